@@ -49,6 +49,16 @@ __CONFIG_OS_FREERTOS ?= y
 #   - n: lwIP 2.x.x, support dual IPv4/IPv6 stack
 __CONFIG_LWIP_V1 ?= y
 
+# lwIP 2.x.x core locking
+#   - y: socket/netconn API calls lock the core and run in the caller's thread
+#   - n: API calls are passed to the tcpip thread by message
+__CONFIG_LWIP_CORE_LOCKING ?= n
+
+# lwIP 2.x.x core locking for input packets, valid if core locking is enabled
+#   - y: received packets are processed in the Rx thread with the core locked
+#   - n: received packets are passed to the tcpip thread by message
+__CONFIG_LWIP_CORE_LOCKING_INPUT ?= n
+
 # mbuf implementation mode
 #   - mode 0: continuous memory allocated from net core
 #   - mode 1: continuous memory (lwip pbuf) allocated from app core
@@ -124,6 +134,14 @@ ifeq ($(__CONFIG_LWIP_V1), y)
   CONFIG_SYMBOLS += -D__CONFIG_LWIP_V1
 endif
 
+ifeq ($(__CONFIG_LWIP_CORE_LOCKING), y)
+  CONFIG_SYMBOLS += -D__CONFIG_LWIP_CORE_LOCKING
+endif
+
+ifeq ($(__CONFIG_LWIP_CORE_LOCKING_INPUT), y)
+  CONFIG_SYMBOLS += -D__CONFIG_LWIP_CORE_LOCKING_INPUT
+endif
+
 CONFIG_SYMBOLS += -D__CONFIG_MBUF_IMPL_MODE=$(__CONFIG_MBUF_IMPL_MODE)
 
 ifeq ($(__CONFIG_XIP_SECTION_FUNC_LEVEL), y)
@@ -91,6 +91,8 @@ typedef enum {
 	ACC_GPIOR, /* Read specified GPIO */
 	ACC_GPIOW, /* Write specified GPIO */
 	ACC_SCAN, /* scan available AP */
+	ACC_MODE_START, /* enter data mode */
+	ACC_MODE_STOP, /* leave data mode */
 } AT_CALLBACK_CMD;
 
 typedef struct {
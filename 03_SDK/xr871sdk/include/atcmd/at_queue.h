@@ -56,6 +56,9 @@ typedef s32 (*at_queue_callback_t)(u8 *buf, s32 size);
 extern s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb);
 extern AT_QUEUE_ERROR_CODE at_queue_get(u8 *element);
 extern AT_QUEUE_ERROR_CODE at_queue_peek(u8 *element);
+extern s32 at_queue_read(u8 *buf, s32 size);
+extern s32 at_queue_span(u8 **ptr);
+extern void at_queue_consume(s32 len);
 
 #ifdef __cplusplus
 }
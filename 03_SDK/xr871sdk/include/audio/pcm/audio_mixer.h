@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef AUDIO_MIXER_H_H
+#define AUDIO_MIXER_H_H
+
+#include <stdint.h>
+#include "audio/pcm/audio_pcm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SND_MIXER_STREAM_MAX    4
+#define SND_MIXER_VOLUME_MAX    0x7FFF  /* Q15 unity gain */
+
+/*
+ * Stream priority used for ducking. While a stream with a higher priority
+ * has data queued, every lower priority stream is attenuated by the duck gain.
+ */
+enum snd_mixer_prio {
+        SND_MIXER_PRIO_MUSIC = 0,
+        SND_MIXER_PRIO_NORMAL,
+        SND_MIXER_PRIO_PROMPT,
+        SND_MIXER_PRIO_ALERT,
+        SND_MIXER_PRIO_MAX,
+};
+
+struct snd_mixer_stat {
+        unsigned int    periods;        /* periods written to the card */
+        unsigned int    idle_periods;   /* periods of silence, no stream active */
+        unsigned int    underruns;      /* a stream ran dry in the middle of a period */
+        unsigned int    active_streams;
+};
+
+typedef struct snd_mixer_stream *snd_mixer_stream_t;
+
+/*
+ * The mixer owns the playback card between snd_mixer_open() and
+ * snd_mixer_close(). @config describes the card format, it must be
+ * PCM_FORMAT_S16_LE with 1 or 2 channels.
+ */
+int snd_mixer_open(struct pcm_config *config, unsigned int card);
+int snd_mixer_close(unsigned int card);
+int snd_mixer_set_duck_gain(uint16_t gain);
+int snd_mixer_get_stat(struct snd_mixer_stat *stat);
+
+/*
+ * Streams are PCM_FORMAT_S16_LE, mono or stereo, at any rate between 4 kHz
+ * and 96 kHz. They are converted to the card rate/channels by the mixer.
+ * period_size/period_count of @config set the depth of the stream queue.
+ * A stream is owned by its writer thread, which must close it before
+ * snd_mixer_close() is called.
+ */
+snd_mixer_stream_t snd_mixer_stream_open(struct pcm_config *config, unsigned int priority);
+int snd_mixer_stream_write(snd_mixer_stream_t stream, void *data, unsigned int count);
+int snd_mixer_stream_drain(snd_mixer_stream_t stream);
+int snd_mixer_stream_close(snd_mixer_stream_t stream);
+int snd_mixer_stream_set_volume(snd_mixer_stream_t stream, uint16_t volume);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -62,6 +62,14 @@ struct pcm_config {
 #define AUDIO_CARD0 SOUND_CARD_EXTERNAL_AUDIOCODEC
 #define AUDIO_CARD1 SOUND_CARD_INTERNAL_DMIC
 
+typedef void (*snd_pcm_period_cb)(void *arg);
+
+void *pcm_zalloc(unsigned int size);
+void pcm_free(void *p);
+unsigned int pcm_get_buffer_size(struct pcm_config *config);
+unsigned int pcm_format_to_bits(enum pcm_format format);
+unsigned int pcm_frames_to_bytes(struct pcm_config *config, unsigned int frames);
+
 int snd_pcm_init();
 int snd_pcm_deinit();
 int snd_pcm_write(struct pcm_config *config, unsigned int card, void *data, unsigned int count);
@@ -69,5 +77,12 @@ int snd_pcm_read(struct pcm_config *config, unsigned int card, void *data, unsig
 int snd_pcm_flush(struct pcm_config *config, unsigned int card);
 int snd_pcm_open(struct pcm_config *config, unsigned int card, unsigned int flags);
 int snd_pcm_close(unsigned int card, unsigned int flags);
+int snd_pcm_mmap_begin(struct pcm_config *config, unsigned int card, unsigned int flags,
+                       void **area, unsigned int *count, unsigned int timeout);
+int snd_pcm_mmap_commit(struct pcm_config *config, unsigned int card, unsigned int flags,
+                        void *area);
+int snd_pcm_set_period_callback(unsigned int card, unsigned int flags,
+                                snd_pcm_period_cb cb, void *arg);
+unsigned int snd_pcm_get_xrun(unsigned int card, unsigned int flags);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DRIVER_CHIP_ADC_STREAM_H_
+#define _DRIVER_CHIP_ADC_STREAM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Continuous sampling of several ADC channels, independent of the
+ * controller.
+ *
+ * The controller converts the selected channels in turn, lowest channel
+ * first, into a FIFO of untagged samples. The owner drains the FIFO in
+ * bursts into adcs_push(), which gives each sample to its channel by its
+ * position in the cycle. Each channel is decimated by a CIC filter: order
+ * 1 is the moving average of ratio samples, orders 2 and 3 reject more of
+ * the band above the output rate. The first order - 1 outputs after a
+ * start or a gap are dropped while the filter settles.
+ *
+ * The outputs are gathered in blocks of ADCS_BLOCK_SAMPLES per channel and
+ * published into a ring for a single consumer, without a lock: the
+ * producer, usually the FIFO interrupt, only moves the head and the
+ * consumer only the tail. When the ring is full the new block is dropped
+ * and counted. A block has the time of its first sample, that of the last
+ * conversion it was filtered from, and a sequence number per channel.
+ *
+ * When the FIFO overran, the owner restarts the conversions from the first
+ * channel and calls adcs_gap(): the partly filled blocks are published,
+ * and the next block of each channel is flagged ADCS_BLOCK_GAP.
+ */
+
+#define ADCS_CHAN_MAX       9
+#define ADCS_BLOCK_SAMPLES  32
+#define ADCS_ORDER_MAX      3
+#define ADCS_GAIN_MAX       (1U << 20)  /* ratio ^ order, in 32 bit registers */
+
+#define ADCS_BLOCK_GAP      (1U << 0)   /* samples were lost before it */
+
+struct adcs_block {
+	uint32_t        t_us;   /* time of data[0] */
+	uint32_t        seq;    /* of the channel's blocks */
+	uint8_t         chan;
+	uint8_t         flags;  /* ADCS_BLOCK_* */
+	uint16_t        num;    /* samples, less than a block at a gap or stop */
+	uint16_t        data[ADCS_BLOCK_SAMPLES];
+};
+
+struct adcs_chan_config {
+	uint8_t         chan;
+	uint8_t         order;  /* 1 to ADCS_ORDER_MAX */
+	uint16_t        ratio;  /* 1 for every sample */
+};
+
+struct adcs_stats {
+	uint32_t        conv;       /* samples pushed */
+	uint32_t        blocks;     /* published */
+	uint32_t        dropped;    /* blocks lost to a full ring */
+	uint32_t        gaps;
+	uint32_t        depth_max;  /* most blocks in the ring */
+};
+
+struct adcs_filter {
+	uint32_t        integ[ADCS_ORDER_MAX];
+	uint32_t        comb[ADCS_ORDER_MAX];
+	uint32_t        div;        /* ratio ^ order */
+	uint16_t        ratio;
+	uint16_t        phase;
+	uint8_t         order;
+	uint8_t         settle;
+	uint8_t         chan;
+	uint8_t         gap;
+	uint32_t        seq;
+	struct adcs_block cur;
+};
+
+struct adcs {
+	uint32_t        freq;       /* conversions per second */
+	uint8_t         nchan;
+	uint8_t         pos;        /* of the next sample in the cycle */
+	uint32_t        t0_us;
+	uint64_t        conv;       /* conversions since t0_us */
+	struct adcs_filter f[ADCS_CHAN_MAX];
+
+	struct adcs_block *ring;
+	uint32_t        mask;
+	volatile uint32_t head;     /* written by the producer */
+	volatile uint32_t tail;     /* written by the consumer */
+
+	struct adcs_stats stats;
+};
+
+int adcs_init(struct adcs *s, uint32_t freq, const struct adcs_chan_config *chan,
+              uint32_t nchan, struct adcs_block *ring, uint32_t ring_num);
+void adcs_start(struct adcs *s, uint32_t t_us);
+uint32_t adcs_push(struct adcs *s, const uint16_t *data, uint32_t n);
+uint32_t adcs_gap(struct adcs *s, uint32_t t_us);
+uint32_t adcs_flush(struct adcs *s);
+
+struct adcs_block *adcs_peek(struct adcs *s);
+void adcs_release(struct adcs *s);
+void adcs_get_stats(struct adcs *s, struct adcs_stats *stats, int reset);
+
+static __inline uint32_t adcs_count(const struct adcs *s)
+{
+	return s->head - s->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_ADC_STREAM_H_ */
@@ -36,6 +36,7 @@
 #define _DRIVER_CHIP_HAL_ADC_H_
 
 #include "driver/chip/hal_def.h"
+#include "driver/chip/adc_stream.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -215,6 +216,33 @@ typedef enum {
 	ADC_HIGH_DATA_IRQ	= 5
 } ADC_IRQState;
 
+/**
+ * @brief A channel of the continuous sampling stream
+ */
+typedef struct {
+	ADC_Channel		chan;
+	uint8_t			order;	/* CIC filter order, 1 for the moving average, up to 3 */
+	uint16_t		ratio;	/* decimation ratio, 1 to keep every sample */
+} ADC_StreamChannel;
+
+/**
+ * @brief Continuous sampling stream parameters
+ */
+typedef struct {
+	uint32_t		freq;		/* conversions per second, shared by the channels */
+	uint8_t			delay;		/* the number of delayed samples in first conversion */
+	uint8_t			num;		/* number of channels */
+	uint16_t		blockNum;	/* blocks in the ring, a power of 2 */
+	const ADC_StreamChannel *chan;
+} ADC_StreamParam;
+
+/** @brief Block of ADC_STREAM_BLOCK_SAMPLES samples of a channel, timestamped */
+typedef struct adcs_block ADC_StreamBlock;
+typedef struct adcs_stats ADC_StreamStats;
+
+#define ADC_STREAM_BLOCK_SAMPLES	ADCS_BLOCK_SAMPLES
+#define ADC_STREAM_BLOCK_GAP		ADCS_BLOCK_GAP
+
 /** @brief Type define of ADC interrupt callback function */
 typedef void (*ADC_IRQCallback)(void *arg);
 
@@ -235,6 +263,12 @@ uint32_t HAL_ADC_GetValue(ADC_Channel chan);
 uint32_t HAL_ADC_GetFifoData(void);
 uint8_t HAL_ADC_GetFifoDataCount(void);
 
+HAL_Status HAL_ADC_StreamStart(const ADC_StreamParam *param);
+HAL_Status HAL_ADC_StreamStop(void);
+ADC_StreamBlock *HAL_ADC_StreamGet(uint32_t msec);
+void HAL_ADC_StreamPut(void);
+HAL_Status HAL_ADC_GetStreamStats(ADC_StreamStats *stats, int reset);
+
 #ifdef __cplusplus
 }
 #endif
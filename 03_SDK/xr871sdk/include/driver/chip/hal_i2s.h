@@ -510,12 +510,21 @@ typedef struct {
 	I2S_HWParam *hwParam; 		/*!< I2S Hardware init structure.    */
 } I2S_Param;
 
+/**
+  * @brief Period elapsed callback, called in interrupt context
+  */
+typedef void (*I2S_PeriodCallback)(void *arg);
+
 HAL_Status HAL_I2S_Init(I2S_Param *param);
 void HAL_I2S_DeInit();
 HAL_Status HAL_I2S_Open(I2S_DataParam *param);
 HAL_Status HAL_I2S_Close(uint32_t dir);
 int32_t HAL_I2S_Read_DMA(uint8_t *buf, uint32_t size);
 int32_t HAL_I2S_Write_DMA(uint8_t *buf, uint32_t size);
+int32_t HAL_I2S_Mmap_Begin(I2S_StreamDir dir, uint8_t **buf, uint32_t msec);
+HAL_Status HAL_I2S_Mmap_Commit(I2S_StreamDir dir, uint8_t *buf);
+HAL_Status HAL_I2S_SetPeriodCallback(I2S_StreamDir dir, I2S_PeriodCallback cb, void *arg);
+uint32_t HAL_I2S_GetXrunCount(I2S_StreamDir dir);
 void HAL_I2S_REG_DEBUG();
 
 #ifdef __cplusplus
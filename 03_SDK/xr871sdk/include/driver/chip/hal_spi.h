@@ -39,6 +39,7 @@
 #include "driver/chip/hal_def.h"
 #include "driver/chip/hal_dma.h"
 #include "driver/chip/hal_gpio.h"
+#include "driver/chip/spi_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -452,6 +453,42 @@ typedef struct {
 	bool cs_level;	/*!< the cs voltage level of chip running */
 } SPI_Global_Config;
 
+/**
+  * @brief A device on a queued SPI port (see HAL_SPI_QueueStart).
+  * @note The controller is set for a device when its transaction starts, the
+  *       device must stay valid while it has transactions queued.
+  */
+typedef struct {
+	SPI_CS				cs;         /*!< spi cs pin */
+	SPI_FirstBit 		firstBit;   /*!< msb or lsb on line */
+	SPI_SclkMode		sclkMode;	/*!< device sclk mode */
+	uint32_t			sclk;       /*!< device sclk frequency */
+	uint8_t				priority;   /*!< 0 (lowest) to SPI_QUEUE_PRIO_NUM - 1 */
+} SPI_QueueDevice;
+
+#define SPI_QUEUE_PRIO_NUM	SPIQ_PRIO_NUM
+
+/**
+  * @brief A segment of a transaction. With tx and rx both set, the segment is
+  *       full duplex. A transmit segment followed by a receive segment runs
+  *       as a single hardware transfer.
+  *       flags: SPI_SEG_CS_CHANGE deselects the device after the segment,
+  *              SPI_SEG_DUAL_RX receives on MOSI and MISO.
+  */
+typedef struct spiq_seg SPI_Segment;
+
+#define SPI_SEG_CS_CHANGE	SPIQ_SEG_CS_CHANGE
+#define SPI_SEG_DUAL_RX		SPIQ_SEG_DUAL_RX
+
+/**
+  * @brief A transaction: seg, num, done and arg are set by the caller, the
+  *       rest belongs to the driver until done(xfer, status, arg) is called
+  *       from the interrupt completing it, with status a HAL_Status.
+  */
+typedef struct spiq_xfer SPI_Xfer;
+
+typedef struct spiq_stats SPI_QueueStats;
+
 /*
  * @brief
  *        reset(not init) <--> ready(inited/closed) <--> busy(opened) <--> tx/rx/tx_rx(transmitting)
@@ -467,6 +504,10 @@ HAL_Status HAL_SPI_Open(SPI_Port port, SPI_CS cs, SPI_Config *config, uint32_t m
 HAL_Status HAL_SPI_Close(SPI_Port port);
 HAL_Status HAL_SPI_CS(SPI_Port port, bool select);
 HAL_Status HAL_SPI_Config(SPI_Port port, SPI_Attribution attr, uint32_t arg);
+HAL_Status HAL_SPI_QueueStart(SPI_Port port, uint32_t msec);
+HAL_Status HAL_SPI_QueueStop(SPI_Port port);
+HAL_Status HAL_SPI_Submit(SPI_Port port, const SPI_QueueDevice *dev, SPI_Xfer *xfer);
+void HAL_SPI_GetQueueStats(SPI_Port port, SPI_QueueStats *stats, int reset);
 void HAL_SPI_Test();
 void HAL_SPI_TestByFlash();
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DRIVER_CHIP_I2S_RING_H_
+#define _DRIVER_CHIP_I2S_RING_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Period bookkeeping of a circular DMA buffer of an audio stream,
+ * independent of the controller.
+ *
+ * The buffer holds two periods. The DMA runs over it in a loop and
+ * interrupts at the end of each period, the owner passes the interrupt to
+ * i2s_ring_elapsed(). The application takes the next period with
+ * i2s_ring_acquire(), fills it (playback) or consumes it (record) in
+ * place, and gives it back with i2s_ring_commit().
+ *
+ * A period elapsed but not yet taken is counted. When the application
+ * missed both periods, the next acquire skips to the period after the
+ * DMA's and counts an xrun. When it missed I2S_RING_XRUN_THRESHOLD
+ * periods of the same half, the DMA is to be stopped: playback restarts
+ * from the first period on the next commit of the second one, record on
+ * the next acquire.
+ *
+ * The ring has no lock, the caller serializes the calls, usually by
+ * masking the DMA interrupt.
+ */
+
+#define I2S_RING_XRUN_THRESHOLD 3
+
+/* i2s_ring_acquire() */
+#define I2S_RING_OK         0
+#define I2S_RING_XRUN       1   /* period returned, skipped one missed */
+#define I2S_RING_WAIT       2   /* no period, wait for i2s_ring_elapsed() */
+#define I2S_RING_START      3   /* start the DMA, then acquire again */
+
+/* i2s_ring_elapsed() */
+#define I2S_RING_WAKE       (1U << 0)   /* the application waits */
+#define I2S_RING_STOP       (1U << 1)   /* stop the DMA, xrun */
+
+struct i2s_ring {
+	uint8_t            *buf;
+	uint32_t            size;       /* two periods */
+	uint8_t            *app;        /* next period of the application */
+	uint8_t            *dma;        /* period the DMA works on */
+	uint8_t            *mmap;       /* acquired by the mmap interface */
+	volatile uint8_t    half;       /* periods elapsed and not taken */
+	volatile uint8_t    end;
+	volatile uint8_t    running;    /* DMA started */
+	uint8_t             tx;
+	uint8_t             waiting;
+	volatile uint32_t   xrun;
+};
+
+void i2s_ring_init(struct i2s_ring *r, uint8_t *buf, uint32_t size, int tx);
+int i2s_ring_acquire(struct i2s_ring *r, uint8_t **period);
+int i2s_ring_commit(struct i2s_ring *r, uint8_t *period);
+uint32_t i2s_ring_elapsed(struct i2s_ring *r, int end);
+
+static __inline uint32_t i2s_ring_period(const struct i2s_ring *r)
+{
+	return r->size / 2;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_I2S_RING_H_ */
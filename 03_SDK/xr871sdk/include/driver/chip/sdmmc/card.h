@@ -174,6 +174,7 @@ struct mmc_card {
 	uint32_t        cidno[4];
 
 	uint32_t        rca;                           /* relative card address of device */
+	uint32_t        blocklen;                      /* block length set by CMD16, 0 if unknown */
 	struct mmc_ocr  ocr;
 	struct mmc_host *host;                         /* the host this device belongs to */
 };
@@ -459,6 +459,23 @@ extern int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk
  */
 extern int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk, uint32_t nblk);
 
+#define MMC_BLOCK_VEC_MAX       16
+
+/**
+ * @brief write SD card from non-contiguous blocks in one transfer.
+ * @param card:
+ *        @arg card->card handler.
+ * @param bufs:
+ *        @arg bufs->nblk pointers to 512 bytes blocks, 4 bytes aligned.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @param nblk:
+ *        @arg nblk->number of blocks, no more than MMC_BLOCK_VEC_MAX.
+ * @retval  0 if success or other if failed.
+ */
+extern int32_t mmc_block_write_vec(struct mmc_card *card, const uint8_t * const *bufs,
+                                   uint64_t sblk, uint32_t nblk);
+
 /**
  * @brief scan or rescan SD card.
  * @param card:
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DRIVER_CHIP_SPI_QUEUE_H_
+#define _DRIVER_CHIP_SPI_QUEUE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Transaction queue of a SPI port, independent of the controller.
+ *
+ * A transaction (struct spiq_xfer) is a list of segments for one device,
+ * run with the device selected from the first segment to the last. The
+ * queue splits it into bursts, one per hardware transfer: a transmit
+ * segment followed by a receive segment, e.g. a command and its answer,
+ * runs as one half duplex burst. The next burst is started as soon as the
+ * last one completes, and the next transaction by priority as soon as the
+ * last one is done, so the bus has no gaps waiting for a thread.
+ *
+ * Transactions of the same priority run in submit order. A lower priority
+ * passed over SPIQ_STARVE_LIMIT times in a row runs next, before the higher
+ * ones.
+ *
+ * The queue has no lock, the caller serializes the calls, usually by
+ * masking the interrupt completing the bursts.
+ */
+
+#define SPIQ_PRIO_NUM       4   /* 0 lowest, SPIQ_PRIO_NUM - 1 highest */
+#define SPIQ_STARVE_LIMIT   8
+#define SPIQ_SEG_LEN_MAX    0xFFFFFFU   /* burst counters are 24 bits */
+
+#define SPIQ_SEG_CS_CHANGE  (1U << 0)   /* deselect the device after it */
+#define SPIQ_SEG_DUAL_RX    (1U << 1)   /* receive on MOSI and MISO */
+
+struct spiq_seg {
+	const uint8_t  *tx;     /* NULL to receive only, dummy bytes are sent */
+	uint8_t        *rx;     /* NULL to transmit only */
+	uint32_t        len;
+	uint32_t        flags;  /* SPIQ_SEG_* */
+};
+
+struct spiq_xfer;
+
+/* called by the owner of the queue for the transactions returned by
+ * spiq_burst_done() and spiq_abort(), out of its lock */
+typedef void (*spiq_done_cb)(struct spiq_xfer *x, int status, void *arg);
+
+struct spiq_xfer {
+	/* set by the submitter */
+	const void             *dev;    /* device config, opaque to the queue */
+	const struct spiq_seg  *seg;
+	uint16_t                num;    /* segments */
+	uint8_t                 prio;
+	spiq_done_cb            done;
+	void                   *arg;
+
+	/* owned by the queue from submit until done is called */
+	struct spiq_xfer       *next;
+	uint16_t                cur;    /* first segment of the next burst */
+	uint32_t                t_submit;
+};
+
+/* one hardware transfer: tx_len bytes sent then rx_len received, or both
+ * at once when duplex (tx_len == rx_len) */
+struct spiq_burst {
+	const uint8_t  *tx;
+	uint8_t        *rx;
+	uint32_t        tx_len;
+	uint32_t        rx_len;
+	uint8_t         duplex;
+	uint8_t         dual_rx;
+	uint8_t         cs_first;   /* select the device before */
+	uint8_t         cs_last;    /* deselect it after */
+	uint8_t         nseg;       /* segments in the burst */
+};
+
+struct spiq_ops {
+	/* program and start the burst, called from spiq_submit() and
+	 * spiq_burst_done() */
+	void (*start)(void *ctx, const struct spiq_xfer *x,
+	              const struct spiq_burst *b);
+	uint32_t (*now_us)(void *ctx);
+};
+
+struct spiq_stats {
+	uint32_t    xfers;          /* completed */
+	uint32_t    errors;         /* completed with a status other than 0 */
+	uint32_t    bursts;
+	uint32_t    merged;         /* transmit + receive segments in a burst */
+	uint32_t    dev_switch;     /* transactions for another device */
+	uint32_t    starved;        /* passed before higher priorities */
+	uint32_t    depth_max;      /* transactions waiting, the most seen */
+	uint32_t    prio_xfers[SPIQ_PRIO_NUM];
+	uint64_t    bytes;
+	uint64_t    busy_us;        /* bursts running */
+	uint64_t    span_us;        /* since the stats were reset */
+	uint64_t    wait_sum_us;    /* submit to first burst */
+	uint32_t    wait_max_us;
+};
+
+struct spiq {
+	const struct spiq_ops  *ops;
+	void                   *ctx;
+	struct spiq_xfer       *head[SPIQ_PRIO_NUM];
+	struct spiq_xfer       *tail[SPIQ_PRIO_NUM];
+	uint8_t                 passed[SPIQ_PRIO_NUM];
+	uint32_t                depth;
+	struct spiq_xfer       *active;
+	struct spiq_burst       burst;  /* of active */
+	const void             *last_dev;
+	uint32_t                t_burst;
+	uint32_t                t_stats;
+	struct spiq_stats       stats;
+};
+
+void spiq_init(struct spiq *q, const struct spiq_ops *ops, void *ctx);
+int spiq_submit(struct spiq *q, struct spiq_xfer *x);
+struct spiq_xfer *spiq_burst_done(struct spiq *q, int status);
+struct spiq_xfer *spiq_abort(struct spiq *q);
+void spiq_get_stats(struct spiq *q, struct spiq_stats *stats, int reset);
+
+static __inline int spiq_busy(const struct spiq *q)
+{
+	return q->active != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DRIVER_CHIP_SPI_QUEUE_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CAM_VIDEO_H__
+#define __CAM_VIDEO_H__
+
+#include "driver/component/component_def.h"
+#include "driver/component/csi_camera/frame_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief Continuous capture into a pool of frame buffers.
+  * @note The CSI FIFOs are moved by DMA straight into the buffer of the
+  *       frame, readers get the latest frame by reference and put it back
+  *       when done with it, nothing is copied.
+  */
+typedef struct {
+	uint8_t num;        /*!< buffers, 2 to FRAME_POOL_MAX */
+	uint8_t jpeg;       /*!< the sensor outputs JPEG, enables the CSI JPEG mode */
+	uint32_t size;      /*!< of each buffer, the largest frame expected */
+} Cam_VideoParam;
+
+typedef struct frame Cam_Frame;
+typedef struct frame_pool_stats Cam_VideoStats;
+
+Component_Status Drv_Cam_Video_Start(const Cam_VideoParam *param);
+void Drv_Cam_Video_Stop(void);
+
+Cam_Frame *Drv_Cam_Frame_Get(uint32_t seq, uint32_t timeout_ms);
+void Drv_Cam_Frame_Put(Cam_Frame *frame);
+void Drv_Cam_Frame_Sent(const Cam_Frame *frame);
+void Drv_Cam_Video_Stats(Cam_VideoStats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAM_VIDEO_H__ */
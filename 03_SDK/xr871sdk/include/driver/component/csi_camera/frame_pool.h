@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FRAME_POOL_H_
+#define _FRAME_POOL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pool of camera frame buffers, independent of the controller.
+ *
+ * The capture side writes a frame straight into a free buffer:
+ * frame_pool_write() gives where each FIFO of the frame goes, and
+ * frame_pool_done() at the end of the frame publishes it as the latest.
+ * When every buffer is in use the whole frame is skipped, when it is
+ * larger than a buffer or the FIFO overflowed it is dropped. In JPEG mode
+ * a frame must start with SOI and is cut after its EOI, the padding of the
+ * last FIFO is not sent.
+ *
+ * Readers only ever get the latest frame, referenced until they put it
+ * back, so a slow reader skips frames instead of holding the capture. A
+ * published frame nobody took is recycled when the next one is published.
+ *
+ * The pool has no lock, the owner serializes the calls, usually by
+ * masking the capture interrupt.
+ */
+
+#define FRAME_POOL_MAX      8
+#define FRAME_JPEG_TAIL     1024    /* bytes searched back for the EOI */
+
+enum frame_state {
+	FRAME_FREE,
+	FRAME_FILLING,
+	FRAME_READY,
+};
+
+struct frame {
+	uint8_t        *buf;
+	uint32_t        size;
+	uint32_t        len;        /* of the frame */
+	uint32_t        seq;
+	uint32_t        t_us;       /* end of the frame */
+	uint8_t         state;      /* enum frame_state */
+	uint8_t         ref;
+	uint8_t         taken;
+	uint8_t         bad;
+};
+
+struct frame_pool_stats {
+	uint32_t        frames;     /* published */
+	uint32_t        no_buf;     /* skipped, every buffer was in use */
+	uint32_t        overflow;   /* larger than a buffer, or FIFO overflow */
+	uint32_t        bad_jpeg;   /* no SOI or EOI */
+	uint32_t        stale;      /* replaced before any reader took it */
+	uint32_t        sent;       /* frames reported by frame_pool_sent() */
+	uint32_t        lat_sum_us; /* frame end to its last byte sent */
+	uint32_t        lat_max_us;
+};
+
+struct frame_pool {
+	struct frame    f[FRAME_POOL_MAX];
+	uint8_t         num;
+	uint8_t         jpeg;
+	uint8_t         skip;       /* until the end of the frame */
+	struct frame   *fill;
+	struct frame   *latest;
+	uint32_t        seq;
+	struct frame_pool_stats stats;
+};
+
+int frame_pool_init(struct frame_pool *p, uint8_t *mem, uint32_t size, uint32_t num, int jpeg);
+uint8_t *frame_pool_write(struct frame_pool *p, uint32_t len);
+void frame_pool_abort(struct frame_pool *p);
+struct frame *frame_pool_done(struct frame_pool *p, uint32_t t_us);
+
+struct frame *frame_pool_get(struct frame_pool *p, uint32_t seq);
+void frame_pool_put(struct frame_pool *p, struct frame *f);
+void frame_pool_sent(struct frame_pool *p, const struct frame *f, uint32_t t_us);
+void frame_pool_get_stats(struct frame_pool *p, struct frame_pool_stats *stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRAME_POOL_H_ */
@@ -56,11 +56,22 @@ typedef struct {
 	 GPIO_Pin oled_reset_Pin;		/*!< The spi reset io seclet */
 }Oled_Config;
 
+/* colors of DRV_Oled_Fb_Fill() */
+#define OLED_BLACK	0
+#define OLED_WHITE	1
+#define OLED_INVERT	2
+
 Component_Status DRV_Oled_Pnxm_Bmp(uint8_t column, uint8_t page, uint8_t width, uint8_t hight, const uint8_t *bmp);
 Component_Status  DRV_Oled_Showchar_1608(uint8_t x, uint8_t y, uint8_t chr);
 Component_Status DRV_Oled_Show_Str_1608(uint8_t column, uint8_t page, const char* str);
 int DRV_Oled_P8xnstr(uint8_t column, uint8_t page, const uint8_t* str, uint8_t len);
 
+void DRV_Oled_Fb_Fill(int x, int y, int w, int h, int color);
+void DRV_Oled_Fb_Bmp(int x, int y, int w, int h, const uint8_t *bmp);
+void DRV_Oled_Fb_Str_1608(int x, int y, const char *str);
+int DRV_Oled_Flush();
+void DRV_Oled_Set_Frame_Rate(uint32_t fps);
+
 Component_Status  DRV_Oled_Init(Oled_Config *cfg);
 Component_Status DRV_Oled_DeInit();
 
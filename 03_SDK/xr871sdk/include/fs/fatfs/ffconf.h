@@ -43,15 +43,26 @@
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_FASTSEEK	0
+#define	_USE_FASTSEEK	1
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define	_USE_EXPAND		0
+#define	_FS_CLMT_FILES	4
+/* When _USE_FASTSEEK == 1, this option defines how the cluster link map table
+/  of a file is attached to the file object.
+/
+/   0:   The table pointer is the cltbl member of FIL (original FatFs behavior).
+/   >0:  The table pointer is kept in a table of _FS_CLMT_FILES entries outside
+/        of FIL and is set with f_setclmt(). This keeps the FIL layout used by
+/        prebuilt libraries unchanged. The value is the number of files which
+/        can be in fast seek mode at the same time. */
+
+
+#define	_USE_EXPAND		1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
-#define _USE_CHMOD		0
+#define _USE_CHMOD		1
 /* This option switches attribute manipulation functions, f_chmod() and f_utime().
 /  (0:Disable or 1:Enable) Also _FS_READONLY needs to be 0 to enable this option. */
 
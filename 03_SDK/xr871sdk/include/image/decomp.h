@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _IMAGE_DECOMP_H_
+#define _IMAGE_DECOMP_H_
+
+#include <stdint.h>
+#include "image/image.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Return values of image_codec::run()
+ */
+typedef enum image_codec_ret {
+	IMAGE_CODEC_MORE    = 0,    /* more input is needed */
+	IMAGE_CODEC_END     = 1,    /* end of the compressed stream */
+	IMAGE_CODEC_ERROR   = -1,   /* corrupted input or output overflow */
+} image_codec_ret_t;
+
+/**
+ * @brief Decoder of a compressed section body
+ *
+ * init() creates a decoder writing to @out, run() is called with every chunk
+ * of the body in order, @last is set for the last chunk. The output is the
+ * whole decompressed section, so a decoder may refer to its previous output
+ * instead of keeping a dictionary of its own.
+ */
+typedef struct image_codec {
+	const char *name;
+	void *(*init)(uint8_t *out, uint32_t out_size);
+	image_codec_ret_t (*run)(void *dec, const uint8_t *in, uint32_t len, int last);
+	uint32_t (*out_len)(void *dec);
+	void (*deinit)(void *dec);
+} image_codec_t;
+
+extern const image_codec_t image_codec_xz;
+extern const image_codec_t image_codec_lz4;
+
+int image_decompress(const section_header_t *sh, void *out, uint32_t out_size,
+                     uint32_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IMAGE_DECOMP_H_ */
@@ -126,6 +126,12 @@ typedef struct section_header {
 #define IMAGE_HEADER_SIZE           sizeof(section_header_t)
 #define IMAGE_ATTR_FLAG_COMPRESS    (1 << 4)
 
+/* codec of a compressed section, valid with IMAGE_ATTR_FLAG_COMPRESS */
+#define IMAGE_ATTR_CODEC_SHIFT      5
+#define IMAGE_ATTR_CODEC_MASK       (0x3 << IMAGE_ATTR_CODEC_SHIFT)
+#define IMAGE_ATTR_CODEC_XZ         (0x0 << IMAGE_ATTR_CODEC_SHIFT)
+#define IMAGE_ATTR_CODEC_LZ4        (0x1 << IMAGE_ATTR_CODEC_SHIFT)
+
 /**
  * @brief OTA parameter definition
  */
@@ -202,6 +208,12 @@ uint32_t image_get_size(void);
 int image_get_cfg(image_cfg_t *cfg);
 int image_set_cfg(image_cfg_t *cfg);
 
+int image_vcache_init(uint32_t flash, uint32_t addr, uint32_t size);
+void image_vcache_deinit(void);
+void image_vcache_drop(image_seq_t seq);
+image_val_t image_get_verified(uint32_t id, const section_header_t *sh);
+void image_set_verified(uint32_t id, const section_header_t *sh);
+
 #ifdef __cplusplus
 }
 #endif
@@ -645,6 +645,16 @@ extern "C" {
 	#define traceTASK_NOTIFY_GIVE_FROM_ISR()
 #endif
 
+#ifndef traceCRITICAL_ENTER
+	/* Called by the port when entering the outermost critical section. */
+	#define traceCRITICAL_ENTER()
+#endif
+
+#ifndef traceCRITICAL_EXIT
+	/* Called by the port when leaving the outermost critical section. */
+	#define traceCRITICAL_EXIT()
+#endif
+
 #ifndef configGENERATE_RUN_TIME_STATS
 	#define configGENERATE_RUN_TIME_STATS 0
 #endif
@@ -154,8 +154,15 @@ extern uint32_t SystemCoreClock;	/* Global variable of CMSIS */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         2
 
-/* Software timer related definitions. */
+/* Software timer related definitions.
+ * OS_Timer runs on a timer wheel of its own (kernel/os/FreeRTOS/os_timer.h),
+ * nothing else uses the FreeRTOS timers, their task is only built when the
+ * wheel is disabled. */
+#if (defined(OS_TIMER_USE_WHEEL) && (OS_TIMER_USE_WHEEL == 0))
 #define configUSE_TIMERS                        1
+#else
+#define configUSE_TIMERS                        0
+#endif
 #define configTIMER_TASK_PRIORITY               ( configMAX_PRIORITIES - 1 ) // highest priority
 #define configTIMER_QUEUE_LENGTH                10
 #define configTIMER_TASK_STACK_DEPTH            512 /* 2048-byte */
@@ -163,8 +170,12 @@ extern uint32_t SystemCoreClock;	/* Global variable of CMSIS */
 
 #define configDEBUG_CPU_USAGE_EN                0 /* use cpu usage statistic */
 
+#define configDEBUG_RTSTAT_EN                   1 /* per-task run time and scheduling latency statistic, see rtstat.h */
+
 #define configDEBUG_TRACE_TASK_MOREINFO         1 /* add some info to trace tasks, use configUSE_STATS_FORMATTING_FUNCTIONS */
 
+#define configDEBUG_STACKMON_EN                 1 /* stack high-water monitor, needs configDEBUG_TRACE_TASK_MOREINFO */
+
 /* Interrupt nesting behaviour configuration. */
 #define configKERNEL_INTERRUPT_PRIORITY 		( 7 << 5 )	/* Priority 7 as only the top three bits are implemented.  This is the lowest priority. */
 /* !!!! configMAX_SYSCALL_INTERRUPT_PRIORITY must not be set to zero !!!!
@@ -190,8 +201,8 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   1
-#define INCLUDE_xEventGroupSetBitFromISR        1
-#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xEventGroupSetBitFromISR        configUSE_TIMERS /* needs the timer task */
+#define INCLUDE_xTimerPendFunctionCall          configUSE_TIMERS
 //#define INCLUDE_xTaskAbortDelay                 0
 //#define INCLUDE_xTaskGetHandle                  0
 #define INCLUDE_xTaskResumeFromISR              1
@@ -247,6 +258,12 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #undef  configDEBUG_TRACE_TASK_MOREINFO
 #define configDEBUG_TRACE_TASK_MOREINFO         0
 
+#undef  configDEBUG_RTSTAT_EN
+#define configDEBUG_RTSTAT_EN                   0
+
+#undef  configDEBUG_STACKMON_EN
+#define configDEBUG_STACKMON_EN                 0
+
 #undef  INCLUDE_vTaskPrioritySet
 #define INCLUDE_vTaskPrioritySet                0
 
@@ -282,4 +299,8 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 
 #endif /* __CONFIG_BOOTLOADER */
 
+#if (configDEBUG_RTSTAT_EN == 1)
+#include "kernel/FreeRTOS/rtstat.h" /* trace macros */
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __RTSTAT_H__
+#define __RTSTAT_H__
+
+#include <stdint.h>
+
+/*
+ * Run time statistic: per-task run time, ready to running latency and the
+ * time spent in critical sections (kernel interrupts masked).
+ *
+ * The accounting below doesn't depend on the kernel. It is fed with the times
+ * of the events, read from a free running counter, so it can be driven by
+ * recorded or synthetic traces as well. Times are in ticks of a 64-bit counter,
+ * so the run times never wrap. A latency or a critical section longer than
+ * 2^32 - 1 ticks is counted as that.
+ */
+
+#define RTSTAT_HIST_NUM     20  /* bucket n counts [2^n, 2^(n+1)) ticks, 0 for [0, 2) */
+
+struct rtstat_hist {
+	uint32_t count[RTSTAT_HIST_NUM];
+	uint32_t max;
+	uint64_t sum;
+};
+
+/* per task, it lives in the task control block */
+struct rtstat_task {
+	uint64_t run_time;      /* ticks spent running */
+	uint64_t ready_at;      /* made ready at, while ready is set */
+	uint32_t switches;      /* times switched in */
+	uint32_t latency_max;   /* longest wait to run, in ticks */
+	uint8_t  ready;         /* waiting to run since ready_at */
+	uint8_t  epoch;         /* stale when != rtstat::epoch */
+};
+
+struct rtstat {
+	struct rtstat_task *current;
+	uint64_t switched_at;
+	uint64_t critical_at;
+	uint64_t reset_at;
+	uint8_t  epoch;
+	struct rtstat_hist latency;
+	struct rtstat_hist critical;
+};
+
+void rtstat_reset(struct rtstat *st, uint64_t now);
+
+/* the task is ready to run, not counted if it is already */
+void rtstat_task_ready(struct rtstat *st, struct rtstat_task *task, uint64_t now);
+
+/* the running task is switched out, still ready if it was preempted */
+void rtstat_switch_out(struct rtstat *st, struct rtstat_task *task, int ready, uint64_t now);
+
+/* the task chosen to run next, at the time of rtstat_switch_out() */
+void rtstat_switch_in(struct rtstat *st, struct rtstat_task *task);
+
+void rtstat_critical_enter(struct rtstat *st, uint64_t now);
+void rtstat_critical_exit(struct rtstat *st, uint64_t now);
+
+/* copy of the task's figures, zero if none since the last reset */
+void rtstat_task_get(const struct rtstat *st, const struct rtstat_task *task,
+                     struct rtstat_task *out);
+
+static __inline uint32_t rtstat_hist_num(const struct rtstat_hist *hist)
+{
+	uint32_t num = 0;
+	int i;
+
+	for (i = 0; i < RTSTAT_HIST_NUM; i++)
+		num += hist->count[i];
+	return num;
+}
+
+/*
+ * FreeRTOS hooks, included from FreeRTOSConfig.h. The idle priority tasks
+ * aren't counted in the latency, they are ready all the time.
+ */
+#if (configDEBUG_RTSTAT_EN == 1)
+
+extern void vRtStatTaskReady(struct rtstat_task *pxTask);
+extern void vRtStatTaskSwitchedOut(struct rtstat_task *pxTask, int xReady);
+extern void vRtStatTaskSwitchedIn(struct rtstat_task *pxTask);
+extern void vRtStatCriticalEnter(void);
+extern void vRtStatCriticalExit(void);
+extern void vRtStatTick(void);
+
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB )                                    \
+	do {                                                                           \
+		if( ( pxTCB )->uxPriority != tskIDLE_PRIORITY )                            \
+			vRtStatTaskReady( &( pxTCB )->xRtStat );                               \
+	} while( 0 )
+
+#define traceTASK_SWITCHED_OUT()                                                   \
+	vRtStatTaskSwitchedOut( &pxCurrentTCB->xRtStat,                                \
+		pxCurrentTCB->uxPriority != tskIDLE_PRIORITY &&                            \
+		listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ), \
+		                         &( pxCurrentTCB->xGenericListItem ) ) )
+
+#define traceTASK_SWITCHED_IN()     vRtStatTaskSwitchedIn( &pxCurrentTCB->xRtStat )
+
+#define traceCRITICAL_ENTER()       vRtStatCriticalEnter()
+#define traceCRITICAL_EXIT()        vRtStatCriticalExit()
+
+/* the counter is read at least once a tick, see rtstat_now() */
+#define traceTASK_INCREMENT_TICK( xTickCount )  vRtStatTick()
+
+#endif /* configDEBUG_RTSTAT_EN */
+
+#endif /* __RTSTAT_H__ */
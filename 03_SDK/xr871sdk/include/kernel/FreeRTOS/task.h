@@ -176,6 +176,10 @@ typedef struct xTASK_STATUS
 #if configDEBUG_TRACE_TASK_MOREINFO
 	volatile StackType_t *pxTopOfStack;
 	StackType_t *pxStack;
+	uint16_t usStackDepth;			/* The size of the stack in words. */
+#endif
+#if ( configDEBUG_RTSTAT_EN == 1 )
+	struct rtstat_task xRtStat;
 #endif
 } TaskStatus_t;
 
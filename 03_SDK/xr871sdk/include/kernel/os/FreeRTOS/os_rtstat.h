@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERNEL_OS_FREERTOS_OS_RTSTAT_H_
+#define _KERNEL_OS_FREERTOS_OS_RTSTAT_H_
+
+#include "kernel/os/FreeRTOS/os_common.h"
+#include "kernel/FreeRTOS/rtstat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Histograms of the run time statistic
+ */
+typedef enum {
+    OS_RTSTAT_LATENCY   = 0,    /* from ready to running */
+    OS_RTSTAT_CRITICAL  = 1,    /* kernel interrupts masked (critical sections) */
+} OS_RtStatHistType;
+
+#define OS_RTSTAT_HIST_NUM  RTSTAT_HIST_NUM
+
+/**
+ * @brief Histogram of durations, in microsecond
+ *
+ * count[n] counts the durations from OS_RtStatHistBound(n) (included) to
+ * OS_RtStatHistBound(n + 1), the last one all the longer ones.
+ */
+typedef struct {
+	uint32_t count[OS_RTSTAT_HIST_NUM];
+	uint32_t max;
+	uint64_t sum;
+} OS_RtStatHist_t;
+
+/**
+ * @brief Run time statistic of a thread, since the last reset
+ */
+typedef struct {
+	char     name[configMAX_TASK_NAME_LEN];
+	uint32_t priority;
+	uint64_t runTime;       /* in microsecond */
+	uint32_t switches;      /* times it was switched in */
+	uint32_t latencyMax;    /* longest wait to run, in microsecond */
+} OS_RtStatThread_t;
+
+#if (configDEBUG_RTSTAT_EN == 1)
+
+OS_Status OS_RtStatStart(void);
+void OS_RtStatStop(void);
+void OS_RtStatReset(void);
+int OS_RtStatGetThreads(OS_RtStatThread_t *threads, int num, uint64_t *elapsed);
+void OS_RtStatGetHist(OS_RtStatHistType type, OS_RtStatHist_t *hist);
+uint32_t OS_RtStatHistBound(int n);
+void OS_RtStatShow(void);
+
+#else /* configDEBUG_RTSTAT_EN */
+
+static __inline OS_Status OS_RtStatStart(void) { return OS_FAIL; }
+static __inline void OS_RtStatStop(void) { }
+static __inline void OS_RtStatReset(void) { }
+static __inline int OS_RtStatGetThreads(OS_RtStatThread_t *threads, int num, uint64_t *elapsed) { return 0; }
+static __inline void OS_RtStatGetHist(OS_RtStatHistType type, OS_RtStatHist_t *hist) { }
+static __inline uint32_t OS_RtStatHistBound(int n) { return 0; }
+static __inline void OS_RtStatShow(void) { }
+
+#endif /* configDEBUG_RTSTAT_EN */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_FREERTOS_OS_RTSTAT_H_ */
@@ -0,0 +1,93 @@
+/**
+ * @file os_stack_table.h
+ * @author XRADIO IOT WLAN Team
+ */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERNEL_OS_FREERTOS_OS_STACK_TABLE_H_
+#define _KERNEL_OS_FREERTOS_OS_STACK_TABLE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stack usage kept per name: the stacks are filled with STKTAB_FILL_WORD
+ * when created, the words still holding it at the far end are the space
+ * never used. Samples of the same name, from one thread or from threads
+ * created again later, are merged, and a size is recommended from the most
+ * ever used plus a margin.
+ *
+ * The table has no lock, the caller serializes the calls.
+ */
+
+#define STKTAB_FILL_WORD    0xa5a5a5a5U /* tskSTACK_FILL_BYTE in every byte */
+#define STKTAB_NAME_LEN     16
+
+/* recommended = used + max(used * STKTAB_MARGIN_PCT%, STKTAB_MARGIN_MIN),
+ * rounded up to STKTAB_ALIGN; the minimum covers an exception frame with the
+ * FPU context and a nested interrupt */
+#define STKTAB_MARGIN_PCT   25
+#define STKTAB_MARGIN_MIN   256
+#define STKTAB_ALIGN        64
+
+struct stktab_entry {
+	char        name[STKTAB_NAME_LEN];
+	uint32_t    size;       /* bytes, of the last sample */
+	uint32_t    min_free;   /* bytes never used, the lowest seen */
+	uint32_t    used_max;   /* bytes used, the most seen */
+	uint32_t    samples;
+	uint8_t     warned;     /* min_free went under the warning level */
+};
+
+struct stktab {
+	struct stktab_entry    *entry;
+	uint16_t                num;        /* entries in use */
+	uint16_t                max;        /* entries available */
+	uint8_t                 warn_pct;   /* warn under this % of the size free */
+	uint32_t                dropped;    /* samples of names without an entry */
+};
+
+uint32_t stktab_scan(const void *bottom, uint32_t size);
+void stktab_fill(void *bottom, uint32_t size);
+void stktab_init(struct stktab *t, struct stktab_entry *entry, uint16_t max,
+                 uint8_t warn_pct);
+struct stktab_entry *stktab_update(struct stktab *t, const char *name,
+                                   uint32_t size, uint32_t free, int *warn);
+uint32_t stktab_recommend(const struct stktab_entry *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_FREERTOS_OS_STACK_TABLE_H_ */
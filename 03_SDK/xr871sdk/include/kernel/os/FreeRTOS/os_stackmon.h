@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERNEL_OS_FREERTOS_OS_STACKMON_H_
+#define _KERNEL_OS_FREERTOS_OS_STACKMON_H_
+
+#include "kernel/os/FreeRTOS/os_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* name of the interrupt (main) stack in the figures */
+#define OS_STACKMON_ISR_NAME    "[isr]"
+
+/**
+ * @brief Stack usage of a thread name, since the monitor started
+ */
+typedef struct {
+	char     name[configMAX_TASK_NAME_LEN];
+	uint32_t size;          /* stack size, in byte */
+	uint32_t minFree;       /* least free space seen, in byte */
+	uint32_t usedMax;       /* most space used, in byte */
+	uint32_t recommend;     /* recommended stack size, in byte */
+	uint32_t samples;
+} OS_StackMonEntry_t;
+
+#if (configDEBUG_STACKMON_EN == 1)
+
+OS_Status OS_StackMonStart(uint32_t periodMS, uint8_t warnPercent);
+void OS_StackMonStop(void);
+void OS_StackMonSample(void);
+int OS_StackMonGet(OS_StackMonEntry_t *entries, int num);
+void OS_StackMonShow(void);
+
+#else /* configDEBUG_STACKMON_EN */
+
+static __inline OS_Status OS_StackMonStart(uint32_t periodMS, uint8_t warnPercent) { return OS_FAIL; }
+static __inline void OS_StackMonStop(void) { }
+static __inline void OS_StackMonSample(void) { }
+static __inline int OS_StackMonGet(OS_StackMonEntry_t *entries, int num) { return 0; }
+static __inline void OS_StackMonShow(void) { }
+
+#endif /* configDEBUG_STACKMON_EN */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_FREERTOS_OS_STACKMON_H_ */
@@ -36,13 +36,38 @@
 #define _KERNEL_OS_FREERTOS_OS_TIMER_H_
 
 #include "kernel/os/FreeRTOS/os_common.h"
+
+/*
+ * Timers filed in a timer wheel served by a thread of its own, rather than
+ * FreeRTOS software timers driven through the timer command queue.
+ * FreeRTOSConfig.h only builds the FreeRTOS timer task for 0, so set it for
+ * the whole build rather than here.
+ */
+#ifndef OS_TIMER_USE_WHEEL
+#define OS_TIMER_USE_WHEEL	1
+#endif
+
+#if OS_TIMER_USE_WHEEL
+/* wheel timers kept ready for OS_TimerCreate(), more come from the heap,
+ * OS_TimerCreateStatic() takes none */
+#ifndef OS_TIMER_POOL_NUM
+#define OS_TIMER_POOL_NUM	16
+#endif
+#endif
+
+#if OS_TIMER_USE_WHEEL
+#include "kernel/os/FreeRTOS/os_timer_wheel.h"
+#else
 #include "timers.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#if (defined(configUSE_TIMER_ID_AS_CALLBACK_ARG) && configUSE_TIMER_ID_AS_CALLBACK_ARG == 1)
+#if OS_TIMER_USE_WHEEL
+#define OS_TIMER_USE_FREERTOS_ORIG_CALLBACK	0
+#elif (defined(configUSE_TIMER_ID_AS_CALLBACK_ARG) && configUSE_TIMER_ID_AS_CALLBACK_ARG == 1)
 #define OS_TIMER_USE_FREERTOS_ORIG_CALLBACK	0
 #else
 #define OS_TIMER_USE_FREERTOS_ORIG_CALLBACK	1
@@ -61,6 +86,36 @@ typedef enum {
 /** @brief Timer expire callback function definition */
 typedef void (*OS_TimerCallback_t)(void *arg);
 
+#if OS_TIMER_USE_WHEEL
+
+/** @brief Timer handle definition */
+typedef struct twheel_timer *OS_TimerHandle_t;
+
+/**
+ * @brief Timer object definition
+ * @note The object is the handle only, as with the FreeRTOS timers, the
+ *       prebuilt libraries are compiled for that size. The wheel timer is
+ *       taken from a pool of OS_TIMER_POOL_NUM when created, or given by the
+ *       caller to OS_TimerCreateStatic().
+ */
+typedef struct OS_Timer {
+    OS_TimerHandle_t        handle;
+} OS_Timer_t;
+
+/**
+ * @brief Timer statistics definition
+ */
+typedef struct OS_TimerStats {
+    uint32_t    fired;      /* timers expired */
+    uint32_t    late;       /* timers expired past their period and slack */
+    uint32_t    lateMaxMS;  /* most time a timer expired past its period */
+    uint32_t    missed;     /* periods skipped by periodic timers */
+    uint32_t    overruns;   /* callbacks running past OS_TIMER_BUDGET_MS */
+    uint32_t    runMaxMS;   /* time of the longest callback */
+} OS_TimerStats_t;
+
+#else /* OS_TIMER_USE_WHEEL */
+
 /** @brief Timer handle definition */
 typedef TimerHandle_t OS_TimerHandle_t;
 
@@ -84,6 +139,7 @@ typedef struct OS_Timer {
 #endif
 } OS_Timer_t;
 
+#endif /* OS_TIMER_USE_WHEEL */
 
 OS_Status OS_TimerCreate(OS_Timer_t *timer, OS_TimerType type,
                          OS_TimerCallback_t cb, void *arg, OS_Time_t periodMS);
@@ -91,6 +147,13 @@ OS_Status OS_TimerDelete(OS_Timer_t *timer);
 OS_Status OS_TimerStart(OS_Timer_t *timer);
 OS_Status OS_TimerChangePeriod(OS_Timer_t *timer, OS_Time_t periodMS);
 OS_Status OS_TimerStop(OS_Timer_t *timer);
+#if OS_TIMER_USE_WHEEL
+OS_Status OS_TimerCreateStatic(OS_Timer_t *timer, struct twheel_timer *storage,
+                               OS_TimerType type, OS_TimerCallback_t cb,
+                               void *arg, OS_Time_t periodMS);
+OS_Status OS_TimerSetSlack(OS_Timer_t *timer, OS_Time_t slackMS);
+void OS_TimerGetStats(OS_TimerStats_t *stats);
+#endif
 
 /**
  * @brief Check whether the timer object is valid or not
@@ -125,7 +188,11 @@ static __always_inline void OS_TimerSetInvalid(OS_Timer_t *timer)
  */
 static __always_inline int OS_TimerIsActive(OS_Timer_t *timer)
 {
+#if OS_TIMER_USE_WHEEL
+	return twheel_timer_pending(timer->handle);
+#else
 	return (xTimerIsTimerActive(timer->handle) != pdFALSE);
+#endif
 }
 
 #ifdef __cplusplus
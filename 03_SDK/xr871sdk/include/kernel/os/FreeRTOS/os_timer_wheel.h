@@ -0,0 +1,123 @@
+/**
+ * @file os_timer_wheel.h
+ * @author XRADIO IOT WLAN Team
+ */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERNEL_OS_FREERTOS_OS_TIMER_WHEEL_H_
+#define _KERNEL_OS_FREERTOS_OS_TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hierarchical timer wheel: TWHEEL_LVL_NUM levels of TWHEEL_LVL_SIZE slots,
+ * level n slots being TWHEEL_LVL_SIZE^n ticks wide. A timer is filed in the
+ * level its distance falls in and moved down a level when the wheel reaches
+ * its slot, so filing and removing are O(1) and the wheel goes from one used
+ * slot to the next without visiting the empty ones.
+ *
+ * The wheel has no lock and no clock of its own, the caller serializes the
+ * calls and passes the current tick. Timer storage is the caller's.
+ */
+
+#define TWHEEL_LVL_BITS     6
+#define TWHEEL_LVL_SIZE     (1U << TWHEEL_LVL_BITS)
+#define TWHEEL_LVL_MASK     (TWHEEL_LVL_SIZE - 1)
+#define TWHEEL_LVL_NUM      4
+#define TWHEEL_MAP_WORDS    (TWHEEL_LVL_SIZE / 32)
+
+/* distances past 2^24 ticks, 4.6 hours at 1 kHz, are filed in the top slots
+ * and refiled when reached, the longest distance is 2^31 - 1 ticks */
+#define TWHEEL_SPAN         (1U << (TWHEEL_LVL_BITS * TWHEEL_LVL_NUM))
+#define TWHEEL_MAX_DELAY    0x7fffffffU
+
+#define TWHEEL_PERIODIC     (1U << 0)
+
+typedef void (*twheel_func_t)(void *arg);
+
+struct twheel_timer {
+	struct twheel_timer    *next;
+	struct twheel_timer   **pprev;      /* NULL when not pending */
+	uint32_t                expires;    /* the tick it is filed for */
+	uint32_t                due;        /* the tick it was asked for */
+	uint32_t                period;     /* delay of a start, reload interval */
+	uint32_t                slack;      /* ticks it may be late by */
+	twheel_func_t           func;
+	void                   *arg;
+	uint8_t                 flags;
+};
+
+struct twheel_stats {
+	uint32_t    fired;      /* timers expired */
+	uint32_t    late;       /* expired past their due tick plus slack */
+	uint32_t    late_max;   /* ticks past the due tick */
+	uint32_t    missed;     /* periods skipped by periodic timers */
+	uint32_t    overruns;   /* callbacks running longer than the budget */
+	uint32_t    run_max;    /* ticks of the longest callback */
+};
+
+struct twheel {
+	uint32_t                clk;        /* the next tick to process */
+	uint32_t                budget;     /* ticks a callback may run */
+	struct twheel_timer    *expired;
+	struct twheel_timer    *slot[TWHEEL_LVL_NUM][TWHEEL_LVL_SIZE];
+	uint32_t                map[TWHEEL_LVL_NUM][TWHEEL_MAP_WORDS];
+	struct twheel_stats     stats;
+};
+
+void twheel_init(struct twheel *w, uint32_t now, uint32_t budget);
+void twheel_timer_init(struct twheel_timer *t, twheel_func_t func, void *arg,
+                       uint32_t period, uint8_t flags);
+void twheel_add(struct twheel *w, struct twheel_timer *t, uint32_t due);
+void twheel_del(struct twheel *w, struct twheel_timer *t);
+struct twheel_timer *twheel_expire(struct twheel *w, uint32_t now);
+int twheel_next(struct twheel *w, uint32_t *expires);
+void twheel_ran(struct twheel *w, uint32_t ticks);
+
+/**
+ * @brief Check whether a timer is filed in a wheel or not
+ * @param[in] t Pointer to the timer
+ * @return 1 on pending, 0 on not
+ */
+static __inline int twheel_timer_pending(const struct twheel_timer *t)
+{
+	return (t->pprev != NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KERNEL_OS_FREERTOS_OS_TIMER_WHEEL_H_ */
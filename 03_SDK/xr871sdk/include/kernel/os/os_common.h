@@ -32,6 +32,8 @@
 
 #ifdef __CONFIG_OS_FREERTOS
 #include "kernel/os/FreeRTOS/os_common.h"
+#elif defined(__CONFIG_OS_POSIX)
+#include "kernel/os/posix/os_common.h"
 #else
 #error "No OS defined!"
 #endif
@@ -242,8 +242,9 @@
  * MEMP_NUM_PBUF: the number of memp struct pbufs (used for PBUF_ROM and PBUF_REF).
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
+ * shttpd sends static content with MSG_NOCOPY, one ROM pbuf per queued segment.
  */
-#define MEMP_NUM_PBUF                   6
+#define MEMP_NUM_PBUF                   16
 
 /**
  * MEMP_NUM_RAW_PCB: Number of raw connection PCBs
@@ -75,6 +75,12 @@ typedef OS_Thread_t * sys_thread_t;
 /* sleep */
 #define sys_msleep(msec)            OS_MSleep(msec)
 
+/* core lock, a mutex with priority inheritance owned by one thread at most */
+#if LWIP_TCPIP_CORE_LOCKING
+void sys_lock_tcpip_core(void);
+void sys_unlock_tcpip_core(void);
+#endif
+
 /* Ticks/jiffies since power up. */
 #define sys_jiffies()               OS_GetTicks()
 
@@ -1329,6 +1329,32 @@
 #define LWIP_WND_SCALE                  0
 #define TCP_RCV_SCALE                   0
 #endif
+
+/**
+ * LWIP_TCP_SACK_OUT==1: TCP will send selective acknowledgements (RFC 2018)
+ * for the data queued on ooseq, if the remote host permits it.
+ * Needs TCP_QUEUE_OOSEQ.
+ */
+#if !defined LWIP_TCP_SACK_OUT || defined __DOXYGEN__
+#define LWIP_TCP_SACK_OUT               0
+#endif
+
+/**
+ * LWIP_TCP_SACK_IN==1: TCP will permit the remote host to send selective
+ * acknowledgements and use them in fast recovery to retransmit every lost
+ * segment of a window, instead of only the first one.
+ */
+#if !defined LWIP_TCP_SACK_IN || defined __DOXYGEN__
+#define LWIP_TCP_SACK_IN                0
+#endif
+
+/**
+ * LWIP_TCP_MAX_SACK_NUM: The maximum number of SACK blocks to include in
+ * an ACK. At most 4 (3 with timestamps) fit into the TCP options.
+ */
+#if !defined LWIP_TCP_MAX_SACK_NUM || defined __DOXYGEN__
+#define LWIP_TCP_MAX_SACK_NUM           4
+#endif
 /**
  * @}
  */
@@ -145,7 +145,7 @@ typedef u32_t tcpwnd_size_t;
 typedef u16_t tcpwnd_size_t;
 #endif
 
-#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS
+#if LWIP_WND_SCALE || TCP_LISTEN_BACKLOG || LWIP_TCP_TIMESTAMPS || LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
 typedef u16_t tcpflags_t;
 #else
 typedef u8_t tcpflags_t;
@@ -223,6 +223,9 @@ struct tcp_pcb {
 #endif
 #if LWIP_TCP_TIMESTAMPS
 #define TF_TIMESTAMP   0x0400U   /* Timestamp option enabled */
+#endif
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+#define TF_SACK        0x0800U   /* SACK permitted by the remote host */
 #endif
 
   /* the rest of the fields are in host byte order
@@ -327,6 +330,14 @@ struct tcp_pcb {
   u8_t snd_scale;
   u8_t rcv_scale;
 #endif
+
+#if LWIP_TCP_SACK_OUT
+  u32_t rcv_sack_last; /* seqno of the last segment queued on ooseq */
+#endif
+#if LWIP_TCP_SACK_IN
+  u32_t sack_recover;  /* snd_nxt when fast recovery was entered */
+  u32_t sack_rexmit;   /* holes below this were retransmitted in fast recovery */
+#endif
 };
 
 #if LWIP_EVENT_API
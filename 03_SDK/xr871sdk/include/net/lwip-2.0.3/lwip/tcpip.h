@@ -53,9 +53,9 @@ extern "C" {
 /** The global semaphore to lock the stack. */
 extern sys_mutex_t lock_tcpip_core;
 /** Lock lwIP core mutex (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
-#define LOCK_TCPIP_CORE()     sys_mutex_lock(&lock_tcpip_core)
+#define LOCK_TCPIP_CORE()     sys_lock_tcpip_core()
 /** Unlock lwIP core mutex (needs @ref LWIP_TCPIP_CORE_LOCKING 1) */
-#define UNLOCK_TCPIP_CORE()   sys_mutex_unlock(&lock_tcpip_core)
+#define UNLOCK_TCPIP_CORE()   sys_unlock_tcpip_core()
 #else /* LWIP_TCPIP_CORE_LOCKING */
 #define LOCK_TCPIP_CORE()
 #define UNLOCK_TCPIP_CORE()
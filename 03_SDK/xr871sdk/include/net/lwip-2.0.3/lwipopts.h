@@ -207,7 +207,11 @@
  * UNLOCK_TCPIP_CORE().
  * Your system should provide mutexes supporting priority inversion to use this.
  */
-#define LWIP_TCPIP_CORE_LOCKING         0 // ???
+#ifdef __CONFIG_LWIP_CORE_LOCKING
+#define LWIP_TCPIP_CORE_LOCKING         1
+#else
+#define LWIP_TCPIP_CORE_LOCKING         0
+#endif
 
 /**
  * LWIP_TCPIP_CORE_LOCKING_INPUT: when LWIP_TCPIP_CORE_LOCKING is enabled,
@@ -216,8 +220,15 @@
  *
  * ATTENTION: this does not work when tcpip_input() is called from
  * interrupt context!
+ *
+ * NB: the whole input path runs in the Rx thread (the DUCC data thread), so
+ *     its stack MUST be as large as the tcpip thread's.
  */
+#if (defined(__CONFIG_LWIP_CORE_LOCKING) && defined(__CONFIG_LWIP_CORE_LOCKING_INPUT))
+#define LWIP_TCPIP_CORE_LOCKING_INPUT   1
+#else
 #define LWIP_TCPIP_CORE_LOCKING_INPUT   0
+#endif
 
 /**
  * SYS_LIGHTWEIGHT_PROT==1: enable inter-task protection (and task-vs-interrupt
@@ -348,8 +359,9 @@
  * MEMP_NUM_PBUF: the number of memp struct pbufs (used for PBUF_ROM and PBUF_REF).
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
+ * shttpd sends static content with MSG_NOCOPY, one ROM pbuf per queued segment.
  */
-#define MEMP_NUM_PBUF                   6
+#define MEMP_NUM_PBUF                   16
 
 /**
  * MEMP_NUM_RAW_PCB: Number of raw connection PCBs
@@ -1042,8 +1054,13 @@
 /**
  * TCP_OOSEQ_MAX_PBUFS: The maximum number of pbufs queued on ooseq per pcb.
  * Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ * NB: received packets are allocated from the pbuf pool, leave half of it
+ *     for in-sequence data and other connections. A full sized segment takes
+ *     one pool pbuf and at most (TCP_WND / TCP_MSS - 1) = 5 segments of a
+ *     window can be out of sequence, so the cap is only reached by peers
+ *     sending small segments.
  */
-#define TCP_OOSEQ_MAX_PBUFS             0
+#define TCP_OOSEQ_MAX_PBUFS             (PBUF_POOL_SIZE / 2)
 
 /**
  * TCP_LISTEN_BACKLOG: Enable the backlog option for tcp listen pcb.
@@ -1104,9 +1121,22 @@
  * range of [0..14]).
  * When LWIP_WND_SCALE is enabled but TCP_RCV_SCALE is 0, we can use a large
  * send window while having a small receive window only.
+ * NB: TCP_WND and TCP_SND_BUF are a few segments only, far below the 64 KB
+ *     an unscaled window can advertise, and the heap and the pbuf pool
+ *     can't back a larger one. Scaling would only widen the window fields.
+ */
+#define LWIP_WND_SCALE                  0
+#define TCP_RCV_SCALE                   0
+
+/**
+ * LWIP_TCP_SACK_OUT==1: send selective acknowledgements for the data queued
+ * on ooseq, if the remote host permits it.
+ * LWIP_TCP_SACK_IN==1: permit the remote host to send selective
+ * acknowledgements, and retransmit all holes reported in fast recovery.
  */
-#define LWIP_WND_SCALE                  0 // ???
-#define TCP_RCV_SCALE                   0 // ???
+#define LWIP_TCP_SACK_OUT               (TCP_QUEUE_OOSEQ)
+#define LWIP_TCP_SACK_IN                1
+#define LWIP_TCP_MAX_SACK_NUM           4
 /**
  * @}
  */
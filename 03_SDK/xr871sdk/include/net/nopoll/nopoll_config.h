@@ -40,7 +40,7 @@
  * @return A \ref noPollPtr reference.
  */
 #ifndef INT_TO_PTR
-#define INT_TO_PTR(integer) ((noPollPtr) (integer))
+#define INT_TO_PTR(integer) ((noPollPtr) (long) (integer))
 #endif
 
 /**
@@ -55,9 +55,26 @@
  * @return A int value.
  */
 #ifndef PTR_TO_INT
-#define PTR_TO_INT(ptr) ((int) (ptr))
+#define PTR_TO_INT(ptr) ((int) (long) (ptr))
 #endif
 
+#if defined(__CONFIG_OS_POSIX)
+/**
+ * @brief Host build (project/host_bench): POSIX sockets, mbedTLS.
+ */
+#define NOPOLL_OS_UNIX (1)
+
+#define NOPOLL_MBEDTLS (1)
+
+/* a va_list can't be walked twice on amd64 */
+#define NOPOLL_HAVE_VASPRINTF (1)
+
+#if defined(__LP64__)
+#define NOPOLL_64BIT_PLATFORM (1)
+#endif
+
+#else /* __CONFIG_OS_POSIX */
+
 /**
  * @brief Allows to get current platform configuration. This is used
  * by Nopoll library but could be used by applications built on top of
@@ -83,6 +100,8 @@
  */
 #define NOPOLL_MBEDTLS (1)
 
+#endif /* __CONFIG_OS_POSIX */
+
 /* @} */
 
 #endif
@@ -186,6 +186,9 @@ int           nopoll_conn_send_binary (noPollConn * conn, const char * content,
 
 int           nopoll_conn_send_binary_fragment (noPollConn * conn, const char * content, long length);
 
+int           nopoll_conn_send_iov (noPollConn * conn, noPollOpCode op_code, nopoll_bool has_fin,
+				    const noPollIov * iov, int iovcnt);
+
 int           nopoll_conn_complete_pending_write (noPollConn * conn);
 
 int           nopoll_conn_pending_write_bytes    (noPollConn * conn);
@@ -242,6 +245,8 @@ int nopoll_conn_default_send (noPollConn * conn, char * buffer, int buffer_size)
 
 void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp);
 
+nopoll_bool __nopoll_conn_has_frame_buffered (noPollConn * conn);
+
 END_C_DECLS
 
 #endif
@@ -325,6 +325,20 @@ typedef struct _noPollIoEngine noPollIoEngine;
  */
 typedef struct _noPollMsg noPollMsg;
 
+/**
+ * @brief One segment of a message sent with \ref nopoll_conn_send_iov.
+ */
+typedef struct _noPollIov {
+	/**
+	 * @brief Start of the segment.
+	 */
+	const void * base;
+	/**
+	 * @brief Amount of bytes in the segment.
+	 */
+	long         len;
+} noPollIov;
+
 /**
  * @brief Abstraction that represents the status and data exchanged
  * during the handshake.
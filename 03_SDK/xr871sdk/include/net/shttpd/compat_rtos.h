@@ -30,7 +30,21 @@
 #ifndef __COMPAT_RTOS_H_H
 #define __COMPAT_RTOS_H_H
 
+#ifdef __CONFIG_OS_POSIX
+/* host build, over the host sockets */
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#define closesocket(s)                  close(s)
+#define ioctlsocket(s, cmd, argp)       ioctl(s, cmd, argp)
+#define MSG_NOCOPY                      0
+#else
 #include "lwip/sockets.h"
+#endif
 #include "kernel/os/os.h"
 
 #define DIRSEP                          '/'
@@ -40,6 +54,7 @@
 #define SHTTPD_SINGLE_CONNECTION
 #define SHTTPD_LOG_ALT
 #define SHTTPD_MEM_IN_HEAP
+//#define SHTTPD_CONTENT_FATFS
 //#define SHTTPD_SSL
 //#define SHTTPD_CUSTOM_LOG_ON
 //#define SHTTPD_DEBUG_ON
@@ -47,15 +62,56 @@
 #include "kernel/os/os_time.h"
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
 
 struct usr_file {
 	char *name;
 	char *body;
 };
 
+/*
+ * Static content, possibly binary and with a gzip encoded variant. The data
+ * is sent in place, so it must stay valid and unchanged while registered.
+ */
+struct usr_content {
+	const char    *name;
+	const void    *body;
+	unsigned long len;
+	const void    *gz_body;     /* gzip encoded body, NULL if none */
+	unsigned long gz_len;
+	unsigned long etag;         /* 0 to hash the body */
+};
+
+/*
+ * Content image, as made by tools/mkwebimg.py. It may be read in place from
+ * XIP mapped flash. All fields are little endian, offsets are from the image
+ * start and every name and body is followed by a '\0' not counted in len.
+ */
+#define CONTENT_IMAGE_MAGIC       (0x49434853) /* "SHCI" */
+#define CONTENT_IMAGE_VERSION     (1)
+
+struct content_image_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;             /* entries following the header */
+	uint32_t size;              /* whole image size */
+};
+
+struct content_image_entry {
+	uint32_t name;
+	uint32_t body;
+	uint32_t len;
+	uint32_t gz_body;           /* 0 if none */
+	uint32_t gz_len;
+	uint32_t etag;
+};
+
 struct f_stat {
 	unsigned long st_size;
 	unsigned int  st_mode;
+	unsigned long st_etag;      /* entity tag of the selected variant */
+	unsigned int  st_gzip;      /* the gzip variant is selected */
+	void          *st_local;    /* registered content, NULL for FatFS */
 };
 
 time_t TIME(time_t *timer);
@@ -74,6 +130,12 @@ time_t TIME(time_t *timer);
 void _shttpd_free(void *ptr);
 void *_shttpd_zalloc(size_t size);
 void _shttpd_init_local_file(const struct usr_file *list, int count);
+void _shttpd_deinit_local_file(void);
+int _shttpd_add_local_content(const struct usr_content *list, int count);
+int _shttpd_mount_content_image(const void *image, unsigned long size);
+#if defined(SHTTPD_CONTENT_FATFS)
+int _shttpd_mount_content_dir(const char *dir);
+#endif
 
 #if defined(SHTTPD_THREADS)
 #define HTTP_THREAD_STACK_SIZE	(4 * 1024)
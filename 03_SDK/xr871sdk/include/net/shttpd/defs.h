@@ -124,6 +124,8 @@ struct headers {
 	union variant   range;        /* Range:			*/
 	union variant   status;       /* Status:			*/
 	union variant   transenc;     /* Transfer-Encoding:		*/
+	union variant   ae;           /* Accept-Encoding:		*/
+	union variant   inm;          /* If-None-Match:		*/
 };
 
 /* Must go after union variant definition */
@@ -136,7 +138,10 @@ union channel {
 #if defined(SHTTPD_FS)
 	int                  fd;            /* Regular static file */
 #else
-	unsigned int         fh;            /* file handler */
+	char                 *fh;           /* Static content */
+#if defined(SHTTPD_CONTENT_FATFS)
+	void                 *fil;          /* FatFS file */
+#endif
 #endif
 	int                  sock;          /* Connected socket	*/
 
@@ -198,6 +203,7 @@ struct stream {
 #define FLAG_DONT_CLOSE            32
 #define FLAG_ALWAYS_READY          64      /* File, dir, user_func */
 #define FLAG_SUSPEND               128
+#define FLAG_STATIC                256     /* Sent from chan.fh, no copy */
 };
 
 struct worker {
@@ -270,6 +276,7 @@ struct shttpd_ctx {
 	FILE           *error_log;        /* Error log stream		*/
 #endif
 	char           *options[NUM_OPTIONS];     /* Configurable options		*/
+	struct shttpd_stats stats;       /* Static content counters	*/
 #if defined(__rtems__)
 	rtems_id       mutex;
 #endif /* _WIN32 */
@@ -393,6 +400,10 @@ extern int _shttpd_put_dir(const char *path);
 extern void _shttpd_get_dir(struct conn *c);
 #endif
 extern void _shttpd_get_file(struct conn *c, struct stat *stp);
+#if !defined(SHTTPD_FS)
+extern int _shttpd_open_content(struct conn *c, const char *path,
+                                         struct stat *stp);
+#endif
 extern void _shttpd_ssl_handshake(struct stream *stream);
 extern void _shttpd_setup_embedded_stream(struct conn *,
                                                         union variant, void *);
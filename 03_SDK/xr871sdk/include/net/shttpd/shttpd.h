@@ -63,6 +63,17 @@ struct shttpd_arg {
  */
 typedef void (*shttpd_callback_t)(struct shttpd_arg *);
 
+/*
+ * Counters of the static content responses, see shttpd_get_stats().
+ */
+struct shttpd_stats {
+	unsigned long	responses;	/* Static content responses	*/
+	unsigned long	not_modified;	/* Of them answered with 304	*/
+	unsigned long	gzip;		/* Of them sent gzip encoded	*/
+	unsigned long	bytes_copied;	/* Body bytes copied to buffers	*/
+	unsigned long	bytes_nocopy;	/* Body bytes sent in place	*/
+};
+
 /*
  * shttpd_init		Initialize shttpd context
  * shttpd_fini		Dealocate the context, close all connections
@@ -106,6 +117,7 @@ int  shttpd_socketpair(int sp[2]);
 #endif
 int shttpd_join(struct shttpd_ctx *, fd_set *, fd_set *, int *max_fd);
 int shttpd_set_ssl_cert(void *cert);
+void shttpd_get_stats(struct shttpd_ctx *, struct shttpd_stats *);
 
 #ifdef __cplusplus
 }
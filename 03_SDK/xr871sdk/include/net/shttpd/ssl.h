@@ -13,8 +13,12 @@
  * from the OpenSSL source installation. Having this, shttpd + SSL can be
  * built on any system with binary SSL libraries installed.
  */
+#ifdef __CONFIG_OS_POSIX
+typedef void SSL_CTX;			/* host build, no SSL */
+#else
 #include "net/mbedtls/mbedtls.h"
 typedef mbedtls_context SSL_CTX;
+#endif
 
 SSL_CTX* shttpd_ssl_wrapper_new();
 void shttpd_ssl_wrapper_free(SSL_CTX *ssl_context);
@@ -31,9 +31,15 @@
 #define _NET_SNTP_H_
 
 #include <stdint.h>
+#ifdef __CONFIG_OS_POSIX
+#include <sys/time.h>
+#else
 #include "lwip/sockets.h"
+#endif
 
+#ifndef SNTP_PORT
 #define SNTP_PORT                     123
+#endif
 #define SNTP_SUPPORT_MULTIPLE_SERVERS 1
 #if SNTP_SUPPORT_MULTIPLE_SERVERS
 #define SNTP_MAX_SERVERS              3
@@ -42,12 +48,19 @@
 #define SNTP_RETRY_TIMEOUT            SNTP_RECV_TIMEOUT
 #define SNTP_RETRY_TIMES              3
 
+#define SNTP_SAMPLES                  4    /* default samples taken from each server */
+#define SNTP_MAX_SAMPLES              8
+#ifndef SNTP_SAMPLE_INTERVAL
+#define SNTP_SAMPLE_INTERVAL          2000 /* ms between two samples of a server */
+#endif
+
 #define SNTP_SERVER_ADDRESS          "pool.ntp.org"
 
 typedef struct {
 	char *server_name;    /* remote server name, if this is not NULL, this will be preferred. */
 	int recv_timeout;     /* the receive timeout from ntp server */
 	uint8_t retry_times;  /* the retry times when receiver timeout */
+	uint8_t samples;      /* samples taken from each server, 0 for SNTP_SAMPLES */
 } sntp_arg;
 
 typedef struct {
@@ -60,6 +73,17 @@ typedef struct {
         uint8_t year;      /**< Years                      - [0,127] */
 } sntp_time;
 
+typedef struct {
+	uint8_t synced;       /* the clock has been set by a sync */
+	uint8_t servers;      /* servers that survived the selection of the last sync */
+	uint8_t stratum;      /* stratum of the best server of the last sync */
+	int32_t offset;       /* us, correction measured by the last sync */
+	int32_t delay;        /* us, round trip delay of the best server */
+	int32_t jitter;       /* us, offset jitter of the selected servers */
+	int32_t freq;         /* ppb, frequency correction of the local clock */
+	uint32_t steps;       /* times the clock has been stepped */
+} sntp_status;
+
 int sntp_request(void *arg);
 sntp_time *sntp_obtain_time(void);
 
@@ -68,5 +92,9 @@ int sntp_get_time(sntp_arg *arg, struct timeval *ntp_time);
 int sntp_set_server(uint8_t idx, char *server_name);
 #endif
 
+int sntp_sync(sntp_arg *arg);
+int64_t sntp_get_time_us(void);
+int sntp_get_status(sntp_status *status);
+
 #endif /* _NET_SNTP_H_ */
 
@@ -39,6 +39,10 @@ struct dhcp_server_info {
 	unsigned int addr_end;
 	unsigned int lease_time;
 	unsigned int max_leases;
+	/* optional, keep the leases across restarts. lease_save() stores len
+	 * bytes of opaque data, lease_load() returns the length read back. */
+	int (*lease_save)(const void *data, unsigned int len);
+	int (*lease_load)(void *data, unsigned int size);
 };
 
 void dhcp_server_start(const struct dhcp_server_info *arg);
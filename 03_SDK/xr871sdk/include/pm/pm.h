@@ -99,6 +99,24 @@ enum pm_op_t {
 
 struct soc_device;
 
+/** @brief Latency histogram buckets: <128us, <512us, <2ms, <8ms, <32ms, more. */
+#define PM_TIME_BUCKETS         6
+#define PM_TIME_BUCKET0_US      128
+
+enum pm_time_t {
+	PM_TIME_SUSPEND = 0,
+	PM_TIME_RESUME,
+	PM_TIME_NUM,
+};
+
+/** @brief Latency statistic kept across suspend/resume cycles. */
+struct pm_time_stats {
+	uint32_t count;
+	uint32_t max_us;
+	uint32_t sum_us;
+	uint16_t hist[PM_TIME_BUCKETS];
+};
+
 /**
  * @brief The basic device driver structure.
  * @suspend:    Called to put the device to sleep mode. Usually to a
@@ -129,6 +147,15 @@ struct soc_device_driver {
  * @note For devices on custom boards, as typical of embedded and SOC based
  *   hardware, You uses platform_data to point to board-specific structures
  *   describing devices and how they are wired.
+ * @deps:  NULL terminated names of devices whose resume() must have finished
+ *         before this device's resume() starts. Only needed between devices
+ *         of the normal phase, all noirq devices are resumed before.
+ * @async: resume() may run on a pm worker thread, overlapped with the
+ *         devices around it. Synchronous devices before it have finished
+ *         when it starts, devices needing it must list it in their @deps.
+ *         Its resume() must change registers shared with other devices
+ *         (CCM bus clock and reset, GPIO) only through the HAL calls doing
+ *         it with the interrupts off.
  */
 struct soc_device {
 	struct list_head node[PM_OP_NUM];
@@ -138,6 +165,12 @@ struct soc_device {
 
 	const struct soc_device_driver *driver; /* which driver has allocated this device */
 	void *platform_data;                    /* Platform specific data, device core doesn't touch it */
+
+	const char *const *deps;                /* devices to be resumed first */
+	uint8_t async;                          /* resume on a pm worker */
+	uint8_t pm_flags;                       /* pm core private */
+
+	struct pm_time_stats time[PM_OP_NUM][PM_TIME_NUM]; /* pm core private */
 };
 
 #ifdef CONFIG_PM
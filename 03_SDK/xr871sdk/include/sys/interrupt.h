@@ -32,7 +32,34 @@
 
 #include "compiler.h"
 
-#if defined(__CC_ARM)
+#if defined(__CONFIG_OS_POSIX)
+/* Host build, there are no interrupts. Masking them takes the scheduler lock,
+ * so the critical sections still exclude each other.
+ */
+#include "kernel/os/os_thread.h"
+
+static __always_inline unsigned long arch_irq_save(void)
+{
+	OS_ThreadSuspendScheduler();
+	return 0;
+}
+
+static __always_inline void arch_irq_restore(unsigned long flags)
+{
+	OS_ThreadResumeScheduler();
+}
+
+static __always_inline unsigned long arch_irq_get_flags(void)
+{
+	return 0;
+}
+
+#define arch_irq_enable()	OS_ThreadResumeScheduler()
+#define arch_irq_disable()	OS_ThreadSuspendScheduler()
+#define arch_fiq_enable()	do { } while (0)
+#define arch_fiq_disable()	do { } while (0)
+
+#elif defined(__CC_ARM)
 /* ARM Compiler */
 
 /*
@@ -87,6 +87,8 @@
 #define SOCKET_CACHE_BUFFER_SIZE	1024
 
 #define SERVER_THREAD_STACK_SIZE	(2 * 1024)
+#define PUMP_THREAD_STACK_SIZE	(2 * 1024)
+#define PUMP_RECV_TIMEOUT	100	/* ms, how often the pump checks for stop */
 
 typedef struct {
 	s32 cmd;
@@ -123,6 +125,16 @@ typedef struct {
 	s32 protocol;
 } server_arg_t;
 
+/* passes data from the socket to the serial port in data mode */
+typedef struct {
+	OS_Thread_t thread;
+	volatile u32 run;
+	volatile AT_ERROR_CODE status;
+	s32 fd;
+	s32 protocol;
+	u8 *buffer;
+} pump_t;
+
 typedef struct {
 	u32 flag; /* 0: disconnect    1: connect */
 	s32 sock_fd;
@@ -147,11 +159,15 @@ static server_ctrl_t g_server_ctrl;
 static u32 g_server_enable = 0;
 static OS_Semaphore_t g_server_sem;
 
+static pump_t g_pump;
+
 static AT_ERROR_CODE callback(AT_CALLBACK_CMD cmd, at_callback_para_t *para, at_callback_rsp_t *rsp);
 
 static AT_ERROR_CODE act(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE reset(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp);
+static AT_ERROR_CODE mode_start(at_callback_para_t *para, at_callback_rsp_t *rsp);
+static AT_ERROR_CODE mode_stop(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE save(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE load(at_callback_para_t *para, at_callback_rsp_t *rsp);
 static AT_ERROR_CODE status(at_callback_para_t *para, at_callback_rsp_t *rsp);
@@ -193,6 +209,8 @@ static const callback_handler_t callback_tbl[] = {
 	{ACC_GPIOR,				gpior},
 	{ACC_GPIOW,				gpiow},
 	{ACC_SCAN,				scan},
+	{ACC_MODE_START,		mode_start},
+	{ACC_MODE_STOP,			mode_stop},
 };
 
 static const u32 channel_freq_tbl[] = {
@@ -429,129 +447,93 @@ static AT_ERROR_CODE reset(at_callback_para_t *para, at_callback_rsp_t *rsp)
 	return aec;
 }
 
-static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
+static void pump_task(void *arg)
 {
-	AT_ERROR_CODE res = AEC_OK;
-	s32 id;
-	u8 *buffer;
-	s32 len;
-	s32 timeout_ms=10;
-	fd_set fdset_r,fdset_w;
-	int fd;
-	struct sockaddr_in address;
-	socklen_t addr_len;
-	char ip[IP_ADDR_SIZE+1];
-	s16 port;
-	s32 protocol;
+	pump_t *pump;
+	int rc;
 
-	if (!g_server_enable) { /* as client */
-		id = 0;
-		fd = networks.connect[id].fd;
-		protocol = networks.connect[id].protocol;
-		port = networks.connect[id].port;
-		strncpy(ip, networks.connect[id].ip, sizeof(ip));
+	pump = arg;
 
-		if (networks.count > 0) {
-			if (networks.connect[id].flag) {
-				int rc = -1;
-				struct timeval tv;
+	while (pump->run) {
+		rc = recv(pump->fd, pump->buffer, SOCKET_CACHE_BUFFER_SIZE, 0);
+		if (rc > 0) {
+			/* received normally */
+			serial_write(pump->buffer, rc);
+		}
+		else if (rc == 0) {
+			if (pump->protocol == 0) { /* TCP */
+				/* has disconnected with peer */
+				pump->status = AEC_DISCONNECT;
+				break;
+			}
+		}
+		else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			/* network error */
+			pump->status = AEC_NETWORK_ERROR;
+			break;
+		}
+	}
+
+	pump->run = 0;
+	OS_ThreadDelete(&pump->thread);
+}
 
-				FD_ZERO(&fdset_w);
-				FD_ZERO(&fdset_r);
-				FD_SET(fd, &fdset_w);
-				FD_SET(fd, &fdset_r);
+static AT_ERROR_CODE pump_start(s32 fd, s32 protocol, u8 *buffer)
+{
+	int timeout = PUMP_RECV_TIMEOUT;
 
-				tv.tv_sec = timeout_ms / 1000;
-				tv.tv_usec = (timeout_ms % 1000) * 1000;
+	if (OS_ThreadIsValid(&g_pump.thread)) {
+		return AEC_IMPROPER_OPERATION;
+	}
 
-				rc = select(fd + 1, &fdset_r, NULL, NULL, &tv);
-				if (rc > 0) {
-					if (FD_ISSET(fd, &fdset_r)) {
-						buffer = socket_cache[id].buffer;
-						len = SOCKET_CACHE_BUFFER_SIZE;
-
-						if (protocol == 0) { /* TCP */
-							rc = recv(fd, buffer, len, 0);
-						}
-						else if (protocol == 1) { /* UDP */
-							address.sin_port = htons(port);
-							address.sin_family = AF_INET;
-							address.sin_addr.s_addr= inet_addr(ip);
-
-							addr_len = sizeof(address);
-
-							rc = recvfrom(fd, buffer, len, 0, (struct sockaddr *)&address, &addr_len);
-						}
-
-						if (rc > 0) {
-							/* received normally */
-							serial_write(buffer, rc);
-						}
-						else if (rc == 0) {
-							/* has disconnected with server */
-							res = AEC_DISCONNECT;
-						}
-						else {
-							/* network error */
-							res = AEC_NETWORK_ERROR;
-						}
-					}
-				}
-				else if (rc == 0) {
-					/* timeouted and sent 0 bytes */
-				}
-				else {
-					 /* network error */
-					res = AEC_NETWORK_ERROR;
-				}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	g_pump.fd = fd;
+	g_pump.protocol = protocol;
+	g_pump.buffer = buffer;
+	g_pump.status = AEC_OK;
+	g_pump.run = 1;
+
+	if (OS_ThreadCreate(&g_pump.thread,
+	                    "pump",
+	                    pump_task,
+	                    &g_pump,
+	                    OS_PRIORITY_NORMAL,
+	                    PUMP_THREAD_STACK_SIZE) != OS_OK) {
+		FUN_DEBUG("create pump task failed\n");
+		g_pump.run = 0;
+		return AEC_UNDEFINED;
+	}
 
-				rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
-				if (rc > 0) {
-					if (FD_ISSET(fd, &fdset_w)) {
-						buffer = para->u.mode.buf;
-						len = para->u.mode.len;
-
-						if (buffer != NULL && len >0) {
-							if (protocol == 0) { /* TCP */
-								rc = send(fd, buffer, len, 0);
-							}
-							else if (protocol == 1) { /* UDP */
-								address.sin_port = htons(port);
-								address.sin_family = AF_INET;
-								address.sin_addr.s_addr= inet_addr(ip);
-
-								addr_len = sizeof(address);
-								rc = sendto(fd, buffer, len, 0, (struct sockaddr *)&address, sizeof(address));
-							}
-
-							if (rc > 0) {
-								/* do nothing */
-							}
-							else if (rc == 0) {
-								/* disconnected with server */
-								res = AEC_DISCONNECT;
-							}
-							else {
-								/* network error */
-								res = AEC_NETWORK_ERROR;
-							}
-						}
-					}
-				}
-				else if (rc == 0) {
-					/* timeouted and sent 0 bytes */
-				}
-				else {
-					 /* network error */
-					res = AEC_NETWORK_ERROR;
-				}
-			}
-			else {
-				res = AEC_SWITCH_MODE;
-			}
+	return AEC_OK;
+}
+
+static void pump_stop(void)
+{
+	int timeout = 0;
+
+	g_pump.run = 0;
+	while (OS_ThreadIsValid(&g_pump.thread)) {
+		OS_MSleep(10);
+	}
+
+	setsockopt(g_pump.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+static AT_ERROR_CODE mode_start(at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	s32 id;
+
+	if (!g_server_enable) { /* as client */
+		id = 0;
+
+		if (networks.count > 0 && networks.connect[id].flag) {
+			return pump_start(networks.connect[id].fd,
+			                  networks.connect[id].protocol,
+			                  socket_cache[id].buffer);
 		}
 		else {
-			res = AEC_SWITCH_MODE;
+			return AEC_SWITCH_MODE;
 		}
 	}
 	else { /* as server */
@@ -565,116 +547,89 @@ static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
 		}
 
 		if (g_server_ctrl.flag) {
-			int rc = -1;
-			struct timeval tv;
-
-			port = g_server_ctrl.port;
-			protocol = g_server_ctrl.protocol;
-			fd = g_server_ctrl.conn_fd;
+			return pump_start(g_server_ctrl.conn_fd,
+			                  g_server_ctrl.protocol,
+			                  socket_cache[MAX_SOCKET_NUM].buffer);
+		}
+		else {
+			return AEC_DISCONNECT;
+		}
+	}
+}
 
-			FD_ZERO(&fdset_w);
-			FD_ZERO(&fdset_r);
-			FD_SET(fd, &fdset_w);
-			FD_SET(fd, &fdset_r);
+static AT_ERROR_CODE mode_stop(at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	pump_stop();
 
-			tv.tv_sec = timeout_ms / 1000;
-			tv.tv_usec = (timeout_ms % 1000) * 1000;
+	if (g_server_enable && g_pump.status == AEC_DISCONNECT &&
+	    g_server_ctrl.protocol == 0) { /* TCP */
+		/* accept the next connection */
+		server_mutex_lock();
+		g_server_net.conn_fd = -1;
+		g_server_net.flag = 0;
+		server_mutex_unlock();
 
-			rc = select(fd + 1, &fdset_r, NULL, NULL, &tv);
-			if (rc > 0) {
-				if (FD_ISSET(fd, &fdset_r)) {
-					buffer = socket_cache[MAX_SOCKET_NUM].buffer;
-					len = SOCKET_CACHE_BUFFER_SIZE;
+		OS_SemaphoreRelease(&g_server_sem);
 
-					if (protocol == 0) { /* TCP */
-						rc = recv(fd, buffer, len, 0);
-					}
-					else if (protocol == 1) { /* UDP */
-						address.sin_port = htons(port);
-						address.sin_family = AF_INET;
-						address.sin_addr.s_addr= inet_addr(ip);
+		g_server_ctrl.flag = 0;
+	}
 
-						addr_len = sizeof(address);
+	return AEC_OK;
+}
 
-						rc = recvfrom(fd, buffer, len, 0, (struct sockaddr *)&address, &addr_len);
-					}
+/* Socket to serial port is done by pump_task, this sends the data from the
+ * serial port, and reports the state of the connection. */
+static AT_ERROR_CODE mode(at_callback_para_t *para, at_callback_rsp_t *rsp)
+{
+	AT_ERROR_CODE res;
+	u8 *buffer;
+	s32 len;
+	s32 sent;
+	int rc;
+	int fd;
+	s32 protocol;
+	s32 id;
 
-					if (rc > 0) {
-						/* received normally */
-						serial_write(buffer, rc);
-					}
-					else if (rc == 0) {
-						/* has disconnected with server */
-						if (protocol == 0) { /* TCP */
-							server_mutex_lock();
-							g_server_net.conn_fd = -1;
-							g_server_net.flag = 0;
-							server_mutex_unlock();
+	res = g_pump.status;
+	if (res != AEC_OK) {
+		return res;
+	}
 
-							OS_SemaphoreRelease(&g_server_sem);
+	buffer = para->u.mode.buf;
+	len = para->u.mode.len;
+	fd = g_pump.fd;
+	protocol = g_pump.protocol;
 
-							g_server_ctrl.flag = 0;
-						}
+	for (sent = 0; buffer != NULL && sent < len; sent += rc) {
+		if (protocol == 0) { /* TCP */
+			rc = send(fd, buffer + sent, len - sent, 0);
+		}
+		else if (!g_server_enable) { /* UDP */
+			struct sockaddr_in address;
 
-						res = AEC_DISCONNECT;
-					}
-					else {
-						/* network error */
-						res = AEC_NETWORK_ERROR;
-					}
-				}
-			}
-			else if (rc == 0) {
-				/* timeouted and sent 0 bytes */
-			}
-			else {
-				 /* network error */
-				res = AEC_NETWORK_ERROR;
-			}
+			id = 0;
+			address.sin_port = htons(networks.connect[id].port);
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = inet_addr(networks.connect[id].ip);
 
-			rc = select(fd + 1, NULL, &fdset_w, NULL, &tv);
-			if (rc > 0) {
-				if (FD_ISSET(fd, &fdset_w)) {
-					buffer = para->u.mode.buf;
-					len = para->u.mode.len;
-
-					if (buffer != NULL && len >0) {
-						if (protocol == 0) { /* TCP */
-							rc = send(fd, buffer, len, 0);
-						}
-						else if (protocol == 1) { /* UDP */
-							FUN_DEBUG("Unsupported!\n");
-						}
-
-						if (rc > 0) {
-							/* do nothing */
-						}
-						else if (rc == 0) {
-							/* disconnected with server */
-							res = AEC_DISCONNECT;
-						}
-						else {
-							/* network error */
-							res = AEC_NETWORK_ERROR;
-						}
-					}
-				}
-			}
-			else if (rc == 0) {
-				/* timeouted and sent 0 bytes */
-			}
-			else {
-				 /* network error */
-				res = AEC_NETWORK_ERROR;
-			}
+			rc = sendto(fd, buffer + sent, len - sent, 0, (struct sockaddr *)&address, sizeof(address));
 		}
 		else {
-			res = AEC_DISCONNECT;
+			FUN_DEBUG("Unsupported!\n");
+			break;
 		}
-	}
 
-	return res;
+		if (rc == 0) {
+			/* disconnected with peer */
+			return AEC_DISCONNECT;
+		}
+		else if (rc < 0) {
+			/* network error */
+			return AEC_NETWORK_ERROR;
+		}
+	}
 
+	return AEC_OK;
 }
 
 static AT_ERROR_CODE save(at_callback_para_t *para, at_callback_rsp_t *rsp)
@@ -35,6 +35,7 @@
 
 #define SERIAL_CACHE_BUF_NUM	16
 #define SERIAL_CACHE_BUF_SIZE	(64/2)
+#define SERIAL_READ_TIMEOUT		10	/* ms */
 
 typedef enum {
 	SERIAL_STATE_STOP = 0,
@@ -54,6 +55,7 @@ typedef struct serial_priv {
 		volatile uint8_t cnt;
 		uint8_t widx;
 		uint8_t ridx;
+		uint8_t roff; /* bytes already read from the buffer at ridx */
 		uint8_t len[SERIAL_CACHE_BUF_NUM];
 		uint8_t buf[SERIAL_CACHE_BUF_NUM][SERIAL_CACHE_BUF_SIZE];
 	} cache;
@@ -276,61 +278,70 @@ void serial_stop(void)
 	serial->state = SERIAL_STATE_STOP;
 }
 
+/*
+ * Read what the rx callback has cached, up to size bytes. Waits up to
+ * SERIAL_READ_TIMEOUT ms if nothing is cached, returns 0 on timeout.
+ */
 int serial_read(uint8_t *buf, int32_t size)
 {
 	serial_priv_t *serial;
 	uint32_t cnt;
 	uint32_t idx;
+	uint32_t off;
+	uint32_t len;
 	int rlen = 0;
 
-	SERIAL_DBG("%s() start...\n", __func__);
-
 	serial = &g_serial;
 
-	idx = serial->cache.ridx;
-
-	while (1) {
-/*
-		if (OS_SemaphoreWait(&serial->cmd_sem, OS_WAIT_FOREVER) != OS_OK)
-			continue;
-*/
-		if (OS_SemaphoreWait(&serial->cmd_sem, 10) != OS_OK)
-			break;
+	arch_irq_disable();
+	cnt = serial->cache.cnt;
+	arch_irq_enable();
 
-		if (serial->state != SERIAL_STATE_START)
-			break;
+	while (cnt == 0) {
+		/* NB: the semaphore is released once per buffer, but several
+		 * buffers may be taken at a time, so it can be signaled
+		 * without anything cached. */
+		if (OS_SemaphoreWait(&serial->cmd_sem, SERIAL_READ_TIMEOUT) != OS_OK)
+			return 0;
 
 		arch_irq_disable();
 		cnt = serial->cache.cnt;
 		arch_irq_enable();
+	}
 
-		if (cnt > 0) {
-			rlen = serial->cache.len[idx];
-			if (rlen > size) {
-				return -1; /* buffer size is too small */
-			}
+	if (serial->state != SERIAL_STATE_START)
+		return 0;
 
-			memcpy(buf, serial->cache.buf[idx], rlen);
+	idx = serial->cache.ridx;
+	off = serial->cache.roff;
 
-			idx++;
-			if (idx >= SERIAL_CACHE_BUF_NUM) {
-				idx = 0;
-			}
+	while (cnt > 0 && rlen < size) {
+		len = serial->cache.len[idx] - off;
+		if (len > size - rlen) {
+			len = size - rlen;
+		}
 
-			serial->cache.ridx = idx;
+		memcpy(buf + rlen, &serial->cache.buf[idx][off], len);
+		rlen += len;
+		off += len;
 
-			arch_irq_disable();
-			serial->cache.cnt--;
-			arch_irq_enable();
+		if (off < serial->cache.len[idx])
+			break; /* buf is full */
 
-			break;
-		}
-		else {
-			SERIAL_WARN("no valid command\n");
-			return -2; /* no data  */
+		off = 0;
+		idx++;
+		if (idx >= SERIAL_CACHE_BUF_NUM) {
+			idx = 0;
 		}
+
+		arch_irq_disable();
+		cnt = --serial->cache.cnt;
+		arch_irq_enable();
 	}
 
+	serial->cache.ridx = idx;
+	serial->cache.roff = off;
+
 	return rlen;
 }
 
@@ -29,8 +29,7 @@
 
 #include <stdint.h>
 #ifdef __CONFIG_BIN_COMPRESS
-#include <stdlib.h>
-#include "xz/xz.h"
+#include "image/decomp.h"
 #include "kernel/os/os_time.h"
 #endif
 #include "driver/chip/system_chip.h"
@@ -86,113 +85,6 @@ static __inline void bl_hw_deinit(void)
 	SystemDeInit(0);
 }
 
-#ifdef __CONFIG_BIN_COMPRESS
-
-#define BL_DEC_BIN_INBUF_SIZE (4 * 1024)
-#define BL_DEC_BIN_DICT_MAX   (32 * 1024)
-
-static int bl_decompress_bin(section_header_t *sh, uint32_t max_size)
-{
-	uint8_t *in_buf;
-	uint32_t read_size, len, id, offset, left;
-	uint16_t chksum;
-	struct xz_dec *s;
-	struct xz_buf b;
-	enum xz_ret xzret;
-	int ret = -1;
-#if BL_DBG_ON
-	OS_Time_t tm;
-#endif
-
-#if BL_DBG_ON
-	BL_DBG("%s() start\n", __func__);
-	tm = OS_GetTicks();
-#endif
-
-	in_buf = malloc(BL_DEC_BIN_INBUF_SIZE);
-	if (in_buf == NULL) {
-		BL_ERR("no mem\n");
-		return ret;
-	}
-
-	/*
-	 * Support up to BL_DEC_BIN_DICT_MAX KiB dictionary. The actually
-	 * needed memory is allocated once the headers have been parsed.
-	 */
-	s = xz_dec_init(XZ_DYNALLOC, BL_DEC_BIN_DICT_MAX);
-	if (s == NULL) {
-		BL_ERR("no mem\n");
-		goto out;
-	}
-
-	b.in = in_buf;
-	b.in_pos = 0;
-	b.in_size = 0;
-	b.out = (uint8_t *)sh->load_addr;
-	b.out_pos = 0;
-	b.out_size = max_size;
-
-	id = sh->id;
-	offset = 0;
-	left = sh->body_len;
-	chksum = sh->data_chksum;
-
-	while (1) {
-		if (b.in_pos == b.in_size) {
-			if (left == 0) {
-				BL_ERR("no more input data\n");
-				break;
-			}
-			read_size = left > BL_DEC_BIN_INBUF_SIZE ?
-			            BL_DEC_BIN_INBUF_SIZE : left;
-			len = image_read(id, IMAGE_SEG_BODY, offset, in_buf, read_size);
-			if (len != read_size) {
-				BL_ERR("read img body fail, id %#x, off %u, len %u != %u\n",
-				         id, offset, len, read_size);
-				break;
-			}
-			chksum += image_get_checksum(in_buf, len);
-			offset += len;
-			left -= len;
-			b.in_size = len;
-			b.in_pos = 0;
-		}
-
-		xzret = xz_dec_run(s, &b);
-
-		if (b.out_pos == b.out_size) {
-			BL_ERR("decompress size >= %u\n", b.out_size);
-			break;
-		}
-
-		if (xzret == XZ_OK) {
-			continue;
-		} else if (xzret == XZ_STREAM_END) {
-#if BL_DBG_ON
-			tm = OS_GetTicks() - tm;
-			BL_DBG("%s() end, size %u --> %u, cost %u ms\n", __func__,
-			         sh->body_len, b.out_pos, tm);
-#endif
-			if (chksum != 0xFFFF) {
-				BL_ERR("invalid checksum %#x\n", chksum);
-			} else {
-				ret = 0;
-			}
-			break;
-		} else {
-			BL_ERR("xz_dec_run() fail %d\n", xzret);
-			break;
-		}
-	}
-
-out:
-	xz_dec_end(s);
-	free(in_buf);
-	return ret;
-}
-
-#endif /* __CONFIG_BIN_COMPRESS */
-
 static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 {
 	uint32_t len;
@@ -212,7 +104,8 @@ static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 	}
 #ifdef __CONFIG_BIN_COMPRESS
 	if (sh.attribute & IMAGE_ATTR_FLAG_COMPRESS) {
-		if (bl_decompress_bin(&sh, max_addr - sh.load_addr) != 0) {
+		if (image_decompress(&sh, (void *)sh.load_addr,
+		                     max_addr - sh.load_addr, NULL) != 0) {
 			BL_ERR("decompress bin %#x failed\n", id);
 			return BL_LOAD_BIN_INVALID;
 		}
@@ -241,10 +134,13 @@ static int bl_load_bin_by_id(uint32_t id, uint32_t max_addr, uint32_t *entry)
 			return BL_LOAD_BIN_INVALID;
 		}
 
-		if (image_check_data(&sh, (void *)sh.load_addr, sh.body_len,
-		                     NULL, 0) == IMAGE_INVALID) {
-			BL_WRN("invalid bin body\n");
-			return BL_LOAD_BIN_INVALID;
+		if (image_get_verified(id, &sh) == IMAGE_INVALID) {
+			if (image_check_data(&sh, (void *)sh.load_addr, sh.body_len,
+			                     NULL, 0) == IMAGE_INVALID) {
+				BL_WRN("invalid bin body\n");
+				return BL_LOAD_BIN_INVALID;
+			}
+			image_set_verified(id, &sh);
 		}
 #if BL_DBG_ON
 		tm = OS_GetTicks() - tm;
@@ -291,6 +187,12 @@ static uint32_t bl_load_bin(void)
 		BL_ERR("img init fail\n");
 		return BL_INVALID_APP_ENTRY;
 	}
+#if PRJCONF_IMG_VCACHE_SIZE
+	if (image_vcache_init(PRJCONF_IMG_VCACHE_FLASH, PRJCONF_IMG_VCACHE_ADDR,
+	                      PRJCONF_IMG_VCACHE_SIZE) != 0) {
+		BL_WRN("img vcache init fail\n");
+	}
+#endif
 
 	const image_ota_param_t *iop = image_get_ota_param();
 	if (iop->ota_addr == IMAGE_INVALID_ADDR) {
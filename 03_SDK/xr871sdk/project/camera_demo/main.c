@@ -53,6 +53,15 @@
 #include "driver/component/csi_camera/camera_csi.h"
 
 #include "driver/component/csi_camera/gc0308/drv_gc0308.h"
+#include "driver/component/csi_camera/cam_video.h"
+
+#include "mjpeg_server.h"
+
+/* 1: capture continuously into a frame pool and serve it over HTTP,
+ * 0: push still pictures to SERVER_IP */
+#define CAM_STREAM_MJPEG     0
+#define CAM_STREAM_PORT      80
+#define CAM_STREAM_BUFNUM    3
 
 
 
@@ -248,6 +257,44 @@ static void TaskWlanControl(void *arg)
 
 
 
+#if CAM_STREAM_MJPEG
+int main(void)
+{
+	Cam_VideoParam param;
+	Cam_VideoStats stats;
+
+	platform_init();
+
+	Cam_PowerInit();
+	Cam_Hardware_Reset();
+	HAL_CSI_Moudle_Enalbe(CSI_DISABLE);
+	if (Drv_GC0308_Init() == COMP_ERROR)
+		return COMP_ERROR;
+	OS_MSleep(500);
+
+	param.num = CAM_STREAM_BUFNUM;
+	param.size = IMAGE_BUFFSIZE;
+	param.jpeg = 0;
+	if (Drv_Cam_Video_Start(&param) != COMP_OK)
+		return COMP_ERROR;
+	if (mjpeg_server_start(CAM_STREAM_PORT, param.jpeg) < 0) {
+		COMPONENT_WARN("mjpeg server start error\n");
+		Drv_Cam_Video_Stop();
+		return COMP_ERROR;
+	}
+
+	while (1) {
+		OS_MSleep(10 * 1000);
+		Drv_Cam_Video_Stats(&stats, 1);
+		printf("cam: %u frames, %u sent, dropped %u no buf %u overflow %u stale,"
+		       " latency avg %u max %u us\n",
+		       stats.frames, stats.sent, stats.no_buf, stats.overflow, stats.stale,
+		       stats.sent ? stats.lat_sum_us / stats.sent : 0, stats.lat_max_us);
+	}
+
+	return COMP_OK;
+}
+#else
 int main(void)
 {
 	uint32_t image_size = 0;
@@ -288,7 +335,8 @@ int main(void)
 		image_size = Drv_GC0308_Capture_Componemt(10000);
 		//printf("[GC0308] image_size %u\n", image_size);
 		if(image_size == 320*240*2) {
-			if((i_wlanstatus == SERVER_CONNECTED_OK) && (i_socketFd != -1)){
+			if((i_wlanstatus == SERVER_CONNECTED_OK) && (i_socketFd != -1))
+{
 				count = 0;
 				len = 0;
 				pbuf = image_buff;
@@ -311,3 +359,4 @@ int main(void)
 
 	return COMP_OK;
 }
+#endif /* CAM_STREAM_MJPEG */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * HTTP server streaming the camera frames as multipart/x-mixed-replace,
+ * one client at a time. Each frame is sent from its pool buffer, lwIP
+ * copies it into its segments as the window allows and nothing else does.
+ * NOCOPY writes are not used, they would need the frame to be held until
+ * acknowledged and the sockets do not tell when that is.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <lwip/sockets.h>
+
+#include "kernel/os/os.h"
+#include "driver/component/csi_camera/cam_video.h"
+#include "mjpeg_server.h"
+
+#define MJPEG_THREAD_STACK_SIZE (2 * 1024)
+#define MJPEG_FRAME_TIMEOUT     (2 * 1000)
+#define MJPEG_BOUNDARY          "frame"
+
+static OS_Thread_t mjpeg_thread;
+static int mjpeg_listen_fd = -1;
+static uint8_t mjpeg_jpeg;
+static volatile uint8_t mjpeg_run;
+
+static const char mjpeg_http_header[] =
+	"HTTP/1.0 200 OK\r\n"
+	"Cache-Control: no-cache\r\n"
+	"Connection: close\r\n"
+	"Content-Type: multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY "\r\n"
+	"\r\n";
+
+static int mjpeg_send_all(int fd, const void *data, int len, int flags)
+{
+	const uint8_t *p = data;
+	int n;
+
+	while (len > 0) {
+		n = send(fd, p, len, flags);
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* the request itself does not matter, any path gets the stream */
+static int mjpeg_read_request(int fd)
+{
+	char buf[128];
+	int i, n, match = 0;
+
+	while (match < 4) {
+		n = recv(fd, buf, sizeof(buf), 0);
+		if (n <= 0)
+			return -1;
+		/* see how far we are into "\r\n\r\n" */
+		for (i = 0; i < n && match < 4; i++) {
+			if (buf[i] == ((match & 1) ? '\n' : '\r'))
+				match++;
+			else
+				match = (buf[i] == '\r');
+		}
+	}
+	return 0;
+}
+
+static void mjpeg_serve(int fd)
+{
+	char part[96];
+	Cam_Frame *f;
+	uint32_t seq = 0;
+	int len, ret;
+
+	if (mjpeg_read_request(fd) < 0 ||
+	    mjpeg_send_all(fd, mjpeg_http_header, sizeof(mjpeg_http_header) - 1, 0) < 0)
+		return;
+
+	while (mjpeg_run) {
+		f = Drv_Cam_Frame_Get(seq, MJPEG_FRAME_TIMEOUT);
+		if (f == NULL)
+			continue;
+		seq = f->seq;
+
+		len = snprintf(part, sizeof(part),
+		               "--" MJPEG_BOUNDARY "\r\n"
+		               "Content-Type: %s\r\n"
+		               "Content-Length: %u\r\n\r\n",
+		               mjpeg_jpeg ? "image/jpeg" : "application/octet-stream",
+		               (unsigned int)f->len);
+		ret = mjpeg_send_all(fd, part, len, MSG_MORE);
+		if (ret == 0)
+			ret = mjpeg_send_all(fd, f->buf, f->len, MSG_MORE);
+		if (ret == 0)
+			Drv_Cam_Frame_Sent(f);
+		Drv_Cam_Frame_Put(f);
+		if (ret < 0 || mjpeg_send_all(fd, "\r\n", 2, 0) < 0)
+			return;
+	}
+}
+
+static void mjpeg_server_task(void *arg)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	int fd;
+
+	while (mjpeg_run) {
+		addr_len = sizeof(addr);
+		fd = accept(mjpeg_listen_fd, (struct sockaddr *)&addr, &addr_len);
+		if (fd < 0) {
+			OS_MSleep(100);
+			continue;
+		}
+		printf("mjpeg: client %s\n", inet_ntoa(addr.sin_addr));
+		mjpeg_serve(fd);
+		closesocket(fd);
+	}
+
+	OS_ThreadDelete(&mjpeg_thread);
+}
+
+/**
+ * Serve the frames of the running capture on port. jpeg tells whether
+ * the frames are JPEG pictures, else they go out as opaque parts.
+ */
+int mjpeg_server_start(uint16_t port, int jpeg)
+{
+	struct sockaddr_in addr;
+
+	if (mjpeg_run)
+		return -1;
+
+	mjpeg_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (mjpeg_listen_fd < 0)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(mjpeg_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(mjpeg_listen_fd, 1) < 0)
+		goto err;
+
+	mjpeg_jpeg = !!jpeg;
+	mjpeg_run = 1;
+	if (OS_ThreadCreate(&mjpeg_thread, "mjpeg", mjpeg_server_task, NULL,
+	                    OS_THREAD_PRIO_APP, MJPEG_THREAD_STACK_SIZE) != OS_OK) {
+		mjpeg_run = 0;
+		goto err;
+	}
+	return 0;
+
+err:
+	closesocket(mjpeg_listen_fd);
+	mjpeg_listen_fd = -1;
+	return -1;
+}
+
+/**
+ * Stop serving. The client being served is dropped after its current
+ * frame, the socket closing wakes up the server waiting for one.
+ */
+void mjpeg_server_stop(void)
+{
+	if (!mjpeg_run)
+		return;
+
+	mjpeg_run = 0;
+	closesocket(mjpeg_listen_fd);
+	mjpeg_listen_fd = -1;
+	while (OS_ThreadIsValid(&mjpeg_thread))
+		OS_MSleep(10);
+}
@@ -38,6 +38,7 @@
 #include "common/cmd/cmd_thread.h"
 #include "common/cmd/cmd_upgrade.h"
 #include "common/cmd/cmd_sysinfo.h"
+#include "common/cmd/cmd_prof.h"
 
 #include "common/cmd/cmd_gpio.h"
 #include "common/cmd/cmd_clock.h"
@@ -83,6 +84,7 @@
 #include "common/cmd/cmd_etf.h"
 #include "common/cmd/cmd_broadcast.h"
 #include "common/cmd/cmd_arp.h"
+#include "common/cmd/cmd_sockbench.h"
 #endif /* PRJCONF_NET_EN */
 
 #endif /* _CMD_H_ */
@@ -103,7 +103,7 @@ void cap_exec(void *cmd)
 	int samplerate;
 	int channels;
 	char *argv[5];
-	FIL file;
+	struct fs_ctrl_file file;
 	char *file_path;
 	unsigned int pcm_buf_size;
 	char *pcm_data;
@@ -131,17 +131,17 @@ void cap_exec(void *cmd)
 		goto exit_thread;
 	}
 
-	f_unlink(file_path);
-	if (f_open(&file, file_path, FA_OPEN_ALWAYS|FA_READ|FA_WRITE) != FR_OK) {
+    pcm_buf_size = (config.channels)*2*(config.period_size);
+
+	if (fs_ctrl_open_record(&file, file_path, (FSIZE_t)pcm_buf_size * TEST_DELAY_TIME) != 0) {
 		CMD_ERR("open file fail\n");
 		goto exit_thread;
 	}
 
-    pcm_buf_size = (config.channels)*2*(config.period_size);
     pcm_data = malloc(pcm_buf_size);
     if (pcm_data == NULL) {
 		CMD_ERR("malloc buf failed\n");
-		f_close(&file);
+		fs_ctrl_close_record(&file);
 		goto exit_thread;
     }
     memset(pcm_data, 0, pcm_buf_size);
@@ -161,7 +161,7 @@ void cap_exec(void *cmd)
 				CMD_ERR("read data failed(%d), line:%d\n", ret, __LINE__);
 				break;
             }
-            if (f_write(&file, pcm_data, pcm_buf_size, &writenum) != FR_OK) {
+            if (f_write(&file.fil, pcm_data, pcm_buf_size, &writenum) != FR_OK) {
 				CMD_ERR("write failed.\n");
 				break;
             } else {
@@ -175,7 +175,7 @@ void cap_exec(void *cmd)
 
 exit:
 	free(pcm_data);
-	f_close(&file);
+	fs_ctrl_close_record(&file);
 	CMD_DBG("Capture end.\n");
 exit_thread:
 	AUDIO_DELETE_THREAD(g_audio_stream_thread);
@@ -188,7 +188,7 @@ void play_exec(void *cmd)
 	int samplerate;
 	int channels;
 	char *argv[5];
-	FIL file;
+	struct fs_ctrl_file file;
 	char *file_path;
 	unsigned int pcm_buf_size;
 	char *pcm_data;
@@ -215,7 +215,7 @@ void play_exec(void *cmd)
 		goto exit_thread;
 	}
 
-	if (f_open(&file, file_path, FA_OPEN_ALWAYS|FA_READ) != FR_OK) {
+	if (fs_ctrl_open_media(&file, file_path) != 0) {
 		CMD_ERR("open file fail\n");
 		goto exit_thread;
 	}
@@ -224,7 +224,7 @@ void play_exec(void *cmd)
     pcm_data = malloc(pcm_buf_size);
     if (pcm_data == NULL) {
 		CMD_ERR("malloc buf failed\n");
-		f_close(&file);
+		fs_ctrl_close_media(&file);
 		goto exit_thread;;
     }
     if (snd_pcm_open(&config, SOUND_PLAYCARD, PCM_OUT) != 0)
@@ -235,7 +235,7 @@ void play_exec(void *cmd)
 	CMD_DBG("Play on.\n");
 	g_audio_task_end = 0;
     while (1 && !g_audio_task_end) {
-		if (f_read(&file, pcm_data, pcm_buf_size, &readnum) != FR_OK) {
+		if (f_read(&file.fil, pcm_data, pcm_buf_size, &readnum) != FR_OK) {
 	        CMD_ERR("read failed.\n");
 			break;
 	    }
@@ -251,7 +251,7 @@ void play_exec(void *cmd)
     snd_pcm_close(SOUND_PLAYCARD, PCM_OUT);
 
 exit:
-	f_close(&file);
+	fs_ctrl_close_media(&file);
 	free(pcm_data);
 	CMD_DBG("Play end.\n");
 exit_thread:
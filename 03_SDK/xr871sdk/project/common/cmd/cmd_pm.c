@@ -181,6 +181,15 @@ static enum cmd_status cmd_pm_wakeupread_exec(char *cmd)
 	return CMD_STATUS_OK;
 }
 
+/* pm stats
+ */
+static enum cmd_status cmd_pm_stats_exec(char *cmd)
+{
+	pm_stats_show();
+
+	return CMD_STATUS_OK;
+}
+
 static enum cmd_status cmd_pm_sleep_exec(char *cmd)
 {
 	pm_enter_mode(PM_MODE_SLEEP);
@@ -226,6 +235,7 @@ static const struct cmd_data g_pm_cmds[] = {
 	{ "wk_io",       cmd_pm_wakeupio_exec },
 	{ "wk_event",    cmd_pm_wakeupevent_exec },
 	{ "wk_read",     cmd_pm_wakeupread_exec },
+	{ "stats",       cmd_pm_stats_exec },
 	{ "sleep",       cmd_pm_sleep_exec },
 	{ "standby",     cmd_pm_standby_exec },
 	{ "hibernation", cmd_pm_hibernation_exec },
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cmd_util.h"
+#include "cmd_prof.h"
+#include "common/framework/xip_prof.h"
+
+#define CMD_PROF_DEFAULT_HZ         1000
+#define CMD_PROF_DEFAULT_SAMPLES    4096
+
+/*
+ * prof start [h=<hz>] [n=<max-samples>]
+ */
+static enum cmd_status cmd_prof_start_exec(char *cmd)
+{
+	uint32_t hz = CMD_PROF_DEFAULT_HZ;
+	uint32_t num = CMD_PROF_DEFAULT_SAMPLES;
+	char *arg;
+
+	if ((arg = cmd_strstr(cmd, "h=")) != NULL) {
+		if (cmd_sscanf(arg, "h=%u", &hz) != 1 || hz == 0) {
+			return CMD_STATUS_INVALID_ARG;
+		}
+	}
+	if ((arg = cmd_strstr(cmd, "n=")) != NULL) {
+		if (cmd_sscanf(arg, "n=%u", &num) != 1 || num == 0) {
+			return CMD_STATUS_INVALID_ARG;
+		}
+	}
+
+	if (xip_prof_start(hz, num) != 0) {
+		return CMD_STATUS_FAIL;
+	}
+	return CMD_STATUS_OK;
+}
+
+/*
+ * prof stop
+ */
+static enum cmd_status cmd_prof_stop_exec(char *cmd)
+{
+	xip_prof_stop();
+	return CMD_STATUS_OK;
+}
+
+/*
+ * prof stat
+ */
+static enum cmd_status cmd_prof_stat_exec(char *cmd)
+{
+	struct xip_prof_stat st;
+
+	xip_prof_get_stat(&st);
+	cmd_write_respond(CMD_STATUS_OK, "total %u, xip %u, sram %u, other %u, "
+	                  "dropped %u", st.total, st.xip, st.sram, st.other,
+	                  st.dropped);
+	return CMD_STATUS_ACKED;
+}
+
+/*
+ * prof dump, the output is the sample file of tools/xip_place.py
+ */
+static enum cmd_status cmd_prof_dump_exec(char *cmd)
+{
+	xip_prof_dump();
+	return CMD_STATUS_OK;
+}
+
+/*
+ * prof free
+ */
+static enum cmd_status cmd_prof_free_exec(char *cmd)
+{
+	xip_prof_deinit();
+	return CMD_STATUS_OK;
+}
+
+static const struct cmd_data g_prof_cmds[] = {
+	{ "start",	cmd_prof_start_exec },
+	{ "stop",	cmd_prof_stop_exec },
+	{ "stat",	cmd_prof_stat_exec },
+	{ "dump",	cmd_prof_dump_exec },
+	{ "free",	cmd_prof_free_exec },
+};
+
+enum cmd_status cmd_prof_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_prof_cmds, cmd_nitems(g_prof_cmds));
+}
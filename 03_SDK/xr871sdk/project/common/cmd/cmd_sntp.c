@@ -34,7 +34,7 @@
 #include "net/sntp/sntp.h"
 
 static OS_Thread_t g_sntp_thread;
-#define SNTP_THREAD_STACK_SIZE		(1 * 1024)
+#define SNTP_THREAD_STACK_SIZE		(2 * 1024)
 #define SNTP_THREAD_EXIT OS_ThreadDelete
 
 void sntp_run(void *arg)
@@ -46,7 +46,11 @@ void sntp_run(void *arg)
 	}
 
 	sntp_time *time = (sntp_time *)sntp_obtain_time();
+	sntp_status status;
 	CMD_LOG(1, "<net> <sntp> <response : success>\n");
+	sntp_get_status(&status);
+	CMD_LOG(1, "sntp offset %d us, delay %d us, jitter %d us, freq %d ppb, %u servers\n",
+	        status.offset, status.delay, status.jitter, status.freq, status.servers);
 	CMD_LOG(1,"sntp(%u  %u  %u ",time->week, time->mon, time->day);
         CMD_LOG(1,"%u:%u:%u %u)\n", time->hour, time->min, time->sec, time->year);
 exit:
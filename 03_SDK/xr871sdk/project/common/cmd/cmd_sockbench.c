@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if PRJCONF_NET_EN
+
+#include "cmd_util.h"
+#include "cmd_sockbench.h"
+#include "lwip/sockets.h"
+#include "lwip/inet.h"
+#include "lwip/netifapi.h"
+#include "lwip/tcpip.h"
+
+#define SOCKBENCH_PORT          5099
+#define SOCKBENCH_DEFAULT_NUM   1000
+#define SOCKBENCH_DEFAULT_LEN   32
+#define SOCKBENCH_MAX_LEN       1024
+#define SOCKBENCH_RCV_TIMEOUT   1000 /* ms */
+
+/* sink interface on a documentation subnet (RFC 5737), drops every packet */
+#define SOCKBENCH_SINK_ADDR     "192.0.2.1"
+#define SOCKBENCH_SINK_MASK     "255.255.255.0"
+#define SOCKBENCH_SINK_DEST     "192.0.2.2"
+
+#ifdef __CONFIG_LWIP_V1
+typedef ip_addr_t sockbench_ip4_t;
+#define SOCKBENCH_OUTPUT_ADDR_T ip_addr_t
+#define sockbench_aton(cp, addr) ipaddr_aton(cp, addr)
+#define sockbench_set_zero(addr) ip_addr_set_zero(addr)
+#else
+typedef ip4_addr_t sockbench_ip4_t;
+#define SOCKBENCH_OUTPUT_ADDR_T const ip4_addr_t
+#define sockbench_aton(cp, addr) ip4addr_aton(cp, addr)
+#define sockbench_set_zero(addr) ip4_addr_set_zero(addr)
+#endif
+
+static struct netif sockbench_sink_netif;
+
+static err_t sockbench_sink_output(struct netif *netif, struct pbuf *p,
+                                   SOCKBENCH_OUTPUT_ADDR_T *ipaddr)
+{
+	return ERR_OK;
+}
+
+static err_t sockbench_sink_init(struct netif *netif)
+{
+	netif->name[0] = 's';
+	netif->name[1] = 'k';
+	netif->output = sockbench_sink_output;
+	netif->mtu = 1500;
+	return ERR_OK;
+}
+
+static int sockbench_sink_add(void)
+{
+	sockbench_ip4_t ipaddr, netmask, gw;
+
+	sockbench_aton(SOCKBENCH_SINK_ADDR, &ipaddr);
+	sockbench_aton(SOCKBENCH_SINK_MASK, &netmask);
+	sockbench_set_zero(&gw);
+	if (netifapi_netif_add(&sockbench_sink_netif, &ipaddr, &netmask, &gw,
+	                       NULL, sockbench_sink_init, tcpip_input) != ERR_OK) {
+		return -1;
+	}
+	netifapi_netif_set_up(&sockbench_sink_netif);
+	netifapi_netif_set_link_up(&sockbench_sink_netif);
+	return 0;
+}
+
+static void sockbench_sink_remove(void)
+{
+	netifapi_netif_remove(&sockbench_sink_netif);
+}
+
+/*
+ * First send UDP datagrams to the sink interface. Each send is one socket API
+ * call plus the UDP/IP output path and nothing else, so the result shows the
+ * cost of an API call, ie. the message passing to the tcpip thread, or the
+ * core lock if LWIP_TCPIP_CORE_LOCKING is enabled.
+ * Then send datagrams to ourself over the loopback interface and receive them
+ * back, one at a time, as a secondary figure for the round trip latency.
+ */
+static int sockbench_run(uint32_t num, uint32_t len)
+{
+	struct sockaddr_in addr, sink;
+	int rfd = -1, sfd = -1;
+	int timeout = SOCKBENCH_RCV_TIMEOUT;
+	uint8_t *buf;
+	uint32_t i, start, send_ms, ms;
+	int ret = -1;
+
+	buf = cmd_malloc(len);
+	if (buf == NULL) {
+		CMD_ERR("no mem\n");
+		return -1;
+	}
+	cmd_memset(buf, 0x5a, len);
+
+	cmd_memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SOCKBENCH_PORT);
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	cmd_memset(&sink, 0, sizeof(sink));
+	sink.sin_family = AF_INET;
+	sink.sin_port = htons(SOCKBENCH_PORT);
+	sink.sin_addr.s_addr = inet_addr(SOCKBENCH_SINK_DEST);
+
+	if (sockbench_sink_add() != 0) {
+		CMD_ERR("add sink netif failed\n");
+		cmd_free(buf);
+		return -1;
+	}
+
+	rfd = socket(AF_INET, SOCK_DGRAM, 0);
+	sfd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (rfd < 0 || sfd < 0) {
+		CMD_ERR("socket failed\n");
+		goto out;
+	}
+	setsockopt(rfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (bind(rfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		CMD_ERR("bind failed\n");
+		goto out;
+	}
+
+	start = OS_GetTicks();
+	for (i = 0; i < num; ++i) {
+		if (sendto(sfd, buf, len, 0, (struct sockaddr *)&sink,
+		           sizeof(sink)) != (int)len) {
+			CMD_ERR("sendto sink failed at %u\n", i);
+			goto out;
+		}
+	}
+	send_ms = OS_TicksToMSecs(OS_GetTicks() - start);
+	if (send_ms == 0)
+		send_ms = 1;
+
+	start = OS_GetTicks();
+	for (i = 0; i < num; ++i) {
+		if (sendto(sfd, buf, len, 0, (struct sockaddr *)&addr,
+		           sizeof(addr)) != (int)len) {
+			CMD_ERR("sendto failed at %u\n", i);
+			goto out;
+		}
+		if (recv(rfd, buf, len, 0) != (int)len) {
+			CMD_ERR("recv failed at %u\n", i);
+			goto out;
+		}
+	}
+	ms = OS_TicksToMSecs(OS_GetTicks() - start);
+	if (ms == 0)
+		ms = 1;
+
+	cmd_write_respond(CMD_STATUS_OK, "%u x %u bytes, "
+	                  "send %u ms, %u send calls/s, round trip %u ms, "
+	                  "%u us/round trip",
+	                  num, len, send_ms, (uint32_t)(1000ULL * num / send_ms),
+	                  ms, (uint32_t)(1000ULL * ms / num));
+	ret = 0;
+
+out:
+	if (sfd >= 0)
+		closesocket(sfd);
+	if (rfd >= 0)
+		closesocket(rfd);
+	sockbench_sink_remove();
+	cmd_free(buf);
+	return ret;
+}
+
+/*
+ * net sockbench [n=<num>] [l=<len>]
+ */
+enum cmd_status cmd_sockbench_exec(char *cmd)
+{
+	uint32_t num = SOCKBENCH_DEFAULT_NUM;
+	uint32_t len = SOCKBENCH_DEFAULT_LEN;
+	char *arg;
+
+	if ((arg = cmd_strstr(cmd, "n=")) != NULL) {
+		if (cmd_sscanf(arg, "n=%u", &num) != 1 || num == 0) {
+			return CMD_STATUS_INVALID_ARG;
+		}
+	}
+	if ((arg = cmd_strstr(cmd, "l=")) != NULL) {
+		if (cmd_sscanf(arg, "l=%u", &len) != 1 || len == 0 ||
+		    len > SOCKBENCH_MAX_LEN) {
+			return CMD_STATUS_INVALID_ARG;
+		}
+	}
+
+	if (sockbench_run(num, len) != 0) {
+		return CMD_STATUS_FAIL;
+	}
+	return CMD_STATUS_ACKED;
+}
+
+#endif /* PRJCONF_NET_EN */
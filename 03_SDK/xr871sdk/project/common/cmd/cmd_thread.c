@@ -28,6 +28,8 @@
  */
 
 #include "cmd_util.h"
+#include "kernel/os/os_rtstat.h"
+#include "kernel/os/os_stackmon.h"
 
 #if (configUSE_TRACE_FACILITY == 1)
 enum cmd_status cmd_thread_list_exec(char *cmd)
@@ -37,10 +39,112 @@ enum cmd_status cmd_thread_list_exec(char *cmd)
 }
 #endif
 
+#if (configDEBUG_RTSTAT_EN == 1)
+/*
+ * thread stat start
+ */
+static enum cmd_status cmd_thread_stat_start_exec(char *cmd)
+{
+	return OS_RtStatStart() == OS_OK ? CMD_STATUS_OK : CMD_STATUS_FAIL;
+}
+
+/*
+ * thread stat stop
+ */
+static enum cmd_status cmd_thread_stat_stop_exec(char *cmd)
+{
+	OS_RtStatStop();
+	return CMD_STATUS_OK;
+}
+
+/*
+ * thread stat reset
+ */
+static enum cmd_status cmd_thread_stat_reset_exec(char *cmd)
+{
+	OS_RtStatReset();
+	return CMD_STATUS_OK;
+}
+
+/*
+ * thread stat show
+ */
+static enum cmd_status cmd_thread_stat_show_exec(char *cmd)
+{
+	OS_RtStatShow();
+	return CMD_STATUS_ACKED;
+}
+
+static const struct cmd_data g_thread_stat_cmds[] = {
+	{ "start",	cmd_thread_stat_start_exec },
+	{ "stop",	cmd_thread_stat_stop_exec },
+	{ "reset",	cmd_thread_stat_reset_exec },
+	{ "show",	cmd_thread_stat_show_exec },
+};
+
+enum cmd_status cmd_thread_stat_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_thread_stat_cmds, cmd_nitems(g_thread_stat_cmds));
+}
+#endif
+
+#if (configDEBUG_STACKMON_EN == 1)
+/*
+ * thread stack start [p=<period_ms>] [w=<warn_percent>]
+ */
+static enum cmd_status cmd_thread_stack_start_exec(char *cmd)
+{
+	uint32_t period = 1000, warn = 10;
+
+	cmd_sscanf(cmd, "p=%u w=%u", &period, &warn);
+	if (period == 0 || warn > 100) {
+		CMD_ERR("invalid param %u %u\n", period, warn);
+		return CMD_STATUS_INVALID_ARG;
+	}
+	return OS_StackMonStart(period, warn) == OS_OK ? CMD_STATUS_OK : CMD_STATUS_FAIL;
+}
+
+/*
+ * thread stack stop
+ */
+static enum cmd_status cmd_thread_stack_stop_exec(char *cmd)
+{
+	OS_StackMonStop();
+	return CMD_STATUS_OK;
+}
+
+/*
+ * thread stack show
+ */
+static enum cmd_status cmd_thread_stack_show_exec(char *cmd)
+{
+	OS_StackMonSample();
+	OS_StackMonShow();
+	return CMD_STATUS_ACKED;
+}
+
+static const struct cmd_data g_thread_stack_cmds[] = {
+	{ "start",	cmd_thread_stack_start_exec },
+	{ "stop",	cmd_thread_stack_stop_exec },
+	{ "show",	cmd_thread_stack_show_exec },
+};
+
+enum cmd_status cmd_thread_stack_exec(char *cmd)
+{
+	return cmd_exec(cmd, g_thread_stack_cmds, cmd_nitems(g_thread_stack_cmds));
+}
+#endif
+
 static const struct cmd_data g_thread_cmds[] = {
 #if (configUSE_TRACE_FACILITY == 1)
 	{ "list",	cmd_thread_list_exec },
 #endif
+#if (configDEBUG_RTSTAT_EN == 1)
+	{ "stat",	cmd_thread_stat_exec },
+#endif
+#if (configDEBUG_STACKMON_EN == 1)
+	{ "stack",	cmd_thread_stack_exec },
+#endif
 };
 
 enum cmd_status cmd_thread_exec(char *cmd)
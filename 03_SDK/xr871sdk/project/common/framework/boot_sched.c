@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "kernel/os/os.h"
+#include "boot_sched.h"
+#include "fwk_debug.h"
+
+#define BOOT_WORKER_MAX     4
+
+struct boot_sched {
+	const struct boot_step *steps;
+	struct boot_step_time *timeline;
+	uint32_t num;
+	uint32_t all;           /* mask of all steps */
+	uint32_t started;       /* mask of steps started or skipped */
+	uint32_t done;          /* mask of steps done or skipped */
+	uint32_t busy_res;      /* resources used by the running steps */
+	uint32_t running;       /* number of running steps */
+	uint32_t waiting;       /* number of workers waiting for a ready step */
+	OS_Mutex_t lock;
+	OS_Semaphore_t wakeup;  /* released for each waiting worker on a change */
+	OS_Semaphore_t exit;    /* released by each helper worker on exit */
+};
+
+struct boot_worker {
+	struct boot_sched *sched;
+	OS_Thread_t thread;
+	uint8_t id;
+};
+
+static uint32_t boot_now(void)
+{
+	return OS_TicksToMSecs(OS_GetTicks());
+}
+
+/* wake up the waiting workers, with the lock held */
+static void boot_sched_wakeup(struct boot_sched *s)
+{
+	while (s->waiting) {
+		s->waiting--;
+		OS_SemaphoreRelease(&s->wakeup);
+	}
+}
+
+/*
+ * Pick a step ready to run, with the lock held.
+ * Return the step index, -1 if no step is ready yet, -2 if no step is left.
+ */
+static int boot_sched_pick(struct boot_sched *s)
+{
+	const struct boot_step *step;
+	uint32_t i, bit, now;
+
+	if (s->started == s->all)
+		return -2;
+
+	for (i = 0; i < s->num; i++) {
+		bit = 1U << i;
+		step = &s->steps[i];
+		if ((s->started & bit) ||
+		    (step->deps & ~s->done) ||
+		    (step->res & s->busy_res))
+			continue;
+		if (step->func == NULL) {
+			/* disabled step, done at once */
+			s->started |= bit;
+			s->done |= bit;
+			s->timeline[i].start = s->timeline[i].end = boot_now();
+			s->timeline[i].worker = BOOT_STEP_SKIPPED;
+			i = (uint32_t)-1; /* rescan, its dependents may be ready now */
+			continue;
+		}
+		return i;
+	}
+
+	if (s->started == s->all)
+		return -2;
+
+	if (s->running == 0) {
+		/* nothing can ever be ready, the left steps depend on a cycle */
+		now = boot_now();
+		for (i = 0; i < s->num; i++) {
+			bit = 1U << i;
+			if (s->started & bit)
+				continue;
+			FWK_ERR("boot step %s blocked, deps 0x%x\n",
+			        s->steps[i].name, s->steps[i].deps & ~s->done);
+			s->timeline[i].start = s->timeline[i].end = now;
+			s->timeline[i].worker = BOOT_STEP_SKIPPED;
+		}
+		s->started = s->all;
+		s->done = s->all;
+		return -2;
+	}
+	return -1;
+}
+
+static void boot_sched_work(struct boot_sched *s, uint8_t worker)
+{
+	const struct boot_step *step;
+	struct boot_step_time *t;
+	int i;
+
+	OS_MutexLock(&s->lock, OS_WAIT_FOREVER);
+	while (1) {
+		i = boot_sched_pick(s);
+		if (i == -2)
+			break;
+		if (i == -1) {
+			s->waiting++;
+			OS_MutexUnlock(&s->lock);
+			OS_SemaphoreWait(&s->wakeup, OS_WAIT_FOREVER);
+			OS_MutexLock(&s->lock, OS_WAIT_FOREVER);
+			continue;
+		}
+
+		step = &s->steps[i];
+		t = &s->timeline[i];
+		s->started |= 1U << i;
+		s->busy_res |= step->res;
+		s->running++;
+		t->worker = worker;
+		t->start = boot_now();
+		OS_MutexUnlock(&s->lock);
+
+		step->func();
+
+		OS_MutexLock(&s->lock, OS_WAIT_FOREVER);
+		t->end = boot_now();
+		s->done |= 1U << i;
+		s->busy_res &= ~step->res;
+		s->running--;
+		boot_sched_wakeup(s);
+	}
+	boot_sched_wakeup(s); /* let the waiting workers see the end */
+	OS_MutexUnlock(&s->lock);
+}
+
+static void boot_worker_task(void *arg)
+{
+	struct boot_worker *w = arg;
+	struct boot_sched *s = w->sched;
+
+	boot_sched_work(s, w->id);
+	OS_SemaphoreRelease(&s->exit);
+	OS_ThreadDelete(NULL);
+}
+
+/*
+ * @brief Run the init steps, overlapping the independent ones
+ * @param[in] steps Table of the steps, at most BOOT_STEP_MAX
+ * @param[in] num Number of the steps
+ * @param[out] timeline Timeline of each step, @num items
+ * @param[in] workers Number of threads running steps, including the caller
+ * @param[in] prio Priority of the helper threads
+ * @param[in] stack_size Stack size of the helper threads
+ * @return 0 on success, -1 if any step is skipped for a dependency cycle
+ * @note The caller is worker 0 and runs steps too. The steps are still all
+ *       run by the caller if the helper threads can't be created.
+ */
+int boot_sched_run(const struct boot_step *steps, uint32_t num,
+                   struct boot_step_time *timeline,
+                   uint32_t workers, OS_Priority prio, uint32_t stack_size)
+{
+	struct boot_sched sched;
+	struct boot_sched *s = &sched;
+	struct boot_worker *w = NULL;
+	uint32_t i, helpers = 0;
+	int ret = 0;
+
+	if (num == 0 || num > BOOT_STEP_MAX)
+		return -1;
+	if (workers == 0)
+		workers = 1;
+	else if (workers > BOOT_WORKER_MAX)
+		workers = BOOT_WORKER_MAX;
+
+	memset(s, 0, sizeof(*s));
+	s->steps = steps;
+	s->timeline = timeline;
+	s->num = num;
+	s->all = (num == 32) ? 0xFFFFFFFFU : ((1U << num) - 1);
+	memset(timeline, 0, num * sizeof(struct boot_step_time));
+
+	OS_MutexSetInvalid(&s->lock);
+	OS_SemaphoreSetInvalid(&s->wakeup);
+	OS_SemaphoreSetInvalid(&s->exit);
+	if (OS_MutexCreate(&s->lock) != OS_OK ||
+	    OS_SemaphoreCreate(&s->wakeup, 0, BOOT_WORKER_MAX) != OS_OK ||
+	    OS_SemaphoreCreate(&s->exit, 0, BOOT_WORKER_MAX) != OS_OK) {
+		FWK_ERR("boot sched init failed\n");
+		workers = 1;
+	}
+
+	if (workers > 1)
+		w = malloc((workers - 1) * sizeof(struct boot_worker));
+	for (i = 0; w != NULL && i < workers - 1; i++) {
+		w[i].sched = s;
+		w[i].id = i + 1;
+		OS_ThreadSetInvalid(&w[i].thread);
+		if (OS_ThreadCreate(&w[i].thread, "boot", boot_worker_task, &w[i],
+		                    prio, stack_size) != OS_OK) {
+			FWK_WRN("boot worker %u create failed\n", i + 1);
+			break;
+		}
+		helpers++;
+	}
+
+	if (OS_MutexIsValid(&s->lock)) {
+		boot_sched_work(s, 0);
+		for (i = 0; i < helpers; i++)
+			OS_SemaphoreWait(&s->exit, OS_WAIT_FOREVER);
+		for (i = 0; i < num; i++) {
+			if (steps[i].func && timeline[i].worker == BOOT_STEP_SKIPPED)
+				ret = -1;
+		}
+	} else {
+		/* no scheduler, run the steps in the table order */
+		for (i = 0; i < num; i++) {
+			timeline[i].worker = steps[i].func ? 0 : BOOT_STEP_SKIPPED;
+			timeline[i].start = boot_now();
+			if (steps[i].func)
+				steps[i].func();
+			timeline[i].end = boot_now();
+		}
+	}
+
+	free(w);
+	if (OS_SemaphoreIsValid(&s->exit))
+		OS_SemaphoreDelete(&s->exit);
+	if (OS_SemaphoreIsValid(&s->wakeup))
+		OS_SemaphoreDelete(&s->wakeup);
+	if (OS_MutexIsValid(&s->lock))
+		OS_MutexDelete(&s->lock);
+	return ret;
+}
+
+/*
+ * @brief Print the timeline of the init steps
+ */
+void boot_sched_dump(const struct boot_step *steps, uint32_t num,
+                     const struct boot_step_time *timeline)
+{
+	uint32_t i;
+
+	FWK_LOG(1, "boot timeline (ms):\n");
+	FWK_LOG(1, "%-12s %6s %6s %6s %s\n", "step", "start", "end", "cost", "worker");
+	for (i = 0; i < num; i++) {
+		if (timeline[i].worker == BOOT_STEP_SKIPPED) {
+			if (steps[i].func != NULL)
+				FWK_LOG(1, "%-12s skipped\n", steps[i].name);
+			continue;
+		}
+		FWK_LOG(1, "%-12s %6u %6u %6u %u\n", steps[i].name,
+		        timeline[i].start, timeline[i].end,
+		        timeline[i].end - timeline[i].start, timeline[i].worker);
+	}
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BOOT_SCHED_H_
+#define _BOOT_SCHED_H_
+
+#include <stdint.h>
+#include "kernel/os/os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_STEP_MAX       32
+
+/* dependency on step @id, used to build boot_step.deps */
+#define BOOT_DEP(id)        (1U << (id))
+
+/* the step is not run, eg. disabled or blocked by a dependency cycle */
+#define BOOT_STEP_SKIPPED   0xFF
+
+/*
+ * An init step. A step is started when all steps in @deps are done, and no
+ * running step uses any of the resources in @res. The index of a step in its
+ * table is its ID. A step without @func is done immediately.
+ */
+struct boot_step {
+	const char *name;
+	void (*func)(void);
+	uint32_t deps;      /* BOOT_DEP() of the steps to be done before */
+	uint32_t res;       /* resources (eg. pin mux) used exclusively */
+};
+
+/* timeline of a step, in milliseconds since boot */
+struct boot_step_time {
+	uint32_t start;
+	uint32_t end;
+	uint8_t worker;     /* index of the worker running the step */
+};
+
+int boot_sched_run(const struct boot_step *steps, uint32_t num,
+                   struct boot_step_time *timeline,
+                   uint32_t workers, OS_Priority prio, uint32_t stack_size);
+void boot_sched_dump(const struct boot_step *steps, uint32_t num,
+                     const struct boot_step_time *timeline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BOOT_SCHED_H_ */
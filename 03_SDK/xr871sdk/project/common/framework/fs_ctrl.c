@@ -31,6 +31,7 @@
 #include "driver/chip/sdmmc/hal_sdhost.h"
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
 #include "driver/chip/sdmmc/sdmmc.h"
 
 #define FS_DBG_ON	0
@@ -64,6 +65,12 @@ static fs_ctrl_private fs_ctrl;
 #define FS_CTRL_LOCK()   OS_RecursiveMutexLock(&fs_ctrl.mutex, OS_WAIT_FOREVER)
 #define FS_CTRL_UNLOCK() OS_RecursiveMutexUnlock(&fs_ctrl.mutex)
 
+/* initial size (in DWORDs) of the cluster link map table of a media file,
+ * enough for 15 fragments, enlarged when the file is more fragmented */
+#define FS_CLMT_INIT_SIZE	32
+/* don't build the link map table for a file fragmented more than this */
+#define FS_CLMT_MAX_SIZE	1024
+
 /*
  * @brief Init the device and mount the file system
  * @param[in] dev_type Device type
@@ -164,6 +171,11 @@ int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 		fs_ctrl.fs = NULL;
 	}
 
+	/* flush the disk cache and release the card held by the disk driver */
+	if (disk_ioctl(0, CTRL_EJECT, NULL) != RES_OK) {
+		FS_ERR("disk eject fail\n");
+	}
+
 	struct mmc_card *card = mmc_card_open(dev_id);
 	if (card == NULL) {
 		FS_ERR("card open fail\n");
@@ -190,6 +202,123 @@ out:
 	return ret;
 }
 
+/*
+ * @brief Open a file for playback, with fast seek enabled if possible
+ * @param[in] file Pointer to the file object
+ * @param[in] path Path of the file
+ * @return 0 on success, -1 on failure
+ * @note The cluster link map table of the file is built on open, so that
+ *       f_lseek() on the file does not follow the FAT chain. The file is
+ *       still usable without fast seek if the table can't be built.
+ */
+int fs_ctrl_open_media(struct fs_ctrl_file *file, const char *path)
+{
+	FRESULT res;
+	DWORD size = FS_CLMT_INIT_SIZE;
+
+	file->clmt = NULL;
+	res = f_open(&file->fil, path, FA_OPEN_EXISTING | FA_READ);
+	if (res != FR_OK) {
+		FS_ERR("open %s fail, err %d\n", path, res);
+		return -1;
+	}
+
+	while (size <= FS_CLMT_MAX_SIZE) {
+		file->clmt = malloc(size * sizeof(DWORD));
+		if (file->clmt == NULL) {
+			break;
+		}
+		file->clmt[0] = size;
+		if (f_setclmt(&file->fil, file->clmt) != FR_OK) {
+			free(file->clmt);
+			file->clmt = NULL;
+			break;
+		}
+		res = f_lseek(&file->fil, CREATE_LINKMAP);
+		if (res == FR_OK) {
+			FS_DBG("%s: %u fragments\n", path, (file->clmt[0] - 2) / 2);
+			return 0;
+		}
+		size = file->clmt[0]; /* required size */
+		f_setclmt(&file->fil, NULL);
+		free(file->clmt);
+		file->clmt = NULL;
+		if (res != FR_NOT_ENOUGH_CORE) {
+			break;
+		}
+	}
+
+	FS_WRN("%s: fast seek off\n", path);
+	return 0;
+}
+
+/*
+ * @brief Close a file opened by fs_ctrl_open_media()
+ * @param[in] file Pointer to the file object
+ * @return 0 on success, -1 on failure
+ */
+int fs_ctrl_close_media(struct fs_ctrl_file *file)
+{
+	FRESULT res = f_close(&file->fil);
+
+	if (file->clmt) {
+		free(file->clmt);
+		file->clmt = NULL;
+	}
+	return (res == FR_OK ? 0 : -1);
+}
+
+/*
+ * @brief Create a file for recording, with its clusters preallocated
+ * @param[in] file Pointer to the file object
+ * @param[in] path Path of the file, an existing file is overwritten
+ * @param[in] prealloc Size in bytes to be preallocated, 0 for no preallocation
+ * @return 0 on success, -1 on failure
+ * @note A contiguous area of @prealloc bytes is allocated on creating, so that
+ *       writing the file does not update the FAT, and writes of whole sectors
+ *       are passed to the disk as multi-sector transfers. If there is no such
+ *       area, the file grows as usual. The file must be closed by
+ *       fs_ctrl_close_record() to be truncated at its file pointer.
+ */
+int fs_ctrl_open_record(struct fs_ctrl_file *file, const char *path, FSIZE_t prealloc)
+{
+	FRESULT res;
+
+	file->clmt = NULL;
+	res = f_open(&file->fil, path, FA_CREATE_ALWAYS | FA_WRITE | FA_READ);
+	if (res != FR_OK) {
+		FS_ERR("open %s fail, err %d\n", path, res);
+		return -1;
+	}
+
+	if (prealloc) {
+		res = f_expand(&file->fil, prealloc, 1);
+		if (res != FR_OK) {
+			FS_WRN("%s: prealloc %u fail, err %d\n", path, (uint32_t)prealloc, res);
+		}
+	}
+	return 0;
+}
+
+/*
+ * @brief Close a file opened by fs_ctrl_open_record()
+ * @param[in] file Pointer to the file object
+ * @return 0 on success, -1 on failure
+ * @note The preallocated area beyond the file pointer is released.
+ */
+int fs_ctrl_close_record(struct fs_ctrl_file *file)
+{
+	FRESULT res = f_truncate(&file->fil);
+
+	if (res != FR_OK) {
+		FS_ERR("truncate fail, err %d\n", res);
+	}
+	if (f_close(&file->fil) != FR_OK) {
+		res = FR_DISK_ERR;
+	}
+	return (res == FR_OK ? 0 : -1);
+}
+
 static void fs_ctrl_msg_process(uint32_t event, uint32_t data, void *arg)
 {
 	switch (EVENT_SUBTYPE(event)) {
@@ -31,6 +31,7 @@
 #define _FS_CTRL_H_
 
 #include "common/framework/sys_ctrl/sys_ctrl.h"
+#include "fs/fatfs/ff.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,6 +76,17 @@ int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id);
 
 void sdcard_detect_callback(uint32_t present);
 
+/* File opened by fs_ctrl_open_media() or fs_ctrl_open_record() */
+struct fs_ctrl_file {
+	FIL fil;
+	DWORD *clmt;	/* cluster link map table for fast seek, NULL if not used */
+};
+
+int fs_ctrl_open_media(struct fs_ctrl_file *file, const char *path);
+int fs_ctrl_close_media(struct fs_ctrl_file *file);
+int fs_ctrl_open_record(struct fs_ctrl_file *file, const char *path, FSIZE_t prealloc);
+int fs_ctrl_close_record(struct fs_ctrl_file *file);
+
 #if 1 /* Obsoleted, for compatibility only  */
 enum fs_mnt_mode {
 	FS_MNT_MODE_MOUNT,
@@ -335,6 +335,8 @@ struct netif *net_open(enum wlan_mode mode)
 		return NULL;
 	}
 
+	/* the netif is already known by the tcpip thread, don't race with it */
+	LOCK_TCPIP_CORE();
 #if LWIP_NETIF_LINK_CALLBACK
 	netif_set_link_callback(nif, netif_link_callback);
 #endif
@@ -357,6 +359,10 @@ struct netif *net_open(enum wlan_mode mode)
 #endif
 	}
 #endif /* LWIP_IPV6 */
+#endif /* __CONFIG_LWIP_V1 */
+	UNLOCK_TCPIP_CORE();
+
+#ifndef __CONFIG_LWIP_V1
 	/* set netif up, but no valid ip address, required by lwip-2.x.x */
 	netifapi_netif_set_up(nif);
 #endif /* __CONFIG_LWIP_V1 */
@@ -41,6 +41,7 @@
 #include "fs_ctrl.h"
 #include "sys_ctrl/sys_ctrl.h"
 #include "fwk_debug.h"
+#include "boot_sched.h"
 
 #if (PRJCONF_SOUNDCARD0_EN || PRJCONF_SOUNDCARD1_EN)
 #include "audio/manager/audio_manager.h"
@@ -277,51 +278,124 @@ __weak void platform_init_level0(void)
 {
 	HAL_Flash_Init(PRJCONF_IMG_FLASH);
 	image_init(PRJCONF_IMG_FLASH, PRJCONF_IMG_ADDR, PRJCONF_IMG_MAX_SIZE);
+#if PRJCONF_IMG_VCACHE_SIZE
+	image_vcache_init(PRJCONF_IMG_VCACHE_FLASH, PRJCONF_IMG_VCACHE_ADDR,
+	                  PRJCONF_IMG_VCACHE_SIZE);
+#endif
 #if (defined(__PRJ_CONFIG_XIP))
 	platform_xip_init();
 #endif
 }
 
-/* init standard platform hardware and services */
-__weak void platform_init_level1(void)
-{
+/*
+ * init standard and extern platform hardware and services
+ *
+ * The steps are run by boot_sched_run(), which starts a step as soon as the
+ * steps it depends on are done, so independent steps overlap, eg. the SD card
+ * is mounted while the wlan is brought up. Steps using pin mux are serialized
+ * by BOOT_RES_PINMUX, the shared CCM bus clock and reset bits are changed
+ * with the interrupts off by the HAL.
+ *
+ * platform_init_level1() and platform_init_level2() are left to projects,
+ * each runs once the standard or extern steps are done, level 2 after
+ * level 1 as before.
+ */
+enum platform_step {
+	PLATFORM_STEP_CE,
+	PLATFORM_STEP_UART,
+	PLATFORM_STEP_SYS_CTRL,
+	PLATFORM_STEP_NET_CTRL,
+	PLATFORM_STEP_PRNG,
+	PLATFORM_STEP_SYSINFO,
+	PLATFORM_STEP_CONSOLE,
+	PLATFORM_STEP_PM,
+	PLATFORM_STEP_NET,
+	PLATFORM_STEP_WDG,
+	PLATFORM_STEP_LEVEL1,
+	PLATFORM_STEP_SPI,
+	PLATFORM_STEP_MMC,
+	PLATFORM_STEP_AUDIO,
+	PLATFORM_STEP_CEDARX,
+	PLATFORM_STEP_LEVEL2,
+	PLATFORM_STEP_NUM
+};
+
+#define BOOT_RES_PINMUX		(1U << 0)
+
 #if PRJCONF_CE_EN
+static void platform_ce_init(void)
+{
 	HAL_CE_Init();
+}
+#else
+#define platform_ce_init	NULL
 #endif
 
 #if PRJCONF_UART_EN
+static void platform_uart_init(void)
+{
 	if ((BOARD_SUB_UART_ID < UART_NUM) &&
 	    (BOARD_SUB_UART_ID != BOARD_MAIN_UART_ID)) {
 		board_uart_init(BOARD_SUB_UART_ID);
 	}
+}
+#else
+#define platform_uart_init	NULL
 #endif
 
 #if PRJCONF_SYS_CTRL_EN
+static void platform_sys_ctrl_init(void)
+{
 	sys_ctrl_create();
-  #if PRJCONF_NET_EN
+}
+#else
+#define platform_sys_ctrl_init	NULL
+#endif
+
+#if (PRJCONF_SYS_CTRL_EN && PRJCONF_NET_EN)
+static void platform_net_ctrl_init(void)
+{
 	net_ctrl_init();
-  #endif
+}
+#else
+#define platform_net_ctrl_init	NULL
 #endif
 
-#if (PRJCONF_CE_EN && PRJCONF_PRNG_INIT_SEED)
-	platform_prng_init_seed(); /* init prng seed */
+#if !(PRJCONF_CE_EN && PRJCONF_PRNG_INIT_SEED)
+#define platform_prng_init_seed	NULL
 #endif
 
+static void platform_sysinfo_init(void)
+{
 	sysinfo_init();
+}
 
 #if PRJCONF_CONSOLE_EN
+static void platform_console_init(void)
+{
 	console_param_t cparam;
 	cparam.uart_id = BOARD_MAIN_UART_ID;
 	cparam.cmd_exec = main_cmd_exec;
 	cparam.stack_size = PRJCONF_CONSOLE_STACK_SIZE;
 	console_start(&cparam);
+}
+#else
+#define platform_console_init	NULL
 #endif
 
 #if PRJCONF_PM_EN
+static void platform_pm_init(void)
+{
 	pm_mode_platform_select(PRJCONF_PM_MODE);
+	pm_start();
+}
+#else
+#define platform_pm_init	NULL
 #endif
 
 #if PRJCONF_NET_EN
+static void platform_net_init(void)
+{
 	net_sys_init();
 
 	struct sysinfo *sysinfo = sysinfo_get();
@@ -330,26 +404,37 @@ __weak void platform_init_level1(void)
   #if PRJCONF_NET_PM_EN
 	pm_register_wlan_power_onoff(net_sys_onoff, PRJCONF_NET_PM_MODE);
   #endif
+}
+#else
+#define platform_net_init	NULL
 #endif /* PRJCONF_NET_EN */
 
-#if PRJCONF_WDG_EN
-	platform_wdg_start();
+#if !PRJCONF_WDG_EN
+#define platform_wdg_start	NULL
 #endif
-}
 
-/* init extern platform hardware and services */
-__weak void platform_init_level2(void)
-{
 #if PRJCONF_SPI_EN
+static void platform_spi_init(void)
+{
 	board_spi_init(BOARD_SPI_PORT);
+}
+#else
+#define platform_spi_init	NULL
 #endif
 
 #if PRJCONF_MMC_EN
+static void platform_mmc_init(void)
+{
 	fs_ctrl_init();
  	board_sdcard_init(sdcard_detect_callback);
+}
+#else
+#define platform_mmc_init	NULL
 #endif
 
 #if (PRJCONF_SOUNDCARD0_EN || PRJCONF_SOUNDCARD1_EN)
+static void platform_audio_init(void)
+{
 	aud_mgr_init();
 	snd_pcm_init();
   #if PRJCONF_SOUNDCARD0_EN
@@ -363,11 +448,80 @@ __weak void platform_init_level2(void)
   #if PRJCONF_SOUNDCARD1_EN
 	board_soundcard1_init();
   #endif
+}
+#else
+#define platform_audio_init	NULL
 #endif
 
-#ifdef __PRJ_CONFIG_XPLAYER
-	platform_cedarx_init();
+#ifndef __PRJ_CONFIG_XPLAYER
+#define platform_cedarx_init	NULL
 #endif
+
+/* project specific init, after the standard steps */
+__weak void platform_init_level1(void)
+{
+}
+
+/* project specific init, after the extern steps */
+__weak void platform_init_level2(void)
+{
+}
+
+#define PLATFORM_LEVEL1_DEPS	(BOOT_DEP(PLATFORM_STEP_CE) |		\
+				 BOOT_DEP(PLATFORM_STEP_UART) |		\
+				 BOOT_DEP(PLATFORM_STEP_SYS_CTRL) |	\
+				 BOOT_DEP(PLATFORM_STEP_NET_CTRL) |	\
+				 BOOT_DEP(PLATFORM_STEP_PRNG) |		\
+				 BOOT_DEP(PLATFORM_STEP_SYSINFO) |	\
+				 BOOT_DEP(PLATFORM_STEP_CONSOLE) |	\
+				 BOOT_DEP(PLATFORM_STEP_PM) |		\
+				 BOOT_DEP(PLATFORM_STEP_NET) |		\
+				 BOOT_DEP(PLATFORM_STEP_WDG))
+
+#define PLATFORM_LEVEL2_DEPS	(BOOT_DEP(PLATFORM_STEP_LEVEL1) |	\
+				 BOOT_DEP(PLATFORM_STEP_SPI) |		\
+				 BOOT_DEP(PLATFORM_STEP_MMC) |		\
+				 BOOT_DEP(PLATFORM_STEP_AUDIO) |	\
+				 BOOT_DEP(PLATFORM_STEP_CEDARX))
+
+static const struct boot_step platform_steps[PLATFORM_STEP_NUM] = {
+	[PLATFORM_STEP_CE]       = { "ce",       platform_ce_init,       0, 0 },
+	[PLATFORM_STEP_UART]     = { "uart",     platform_uart_init,     0, BOOT_RES_PINMUX },
+	[PLATFORM_STEP_SYS_CTRL] = { "sys_ctrl", platform_sys_ctrl_init, 0, 0 },
+	[PLATFORM_STEP_NET_CTRL] = { "net_ctrl", platform_net_ctrl_init,
+	                             BOOT_DEP(PLATFORM_STEP_SYS_CTRL), 0 },
+	[PLATFORM_STEP_PRNG]     = { "prng",     platform_prng_init_seed,
+	                             BOOT_DEP(PLATFORM_STEP_CE), 0 },
+	[PLATFORM_STEP_SYSINFO]  = { "sysinfo",  platform_sysinfo_init,  0, 0 },
+	[PLATFORM_STEP_CONSOLE]  = { "console",  platform_console_init,
+	                             BOOT_DEP(PLATFORM_STEP_SYS_CTRL) |
+	                             BOOT_DEP(PLATFORM_STEP_SYSINFO), 0 },
+	[PLATFORM_STEP_PM]       = { "pm",       platform_pm_init,       0, 0 },
+	[PLATFORM_STEP_NET]      = { "net",      platform_net_init,
+	                             BOOT_DEP(PLATFORM_STEP_CE) |
+	                             BOOT_DEP(PLATFORM_STEP_NET_CTRL) |
+	                             BOOT_DEP(PLATFORM_STEP_PRNG) |
+	                             BOOT_DEP(PLATFORM_STEP_SYSINFO) |
+	                             BOOT_DEP(PLATFORM_STEP_PM), 0 },
+	[PLATFORM_STEP_WDG]      = { "wdg",      platform_wdg_start,     0, 0 },
+	[PLATFORM_STEP_LEVEL1]   = { "level1",   platform_init_level1,
+	                             PLATFORM_LEVEL1_DEPS, 0 },
+	[PLATFORM_STEP_SPI]      = { "spi",      platform_spi_init,      0, BOOT_RES_PINMUX },
+	[PLATFORM_STEP_MMC]      = { "mmc",      platform_mmc_init,
+	                             BOOT_DEP(PLATFORM_STEP_SYS_CTRL), BOOT_RES_PINMUX },
+	[PLATFORM_STEP_AUDIO]    = { "audio",    platform_audio_init,
+	                             BOOT_DEP(PLATFORM_STEP_SYS_CTRL), BOOT_RES_PINMUX },
+	[PLATFORM_STEP_CEDARX]   = { "cedarx",   platform_cedarx_init,   0, 0 },
+	[PLATFORM_STEP_LEVEL2]   = { "level2",   platform_init_level2,
+	                             PLATFORM_LEVEL2_DEPS, 0 },
+};
+
+static struct boot_step_time platform_timeline[PLATFORM_STEP_NUM];
+
+/* print the timeline of the last platform_init() */
+void platform_boot_timeline_dump(void)
+{
+	boot_sched_dump(platform_steps, PLATFORM_STEP_NUM, platform_timeline);
 }
 
 __nonxip_text
@@ -378,6 +532,10 @@ void platform_init(void)
 #if PLATFORM_SHOW_INFO
 	platform_show_info();
 #endif
-	platform_init_level1();
-	platform_init_level2();
+	boot_sched_run(platform_steps, PLATFORM_STEP_NUM, platform_timeline,
+	               PRJCONF_BOOT_WORKERS, PRJCONF_MAIN_THREAD_PRIO,
+	               PRJCONF_BOOT_WORKER_STACK_SIZE);
+#if PRJCONF_BOOT_TIMELINE_EN
+	platform_boot_timeline_dump();
+#endif
 }
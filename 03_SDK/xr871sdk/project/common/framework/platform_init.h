@@ -35,6 +35,11 @@ extern "C" {
 #endif
 
 void platform_init(void);
+void platform_boot_timeline_dump(void);
+
+/* weak, for projects to add their own init, run by platform_init() */
+void platform_init_level1(void);
+void platform_init_level2(void);
 
 #ifdef __cplusplus
 }
@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include "sys/defs.h"
 #include "sys/list.h"
 #include "kernel/os/os.h"
 #include "observer.h"
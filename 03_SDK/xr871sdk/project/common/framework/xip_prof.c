@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sampling profiler for code placement
+ *
+ * A timer interrupt at the highest priority, above the one masked by the OS
+ * critical sections, records the PC stacked by the CPU on entry. Samples are
+ * split by whether the PC is in XIP (flash) code or in SRAM code, and the
+ * dump of the aggregated PCs is the input of tools/xip_place.py, which ranks
+ * functions for moving to SRAM.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "sys/interrupt.h"
+#include "driver/chip/hal_nvic.h"
+#include "driver/chip/hal_clock.h"
+#include "xip_prof.h"
+#include "fwk_debug.h"
+
+#define XIP_PROF_IRQ_PRIO       (0)
+
+#if (XIP_PROF_TIMER_ID == TIMER0_ID)
+#define XIP_PROF_TIMER_IRQn     TIMER0_IRQn
+#else
+#define XIP_PROF_TIMER_IRQn     TIMER1_IRQn
+#endif
+
+struct xip_prof {
+	uint32_t *samples;
+	uint32_t max_samples;
+	uint32_t hz;
+	struct xip_prof_stat stat;
+	NVIC_IRQHandler timer_handler;  /* handler of the timer driver */
+	uint8_t running;
+};
+
+static struct xip_prof g_xip_prof;
+
+#if (defined(__PRJ_CONFIG_XIP))
+extern uint8_t __xip_start[];
+extern uint8_t __xip_end[];
+#endif
+extern uint8_t __RAM_BASE[];
+extern uint8_t _estack[];
+
+/* @frame is the exception frame stacked on entry: r0-r3, r12, lr, pc, xpsr */
+static __attribute__((used)) __nonxip_text void xip_prof_sample(uint32_t *frame)
+{
+	struct xip_prof *prof = &g_xip_prof;
+	uint32_t pc = frame[6];
+
+	prof->stat.total++;
+#if (defined(__PRJ_CONFIG_XIP))
+	if (pc >= (uint32_t)__xip_start && pc < (uint32_t)__xip_end)
+		prof->stat.xip++;
+	else
+#endif
+	if (pc >= (uint32_t)__RAM_BASE && pc < (uint32_t)_estack)
+		prof->stat.sram++;
+	else
+		prof->stat.other++;
+
+	if (prof->stat.total - prof->stat.dropped <= prof->max_samples)
+		prof->samples[prof->stat.total - prof->stat.dropped - 1] = pc;
+	else
+		prof->stat.dropped++;
+
+	/* let the timer driver clear the pending IRQ */
+	prof->timer_handler();
+}
+
+/* pass the exception frame of the interrupted context to the sampler */
+static __attribute__((naked)) __nonxip_text void xip_prof_irq_entry(void)
+{
+	__asm volatile (
+		"tst   lr, #4          \n"
+		"ite   eq              \n"
+		"mrseq r0, msp         \n"
+		"mrsne r0, psp         \n"
+		"b     xip_prof_sample \n"
+	);
+}
+
+/**
+ * @brief Start sampling PCs
+ * @param[in] hz Sampling rate
+ * @param[in] max_samples Max number of samples kept for xip_prof_dump()
+ * @return 0 on success, -1 on failure
+ *
+ * @note Samples of the previous run are discarded.
+ */
+int xip_prof_start(uint32_t hz, uint32_t max_samples)
+{
+	struct xip_prof *prof = &g_xip_prof;
+	TIMER_InitParam param;
+
+	if (prof->running || hz == 0 || max_samples == 0) {
+		FWK_ERR("running %d, hz %u, max samples %u\n", prof->running, hz,
+		        max_samples);
+		return -1;
+	}
+
+	if (prof->samples == NULL || prof->max_samples != max_samples) {
+		free(prof->samples);
+		prof->samples = malloc(max_samples * sizeof(uint32_t));
+		if (prof->samples == NULL) {
+			FWK_ERR("no mem, %u samples\n", max_samples);
+			prof->max_samples = 0;
+			return -1;
+		}
+		prof->max_samples = max_samples;
+	}
+	memset(&prof->stat, 0, sizeof(prof->stat));
+	prof->hz = hz;
+
+	param.cfg = HAL_TIMER_MakeInitCfg(TIMER_MODE_REPEAT, TIMER_CLK_SRC_HFCLK,
+	                                  TIMER_CLK_PRESCALER_1);
+	param.period = HAL_GetHFClock() / hz;
+	param.isEnableIRQ = 1;
+	param.callback = NULL;
+	param.arg = NULL;
+	if (HAL_TIMER_Init(XIP_PROF_TIMER_ID, &param) != HAL_OK) {
+		FWK_ERR("timer init failed\n");
+		return -1;
+	}
+
+	/* hook the vector, the driver's handler is chained to clear the IRQ */
+	prof->timer_handler = HAL_NVIC_GetIRQHandler(XIP_PROF_TIMER_IRQn);
+	HAL_NVIC_ConfigExtIRQ(XIP_PROF_TIMER_IRQn, xip_prof_irq_entry,
+	                      XIP_PROF_IRQ_PRIO);
+
+	prof->running = 1;
+	HAL_TIMER_Start(XIP_PROF_TIMER_ID);
+	return 0;
+}
+
+/**
+ * @brief Stop sampling PCs, the samples are kept
+ * @return None
+ */
+void xip_prof_stop(void)
+{
+	struct xip_prof *prof = &g_xip_prof;
+
+	if (!prof->running)
+		return;
+
+	HAL_TIMER_DeInit(XIP_PROF_TIMER_ID);
+	prof->running = 0;
+}
+
+/**
+ * @brief Get the sampling statistics
+ * @param[out] stat Pointer to the statistics
+ * @return None
+ */
+void xip_prof_get_stat(struct xip_prof_stat *stat)
+{
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	*stat = g_xip_prof.stat;
+	arch_irq_restore(flags);
+}
+
+static int xip_prof_cmp(const void *a, const void *b)
+{
+	uint32_t pa = *(const uint32_t *)a;
+	uint32_t pb = *(const uint32_t *)b;
+
+	return (pa > pb) - (pa < pb);
+}
+
+/**
+ * @brief Print the samples of a stopped run, one "<pc> <count>" line for each
+ *        distinct PC, sorted by PC
+ * @return None
+ */
+void xip_prof_dump(void)
+{
+	struct xip_prof *prof = &g_xip_prof;
+	struct xip_prof_stat *st = &prof->stat;
+	uint32_t num, i, cnt;
+
+	if (prof->running) {
+		FWK_ERR("stop it first\n");
+		return;
+	}
+	if (prof->samples == NULL)
+		return;
+
+	num = st->total - st->dropped;
+	qsort(prof->samples, num, sizeof(uint32_t), xip_prof_cmp);
+
+	printf("# xip_prof hz %u total %u xip %u sram %u other %u dropped %u\n",
+	       prof->hz, st->total, st->xip, st->sram, st->other, st->dropped);
+	for (i = 0; i < num; i += cnt) {
+		for (cnt = 1; i + cnt < num; cnt++) {
+			if (prof->samples[i + cnt] != prof->samples[i])
+				break;
+		}
+		printf("%08x %u\n", prof->samples[i], cnt);
+	}
+	printf("# xip_prof end\n");
+}
+
+/**
+ * @brief Stop sampling and release the samples
+ * @return None
+ */
+void xip_prof_deinit(void)
+{
+	struct xip_prof *prof = &g_xip_prof;
+
+	xip_prof_stop();
+	free(prof->samples);
+	memset(prof, 0, sizeof(*prof));
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _XIP_PROF_H_
+#define _XIP_PROF_H_
+
+#include <stdint.h>
+#include "driver/chip/hal_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* timer driving the sampling, not available to others while profiling */
+#define XIP_PROF_TIMER_ID       TIMER1_ID
+
+/* sampling statistics, hits are split by where the sampled code runs from */
+struct xip_prof_stat {
+	uint32_t total;     /* samples taken */
+	uint32_t xip;       /* PC in XIP (flash) code */
+	uint32_t sram;      /* PC in SRAM code */
+	uint32_t other;     /* PC elsewhere, eg. ROM */
+	uint32_t dropped;   /* samples not recorded due to a full buffer */
+};
+
+int xip_prof_start(uint32_t hz, uint32_t max_samples);
+void xip_prof_stop(void);
+void xip_prof_get_stat(struct xip_prof_stat *stat);
+void xip_prof_dump(void);
+void xip_prof_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _XIP_PROF_H_ */
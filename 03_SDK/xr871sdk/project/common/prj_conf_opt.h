@@ -55,6 +55,21 @@ extern "C" {
 #define PRJCONF_MAIN_THREAD_STACK_SIZE  (1 * 1024)
 #endif
 
+/* number of threads running the platform init steps, including main thread */
+#ifndef PRJCONF_BOOT_WORKERS
+#define PRJCONF_BOOT_WORKERS            2
+#endif
+
+/* stack size of the threads helping main thread to run the init steps */
+#ifndef PRJCONF_BOOT_WORKER_STACK_SIZE
+#define PRJCONF_BOOT_WORKER_STACK_SIZE  (2 * 1024)
+#endif
+
+/* print the timeline of the platform init steps */
+#ifndef PRJCONF_BOOT_TIMELINE_EN
+#define PRJCONF_BOOT_TIMELINE_EN        0
+#endif
+
 /* sys ctrl enable/disable */
 #ifndef PRJCONF_SYS_CTRL_EN
 #define PRJCONF_SYS_CTRL_EN             1
@@ -95,6 +110,22 @@ extern "C" {
 #define PRJCONF_IMG_MAX_SIZE            ((1024 - 4) * 1024)
 #endif
 
+/*
+ * image verified cache, recording sections whose data has been checked to
+ * skip checking them again on boot, disabled if size is 0
+ */
+#ifndef PRJCONF_IMG_VCACHE_FLASH
+#define PRJCONF_IMG_VCACHE_FLASH        PRJCONF_IMG_FLASH
+#endif
+
+#ifndef PRJCONF_IMG_VCACHE_ADDR
+#define PRJCONF_IMG_VCACHE_ADDR         0x00000000
+#endif
+
+#ifndef PRJCONF_IMG_VCACHE_SIZE
+#define PRJCONF_IMG_VCACHE_SIZE         0
+#endif
+
 /* save sysinfo to flash or not */
 #ifndef PRJCONF_SYSINFO_SAVE_TO_FLASH
 #define PRJCONF_SYSINFO_SAVE_TO_FLASH	1
@@ -188,7 +188,7 @@ static void player_task(void *arg)
     int ret;
     int volume = 8;
     int max_vol;
-    char read_songs_buf[255];
+    char read_songs_buf[PLAY_LIST_PATH_MAX];
     PLAYER_PAUSE_CTRL pause_ctrl = PLAYER_PAUSE_DIS;
 #if AUDIO_DISPLAY_ENABLE
     int show_song_countdown = 0;
@@ -206,12 +206,12 @@ static void player_task(void *arg)
         switch (cmd) {
             case CMD_PLAYER_NEXT:
                 pause_ctrl = PLAYER_PAUSE_DIS;
-                player_read_song(PLAYER_NEXT, read_songs_buf);
+                player_read_song(PLAYER_NEXT, read_songs_buf, sizeof(read_songs_buf));
                 play_songs(read_songs_buf);
                 break;
             case CMD_PLAYER_PERV:
                 pause_ctrl = PLAYER_PAUSE_DIS;
-                player_read_song(PLAYER_PREV, read_songs_buf);
+                player_read_song(PLAYER_PREV, read_songs_buf, sizeof(read_songs_buf));
                 play_songs(read_songs_buf);
                 break;
             case CMD_PLAYER_VOLUME_UP:
@@ -84,6 +84,7 @@ static const struct cmd_data g_main_cmds[] = {
 	{ "fs",     cmd_fs_exec },
 	{ "audio",  cmd_audio_exec },
 	{ "auddbg", cmd_auddbg_exec },
+	{ "prof",   cmd_prof_exec },
 };
 
 void main_cmd_exec(char *cmd)
@@ -36,193 +36,848 @@
 #include "play_list.h"
 
 #define PLAYER_SONGS_DIR  "0:/music"
-#define PLAY_LIST_FILE_NAME  "/mp3_list.txt"
+#define PLAY_LIST_FILE_NAME  "/.play_list.idx"
+#define PLAY_LIST_NEW_NAME   "/.play_list.new"
+#define PLAY_LIST_RUN_NAME   "/.play_list.run"
 
 #define LIST_LOGE(fmt, arg...)  printf("[LIST_ERR][F:%s][L:%d] " fmt, __func__, __LINE__, ##arg)
 #define LIST_LOGD(fmt, arg...)  printf("[LIST_DBG][F:%s][L:%d] " fmt, __func__, __LINE__, ##arg)
 
+/*
+ * The play list is a binary index kept in the music directory:
+ *
+ *   header | string pool | directory table | entry table
+ *
+ * Each directory records its modified time, so the index is only rebuilt
+ * when a directory has changed, and only the changed directories are read
+ * again on rebuilding. The entries are sorted by directory and name, and
+ * are read from the card on demand, so the library size is not limited by
+ * RAM.
+ *
+ * The vfat of Linux updates the time of a directory when a file is added
+ * to it, FatFs doesn't. Songs written on the board need f_utime() on their
+ * directory, or play_list_update(1).
+ */
+#define PLAY_LIST_MAGIC         0x494C5058  /* "XPLI" */
+#define PLAY_LIST_VERSION       1
+
+#define PLAY_LIST_DIR_MAX       64      /* directories in the index */
+#define PLAY_LIST_DIR_DEPTH     4       /* levels of sub directories scanned */
+#define PLAY_LIST_KEY_LEN       12      /* leading characters of a name used for sorting */
+#define PLAY_LIST_RUN_ENTRIES   256     /* entries sorted in RAM at a time on building */
+#define PLAY_LIST_MERGE_BUF     8       /* entries buffered per run on merging */
+#define PLAY_LIST_COPY_BUF      256     /* entries read at a time from the old index */
+
+#define PLAY_LIST_DIR_ROOT      0xFFFF  /* parent of the root directory */
+
+struct pl_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t dir_num;
+    uint32_t entry_num;
+    uint32_t pool_off;
+    uint32_t dir_off;
+    uint32_t entry_off;
+    uint32_t reserved[2];
+};
+
+struct pl_dir {
+    uint32_t mtime;         /* fdate << 16 | ftime of the directory */
+    uint32_t name_off;      /* offset of the name in the string pool */
+    uint32_t first;         /* index of the first entry in the directory */
+    uint32_t count;         /* number of entries in the directory */
+    uint16_t parent;        /* index of the parent directory */
+    uint8_t  name_len;
+    uint8_t  depth;
+};
+
+struct pl_entry {
+    uint32_t name_off;      /* offset of the name in the string pool */
+    uint16_t dir;           /* index of the directory */
+    uint8_t  name_len;
+    uint8_t  reserved;
+    char     key[PLAY_LIST_KEY_LEN];    /* upper case name prefix */
+};
+
 struct play_list_info {
-    FIL fp;
+    struct fs_ctrl_file file;
+    struct pl_header hdr;
+    struct pl_dir *dirs;
     int count;
-    uint32_t Mp3_Position[100];
-    uint32_t Mp3_File_Num;
+    uint32_t shuffle_a;     /* position k plays entry (a * k + b) % n, 0 for in order */
+    uint32_t shuffle_b;
 };
 
 static struct play_list_info list_info;
 
-static int player_open_dir(DIR *dirs, char *path)
+static int pl_read_at(FIL *fp, uint32_t off, void *buf, uint32_t len)
 {
-    if (strlen(path) + 14 > 50)
+    UINT br;
+
+    if (f_lseek(fp, off) != FR_OK || f_read(fp, buf, len, &br) != FR_OK || br != len)
         return -1;
+    return 0;
+}
 
-    if (f_opendir(dirs, path) != FR_OK) {
+static int pl_write(FIL *fp, const void *buf, uint32_t len)
+{
+    UINT bw;
+
+    if (f_write(fp, buf, len, &bw) != FR_OK || bw != len)
         return -1;
+    return 0;
+}
+
+static uint32_t pl_mtime(const FILINFO *finfo)
+{
+    return ((uint32_t)finfo->fdate << 16) | finfo->ftime;
+}
+
+static int pl_is_song(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+
+    return (ext != NULL && strcasecmp(ext, ".mp3") == 0);
+}
+
+static void pl_make_key(char *key, const char *name, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < PLAY_LIST_KEY_LEN; i++) {
+        if (i < len) {
+            key[i] = (name[i] >= 'a' && name[i] <= 'z') ? name[i] - 'a' + 'A' : name[i];
+        } else {
+            key[i] = 0;
+        }
     }
+}
+
+static int pl_entry_cmp(const void *a, const void *b)
+{
+    const struct pl_entry *ea = a;
+    const struct pl_entry *eb = b;
+    int ret;
+
+    if (ea->dir != eb->dir)
+        return (ea->dir < eb->dir) ? -1 : 1;
+    ret = memcmp(ea->key, eb->key, PLAY_LIST_KEY_LEN);
+    if (ret != 0)
+        return ret;
+    return (ea->name_off < eb->name_off) ? -1 : (ea->name_off > eb->name_off);
+}
+
+/* Read the name at @off of the string pool of an index */
+static int pl_read_name(FIL *fp, const struct pl_header *hdr, uint32_t off,
+                        uint32_t len, char *buf)
+{
+    if (pl_read_at(fp, hdr->pool_off + off, buf, len) != 0)
+        return -1;
+    buf[len] = '\0';
     return 0;
 }
 
-static int read_songs_name(FIL* fp, char *buff)
+/* Make "<music dir>/<sub dir>/..." of directory @d of an index */
+static int pl_dir_path(FIL *fp, const struct pl_header *hdr, const struct pl_dir *dirs,
+                       uint16_t d, char *buf, uint32_t size)
 {
-    uint32_t len = 0;
-    FRESULT res;
-    char data;
-    uint8_t i = 0;
+    uint16_t chain[PLAY_LIST_DIR_DEPTH + 1];
+    int depth = 0;
+    uint32_t len;
 
-    while(1) {
-        res = f_read (fp, &data, 1, &len);
-        if (res != FR_OK) {
-            LIST_LOGE("read file error %d\n", res);
+    while (d != 0 && d != PLAY_LIST_DIR_ROOT && depth < PLAY_LIST_DIR_DEPTH + 1) {
+        chain[depth++] = d;
+        d = dirs[d].parent;
+    }
+
+    len = strlen(PLAYER_SONGS_DIR);
+    if (len >= size)
+        return -1;
+    memcpy(buf, PLAYER_SONGS_DIR, len + 1);
+    while (depth-- > 0) {
+        const struct pl_dir *dir = &dirs[chain[depth]];
+        if (len + 1 + dir->name_len >= size)
             return -1;
+        buf[len++] = '/';
+        if (pl_read_name(fp, hdr, dir->name_off, dir->name_len, buf + len) != 0)
+            return -1;
+        len += dir->name_len;
+    }
+    return len;
+}
+
+/*
+ * Building
+ */
+struct pl_build_dir {
+    struct pl_dir rec;
+    int old;                /* index of the directory in the old index, -1 if none */
+    char *name;
+};
+
+struct pl_run {
+    uint32_t pos;           /* next entry to be read */
+    uint32_t end;
+    uint32_t idx;           /* next entry in buf[] */
+    uint32_t num;           /* entries in buf[] */
+    struct pl_entry buf[PLAY_LIST_MERGE_BUF];
+};
+
+struct pl_build {
+    struct fs_ctrl_file old;    /* the old index, with fast seek */
+    FIL out;
+    FIL run;
+    struct pl_header old_hdr;   /* magic is 0 if there is no old index */
+    struct pl_dir *old_dirs;
+    struct pl_build_dir dirs[PLAY_LIST_DIR_MAX];
+    uint16_t dir_num;
+    uint32_t pool_len;
+    uint32_t entry_num;
+    uint32_t run_len;           /* entries in run_buf[] */
+    uint32_t run_num;           /* runs written to the run file */
+    struct pl_entry run_buf[PLAY_LIST_RUN_ENTRIES];
+    struct pl_entry copy_buf[PLAY_LIST_COPY_BUF];
+    DIR dirs_obj;
+    FILINFO finfo;
+    char path[PLAY_LIST_PATH_MAX];
+    char name[_MAX_LFN + 1];
+};
+
+static int pl_build_dir_path(struct pl_build *b, uint16_t d, char *buf, uint32_t size)
+{
+    uint16_t chain[PLAY_LIST_DIR_DEPTH + 1];
+    int depth = 0;
+    int len;
+
+    while (d != 0 && depth < PLAY_LIST_DIR_DEPTH + 1) {
+        chain[depth++] = d;
+        d = b->dirs[d].rec.parent;
+    }
+
+    len = snprintf(buf, size, "%s", PLAYER_SONGS_DIR);
+    while (depth-- > 0 && len < size)
+        len += snprintf(buf + len, size - len, "/%s", b->dirs[chain[depth]].name);
+    return (len < size) ? len : -1;
+}
+
+static int pl_build_add_dir(struct pl_build *b, uint16_t parent, const char *name, int old)
+{
+    struct pl_build_dir *dir;
+    uint32_t len = strlen(name);
+
+    if (b->dir_num >= PLAY_LIST_DIR_MAX) {
+        LIST_LOGE("too many dirs, %s skipped\n", name);
+        return 0;
+    }
+
+    dir = &b->dirs[b->dir_num];
+    memset(dir, 0, sizeof(*dir));
+    dir->name = malloc(len + 1);
+    if (dir->name == NULL)
+        return -1;
+    memcpy(dir->name, name, len + 1);
+    if (pl_write(&b->out, name, len) != 0)
+        return -1;
+    dir->rec.name_off = b->pool_len;
+    dir->rec.name_len = len;
+    dir->rec.parent = parent;
+    dir->rec.depth = (parent == PLAY_LIST_DIR_ROOT) ? 0 : b->dirs[parent].rec.depth + 1;
+    dir->old = old;
+    b->pool_len += len;
+    b->dir_num++;
+    return 0;
+}
+
+static int pl_build_flush_run(struct pl_build *b)
+{
+    if (b->run_len == 0)
+        return 0;
+
+    qsort(b->run_buf, b->run_len, sizeof(struct pl_entry), pl_entry_cmp);
+    if (pl_write(&b->run, b->run_buf, b->run_len * sizeof(struct pl_entry)) != 0)
+        return -1;
+    b->run_num++;
+    b->run_len = 0;
+    return 0;
+}
+
+static int pl_build_put_entry(struct pl_build *b, const struct pl_entry *e)
+{
+    if (b->run_len == PLAY_LIST_RUN_ENTRIES && pl_build_flush_run(b) != 0)
+        return -1;
+
+    b->run_buf[b->run_len++] = *e;
+    b->dirs[e->dir].rec.count++;
+    b->entry_num++;
+    return 0;
+}
+
+static int pl_build_add_entry(struct pl_build *b, uint16_t d, const char *name, uint32_t len)
+{
+    struct pl_entry e;
+
+    if (pl_write(&b->out, name, len) != 0)
+        return -1;
+
+    e.name_off = b->pool_len;
+    e.dir = d;
+    e.name_len = len;
+    e.reserved = 0;
+    pl_make_key(e.key, name, len);
+    b->pool_len += len;
+    return pl_build_put_entry(b, &e);
+}
+
+/* Read the entries of old directory @od from the @i-th into copy_buf[] */
+static int pl_build_read_old(struct pl_build *b, const struct pl_dir *od, uint32_t i)
+{
+    uint32_t num = od->count - i;
+
+    if (num > PLAY_LIST_COPY_BUF)
+        num = PLAY_LIST_COPY_BUF;
+    if (pl_read_at(&b->old.fil, b->old_hdr.entry_off + (od->first + i) * sizeof(struct pl_entry),
+                   b->copy_buf, num * sizeof(struct pl_entry)) != 0)
+        return -1;
+    return num;
+}
+
+/*
+ * Take over the entries and sub directories of an unchanged directory.
+ * The names of its entries are together in the old string pool, they are
+ * copied at once instead of one by one.
+ */
+static int pl_build_copy_dir(struct pl_build *b, uint16_t d)
+{
+    const struct pl_dir *od = &b->old_dirs[b->dirs[d].old];
+    struct pl_entry *e = b->copy_buf;
+    uint32_t lo = UINT32_MAX, hi = 0, base = b->pool_len;
+    uint32_t i, j, len;
+    int num;
+
+    for (i = 0; i < od->count; i += num) {
+        if ((num = pl_build_read_old(b, od, i)) < 0)
+            return -1;
+        for (j = 0; j < num; j++) {
+            if (e[j].name_off < lo)
+                lo = e[j].name_off;
+            if (e[j].name_off + e[j].name_len > hi)
+                hi = e[j].name_off + e[j].name_len;
         }
-        if (len == 0) {
-            LIST_LOGD("file read end\n");
-            return 0;
-        }
+    }
 
-        buff[i++] = data;
+    for (i = lo; i < hi; i += len) {
+        len = hi - i;
+        if (len > sizeof(b->copy_buf))
+            len = sizeof(b->copy_buf);
+        if (pl_read_at(&b->old.fil, b->old_hdr.pool_off + i, b->copy_buf, len) != 0 ||
+            pl_write(&b->out, b->copy_buf, len) != 0)
+            return -1;
+        b->pool_len += len;
+    }
 
-        if (data == '\0') {
-            LIST_LOGD("read one song\n");
-            break;
+    for (i = 0; i < od->count; i += num) {
+        if ((num = pl_build_read_old(b, od, i)) < 0)
+            return -1;
+        for (j = 0; j < num; j++) {
+            e[j].name_off = e[j].name_off - lo + base;
+            e[j].dir = d;
+            if (pl_build_put_entry(b, &e[j]) != 0)
+                return -1;
         }
     }
-    return i;
+
+    for (i = 0; i < b->old_hdr.dir_num; i++) {
+        if (b->old_dirs[i].parent != b->dirs[d].old)
+            continue;
+        if (pl_read_name(&b->old.fil, &b->old_hdr, b->old_dirs[i].name_off,
+                         b->old_dirs[i].name_len, b->name) != 0 ||
+            pl_build_add_dir(b, d, b->name, i) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Find the sub directory @name of old directory @parent */
+static int pl_build_find_old(struct pl_build *b, int parent, const char *name)
+{
+    uint32_t i;
+    uint32_t len = strlen(name);
+    char *buf = b->name;
+
+    if (parent < 0)
+        return -1;
+
+    for (i = 0; i < b->old_hdr.dir_num; i++) {
+        if (b->old_dirs[i].parent != parent || b->old_dirs[i].name_len != len)
+            continue;
+        if (pl_read_name(&b->old.fil, &b->old_hdr, b->old_dirs[i].name_off, len, buf) == 0 &&
+            strcmp(buf, name) == 0)
+            return i;
+    }
+    return -1;
 }
 
-int player_read_song(PLAYER_READ_SONG ctrl, char *buff)
+static int pl_build_scan_dir(struct pl_build *b, uint16_t d)
 {
-    uint32_t position = 0;
+    FILINFO *finfo = &b->finfo;
+    FRESULT res;
     int ret = 0;
-    struct play_list_info *info = &list_info;
 
-    if (ctrl == PLAYER_NEXT) {
-        info->count++;
-        if (info->count >= info->Mp3_File_Num)
-            info->count = 0;
-        ret = read_songs_name(&info->fp, buff);
-        if (ret == 0) {
-            f_lseek (&info->fp, 0);
-            ret = read_songs_name(&info->fp, buff);
-            info->count = 0;
+    if (f_opendir(&b->dirs_obj, b->path) != FR_OK) {
+        LIST_LOGE("open dir %s error\n", b->path);
+        return 0;
+    }
+
+    while ((res = f_readdir(&b->dirs_obj, finfo)) == FR_OK && finfo->fname[0]) {
+        if (finfo->fname[0] == '.' || (finfo->fattrib & (AM_HID | AM_SYS)))
+            continue;
+        if (finfo->fattrib & AM_DIR) {
+            if (b->dirs[d].rec.depth < PLAY_LIST_DIR_DEPTH) {
+                ret = pl_build_add_dir(b, d, finfo->fname,
+                                       pl_build_find_old(b, b->dirs[d].old, finfo->fname));
+            }
+        } else if (pl_is_song(finfo->fname)) {
+            ret = pl_build_add_entry(b, d, finfo->fname, strlen(finfo->fname));
         }
-    } else {
-        info->count--;
-        if (info->count < 0)
-            info->count = info->Mp3_File_Num - 1;
-        position = info->Mp3_Position[info->count];
-        f_lseek (&info->fp, position);
-        ret = read_songs_name(&info->fp, buff);
+        if (ret != 0)
+            break;
     }
+    f_closedir(&b->dirs_obj);
+    return (res == FR_OK) ? ret : -1;
+}
+
+static int pl_run_fill(struct pl_build *b, struct pl_run *r)
+{
+    uint32_t num = r->end - r->pos;
+
+    if (num > PLAY_LIST_MERGE_BUF)
+        num = PLAY_LIST_MERGE_BUF;
+    if (pl_read_at(&b->run, r->pos * sizeof(struct pl_entry), r->buf,
+                   num * sizeof(struct pl_entry)) != 0)
+        return -1;
+    r->pos += num;
+    r->num = num;
+    r->idx = 0;
     return 0;
 }
 
-static int create_play_list(char *music_dir, char *file_name)  /* Pointer to the path name working buffer */
+/* Merge the sorted runs into the entry table */
+static int pl_build_merge(struct pl_build *b)
 {
-    FRESULT res;
-    int ret;
-    char *mp3;
-    char *MP3;
-    DIR dirs;
-    FILINFO finfo;
-    char f_path[100];
-    uint8_t Mp3_File_count = 1;
-    uint32_t File_Position = 0;
-    struct play_list_info *info = &list_info;
+    struct pl_run *runs;
+    uint32_t i, n;
+    int ret = -1;
+
+    if (b->run_num == 0)
+        return 0;
+
+    runs = malloc(b->run_num * sizeof(struct pl_run));
+    if (runs == NULL) {
+        LIST_LOGE("no mem for %u runs\n", b->run_num);
+        return -1;
+    }
+
+    for (i = 0; i < b->run_num; i++) {
+        runs[i].pos = i * PLAY_LIST_RUN_ENTRIES;
+        runs[i].end = runs[i].pos + PLAY_LIST_RUN_ENTRIES;
+        if (runs[i].end > b->entry_num)
+            runs[i].end = b->entry_num;
+        if (pl_run_fill(b, &runs[i]) != 0)
+            goto out;
+    }
+
+    for (n = 0; n < b->entry_num; n++) {
+        struct pl_run *min = NULL;
+
+        for (i = 0; i < b->run_num; i++) {
+            if (runs[i].idx == runs[i].num)
+                continue;
+            if (min == NULL || pl_entry_cmp(&runs[i].buf[runs[i].idx], &min->buf[min->idx]) < 0)
+                min = &runs[i];
+        }
+        if (min == NULL || pl_write(&b->out, &min->buf[min->idx], sizeof(struct pl_entry)) != 0)
+            goto out;
+        if (++min->idx == min->num && min->pos < min->end && pl_run_fill(b, min) != 0)
+            goto out;
+    }
+    ret = 0;
 
-    ret =  player_open_dir(&dirs, music_dir);
-    if(ret != 0) {
-        LIST_LOGE("open dir error\n");
+out:
+    free(runs);
+    return ret;
+}
+
+static int pl_build_load_old(struct pl_build *b, const char *path)
+{
+    uint32_t size;
+
+    if (fs_ctrl_open_media(&b->old, path) != 0)
         return -1;
+
+    if (pl_read_at(&b->old.fil, 0, &b->old_hdr, sizeof(b->old_hdr)) == 0 &&
+        b->old_hdr.magic == PLAY_LIST_MAGIC &&
+        b->old_hdr.version == PLAY_LIST_VERSION &&
+        b->old_hdr.dir_num <= PLAY_LIST_DIR_MAX) {
+        size = b->old_hdr.dir_num * sizeof(struct pl_dir);
+        b->old_dirs = malloc(size);
+        if (b->old_dirs != NULL &&
+            pl_read_at(&b->old.fil, b->old_hdr.dir_off, b->old_dirs, size) == 0) {
+            return 0;
+        }
+        free(b->old_dirs);
+        b->old_dirs = NULL;
     }
 
-    sprintf(f_path, "%s%s", music_dir, file_name);
-    f_unlink(f_path);
+    fs_ctrl_close_media(&b->old);
+    b->old_hdr.magic = 0;
+    return -1;
+}
 
-    res = f_open(&info->fp, f_path, FA_CREATE_NEW | FA_WRITE | FA_READ);
-    if(res != FR_OK) {
-        LIST_LOGE("open file error %d\n", res);
+static int pl_build(char *music_dir)
+{
+    struct pl_build *b;
+    struct pl_header hdr;
+    char list_path[64];
+    char new_path[64];
+    char run_path[64];
+    uint16_t d;
+    uint32_t i;
+    int ret = -1;
+
+    b = malloc(sizeof(struct pl_build));
+    if (b == NULL) {
+        LIST_LOGE("no mem\n");
         return -1;
     }
+    memset(b, 0, sizeof(struct pl_build));
 
-    info->Mp3_File_Num = 0;
+    sprintf(list_path, "%s%s", music_dir, PLAY_LIST_FILE_NAME);
+    sprintf(new_path, "%s%s", music_dir, PLAY_LIST_NEW_NAME);
+    sprintf(run_path, "%s%s", music_dir, PLAY_LIST_RUN_NAME);
 
-    while(1) {
-        mp3 = MP3 = NULL;
-        if ((res = f_readdir(&dirs, &finfo)) == FR_OK && finfo.fname[0]) {
-            if (finfo.fattrib & AM_DIR) {
-                LIST_LOGD("find a dir.\n");
-            } else {
-                mp3 = strstr(finfo.fname, ".mp3");
-                MP3 = strstr(finfo.fname, ".MP3");
-                if (mp3 || MP3) {
-                    LIST_LOGD("find a mp3: %s\n",finfo.fname);
-                    uint32_t write_len = 0;
-                    sprintf(f_path, "file://%s/%s", music_dir, finfo.fname);
-                    res = f_write (&info->fp, f_path, strlen(f_path) + 1, &write_len);
-                    if ((res != FR_OK) || (write_len != strlen(f_path) + 1)) {
-                        goto err;
-                    }
-                    File_Position += write_len;
-                    info->Mp3_Position[Mp3_File_count++] = File_Position;
-                    info->Mp3_File_Num++;
-                }
-            }
+    pl_build_load_old(b, list_path);
+
+    if (f_open(&b->out, new_path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        LIST_LOGE("open %s error\n", new_path);
+        goto out_old;
+    }
+    if (f_open(&b->run, run_path, FA_CREATE_ALWAYS | FA_WRITE | FA_READ) != FR_OK) {
+        LIST_LOGE("open %s error\n", run_path);
+        goto out_new;
+    }
+
+    /* the header is written at last */
+    memset(&hdr, 0, sizeof(hdr));
+    if (f_lseek(&b->out, sizeof(hdr)) != FR_OK)
+        goto out_run;
+
+    if (pl_build_add_dir(b, PLAY_LIST_DIR_ROOT, "", b->old_hdr.magic ? 0 : -1) != 0)
+        goto out_run;
+
+    /* breadth first, so that the sub directories follow their parents */
+    for (d = 0; d < b->dir_num; d++) {
+        struct pl_build_dir *dir = &b->dirs[d];
+
+        dir->rec.first = b->entry_num;
+        if (pl_build_dir_path(b, d, b->path, sizeof(b->path)) < 0 ||
+            f_stat(b->path, &b->finfo) != FR_OK) {
+            LIST_LOGE("stat dir %s error\n", b->path);
+            continue;
+        }
+        dir->rec.mtime = pl_mtime(&b->finfo);
+
+        if (dir->old >= 0 && b->old_dirs[dir->old].mtime == dir->rec.mtime) {
+            ret = pl_build_copy_dir(b, d);
         } else {
-            LIST_LOGD("scan mp3 end\n");
+            LIST_LOGD("scan %s\n", b->path);
+            ret = pl_build_scan_dir(b, d);
+        }
+        if (ret != 0)
+            goto out_run;
+        ret = -1;
+    }
+    if (pl_build_flush_run(b) != 0)
+        goto out_run;
+
+    hdr.magic = PLAY_LIST_MAGIC;
+    hdr.version = PLAY_LIST_VERSION;
+    hdr.dir_num = b->dir_num;
+    hdr.entry_num = b->entry_num;
+    hdr.pool_off = sizeof(hdr);
+    hdr.dir_off = sizeof(hdr) + b->pool_len;
+    hdr.entry_off = hdr.dir_off + b->dir_num * sizeof(struct pl_dir);
+
+    for (i = 0; i < b->dir_num; i++) {
+        if (pl_write(&b->out, &b->dirs[i].rec, sizeof(struct pl_dir)) != 0)
+            goto out_run;
+    }
+    if (pl_build_merge(b) != 0)
+        goto out_run;
+    if (f_lseek(&b->out, 0) != FR_OK || pl_write(&b->out, &hdr, sizeof(hdr)) != 0)
+        goto out_run;
+    ret = 0;
+    LIST_LOGD("%u songs in %u dirs\n", b->entry_num, b->dir_num);
+
+out_run:
+    f_close(&b->run);
+    f_unlink(run_path);
+out_new:
+    if (f_close(&b->out) != FR_OK)
+        ret = -1;
+out_old:
+    if (b->old_hdr.magic) {
+        fs_ctrl_close_media(&b->old);
+        free(b->old_dirs);
+    }
+    if (ret == 0) {
+        f_unlink(list_path);
+        if (f_rename(new_path, list_path) != FR_OK) {
+            LIST_LOGE("rename %s error\n", new_path);
+            ret = -1;
+        }
+    } else {
+        f_unlink(new_path);
+    }
+    for (i = 0; i < b->dir_num; i++)
+        free(b->dirs[i].name);
+    free(b);
+    return ret;
+}
+
+/*
+ * Reading
+ */
+static void play_list_close(struct play_list_info *info)
+{
+    if (info->dirs != NULL) {
+        fs_ctrl_close_media(&info->file);
+        free(info->dirs);
+        info->dirs = NULL;
+    }
+    info->hdr.entry_num = 0;
+}
+
+/* Open the index, return 1 if it is up to date, 0 if it needs a rebuild */
+static int play_list_open(struct play_list_info *info, const char *list_path)
+{
+    FILINFO *finfo;
+    char *path;
+    uint32_t size;
+    uint16_t d;
+    int ret = 0;
+
+    if (fs_ctrl_open_media(&info->file, list_path) != 0)
+        return 0;
+
+    if (pl_read_at(&info->file.fil, 0, &info->hdr, sizeof(info->hdr)) != 0 ||
+        info->hdr.magic != PLAY_LIST_MAGIC ||
+        info->hdr.version != PLAY_LIST_VERSION ||
+        info->hdr.dir_num == 0 || info->hdr.dir_num > PLAY_LIST_DIR_MAX) {
+        fs_ctrl_close_media(&info->file);
+        return 0;
+    }
+
+    size = info->hdr.dir_num * sizeof(struct pl_dir);
+    info->dirs = malloc(size);
+    finfo = malloc(sizeof(FILINFO) + PLAY_LIST_PATH_MAX);
+    if (info->dirs == NULL || finfo == NULL ||
+        pl_read_at(&info->file.fil, info->hdr.dir_off, info->dirs, size) != 0)
+        goto out;
+
+    /* the index is up to date if no directory has been modified */
+    path = (char *)(finfo + 1);
+    for (d = 0; d < info->hdr.dir_num; d++) {
+        if (pl_dir_path(&info->file.fil, &info->hdr, info->dirs, d,
+                        path, PLAY_LIST_PATH_MAX) < 0 ||
+            f_stat(path, finfo) != FR_OK ||
+            pl_mtime(finfo) != info->dirs[d].mtime)
             break;
+    }
+    ret = (d == info->hdr.dir_num);
+
+out:
+    free(finfo);
+    if (ret == 0) {
+        if (info->dirs == NULL)
+            fs_ctrl_close_media(&info->file);
+        play_list_close(info);
+    }
+    return ret;
+}
+
+int play_list_count(void)
+{
+    return list_info.hdr.entry_num;
+}
+
+int play_list_get(uint32_t index, char *buff, uint32_t size)
+{
+    struct play_list_info *info = &list_info;
+    struct pl_entry e;
+    int len;
+
+    if (index >= info->hdr.entry_num)
+        return -1;
+
+    if (pl_read_at(&info->file.fil, info->hdr.entry_off + index * sizeof(e), &e, sizeof(e)) != 0 ||
+        e.dir >= info->hdr.dir_num)
+        return -1;
+
+    len = snprintf(buff, size, "file://");
+    if (len >= size)
+        return -1;
+    len = pl_dir_path(&info->file.fil, &info->hdr, info->dirs, e.dir, buff + len, size - len);
+    if (len < 0)
+        return -1;
+    len += strlen("file://");
+    if (len + 1 + e.name_len >= size)
+        return -1;
+    buff[len++] = '/';
+    return pl_read_name(&info->file.fil, &info->hdr, e.name_off, e.name_len, buff + len);
+}
+
+int play_list_find(const char *name)
+{
+    struct play_list_info *info = &list_info;
+    struct pl_entry e;
+    char key[PLAY_LIST_KEY_LEN];
+    char buf[_MAX_LFN + 1];
+    uint32_t len = strlen(name);
+    uint32_t klen = (len < PLAY_LIST_KEY_LEN) ? len : PLAY_LIST_KEY_LEN;
+    uint32_t lo, hi, mid;
+    uint16_t d;
+
+    pl_make_key(key, name, len);
+
+    for (d = 0; d < info->hdr.dir_num; d++) {
+        /* lower bound of the key prefix in the entries of the directory */
+        lo = info->dirs[d].first;
+        hi = lo + info->dirs[d].count;
+        while (lo < hi) {
+            mid = (lo + hi) / 2;
+            if (pl_read_at(&info->file.fil, info->hdr.entry_off + mid * sizeof(e), &e, sizeof(e)) != 0)
+                return -1;
+            if (memcmp(e.key, key, klen) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        for (hi = info->dirs[d].first + info->dirs[d].count; lo < hi; lo++) {
+            if (pl_read_at(&info->file.fil, info->hdr.entry_off + lo * sizeof(e), &e, sizeof(e)) != 0)
+                return -1;
+            if (memcmp(e.key, key, klen) != 0)
+                break;
+            if (e.name_len >= len &&
+                pl_read_name(&info->file.fil, &info->hdr, e.name_off, e.name_len, buf) == 0 &&
+                strncasecmp(buf, name, len) == 0)
+                return lo;
         }
     }
-    f_close (&info->fp);
+    return -1;
+}
+
+static uint32_t pl_gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void play_list_set_shuffle(int enable)
+{
+    struct play_list_info *info = &list_info;
+    uint32_t n = info->hdr.entry_num;
+    uint32_t seed;
+
+    info->shuffle_a = 0;
+    if (!enable || n < 3)
+        return;
+
+    /* any a coprime with n gives a permutation of the songs */
+    seed = OS_GetTicks() * 2654435761U;
+    info->shuffle_a = seed % (n - 1) + 1;
+    while (pl_gcd(info->shuffle_a, n) != 1)
+        info->shuffle_a = info->shuffle_a % (n - 1) + 1;
+    info->shuffle_b = (seed >> 16) % n;
+}
 
-    if (info->Mp3_File_Num == 0) {
-        LIST_LOGD("no song found\n");
+int player_read_song(PLAYER_READ_SONG ctrl, char *buff, uint32_t size)
+{
+    struct play_list_info *info = &list_info;
+    int n = info->hdr.entry_num;
+    uint32_t index;
+
+    if (n == 0)
         return -1;
+
+    if (ctrl == PLAYER_NEXT) {
+        info->count++;
+        if (info->count >= n)
+            info->count = 0;
+    } else {
+        info->count--;
+        if (info->count < 0)
+            info->count = n - 1;
     }
 
-    return 0;
-err:
-    f_close (&info->fp);
-    LIST_LOGE("write file fail\n");
-    return -1;
+    index = info->count;
+    if (info->shuffle_a)
+        index = (uint32_t)(((uint64_t)info->shuffle_a * index + info->shuffle_b) % n);
+    return play_list_get(index, buff, size);
 }
 
-int play_list_init ()
+int play_list_update(int force)
 {
-    int ret;
     char *music_dir = PLAYER_SONGS_DIR;
-    char *list_name = PLAY_LIST_FILE_NAME;
     char list_path[64];
     struct play_list_info *info = &list_info;
 
-    info->count = -1;
+    sprintf(list_path, "%s%s", music_dir, PLAY_LIST_FILE_NAME);
 
-    sprintf(list_path, "%s%s", music_dir, list_name);
+    play_list_close(info);
+    if (!force && play_list_open(info, list_path))
+        return 0;
 
-    if (fs_ctrl_mount(FS_MNT_DEV_TYPE_SDCARD, 0) != 0) {
-        LIST_LOGE("mount fail\n");
+    if (force)
+        f_unlink(list_path);
+    if (pl_build(music_dir) != 0) {
+        LIST_LOGE("create play list fail\n");
         return -1;
     }
-
-    ret = create_play_list(music_dir, list_name);
-    if (ret != 0) {
-        LIST_LOGE("create play list fail\n");
+    if (!play_list_open(info, list_path) || info->hdr.entry_num == 0) {
+        LIST_LOGE("no song found\n");
+        play_list_close(info);
         return -1;
     }
+    info->count = -1;
+    return 0;
+}
 
-    if (f_open(&info->fp, list_path, FA_READ) != FR_OK) {
-        LIST_LOGE("open file fail\n");
+int play_list_init ()
+{
+    struct play_list_info *info = &list_info;
+
+    memset(info, 0, sizeof(*info));
+    info->count = -1;
+
+    if (fs_ctrl_mount(FS_MNT_DEV_TYPE_SDCARD, 0) != 0) {
+        LIST_LOGE("mount fail\n");
         return -1;
     }
-    return 0;
+
+    return play_list_update(0);
 }
 
 void play_list_deinit()
 {
     struct play_list_info *info = &list_info;
 
-    f_close(&info->fp);
+    play_list_close(info);
     if (fs_ctrl_unmount(FS_MNT_DEV_TYPE_SDCARD, 0) != 0) {
         LIST_LOGE("unmount fail\n");
     }
 }
-
@@ -29,10 +29,14 @@
 #ifndef __AUDIO_PLAY_LIST_H_
 #define __AUDIO_PLAY_LIST_H_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
+#define PLAY_LIST_PATH_MAX  255
+
 typedef enum {
     PLAYER_PREV,
     PLAYER_NEXT,
@@ -40,7 +44,12 @@ typedef enum {
 
 int play_list_init ();
 void play_list_deinit();
-int player_read_song(PLAYER_READ_SONG ctrl, char *buff);
+int play_list_update(int force);
+int play_list_count(void);
+int play_list_get(uint32_t index, char *buff, uint32_t size);
+int play_list_find(const char *name);
+void play_list_set_shuffle(int enable);
+int player_read_song(PLAYER_READ_SONG ctrl, char *buff, uint32_t size);
 
 #ifdef __cplusplus
 }
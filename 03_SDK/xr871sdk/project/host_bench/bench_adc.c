@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ADC sampling stream (src/driver/chip/adc_stream.c) fed with recorded
+ * FIFO streams: four channels with different signals interleaved as the
+ * controller converts them, drained in bursts of random size. Every
+ * channel's output is checked against a plain moving sum cascade of its
+ * own samples, with the block times, sequence numbers and flags. Then a
+ * FIFO overrun in the middle of a block, a consumer too slow for the ring
+ * and invalid setups, and the cost of a sample through the stream.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "driver/chip/adc_stream.h"
+#include "bench.h"
+
+#define FREQ            48000
+#define T0              1000
+#define NCHAN           4
+#define SAMPLES         (FREQ * 2)
+#define RING            64
+#define REF_MAX         (SAMPLES / NCHAN)
+
+/* not in channel order, the stream sorts them */
+static const struct adcs_chan_config chans[NCHAN] = {
+	{ 8, 3, 16 },   /* battery, slow, strongly filtered */
+	{ 0, 1, 1 },    /* every sample */
+	{ 5, 2, 5 },    /* a ratio not a power of 2 */
+	{ 3, 1, 8 },    /* moving average */
+};
+
+static uint16_t fifo[SAMPLES];
+
+static uint16_t signal(int chan, uint32_t i)
+{
+	switch (chan) {
+	case 0:
+		return (i * 37) & 0xFFF;
+	case 3:
+		return 2048 + 1500 * sin(i * 0.01) + (rand() % 200) - 100;
+	case 5:
+		return rand() & 0xFFF;
+	default:
+		return 3000 + (i / 1000) * 7;
+	}
+}
+
+/* the FIFO words of n conversions, the channels in order */
+static void record(uint16_t *out, uint32_t n, const uint8_t *order)
+{
+	uint32_t k;
+
+	for (k = 0; k < n; k++) {
+		out[k] = signal(order[k % NCHAN], k / NCHAN);
+		if (rand() % 16 == 0)
+			out[k] |= 0xF000;   /* not sample bits */
+	}
+}
+
+/* the outputs of a channel from its samples x[0..n) */
+static uint32_t reference(const uint16_t *fifo, uint32_t n, uint32_t pos,
+                          const struct adcs_chan_config *c, uint16_t *out)
+{
+	static int64_t s[2][REF_MAX];
+	uint32_t i, j, k, m, num = (n - pos + NCHAN - 1) / NCHAN;
+	uint32_t div = 1;
+	int cur = 0;
+
+	for (j = 0; j < num; j++)
+		s[0][j] = fifo[j * NCHAN + pos] & 0xFFF;
+	for (k = 0; k < c->order; k++, cur ^= 1) {
+		div *= c->ratio;
+		for (j = 0; j < num; j++) {
+			s[cur ^ 1][j] = 0;
+			for (i = 0; i < c->ratio && i <= j; i++)
+				s[cur ^ 1][j] += s[cur][j - i];
+		}
+	}
+
+	m = 0;
+	for (j = c->ratio - 1; j < num; j += c->ratio) {
+		if (j / c->ratio < (uint32_t)c->order - 1)
+			continue;   /* settling */
+		out[m++] = (s[cur][j] + div / 2) / div;
+	}
+	return m;
+}
+
+struct sink {
+	uint16_t    data[NCHAN][REF_MAX];
+	uint32_t    num[NCHAN];
+	uint32_t    seq[NCHAN];
+	uint32_t    t_first[NCHAN][REF_MAX / ADCS_BLOCK_SAMPLES + 8];
+	uint32_t    blocks[NCHAN];
+	uint32_t    gaps[NCHAN];
+	uint32_t    short_blocks;
+};
+
+static int chan_pos(const struct adcs *s, int chan)
+{
+	int p;
+
+	for (p = 0; p < s->nchan; p++)
+		if (s->f[p].chan == chan)
+			return p;
+	return -1;
+}
+
+static void drain(struct adcs *s, struct sink *k)
+{
+	struct adcs_block *b;
+	int p;
+
+	while ((b = adcs_peek(s)) != NULL) {
+		p = chan_pos(s, b->chan);
+		BENCH_CHECK(p >= 0);
+		BENCH_CHECK(b->seq == k->seq[p]);
+		BENCH_CHECK(b->num > 0 && b->num <= ADCS_BLOCK_SAMPLES);
+		if (b->flags & ADCS_BLOCK_GAP)
+			k->gaps[p]++;
+		if (b->num < ADCS_BLOCK_SAMPLES)
+			k->short_blocks++;
+		k->seq[p]++;
+		k->t_first[p][k->blocks[p]++] = b->t_us;
+		memcpy(&k->data[p][k->num[p]], b->data, b->num * sizeof(b->data[0]));
+		k->num[p] += b->num;
+		adcs_release(s);
+	}
+}
+
+static void feed(struct adcs *s, struct sink *k, const uint16_t *words, uint32_t n)
+{
+	uint32_t i;
+
+	for (i = 0; i < n; i += 256) {
+		adcs_push(s, &words[i], n - i < 256 ? n - i : 256);
+		drain(s, k);
+	}
+}
+
+/* time of output m of the channel at pos */
+static uint32_t out_time(const struct adcs *s, int pos, uint32_t m, uint32_t t0)
+{
+	const struct adcs_filter *f = &s->f[pos];
+	uint64_t j = (uint64_t)(m + f->order - 1) * f->ratio + f->ratio - 1;
+
+	return t0 + (uint32_t)((j * NCHAN + pos) * 1000000 / FREQ);
+}
+
+static void check_chan(const struct adcs *s, const struct sink *k, int p,
+                       const uint16_t *words, uint32_t n, uint32_t from, uint32_t t0)
+{
+	static uint16_t ref[REF_MAX];
+	struct adcs_chan_config c;
+	uint32_t num, b;
+
+	c.chan = s->f[p].chan;
+	c.order = s->f[p].order;
+	c.ratio = s->f[p].ratio;
+	num = reference(words, n, p, &c, ref);
+	BENCH_CHECK(k->num[p] >= from + num);
+	BENCH_CHECK(memcmp(&k->data[p][from], ref, num * sizeof(ref[0])) == 0);
+
+	for (b = 0; b * ADCS_BLOCK_SAMPLES < num; b++)
+		BENCH_CHECK(k->t_first[p][from / ADCS_BLOCK_SAMPLES + b] ==
+		            out_time(s, p, b * ADCS_BLOCK_SAMPLES, t0));
+}
+
+static void test_stream(void)
+{
+	static struct adcs s;
+	static struct adcs_block ring[RING];
+	static struct sink k;
+	uint8_t order[NCHAN];
+	uint32_t i, n;
+	int p;
+
+	srand(49);
+	memset(&k, 0, sizeof(k));
+	BENCH_CHECK(adcs_init(&s, FREQ, chans, NCHAN, ring, RING) == 0);
+	for (p = 0; p < NCHAN; p++) {
+		order[p] = s.f[p].chan;
+		BENCH_CHECK(p == 0 || order[p] > order[p - 1]);
+	}
+	record(fifo, SAMPLES, order);
+
+	adcs_start(&s, T0);
+	for (i = 0; i < SAMPLES; i += n) {
+		n = rand() % 64 + 1;
+		if (n > SAMPLES - i)
+			n = SAMPLES - i;
+		adcs_push(&s, &fifo[i], n);
+		if (rand() % 4 == 0)
+			drain(&s, &k);
+	}
+	adcs_flush(&s);
+	drain(&s, &k);
+
+	for (p = 0; p < NCHAN; p++) {
+		check_chan(&s, &k, p, fifo, SAMPLES, 0, T0);
+		BENCH_CHECK(k.gaps[p] == 0);
+	}
+	BENCH_CHECK(s.stats.dropped == 0 && s.stats.conv == SAMPLES);
+	printf("%u conversions: %u %u %u %u samples per channel in %u blocks, ring depth max %u\n",
+	       s.stats.conv, k.num[0], k.num[1], k.num[2], k.num[3],
+	       s.stats.blocks, s.stats.depth_max);
+}
+
+static void test_gap(void)
+{
+	static struct adcs s;
+	static struct adcs_block ring[RING];
+	static struct sink k;
+	uint32_t seq[NCHAN], first = 10000 + 3;     /* in the middle of a cycle */
+	uint8_t order[NCHAN];
+	int p;
+
+	memset(&k, 0, sizeof(k));
+	BENCH_CHECK(adcs_init(&s, FREQ, chans, NCHAN, ring, RING) == 0);
+	for (p = 0; p < NCHAN; p++)
+		order[p] = s.f[p].chan;
+	record(fifo, SAMPLES, order);
+
+	adcs_start(&s, T0);
+	feed(&s, &k, fifo, first);
+	BENCH_CHECK(k.short_blocks == 0);
+
+	/* overrun: what was filled is published, the cycle starts again */
+	adcs_gap(&s, 777777);
+	drain(&s, &k);
+	BENCH_CHECK(k.short_blocks == NCHAN);
+	for (p = 0; p < NCHAN; p++)
+		check_chan(&s, &k, p, fifo, first, 0, T0);
+
+	memcpy(seq, k.seq, sizeof(seq));
+	memset(&k, 0, sizeof(k));
+	memcpy(k.seq, seq, sizeof(seq));
+	feed(&s, &k, fifo, SAMPLES);
+	adcs_flush(&s);
+	drain(&s, &k);
+	for (p = 0; p < NCHAN; p++) {
+		check_chan(&s, &k, p, fifo, SAMPLES, 0, 777777);
+		BENCH_CHECK(k.gaps[p] == 1);
+	}
+	BENCH_CHECK(s.stats.gaps == 1 && s.stats.dropped == 0);
+}
+
+/* no reader: the ring fills up, the next blocks are lost and counted */
+static void test_full(void)
+{
+	static struct adcs s;
+	static struct adcs_block ring[4];
+	static struct sink k;
+	static const struct adcs_chan_config one = { 2, 1, 1 };
+	uint16_t words[ADCS_BLOCK_SAMPLES * 10];
+	struct adcs_block *b;
+	uint32_t i;
+
+	for (i = 0; i < ADCS_BLOCK_SAMPLES * 10; i++)
+		words[i] = i;
+	memset(&k, 0, sizeof(k));
+	BENCH_CHECK(adcs_init(&s, FREQ, &one, 1, ring, 4) == 0);
+	adcs_start(&s, 0);
+	BENCH_CHECK(adcs_push(&s, words, ADCS_BLOCK_SAMPLES * 6) == 4);
+	BENCH_CHECK(adcs_count(&s) == 4 && s.stats.dropped == 2);
+
+	drain(&s, &k);
+	BENCH_CHECK(k.gaps[0] == 0 && k.num[0] == ADCS_BLOCK_SAMPLES * 4);
+	BENCH_CHECK(adcs_push(&s, &words[ADCS_BLOCK_SAMPLES * 6], ADCS_BLOCK_SAMPLES) == 1);
+	b = adcs_peek(&s);
+	BENCH_CHECK(b->seq == 6 && (b->flags & ADCS_BLOCK_GAP));
+	BENCH_CHECK(b->data[0] == ADCS_BLOCK_SAMPLES * 6);
+	adcs_release(&s);
+	BENCH_CHECK(adcs_push(&s, &words[ADCS_BLOCK_SAMPLES * 7], ADCS_BLOCK_SAMPLES) == 1);
+	b = adcs_peek(&s);
+	BENCH_CHECK(b->seq == 7 && !(b->flags & ADCS_BLOCK_GAP));
+	BENCH_CHECK(s.stats.depth_max == 4);
+}
+
+static void test_invalid(void)
+{
+	static struct adcs s;
+	static struct adcs_block ring[8];
+	struct adcs_chan_config c[2] = { { 1, 1, 1 }, { 1, 1, 1 } };
+
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == -1);     /* twice */
+	c[1].chan = 9;
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == -1);
+	c[1].chan = 2;
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 6) == -1);     /* not a power of 2 */
+	BENCH_CHECK(adcs_init(&s, 0, c, 2, ring, 8) == -1);
+	c[1].order = 4;
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == -1);
+	c[1].order = 3;
+	c[1].ratio = 102;   /* 102^3 > 2^20 */
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == -1);
+	c[1].ratio = 101;
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == 0);
+	c[1].ratio = 0;
+	BENCH_CHECK(adcs_init(&s, FREQ, c, 2, ring, 8) == -1);
+}
+
+/* the interrupt drains ADC_FIFO_LEVEL samples at a time */
+static void bench_push(void)
+{
+	static struct adcs s;
+	static struct adcs_block ring[RING];
+	uint8_t order[NCHAN];
+	uint32_t i, n = 0;
+	uint64_t t;
+	int p;
+
+	BENCH_CHECK(adcs_init(&s, FREQ, chans, NCHAN, ring, RING) == 0);
+	for (p = 0; p < NCHAN; p++)
+		order[p] = s.f[p].chan;
+	record(fifo, SAMPLES, order);
+	adcs_start(&s, 0);
+
+	t = bench_now_ns();
+	for (i = 0; i < 50; i++) {
+		uint32_t j;
+
+		for (j = 0; j < SAMPLES; j += 32) {
+			adcs_push(&s, &fifo[j], 32);
+			while (adcs_peek(&s))
+				adcs_release(&s);
+		}
+		n += SAMPLES;
+	}
+	bench_report("adcs_push 4 chans, 32 a burst", n, bench_now_ns() - t);
+	printf("at %u conversions/s: %u interrupts/s draining by 32, %u for a sample each\n",
+	       FREQ, FREQ / 32, FREQ);
+}
+
+int main(void)
+{
+	test_stream();
+	test_gap();
+	test_full();
+	test_invalid();
+	bench_push();
+	printf("adc stream checks passed\n");
+	return 0;
+}
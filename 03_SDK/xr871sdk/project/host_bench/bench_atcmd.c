@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * AT command layer (src/atcmd) fed by a UART capture: the queue callback
+ * hands the capture to at_queue in chunks of random size like the serial
+ * driver does, and goes idle where the host would wait. The capture mixes
+ * plain commands, unknown ones, blank lines, AT+S.SOCKW with its payload
+ * and a data mode session left by the escape sequence. Every command must
+ * get its response and every payload byte must reach the socket callback
+ * in order, in data mode flushed by AT_MODE_FLUSH_SIZE or on idle. Then
+ * the sustained throughput of command lines, of AT+S.SOCKW and of data
+ * mode against what a 921600 baud UART delivers.
+ */
+
+#include <string.h>
+#include <setjmp.h>
+#include "atcmd/at_command.h"
+#include "at_private.h"
+#include "bench.h"
+
+#define CAP_SIZE        (8 * 1024 * 1024)
+#define MAX_IDLES       4096
+#define MIX_ROUNDS      200
+#define COST_LINES      200000
+#define COST_BYTES      (4 * 1024 * 1024)
+#define COST_CHUNK      256
+#define SOCKW_LEN       4096
+#define UART_BPS        (921600 / 10)   /* 8N1 */
+
+static const char escape_seq[] = "at+s.";
+
+/* the UART capture and what it should produce */
+static struct {
+	uint8_t        *buf;
+	uint32_t        len;
+	uint32_t        idle[MAX_IDLES];    /* offsets where the line goes idle */
+	uint32_t        idles;
+	uint8_t        *expect;             /* payload sent to the socket */
+	uint32_t        expect_len;
+	uint32_t        oks;
+	uint32_t        errors;
+	uint32_t        sockws;             /* ACC_SOCKW calls */
+	uint32_t        flushes;            /* ACC_MODE calls with data */
+} g_cap;
+
+/* the replay */
+static struct {
+	jmp_buf         done;
+	uint32_t        pos;
+	uint32_t        next_idle;
+	uint32_t        chunk_max;
+	uint8_t        *sink;
+	uint32_t        sink_len;
+	uint32_t        oks;
+	uint32_t        errors;
+	uint32_t        sockws;
+	uint32_t        flushes;
+	uint32_t        mode_max;
+} g_rep;
+
+static void cap_put(const void *data, uint32_t len)
+{
+	BENCH_CHECK(g_cap.len + len <= CAP_SIZE);
+	memcpy(g_cap.buf + g_cap.len, data, len);
+	g_cap.len += len;
+}
+
+static void cap_line(const char *line, int ok)
+{
+	cap_put(line, strlen(line));
+	if (ok > 0)
+		g_cap.oks++;
+	else if (ok < 0)
+		g_cap.errors++;
+}
+
+static void cap_idle(void)
+{
+	BENCH_CHECK(g_cap.idles < MAX_IDLES);
+	g_cap.idle[g_cap.idles++] = g_cap.len;
+}
+
+static void cap_payload(uint32_t len, uint32_t seed)
+{
+	uint32_t i;
+
+	BENCH_CHECK(g_cap.len + len <= CAP_SIZE);
+	for (i = 0; i < len; i++) {
+		seed = seed * 1103515245 + 12345;
+		g_cap.buf[g_cap.len + i] = seed >> 16;
+	}
+	memcpy(g_cap.expect + g_cap.expect_len, g_cap.buf + g_cap.len, len);
+	g_cap.len += len;
+	g_cap.expect_len += len;
+}
+
+static void cap_sockw(uint32_t len, uint32_t seed)
+{
+	char line[32];
+
+	sprintf(line, "AT+S.SOCKW=00,%u\r\n", len);
+	cap_line(line, 1);
+	cap_payload(len, seed);
+	g_cap.sockws += (len + AT_SOCKET_BUFFER_SIZE - 1) / AT_SOCKET_BUFFER_SIZE;
+}
+
+/* the host waits for "Enter data mode", and leaves by the escape sequence
+ * between two idle periods */
+static void cap_data_mode(uint32_t len, uint32_t seed)
+{
+	cap_line("AT+S.\r\n", 1);
+	cap_idle();
+	cap_payload(len, seed);
+	cap_idle();
+	cap_line(escape_seq, 0);
+	cap_idle();
+	g_cap.flushes += (len + AT_MODE_FLUSH_SIZE - 1) / AT_MODE_FLUSH_SIZE;
+}
+
+static void cap_reset(void)
+{
+	g_cap.len = 0;
+	g_cap.idles = 0;
+	g_cap.expect_len = 0;
+	g_cap.oks = 0;
+	g_cap.errors = 0;
+	g_cap.sockws = 0;
+	g_cap.flushes = 0;
+}
+
+/* at_queue_callback_t, the serial driver handing over what it received */
+static s32 serial_read(u8 *buf, s32 size)
+{
+	uint32_t len;
+
+	if (g_rep.next_idle < g_cap.idles && g_cap.idle[g_rep.next_idle] == g_rep.pos) {
+		g_rep.next_idle++;
+		return 0;
+	}
+	if (g_rep.pos == g_cap.len)
+		longjmp(g_rep.done, 1); /* at_parse() never returns */
+
+	len = 1 + rand() % g_rep.chunk_max;
+	if (len > (uint32_t)size)
+		len = size;
+	if (len > g_cap.len - g_rep.pos)
+		len = g_cap.len - g_rep.pos;
+	if (g_rep.next_idle < g_cap.idles && len > g_cap.idle[g_rep.next_idle] - g_rep.pos)
+		len = g_cap.idle[g_rep.next_idle] - g_rep.pos;
+
+	memcpy(buf, g_cap.buf + g_rep.pos, len);
+	g_rep.pos += len;
+	return len;
+}
+
+static void sink_put(const u8 *buf, s32 len)
+{
+	BENCH_CHECK(g_rep.sink_len + len <= CAP_SIZE);
+	memcpy(g_rep.sink + g_rep.sink_len, buf, len);
+	g_rep.sink_len += len;
+}
+
+/* the application, a socket taking everything */
+static AT_ERROR_CODE handle_cb(AT_CALLBACK_CMD cmd, at_callback_para_t *para,
+                               at_callback_rsp_t *rsp)
+{
+	switch (cmd) {
+	case ACC_LOAD:
+		memset(para->cfg, 0, sizeof(*para->cfg));
+		strcpy(para->cfg->escape_seq, escape_seq);
+		break;
+	case ACC_SOCKW:
+		BENCH_CHECK(para->u.sockw.id == 0);
+		BENCH_CHECK(para->u.sockw.len <= AT_SOCKET_BUFFER_SIZE);
+		sink_put(para->u.sockw.buf, para->u.sockw.len);
+		g_rep.sockws++;
+		break;
+	case ACC_MODE:
+		if (para->u.mode.len > 0) {
+			sink_put(para->u.mode.buf, para->u.mode.len);
+			g_rep.flushes++;
+			if (para->u.mode.len > g_rep.mode_max)
+				g_rep.mode_max = para->u.mode.len;
+		}
+		break;
+	default:
+		break;
+	}
+	return AEC_OK;
+}
+
+/* the responses going back to the UART */
+static s32 dump_cb(u8 *buf, s32 len)
+{
+	if (len == 6 && !memcmp(buf, "\r\nOK\r\n", 6))
+		g_rep.oks++;
+	else if (len > 8 && !memcmp(buf, "\r\nERROR:", 8))
+		g_rep.errors++;
+	return len;
+}
+
+static uint64_t replay(uint32_t chunk_max)
+{
+	static u8 queue_buf[1024];
+	at_callback_t cb = { handle_cb, dump_cb };
+	u8 *sink = g_rep.sink;
+	uint64_t t0;
+
+	memset(&g_rep, 0, sizeof(g_rep));
+	g_rep.sink = sink;
+	g_rep.chunk_max = chunk_max;
+
+	at_queue_init(queue_buf, sizeof(queue_buf), serial_read);
+	BENCH_CHECK(at_init(&cb) == AEC_OK);
+
+	t0 = bench_now_ns();
+	if (setjmp(g_rep.done) == 0)
+		at_parse();
+	return bench_now_ns() - t0;
+}
+
+static void check_replay(void)
+{
+	BENCH_CHECK(g_rep.pos == g_cap.len);
+	BENCH_CHECK(g_rep.next_idle == g_cap.idles);
+	BENCH_CHECK(g_rep.oks == g_cap.oks);
+	BENCH_CHECK(g_rep.errors == g_cap.errors);
+	BENCH_CHECK(g_rep.sockws == g_cap.sockws);
+	BENCH_CHECK(g_rep.flushes == g_cap.flushes);
+	BENCH_CHECK(g_rep.mode_max <= AT_MODE_FLUSH_SIZE);
+	BENCH_CHECK(g_rep.sink_len == g_cap.expect_len);
+	BENCH_CHECK(memcmp(g_rep.sink, g_cap.expect, g_cap.expect_len) == 0);
+}
+
+static void test_mixed(void)
+{
+	static const uint32_t chunks[] = { 1, 7, 64, 1024 };
+	uint32_t i;
+
+	cap_reset();
+	for (i = 0; i < MIX_ROUNDS; i++) {
+		cap_line("AT\r\n", 1);
+		cap_line("AT+S.GCFG=escape_seq\r\n", 1);
+		cap_line("AT+S.NOPE\r\n", -1);
+		cap_line("\r\n", 0);                    /* blank, no response */
+		cap_line("AT+S.SOCKQ=00\n", 1);         /* unix line end */
+		cap_line("AT+S.GCFG=nokey\r", -1);      /* mac line end */
+		cap_sockw(1 + rand() % 3000, i);
+		if (i % 4 == 0)
+			cap_data_mode(1 + rand() % 5000, ~i);
+	}
+
+	for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+		replay(chunks[i]);
+		check_replay();
+	}
+}
+
+static void bench_cost(void)
+{
+	static const char *lines[] = {
+		"AT\r\n", "AT+S.SOCKQ=00\r\n", "AT+S.SOCKC=00\r\n",
+		"AT+S.WIFI=1\r\n", "AT+S.ROAM\r\n", "AT+ACT\r\n",
+	};
+	char name[48];
+	uint64_t ns;
+	uint32_t i;
+
+	/* command lines, the lookup and the parameters */
+	cap_reset();
+	for (i = 0; i < COST_LINES; i++)
+		cap_line(lines[i % (sizeof(lines) / sizeof(lines[0]))], 1);
+	ns = replay(COST_CHUNK);
+	check_replay();
+	bench_report("command lines", COST_LINES, ns);
+	printf("%-36s %9u lines/s\n", "  sustained",
+	       (uint32_t)((uint64_t)COST_LINES * 1000000000ULL / ns));
+
+	/* AT+S.SOCKW */
+	cap_reset();
+	for (i = 0; i < COST_BYTES / SOCKW_LEN; i++)
+		cap_sockw(SOCKW_LEN, i);
+	ns = replay(COST_CHUNK);
+	check_replay();
+	snprintf(name, sizeof(name), "sockw %u bytes", SOCKW_LEN);
+	bench_report(name, g_cap.len, ns);
+	printf("%-36s %9u KB/s %6.0fx uart\n", "  sustained",
+	       (uint32_t)((uint64_t)g_cap.len * 1000000ULL / ns),
+	       (double)g_cap.len * 1e9 / ns / UART_BPS);
+
+	/* data mode */
+	cap_reset();
+	cap_data_mode(COST_BYTES, 1);
+	ns = replay(COST_CHUNK);
+	check_replay();
+	bench_report("data mode", g_cap.len, ns);
+	printf("%-36s %9u KB/s %6.0fx uart\n", "  sustained",
+	       (uint32_t)((uint64_t)g_cap.len * 1000000ULL / ns),
+	       (double)g_cap.len * 1e9 / ns / UART_BPS);
+}
+
+int main(void)
+{
+	g_cap.buf = malloc(CAP_SIZE);
+	g_cap.expect = malloc(CAP_SIZE);
+	g_rep.sink = malloc(CAP_SIZE);
+	BENCH_CHECK(g_cap.buf && g_cap.expect && g_rep.sink);
+
+	srand(37);
+	test_mixed();
+	bench_cost();
+
+	free(g_rep.sink);
+	free(g_cap.expect);
+	free(g_cap.buf);
+
+	printf("atcmd checks passed\n");
+	return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Boot step scheduler (project/common/framework/boot_sched.c) over stub
+ * steps. The table of platform_init() is run with a delay injected into
+ * each step, on one, two and four workers: every step must start after its
+ * dependencies are done and never while a step using the same resource
+ * runs, the timeline must tell the same, and two workers must overlap the
+ * independent steps down to near the critical path. Then a dependency
+ * cycle, and the cost of the scheduler itself per step.
+ */
+
+#include <string.h>
+#include "kernel/os/os.h"
+#include "framework/boot_sched.h"
+#include "bench.h"
+
+/* the steps of platform_init(), project/common/framework/platform_init.c */
+enum {
+	STEP_CE, STEP_UART, STEP_SYS_CTRL, STEP_NET_CTRL, STEP_PRNG,
+	STEP_SYSINFO, STEP_CONSOLE, STEP_PM, STEP_NET, STEP_WDG,
+	STEP_LEVEL1, STEP_SPI, STEP_MMC, STEP_AUDIO, STEP_CEDARX, STEP_LEVEL2,
+	STEP_NUM
+};
+
+#define RES_PINMUX      (1U << 0)
+#define COST_STEPS      BOOT_STEP_MAX
+#define COST_ROUNDS     200
+
+/* the steps run */
+static struct {
+	OS_Mutex_t      lock;
+	const struct boot_step *steps;
+	uint32_t        delay[BOOT_STEP_MAX];   /* ms */
+	uint32_t        done;
+	uint32_t        busy_res;
+	uint32_t        running;
+	uint32_t        running_max;
+	uint32_t        runs[BOOT_STEP_MAX];
+	uint32_t        order[BOOT_STEP_MAX];   /* steps in start order */
+	uint32_t        started;
+} g_run;
+
+static void stub_run(uint32_t id)
+{
+	const struct boot_step *step = &g_run.steps[id];
+
+	OS_MutexLock(&g_run.lock, OS_WAIT_FOREVER);
+	BENCH_CHECK((step->deps & ~g_run.done) == 0);
+	BENCH_CHECK((step->res & g_run.busy_res) == 0);
+	g_run.busy_res |= step->res;
+	g_run.runs[id]++;
+	g_run.order[g_run.started++] = id;
+	if (++g_run.running > g_run.running_max)
+		g_run.running_max = g_run.running;
+	OS_MutexUnlock(&g_run.lock);
+
+	if (g_run.delay[id])
+		OS_MSleep(g_run.delay[id]);
+
+	OS_MutexLock(&g_run.lock, OS_WAIT_FOREVER);
+	g_run.busy_res &= ~step->res;
+	g_run.done |= 1U << id;
+	g_run.running--;
+	OS_MutexUnlock(&g_run.lock);
+}
+
+#define STUB(n)     static void stub_##n(void) { stub_run(n); }
+STUB(0)  STUB(1)  STUB(2)  STUB(3)  STUB(4)  STUB(5)  STUB(6)  STUB(7)
+STUB(8)  STUB(9)  STUB(10) STUB(11) STUB(12) STUB(13) STUB(14) STUB(15)
+STUB(16) STUB(17) STUB(18) STUB(19) STUB(20) STUB(21) STUB(22) STUB(23)
+STUB(24) STUB(25) STUB(26) STUB(27) STUB(28) STUB(29) STUB(30) STUB(31)
+
+static void (* const stubs[BOOT_STEP_MAX])(void) = {
+	stub_0,  stub_1,  stub_2,  stub_3,  stub_4,  stub_5,  stub_6,  stub_7,
+	stub_8,  stub_9,  stub_10, stub_11, stub_12, stub_13, stub_14, stub_15,
+	stub_16, stub_17, stub_18, stub_19, stub_20, stub_21, stub_22, stub_23,
+	stub_24, stub_25, stub_26, stub_27, stub_28, stub_29, stub_30, stub_31,
+};
+
+#define LEVEL1_DEPS (BOOT_DEP(STEP_CE) | BOOT_DEP(STEP_UART) |              \
+                     BOOT_DEP(STEP_SYS_CTRL) | BOOT_DEP(STEP_NET_CTRL) |    \
+                     BOOT_DEP(STEP_PRNG) | BOOT_DEP(STEP_SYSINFO) |         \
+                     BOOT_DEP(STEP_CONSOLE) | BOOT_DEP(STEP_PM) |           \
+                     BOOT_DEP(STEP_NET) | BOOT_DEP(STEP_WDG))
+#define LEVEL2_DEPS (BOOT_DEP(STEP_LEVEL1) | BOOT_DEP(STEP_SPI) |           \
+                     BOOT_DEP(STEP_MMC) | BOOT_DEP(STEP_AUDIO) |            \
+                     BOOT_DEP(STEP_CEDARX))
+
+/* cedarx disabled, like without __PRJ_CONFIG_XPLAYER */
+static const struct boot_step platform_steps[STEP_NUM] = {
+	[STEP_CE]       = { "ce",       stub_0,  0, 0 },
+	[STEP_UART]     = { "uart",     stub_1,  0, RES_PINMUX },
+	[STEP_SYS_CTRL] = { "sys_ctrl", stub_2,  0, 0 },
+	[STEP_NET_CTRL] = { "net_ctrl", stub_3,  BOOT_DEP(STEP_SYS_CTRL), 0 },
+	[STEP_PRNG]     = { "prng",     stub_4,  BOOT_DEP(STEP_CE), 0 },
+	[STEP_SYSINFO]  = { "sysinfo",  stub_5,  0, 0 },
+	[STEP_CONSOLE]  = { "console",  stub_6,  BOOT_DEP(STEP_SYS_CTRL) |
+	                                         BOOT_DEP(STEP_SYSINFO), 0 },
+	[STEP_PM]       = { "pm",       stub_7,  0, 0 },
+	[STEP_NET]      = { "net",      stub_8,  BOOT_DEP(STEP_CE) |
+	                                         BOOT_DEP(STEP_NET_CTRL) |
+	                                         BOOT_DEP(STEP_PRNG) |
+	                                         BOOT_DEP(STEP_SYSINFO) |
+	                                         BOOT_DEP(STEP_PM), 0 },
+	[STEP_WDG]      = { "wdg",      stub_9,  0, 0 },
+	[STEP_LEVEL1]   = { "level1",   stub_10, LEVEL1_DEPS, 0 },
+	[STEP_SPI]      = { "spi",      stub_11, 0, RES_PINMUX },
+	[STEP_MMC]      = { "mmc",      stub_12, BOOT_DEP(STEP_SYS_CTRL), RES_PINMUX },
+	[STEP_AUDIO]    = { "audio",    stub_13, BOOT_DEP(STEP_SYS_CTRL), RES_PINMUX },
+	[STEP_CEDARX]   = { "cedarx",   NULL,    0, 0 },
+	[STEP_LEVEL2]   = { "level2",   stub_15, LEVEL2_DEPS, 0 },
+};
+
+/* injected, in ms: the net core load and the SD card mount dominate */
+static const uint32_t platform_delay[STEP_NUM] = {
+	[STEP_CE] = 4, [STEP_UART] = 2, [STEP_SYS_CTRL] = 1, [STEP_NET_CTRL] = 3,
+	[STEP_PRNG] = 8, [STEP_SYSINFO] = 6, [STEP_CONSOLE] = 2, [STEP_PM] = 1,
+	[STEP_NET] = 40, [STEP_WDG] = 1, [STEP_LEVEL1] = 1, [STEP_SPI] = 2,
+	[STEP_MMC] = 30, [STEP_AUDIO] = 10, [STEP_LEVEL2] = 1,
+};
+
+static void run_reset(const struct boot_step *steps, const uint32_t *delay, uint32_t num)
+{
+	uint32_t i;
+
+	g_run.steps = steps;
+	memset(g_run.delay, 0, sizeof(g_run.delay));
+	if (delay)
+		memcpy(g_run.delay, delay, num * sizeof(delay[0]));
+	g_run.done = 0;
+	for (i = 0; i < num; i++) {
+		if (steps[i].func == NULL)
+			g_run.done |= BOOT_DEP(i);    /* disabled, done at once */
+	}
+	g_run.busy_res = 0;
+	g_run.running = 0;
+	g_run.running_max = 0;
+	g_run.started = 0;
+	memset(g_run.runs, 0, sizeof(g_run.runs));
+}
+
+/* the longest chain of delays ending with step @id */
+static uint32_t critical_path(const struct boot_step *steps, const uint32_t *delay,
+                              uint32_t id)
+{
+	uint32_t i, path, max = 0;
+
+	for (i = 0; i < id; i++) {
+		if (steps[id].deps & BOOT_DEP(i)) {
+			path = critical_path(steps, delay, i);
+			if (path > max)
+				max = path;
+		}
+	}
+	return max + (steps[id].func ? delay[id] : 0);
+}
+
+static uint32_t test_platform(uint32_t workers, int dump)
+{
+	struct boot_step_time tl[STEP_NUM];
+	uint32_t i, j, sum = 0, crit, wall;
+	uint64_t t;
+
+	run_reset(platform_steps, platform_delay, STEP_NUM);
+	t = bench_now_ns();
+	BENCH_CHECK(boot_sched_run(platform_steps, STEP_NUM, tl, workers,
+	                           OS_THREAD_PRIO_APP, 2048) == 0);
+	wall = (uint32_t)((bench_now_ns() - t) / 1000000);
+
+	for (i = 0; i < STEP_NUM; i++) {
+		const struct boot_step *step = &platform_steps[i];
+
+		if (step->func == NULL) {
+			BENCH_CHECK(tl[i].worker == BOOT_STEP_SKIPPED);
+			BENCH_CHECK(g_run.runs[i] == 0);
+			continue;
+		}
+		BENCH_CHECK(g_run.runs[i] == 1);
+		BENCH_CHECK(tl[i].worker < workers && tl[i].worker < 4);
+		BENCH_CHECK(tl[i].end - tl[i].start >= platform_delay[i]);
+		for (j = 0; j < STEP_NUM; j++) {
+			if ((step->deps & BOOT_DEP(j)) && platform_steps[j].func)
+				BENCH_CHECK(tl[j].end <= tl[i].start);
+		}
+		sum += platform_delay[i];
+	}
+	BENCH_CHECK(g_run.running_max <= workers);
+	crit = critical_path(platform_steps, platform_delay, STEP_LEVEL2);
+	BENCH_CHECK(wall >= crit);
+	if (workers == 1)
+		BENCH_CHECK(wall >= sum && g_run.running_max == 1);
+	else
+		BENCH_CHECK(wall < sum * 3 / 4 && g_run.running_max > 1);
+
+	printf("%u worker(s): %u ms, steps %u ms in sequence, critical path %u ms\n",
+	       workers, wall, sum, crit);
+	if (dump)
+		boot_sched_dump(platform_steps, STEP_NUM, tl);
+	return wall;
+}
+
+/* a and b wait for each other, c is independent */
+static void test_cycle(void)
+{
+	static const struct boot_step steps[] = {
+		{ "a", stub_0, BOOT_DEP(1), 0 },
+		{ "b", stub_1, BOOT_DEP(0), 0 },
+		{ "c", stub_2, 0, 0 },
+		{ "d", stub_3, BOOT_DEP(2), 0 },
+	};
+	struct boot_step_time tl[4];
+	uint32_t workers;
+
+	for (workers = 1; workers <= 2; workers++) {
+		run_reset(steps, NULL, 4);
+		BENCH_CHECK(boot_sched_run(steps, 4, tl, workers, OS_THREAD_PRIO_APP, 2048) == -1);
+		BENCH_CHECK(tl[0].worker == BOOT_STEP_SKIPPED && g_run.runs[0] == 0);
+		BENCH_CHECK(tl[1].worker == BOOT_STEP_SKIPPED && g_run.runs[1] == 0);
+		BENCH_CHECK(tl[2].worker != BOOT_STEP_SKIPPED && g_run.runs[2] == 1);
+		BENCH_CHECK(tl[3].worker != BOOT_STEP_SKIPPED && g_run.runs[3] == 1);
+	}
+	BENCH_CHECK(boot_sched_run(steps, 0, tl, 1, OS_THREAD_PRIO_APP, 2048) == -1);
+	BENCH_CHECK(boot_sched_run(steps, BOOT_STEP_MAX + 1, tl, 1,
+	                           OS_THREAD_PRIO_APP, 2048) == -1);
+}
+
+/* empty steps, in a chain or all independent */
+static void bench_cost(void)
+{
+	static struct boot_step steps[COST_STEPS];
+	static struct boot_step_time tl[COST_STEPS];
+	uint32_t i, r, workers, chain;
+	uint64_t t;
+	char name[48];
+
+	for (chain = 0; chain <= 1; chain++) {
+		for (i = 0; i < COST_STEPS; i++) {
+			steps[i].name = "stub";
+			steps[i].func = stubs[i];
+			steps[i].deps = (chain && i) ? BOOT_DEP(i - 1) : 0;
+			steps[i].res = 0;
+		}
+		for (workers = 1; workers <= 2; workers++) {
+			t = bench_now_ns();
+			for (r = 0; r < COST_ROUNDS; r++) {
+				run_reset(steps, NULL, COST_STEPS);
+				BENCH_CHECK(boot_sched_run(steps, COST_STEPS, tl, workers,
+				                           OS_THREAD_PRIO_APP, 2048) == 0);
+				BENCH_CHECK(g_run.done == 0xFFFFFFFFU);
+			}
+			snprintf(name, sizeof(name), "boot sched, %s, %u worker(s)",
+			         chain ? "chain" : "independent", workers);
+			bench_report(name, COST_ROUNDS * COST_STEPS, bench_now_ns() - t);
+		}
+	}
+}
+
+int main(void)
+{
+	uint32_t one, two;
+
+	BENCH_CHECK(OS_MutexCreate(&g_run.lock) == OS_OK);
+
+	one = test_platform(1, 0);
+	two = test_platform(2, 1);
+	test_platform(4, 0);
+	BENCH_CHECK(two < one);
+	test_cycle();
+	bench_cost();
+
+	OS_MutexDelete(&g_run.lock);
+	printf("boot sched checks passed\n");
+	return 0;
+}
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Camera frame pool (src/driver/component/csi_camera/frame_pool.c) fed by
+ * a simulated CSI: frames of random size cut in FIFO loads as the
+ * interrupt hands them over, JPEG ones padded after their EOI, some too
+ * large, broken or cut by a FIFO overflow. Readers of random speed take
+ * and put back frames meanwhile, each frame got must be the latest
+ * published and its content must stay intact until put back. Then the
+ * frame to network latency, and the cost of a frame through the pool.
+ */
+
+#include <string.h>
+#include "driver/component/csi_camera/frame_pool.h"
+#include "bench.h"
+
+#define FIFO            512
+#define BUF_SIZE        (16 * 1024)
+#define NBUF            4
+#define READERS         3
+#define ROUNDS          20000
+
+static uint8_t mem[NBUF * BUF_SIZE];
+static uint8_t frame_data[BUF_SIZE + 4 * FIFO];
+
+enum {
+	GEN_OK,
+	GEN_BIG,        /* larger than a buffer */
+	GEN_NO_SOI,
+	GEN_NO_EOI,
+	GEN_OVERFLOW,   /* FIFO overflow in the middle */
+};
+
+static uint8_t gen_byte(uint32_t tag, uint32_t i)
+{
+	uint8_t b = (uint8_t)((tag * 131 + i * 7) ^ (i >> 5));
+
+	/* no marker in the body */
+	return b == 0xFF ? 0xFE : b;
+}
+
+/*
+ * The bytes the sensor sends for frame tag: the picture of len bytes,
+ * the tag after SOI, then the padding of the last FIFO. Returns the
+ * length sent.
+ */
+static uint32_t gen_frame(uint8_t *out, uint32_t tag, uint32_t len, uint32_t pad, int jpeg, int kind)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		out[i] = gen_byte(tag, i);
+	if (jpeg) {
+		out[0] = 0xFF;
+		out[1] = 0xD8;
+		out[len - 2] = 0xFF;
+		out[len - 1] = 0xD9;
+		if (kind == GEN_NO_SOI)
+			out[1] = 0;
+		if (kind == GEN_NO_EOI)
+			out[len - 1] = 0;
+	}
+	memcpy(out + 2, &tag, 4);
+	memset(out + len, 0, pad);
+	return len + pad;
+}
+
+static void check_frame(const struct frame *f, int jpeg)
+{
+	uint32_t tag, i;
+
+	BENCH_CHECK(f->len >= 8);
+	memcpy(&tag, f->buf + 2, 4);
+	for (i = 6; i < f->len - 2; i++)
+		BENCH_CHECK(f->buf[i] == gen_byte(tag, i));
+	if (jpeg) {
+		BENCH_CHECK(f->buf[0] == 0xFF && f->buf[1] == 0xD8);
+		BENCH_CHECK(f->buf[f->len - 2] == 0xFF && f->buf[f->len - 1] == 0xD9);
+	}
+}
+
+/*
+ * What the CSI interrupt does with a frame: FIFO loads moved to where the
+ * pool says, or dropped, then the frame done.
+ */
+static struct frame *csi_frame(struct frame_pool *p, const uint8_t *data, uint32_t n,
+                               uint32_t overflow_at, uint32_t t_us)
+{
+	uint32_t off, len;
+	uint8_t *dst;
+
+	for (off = 0; off < n; off += len) {
+		len = n - off < FIFO ? n - off : FIFO;
+		if (off == overflow_at) {
+			frame_pool_abort(p);
+			continue;
+		}
+		dst = frame_pool_write(p, len);
+		if (dst) {
+			BENCH_CHECK(dst >= mem && dst + len <= mem + sizeof(mem));
+			memcpy(dst, data + off, len);
+		}
+	}
+	return frame_pool_done(p, t_us);
+}
+
+struct reader {
+	struct frame   *f;
+	uint32_t        seq;
+	uint8_t         copy[BUF_SIZE];    /* to tell the frame was not touched */
+	int             speed;             /* rounds it keeps a frame */
+	int             left;
+};
+
+static void run_pool(int jpeg)
+{
+	static struct frame_pool p;
+	static struct reader rd[READERS];
+	struct frame_pool_stats st;
+	uint32_t tag = 0, expect_frames = 0, expect_bad = 0, expect_over = 0;
+	uint32_t expect_lost = 0, got = 0, last_seq = 0, sent = 0;
+	uint32_t lat_sum = 0, lat_max = 0, lat;
+	struct frame *pub, *latest = NULL;
+	uint32_t r, i, len, pad, n, over_at;
+	int kind;
+
+	srand(jpeg ? 7 : 3);
+	BENCH_CHECK(frame_pool_init(&p, mem, BUF_SIZE, NBUF, jpeg) == 0);
+	memset(rd, 0, sizeof(rd));
+	/* none quick enough to take every frame */
+	rd[0].speed = 2;
+	rd[1].speed = 5;
+	rd[2].speed = 13;
+
+	for (r = 0; r < ROUNDS; r++) {
+		/* one frame from the sensor */
+		kind = rand() % 16;
+		kind = kind < 11 ? GEN_OK : kind - 11;
+		if (!jpeg && (kind == GEN_NO_SOI || kind == GEN_NO_EOI))
+			kind = GEN_OK;
+		len = 64 + rand() % (BUF_SIZE - 64);
+		pad = jpeg ? rand() % FIFO : 0;
+		if (kind == GEN_BIG)
+			len = BUF_SIZE + 1 + rand() % (2 * FIFO);
+		else if (len + pad > BUF_SIZE)
+			pad = BUF_SIZE - len;
+		n = gen_frame(frame_data, ++tag, len, pad, jpeg, kind);
+
+		over_at = kind == GEN_OVERFLOW ? (n / 2) / FIFO * FIFO : ~0U;
+		{
+			/* a buffer is there if one is neither held nor the latest */
+			uint32_t busy = 0, k;
+
+			for (k = 0; k < NBUF; k++)
+				busy += p.f[k].state != FRAME_FREE;
+			/* an overflow in the first FIFO is before any buffer */
+			if (busy == NBUF && over_at != 0)
+				expect_lost++;
+			else if (kind == GEN_BIG || kind == GEN_OVERFLOW)
+				expect_over++;
+			else if (kind != GEN_OK)
+				expect_bad++;
+			else
+				expect_frames++;
+		}
+		pub = csi_frame(&p, frame_data, n, over_at, r * 100);
+		if (pub) {
+			BENCH_CHECK(pub->len == len);
+			BENCH_CHECK(pub->seq == last_seq + 1);
+			last_seq = pub->seq;
+			latest = pub;
+		}
+
+		/* the readers */
+		for (i = 0; i < READERS; i++) {
+			struct reader *x = &rd[i];
+
+			if (x->f && --x->left > 0)
+				continue;
+			if (x->f) {
+				BENCH_CHECK(memcmp(x->f->buf, x->copy, x->f->len) == 0);
+				/* published at the start of a round, sent in the middle */
+				lat = r * 100 + 50 - x->f->t_us;
+				BENCH_CHECK(lat % 100 == 50);
+				lat_sum += lat;
+				lat_max = lat > lat_max ? lat : lat_max;
+				sent++;
+				frame_pool_sent(&p, x->f, r * 100 + 50);
+				frame_pool_put(&p, x->f);
+				x->f = NULL;
+			}
+			x->f = frame_pool_get(&p, x->seq);
+			if (x->f == NULL) {
+				BENCH_CHECK(latest == NULL || latest->seq == x->seq);
+				continue;
+			}
+			BENCH_CHECK(x->f == latest);
+			BENCH_CHECK(x->f->seq > x->seq);
+			check_frame(x->f, jpeg);
+			memcpy(x->copy, x->f->buf, x->f->len);
+			x->seq = x->f->seq;
+			x->left = x->speed;
+			got++;
+		}
+	}
+
+	for (i = 0; i < READERS; i++) {
+		if (rd[i].f)
+			frame_pool_put(&p, rd[i].f);
+	}
+	/* only the latest is still kept */
+	for (i = 0, n = 0; i < NBUF; i++)
+		n += p.f[i].state != FRAME_FREE;
+	BENCH_CHECK(n == 1 && p.latest == latest && latest->state == FRAME_READY);
+
+	frame_pool_get_stats(&p, &st, 1);
+	BENCH_CHECK(st.frames == expect_frames);
+	BENCH_CHECK(st.no_buf == expect_lost);
+	BENCH_CHECK(st.overflow == expect_over);
+	BENCH_CHECK(st.bad_jpeg == expect_bad);
+	BENCH_CHECK(st.sent == sent && sent + READERS >= got);
+	BENCH_CHECK(st.lat_sum_us == lat_sum && st.lat_max_us == lat_max);
+	printf("%s: %u frames, %u got, %u no buf, %u overflow, %u bad, %u stale,"
+	       " latency avg %u max %u\n",
+	       jpeg ? "jpeg" : "raw", st.frames, got, st.no_buf, st.overflow,
+	       st.bad_jpeg, st.stale, st.lat_sum_us / st.sent, st.lat_max_us);
+
+	frame_pool_get_stats(&p, &st, 0);
+	BENCH_CHECK(st.frames == 0 && st.sent == 0);
+}
+
+/* every buffer held: the frame is skipped as a whole, not its end only */
+static void test_skip(void)
+{
+	static struct frame_pool p;
+	struct frame *f[3];
+	struct frame_pool_stats st;
+	uint32_t n;
+
+	BENCH_CHECK(frame_pool_init(&p, mem, BUF_SIZE, 3, 1) == 0);
+	n = gen_frame(frame_data, 1, 3000, 100, 1, GEN_OK);
+	BENCH_CHECK(csi_frame(&p, frame_data, n, ~0U, 0) != NULL);
+	f[0] = frame_pool_get(&p, 0);
+	BENCH_CHECK(frame_pool_get(&p, f[0]->seq) == NULL);
+	BENCH_CHECK(csi_frame(&p, frame_data, n, ~0U, 0) != NULL);
+	f[1] = frame_pool_get(&p, f[0]->seq);
+	f[2] = frame_pool_get(&p, 0);
+	BENCH_CHECK(f[1] == f[2] && f[1]->ref == 2);
+	BENCH_CHECK(csi_frame(&p, frame_data, n, ~0U, 0) != NULL);
+
+	/* f[0] and f[1] held, the third is the latest */
+	BENCH_CHECK(frame_pool_write(&p, FIFO) == NULL);
+	frame_pool_put(&p, f[0]);
+	BENCH_CHECK(frame_pool_write(&p, FIFO) == NULL);
+	BENCH_CHECK(frame_pool_done(&p, 0) == NULL);
+	BENCH_CHECK(csi_frame(&p, frame_data, n, ~0U, 0) != NULL);
+
+	frame_pool_put(&p, f[1]);
+	BENCH_CHECK(f[1]->state == FRAME_READY);
+	frame_pool_put(&p, f[2]);
+	BENCH_CHECK(f[1]->state == FRAME_FREE);
+
+	frame_pool_get_stats(&p, &st, 0);
+	BENCH_CHECK(st.frames == 4 && st.no_buf == 1 && st.stale == 1);
+
+	BENCH_CHECK(frame_pool_init(&p, mem, BUF_SIZE, 1, 0) < 0);
+	BENCH_CHECK(frame_pool_init(&p, mem, BUF_SIZE, FRAME_POOL_MAX + 1, 0) < 0);
+	BENCH_CHECK(frame_pool_init(&p, mem, 0, 2, 0) < 0);
+}
+
+static void bench_frame(void)
+{
+	static struct frame_pool p;
+	struct frame *f;
+	uint32_t i, n, seq = 0;
+	const uint32_t frames = 20000;
+	uint64_t t0;
+
+	frame_pool_init(&p, mem, BUF_SIZE, NBUF, 1);
+	n = gen_frame(frame_data, 1, BUF_SIZE - 300, 200, 1, GEN_OK);
+	/* the pool only, as if the DMA had already moved the bytes */
+	for (i = 0; i < NBUF; i++)
+		memcpy(mem + i * BUF_SIZE, frame_data, n);
+	t0 = bench_now_ns();
+	for (i = 0; i < frames; i++) {
+		uint32_t off, len;
+
+		for (off = 0; off < n; off += len) {
+			len = n - off < FIFO ? n - off : FIFO;
+			frame_pool_write(&p, len);
+		}
+		frame_pool_done(&p, i);
+		f = frame_pool_get(&p, seq);
+		BENCH_CHECK(f != NULL);
+		seq = f->seq;
+		frame_pool_sent(&p, f, i);
+		frame_pool_put(&p, f);
+	}
+	bench_report("frame_pool 16 KB jpeg frame", frames, bench_now_ns() - t0);
+}
+
+int main(void)
+{
+	run_pool(1);
+	run_pool(0);
+	test_skip();
+	bench_frame();
+	printf("frame pool checks passed\n");
+	return 0;
+}
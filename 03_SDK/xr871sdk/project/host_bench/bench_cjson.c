@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "cjson/cJSON.h"
+#include "bench.h"
+
+#define CJSON_ITEMS		64
+#define CJSON_ROUNDS	2000
+
+static cJSON *build_doc(void)
+{
+	cJSON *root, *arr, *item;
+	char name[16];
+	int i;
+
+	root = cJSON_CreateObject();
+	cJSON_AddStringToObject(root, "device", "xr871");
+	cJSON_AddNumberToObject(root, "version", 3);
+	arr = cJSON_CreateArray();
+	for (i = 0; i < CJSON_ITEMS; i++) {
+		item = cJSON_CreateObject();
+		snprintf(name, sizeof(name), "sensor%d", i);
+		cJSON_AddStringToObject(item, "name", name);
+		cJSON_AddNumberToObject(item, "value", i * 1.5);
+		cJSON_AddTrueToObject(item, "valid");
+		cJSON_AddItemToArray(arr, item);
+	}
+	cJSON_AddItemToObject(root, "sensors", arr);
+	return root;
+}
+
+int main(void)
+{
+	cJSON *root;
+	char *text;
+	size_t len;
+	uint64_t t;
+	int i;
+
+	t = bench_now_ns();
+	for (i = 0; i < CJSON_ROUNDS; i++) {
+		root = build_doc();
+		cJSON_Delete(root);
+	}
+	bench_report("cJSON build and delete", CJSON_ROUNDS, bench_now_ns() - t);
+
+	root = build_doc();
+	t = bench_now_ns();
+	for (i = 0; i < CJSON_ROUNDS; i++) {
+		text = cJSON_PrintUnformatted(root);
+		free(text);
+	}
+	bench_report("cJSON print", CJSON_ROUNDS, bench_now_ns() - t);
+
+	text = cJSON_PrintUnformatted(root);
+	len = strlen(text);
+	cJSON_Delete(root);
+
+	t = bench_now_ns();
+	for (i = 0; i < CJSON_ROUNDS; i++) {
+		root = cJSON_Parse(text);
+		BENCH_CHECK(root != NULL);
+		cJSON_Delete(root);
+	}
+	bench_report("cJSON parse", CJSON_ROUNDS, bench_now_ns() - t);
+	printf("%-36s %9zu bytes\n", "document", len);
+
+	root = cJSON_Parse(text);
+	BENCH_CHECK(cJSON_GetArraySize(cJSON_GetObjectItem(root, "sensors")) == CJSON_ITEMS);
+	cJSON_Delete(root);
+	free(text);
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Section body codecs (src/image/decomp_*.c) on net.bin, compressed by the
+ * Makefile with the options of project.mk: decode throughput and ratio of
+ * lz4 and xz, fed in chunks of the flash read size. Then the lz4 stream
+ * split at any byte, ended by an end mark or by padding, and truncated.
+ */
+
+#include <string.h>
+#include "image/decomp.h"
+#include "bench.h"
+
+#define BIN_NAME        "net.bin"
+#define CHUNK           (4 * 1024)      /* DECOMP_INBUF_SIZE */
+#define ROUNDS          20
+#define PAD             64
+
+struct blob {
+	uint8_t *data;
+	uint32_t len;
+};
+
+static struct blob bin, lz4, xz;
+static uint8_t *out;
+
+static void load(struct blob *b, const char *name)
+{
+	FILE *f = fopen(name, "rb");
+	long len;
+
+	BENCH_CHECK(f != NULL);
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	b->data = malloc(len);
+	BENCH_CHECK(b->data != NULL);
+	BENCH_CHECK(fread(b->data, 1, len, f) == (size_t)len);
+	b->len = len;
+	fclose(f);
+}
+
+/* decode in chunks of chunk bytes, return the last result */
+static image_codec_ret_t decode(const image_codec_t *codec, const uint8_t *in,
+                                uint32_t len, uint32_t chunk, uint32_t *out_len)
+{
+	image_codec_ret_t ret = IMAGE_CODEC_MORE;
+	uint32_t off, n;
+	void *dec;
+
+	memset(out, 0, bin.len);
+	dec = codec->init(out, bin.len + 1);
+	BENCH_CHECK(dec != NULL);
+	for (off = 0; off < len && ret == IMAGE_CODEC_MORE; off += n) {
+		n = len - off < chunk ? len - off : chunk;
+		ret = codec->run(dec, in + off, n, off + n == len);
+	}
+	*out_len = codec->out_len(dec);
+	codec->deinit(dec);
+	return ret;
+}
+
+static void check_decode(const image_codec_t *codec, const uint8_t *in,
+                         uint32_t len, uint32_t chunk)
+{
+	uint32_t out_len;
+
+	BENCH_CHECK(decode(codec, in, len, chunk, &out_len) == IMAGE_CODEC_END);
+	BENCH_CHECK(out_len == bin.len && memcmp(out, bin.data, bin.len) == 0);
+}
+
+static void bench_codec(const image_codec_t *codec, const struct blob *b)
+{
+	char name[48];
+	uint64_t t;
+	uint32_t i;
+
+	check_decode(codec, b->data, b->len, CHUNK);
+	t = bench_now_ns();
+	for (i = 0; i < ROUNDS; i++)
+		check_decode(codec, b->data, b->len, CHUNK);
+	t = bench_now_ns() - t;
+	snprintf(name, sizeof(name), "%s decode %s", codec->name, BIN_NAME);
+	bench_report(name, ROUNDS, t);
+	printf("  %u -> %u bytes, ratio %.1f%%, %.1f MB/s\n", b->len, bin.len,
+	       100.0 * b->len / bin.len, (double)bin.len * ROUNDS * 1000 / t);
+}
+
+static void test_lz4_stream_end(void)
+{
+	uint32_t out_len, chunk;
+	uint8_t *in, *end;
+
+	/* any split of the input */
+	for (chunk = 1; chunk <= 13; chunk += 3)
+		check_decode(&image_codec_lz4, lz4.data, lz4.len, chunk);
+
+	in = malloc(lz4.len + PAD);
+	BENCH_CHECK(in != NULL);
+	memcpy(in, lz4.data, lz4.len);
+	end = in + lz4.len;
+
+	/* end mark, then the padding of the body */
+	memset(end, 0, 4);
+	memset(end + 4, 0xFF, PAD - 4);
+	check_decode(&image_codec_lz4, in, lz4.len + PAD, CHUNK);
+	check_decode(&image_codec_lz4, in, lz4.len + PAD, 1);
+
+	/* padding only, as a block size too large or cut short */
+	memset(end, 0xFF, PAD);
+	check_decode(&image_codec_lz4, in, lz4.len + PAD, CHUNK);
+	check_decode(&image_codec_lz4, in, lz4.len + 3, CHUNK);
+
+	/* cut in a block */
+	BENCH_CHECK(decode(&image_codec_lz4, in, lz4.len - 1, CHUNK,
+	                   &out_len) == IMAGE_CODEC_ERROR);
+	free(in);
+}
+
+int main(void)
+{
+	load(&bin, BIN_NAME);
+	load(&lz4, BIN_NAME ".lz4");
+	load(&xz, BIN_NAME ".xz");
+	out = malloc(bin.len + 1);
+	BENCH_CHECK(out != NULL);
+
+	bench_codec(&image_codec_lz4, &lz4);
+	bench_codec(&image_codec_xz, &xz);
+	test_lz4_stream_end();
+
+	printf("decomp checks passed\n");
+	return 0;
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Lease table of the DHCP server (src/net/udhcp-0.9.8/leases.c) under 200
+ * simulated clients. The requests take the lease decisions of sendOffer(),
+ * sendACK() and the message switch of usr_dhcpd.c, without the packets,
+ * over a simulated clock and a simulated ARP probe. The probe of an
+ * address nobody has waits for the full timeout of arpping().
+ *
+ * The clients join in a burst, renew, reboot, and some of them leave
+ * while new ones come. Every client must hold its own address from the
+ * pool, and the hosts squatting in the pool must be reserved. Each free
+ * address is probed once. The table is then packed, the server
+ * restarted and the table reloaded, and the clients keep their leases.
+ * Last come the latency of each kind of request and the time spent
+ * waiting for probes.
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+#include "dhcpd.h"
+#include "dhcp_time.h"
+#include "files.h"
+#include "leases.h"
+#include "bench.h"
+
+#define POOL_START      0x0A00000AU     /* 10.0.0.10 */
+#define POOL_SIZE       210
+#define SERVER_IP       0x0A000001U
+#define CLIENTS         200
+#define CHURN           20
+#define MAX_CLIENTS     (CLIENTS + CHURN)
+#define LEASE_SECS      3600
+#define ARP_TIMEOUT_MS  2000            /* arpping() waits that long for nobody */
+#define COST_ROUNDS     50
+
+/* hosts with a static address inside the pool, they answer the probes */
+static const u_int32_t squatters[] = { 15, 50, 77, 120, 160 };
+#define SQUATTERS       (sizeof(squatters) / sizeof(squatters[0]))
+
+enum { REPLY_NONE, REPLY_ACK, REPLY_NAK };
+
+struct dhcpOfferedAddr *leases;
+struct server_config_t server_config;
+
+static time_t g_now = 1000000;
+static uint32_t g_probes;
+static uint64_t g_probe_wait_ms;
+
+static struct client {
+	u_int8_t  chaddr[16];
+	u_int32_t addr;                 /* leased, network order */
+} g_clients[MAX_CLIENTS];
+
+time_t dhcp_time(time_t *timer)
+{
+	if (timer)
+		*timer = g_now;
+	return g_now;
+}
+
+int arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interface)
+{
+	u_int32_t p = ntohl(yiaddr) - POOL_START;
+	unsigned int i;
+
+	g_probes++;
+	for (i = 0; i < SQUATTERS; i++) {
+		if (squatters[i] == p)
+			return 0;               /* answered at once */
+	}
+	g_probe_wait_ms += ARP_TIMEOUT_MS;
+	return 1;
+}
+
+static int pool_has(u_int32_t addr)
+{
+	return ntohl(addr) >= POOL_START && ntohl(addr) < POOL_START + POOL_SIZE;
+}
+
+static int is_squatter(u_int32_t addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < SQUATTERS; i++) {
+		if (htonl(POOL_START + squatters[i]) == addr)
+			return 1;
+	}
+	return 0;
+}
+
+/* DHCPDISCOVER, the address sendOffer() offers, 0 for none */
+static u_int32_t dhcp_discover(struct client *c, u_int32_t requested)
+{
+	struct dhcpOfferedAddr *lease;
+	u_int32_t yiaddr;
+
+	if ((lease = find_lease_by_chaddr(c->chaddr))) {
+		yiaddr = lease->yiaddr;
+	} else if (requested && pool_has(requested) &&
+	           (!(lease = find_lease_by_yiaddr(requested)) || lease_expired(lease))) {
+		yiaddr = requested;
+	} else {
+		yiaddr = find_address(0);
+		if (!yiaddr)
+			yiaddr = find_address(1);
+	}
+	if (!yiaddr || !add_lease(c->chaddr, yiaddr, server_config.offer_time))
+		return 0;
+	return yiaddr;
+}
+
+/* DHCPREQUEST, like usr_dhcpd.c, sendACK() leases the address */
+static int dhcp_request(struct client *c, u_int32_t requested, u_int32_t server_id,
+                        u_int32_t ciaddr)
+{
+	struct dhcpOfferedAddr *lease = find_lease_by_chaddr(c->chaddr);
+	u_int32_t yiaddr;
+
+	if (lease) {
+		yiaddr = lease->yiaddr;
+		if (server_id) {
+			/* SELECTING */
+			if (server_id != server_config.server || requested != yiaddr)
+				return REPLY_NONE;
+		} else if (requested) {
+			/* INIT-REBOOT */
+			if (requested != yiaddr)
+				return REPLY_NAK;
+		} else if (ciaddr != yiaddr) {
+			/* RENEWING or REBINDING */
+			return REPLY_NAK;
+		}
+		add_lease(c->chaddr, yiaddr, server_config.lease);
+		c->addr = yiaddr;
+		return REPLY_ACK;
+	}
+
+	if (!server_id && requested) {
+		/* INIT-REBOOT without a record */
+		if ((lease = find_lease_by_yiaddr(requested)) && lease_expired(lease)) {
+			lease_clear_chaddr(lease);
+			return REPLY_NONE;
+		}
+		return REPLY_NAK;
+	}
+	return REPLY_NONE;
+}
+
+/* DHCPDECLINE and DHCPRELEASE */
+static void dhcp_decline(struct client *c)
+{
+	struct dhcpOfferedAddr *lease = find_lease_by_chaddr(c->chaddr);
+
+	if (lease) {
+		lease_clear_chaddr(lease);
+		lease_set_expires(lease, time(0) + server_config.decline_time);
+	}
+	c->addr = 0;
+}
+
+static void dhcp_release(struct client *c)
+{
+	struct dhcpOfferedAddr *lease = find_lease_by_chaddr(c->chaddr);
+
+	if (lease)
+		lease_set_expires(lease, time(0));
+	c->addr = 0;
+}
+
+/* DISCOVER then REQUEST in the SELECTING state */
+static void dhcp_join(struct client *c)
+{
+	u_int32_t offer = dhcp_discover(c, 0);
+
+	BENCH_CHECK(offer != 0);
+	BENCH_CHECK(dhcp_request(c, offer, server_config.server, 0) == REPLY_ACK);
+	BENCH_CHECK(c->addr == offer);
+}
+
+static void server_start(void)
+{
+	memset(&server_config, 0, sizeof(server_config));
+	server_config.server = htonl(SERVER_IP);
+	server_config.start = htonl(POOL_START);
+	server_config.end = htonl(POOL_START + POOL_SIZE - 1);
+	server_config.max_leases = POOL_SIZE;
+	server_config.lease = LEASE_SECS;
+	server_config.decline_time = 3600;
+	server_config.conflict_time = 3600;
+	server_config.offer_time = 60;
+	server_config.min_lease = 60;
+	BENCH_CHECK(leases_init() == 0);
+}
+
+static void clients_reset(void)
+{
+	unsigned int i;
+
+	memset(g_clients, 0, sizeof(g_clients));
+	for (i = 0; i < MAX_CLIENTS; i++) {
+		g_clients[i].chaddr[0] = 0x02;
+		g_clients[i].chaddr[4] = i >> 8;
+		g_clients[i].chaddr[5] = i;
+	}
+	g_probes = 0;
+	g_probe_wait_ms = 0;
+}
+
+/* every client holding an address holds its own one, and the table agrees,
+ * returns the number of them */
+static unsigned int check_clients(unsigned int num)
+{
+	static uint8_t taken[POOL_SIZE];
+	struct dhcpOfferedAddr *lease;
+	unsigned int i, active = 0;
+	u_int32_t p;
+
+	memset(taken, 0, sizeof(taken));
+	for (i = 0; i < num; i++) {
+		struct client *c = &g_clients[i];
+
+		if (!c->addr)
+			continue;
+		BENCH_CHECK(pool_has(c->addr) && !is_squatter(c->addr));
+		p = ntohl(c->addr) - POOL_START;
+		BENCH_CHECK(!taken[p]);
+		taken[p] = 1;
+		lease = find_lease_by_chaddr(c->chaddr);
+		BENCH_CHECK(lease && lease->yiaddr == c->addr && !lease_expired(lease));
+		BENCH_CHECK(find_lease_by_yiaddr(c->addr) == lease);
+		active++;
+	}
+	return active;
+}
+
+/* the squatters' addresses are reserved for nobody */
+static void check_squatters(void)
+{
+	struct dhcpOfferedAddr *lease;
+	unsigned int i;
+
+	for (i = 0; i < SQUATTERS; i++) {
+		lease = find_lease_by_yiaddr(htonl(POOL_START + squatters[i]));
+		BENCH_CHECK(lease && !memcmp(lease->chaddr, blank_chaddr, 16));
+		BENCH_CHECK(!lease_expired(lease));
+	}
+}
+
+static void test_clients(void)
+{
+	static u_int8_t buf[POOL_SIZE * LEASE_RECORD_SIZE];
+	struct dhcpOfferedAddr *lease;
+	u_int32_t expires[CLIENTS], addr, declined;
+	unsigned int i, len;
+
+	server_start();
+	clients_reset();
+
+	/* a burst of clients joining, each free address is probed once */
+	for (i = 0; i < CLIENTS; i++)
+		dhcp_join(&g_clients[i]);
+	BENCH_CHECK(check_clients(CLIENTS) == CLIENTS);
+	BENCH_CHECK(g_probes == CLIENTS + SQUATTERS);
+	check_squatters();
+
+	/* renewing at T1, and rebooting clients asking for their address */
+	g_now += LEASE_SECS / 2;
+	for (i = 0; i < CLIENTS; i++) {
+		struct client *c = &g_clients[i];
+
+		if (i % 10 == 0)
+			BENCH_CHECK(dhcp_request(c, c->addr, 0, 0) == REPLY_ACK);
+		else
+			BENCH_CHECK(dhcp_request(c, 0, 0, c->addr) == REPLY_ACK);
+		BENCH_CHECK(find_lease_by_chaddr(c->chaddr)->expires == g_now + LEASE_SECS);
+	}
+	BENCH_CHECK(g_probes == CLIENTS + SQUATTERS);
+	addr = g_clients[0].addr;
+	BENCH_CHECK(dhcp_request(&g_clients[0], g_clients[1].addr, 0, 0) == REPLY_NAK);
+	BENCH_CHECK(dhcp_request(&g_clients[0], 0, 0, g_clients[1].addr) == REPLY_NAK);
+	g_clients[0].addr = addr;
+
+	/* some leave, new ones take the free addresses, then the released ones */
+	for (i = 0; i < CHURN; i++)
+		dhcp_release(&g_clients[i * 7]);
+	g_now++;
+	for (i = CLIENTS; i < CLIENTS + CHURN; i++)
+		dhcp_join(&g_clients[i]);
+	BENCH_CHECK(check_clients(MAX_CLIENTS) == CLIENTS);
+	check_squatters();
+
+	/* a new client finding its address taken after all */
+	declined = g_clients[CLIENTS].addr;
+	dhcp_decline(&g_clients[CLIENTS]);
+	BENCH_CHECK(dhcp_discover(&g_clients[CLIENTS], declined) != declined);
+	lease = find_lease_by_yiaddr(declined);
+	BENCH_CHECK(lease && !memcmp(lease->chaddr, blank_chaddr, 16) && !lease_expired(lease));
+	dhcp_release(&g_clients[CLIENTS]);
+	g_now++;
+
+	/* restart, keeping the leases */
+	for (i = 0; i < CLIENTS; i++) {
+		lease = find_lease_by_chaddr(g_clients[i].chaddr);
+		expires[i] = lease && g_clients[i].addr ? lease->expires : 0;
+	}
+	len = pack_leases(buf, sizeof(buf));
+	BENCH_CHECK(len == (CLIENTS - 1) * LEASE_RECORD_SIZE);
+	leases_deinit();
+	server_start();
+	unpack_leases(buf, len);
+	BENCH_CHECK(check_clients(MAX_CLIENTS) == CLIENTS - 1);
+	for (i = 0; i < CLIENTS; i++) {
+		if (expires[i])
+			BENCH_CHECK(find_lease_by_chaddr(g_clients[i].chaddr)->expires == expires[i]);
+	}
+
+	/* back after the lease ran out, the old address is still there */
+	g_now += 2 * LEASE_SECS;
+	addr = g_clients[1].addr;
+	BENCH_CHECK(dhcp_discover(&g_clients[1], 0) == addr);
+	BENCH_CHECK(dhcp_request(&g_clients[1], addr, server_config.server, 0) == REPLY_ACK);
+
+	leases_deinit();
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report_latency(const char *name, uint64_t *ns, uint32_t num)
+{
+	uint64_t sum = 0;
+	uint32_t i;
+
+	for (i = 0; i < num; i++)
+		sum += ns[i];
+	bench_report(name, num, sum);
+	qsort(ns, num, sizeof(ns[0]), cmp_u64);
+	printf("%-36s %9llu ns p50 %9llu ns p99 %9llu ns max\n", "  latency",
+	       (unsigned long long)ns[num / 2],
+	       (unsigned long long)ns[num * 99 / 100],
+	       (unsigned long long)ns[num - 1]);
+}
+
+static void bench_latency(void)
+{
+	static uint64_t join_ns[COST_ROUNDS * CLIENTS];
+	static uint64_t renew_ns[COST_ROUNDS * CLIENTS];
+	uint32_t r, i, n = 0;
+	uint64_t t, probe_wait = 0, probes = 0;
+
+	for (r = 0; r < COST_ROUNDS; r++) {
+		server_start();
+		clients_reset();
+		for (i = 0; i < CLIENTS; i++) {
+			t = bench_now_ns();
+			dhcp_join(&g_clients[i]);
+			join_ns[n + i] = bench_now_ns() - t;
+		}
+		probes += g_probes;
+		probe_wait += g_probe_wait_ms;
+		g_now += LEASE_SECS / 2;
+		for (i = 0; i < CLIENTS; i++) {
+			struct client *c = &g_clients[i];
+
+			t = bench_now_ns();
+			BENCH_CHECK(dhcp_request(c, 0, 0, c->addr) == REPLY_ACK);
+			renew_ns[n + i] = bench_now_ns() - t;
+		}
+		BENCH_CHECK(g_probes == CLIENTS + SQUATTERS);
+		n += CLIENTS;
+		leases_deinit();
+	}
+
+	report_latency("dhcpd join, 200 clients", join_ns, n);
+	report_latency("dhcpd renew, 200 clients", renew_ns, n);
+	printf("%-36s %9.2f probes %9.0f ms waited per join\n", "  arp",
+	       (double)probes / n, (double)probe_wait / n);
+}
+
+int main(void)
+{
+	test_clients();
+	bench_latency();
+
+	printf("dhcpd checks passed\n");
+	return 0;
+}
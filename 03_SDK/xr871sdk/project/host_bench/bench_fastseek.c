@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * FatFs fast seek and preallocation (src/fs/fatfs/ff.c) over the SD cache of
+ * sdmmc_diskio.c and a file backed card: random seeks in a fragmented media
+ * file with and without a cluster link map table, like fs_ctrl_open_media()
+ * sets up, then recording with and without the f_expand() preallocation of
+ * fs_ctrl_open_record(). Card commands are counted along the time. Then the
+ * link map table slots are checked to be released by a failing f_close().
+ */
+
+#include <string.h>
+#include "fs/fatfs/ff.h"
+#include "sd_image.h"
+#include "bench.h"
+
+#define IMAGE_SECTORS   (1024 * 1024)           /* 512 MB, sparse */
+#define SEC_PER_CLUS    8                       /* 4 KB clusters */
+#define CLUS_SIZE       (SEC_PER_CLUS * 512)
+#define MEDIA_SIZE      (4 * 1024 * 1024)
+#define SEEKS           4000
+#define READ_LEN        512
+#define RECORD_SIZE     (8 * 1024 * 1024)
+#define RECORD_CHUNK    (4 * 1024)
+#define CLMT_SIZE       (2 * (MEDIA_SIZE / CLUS_SIZE) + 4)
+
+static FATFS fs;
+static uint8_t buf[RECORD_CHUNK];
+static DWORD clmt[CLMT_SIZE];
+
+/* the content of the media file, byte at offset ofs */
+static uint8_t media_byte(uint32_t ofs)
+{
+	return (uint8_t)((ofs >> 9) * 31 + ofs);
+}
+
+static void fill(uint32_t ofs, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = media_byte(ofs + i);
+}
+
+static void report_cmds(const char *name, uint32_t ops, uint64_t ns)
+{
+	sd_image_stat st;
+
+	sd_image_get_stat(&st);
+	bench_report(name, ops, ns);
+	printf("  card: %u+%u reads (%u sectors), %u+%u writes (%u sectors)\n",
+	       st.read_single, st.read_multi, st.read_sectors,
+	       st.write_single, st.write_multi, st.write_sectors);
+}
+
+/* write the media file one cluster at a time, interleaved with another file */
+static void make_fragmented(void)
+{
+	FIL media, other;
+	uint32_t ofs;
+	UINT bw;
+
+	BENCH_CHECK(f_open(&media, "media.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+	BENCH_CHECK(f_open(&other, "other.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+	for (ofs = 0; ofs < MEDIA_SIZE; ofs += CLUS_SIZE) {
+		fill(ofs, CLUS_SIZE);
+		BENCH_CHECK(f_write(&media, buf, CLUS_SIZE, &bw) == FR_OK && bw == CLUS_SIZE);
+		BENCH_CHECK(f_write(&other, buf, CLUS_SIZE, &bw) == FR_OK && bw == CLUS_SIZE);
+	}
+	BENCH_CHECK(f_close(&other) == FR_OK);
+	BENCH_CHECK(f_close(&media) == FR_OK);
+}
+
+static void seek_read(int fast)
+{
+	uint8_t data[READ_LEN];
+	char name[48];
+	uint64_t t;
+	uint32_t i, ofs, seed = 1;
+	FIL f;
+	UINT br;
+
+	BENCH_CHECK(f_open(&f, "media.bin", FA_OPEN_EXISTING | FA_READ) == FR_OK);
+	if (fast) {
+		clmt[0] = CLMT_SIZE;
+		BENCH_CHECK(f_setclmt(&f, clmt) == FR_OK);
+		BENCH_CHECK(f_lseek(&f, CREATE_LINKMAP) == FR_OK);
+		/* every other cluster is the media's */
+		BENCH_CHECK(clmt[0] == 2 * (MEDIA_SIZE / CLUS_SIZE) + 2);
+	}
+
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	for (i = 0; i < SEEKS; i++) {
+		seed = seed * 1103515245 + 12345;
+		ofs = (seed >> 8) % (MEDIA_SIZE - READ_LEN);
+		BENCH_CHECK(f_lseek(&f, ofs) == FR_OK);
+		BENCH_CHECK(f_read(&f, data, READ_LEN, &br) == FR_OK && br == READ_LEN);
+		BENCH_CHECK(data[0] == media_byte(ofs) &&
+		            data[READ_LEN - 1] == media_byte(ofs + READ_LEN - 1));
+	}
+	snprintf(name, sizeof(name), "seek+read %u, %s", READ_LEN,
+	         fast ? "fast seek" : "FAT chain");
+	report_cmds(name, SEEKS, bench_now_ns() - t);
+	BENCH_CHECK(f_close(&f) == FR_OK);
+}
+
+static void record(int prealloc)
+{
+	char name[48];
+	uint64_t t;
+	uint32_t ofs;
+	FIL f;
+	UINT bw;
+
+	BENCH_CHECK(f_open(&f, "rec.bin", FA_CREATE_ALWAYS | FA_WRITE | FA_READ) == FR_OK);
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	if (prealloc)
+		BENCH_CHECK(f_expand(&f, RECORD_SIZE + RECORD_CHUNK, 1) == FR_OK);
+	for (ofs = 0; ofs < RECORD_SIZE; ofs += RECORD_CHUNK) {
+		fill(ofs, RECORD_CHUNK);
+		BENCH_CHECK(f_write(&f, buf, RECORD_CHUNK, &bw) == FR_OK && bw == RECORD_CHUNK);
+	}
+	/* as fs_ctrl_close_record() */
+	BENCH_CHECK(f_truncate(&f) == FR_OK);
+	BENCH_CHECK(f_close(&f) == FR_OK);
+	snprintf(name, sizeof(name), "record %u KB, %s", RECORD_SIZE / 1024,
+	         prealloc ? "f_expand" : "growing");
+	report_cmds(name, RECORD_SIZE / RECORD_CHUNK, bench_now_ns() - t);
+
+	BENCH_CHECK(f_open(&f, "rec.bin", FA_OPEN_EXISTING | FA_READ) == FR_OK);
+	BENCH_CHECK(f_size(&f) == RECORD_SIZE);
+	BENCH_CHECK(f_lseek(&f, RECORD_SIZE - RECORD_CHUNK) == FR_OK);
+	BENCH_CHECK(f_read(&f, buf, RECORD_CHUNK, &bw) == FR_OK && bw == RECORD_CHUNK);
+	BENCH_CHECK(buf[RECORD_CHUNK - 1] == media_byte(RECORD_SIZE - 1));
+	BENCH_CHECK(f_close(&f) == FR_OK);
+	BENCH_CHECK(f_unlink("rec.bin") == FR_OK);
+}
+
+/*
+ * A file failing to close must not keep its link map table slot, the table
+ * is freed by fs_ctrl_close_media() whatever f_close() returns.
+ */
+static void test_clmt_release(void)
+{
+	static DWORD tbl[_FS_CLMT_FILES][CLMT_SIZE];
+	static FIL failed[2 * _FS_CLMT_FILES];
+	FIL f[_FS_CLMT_FILES];
+	int round, i;
+	UINT bw;
+
+	for (round = 0; round < 2 * _FS_CLMT_FILES; round++) {
+		/* a dirty file closed while the card fails, then dropped */
+		BENCH_CHECK(f_open(&failed[round], "media.bin",
+		                   FA_OPEN_EXISTING | FA_READ | FA_WRITE) == FR_OK);
+		tbl[0][0] = CLMT_SIZE;
+		BENCH_CHECK(f_setclmt(&failed[round], tbl[0]) == FR_OK);
+		BENCH_CHECK(f_write(&failed[round], buf, 16, &bw) == FR_OK && bw == 16);
+		sd_image_fail_writes(1);
+		BENCH_CHECK(f_close(&failed[round]) != FR_OK);
+		sd_image_fail_writes(0);
+
+		/* all the slots are free again */
+		for (i = 0; i < _FS_CLMT_FILES; i++) {
+			BENCH_CHECK(f_open(&f[i], "media.bin", FA_OPEN_EXISTING | FA_READ) == FR_OK);
+			tbl[i][0] = CLMT_SIZE;
+			BENCH_CHECK(f_setclmt(&f[i], tbl[i]) == FR_OK);
+		}
+		for (i = 0; i < _FS_CLMT_FILES; i++)
+			BENCH_CHECK(f_close(&f[i]) == FR_OK);
+	}
+}
+
+int main(void)
+{
+	BENCH_CHECK(sd_image_open("fastseek.img", IMAGE_SECTORS) == 0);
+	BENCH_CHECK(sd_image_format(SEC_PER_CLUS) == 0);
+	BENCH_CHECK(f_mount(&fs, "", 1) == FR_OK);
+
+	make_fragmented();
+	seek_read(0);
+	seek_read(1);
+	record(0);
+	record(1);
+	test_clmt_release();
+
+	BENCH_CHECK(f_mount(NULL, "", 0) == FR_OK);
+	sd_image_close();
+	remove("fastseek.img");
+	printf("fast seek checks passed\n");
+	return 0;
+}
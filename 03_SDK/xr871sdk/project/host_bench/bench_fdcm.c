@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "image/fdcm.h"
+#include "flash_file.h"
+#include "bench.h"
+
+#define FDCM_AREA_ADDR	(0x10000)
+#define FDCM_AREA_SIZE	(4 * FLASH_FILE_ERASE_BLOCK)
+#define FDCM_ROUNDS		20000
+
+/* about the size of the sysinfo kept by the framework */
+typedef struct {
+	uint32_t seq;
+	uint8_t data[124];
+} bench_record;
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "flash.bin";
+	fdcm_handle_t *hdl;
+	bench_record rec, out;
+	flash_file_stat stat;
+	uint64_t t, t_read = 0;
+	uint32_t i;
+
+	BENCH_CHECK(flash_file_open(path) == 0);
+	hdl = fdcm_open(0, FDCM_AREA_ADDR, FDCM_AREA_SIZE);
+	BENCH_CHECK(hdl != NULL);
+	BENCH_CHECK(fdcm_erase(hdl) == 0);
+
+	memset(&rec, 0x5A, sizeof(rec));
+	t = bench_now_ns();
+	for (i = 0; i < FDCM_ROUNDS; i++) {
+		rec.seq = i;
+		BENCH_CHECK(fdcm_write(hdl, &rec, sizeof(rec)) == sizeof(rec));
+		if ((i & 0xFF) == 0) {
+			uint64_t r = bench_now_ns();
+			BENCH_CHECK(fdcm_read(hdl, &out, sizeof(out)) == sizeof(out));
+			BENCH_CHECK(out.seq == i);
+			t_read += bench_now_ns() - r;
+		}
+	}
+	t = bench_now_ns() - t - t_read;
+	bench_report("fdcm write, 128 byte record", FDCM_ROUNDS, t);
+	bench_report("fdcm read", (FDCM_ROUNDS + 255) / 256, t_read);
+
+	flash_file_get_stat(&stat);
+	printf("%-36s %9u bytes written, %u blocks erased\n", "flash",
+	       stat.write_bytes, stat.erase_blocks);
+
+	fdcm_close(hdl);
+	flash_file_close();
+	return 0;
+}
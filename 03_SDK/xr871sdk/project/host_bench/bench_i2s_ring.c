@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Period ring of the I2S DMA buffer (src/driver/chip/i2s_ring.c) driven the
+ * way hal_i2s.c drives it, over a simulated DMA: a step transfers the
+ * period under the DMA and raises its half or end interrupt. Playback and
+ * record are checked for the order of the periods, for the xruns of a
+ * writer or reader late by two periods and by enough periods to stop the
+ * DMA, and for the recovery after them. Then the cost of filling a period
+ * in place through the mmap interface against rendering it aside and
+ * copying it like HAL_I2S_Write_DMA(), and a run with the DMA in its own
+ * thread waking the writer by a semaphore.
+ */
+
+#include <string.h>
+#include "kernel/os/os.h"
+#include "driver/chip/i2s_ring.h"
+#include "bench.h"
+
+#define BUF_SIZE        4096            /* two periods */
+#define PERIOD_SIZE     (BUF_SIZE / 2)
+#define PERIOD_WORDS    (PERIOD_SIZE / 4)
+#define SEQ_PERIODS     64
+#define MAX_STEPS       256
+#define COST_PERIODS    5000
+#define COST_ROUNDS     8
+#define THREAD_PERIODS  200
+
+struct sim {
+	struct i2s_ring r;
+	uint32_t        buf[BUF_SIZE / 4];
+	uint32_t        cur;        /* period the DMA transfers, 0 or 1 */
+	uint32_t        seq;        /* record: next period captured */
+	uint32_t        played[MAX_STEPS];
+	uint32_t        steps;
+	uint32_t        waits;
+	uint32_t        wakes;
+	uint32_t        stops;
+	uint32_t        sum;        /* of the ends of the periods, cost run */
+	int             check;      /* the words of a period are all its number */
+};
+
+static struct sim g_sim;
+
+/* HAL_I2S_Trigger(true, dir) */
+static void sim_start(struct sim *s)
+{
+	s->cur = 0;
+	s->r.running = 1;
+}
+
+/* the DMA transferring the period under it, then the period interrupt */
+static void sim_dma_step(struct sim *s)
+{
+	uint32_t *p = s->buf + s->cur * PERIOD_WORDS;
+	uint32_t ev, i;
+
+	if (!s->r.running)
+		return;
+
+	if (s->r.tx) {
+		if (s->check) {
+			for (i = 1; i < PERIOD_WORDS; i++)
+				BENCH_CHECK(p[i] == p[0]);
+			if (s->steps < MAX_STEPS)
+				s->played[s->steps] = p[0];
+		} else {
+			s->sum += p[0] + p[PERIOD_WORDS - 1];
+		}
+	} else {
+		for (i = 0; i < PERIOD_WORDS; i++)
+			p[i] = s->seq;
+		s->seq++;
+	}
+	s->steps++;
+
+	ev = i2s_ring_elapsed(&s->r, s->cur == 1);
+	if (ev & I2S_RING_WAKE)
+		s->wakes++;
+	if (ev & I2S_RING_STOP) {
+		BENCH_CHECK(!s->r.running);
+		s->stops++;
+	}
+	s->cur ^= 1;
+}
+
+static void sim_init(struct sim *s, int tx)
+{
+	memset(s, 0, sizeof(*s));
+	i2s_ring_init(&s->r, (uint8_t *)s->buf, BUF_SIZE, tx);
+	s->check = 1;
+}
+
+/* I2S_PeriodAcquire(), the DMA steps while the writer or reader waits */
+static uint32_t *sim_acquire(struct sim *s, int *xrun)
+{
+	uint8_t *p;
+	int ret;
+
+	while (1) {
+		ret = i2s_ring_acquire(&s->r, &p);
+		if (ret == I2S_RING_START) {
+			BENCH_CHECK(!s->r.tx);
+			sim_start(s);
+			continue;
+		}
+		if (ret != I2S_RING_WAIT)
+			break;
+		BENCH_CHECK(s->r.waiting);
+		s->waits++;
+		sim_dma_step(s);
+	}
+	BENCH_CHECK(p == s->r.buf || p == s->r.buf + PERIOD_SIZE);
+	if (xrun)
+		*xrun = (ret == I2S_RING_XRUN);
+	return (uint32_t *)p;
+}
+
+/* I2S_PeriodCommit() */
+static void sim_commit(struct sim *s, uint32_t *p)
+{
+	if (i2s_ring_commit(&s->r, (uint8_t *)p)) {
+		BENCH_CHECK(s->r.tx && p == s->buf + PERIOD_WORDS);
+		sim_start(s);
+	}
+}
+
+static void sim_stall(struct sim *s, uint32_t periods)
+{
+	while (periods--)
+		sim_dma_step(s);
+}
+
+/*
+ * The writer is late by @stall periods before period @at. Every period
+ * written must be played once and in order, a period played again is the
+ * glitch of an xrun.
+ */
+static void test_playback(uint32_t at, uint32_t stall, uint32_t xrun,
+                          uint32_t repeats, uint32_t stops)
+{
+	struct sim *s = &g_sim;
+	uint32_t *p, n, i, next, rep;
+
+	sim_init(s, 1);
+	for (n = 0; n < SEQ_PERIODS; n++) {
+		if (n == at)
+			sim_stall(s, stall);
+		p = sim_acquire(s, NULL);
+		for (i = 0; i < PERIOD_WORDS; i++)
+			p[i] = n;
+		sim_commit(s, p);
+	}
+	BENCH_CHECK(s->r.running);
+	sim_stall(s, 2);    /* the DMA's period and the last one */
+
+	for (i = 0, next = 0, rep = 0; i < s->steps; i++) {
+		if (s->played[i] == next)
+			next++;
+		else
+			rep++;
+	}
+	BENCH_CHECK(next == SEQ_PERIODS);
+	BENCH_CHECK(rep == repeats);
+	BENCH_CHECK(s->r.xrun == xrun);
+	BENCH_CHECK(s->stops == stops);
+	BENCH_CHECK(s->wakes == s->waits);
+}
+
+/*
+ * The reader is late by @stall periods before period @at. The periods
+ * read must be captured in order, @lost of them are overwritten.
+ */
+static void test_record(uint32_t at, uint32_t stall, uint32_t xrun,
+                        uint32_t lost, uint32_t stops)
+{
+	struct sim *s = &g_sim;
+	uint32_t *p, n, i, last = 0, skipped = 0;
+	int over, first = 1;
+
+	sim_init(s, 0);
+	for (n = 0; n < SEQ_PERIODS; n++) {
+		if (n == at)
+			sim_stall(s, stall);
+		p = sim_acquire(s, &over);
+		for (i = 1; i < PERIOD_WORDS; i++)
+			BENCH_CHECK(p[i] == p[0]);
+		if (first) {
+			BENCH_CHECK(p[0] == 0);
+			first = 0;
+		} else {
+			BENCH_CHECK(p[0] > last);
+			skipped += p[0] - last - 1;
+		}
+		BENCH_CHECK(over == 0 || n == at);
+		last = p[0];
+		sim_commit(s, p);
+	}
+	BENCH_CHECK(s->r.xrun == xrun);
+	BENCH_CHECK(skipped == lost);
+	BENCH_CHECK(s->stops == stops);
+	BENCH_CHECK(s->wakes == s->waits);
+}
+
+static void render(uint32_t *p, uint32_t n)
+{
+	int16_t *pcm = (int16_t *)p;
+	uint32_t i;
+
+	for (i = 0; i < PERIOD_SIZE / 2; i++)
+		pcm[i] = (int16_t)(n + i * 131);
+}
+
+/* @copy renders aside then copies like HAL_I2S_Write_DMA() */
+static uint64_t cost_run(int copy, uint32_t *sum)
+{
+	static uint32_t aside[PERIOD_WORDS];
+	struct sim *s = &g_sim;
+	uint32_t *p, n;
+	uint64_t t;
+
+	sim_init(s, 1);
+	s->check = 0;
+	t = bench_now_ns();
+	for (n = 0; n < COST_PERIODS; n++) {
+		if (copy) {
+			render(aside, n);
+			p = sim_acquire(s, NULL);
+			memcpy(p, aside, PERIOD_SIZE);
+		} else {
+			p = sim_acquire(s, NULL);
+			render(p, n);
+		}
+		sim_commit(s, p);
+	}
+	sim_stall(s, 2);
+	t = bench_now_ns() - t;
+	BENCH_CHECK(s->r.xrun == 0);
+	*sum = s->sum;
+	return t;
+}
+
+/* the best of COST_ROUNDS, the host is noisy */
+static void bench_cost(void)
+{
+	struct sim *s = &g_sim;
+	uint32_t *p, n, r, sum, ref;
+	uint64_t t, best[2] = { ~0ULL, ~0ULL };
+
+	sim_init(s, 1);
+	s->check = 0;
+	t = bench_now_ns();
+	for (n = 0; n < COST_PERIODS; n++) {
+		p = sim_acquire(s, NULL);
+		sim_commit(s, p);
+	}
+	bench_report("ring acquire/commit/elapsed", COST_PERIODS, bench_now_ns() - t);
+	BENCH_CHECK(s->r.xrun == 0);
+
+	for (r = 0; r < COST_ROUNDS; r++) {
+		t = cost_run(0, &ref);
+		if (t < best[0])
+			best[0] = t;
+		t = cost_run(1, &sum);
+		if (t < best[1])
+			best[1] = t;
+		BENCH_CHECK(sum == ref);
+	}
+	bench_report("ring mmap, 2 KiB period in place", COST_PERIODS, best[0]);
+	bench_report("ring write, 2 KiB period copied", COST_PERIODS, best[1]);
+	printf("%-36s %9u bytes/period in place, %u copied\n", "ring, writer memory traffic",
+	       PERIOD_SIZE, PERIOD_SIZE * 3);
+}
+
+/*
+ * The DMA in its own thread, a period a ms, the writer waiting on the
+ * semaphore like HAL_I2S_Mmap_Begin(). The mutex stands for the masked
+ * interrupt.
+ */
+static struct {
+	OS_Mutex_t      irq;
+	OS_Semaphore_t  ready;
+	OS_Semaphore_t  done;
+	OS_Thread_t     thread;
+} g_thd;
+
+static void dma_task(void *arg)
+{
+	struct sim *s = arg;
+	uint32_t ev, wakes, n;
+
+	for (n = 0; n < THREAD_PERIODS + 2; n++) {
+		OS_MSleep(1);
+		OS_MutexLock(&g_thd.irq, OS_WAIT_FOREVER);
+		wakes = s->wakes;
+		sim_dma_step(s);
+		ev = s->wakes - wakes;
+		OS_MutexUnlock(&g_thd.irq);
+		if (ev)
+			OS_SemaphoreRelease(&g_thd.ready);
+	}
+	OS_SemaphoreRelease(&g_thd.done);
+	OS_ThreadDelete(&g_thd.thread);
+}
+
+static void bench_thread(void)
+{
+	struct sim *s = &g_sim;
+	uint8_t *p;
+	uint32_t n, i, next, rep, waits = 0;
+	int ret;
+	uint64_t t;
+
+	sim_init(s, 1);
+	BENCH_CHECK(OS_MutexCreate(&g_thd.irq) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_thd.ready) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_thd.done) == OS_OK);
+
+	t = bench_now_ns();
+	for (n = 0; n < THREAD_PERIODS; n++) {
+		OS_MutexLock(&g_thd.irq, OS_WAIT_FOREVER);
+		while ((ret = i2s_ring_acquire(&s->r, &p)) == I2S_RING_WAIT) {
+			waits++;
+			OS_MutexUnlock(&g_thd.irq);
+			BENCH_CHECK(OS_SemaphoreWait(&g_thd.ready, 1000) == OS_OK);
+			OS_MutexLock(&g_thd.irq, OS_WAIT_FOREVER);
+		}
+		OS_MutexUnlock(&g_thd.irq);
+
+		for (i = 0; i < PERIOD_WORDS; i++)
+			((uint32_t *)p)[i] = n;
+
+		OS_MutexLock(&g_thd.irq, OS_WAIT_FOREVER);
+		if (i2s_ring_commit(&s->r, p)) {
+			sim_start(s);
+			BENCH_CHECK(OS_ThreadCreate(&g_thd.thread, "dma", dma_task, s,
+			                            OS_THREAD_PRIO_APP, 1024) == OS_OK);
+		}
+		OS_MutexUnlock(&g_thd.irq);
+	}
+	BENCH_CHECK(OS_SemaphoreWait(&g_thd.done, OS_WAIT_FOREVER) == OS_OK);
+	bench_report("ring, DMA thread, 1 ms periods", THREAD_PERIODS, bench_now_ns() - t);
+
+	/* a late wake up of the writer is an xrun, not a loss */
+	for (i = 0, next = 0, rep = 0; i < s->steps; i++) {
+		if (s->played[i] == next)
+			next++;
+		else
+			rep++;
+	}
+	BENCH_CHECK(next == THREAD_PERIODS);
+	BENCH_CHECK(waits > THREAD_PERIODS / 2);
+	printf("%-36s %9u xrun %u stops %u repeats\n", "ring, DMA thread",
+	       s->r.xrun, s->stops, rep);
+
+	OS_SemaphoreDelete(&g_thd.done);
+	OS_SemaphoreDelete(&g_thd.ready);
+	OS_MutexDelete(&g_thd.irq);
+}
+
+int main(void)
+{
+	test_playback(SEQ_PERIODS, 0, 0, 0, 0);
+	test_playback(10, 1, 0, 0, 0);      /* within the buffer */
+	test_playback(10, 2, 1, 1, 0);
+	test_playback(10, 6, 1, 3, 1);
+	test_record(SEQ_PERIODS, 0, 0, 0, 0);
+	test_record(10, 1, 0, 0, 0);
+	test_record(10, 2, 1, 1, 0);
+	test_record(10, 6, 1, 5, 1);
+
+	bench_cost();
+	bench_thread();
+
+	printf("i2s ring checks passed\n");
+	return 0;
+}
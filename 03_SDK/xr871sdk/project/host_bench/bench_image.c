@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Image checksum and section checks (src/image/image.c) over a file backed
+ * flash. image_get_checksum() is compared with the halfword loop it
+ * replaced on random buffers of every alignment and length, then random
+ * images are built with the reference sums and checked whole, section by
+ * section and with a corrupted byte. The verified cache is checked to skip
+ * the data of unchanged sections, also after a cold boot, and to check
+ * again a section rewritten with a new version. Then the cost of both
+ * checksums and of a boot check with and without the cache.
+ */
+
+#include <string.h>
+#include "image/flash.h"
+#include "image/image.h"
+#include "flash_file.h"
+#include "bench.h"
+
+#define IMG_ADDR        0
+#define IMG_MAX_SIZE    (1536 * 1024)
+#define IMG_BL_SIZE     (32 * 1024)
+#define IMG_SEC_MAX     10
+#define VCACHE_ADDR     (FLASH_FILE_SIZE - 4 * FLASH_FILE_ERASE_BLOCK)
+#define VCACHE_SIZE     (4 * FLASH_FILE_ERASE_BLOCK)
+
+#define EQ_ROUNDS       20000
+#define EQ_LEN_MAX      2100
+#define COST_SIZE       (1024 * 1024)
+#define COST_ROUNDS     20
+
+static const uint32_t sec_ids[IMG_SEC_MAX] = {
+	IMAGE_BOOT_ID, IMAGE_APP_ID, IMAGE_APP_XIP_ID, IMAGE_NET_ID,
+	IMAGE_NET_AP_ID, IMAGE_WLAN_BL_ID, IMAGE_WLAN_FW_ID, IMAGE_WLAN_SDD_ID,
+	IMAGE_USER_ID, IMAGE_USER_ID + 1,
+};
+
+/* the sections of the last image built */
+static struct {
+	uint32_t    num;
+	uint32_t    addr[IMG_SEC_MAX];
+	uint32_t    size[IMG_SEC_MAX];
+	uint32_t    version[IMG_SEC_MAX];
+	uint32_t    total;
+} g_img;
+
+static uint8_t g_buf[COST_SIZE + 8];
+
+/*
+ * image_checksum16() before the word-wide loop. Halfwords are built from
+ * bytes, the same as the little-endian loads of the target at any alignment.
+ * Not vectorized, as on the target, where the cost is the loads.
+ */
+__attribute__((noinline, optimize("no-tree-vectorize")))
+static uint16_t ref_checksum16(const uint8_t *data, uint32_t len)
+{
+	uint16_t cs = 0;
+
+	while (len > 1) {
+		cs += data[0] | (data[1] << 8);
+		data += 2;
+		len -= 2;
+	}
+	if (len) {
+		cs += *data;
+	}
+	return cs;
+}
+
+static uint32_t rand32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void fill_random(uint8_t *p, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		p[i] = (uint8_t)rand();
+}
+
+static void test_equivalence(void)
+{
+	uint32_t r, off, len, i;
+
+	/* sums of 0xFF words wrap the 16 bit sum many times */
+	memset(g_buf, 0xFF, sizeof(g_buf));
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len < 70; len++)
+			BENCH_CHECK(image_get_checksum(g_buf + off, len) ==
+			            ref_checksum16(g_buf + off, len));
+		len = COST_SIZE - 1 - off;
+		BENCH_CHECK(image_get_checksum(g_buf + off, len) ==
+		            ref_checksum16(g_buf + off, len));
+	}
+
+	for (r = 0; r < EQ_ROUNDS; r++) {
+		off = rand() % 8;
+		len = rand() % EQ_LEN_MAX;
+		fill_random(g_buf, off + len + 8);
+		if (r % 16 == 0) {
+			/* long runs of erased flash */
+			for (i = 0; i < len; i += 1 + rand() % 64)
+				g_buf[off + i] = 0xFF;
+		}
+		BENCH_CHECK(image_get_checksum(g_buf + off, len) ==
+		            ref_checksum16(g_buf + off, len));
+	}
+}
+
+/* body and tailer split at odd and even lengths, as the OTA gets them */
+static void test_check_data(void)
+{
+	section_header_t sh;
+	uint8_t *data = g_buf;
+	uint32_t r, len, body_len, tailer_len;
+
+	for (r = 0; r < 2000; r++) {
+		len = 2 + rand() % 1500;
+		body_len = 1 + rand() % (len - 1);
+		tailer_len = (r % 4 == 0) ? 0 : len - body_len;
+		fill_random(data, len);
+		memset(&sh, 0, sizeof(sh));
+		sh.data_chksum = 0xFFFF - ref_checksum16(data, body_len + tailer_len);
+		BENCH_CHECK(image_check_data(&sh, data, body_len, tailer_len ? data + body_len : NULL,
+		                             tailer_len) == IMAGE_VALID);
+		data[rand() % (body_len + tailer_len)] ^= 1U << (rand() % 8);
+		BENCH_CHECK(image_check_data(&sh, data, body_len, tailer_len ? data + body_len : NULL,
+		                             tailer_len) == IMAGE_INVALID);
+	}
+}
+
+static void write_section(uint32_t i, uint32_t next)
+{
+	section_header_t sh;
+	uint8_t *data = g_buf;
+
+	memset(&sh, 0, sizeof(sh));
+	sh.magic_number = IMAGE_MAGIC_NUMBER;
+	sh.version = g_img.version[i];
+	sh.data_size = g_img.size[i];
+	sh.body_len = g_img.size[i];
+	sh.load_addr = rand32();
+	sh.entry = rand32();
+	sh.next_addr = next;
+	sh.id = sec_ids[i];
+	if (i == 0) {
+		/* OTA area not set, the image is sequence 0 only */
+		sh.priv[0] = 0xFFFFFFFF;
+		sh.priv[1] = IMAGE_INVALID_ADDR;
+	}
+
+	fill_random(data, g_img.size[i]);
+	sh.data_chksum = 0xFFFF - ref_checksum16(data, g_img.size[i]);
+	sh.header_chksum = 0xFFFF - ref_checksum16((uint8_t *)&sh, IMAGE_HEADER_SIZE);
+
+	BENCH_CHECK(flash_write(0, g_img.addr[i], &sh, IMAGE_HEADER_SIZE) == IMAGE_HEADER_SIZE);
+	BENCH_CHECK(flash_write(0, g_img.addr[i] + IMAGE_HEADER_SIZE, data, g_img.size[i]) ==
+	            g_img.size[i]);
+}
+
+/* @seed picks the layout and the data, @bump is a section given a new version */
+static void build_image(uint32_t seed, int bump)
+{
+	uint32_t i, addr, next;
+
+	srand(seed);
+	g_img.num = 4 + rand() % (IMG_SEC_MAX - 3);
+	g_img.addr[0] = IMG_ADDR;
+	g_img.size[0] = 8 * 1024 + rand() % (16 * 1024);
+	addr = IMG_ADDR + IMG_BL_SIZE;
+	for (i = 1; i < g_img.num; i++) {
+		if (i > 1)
+			addr += rand() % 4; /* sections at any alignment */
+		g_img.addr[i] = addr;
+		g_img.size[i] = 1 + rand() % (IMG_MAX_SIZE / IMG_SEC_MAX);
+		addr += IMAGE_HEADER_SIZE + g_img.size[i];
+	}
+	g_img.total = addr - IMG_ADDR;
+	BENCH_CHECK(g_img.total <= IMG_MAX_SIZE);
+	for (i = 0; i < g_img.num; i++)
+		g_img.version[i] = 2 + (rand() % 3) + (i == (uint32_t)bump);
+
+	BENCH_CHECK(flash_erase(0, IMG_ADDR, IMG_MAX_SIZE) == 0);
+	for (i = 0; i < g_img.num; i++) {
+		if (i + 1 < g_img.num)
+			next = g_img.addr[i + 1] - IMG_ADDR;
+		else
+			next = IMAGE_INVALID_ADDR;
+		write_section(i, next);
+	}
+}
+
+static uint32_t flash_read_bytes(void)
+{
+	flash_file_stat stat;
+
+	flash_file_get_stat(&stat);
+	return stat.read_bytes;
+}
+
+/* clear a set bit of a byte in the data of section @i, flash can only do that */
+static void corrupt_section(uint32_t i)
+{
+	uint32_t addr;
+	uint8_t b;
+
+	do {
+		addr = g_img.addr[i] + IMAGE_HEADER_SIZE + rand() % g_img.size[i];
+		BENCH_CHECK(flash_read(0, addr, &b, 1) == 1);
+	} while (b == 0);
+	b &= ~(1U << __builtin_ctz(b));
+	BENCH_CHECK(flash_write(0, addr, &b, 1) == 1);
+}
+
+static void test_images(void)
+{
+	uint32_t seed, i, bad;
+
+	for (seed = 1; seed <= 8; seed++) {
+		build_image(seed, -1);
+		BENCH_CHECK(image_init(0, IMG_ADDR, IMG_MAX_SIZE) == 0);
+		BENCH_CHECK(image_get_running_seq() == 0);
+		BENCH_CHECK(image_check_sections(0) == IMAGE_VALID);
+		for (i = 1; i < g_img.num; i++)
+			BENCH_CHECK(image_check_section(0, sec_ids[i]) == IMAGE_VALID);
+
+		bad = 1 + rand() % (g_img.num - 1);
+		corrupt_section(bad);
+		BENCH_CHECK(image_check_sections(0) == IMAGE_INVALID);
+		for (i = 1; i < g_img.num; i++)
+			BENCH_CHECK(image_check_section(0, sec_ids[i]) ==
+			            (i == bad ? IMAGE_INVALID : IMAGE_VALID));
+		image_deinit();
+	}
+}
+
+/* image_init() and the cache of the last boot, like platform_init() */
+static void boot(void)
+{
+	BENCH_CHECK(image_init(0, IMG_ADDR, IMG_MAX_SIZE) == 0);
+	BENCH_CHECK(image_vcache_init(0, VCACHE_ADDR, VCACHE_SIZE) == 0);
+}
+
+static uint32_t check_reads(image_val_t expect)
+{
+	uint32_t reads = flash_read_bytes();
+
+	BENCH_CHECK(image_check_sections(0) == expect);
+	return flash_read_bytes() - reads;
+}
+
+static void test_vcache(void)
+{
+	uint32_t reads, headers, bump;
+
+	BENCH_CHECK(flash_erase(0, VCACHE_ADDR, VCACHE_SIZE) == 0);
+	build_image(21, -1);
+	headers = g_img.num * IMAGE_HEADER_SIZE;
+
+	boot();
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads >= g_img.total - IMG_BL_SIZE);
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads == headers);
+	image_deinit();
+
+	/* cold boot, the records are kept in flash */
+	boot();
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads == headers);
+	image_deinit();
+
+	/* the same image with a section of a new version, not dropped */
+	bump = 2;
+	build_image(21, bump);
+	boot();
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads >= headers + g_img.size[bump]);
+	BENCH_CHECK(reads < headers * 2 + g_img.size[bump] + 1024);
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads == headers);
+
+	/* dropped before an OTA writes the image */
+	image_vcache_drop(0);
+	reads = check_reads(IMAGE_VALID);
+	BENCH_CHECK(reads >= g_img.total - IMG_BL_SIZE);
+
+	/* a record only skips a section with the same header */
+	corrupt_section(bump);
+	BENCH_CHECK(check_reads(IMAGE_VALID) == headers);
+	image_vcache_drop(0);
+	BENCH_CHECK(check_reads(IMAGE_INVALID) > headers);
+	image_deinit();
+}
+
+static void bench_cost(void)
+{
+	uint32_t r, cs = 0, ref = 0;
+	uint64_t t;
+
+	fill_random(g_buf, COST_SIZE);
+	t = bench_now_ns();
+	for (r = 0; r < COST_ROUNDS; r++) {
+		g_buf[r]++;     /* not to be hoisted out of the loop */
+		ref += ref_checksum16(g_buf, COST_SIZE);
+	}
+	bench_report("checksum16 halfwords, 1 MiB", COST_ROUNDS, bench_now_ns() - t);
+
+	for (r = 0; r < COST_ROUNDS; r++)
+		g_buf[r]--;
+	t = bench_now_ns();
+	for (r = 0; r < COST_ROUNDS; r++) {
+		g_buf[r]++;
+		cs += image_get_checksum(g_buf, COST_SIZE);
+	}
+	bench_report("checksum16 words, 1 MiB", COST_ROUNDS, bench_now_ns() - t);
+	BENCH_CHECK(cs == ref);
+
+	build_image(33, -1);
+	BENCH_CHECK(image_init(0, IMG_ADDR, IMG_MAX_SIZE) == 0);
+	t = bench_now_ns();
+	for (r = 0; r < COST_ROUNDS; r++)
+		BENCH_CHECK(image_check_sections(0) == IMAGE_VALID);
+	bench_report("image check, no cache", COST_ROUNDS, bench_now_ns() - t);
+
+	BENCH_CHECK(flash_erase(0, VCACHE_ADDR, VCACHE_SIZE) == 0);
+	BENCH_CHECK(image_vcache_init(0, VCACHE_ADDR, VCACHE_SIZE) == 0);
+	BENCH_CHECK(image_check_sections(0) == IMAGE_VALID);
+	t = bench_now_ns();
+	for (r = 0; r < COST_ROUNDS; r++)
+		BENCH_CHECK(image_check_sections(0) == IMAGE_VALID);
+	bench_report("image check, verified cache", COST_ROUNDS, bench_now_ns() - t);
+	printf("%-36s %9u bytes, %u sections\n", "image", g_img.total, g_img.num);
+	image_deinit();
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "image.bin";
+
+	BENCH_CHECK(flash_file_open(path) == 0);
+	srand(7);
+	test_equivalence();
+	test_check_data();
+	test_images();
+	test_vcache();
+	bench_cost();
+	flash_file_close();
+
+	printf("image checks passed\n");
+	return 0;
+}
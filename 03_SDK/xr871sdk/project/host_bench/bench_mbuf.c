@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "lwip/sys.h"
+#include "lwip/mem.h"
+#include "lwip/memp.h"
+#include "lwip/pbuf.h"
+#include "sys/mbuf_1.h"
+#include "bench.h"
+
+#define MBUF_ROUNDS		200000
+
+static const int g_sizes[] = { 64, 256, 1500 };
+
+int main(void)
+{
+	struct mbuf *m;
+	struct pbuf *p;
+	char name[48];
+	uint64_t t;
+	uint32_t i, s;
+	int tx;
+
+	sys_init();
+	mem_init();
+	memp_init();
+
+	for (tx = 0; tx <= 1; tx++) {
+		for (s = 0; s < sizeof(g_sizes) / sizeof(g_sizes[0]); s++) {
+			t = bench_now_ns();
+			for (i = 0; i < MBUF_ROUNDS; i++) {
+				m = mb_get(g_sizes[s], tx);
+				BENCH_CHECK(m != NULL && m->m_len == g_sizes[s]);
+				mb_free(m);
+			}
+			snprintf(name, sizeof(name), "mb_get/mb_free %s %d", tx ? "tx" : "rx",
+			         g_sizes[s]);
+			bench_report(name, MBUF_ROUNDS, bench_now_ns() - t);
+		}
+	}
+
+	t = bench_now_ns();
+	for (i = 0; i < MBUF_ROUNDS; i++) {
+		m = mb_get(1500, 0);
+		p = mb_mbuf2pbuf(m);
+		BENCH_CHECK(p != NULL && p->tot_len == 1500);
+		mb_free(m);
+		m = mb_pbuf2mbuf(p);
+		BENCH_CHECK(m != NULL);
+		pbuf_free(p);
+		mb_free(m);
+	}
+	bench_report("mbuf <-> pbuf round trip, 1500", MBUF_ROUNDS, bench_now_ns() - t);
+	return 0;
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software mixer of the PCM layer (src/audio/pcm/audio_mixer.c) over a card
+ * played by the bench: the periods the mixer commits are captured. First
+ * single streams at several rates resampled to a 48 kHz stereo card,
+ * checked against a float model of the interpolation and against the ideal
+ * sine. Then two streams clipping, and a prompt ducking the music. Then
+ * the CPU cost per ms of audio with one and four streams.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "kernel/os/os.h"
+#include "audio/pcm/audio_mixer.h"
+#include "bench.h"
+
+#define CARD_RATE       48000
+#define CARD_CH         2
+#define PERIOD          480                     /* frames, 10 ms */
+#define CAP_FRAMES      (CARD_RATE * 2)
+#define TONE            1000.0
+#define AMP             16000.0
+#define COST_SECONDS    2
+
+/*
+ * The card: mmap_begin() hands out the period the DMA has played, the bench
+ * plays @n periods by card_run(). In free run every period is played at
+ * once, like the card keeps on clocking when the mixer is closed.
+ */
+static struct {
+	OS_Semaphore_t  played;
+	OS_Semaphore_t  committed;
+	volatile int    free_run;
+	int16_t         period[PERIOD * CARD_CH];
+	int16_t         cap[CAP_FRAMES * CARD_CH];
+	uint32_t        cap_len;                /* frames captured */
+} card;
+
+void *pcm_zalloc(unsigned int size)
+{
+	return calloc(1, size);
+}
+
+void pcm_free(void *p)
+{
+	free(p);
+}
+
+unsigned int pcm_get_buffer_size(struct pcm_config *config)
+{
+	return config->period_count * config->period_size;
+}
+
+unsigned int pcm_frames_to_bytes(struct pcm_config *config, unsigned int frames)
+{
+	return frames * config->channels * sizeof(int16_t);
+}
+
+int snd_pcm_open(struct pcm_config *config, unsigned int card, unsigned int flags)
+{
+	return 0;
+}
+
+int snd_pcm_close(unsigned int card, unsigned int flags)
+{
+	return 0;
+}
+
+int snd_pcm_flush(struct pcm_config *config, unsigned int card)
+{
+	return 0;
+}
+
+int snd_pcm_mmap_begin(struct pcm_config *config, unsigned int c, unsigned int flags,
+                       void **area, unsigned int *count, unsigned int timeout)
+{
+	while (!card.free_run && OS_SemaphoreWait(&card.played, 10) != OS_OK)
+		;
+	*area = card.period;
+	*count = sizeof(card.period);
+	return 0;
+}
+
+int snd_pcm_mmap_commit(struct pcm_config *config, unsigned int c, unsigned int flags,
+                        void *area)
+{
+	if (card.free_run)
+		return 0;
+	if (card.cap_len + PERIOD <= CAP_FRAMES) {
+		memcpy(&card.cap[card.cap_len * CARD_CH], area, sizeof(card.period));
+		card.cap_len += PERIOD;
+	}
+	OS_SemaphoreRelease(&card.committed);
+	return 0;
+}
+
+static void card_run(uint32_t periods)
+{
+	uint32_t i;
+
+	for (i = 0; i < periods; i++)
+		OS_SemaphoreRelease(&card.played);
+	for (i = 0; i < periods; i++)
+		BENCH_CHECK(OS_SemaphoreWait(&card.committed, OS_WAIT_FOREVER) == OS_OK);
+}
+
+static struct pcm_config card_config = {
+	.channels = CARD_CH,
+	.rate = CARD_RATE,
+	.period_size = PERIOD,
+	.period_count = 2,
+	.format = PCM_FORMAT_S16_LE,
+};
+
+/* a stream holding all of @frames at once */
+static snd_mixer_stream_t stream_open(uint32_t rate, uint32_t ch, uint32_t frames,
+                                      unsigned int prio)
+{
+	struct pcm_config c = {
+		.channels = ch,
+		.rate = rate,
+		.period_size = frames,
+		.period_count = 1,
+		.format = PCM_FORMAT_S16_LE,
+	};
+	snd_mixer_stream_t s = snd_mixer_stream_open(&c, prio);
+
+	BENCH_CHECK(s != NULL);
+	return s;
+}
+
+static void stream_write(snd_mixer_stream_t s, const int16_t *data, uint32_t frames, uint32_t ch)
+{
+	uint32_t bytes = frames * ch * sizeof(int16_t);
+
+	BENCH_CHECK(snd_mixer_stream_write(s, (void *)data, bytes) == bytes);
+}
+
+/* @ch channels of a tone, the right one in opposite phase */
+static int16_t *tone(uint32_t rate, uint32_t ch, uint32_t frames)
+{
+	int16_t *p = malloc(frames * ch * sizeof(int16_t));
+	uint32_t i;
+
+	BENCH_CHECK(p != NULL);
+	for (i = 0; i < frames; i++) {
+		p[i * ch] = (int16_t)lrint(AMP * sin(2 * M_PI * TONE * i / rate));
+		if (ch == 2)
+			p[i * ch + 1] = -p[i * ch];
+	}
+	return p;
+}
+
+static int16_t *dc(int16_t v, uint32_t frames)
+{
+	int16_t *p = malloc(frames * CARD_CH * sizeof(int16_t));
+	uint32_t i;
+
+	BENCH_CHECK(p != NULL);
+	for (i = 0; i < frames * CARD_CH; i++)
+		p[i] = v;
+	return p;
+}
+
+/*
+ * A stream at @rate resampled alone. The float model follows the mixer's
+ * Q16 phase: output frame k interpolates between source frames c - 2 and
+ * c - 1, c being the frames consumed, the frame before the first is silence.
+ */
+static void test_resample(uint32_t rate, uint32_t ch)
+{
+	uint32_t frames = rate / 2, out = (CARD_RATE / 2) / PERIOD - 2;
+	uint32_t step = (uint32_t)(((uint64_t)rate << 16) / CARD_RATE);
+	uint32_t phase = 1 << 16, c = 0, k, j;
+	double sig = 0, err = 0, max_err = 0, pos, v, w, ideal, gain = 32767.0 / 32768;
+	int16_t *src = tone(rate, ch, frames);
+	snd_mixer_stream_t s;
+	struct snd_mixer_stat st;
+
+	s = stream_open(rate, ch, frames, SND_MIXER_PRIO_MUSIC);
+	stream_write(s, src, frames, ch);
+	card.cap_len = 0;
+	card_run(out);
+	BENCH_CHECK(snd_mixer_get_stat(&st) == 0 && st.underruns == 0);
+	BENCH_CHECK(snd_mixer_stream_close(s) == 0);
+
+	for (k = 0; k < out * PERIOD; k++) {
+		while (phase >= (1 << 16)) {
+			c++;
+			phase -= 1 << 16;
+		}
+		for (j = 0; j < CARD_CH; j++) {
+			int16_t a = (c >= 2) ? src[(c - 2) * ch + (j % ch)] : 0;
+			int16_t b = src[(c - 1) * ch + (j % ch)];
+
+			v = (a + (b - a) * (phase / 65536.0)) * gain;
+			BENCH_CHECK(fabs(card.cap[k * CARD_CH + j] - v) < 3.0);
+			if (fabs(card.cap[k * CARD_CH + j] - v) > max_err)
+				max_err = fabs(card.cap[k * CARD_CH + j] - v);
+
+			/* the source position in frames, the tone starts at 0 */
+			pos = (double)c - 2 + phase / 65536.0;
+			if (pos < 0)
+				continue;
+			ideal = AMP * sin(2 * M_PI * TONE * pos / rate) * gain;
+			if (ch == 2 && j == 1)
+				ideal = -ideal;
+			sig += ideal * ideal;
+			err += (card.cap[k * CARD_CH + j] - ideal) * (card.cap[k * CARD_CH + j] - ideal);
+		}
+		phase += step;
+	}
+	/* the error of a linear interpolation is below (w * T)^2 / 8 of the tone */
+	w = 2 * M_PI * TONE / rate;
+	printf("  %5u Hz %s: SNR %.1f dB against the tone (bound %.1f dB), "
+	       "%.2f LSB off the float model\n", rate, ch == 2 ? "stereo" : "mono  ",
+	       10 * log10(sig / err), 20 * log10(8 / (w * w)), max_err);
+	//X
+	free(src);
+}
+
+/* two streams near full scale clip instead of wrapping */
+static void test_saturation(int16_t v)
+{
+	uint32_t frames = 4 * PERIOD, k;
+	int16_t *src = dc(v, frames);
+	snd_mixer_stream_t a, b;
+
+	a = stream_open(CARD_RATE, CARD_CH, frames, SND_MIXER_PRIO_MUSIC);
+	b = stream_open(CARD_RATE, CARD_CH, frames, SND_MIXER_PRIO_MUSIC);
+	stream_write(a, src, frames, CARD_CH);
+	stream_write(b, src, frames, CARD_CH);
+	card.cap_len = 0;
+	card_run(3);
+	BENCH_CHECK(snd_mixer_stream_close(a) == 0 && snd_mixer_stream_close(b) == 0);
+
+	/* frame 0 interpolates from silence */
+	for (k = CARD_CH; k < 3 * PERIOD * CARD_CH; k++)
+		BENCH_CHECK(card.cap[k] == (v > 0 ? 32767 : -32768));
+	free(src);
+}
+
+static void check_periods(uint32_t from, uint32_t to, int16_t v)
+{
+	uint32_t k;
+
+	for (k = from * PERIOD * CARD_CH; k < to * PERIOD * CARD_CH; k++)
+		BENCH_CHECK(card.cap[k] == v);
+}
+
+/* a prompt ducks the music while it has data, the gains ramp over a period */
+static void test_ducking(void)
+{
+	uint32_t music_frames = 24 * PERIOD, prompt_frames = 10 * PERIOD, k;
+	int16_t *music = dc(16000, music_frames);
+	int16_t *prompt = dc(8000, prompt_frames);
+	int16_t m = (16000 * 32767) >> 15;
+	int16_t p = (8000 * 32767) >> 15;
+	int16_t ducked = (16000 * ((32767 * 0x2000) >> 15)) >> 15;
+	snd_mixer_stream_t a, b;
+
+	a = stream_open(CARD_RATE, CARD_CH, music_frames, SND_MIXER_PRIO_MUSIC);
+	b = stream_open(CARD_RATE, CARD_CH, prompt_frames, SND_MIXER_PRIO_PROMPT);
+	BENCH_CHECK(snd_mixer_set_duck_gain(0x2000) == 0);
+	stream_write(a, music, music_frames, CARD_CH);
+	card.cap_len = 0;
+	card_run(5);
+	stream_write(b, prompt, prompt_frames, CARD_CH);
+	card_run(15);
+	BENCH_CHECK(snd_mixer_stream_close(a) == 0 && snd_mixer_stream_close(b) == 0);
+
+	/*
+	 * periods 0..4 the music alone, 5 the ramp down, 6..14 ducked under the
+	 * prompt, which ran dry at the end of 14, 15 the ramp up, then the music
+	 */
+	check_periods(1, 5, m);
+	check_periods(6, 15, ducked + p);
+	check_periods(16, 20, m);
+	for (k = 5 * PERIOD * CARD_CH; k < 6 * PERIOD * CARD_CH; k++)
+		BENCH_CHECK(card.cap[k] >= ducked && card.cap[k] <= m + p);
+	for (k = 15 * PERIOD * CARD_CH; k < 16 * PERIOD * CARD_CH; k++)
+		BENCH_CHECK(card.cap[k] >= ducked && card.cap[k] <= m);
+	free(prompt);
+	free(music);
+}
+
+/* time to mix the periods of @n streams, per ms of audio */
+static void test_cost(const char *name, int n)
+{
+	static const struct {
+		uint32_t rate;
+		uint32_t ch;
+	} cfg[] = {
+		{ 44100, 2 }, { 22050, 1 }, { 16000, 1 }, { 48000, 2 },
+	};
+	snd_mixer_stream_t s[4];
+	int16_t *src[4];
+	uint32_t periods = COST_SECONDS * CARD_RATE / PERIOD - 2;
+	uint64_t t;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		uint32_t frames = cfg[i].rate * COST_SECONDS;
+
+		src[i] = tone(cfg[i].rate, cfg[i].ch, frames);
+		s[i] = stream_open(cfg[i].rate, cfg[i].ch, frames, SND_MIXER_PRIO_MUSIC);
+		stream_write(s[i], src[i], frames, cfg[i].ch);
+	}
+	t = bench_now_ns();
+	card_run(periods);
+	bench_report(name, periods * PERIOD * 1000 / CARD_RATE, bench_now_ns() - t);
+	for (i = 0; i < n; i++) {
+		BENCH_CHECK(snd_mixer_stream_close(s[i]) == 0);
+		free(src[i]);
+	}
+}
+
+int main(void)
+{
+	BENCH_CHECK(OS_SemaphoreCreate(&card.played, 0, 0xFFFF) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreate(&card.committed, 0, 0xFFFF) == OS_OK);
+	BENCH_CHECK(snd_mixer_open(&card_config, AUDIO_CARD0) == 0);
+
+	printf("resampled to %u Hz stereo:\n", CARD_RATE);
+	test_resample(8000, 1);
+	test_resample(16000, 1);
+	test_resample(22050, 2);
+	test_resample(44100, 2);
+	test_resample(48000, 2);
+	test_resample(96000, 2);
+	test_saturation(24000);
+	test_saturation(-24000);
+	test_ducking();
+	test_cost("mix 1 stream, per ms of audio", 1);
+	test_cost("mix 4 streams, per ms of audio", 4);
+
+	card.free_run = 1;
+	BENCH_CHECK(snd_mixer_close(AUDIO_CARD0) == 0);
+	OS_SemaphoreDelete(&card.committed);
+	OS_SemaphoreDelete(&card.played);
+	printf("mixer checks passed\n");
+	return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * noPoll WebSocket frames over a loopback connection. The server context runs
+ * its loop in its own thread and the client drives its connection from the
+ * main one, as a device streaming telemetry would. Allocations are counted
+ * through nopoll_calloc()/nopoll_realloc(), wrapped at link time.
+ */
+
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "nopoll.h"
+#include "bench.h"
+
+#define BENCH_PORT          "18081"
+#define BENCH_FRAMES        20000
+#define BENCH_WINDOW        16
+#define BENCH_MIN_LEN       64
+#define BENCH_MAX_LEN       200
+#define BENCH_LARGE_LEN     4000
+#define BENCH_LARGE_FRAMES  500
+#define BENCH_MASK_LEN      1500
+
+enum {
+	MODE_SINK,      /* count and check */
+	MODE_ECHO,      /* check and send back, header and payload apart */
+	MODE_HOLD,      /* check, keeping the last ones referenced */
+	MODE_JOIN,      /* check once all the pieces read of a frame arrived */
+	MODE_STOP,      /* leave the server loop, from its own thread */
+};
+
+/* shared with the server thread */
+static int g_mode;
+static int g_received;
+static int g_errors;
+static noPollMsg *g_held[BENCH_WINDOW];
+static int g_allocs;
+static unsigned char g_stop[BENCH_MIN_LEN];
+static unsigned char g_join[BENCH_LARGE_LEN + 1];
+static int g_join_len;
+
+#define LOAD(v)         __atomic_load_n(&(v), __ATOMIC_ACQUIRE)
+#define STORE(v, n)     __atomic_store_n(&(v), (n), __ATOMIC_RELEASE)
+
+noPollPtr __real_nopoll_calloc(size_t count, size_t size);
+noPollPtr __real_nopoll_realloc(noPollPtr ref, size_t size);
+
+noPollPtr __wrap_nopoll_calloc(size_t count, size_t size)
+{
+	__sync_fetch_and_add(&g_allocs, 1);
+	return __real_nopoll_calloc(count, size);
+}
+
+noPollPtr __wrap_nopoll_realloc(noPollPtr ref, size_t size)
+{
+	__sync_fetch_and_add(&g_allocs, 1);
+	return __real_nopoll_realloc(ref, size);
+}
+
+/* frame i: a 4 bytes sequence number then a pattern of its length */
+static int frame_len(int i, int large)
+{
+	return large ? BENCH_LARGE_LEN - (i % 7) :
+	       BENCH_MIN_LEN + (i * 37) % (BENCH_MAX_LEN - BENCH_MIN_LEN + 1);
+}
+
+static void frame_fill(unsigned char *buf, int i, int len)
+{
+	int k;
+
+	memcpy(buf, &i, 4);
+	for (k = 4; k < len; k++)
+		buf[k] = (unsigned char)(i + k);
+}
+
+static int frame_check(const unsigned char *buf, int len, int *seq)
+{
+	int k;
+
+	if (len < 4)
+		return 0;
+	memcpy(seq, buf, 4);
+	for (k = 4; k < len; k++) {
+		if (buf[k] != (unsigned char)(*seq + k))
+			return 0;
+	}
+	return buf[len] == '\0';
+}
+
+static void server_on_msg(noPollCtx *ctx, noPollConn *conn, noPollMsg *msg,
+                          noPollPtr user_data)
+{
+	const unsigned char *payload = nopoll_msg_get_payload(msg);
+	int len = nopoll_msg_get_payload_size(msg);
+	int seq, slot;
+	noPollIov iov[2];
+
+	if (LOAD(g_mode) == MODE_JOIN) {
+		/* frames larger than the receive buffer are delivered in
+		 * pieces as they are read */
+		if (g_join_len + len > BENCH_LARGE_LEN) {
+			__sync_fetch_and_add(&g_errors, 1);
+			return;
+		}
+		memcpy(g_join + g_join_len, payload, len);
+		g_join_len += len;
+		if (g_join_len < frame_len(LOAD(g_received), 1))
+			return;
+		g_join[g_join_len] = '\0';
+		payload = g_join;
+		len = g_join_len;
+		g_join_len = 0;
+	}
+	if (!frame_check(payload, len, &seq) || seq != LOAD(g_received)) {
+		__sync_fetch_and_add(&g_errors, 1);
+		return;
+	}
+	switch (LOAD(g_mode)) {
+	case MODE_ECHO:
+		iov[0].base = payload;
+		iov[0].len = 4;
+		iov[1].base = payload + 4;
+		iov[1].len = len - 4;
+		if (nopoll_conn_send_iov(conn, NOPOLL_BINARY_FRAME, nopoll_true, iov, 2) != len)
+			__sync_fetch_and_add(&g_errors, 1);
+		break;
+	case MODE_HOLD:
+		/* the earlier one must have survived the frames read since */
+		slot = seq % BENCH_WINDOW;
+		if (g_held[slot] != NULL) {
+			if (!frame_check(nopoll_msg_get_payload(g_held[slot]),
+			                 nopoll_msg_get_payload_size(g_held[slot]), &len) ||
+			    len != seq - BENCH_WINDOW)
+				__sync_fetch_and_add(&g_errors, 1);
+			nopoll_msg_unref(g_held[slot]);
+		}
+		nopoll_msg_ref(msg);
+		g_held[slot] = msg;
+		break;
+	case MODE_STOP:
+		nopoll_loop_stop(ctx);
+		break;
+	}
+	__sync_fetch_and_add(&g_received, 1);
+}
+
+static void *server_task(void *arg)
+{
+	nopoll_loop_wait((noPollCtx *)arg, 0);
+	return NULL;
+}
+
+static void wait_received(int n)
+{
+	uint64_t t0 = bench_now_ns();
+
+	while (LOAD(g_received) < n && LOAD(g_errors) == 0) {
+		BENCH_CHECK(bench_now_ns() - t0 < 10000000000ULL);
+		usleep(100);
+	}
+	BENCH_CHECK(LOAD(g_errors) == 0);
+}
+
+static void stream(noPollConn *client, const char *name, int mode, int frames, int large)
+{
+	static unsigned char buf[BENCH_LARGE_LEN];
+	uint64_t t0, t1;
+	int allocs, i, len;
+
+	STORE(g_mode, mode);
+	STORE(g_received, 0);
+	allocs = LOAD(g_allocs);
+	t0 = bench_now_ns();
+	for (i = 0; i < frames; i++) {
+		len = frame_len(i, large);
+		frame_fill(buf, i, len);
+		BENCH_CHECK(nopoll_conn_send_binary(client, (char *)buf, len) == len);
+	}
+	wait_received(frames);
+	t1 = bench_now_ns();
+	allocs = LOAD(g_allocs) - allocs;
+
+	bench_report(name, frames, t1 - t0);
+	printf("    %8.0f frames/s, %.2f allocations per frame\n",
+	       frames * 1e9 / (t1 - t0), (double)allocs / frames);
+}
+
+/* the client waits for each echo once BENCH_WINDOW frames are in flight */
+static void echo(noPollConn *client)
+{
+	static unsigned char buf[BENCH_MAX_LEN];
+	struct pollfd pfd;
+	noPollMsg *msg;
+	uint64_t t0, t1;
+	int allocs, sent = 0, got = 0, len, seq;
+
+	STORE(g_mode, MODE_ECHO);
+	STORE(g_received, 0);
+	allocs = LOAD(g_allocs);
+	pfd.fd = nopoll_conn_socket(client);
+	pfd.events = POLLIN;
+	t0 = bench_now_ns();
+	while (got < BENCH_FRAMES) {
+		if (sent < BENCH_FRAMES && sent - got < BENCH_WINDOW) {
+			len = frame_len(sent, 0);
+			frame_fill(buf, sent, len);
+			BENCH_CHECK(nopoll_conn_send_binary(client, (char *)buf, len) == len);
+			sent++;
+			continue;
+		}
+		msg = nopoll_conn_get_msg(client);
+		if (msg == NULL) {
+			BENCH_CHECK(nopoll_conn_is_ok(client) && LOAD(g_errors) == 0);
+			poll(&pfd, 1, 100);
+			continue;
+		}
+		BENCH_CHECK(frame_check(nopoll_msg_get_payload(msg),
+		                        nopoll_msg_get_payload_size(msg), &seq));
+		BENCH_CHECK(seq == got && nopoll_msg_get_payload_size(msg) == frame_len(got, 0));
+		nopoll_msg_unref(msg);
+		got++;
+	}
+	t1 = bench_now_ns();
+	allocs = LOAD(g_allocs) - allocs;
+
+	bench_report("nopoll echo (window 16)", BENCH_FRAMES, t1 - t0);
+	printf("    %8.0f round trips/s, %.2f allocations per round trip\n",
+	       BENCH_FRAMES * 1e9 / (t1 - t0), (double)allocs / BENCH_FRAMES);
+}
+
+static void mask_bench(void)
+{
+	static char ref[BENCH_MASK_LEN + 8], buf[BENCH_MASK_LEN + 8];
+	char mask[4] = { 0x12, (char)0xa5, 0x3c, (char)0xf0 };
+	uint64_t t0, t1;
+	int off, desp, len, k, i;
+
+	/* against the plain definition, at any alignment and key offset */
+	for (off = 0; off < 8; off++) {
+		for (desp = 0; desp < 4; desp++) {
+			for (len = 0; len < 67; len++) {
+				for (k = 0; k < len; k++)
+					ref[off + k] = buf[off + k] = (char)(k * 7 + off);
+				for (k = 0; k < len; k++)
+					ref[off + k] ^= mask[(k + desp) % 4];
+				nopoll_conn_mask_content(NULL, buf + off, len, mask, desp);
+				BENCH_CHECK(memcmp(ref + off, buf + off, len) == 0);
+			}
+		}
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < 20000; i++)
+		nopoll_conn_mask_content(NULL, buf + (i & 3), BENCH_MASK_LEN, mask, i & 3);
+	t1 = bench_now_ns();
+	bench_report("nopoll mask 1500 bytes", 20000, t1 - t0);
+}
+
+int main(void)
+{
+	noPollCtx *sctx, *cctx;
+	noPollConn *listener, *client;
+	pthread_t server;
+	int i;
+
+	mask_bench();
+
+	sctx = nopoll_ctx_new();
+	cctx = nopoll_ctx_new();
+	BENCH_CHECK(sctx != NULL && cctx != NULL);
+	nopoll_ctx_set_on_msg(sctx, server_on_msg, NULL);
+	listener = nopoll_listener_new(sctx, "127.0.0.1", BENCH_PORT);
+	BENCH_CHECK(nopoll_conn_is_ok(listener));
+	BENCH_CHECK(pthread_create(&server, NULL, server_task, sctx) == 0);
+
+	client = nopoll_conn_new(cctx, "127.0.0.1", BENCH_PORT, NULL, NULL, NULL, NULL);
+	BENCH_CHECK(nopoll_conn_wait_until_connection_ready(client, 5));
+
+	/* warm up the per-connection buffers */
+	stream(client, "nopoll warm up", MODE_SINK, BENCH_WINDOW, 0);
+	stream(client, "nopoll telemetry 64-200 bytes", MODE_SINK, BENCH_FRAMES, 0);
+	echo(client);
+	stream(client, "nopoll held messages", MODE_HOLD, BENCH_FRAMES, 0);
+	stream(client, "nopoll large frames 4000 bytes", MODE_JOIN, BENCH_LARGE_FRAMES, 1);
+
+	/* nopoll_loop_stop() isn't meant to be called from another thread */
+	STORE(g_mode, MODE_STOP);
+	STORE(g_received, 0);
+	frame_fill(g_stop, 0, sizeof(g_stop));
+	BENCH_CHECK(nopoll_conn_send_binary(client, (char *)g_stop, sizeof(g_stop)) == sizeof(g_stop));
+	pthread_join(server, NULL);
+	for (i = 0; i < BENCH_WINDOW; i++) {
+		if (g_held[i] != NULL)
+			nopoll_msg_unref(g_held[i]);
+	}
+	nopoll_conn_close(client);
+	nopoll_ctx_unref(cctx);
+	nopoll_ctx_unref(sctx);
+	nopoll_cleanup_library();
+	return 0;
+}
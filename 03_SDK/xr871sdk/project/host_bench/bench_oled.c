@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * OLED framebuffer (src/driver/component/oled/oled_fb.c). Every drawing is
+ * repeated on a plain pixel array from the bitmap format's definition,
+ * which is the golden image the framebuffer must equal, and a glyph is
+ * checked against a picture of it to pin the orientation. The flushes go
+ * to a model of the SSD1306 in horizontal addressing mode whose GDDRAM
+ * must then equal the framebuffer. The bytes and transfers of typical
+ * updates are counted against the per byte writes the driver used to do,
+ * and the cost of drawing and planning is measured.
+ */
+
+#include <string.h>
+#include "oled_fb.h"
+#include "oled_char_lib.h"
+#include "bench.h"
+
+/* assumed on the target: 8 MHz sclk, HAL_SPI_Transmit call and D/C pin */
+#define SPI_NS_PER_BYTE     1000
+#define SPI_NS_PER_XFER     12000
+
+static uint8_t ref[OLED_FB_HEIGHT][OLED_FB_WIDTH];
+
+static void ref_blit(int x, int y, int w, int h, const uint8_t *bmp)
+{
+	int i, j;
+
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			if (x + i < 0 || x + i >= OLED_FB_WIDTH ||
+			    y + j < 0 || y + j >= OLED_FB_HEIGHT)
+				continue;
+			ref[y + j][x + i] = (bmp[(j / 8) * w + i] >> (7 - j % 8)) & 1;
+		}
+	}
+}
+
+static void ref_fill(int x, int y, int w, int h, int color)
+{
+	int i, j;
+
+	for (j = y; j < y + h; j++) {
+		for (i = x; i < x + w; i++) {
+			if (i < 0 || i >= OLED_FB_WIDTH || j < 0 || j >= OLED_FB_HEIGHT)
+				continue;
+			if (color == OLED_FB_INVERT)
+				ref[j][i] ^= 1;
+			else
+				ref[j][i] = color == OLED_FB_WHITE;
+		}
+	}
+}
+
+static int fb_pixel(const uint8_t buf[OLED_FB_PAGES][OLED_FB_WIDTH], int x, int y)
+{
+	return (buf[OLED_FB_PAGES - 1 - y / 8][x] >> (7 - y % 8)) & 1;
+}
+
+static void check_ref(const struct oled_fb *fb)
+{
+	int x, y;
+
+	for (y = 0; y < OLED_FB_HEIGHT; y++)
+		for (x = 0; x < OLED_FB_WIDTH; x++)
+			BENCH_CHECK(fb_pixel(fb->buf, x, y) == ref[y][x]);
+}
+
+/* the controller, as far as the flush uses it */
+struct panel {
+	uint8_t     ram[OLED_FB_PAGES][OLED_FB_WIDTH];
+	int         col0, col1, page0, page1;
+	int         col, page;
+	uint8_t     cmd[3];
+	int         ncmd;
+	uint32_t    bytes;
+	uint32_t    xfers;
+};
+
+static void panel_cmd(struct panel *pn, uint8_t b)
+{
+	pn->cmd[pn->ncmd++] = b;
+	if (pn->cmd[0] != 0x21 && pn->cmd[0] != 0x22) {
+		pn->ncmd = 0;   /* not used by the flush */
+		return;
+	}
+	if (pn->ncmd < 3)
+		return;
+	if (pn->cmd[0] == 0x21) {
+		pn->col0 = pn->col = pn->cmd[1] & 0x7f;
+		pn->col1 = pn->cmd[2] & 0x7f;
+	} else {
+		pn->page0 = pn->page = pn->cmd[1] & 0x7;
+		pn->page1 = pn->cmd[2] & 0x7;
+	}
+	pn->ncmd = 0;
+}
+
+static void panel_data(struct panel *pn, uint8_t b)
+{
+	pn->ram[pn->page][pn->col] = b;
+	if (pn->col++ == pn->col1) {
+		pn->col = pn->col0;
+		if (pn->page++ == pn->page1)
+			pn->page = pn->page0;
+	}
+}
+
+static int panel_write(void *ctx, const uint8_t *buf, uint32_t len, int cmd)
+{
+	struct panel *pn = ctx;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (cmd)
+			panel_cmd(pn, buf[i]);
+		else
+			panel_data(pn, buf[i]);
+	}
+	pn->bytes += len;
+	pn->xfers++;
+	return 0;
+}
+
+static int flush(struct oled_fb *fb, struct panel *pn)
+{
+	int n;
+
+	pn->bytes = pn->xfers = 0;
+	n = oled_fb_flush(fb, panel_write, pn);
+	BENCH_CHECK(n == (int)pn->bytes);
+	BENCH_CHECK(!oled_fb_dirty(fb));
+	BENCH_CHECK(memcmp(pn->ram, fb->buf, sizeof(fb->buf)) == 0);
+	return n;
+}
+
+static const char *golden_A[16] = {
+	"........",
+	"........",
+	"........",
+	"...#....",
+	"...#....",
+	"...##...",
+	"..#.#...",
+	"..#.#...",
+	"..#..#..",
+	"..####..",
+	".#...#..",
+	".#....#.",
+	".#....#.",
+	"###..###",
+	"........",
+	"........",
+};
+
+static void test_golden(void)
+{
+	struct oled_fb fb;
+	int x, y;
+
+	oled_fb_init(&fb);
+	memset(ref, 0, sizeof(ref));
+	oled_fb_blit(&fb, 40, 21, 8, 16, ascii_1608['A' - ' ']);
+	for (y = 0; y < 16; y++) {
+		for (x = 0; x < 8; x++) {
+			int on = fb_pixel(fb.buf, 40 + x, 21 + y);
+			if (on != (golden_A[y][x] == '#')) {
+				for (y = 0; y < 16; y++, printf("\n"))
+					for (x = 0; x < 8; x++)
+						printf("%c", fb_pixel(fb.buf, 40 + x, 21 + y) ? '#' : '.');
+				BENCH_CHECK(0);
+			}
+		}
+	}
+	ref_blit(40, 21, 8, 16, ascii_1608['A' - ' ']);
+	check_ref(&fb);
+}
+
+static void test_random(void)
+{
+	static struct oled_fb fb;
+	static struct panel pn;
+	uint8_t bmp[OLED_FB_PAGES * 2 * OLED_FB_WIDTH];
+	int i, k, x, y, w, h;
+
+	srand(48);
+	oled_fb_init(&fb);
+	memset(ref, 0, sizeof(ref));
+	memset(&pn, 0, sizeof(pn));
+	BENCH_CHECK(flush(&fb, &pn) == 0);
+
+	for (i = 0; i < 20000; i++) {
+		x = rand() % 160 - 16;
+		y = rand() % 96 - 16;
+		w = rand() % 40 + 1;
+		h = rand() % 40 + 1;
+		if (rand() % 8 == 0) {
+			w = rand() % 140;
+			h = rand() % 80;
+		}
+		if (rand() % 2) {
+			for (k = 0; k < (h + 7) / 8 * w; k++)
+				bmp[k] = rand();
+			oled_fb_blit(&fb, x, y, w, h, bmp);
+			ref_blit(x, y, w, h, bmp);
+		} else {
+			k = rand() % 3;
+			oled_fb_fill(&fb, x, y, w, h, k);
+			ref_fill(x, y, w, h, k);
+		}
+		check_ref(&fb);
+		if (rand() % 4 == 0)
+			flush(&fb, &pn);
+	}
+	flush(&fb, &pn);
+}
+
+static void text(struct oled_fb *fb, int x, int y, const char *s)
+{
+	for (; *s; s++, x += 8)
+		oled_fb_blit(fb, x, y, 8, 16, ascii_1608[*s - ' ']);
+}
+
+struct update {
+	uint32_t    bytes;
+	uint32_t    xfers;
+};
+
+static void report(const char *name, const struct update *fb, const struct update *old)
+{
+	uint64_t t_fb = (uint64_t)fb->bytes * SPI_NS_PER_BYTE + (uint64_t)fb->xfers * SPI_NS_PER_XFER;
+	uint64_t t_old = (uint64_t)old->bytes * SPI_NS_PER_BYTE + (uint64_t)old->xfers * SPI_NS_PER_XFER;
+
+	printf("%-24s fb %5u bytes %4u xfers %7.1f us | per byte %5u xfers %8.1f us\n",
+	       name, fb->bytes, fb->xfers, t_fb / 1000.0, old->xfers, t_old / 1000.0);
+}
+
+/* the writes of the driver before: 3 commands and the data of each page, a byte per transfer */
+static void old_write(struct update *u, int pages, int width)
+{
+	u->bytes += pages * (3 + width);
+	u->xfers += pages * (3 + width);
+}
+
+static void test_updates(void)
+{
+	static struct oled_fb fb;
+	static struct panel pn;
+	struct update u, old;
+	char s[16];
+	int i, y;
+
+	oled_fb_init(&fb);
+	memset(&pn, 0, sizeof(pn));
+	BENCH_CHECK(flush(&fb, &pn) == 0);
+
+	/* nothing changed */
+	BENCH_CHECK(flush(&fb, &pn) == 0 && pn.xfers == 0);
+
+	/* one char: both pages in one window */
+	text(&fb, 0, 0, "A");
+	BENCH_CHECK(flush(&fb, &pn) == 6 + 16);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, 2, 8);
+	BENCH_CHECK(u.xfers == 3);
+	report("one char", &u, &old);
+
+	/* a clock, a digit changing */
+	text(&fb, 0, 48, "12:34:56");
+	flush(&fb, &pn);
+	text(&fb, 56, 48, "7");
+	flush(&fb, &pn);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, 2, 8);
+	report("clock second", &u, &old);
+
+	/* a status line of 16 chars rewritten */
+	text(&fb, 0, 16, "rssi -52 ch 6 ok");
+	flush(&fb, &pn);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, 2 * 16, 8);
+	report("status line", &u, &old);
+
+	/* a bar graph, 4 bars in distant columns of the lower half */
+	for (i = 0; i < 4; i++)
+		oled_fb_fill(&fb, 8 + i * 32, 40, 6, 24, i & 1 ? OLED_FB_WHITE : OLED_FB_BLACK);
+	flush(&fb, &pn);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, 4 * 3, 6);
+	report("4 bars", &u, &old);
+
+	/* full screen */
+	oled_fb_fill(&fb, 0, 0, OLED_FB_WIDTH, OLED_FB_HEIGHT, OLED_FB_INVERT);
+	BENCH_CHECK(flush(&fb, &pn) == 6 + OLED_FB_PAGES * OLED_FB_WIDTH);
+	BENCH_CHECK(pn.xfers == 2);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, OLED_FB_PAGES, OLED_FB_WIDTH);
+	report("full screen", &u, &old);
+
+	/* a page of 4 lines of text */
+	for (y = 0; y < 4; y++) {
+		snprintf(s, sizeof(s), "line %d of text", y);
+		text(&fb, 0, y * 16, s);
+	}
+	flush(&fb, &pn);
+	u.bytes = pn.bytes;
+	u.xfers = pn.xfers;
+	memset(&old, 0, sizeof(old));
+	old_write(&old, 4 * 2 * (int)strlen(s), 8);
+	report("4 lines of text", &u, &old);
+}
+
+static void bench_draw(void)
+{
+	static struct oled_fb fb;
+	static struct panel pn;
+	struct oled_fb_region r[OLED_FB_PAGES];
+	uint64_t t;
+	uint32_t i, n = 200000;
+	volatile int sink = 0;
+
+	oled_fb_init(&fb);
+	t = bench_now_ns();
+	for (i = 0; i < n; i++)
+		oled_fb_blit(&fb, (i * 8) % 120, 0, 8, 16, ascii_1608[i % 95]);
+	bench_report("oled_fb_blit char aligned", n, bench_now_ns() - t);
+
+	t = bench_now_ns();
+	for (i = 0; i < n; i++)
+		oled_fb_blit(&fb, (i * 8) % 120, 5, 8, 16, ascii_1608[i % 95]);
+	bench_report("oled_fb_blit char unaligned", n, bench_now_ns() - t);
+
+	t = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		oled_fb_mark(&fb, (i * 8) % 120, (i * 16) % 48, 8, 16);
+		sink += oled_fb_plan(&fb, r, OLED_FB_PAGES);
+	}
+	bench_report("oled_fb_mark + plan", n, bench_now_ns() - t);
+
+	n = 20000;
+	t = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		oled_fb_mark_all(&fb);
+		sink += oled_fb_flush(&fb, panel_write, &pn);
+	}
+	bench_report("oled_fb_flush full, to the model", n, bench_now_ns() - t);
+	(void)sink;
+}
+
+int main(void)
+{
+	test_golden();
+	test_random();
+	test_updates();
+	bench_draw();
+
+	printf("oled framebuffer checks passed\n");
+	return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "kernel/os/os.h"
+#include "bench.h"
+
+#define PINGPONG_ROUNDS		100000
+#define QUEUE_ITEMS			200000
+#define MUTEX_ROUNDS		1000000
+#define TIMER_PERIOD_MS		10
+#define TIMER_TICKS			50
+
+static OS_Semaphore_t g_ping;
+static OS_Semaphore_t g_pong;
+static OS_Semaphore_t g_done;
+static OS_Queue_t g_queue;
+static OS_Thread_t g_pong_thread;
+static OS_Thread_t g_consumer_thread;
+
+typedef struct {
+	uint32_t seq;
+	uint8_t data[12];
+} bench_item;
+
+static void pong_task(void *arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < PINGPONG_ROUNDS; i++) {
+		OS_SemaphoreWait(&g_ping, OS_WAIT_FOREVER);
+		OS_SemaphoreRelease(&g_pong);
+	}
+	OS_ThreadDelete(&g_pong_thread);
+}
+
+static void bench_semaphore(void)
+{
+	uint64_t t;
+	uint32_t i;
+
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_ping) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_pong) == OS_OK);
+	BENCH_CHECK(OS_ThreadCreate(&g_pong_thread, "pong", pong_task, NULL,
+	                            OS_THREAD_PRIO_APP, 1024) == OS_OK);
+
+	t = bench_now_ns();
+	for (i = 0; i < PINGPONG_ROUNDS; i++) {
+		OS_SemaphoreRelease(&g_ping);
+		OS_SemaphoreWait(&g_pong, OS_WAIT_FOREVER);
+	}
+	bench_report("semaphore ping-pong round trip", PINGPONG_ROUNDS, bench_now_ns() - t);
+
+	/* a binary semaphore can't be released twice */
+	BENCH_CHECK(OS_SemaphoreRelease(&g_ping) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreRelease(&g_ping) == OS_FAIL);
+	BENCH_CHECK(OS_SemaphoreWait(&g_ping, 0) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreWait(&g_ping, 0) == OS_E_TIMEOUT);
+
+	OS_MSleep(10); /* let pong_task exit */
+	OS_SemaphoreDelete(&g_ping);
+	OS_SemaphoreDelete(&g_pong);
+}
+
+static void consumer_task(void *arg)
+{
+	bench_item item;
+	uint32_t i;
+
+	for (i = 0; i < QUEUE_ITEMS; i++) {
+		OS_QueueReceive(&g_queue, &item, OS_WAIT_FOREVER);
+		if (item.seq != i) {
+			printf("queue item %u out of order, %u\n", i, item.seq);
+			exit(1);
+		}
+	}
+	OS_SemaphoreRelease(&g_done);
+	OS_ThreadDelete(&g_consumer_thread);
+}
+
+static void bench_queue(void)
+{
+	bench_item item;
+	uint64_t t;
+	uint32_t i;
+
+	BENCH_CHECK(OS_QueueCreate(&g_queue, 16, sizeof(bench_item)) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_done) == OS_OK);
+	BENCH_CHECK(OS_ThreadCreate(&g_consumer_thread, "consumer", consumer_task, NULL,
+	                            OS_THREAD_PRIO_APP, 1024) == OS_OK);
+
+	memset(&item, 0, sizeof(item));
+	t = bench_now_ns();
+	for (i = 0; i < QUEUE_ITEMS; i++) {
+		item.seq = i;
+		OS_QueueSend(&g_queue, &item, OS_WAIT_FOREVER);
+	}
+	OS_SemaphoreWait(&g_done, OS_WAIT_FOREVER);
+	bench_report("queue send/receive, 16 byte items", QUEUE_ITEMS, bench_now_ns() - t);
+
+	BENCH_CHECK(OS_QueueReceive(&g_queue, &item, 0) == OS_E_TIMEOUT);
+	OS_QueueDelete(&g_queue);
+	OS_SemaphoreDelete(&g_done);
+}
+
+static void bench_mutex(void)
+{
+	OS_Mutex_t mutex;
+	uint64_t t;
+	uint32_t i;
+
+	OS_MutexSetInvalid(&mutex);
+	BENCH_CHECK(OS_MutexCreate(&mutex) == OS_OK);
+	t = bench_now_ns();
+	for (i = 0; i < MUTEX_ROUNDS; i++) {
+		OS_MutexLock(&mutex, OS_WAIT_FOREVER);
+		OS_MutexUnlock(&mutex);
+	}
+	bench_report("mutex lock/unlock, uncontended", MUTEX_ROUNDS, bench_now_ns() - t);
+
+	/* a normal mutex isn't recursive, the second lock times out */
+	BENCH_CHECK(OS_MutexLock(&mutex, 0) == OS_OK);
+	BENCH_CHECK(OS_MutexLock(&mutex, 5) == OS_E_TIMEOUT);
+	BENCH_CHECK(OS_MutexGetOwner(&mutex) == OS_ThreadGetCurrentHandle());
+	OS_MutexUnlock(&mutex);
+	BENCH_CHECK(OS_MutexUnlock(&mutex) == OS_FAIL);
+	OS_MutexDelete(&mutex);
+
+	BENCH_CHECK(OS_RecursiveMutexCreate(&mutex) == OS_OK);
+	BENCH_CHECK(OS_RecursiveMutexLock(&mutex, 0) == OS_OK);
+	BENCH_CHECK(OS_RecursiveMutexLock(&mutex, 0) == OS_OK);
+	BENCH_CHECK(OS_RecursiveMutexUnlock(&mutex) == OS_OK);
+	BENCH_CHECK(OS_MutexGetOwner(&mutex) != NULL);
+	BENCH_CHECK(OS_RecursiveMutexUnlock(&mutex) == OS_OK);
+	BENCH_CHECK(OS_MutexGetOwner(&mutex) == NULL);
+	OS_RecursiveMutexDelete(&mutex);
+}
+
+static OS_Time_t g_timer_last;
+static uint32_t g_timer_count;
+static uint32_t g_timer_jitter;
+
+static void timer_cb(void *arg)
+{
+	OS_Time_t now = OS_GetTicks();
+	uint32_t diff;
+
+	if (g_timer_count > 0) {
+		diff = OS_TicksToMSecs(now - g_timer_last);
+		diff = diff > TIMER_PERIOD_MS ? diff - TIMER_PERIOD_MS : TIMER_PERIOD_MS - diff;
+		if (diff > g_timer_jitter)
+			g_timer_jitter = diff;
+	}
+	g_timer_last = now;
+	if (++g_timer_count == TIMER_TICKS) {
+		OS_TimerStop((OS_Timer_t *)arg);
+		OS_SemaphoreRelease(&g_done);
+	}
+}
+
+static void bench_timer(void)
+{
+	OS_Timer_t timer;
+	OS_Time_t start;
+	uint32_t elapsed;
+
+	OS_TimerSetInvalid(&timer);
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_done) == OS_OK);
+	BENCH_CHECK(OS_TimerCreate(&timer, OS_TIMER_PERIODIC, timer_cb, &timer,
+	                           TIMER_PERIOD_MS) == OS_OK);
+	BENCH_CHECK(!OS_TimerIsActive(&timer));
+
+	start = OS_GetTicks();
+	OS_TimerStart(&timer);
+	BENCH_CHECK(OS_SemaphoreWait(&g_done, 10 * TIMER_PERIOD_MS * TIMER_TICKS) == OS_OK);
+	elapsed = OS_TicksToMSecs(OS_GetTicks() - start);
+	BENCH_CHECK(!OS_TimerIsActive(&timer));
+	printf("%-36s %9u ticks %9u ms, max jitter %u ms\n", "periodic timer, 10 ms",
+	       TIMER_TICKS, elapsed, g_timer_jitter);
+
+	/* a wait times out after its time, not earlier */
+	start = OS_GetTicks();
+	BENCH_CHECK(OS_SemaphoreWait(&g_done, 20) == OS_E_TIMEOUT);
+	BENCH_CHECK(OS_TicksToMSecs(OS_GetTicks() - start) >= 20);
+
+	OS_TimerDelete(&timer);
+	OS_SemaphoreDelete(&g_done);
+}
+
+int main(void)
+{
+	bench_semaphore();
+	bench_queue();
+	bench_mutex();
+	bench_timer();
+	return 0;
+}
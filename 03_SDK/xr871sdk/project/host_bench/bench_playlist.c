@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Play list index of evb_audio (project/evb_audio/play_list.c) over FatFs
+ * and a file backed card with 10000 songs in 40 albums. The first build of
+ * the index against a plain walk of the directories like the old text list
+ * did at every start, then a restart with the index up to date, and an
+ * incremental update after songs and an album are added like a PC would.
+ * Then random access, search and shuffle. Card commands are counted along
+ * the time, and the list is checked against the songs on the card.
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "fs/fatfs/ff.h"
+#include "common/framework/fs_ctrl.h"
+#include "play_list.h"
+#include "sd_image.h"
+#include "bench.h"
+
+#define IMAGE_SECTORS   (1024 * 1024)           /* 512 MB, sparse */
+#define SEC_PER_CLUS    8
+#define ARTISTS         10
+#define ALBUMS          4
+#define TRACKS          250
+#define SONGS           (ARTISTS * ALBUMS * TRACKS)
+#define ADD_TRACKS      50                      /* added to an album */
+#define NEW_TRACKS      30                      /* in a new album */
+#define SONGS_MAX       (SONGS + ADD_TRACKS + NEW_TRACKS + 1)
+#define GETS            10000
+#define FINDS           1000
+#define PATH_LEN        96
+#define KEY_LEN         12                      /* PLAY_LIST_KEY_LEN */
+
+/* no system control on the host, fs_ctrl only notifies it */
+int sys_event_send(uint16_t type, uint16_t subtype, uint32_t data, uint32_t wait_ms)
+{
+	return 0;
+}
+
+observer_base *callback_observer_create(uint32_t event,
+                                        void (*cb)(uint32_t event, uint32_t data, void *arg),
+                                        void *arg)
+{
+	static observer_base base;
+
+	return &base;
+}
+
+int sys_ctrl_attach(observer_base *obs)
+{
+	return 0;
+}
+
+/* the songs on the card, and the songs of the play list */
+static char (*songs)[PATH_LEN];
+static char (*listed)[PATH_LEN];
+static uint32_t song_num;
+static uint32_t id_next;
+static uint16_t touch_time;
+
+static void report_cmds(const char *name, uint32_t ops, uint64_t ns)
+{
+	sd_image_stat st;
+
+	sd_image_get_stat(&st);
+	bench_report(name, ops, ns);
+	printf("  card: %u+%u reads (%u sectors), %u+%u writes (%u sectors)\n",
+	       st.read_single, st.read_multi, st.read_sectors,
+	       st.write_single, st.write_multi, st.write_sectors);
+}
+
+static int path_cmp(const void *a, const void *b)
+{
+	return strcmp(a, b);
+}
+
+/* set the time of a directory, like a PC adding a file to it */
+static void touch(const char *dir)
+{
+	FILINFO fno;
+
+	fno.fdate = ((2020 - 1980) << 9) | (1 << 5) | 1;
+	fno.ftime = touch_time++;
+	BENCH_CHECK(f_utime(dir, &fno) == FR_OK);
+}
+
+static void add_song(const char *dir, uint32_t track)
+{
+	FIL f;
+
+	BENCH_CHECK(song_num < SONGS_MAX);
+	snprintf(songs[song_num], PATH_LEN, "%s/%03u - Title %05u.mp3", dir, track, id_next++);
+	BENCH_CHECK(f_open(&f, songs[song_num], FA_CREATE_NEW | FA_WRITE) == FR_OK);
+	BENCH_CHECK(f_close(&f) == FR_OK);
+	song_num++;
+}
+
+static void add_file(const char *dir, const char *name)
+{
+	char path[PATH_LEN];
+	FIL f;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	BENCH_CHECK(f_open(&f, path, FA_CREATE_NEW | FA_WRITE) == FR_OK);
+	BENCH_CHECK(f_close(&f) == FR_OK);
+}
+
+static void make_library(void)
+{
+	char dir[PATH_LEN];
+	uint32_t a, b, t;
+
+	BENCH_CHECK(f_mkdir("0:/music") == FR_OK);
+	for (a = 0; a < ARTISTS; a++) {
+		snprintf(dir, sizeof(dir), "0:/music/Artist %02u", a);
+		BENCH_CHECK(f_mkdir(dir) == FR_OK);
+		for (b = 0; b < ALBUMS; b++) {
+			snprintf(dir, sizeof(dir), "0:/music/Artist %02u/Album %u", a, b);
+			BENCH_CHECK(f_mkdir(dir) == FR_OK);
+			/* in reverse order, the index sorts them */
+			for (t = TRACKS; t > 0; t--)
+				add_song(dir, t);
+			add_file(dir, "cover.jpg");
+			add_file(dir, "notes.txt");
+		}
+	}
+}
+
+/* what the old text list did at every start, without writing the list */
+static uint32_t walk(const char *path)
+{
+	char sub[PATH_LEN + _MAX_LFN + 2];
+	FILINFO fno;
+	DIR dir;
+	uint32_t n = 0;
+	const char *ext;
+
+	BENCH_CHECK(f_opendir(&dir, path) == FR_OK);
+	while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0]) {
+		if (fno.fattrib & AM_DIR) {
+			snprintf(sub, sizeof(sub), "%s/%s", path, fno.fname);
+			n += walk(sub);
+		} else {
+			ext = strrchr(fno.fname, '.');
+			n += (ext != NULL && strcasecmp(ext, ".mp3") == 0);
+		}
+	}
+	BENCH_CHECK(f_closedir(&dir) == FR_OK);
+	return n;
+}
+
+static const char *base_name(const char *path)
+{
+	return strrchr(path, '/') + 1;
+}
+
+/* the play list holds every song once, sorted by name in each directory */
+static void check_list(void)
+{
+	char buf[PLAY_LIST_PATH_MAX];
+	uint32_t i, n = play_list_count();
+	size_t dir_len;
+
+	BENCH_CHECK(n == song_num);
+	for (i = 0; i < n; i++) {
+		BENCH_CHECK(play_list_get(i, buf, sizeof(buf)) == 0);
+		BENCH_CHECK(strncmp(buf, "file://", 7) == 0 && strlen(buf + 7) < PATH_LEN);
+		strcpy(listed[i], buf + 7);
+		if (i == 0)
+			continue;
+		dir_len = base_name(listed[i]) - listed[i];
+		if (dir_len == base_name(listed[i - 1]) - listed[i - 1] &&
+		    strncmp(listed[i], listed[i - 1], dir_len) == 0)
+			BENCH_CHECK(strncasecmp(base_name(listed[i - 1]), base_name(listed[i]), KEY_LEN) <= 0);
+	}
+	BENCH_CHECK(play_list_get(n, buf, sizeof(buf)) == -1);
+
+	qsort(listed, n, PATH_LEN, path_cmp);
+	qsort(songs, n, PATH_LEN, path_cmp);
+	for (i = 0; i < n; i++)
+		BENCH_CHECK(strcmp(listed[i], songs[i]) == 0);
+}
+
+static void build(void)
+{
+	uint64_t t;
+	uint32_t n;
+
+	BENCH_CHECK(fs_ctrl_init() == 0);
+	BENCH_CHECK(fs_ctrl_mount(FS_MNT_DEV_TYPE_SDCARD, 0) == 0);
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	n = walk("0:/music");
+	report_cmds("walk of the music dir", n, bench_now_ns() - t);
+	BENCH_CHECK(n == song_num);
+
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	BENCH_CHECK(play_list_init() == 0);
+	report_cmds("first build of the index", song_num, bench_now_ns() - t);
+	check_list();
+}
+
+static void restart(void)
+{
+	sd_image_stat st;
+	uint64_t t;
+
+	play_list_deinit();
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	BENCH_CHECK(play_list_init() == 0);
+	report_cmds("restart, index up to date", song_num, bench_now_ns() - t);
+	sd_image_get_stat(&st);
+	BENCH_CHECK(st.write_sectors == 0);
+	BENCH_CHECK(play_list_count() == song_num);
+}
+
+static void update(void)
+{
+	char dir[PATH_LEN];
+	uint64_t t;
+	uint32_t i, n = song_num;
+
+	/* songs added to an album, and a new album of an artist */
+	snprintf(dir, sizeof(dir), "0:/music/Artist %02u/Album %u", 3, 2);
+	for (i = 0; i < ADD_TRACKS; i++)
+		add_song(dir, TRACKS + 1 + i);
+	touch(dir);
+	snprintf(dir, sizeof(dir), "0:/music/Artist %02u/Album %u", 7, ALBUMS);
+	BENCH_CHECK(f_mkdir(dir) == FR_OK);
+	for (i = 0; i < NEW_TRACKS; i++)
+		add_song(dir, i + 1);
+	snprintf(dir, sizeof(dir), "0:/music/Artist %02u", 7);
+	touch(dir);
+
+	play_list_deinit();
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	BENCH_CHECK(play_list_init() == 0);
+	report_cmds("incremental update, 2 dirs changed", song_num - n, bench_now_ns() - t);
+	check_list();
+
+	/* FatFs leaves the time of the directory, a forced update is needed */
+	snprintf(dir, sizeof(dir), "0:/music/Artist %02u/Album %u", 0, 0);
+	add_song(dir, TRACKS + 1);
+	BENCH_CHECK(play_list_update(0) == 0);
+	BENCH_CHECK(play_list_count() == song_num - 1);
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	BENCH_CHECK(play_list_update(1) == 0);
+	report_cmds("forced update", song_num, bench_now_ns() - t);
+	check_list();
+}
+
+static void browse(void)
+{
+	char buf[PLAY_LIST_PATH_MAX];
+	uint8_t *seen;
+	uint64_t t;
+	uint32_t i, n = play_list_count(), seed = 1;
+	char (*p)[PATH_LEN];
+	int idx;
+
+	/* listed[] is sorted by check_list() */
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	for (i = 0; i < GETS; i++) {
+		seed = seed * 1103515245 + 12345;
+		BENCH_CHECK(play_list_get((seed >> 8) % n, buf, sizeof(buf)) == 0);
+		BENCH_CHECK(bsearch(buf + 7, listed, n, PATH_LEN, path_cmp) != NULL);
+	}
+	report_cmds("play_list_get, random", GETS, bench_now_ns() - t);
+
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	for (i = 0; i < FINDS; i++) {
+		const char *name;
+
+		seed = seed * 1103515245 + 12345;
+		name = base_name(songs[(seed >> 8) % n]);
+		idx = play_list_find(name);
+		BENCH_CHECK(idx >= 0);
+		BENCH_CHECK(play_list_get(idx, buf, sizeof(buf)) == 0);
+		BENCH_CHECK(strcmp(base_name(buf), name) == 0);
+	}
+	report_cmds("play_list_find, full name", FINDS, bench_now_ns() - t);
+	BENCH_CHECK(play_list_find("No such song.mp3") == -1);
+
+	/* a shuffled round plays every song once */
+	seen = calloc(n, 1);
+	BENCH_CHECK(seen != NULL);
+	play_list_set_shuffle(1);
+	sd_image_reset_stat();
+	t = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		BENCH_CHECK(player_read_song(PLAYER_NEXT, buf, sizeof(buf)) == 0);
+		p = bsearch(buf + 7, listed, n, PATH_LEN, path_cmp);
+		BENCH_CHECK(p != NULL && !seen[p - listed]);
+		seen[p - listed] = 1;
+	}
+	report_cmds("player_read_song, shuffled", n, bench_now_ns() - t);
+	play_list_set_shuffle(0);
+	free(seen);
+}
+
+int main(void)
+{
+	songs = malloc(SONGS_MAX * PATH_LEN);
+	listed = malloc(SONGS_MAX * PATH_LEN);
+	BENCH_CHECK(songs != NULL && listed != NULL);
+
+	BENCH_CHECK(sd_image_open("playlist.img", IMAGE_SECTORS) == 0);
+	BENCH_CHECK(sd_image_format(SEC_PER_CLUS) == 0);
+
+	/* the library is made before fs_ctrl mounts the card */
+	{
+		FATFS fs;
+
+		BENCH_CHECK(f_mount(&fs, "", 1) == FR_OK);
+		make_library();
+		BENCH_CHECK(f_mount(NULL, "", 0) == FR_OK);
+	}
+
+	build();
+	restart();
+	update();
+	browse();
+
+	play_list_deinit();
+	sd_image_close();
+	remove("playlist.img");
+	free(listed);
+	free(songs);
+	printf("play list checks passed\n");
+	return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Resume of the PM normal phase (src/pm/pm_async.c) over mock devices with
+ * configurable latencies: list order of the synchronous devices, the deps,
+ * the worker limit and the overlap of the async devices, then the latency
+ * histograms and the wall time of a serial and an overlapped resume.
+ */
+
+#include <string.h>
+#include "kernel/os/os.h"
+#include "pm/pm.h"
+#include "../../src/pm/pm_i.h"
+#include "bench.h"
+
+#define MOCK_MAX        8
+#define BENCH_CYCLES    10
+
+struct mock {
+	struct soc_device dev;
+	uint32_t latency_ms;
+	int fail;
+	uint32_t start;         /* sequence numbers, 0 until it happened */
+	uint32_t end;
+};
+
+static struct mock g_mock[MOCK_MAX];
+static int g_mock_num;
+static uint32_t g_seq;
+static int g_running;           /* async resumes in progress */
+static int g_running_max;
+static int g_errors;
+
+static LIST_HEAD_DEF(g_from);
+static LIST_HEAD_DEF(g_to);
+
+static uint32_t seq_next(void)
+{
+	return __atomic_add_fetch(&g_seq, 1, __ATOMIC_SEQ_CST);
+}
+
+static struct mock *mock_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < g_mock_num; i++) {
+		if (!strcmp(g_mock[i].dev.name, name))
+			return &g_mock[i];
+	}
+	return NULL;
+}
+
+static int mock_suspend(struct soc_device *dev, enum suspend_state_t state)
+{
+	return 0;
+}
+
+static int mock_resume(struct soc_device *dev, enum suspend_state_t state)
+{
+	struct mock *m = (struct mock *)dev;
+	const char *const *name;
+	int n;
+
+	__atomic_store_n(&m->start, seq_next(), __ATOMIC_SEQ_CST);
+	for (name = dev->deps; name && *name; name++) {
+		struct mock *dep = mock_find(*name);
+		/* a dep resumed after dev in list order isn't waited for */
+		if (dep && dep < m && !__atomic_load_n(&dep->end, __ATOMIC_SEQ_CST)) {
+			printf("%s started before %s finished\n", dev->name, *name);
+			__atomic_add_fetch(&g_errors, 1, __ATOMIC_SEQ_CST);
+		}
+	}
+	if (dev->async) {
+		n = __atomic_add_fetch(&g_running, 1, __ATOMIC_SEQ_CST);
+		if (n > __atomic_load_n(&g_running_max, __ATOMIC_SEQ_CST))
+			__atomic_store_n(&g_running_max, n, __ATOMIC_SEQ_CST);
+	}
+	if (m->latency_ms)
+		OS_MSleep(m->latency_ms);
+	if (dev->async)
+		__atomic_sub_fetch(&g_running, 1, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&m->end, seq_next(), __ATOMIC_SEQ_CST);
+
+	return m->fail ? -1 : 0;
+}
+
+static const struct soc_device_driver mock_drv = {
+	.name = "mock",
+	.suspend = mock_suspend,
+	.resume = mock_resume,
+};
+
+static void mock_add(const char *name, uint32_t latency_ms, int async,
+                     const char *const *deps)
+{
+	struct mock *m = &g_mock[g_mock_num++];
+
+	memset(m, 0, sizeof(*m));
+	m->dev.name = name;
+	m->dev.driver = &mock_drv;
+	m->dev.async = async;
+	m->dev.deps = deps;
+	m->latency_ms = latency_ms;
+}
+
+/* put every mock on the suspended list in resume order, clear the stamps */
+static void mock_suspend_all(void)
+{
+	int i;
+
+	INIT_LIST_HEAD(&g_from);
+	INIT_LIST_HEAD(&g_to);
+	for (i = 0; i < g_mock_num; i++) {
+		g_mock[i].start = g_mock[i].end = 0;
+		list_add_tail(&g_mock[i].dev.node[PM_OP_NORMAL], &g_from);
+	}
+	g_running_max = 0;
+}
+
+static uint64_t mock_resume_all(int expect_failed)
+{
+	uint64_t t0 = bench_now_ns();
+	int i, failed;
+
+	mock_suspend_all();
+	failed = dpm_resume_async(&g_from, &g_to, PM_MODE_STANDBY);
+	t0 = bench_now_ns() - t0;
+
+	BENCH_CHECK(failed == expect_failed);
+	BENCH_CHECK(list_empty(&g_from));
+	BENCH_CHECK(g_errors == 0);
+	BENCH_CHECK(g_running_max <= PM_ASYNC_WORKERS);
+	for (i = 0; i < g_mock_num; i++) {
+		struct soc_device *dev = &g_mock[i].dev;
+		BENCH_CHECK(g_mock[i].start && g_mock[i].end);
+		BENCH_CHECK(!(dev->pm_flags & PM_DEV_PENDING));
+		BENCH_CHECK(!!(dev->pm_flags & PM_DEV_FAILED) == g_mock[i].fail);
+		BENCH_CHECK(dev->ref == 0);
+	}
+	/* moved to the head like the serial walk, reversing the order */
+	BENCH_CHECK(g_to.next == &g_mock[g_mock_num - 1].dev.node[PM_OP_NORMAL]);
+
+	return t0;
+}
+
+/* synchronous devices run in list order and finish before anything after
+ * them starts; a queued device may be picked up by its worker later. */
+static void check_sync_order(void)
+{
+	int i, j;
+
+	for (i = 0; i < g_mock_num; i++) {
+		if (g_mock[i].dev.async)
+			continue;
+		for (j = 0; j < i; j++) {
+			if (!g_mock[j].dev.async)
+				BENCH_CHECK(g_mock[j].end < g_mock[i].start);
+		}
+		for (j = i + 1; j < g_mock_num; j++)
+			BENCH_CHECK(g_mock[i].end < g_mock[j].start);
+	}
+}
+
+static uint32_t serial_ms(void)
+{
+	uint32_t ms = 0;
+	int i;
+
+	for (i = 0; i < g_mock_num; i++)
+		ms += g_mock[i].latency_ms;
+	return ms;
+}
+
+static const char *const codec_deps[] = { "I2S", NULL };
+static const char *const app_deps[] = { "sdc", NULL };
+static const char *const early_deps[] = { "wlan_sys", NULL };
+
+/* the board's slow devices between fast synchronous ones */
+static void mock_board(void)
+{
+	g_mock_num = 0;
+	mock_add("flash", 1, 0, NULL);
+	mock_add("I2S", 3, 0, NULL);
+	mock_add("sdc", 40, 1, NULL);
+	mock_add("CODEC", 30, 1, codec_deps);
+	mock_add("uart", 1, 0, NULL);
+	mock_add("wlan_sys", 40, 1, NULL);
+	mock_add("app", 2, 0, app_deps);
+}
+
+static void test_inline(void)
+{
+	int i;
+
+	mock_board();
+	mock_resume_all(0);
+	check_sync_order();
+	for (i = 1; i < g_mock_num; i++)
+		BENCH_CHECK(g_mock[i - 1].end < g_mock[i].start);
+}
+
+static void test_async(void)
+{
+	uint64_t ns;
+	struct mock *m;
+
+	mock_board();
+	ns = mock_resume_all(0);
+	check_sync_order();
+
+	/* deps and the worker limit */
+	BENCH_CHECK(mock_find("I2S")->end < mock_find("CODEC")->start);
+	BENCH_CHECK(mock_find("sdc")->end < mock_find("app")->start);
+	BENCH_CHECK(g_running_max == PM_ASYNC_WORKERS);
+
+	/* sdc and CODEC overlap, wlan_sys waits for one of them */
+	BENCH_CHECK(mock_find("CODEC")->start < mock_find("sdc")->end);
+	m = mock_find("wlan_sys");
+	BENCH_CHECK(m->start > mock_find("sdc")->end ||
+	            m->start > mock_find("CODEC")->end);
+	BENCH_CHECK(ns / 1000000 < serial_ms() * 3 / 4);
+
+	/* a failure is counted and the others still resume */
+	mock_find("CODEC")->fail = 1;
+	mock_find("app")->fail = 1;
+	mock_resume_all(2);
+	mock_find("CODEC")->fail = 0;
+	mock_find("app")->fail = 0;
+}
+
+/* a dep later in list order can't be waited for, it must not block */
+static void test_misordered(void)
+{
+	mock_board();
+	g_mock[0].dev.deps = early_deps;
+	mock_resume_all(0);
+	check_sync_order();
+}
+
+static void test_hist(void)
+{
+	static const struct {
+		uint32_t us;
+		int bucket;
+	} s[] = {
+		{ 0, 0 }, { 127, 0 }, { 128, 1 }, { 511, 1 }, { 512, 2 },
+		{ 2047, 2 }, { 2048, 3 }, { 8191, 3 }, { 8192, 4 },
+		{ 32767, 4 }, { 32768, 5 }, { 0xffffffff, 5 },
+	};
+	struct pm_time_stats st;
+	uint32_t i, j;
+
+	for (i = 0; i < sizeof(s) / sizeof(s[0]); i++) {
+		memset(&st, 0, sizeof(st));
+		pm_time_add(&st, s[i].us);
+		for (j = 0; j < PM_TIME_BUCKETS; j++)
+			BENCH_CHECK(st.hist[j] == (j == s[i].bucket));
+		BENCH_CHECK(st.count == 1 && st.max_us == s[i].us);
+	}
+
+	memset(&st, 0, sizeof(st));
+	for (i = 0; i < 70000; i++)
+		pm_time_add(&st, 100);
+	BENCH_CHECK(st.hist[0] == UINT16_MAX && st.count == 70000);
+	BENCH_CHECK(st.sum_us == 7000000);
+}
+
+static void bench_resume(const char *name)
+{
+	struct mock *m;
+	uint64_t ns = 0;
+	uint32_t i, count;
+
+	mock_board();
+	for (i = 0; i < (uint32_t)g_mock_num; i++)
+		memset(g_mock[i].dev.time, 0, sizeof(g_mock[i].dev.time));
+	for (i = 0; i < BENCH_CYCLES; i++)
+		ns += mock_resume_all(0);
+	bench_report(name, BENCH_CYCLES, ns);
+
+	/* every cycle lands in the device's histogram, around its latency */
+	m = mock_find("sdc");
+	count = m->dev.time[PM_OP_NORMAL][PM_TIME_RESUME].count;
+	BENCH_CHECK(count == BENCH_CYCLES);
+	BENCH_CHECK(m->dev.time[PM_OP_NORMAL][PM_TIME_RESUME].hist[5] == count);
+	BENCH_CHECK(m->dev.time[PM_OP_NORMAL][PM_TIME_RESUME].max_us >= 39000);
+}
+
+int main(void)
+{
+	test_hist();
+	test_inline();
+	bench_resume("resume serial (ms scale)");
+
+	BENCH_CHECK(pm_async_start() == 0);
+	test_async();
+	test_misordered();
+	bench_resume("resume async (ms scale)");
+	pm_async_stop();
+
+	/* restartable, and inline again once stopped */
+	BENCH_CHECK(pm_async_start() == 0);
+	pm_async_stop();
+	test_inline();
+
+	printf("pm resume checks passed\n");
+	return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Run time statistic accounting (src/kernel/FreeRTOS/Source/rtstat.c) fed with
+ * synthetic context switch traces, as the FreeRTOS hooks would: a hand written
+ * one, one crossing 2^32 ticks, then a random schedule of prioritized
+ * tasks checked against a model.
+ */
+
+#include <string.h>
+#include "kernel/FreeRTOS/rtstat.h"
+#include "bench.h"
+
+#define SIM_TASKS       8       /* task 0 has the idle priority */
+#define SIM_STEPS       2000000
+
+static struct rtstat g_st;
+
+static uint32_t hist_bucket(uint32_t ticks)
+{
+	uint32_t n = 0;
+
+	while (ticks >= 2 && n < RTSTAT_HIST_NUM - 1) {
+		ticks >>= 1;
+		n++;
+	}
+	return n;
+}
+
+/* switch from one task to another at the given time, as vTaskSwitchContext() */
+static void trace_switch(struct rtstat_task *out, int ready, struct rtstat_task *in, uint64_t now)
+{
+	rtstat_switch_out(&g_st, out, ready, now);
+	rtstat_switch_in(&g_st, in);
+}
+
+static void test_trace(void)
+{
+	struct rtstat_task idle, a, b, t;
+
+	memset(&g_st, 0, sizeof(g_st));
+	memset(&idle, 0, sizeof(idle));
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+
+	rtstat_reset(&g_st, 1000);
+	rtstat_switch_in(&g_st, &idle);
+	rtstat_task_ready(&g_st, &a, 1100);         /* from an interrupt */
+	trace_switch(&idle, 0, &a, 1110);           /* waited 10 */
+	rtstat_task_ready(&g_st, &b, 1500);
+	rtstat_task_ready(&g_st, &b, 1550);         /* already ready */
+	trace_switch(&a, 0, &b, 1600);              /* a blocks, b waited 100 */
+	rtstat_task_ready(&g_st, &a, 1700);
+	trace_switch(&b, 1, &a, 1705);              /* b preempted, a waited 5 */
+	trace_switch(&a, 1, &a, 1750);              /* a yields to nobody */
+	trace_switch(&a, 0, &b, 1800);              /* b waited 95 */
+	trace_switch(&b, 0, &idle, 2000);
+
+	rtstat_task_get(&g_st, &idle, &t);
+	BENCH_CHECK(t.run_time == 110 && t.switches == 2 && t.latency_max == 0);
+	rtstat_task_get(&g_st, &a, &t);
+	BENCH_CHECK(t.run_time == 585 && t.switches == 2 && t.latency_max == 10);
+	rtstat_task_get(&g_st, &b, &t);
+	BENCH_CHECK(t.run_time == 305 && t.switches == 2 && t.latency_max == 100);
+
+	BENCH_CHECK(rtstat_hist_num(&g_st.latency) == 4);
+	BENCH_CHECK(g_st.latency.count[2] == 1 && g_st.latency.count[3] == 1 &&
+	            g_st.latency.count[6] == 2);
+	BENCH_CHECK(g_st.latency.max == 100 && g_st.latency.sum == 210);
+
+	/* a reset in a critical section, the section is counted whole */
+	rtstat_critical_enter(&g_st, 2010);
+	rtstat_reset(&g_st, 2020);
+	rtstat_critical_exit(&g_st, 2040);
+	BENCH_CHECK(rtstat_hist_num(&g_st.critical) == 1 && g_st.critical.count[4] == 1);
+	BENCH_CHECK(rtstat_hist_num(&g_st.latency) == 0);
+
+	/* the figures of before are gone, the running idle task goes on */
+	rtstat_task_get(&g_st, &a, &t);
+	BENCH_CHECK(t.run_time == 0 && t.switches == 0);
+	rtstat_task_ready(&g_st, &a, 2100);
+	trace_switch(&idle, 0, &a, 2101);
+	rtstat_task_get(&g_st, &idle, &t);
+	BENCH_CHECK(t.run_time == 81 && t.switches == 0);
+	rtstat_task_get(&g_st, &a, &t);
+	BENCH_CHECK(t.switches == 1 && t.latency_max == 1 && g_st.latency.count[0] == 1);
+}
+
+static void test_wrap(void)
+{
+	struct rtstat_task idle, a, t;
+
+	memset(&g_st, 0, sizeof(g_st));
+	memset(&idle, 0, sizeof(idle));
+	memset(&a, 0, sizeof(a));
+
+	rtstat_reset(&g_st, 0xffffff00);
+	rtstat_switch_in(&g_st, &idle);
+	rtstat_task_ready(&g_st, &a, 0xfffffff0);
+	trace_switch(&idle, 0, &a, 0x100000010ULL);
+	rtstat_critical_enter(&g_st, 0x100000020ULL);
+	rtstat_critical_exit(&g_st, 0x100000120ULL);
+	trace_switch(&a, 0, &idle, 0x100000200ULL);
+
+	rtstat_task_get(&g_st, &idle, &t);
+	BENCH_CHECK(t.run_time == 0x110);
+	rtstat_task_get(&g_st, &a, &t);
+	BENCH_CHECK(t.run_time == 0x1f0 && t.latency_max == 0x20);
+	BENCH_CHECK(g_st.critical.max == 0x100 && g_st.critical.count[8] == 1);
+
+	/* idle runs for longer than 2^32 ticks, a waits as long and is clamped */
+	rtstat_task_ready(&g_st, &a, 0x100000300ULL);
+	trace_switch(&idle, 0, &a, 0x300000300ULL);
+	rtstat_task_get(&g_st, &idle, &t);
+	BENCH_CHECK(t.run_time == 0x110 + 0x200000100ULL);
+	rtstat_task_get(&g_st, &a, &t);
+	BENCH_CHECK(t.latency_max == UINT32_MAX);
+	BENCH_CHECK(g_st.latency.max == UINT32_MAX &&
+	            g_st.latency.count[RTSTAT_HIST_NUM - 1] == 1);
+}
+
+/*
+ * Tasks of increasing priorities get ready at random times and run for a
+ * random while. The model knows when each one got ready and how long it ran.
+ */
+static void test_random(void)
+{
+	struct rtstat_task task[SIM_TASKS], t;
+	uint64_t run[SIM_TASKS] = { 0 };
+	uint64_t ready_at[SIM_TASKS], now = 0xfff00000, last, reset_at;
+	uint32_t lat_max[SIM_TASKS] = { 0 };
+	uint32_t hist[RTSTAT_HIST_NUM] = { 0 };
+	int ready[SIM_TASKS] = { 0 };
+	uint32_t seed = 1, lat;
+	uint64_t lat_num = 0, lat_sum = 0, total = 0;
+	int cur = 0, next, i, k;
+
+	memset(&g_st, 0, sizeof(g_st));
+	memset(task, 0, sizeof(task));
+	rtstat_reset(&g_st, now);
+	rtstat_switch_in(&g_st, &task[0]);
+	reset_at = last = now;
+
+	for (i = 0; i < SIM_STEPS; i++) {
+		seed = seed * 1103515245 + 12345;
+		now += (seed >> 16) % 500;
+		k = (seed >> 8) % SIM_TASKS;
+
+		if (k != 0 && k != cur && (seed & 1)) {
+			/* k gets ready, preempting the current one if lower */
+			rtstat_task_ready(&g_st, &task[k], now);
+			if (!ready[k]) {
+				ready[k] = 1;
+				ready_at[k] = now;
+			}
+			if (k < cur)
+				continue;
+			next = k;
+		} else if (cur != 0) {
+			/* the current one blocks, the highest ready one runs */
+			for (next = SIM_TASKS - 1; next > 0 && !ready[next]; next--)
+				;
+		} else {
+			continue;
+		}
+
+		rtstat_switch_out(&g_st, &task[cur], cur != 0 && next > cur, now);
+		rtstat_switch_in(&g_st, &task[next]);
+		run[cur] += now - last;
+		last = now;
+		if (cur != 0 && next > cur) {
+			ready[cur] = 1;
+			ready_at[cur] = now;
+		}
+		if (ready[next]) {
+			ready[next] = 0;
+			lat = now - ready_at[next];
+			lat_num++;
+			lat_sum += lat;
+			hist[hist_bucket(lat)]++;
+			if (lat > lat_max[next])
+				lat_max[next] = lat;
+		}
+		cur = next;
+	}
+	rtstat_switch_out(&g_st, &task[cur], 0, now);
+	run[cur] += now - last;
+
+	for (k = 0; k < SIM_TASKS; k++) {
+		rtstat_task_get(&g_st, &task[k], &t);
+		BENCH_CHECK(t.run_time == run[k] && t.latency_max == lat_max[k]);
+		total += t.run_time;
+	}
+	BENCH_CHECK(total == now - reset_at);
+	BENCH_CHECK(rtstat_hist_num(&g_st.latency) == lat_num && g_st.latency.sum == lat_sum);
+	BENCH_CHECK(memcmp(g_st.latency.count, hist, sizeof(hist)) == 0);
+}
+
+static void bench_hooks(void)
+{
+	struct rtstat_task a, b;
+	uint64_t t;
+	uint32_t i;
+
+	memset(&g_st, 0, sizeof(g_st));
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+	rtstat_reset(&g_st, 0);
+	rtstat_switch_in(&g_st, &a);
+
+	t = bench_now_ns();
+	for (i = 0; i < 1000000; i++) {
+		rtstat_task_ready(&g_st, &b, i * 8);
+		trace_switch(&a, 1, &b, i * 8 + 3);
+		trace_switch(&b, 0, &a, i * 8 + 5);
+	}
+	bench_report("rtstat ready and 2 switches", 1000000, bench_now_ns() - t);
+
+	t = bench_now_ns();
+	for (i = 0; i < 1000000; i++) {
+		rtstat_critical_enter(&g_st, i * 8);
+		rtstat_critical_exit(&g_st, i * 8 + 7);
+	}
+	bench_report("rtstat critical section", 1000000, bench_now_ns() - t);
+}
+
+int main(void)
+{
+	test_trace();
+	test_wrap();
+	test_random();
+	bench_hooks();
+	return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Sector cache of the FatFs SD driver (src/fs/fatfs/driver/sdmmc_diskio.c)
+ * over a file backed card. First random reads and writes of 1 to 16 sectors
+ * checked against a shadow copy, across syncs and an eject. Then FatFs
+ * workloads, counting the sector requests of FatFs against the commands
+ * the card gets: small files created in a directory, and a media file read
+ * in small pieces.
+ */
+
+#include <string.h>
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+#include "sd_image.h"
+#include "bench.h"
+
+#define IMAGE_SECTORS   (1024 * 1024)           /* 512 MB, sparse */
+#define SEC_PER_CLUS    8
+#define MODEL_SECTORS   256
+#define MODEL_OPS       50000
+#define SMALL_FILES     200
+#define SMALL_SIZE      1000
+#define MEDIA_SIZE      (1024 * 1024)
+#define MEDIA_READ      64
+
+/* the requests of FatFs to the SD driver */
+static uint32_t g_req_read, g_req_write;
+
+DRESULT __real_SDMMC_read(BYTE *buff, DWORD sector, UINT count);
+DRESULT __real_SDMMC_write(const BYTE *buff, DWORD sector, UINT count);
+
+DRESULT __wrap_SDMMC_read(BYTE *buff, DWORD sector, UINT count)
+{
+	g_req_read++;
+	return __real_SDMMC_read(buff, sector, count);
+}
+
+DRESULT __wrap_SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	g_req_write++;
+	return __real_SDMMC_write(buff, sector, count);
+}
+
+static FATFS fs;
+static uint8_t shadow[MODEL_SECTORS][512];
+static uint8_t buf[16 * 512];
+
+static uint32_t rnd(void)
+{
+	static uint32_t seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+static void reset_counts(void)
+{
+	g_req_read = 0;
+	g_req_write = 0;
+	sd_image_reset_stat();
+}
+
+static void report_cmds(const char *name, uint32_t ops, uint64_t ns)
+{
+	sd_image_stat st;
+
+	sd_image_get_stat(&st);
+	bench_report(name, ops, ns);
+	printf("  requests: %u reads, %u writes -> card: %u+%u reads, %u+%u writes\n",
+	       g_req_read, g_req_write, st.read_single, st.read_multi,
+	       st.write_single, st.write_multi);
+}
+
+/* single and multi-sector requests mixed, mostly single ones like FatFs */
+static void test_model(void)
+{
+	uint32_t i, sector, count, s;
+	uint64_t t;
+
+	BENCH_CHECK(disk_initialize(0) == 0);
+	memset(buf, 0, sizeof(buf));
+	for (s = 0; s < MODEL_SECTORS; s++)
+		BENCH_CHECK(disk_write(0, buf, s, 1) == RES_OK);
+	memset(shadow, 0, sizeof(shadow));
+
+	reset_counts();
+	t = bench_now_ns();
+	for (i = 0; i < MODEL_OPS; i++) {
+		count = (rnd() % 4) ? 1 : 1 + rnd() % 16;
+		sector = rnd() % (MODEL_SECTORS - count + 1);
+		if (rnd() % 3 == 0) {
+			for (s = 0; s < count * 512; s++)
+				buf[s] = (uint8_t)(i + s / 512 + sector);
+			BENCH_CHECK(disk_write(0, buf, sector, count) == RES_OK);
+			memcpy(shadow[sector], buf, count * 512);
+		} else {
+			BENCH_CHECK(disk_read(0, buf, sector, count) == RES_OK);
+			BENCH_CHECK(memcmp(shadow[sector], buf, count * 512) == 0);
+		}
+		if (rnd() % 1000 == 0)
+			BENCH_CHECK(disk_ioctl(0, CTRL_SYNC, NULL) == RES_OK);
+	}
+	report_cmds("random 1-16 sector requests", MODEL_OPS, bench_now_ns() - t);
+
+	/* all written back on eject, read again without cache */
+	BENCH_CHECK(disk_ioctl(0, CTRL_EJECT, NULL) == RES_OK);
+	BENCH_CHECK(disk_initialize(0) == 0);
+	for (s = 0; s < MODEL_SECTORS; s += 16) {
+		BENCH_CHECK(disk_read(0, buf, s, 16) == RES_OK);
+		BENCH_CHECK(memcmp(shadow[s], buf, 16 * 512) == 0);
+	}
+	BENCH_CHECK(disk_ioctl(0, CTRL_EJECT, NULL) == RES_OK);
+}
+
+static void small_files(void)
+{
+	char name[32];
+	uint64_t t;
+	uint32_t i;
+	FIL f;
+	UINT n;
+
+	BENCH_CHECK(f_mkdir("small") == FR_OK);
+	reset_counts();
+	t = bench_now_ns();
+	for (i = 0; i < SMALL_FILES; i++) {
+		snprintf(name, sizeof(name), "small/file%03u.txt", i);
+		memset(buf, 'a' + i % 26, SMALL_SIZE);
+		BENCH_CHECK(f_open(&f, name, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+		BENCH_CHECK(f_write(&f, buf, SMALL_SIZE, &n) == FR_OK && n == SMALL_SIZE);
+		BENCH_CHECK(f_close(&f) == FR_OK);
+	}
+	report_cmds("create small file", SMALL_FILES, bench_now_ns() - t);
+
+	reset_counts();
+	t = bench_now_ns();
+	for (i = 0; i < SMALL_FILES; i++) {
+		snprintf(name, sizeof(name), "small/file%03u.txt", i);
+		BENCH_CHECK(f_open(&f, name, FA_OPEN_EXISTING | FA_READ) == FR_OK);
+		BENCH_CHECK(f_read(&f, buf, SMALL_SIZE, &n) == FR_OK && n == SMALL_SIZE);
+		BENCH_CHECK(buf[0] == 'a' + i % 26 && buf[SMALL_SIZE - 1] == 'a' + i % 26);
+		BENCH_CHECK(f_close(&f) == FR_OK);
+	}
+	report_cmds("open and read small file", SMALL_FILES, bench_now_ns() - t);
+}
+
+static void media_read(void)
+{
+	uint8_t data[MEDIA_READ];
+	uint64_t t;
+	uint32_t ofs, i;
+	FIL f;
+	UINT n;
+
+	BENCH_CHECK(f_open(&f, "media.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+	for (ofs = 0; ofs < MEDIA_SIZE; ofs += sizeof(buf)) {
+		for (i = 0; i < sizeof(buf); i++)
+			buf[i] = (uint8_t)((ofs + i) * 7);
+		BENCH_CHECK(f_write(&f, buf, sizeof(buf), &n) == FR_OK && n == sizeof(buf));
+	}
+	BENCH_CHECK(f_close(&f) == FR_OK);
+
+	BENCH_CHECK(f_open(&f, "media.bin", FA_OPEN_EXISTING | FA_READ) == FR_OK);
+	reset_counts();
+	t = bench_now_ns();
+	for (ofs = 0; ofs < MEDIA_SIZE; ofs += MEDIA_READ) {
+		BENCH_CHECK(f_read(&f, data, MEDIA_READ, &n) == FR_OK && n == MEDIA_READ);
+		BENCH_CHECK(data[MEDIA_READ - 1] == (uint8_t)((ofs + MEDIA_READ - 1) * 7));
+	}
+	report_cmds("media read 64", MEDIA_SIZE / MEDIA_READ, bench_now_ns() - t);
+	BENCH_CHECK(f_close(&f) == FR_OK);
+}
+
+int main(void)
+{
+	BENCH_CHECK(sd_image_open("sdcache.img", IMAGE_SECTORS) == 0);
+	test_model();
+
+	BENCH_CHECK(sd_image_format(SEC_PER_CLUS) == 0);
+	BENCH_CHECK(f_mount(&fs, "", 1) == FR_OK);
+	small_files();
+	media_read();
+	BENCH_CHECK(f_mount(NULL, "", 0) == FR_OK);
+	BENCH_CHECK(disk_ioctl(0, CTRL_EJECT, NULL) == RES_OK);
+
+	sd_image_close();
+	remove("sdcache.img");
+	printf("sd cache checks passed\n");
+	return 0;
+}
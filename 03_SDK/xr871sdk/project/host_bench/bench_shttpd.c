@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * shttpd static content over a keep-alive loopback connection. The client is
+ * driven from the same thread as shttpd_poll(), so every byte the server copies
+ * is accounted to a single request. Content is registered both from memory and
+ * from a content image, as mounted from XIP flash on the target.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "defs.h"
+#include "bench.h"
+
+#define BENCH_PORT          "18080"
+#define BENCH_REQUESTS      400
+#define APP_LEN             (96 * 1024) /* the provisioning UI bundle */
+#define APP_GZ_LEN          (24 * 1024)
+#define LOGO_LEN            3000
+
+static char g_app[APP_LEN];
+static char g_app_gz[APP_GZ_LEN];
+static char g_logo[LOGO_LEN];
+static char g_index[] = "<html><body><script src=\"app.js\"></script></body></html>";
+static char g_rsp[APP_LEN + 1024];
+
+static const struct usr_file g_files[] = {
+	{"./",              ""},
+	{"./index.html",    g_index},
+};
+
+static const struct usr_content g_content[] = {
+	{"./app.js", g_app, APP_LEN, g_app_gz, APP_GZ_LEN, 0},
+};
+
+/* a content image as tools/mkwebimg.py makes it, with "./img/logo.svg" */
+static uint32_t g_image[(sizeof(struct content_image_hdr) +
+                         2 * sizeof(struct content_image_entry) +
+                         64 + LOGO_LEN + 4) / 4];
+
+static uint32_t image_put(uint32_t *off, const void *data, uint32_t len)
+{
+	uint32_t at = *off;
+
+	memcpy((char *)g_image + at, data, len);
+	*off = (at + len + 4) & ~3;
+	return at;
+}
+
+static void image_build(void)
+{
+	struct content_image_hdr *hdr = (struct content_image_hdr *)g_image;
+	struct content_image_entry *ent = (struct content_image_entry *)(hdr + 1);
+	uint32_t off = sizeof(*hdr) + 2 * sizeof(*ent);
+	memset(g_logo, 'L', sizeof(g_logo));
+	memset(ent, 0, 2 * sizeof(*ent));
+	ent[0].name = image_put(&off, "./img/", 6);
+	ent[1].name = image_put(&off, "./img/logo.svg", 14);
+	ent[1].body = image_put(&off, g_logo, LOGO_LEN);
+	ent[1].len = LOGO_LEN;
+	ent[1].etag = 0x5eed;
+	hdr->magic = CONTENT_IMAGE_MAGIC;
+	hdr->version = CONTENT_IMAGE_VERSION;
+	hdr->count = 2;
+	hdr->size = off;
+	BENCH_CHECK(off <= sizeof(g_image));
+}
+
+typedef struct {
+	int status;
+	int gzip;
+	char etag[32];
+	const char *body;
+	int len;
+} reply;
+
+static const char *header_value(const char *hdrs, const char *name)
+{
+	const char *p = strcasestr(hdrs, name);
+
+	return p ? p + strlen(name) : NULL;
+}
+
+/* one request on the keep-alive connection, polling the server meanwhile */
+static void request(struct shttpd_ctx *ctx, int sock, const char *req, reply *r)
+{
+	int sent = 0, got = 0, hlen = 0, n;
+	const char *v;
+	char *e;
+
+	while (sent < (int)strlen(req)) {
+		n = send(sock, req + sent, strlen(req) - sent, 0);
+		if (n > 0)
+			sent += n;
+		shttpd_poll(ctx, 0);
+	}
+	memset(r, 0, sizeof(*r));
+	r->len = -1;
+	while (hlen == 0 || got < hlen + r->len) {
+		shttpd_poll(ctx, 0);
+		n = recv(sock, g_rsp + got, sizeof(g_rsp) - 1 - got, 0);
+		BENCH_CHECK(n != 0);
+		if (n < 0) {
+			BENCH_CHECK(errno == EAGAIN);
+			continue;
+		}
+		got += n;
+		g_rsp[got] = '\0';
+		if (hlen == 0 && (e = strstr(g_rsp, "\r\n\r\n")) != NULL) {
+			hlen = e + 4 - g_rsp;
+			e[2] = '\0';
+			r->status = atoi(g_rsp + 9);
+			v = header_value(g_rsp, "Content-Length: ");
+			r->len = v ? atoi(v) : 0;
+			r->gzip = header_value(g_rsp, "Content-Encoding: gzip") != NULL;
+			if ((v = header_value(g_rsp, "Etag: \"")) != NULL)
+				sscanf(v, "%31[^\"]", r->etag);
+		}
+	}
+	BENCH_CHECK(got == hlen + r->len);
+	r->body = g_rsp + hlen;
+}
+
+static void run(struct shttpd_ctx *ctx, int sock, const char *name,
+                const char *req, int status, const void *body, int len)
+{
+	struct shttpd_stats s0, s1;
+	uint64_t t0, t1;
+	reply r;
+	int i;
+
+	shttpd_get_stats(ctx, &s0);
+	t0 = bench_now_ns();
+	for (i = 0; i < BENCH_REQUESTS; i++) {
+		request(ctx, sock, req, &r);
+		BENCH_CHECK(r.status == status && r.len == len);
+		BENCH_CHECK(len == 0 || memcmp(r.body, body, len) == 0);
+	}
+	t1 = bench_now_ns();
+	shttpd_get_stats(ctx, &s1);
+
+	bench_report(name, BENCH_REQUESTS, t1 - t0);
+	printf("    %8.0f req/s, %lu bytes copied and %lu in place per response\n",
+	       BENCH_REQUESTS * 1e9 / (t1 - t0),
+	       (s1.bytes_copied - s0.bytes_copied) / BENCH_REQUESTS,
+	       (s1.bytes_nocopy - s0.bytes_nocopy) / BENCH_REQUESTS);
+	BENCH_CHECK(s1.responses - s0.responses == BENCH_REQUESTS);
+}
+
+int main(void)
+{
+	struct shttpd_ctx *ctx;
+	struct shttpd_stats s;
+	struct sockaddr_in addr;
+	char req[256];
+	reply r, rz;
+	int sock, one = 1, i;
+
+	for (i = 0; i < APP_LEN; i++)
+		g_app[i] = "var x = 0;\n"[i % 11];
+	for (i = 0; i < APP_GZ_LEN; i++)
+		g_app_gz[i] = (char)random();
+	g_app_gz[0] = 0x1f;
+	image_build();
+
+	_shttpd_init_local_file(g_files, 2);
+	BENCH_CHECK(_shttpd_add_local_content(g_content, 1) == 0);
+	BENCH_CHECK(_shttpd_add_local_content(g_content, 1) != 0);
+	BENCH_CHECK(_shttpd_mount_content_image(g_image, sizeof(g_image)) == 0);
+	ctx = shttpd_init(0, NULL);
+	BENCH_CHECK(ctx != NULL);
+	BENCH_CHECK(shttpd_set_option(ctx, "ports", BENCH_PORT) == TRUE);
+
+	sock = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(atoi(BENCH_PORT));
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	BENCH_CHECK(connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+	/* variants and tags */
+	request(ctx, sock, "GET / HTTP/1.1\r\n\r\n", &r);
+	BENCH_CHECK(r.status == 200 && r.len == (int)strlen(g_index) && !r.gzip);
+	BENCH_CHECK(memcmp(r.body, g_index, r.len) == 0);
+	request(ctx, sock, "GET /app.js HTTP/1.1\r\n"
+	        "Accept-Encoding: gzip;q=0, deflate\r\n\r\n", &r);
+	BENCH_CHECK(r.status == 200 && r.len == APP_LEN && !r.gzip);
+	request(ctx, sock, "GET /app.js HTTP/1.1\r\n"
+	        "Accept-Encoding: deflate, gzip\r\n\r\n", &rz);
+	BENCH_CHECK(rz.status == 200 && rz.len == APP_GZ_LEN && rz.gzip);
+	BENCH_CHECK(strcmp(r.etag, rz.etag) != 0);
+	request(ctx, sock, "GET /img/logo.svg HTTP/1.1\r\n\r\n", &r);
+	BENCH_CHECK(r.status == 200 && r.len == LOGO_LEN &&
+	            strcmp(r.etag, "00005eed") == 0);
+	request(ctx, sock, "GET /missing.js HTTP/1.1\r\n\r\n", &r);
+	BENCH_CHECK(r.status == 404);
+
+	run(ctx, sock, "shttpd GET app.js identity",
+	    "GET /app.js HTTP/1.1\r\n\r\n", 200, g_app, APP_LEN);
+	run(ctx, sock, "shttpd GET app.js gzip",
+	    "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip, deflate, br\r\n\r\n",
+	    200, g_app_gz, APP_GZ_LEN);
+	snprintf(req, sizeof(req), "GET /app.js HTTP/1.1\r\n"
+	         "Accept-Encoding: gzip\r\nIf-None-Match: \"0\", W/\"%s\"\r\n\r\n",
+	         rz.etag);
+	run(ctx, sock, "shttpd GET app.js 304", req, 304, NULL, 0);
+	run(ctx, sock, "shttpd GET img/logo.svg (image)",
+	    "GET /img/logo.svg HTTP/1.1\r\n\r\n", 200, g_logo, LOGO_LEN);
+
+	/* only the small index.html went through the stream buffer */
+	shttpd_get_stats(ctx, &s);
+	BENCH_CHECK(s.bytes_copied == strlen(g_index));
+	BENCH_CHECK(s.not_modified == BENCH_REQUESTS);
+	BENCH_CHECK(s.gzip == BENCH_REQUESTS + 1);
+
+	close(sock);
+	shttpd_fini(ctx);
+	_shttpd_deinit_local_file();
+	return 0;
+}
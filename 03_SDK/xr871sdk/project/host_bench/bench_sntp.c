@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SNTP client against simulated servers on the loopback. Each server has its
+ * own clock running with a skew against the host's monotonic clock, and delays
+ * its replies by a random amount on either path. One of them is a falseticker.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "kernel/os/os.h"
+#include "net/sntp/sntp.h"
+#include "bench.h"
+
+#define SERVER_NUM          3
+#define SERVER_SKEW_PPM     150
+#define SERVER_FALSE_US     80000       /* offset of the falseticker */
+#define SERVER_JITTER_US    3000        /* max extra delay on each path */
+#define SERVER_UTC_BASE     1700000000000000LL
+
+#define SYNC_ROUNDS         12
+#define SYNC_INTERVAL_MS    500
+#define SYNC_SAMPLES        8
+
+typedef struct {
+	int sockfd;
+	int64_t bias;
+	OS_Thread_t thread;
+} ntp_server;
+
+static ntp_server g_server[SERVER_NUM];
+static OS_Semaphore_t g_server_stop;
+static OS_Semaphore_t g_server_done;
+
+static uint64_t mono_us(void)
+{
+	return bench_now_ns() / 1000;
+}
+
+/* the reference time, what every good server's clock reads */
+static int64_t server_utc(uint64_t t)
+{
+	return SERVER_UTC_BASE + (int64_t)t + (int64_t)t * SERVER_SKEW_PPM / 1000000;
+}
+
+static void server_stamp(uint8_t *p, int64_t us)
+{
+	uint32_t sec = (uint32_t)(us / 1000000 + 2208988800LL);
+	uint32_t frac = (uint32_t)(((uint64_t)(us % 1000000) << 32) / 1000000);
+
+	sec = htonl(sec);
+	frac = htonl(frac);
+	memcpy(p, &sec, 4);
+	memcpy(p + 4, &frac, 4);
+}
+
+static void server_delay(void)
+{
+	/* half of the packets go straight, the rest are held up to the jitter */
+	if (random() & 1)
+		usleep(random() % SERVER_JITTER_US);
+}
+
+static void server_task(void *arg)
+{
+	ntp_server *srv = arg;
+	uint8_t pkt[48];
+	struct sockaddr_in from;
+	socklen_t fromlen;
+	struct timeval tv = { 0, 100000 };
+
+	setsockopt(srv->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	while (OS_SemaphoreWait(&g_server_stop, 0) != OS_OK) {
+		fromlen = sizeof(from);
+		if (recvfrom(srv->sockfd, pkt, sizeof(pkt), 0,
+		             (struct sockaddr *)&from, &fromlen) != sizeof(pkt))
+			continue;
+		server_delay();
+		memcpy(pkt + 24, pkt + 40, 8);      /* originate = client's transmit */
+		server_stamp(pkt + 32, server_utc(mono_us()) + srv->bias);
+		pkt[0] = (3 << 3) | 4;              /* v3, server */
+		pkt[1] = 2;                         /* stratum */
+		memset(pkt + 4, 0, 8);              /* root delay and dispersion */
+		server_stamp(pkt + 40, server_utc(mono_us()) + srv->bias);
+		server_delay();
+		sendto(srv->sockfd, pkt, sizeof(pkt), 0, (struct sockaddr *)&from, fromlen);
+	}
+	close(srv->sockfd);
+	OS_SemaphoreRelease(&g_server_done);
+	OS_ThreadDelete(&srv->thread);
+}
+
+static void server_start(int idx, int64_t bias)
+{
+	ntp_server *srv = &g_server[idx];
+	struct sockaddr_in addr;
+	char name[16];
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SNTP_PORT);
+	addr.sin_addr.s_addr = htonl(0x7f000001 + idx);
+	srv->bias = bias;
+	srv->sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	BENCH_CHECK(srv->sockfd >= 0);
+	BENCH_CHECK(bind(srv->sockfd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	BENCH_CHECK(OS_ThreadCreate(&srv->thread, "ntpd", server_task, srv,
+	                            OS_THREAD_PRIO_APP, 1024) == OS_OK);
+
+	snprintf(name, sizeof(name), "127.0.0.%d", idx + 1);
+	BENCH_CHECK(sntp_set_server(idx, name) == 0);
+}
+
+static int64_t time_error(void)
+{
+	int64_t t = sntp_get_time_us();
+
+	return t - server_utc(mono_us());
+}
+
+int main(int argc, char **argv)
+{
+	sntp_arg arg;
+	sntp_status st;
+	int64_t before, after, err;
+	uint64_t t;
+	uint32_t i;
+
+	srandom(1);
+	BENCH_CHECK(OS_SemaphoreCreate(&g_server_stop, 0, SERVER_NUM) == OS_OK);
+	BENCH_CHECK(OS_SemaphoreCreate(&g_server_done, 0, SERVER_NUM) == OS_OK);
+	server_start(0, 0);
+	server_start(1, 0);
+	server_start(2, SERVER_FALSE_US);
+
+	memset(&arg, 0, sizeof(arg));
+	arg.recv_timeout = 200;
+	arg.retry_times = SNTP_RETRY_TIMES;
+	arg.samples = SYNC_SAMPLES;
+
+	BENCH_CHECK(sntp_get_time_us() < 0);
+
+	/* the first sync steps the clock */
+	BENCH_CHECK(sntp_sync(&arg) == 0);
+	BENCH_CHECK(sntp_get_status(&st) == 0);
+	err = time_error();
+	printf("first sync: error %lld us, %u servers, delay %d us\n",
+	       (long long)err, st.servers, st.delay);
+	BENCH_CHECK(st.servers == 2);
+	BENCH_CHECK(st.steps == 1);
+	BENCH_CHECK(err > -2000 && err < 2000);
+
+	/* the rest slew it in and train the frequency, never going back */
+	for (i = 0; i < SYNC_ROUNDS; i++) {
+		OS_MSleep(SYNC_INTERVAL_MS);
+		before = sntp_get_time_us();
+		BENCH_CHECK(sntp_sync(&arg) == 0);
+		after = sntp_get_time_us();
+		BENCH_CHECK(after >= before);
+	}
+	BENCH_CHECK(sntp_get_status(&st) == 0);
+	err = time_error();
+	printf("after %d syncs: error %lld us, freq %d ppb, jitter %d us\n",
+	       SYNC_ROUNDS, (long long)err, st.freq, st.jitter);
+	BENCH_CHECK(st.steps == 1);
+	BENCH_CHECK(st.servers == 2);
+	BENCH_CHECK(err > -500 && err < 500);
+	BENCH_CHECK(st.freq > (SERVER_SKEW_PPM - 30) * 1000 &&
+	            st.freq < (SERVER_SKEW_PPM + 30) * 1000);
+
+	/* free running on the frequency correction */
+	OS_MSleep(2000);
+	err = time_error();
+	printf("2 s later: error %lld us\n", (long long)err);
+	BENCH_CHECK(err > -500 && err < 500);
+
+	t = bench_now_ns();
+	for (i = 0; i < 1000000; i++)
+		before = sntp_get_time_us();
+	bench_report("sntp_get_time_us", 1000000, bench_now_ns() - t);
+
+	for (i = 0; i < SERVER_NUM; i++)
+		OS_SemaphoreRelease(&g_server_stop);
+	for (i = 0; i < SERVER_NUM; i++)
+		OS_SemaphoreWait(&g_server_done, OS_WAIT_FOREVER);
+	return 0;
+}
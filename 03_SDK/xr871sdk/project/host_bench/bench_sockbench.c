@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host variant of the "net sockbench" command. The main figure is UDP sends
+ * to a sink interface which drops every packet, so each op is one socket API
+ * call plus the UDP/IP output path. Round trips over the loopback interface
+ * follow as a secondary figure. Built once with and once without
+ * LWIP_TCPIP_CORE_LOCKING to compare both modes.
+ */
+
+#include <string.h>
+#include "lwip/tcpip.h"
+#include "lwip/sockets.h"
+#include "lwip/inet.h"
+#include "lwip/netifapi.h"
+#include "bench.h"
+
+#define SOCKBENCH_PORT		5099
+#define SOCKBENCH_ROUNDS	20000
+#define SOCKBENCH_RCV_TIMEOUT	1000 /* ms */
+
+#define SOCKBENCH_SINK_ADDR	"192.0.2.1"
+#define SOCKBENCH_SINK_MASK	"255.255.255.0"
+#define SOCKBENCH_SINK_DEST	"192.0.2.2"
+
+static const int g_lens[] = { 32, 1024 };
+
+static sys_sem_t g_tcpip_ready;
+static struct netif g_sink_netif;
+static uint32_t g_sink_packets;
+
+static err_t sink_output(struct netif *netif, struct pbuf *p,
+                         const ip4_addr_t *ipaddr)
+{
+	g_sink_packets++;
+	return ERR_OK;
+}
+
+static err_t sink_init(struct netif *netif)
+{
+	netif->name[0] = 's';
+	netif->name[1] = 'k';
+	netif->output = sink_output;
+	netif->mtu = 1500;
+	return ERR_OK;
+}
+
+static void tcpip_ready(void *arg)
+{
+	sys_sem_signal(&g_tcpip_ready);
+}
+
+int main(void)
+{
+	struct sockaddr_in addr, sink;
+	ip4_addr_t ipaddr, netmask, gw;
+	int timeout = SOCKBENCH_RCV_TIMEOUT;
+	uint8_t buf[1024];
+	char name[48];
+	uint64_t t;
+	uint32_t i, l;
+	int rfd, sfd;
+
+	BENCH_CHECK(sys_sem_new(&g_tcpip_ready, 0) == ERR_OK);
+	tcpip_init(tcpip_ready, NULL);
+	sys_sem_wait(&g_tcpip_ready);
+
+	ip4addr_aton(SOCKBENCH_SINK_ADDR, &ipaddr);
+	ip4addr_aton(SOCKBENCH_SINK_MASK, &netmask);
+	ip4_addr_set_zero(&gw);
+	BENCH_CHECK(netifapi_netif_add(&g_sink_netif, &ipaddr, &netmask, &gw, NULL,
+	                               sink_init, tcpip_input) == ERR_OK);
+	netifapi_netif_set_up(&g_sink_netif);
+	netifapi_netif_set_link_up(&g_sink_netif);
+
+	memset(&sink, 0, sizeof(sink));
+	sink.sin_family = AF_INET;
+	sink.sin_port = htons(SOCKBENCH_PORT);
+	sink.sin_addr.s_addr = inet_addr(SOCKBENCH_SINK_DEST);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SOCKBENCH_PORT);
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	rfd = socket(AF_INET, SOCK_DGRAM, 0);
+	sfd = socket(AF_INET, SOCK_DGRAM, 0);
+	BENCH_CHECK(rfd >= 0 && sfd >= 0);
+	setsockopt(rfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	BENCH_CHECK(bind(rfd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+	memset(buf, 0x5a, sizeof(buf));
+	for (l = 0; l < sizeof(g_lens) / sizeof(g_lens[0]); l++) {
+		g_sink_packets = 0;
+		t = bench_now_ns();
+		for (i = 0; i < SOCKBENCH_ROUNDS; i++) {
+			BENCH_CHECK(sendto(sfd, buf, g_lens[l], 0, (struct sockaddr *)&sink,
+			                   sizeof(sink)) == g_lens[l]);
+		}
+		snprintf(name, sizeof(name), "udp send %d, core lock %s", g_lens[l],
+		         LWIP_TCPIP_CORE_LOCKING ? "on" : "off");
+		bench_report(name, SOCKBENCH_ROUNDS, bench_now_ns() - t);
+		BENCH_CHECK(g_sink_packets == SOCKBENCH_ROUNDS);
+	}
+	for (l = 0; l < sizeof(g_lens) / sizeof(g_lens[0]); l++) {
+		t = bench_now_ns();
+		for (i = 0; i < SOCKBENCH_ROUNDS; i++) {
+			BENCH_CHECK(sendto(sfd, buf, g_lens[l], 0, (struct sockaddr *)&addr,
+			                   sizeof(addr)) == g_lens[l]);
+			BENCH_CHECK(recv(rfd, buf, g_lens[l], 0) == g_lens[l]);
+		}
+		snprintf(name, sizeof(name), "udp round trip %d, core lock %s", g_lens[l],
+		         LWIP_TCPIP_CORE_LOCKING ? "on" : "off");
+		bench_report(name, SOCKBENCH_ROUNDS, bench_now_ns() - t);
+	}
+
+	closesocket(sfd);
+	closesocket(rfd);
+	netifapi_netif_remove(&g_sink_netif);
+	return 0;
+}
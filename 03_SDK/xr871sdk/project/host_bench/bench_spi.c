@@ -0,0 +1,777 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SPI transaction queue (src/driver/chip/spi_queue.c) over a mock of the
+ * SPI controller and its DMA channels, run on a virtual clock: the bursts
+ * are programmed into mock registers the way hal_spi.c does, the mock bus
+ * shifts them at the device's sclk and raises the transfer complete and
+ * rx DMA end events. Checked: the data and chip select of every device,
+ * merged command + answer bursts, the priority order, the starvation
+ * limit and abort. Then a display, a flash and a sensor sharing a bus are
+ * simulated for a second through the queue and through the blocking
+ * Open/CS/Transmit/Receive/Close calls, and the cost of the queue itself
+ * is measured.
+ */
+
+#include <string.h>
+#include "driver/chip/spi_queue.h"
+#include "bench.h"
+
+#define FIFO_SIZE       64
+
+/* assumed costs on the target, in us */
+#define COST_ISR        2       /* interrupt entry to the next burst started */
+#define COST_BURST      2       /* registers and FIFO reset of a burst */
+#define COST_DMA        2       /* a DMA channel started and stopped */
+#define COST_SET_DEV    3       /* clock and mode of another device */
+#define COST_OPEN       15      /* HAL_SPI_Open + HAL_SPI_Close */
+#define COST_WAKE       20      /* semaphore to the blocked thread running */
+
+#define SIM_DEVS        4
+#define SIM_XFERS       64
+#define SIM_SEGS        20
+#define SIM_BUF         4096
+
+struct sim_dev {
+	uint32_t    sclk;
+	uint8_t     cs;
+	uint8_t     mode;
+	uint8_t     prio;
+	uint8_t     seed;           /* MISO byte n after select is seed + n */
+	uint32_t    clocked;        /* bytes since selected */
+	uint8_t     mosi[SIM_BUF * SIM_SEGS];
+	uint32_t    mosi_len;
+	uint32_t    selects;
+};
+
+/* the registers and the DMA channels the queue programs */
+struct mock_hw {
+	uint32_t    ss_sel;         /* TCTRL SS_SEL */
+	uint32_t    ss_active;      /* TCTRL SS_LEVEL, selected */
+	uint32_t    dhb_full;       /* TCTRL DHB */
+	uint32_t    bc, tc;         /* BC MBC, TC MWTC */
+	uint32_t    drq_tx, drq_rx; /* FCTL DRQ enables */
+	uint8_t     txfifo[FIFO_SIZE];
+	uint32_t    txcnt;
+	uint8_t     rxfifo[FIFO_SIZE];
+	uint32_t    rxcnt;
+	const uint8_t *dma_tx_src;
+	uint32_t    dma_tx_len;
+	uint8_t    *dma_rx_dst;
+	uint32_t    dma_rx_len;
+	const struct sim_dev *dev;  /* the clock and mode set */
+	uint32_t    pending;        /* events left in the burst */
+	uint32_t    done_at;        /* the burst is shifted out */
+	int         running;
+};
+
+struct sim {
+	struct spiq         q;
+	struct mock_hw      hw;
+	struct sim_dev      dev[SIM_DEVS];
+	uint32_t            now;
+	uint32_t            set_dev;
+	uint32_t            done_order[SIM_XFERS];
+	uint32_t            done_num;
+	int                 resubmit;   /* xfers the callback submits again */
+};
+
+static struct sim g_sim;
+
+static uint32_t bus_us(const struct sim_dev *d, uint32_t bytes)
+{
+	return (uint32_t)(((uint64_t)bytes * 8 * 1000000 + d->sclk - 1) / d->sclk);
+}
+
+static uint32_t mock_now(void *ctx)
+{
+	return ((struct sim *)ctx)->now;
+}
+
+/* HAL_SPI_QueueStartBurst() on the mock */
+static void mock_start(void *ctx, const struct spiq_xfer *x, const struct spiq_burst *b)
+{
+	struct sim *s = ctx;
+	struct mock_hw *hw = &s->hw;
+	const struct sim_dev *d = x->dev;
+	uint32_t cost = COST_BURST;
+
+	BENCH_CHECK(!hw->running);
+	if (b->cs_first) {
+		BENCH_CHECK(!hw->ss_active);
+		if (d != hw->dev) {
+			if (hw->dev == NULL || hw->dev->sclk != d->sclk || hw->dev->mode != d->mode) {
+				s->set_dev++;
+				cost += COST_SET_DEV;
+			}
+			hw->dev = d;
+		}
+		hw->ss_sel = d->cs;
+		hw->ss_active = 1;
+		s->dev[d->cs].clocked = 0;
+		s->dev[d->cs].selects++;
+	} else {
+		BENCH_CHECK(hw->ss_active && hw->ss_sel == d->cs);
+	}
+
+	if (b->duplex)
+		BENCH_CHECK(b->tx_len == b->rx_len && b->tx && b->rx);
+	hw->dhb_full = b->duplex;
+	hw->txcnt = 0;
+	hw->rxcnt = 0;
+	hw->tc = b->tx_len;
+	hw->bc = b->duplex ? b->tx_len : b->tx_len + b->rx_len;
+
+	hw->drq_tx = b->tx_len > FIFO_SIZE;
+	hw->drq_rx = b->rx_len > FIFO_SIZE;
+	if (hw->drq_rx) {
+		hw->dma_rx_dst = b->rx;
+		hw->dma_rx_len = b->rx_len;
+		cost += COST_DMA;
+	}
+	if (hw->drq_tx) {
+		hw->dma_tx_src = b->tx;
+		hw->dma_tx_len = b->tx_len;
+		cost += COST_DMA;
+	} else {
+		memcpy(hw->txfifo, b->tx, b->tx_len);
+		hw->txcnt = b->tx_len;
+	}
+
+	hw->pending = 1 + hw->drq_rx;
+	hw->running = 1;
+	hw->done_at = s->now + cost + bus_us(d, hw->bc);
+}
+
+/* the bus shifting the burst out */
+static void mock_shift(struct sim *s)
+{
+	struct mock_hw *hw = &s->hw;
+	struct sim_dev *d = &s->dev[hw->ss_sel];
+	const uint8_t *tx = hw->drq_tx ? hw->dma_tx_src : hw->txfifo;
+	uint32_t i, rx_len;
+
+	BENCH_CHECK(hw->ss_active);
+	BENCH_CHECK(hw->drq_tx ? hw->dma_tx_len == hw->tc : hw->txcnt == hw->tc);
+	for (i = 0; i < hw->tc; i++) {
+		BENCH_CHECK(d->mosi_len < sizeof(d->mosi));
+		d->mosi[d->mosi_len++] = tx[i];
+	}
+	if (hw->dhb_full) {
+		rx_len = hw->bc;
+	} else {
+		d->clocked += hw->tc;
+		rx_len = hw->bc - hw->tc;
+	}
+	for (i = 0; i < rx_len; i++) {
+		uint8_t v = (uint8_t)(d->seed + d->clocked + i);
+		if (hw->drq_rx) {
+			BENCH_CHECK(i < hw->dma_rx_len);
+			hw->dma_rx_dst[i] = v;
+		} else {
+			BENCH_CHECK(hw->rxcnt < FIFO_SIZE);
+			hw->rxfifo[hw->rxcnt++] = v;
+		}
+	}
+	d->clocked += rx_len;
+	hw->running = 0;
+}
+
+/* HAL_SPI_QueueEvent() on the mock */
+static void mock_event(struct sim *s)
+{
+	struct mock_hw *hw = &s->hw;
+	const struct spiq_burst *b = &s->q.burst;
+	struct spiq_xfer *x;
+
+	BENCH_CHECK(hw->pending > 0);
+	if (--hw->pending != 0)
+		return;
+	if (!hw->drq_rx && b->rx_len) {
+		BENCH_CHECK(hw->rxcnt == b->rx_len);
+		memcpy(b->rx, hw->rxfifo, b->rx_len);
+	}
+	if (b->cs_last)
+		hw->ss_active = 0;
+	s->now += COST_ISR;
+	x = spiq_burst_done(&s->q, 0);
+	if (x && x->done)
+		x->done(x, 0, x->arg);
+}
+
+/* run the bus until the queue is idle or until the time given */
+static void sim_run(struct sim *s, uint32_t until)
+{
+	uint32_t n;
+
+	while (s->hw.running && (int32_t)(s->hw.done_at - until) <= 0) {
+		s->now = s->hw.done_at;
+		mock_shift(s);
+		/* the rx DMA end, then the transfer complete, the last starts
+		 * the next burst */
+		n = s->hw.pending;
+		while (n--)
+			mock_event(s);
+	}
+	if ((int32_t)(s->now - until) < 0)
+		s->now = until;
+}
+
+static const struct spiq_ops mock_ops = {
+	.start = mock_start,
+	.now_us = mock_now,
+};
+
+static void sim_init(struct sim *s)
+{
+	int i;
+
+	memset(s, 0, sizeof(*s));
+	for (i = 0; i < SIM_DEVS; i++) {
+		s->dev[i].cs = i;
+		s->dev[i].sclk = 8000000;
+		s->dev[i].seed = 0x10 * (i + 1);
+	}
+	spiq_init(&s->q, &mock_ops, s);
+}
+
+static void sim_done_once(struct spiq_xfer *x, int status, void *arg)
+{
+	struct sim *s = &g_sim;
+
+	BENCH_CHECK(status == 0);
+	if (s->done_num < SIM_XFERS)
+		s->done_order[s->done_num] = (uint32_t)(uintptr_t)arg;
+	s->done_num++;
+}
+
+static void sim_done(struct spiq_xfer *x, int status, void *arg)
+{
+	struct sim *s = &g_sim;
+
+	sim_done_once(x, status, arg);
+	if (s->resubmit > 0) {
+		s->resubmit--;
+		BENCH_CHECK(spiq_submit(&s->q, x) == 0);
+	}
+}
+
+static void xfer_set(struct spiq_xfer *x, struct sim_dev *d,
+                     const struct spiq_seg *seg, uint16_t num, uintptr_t id)
+{
+	memset(x, 0, sizeof(*x));
+	x->dev = d;
+	x->prio = d->prio;
+	x->seg = seg;
+	x->num = num;
+	x->done = sim_done;
+	x->arg = (void *)id;
+}
+
+static uint8_t g_tx[SIM_BUF];
+static uint8_t g_rx[SIM_SEGS][SIM_BUF];
+
+/* data and chip select: every segment layout, FIFO and DMA sizes */
+static void test_data(void)
+{
+	static const uint32_t lens[] = { 1, 4, 63, 64, 65, 256, 4000 };
+	struct sim *s = &g_sim;
+	struct spiq_seg seg[SIM_SEGS];
+	struct spiq_xfer x;
+	struct spiq_stats st;
+	uint32_t i, r, n, pos, mosi, bursts, selects;
+
+	for (i = 0; i < SIM_BUF; i++)
+		g_tx[i] = (uint8_t)(i * 7 + 3);
+
+	for (r = 0; r < 2000; r++) {
+		sim_init(s);
+		n = 1 + r % SIM_SEGS;
+		srand(r);
+		for (i = 0; i < n; i++) {
+			uint32_t kind = rand() % 3;
+			seg[i].len = lens[rand() % (sizeof(lens) / sizeof(lens[0]))];
+			seg[i].tx = kind != 1 ? g_tx + (rand() % 64) : NULL;
+			seg[i].rx = kind != 0 ? g_rx[i] : NULL;
+			seg[i].flags = (rand() % 4 == 0) ? SPIQ_SEG_CS_CHANGE : 0;
+			if (seg[i].rx)
+				memset(g_rx[i], 0xee, seg[i].len);
+		}
+		xfer_set(&x, &s->dev[r % SIM_DEVS], seg, n, r);
+		BENCH_CHECK(spiq_submit(&s->q, &x) == 0);
+		sim_run(s, s->now + 1000000);
+		BENCH_CHECK(!spiq_busy(&s->q) && s->done_num == 1);
+		BENCH_CHECK(!s->hw.ss_active);
+
+		/* replay what the device saw */
+		pos = 0;
+		mosi = 0;
+		bursts = 0;
+		selects = 1;
+		for (i = 0; i < n; i++) {
+			const struct spiq_seg *g = &seg[i];
+			uint32_t k;
+
+			if (g->tx) {
+				BENCH_CHECK(!memcmp(s->dev[r % SIM_DEVS].mosi + mosi, g->tx, g->len));
+				mosi += g->len;
+			}
+			if (g->rx) {
+				for (k = 0; k < g->len; k++)
+					BENCH_CHECK(g->rx[k] == (uint8_t)(s->dev[r % SIM_DEVS].seed + pos + k));
+			}
+			pos += g->len;
+			bursts++;
+			if (g->tx && !g->rx && !(g->flags & SPIQ_SEG_CS_CHANGE) &&
+			    i + 1 < n && !seg[i + 1].tx) {
+				/* merged with the receive after it */
+				i++;
+				for (k = 0; k < seg[i].len; k++)
+					BENCH_CHECK(seg[i].rx[k] == (uint8_t)(s->dev[r % SIM_DEVS].seed + pos + k));
+				pos += seg[i].len;
+			}
+			if ((seg[i].flags & SPIQ_SEG_CS_CHANGE) && i + 1 < n) {
+				pos = 0;
+				selects++;
+			}
+		}
+		BENCH_CHECK(s->dev[r % SIM_DEVS].mosi_len == mosi);
+		BENCH_CHECK(s->dev[r % SIM_DEVS].selects == selects);
+		spiq_get_stats(&s->q, &st, 0);
+		BENCH_CHECK(st.bursts == bursts && st.xfers == 1);
+	}
+}
+
+/* the bus is busy, those waiting run by priority then in submit order */
+static void test_priority(void)
+{
+	static const uint8_t prio[] = { 0, 0, 2, 1, 3, 2, 0, 3 };
+	static const uint32_t order[] = { 0, 4, 7, 2, 5, 3, 1, 6 };
+	struct sim *s = &g_sim;
+	struct spiq_seg seg = { g_tx, NULL, 256, 0 };
+	struct spiq_xfer x[8];
+	struct spiq_stats st;
+	uint32_t i;
+
+	sim_init(s);
+	for (i = 0; i < 8; i++) {
+		s->dev[i % SIM_DEVS].prio = prio[i];
+		xfer_set(&x[i], &s->dev[i % SIM_DEVS], &seg, 1, i);
+		x[i].prio = prio[i];
+		BENCH_CHECK(spiq_submit(&s->q, &x[i]) == 0);
+	}
+	sim_run(s, s->now + 1000000);
+	BENCH_CHECK(s->done_num == 8);
+	for (i = 0; i < 8; i++)
+		BENCH_CHECK(s->done_order[i] == order[i]);
+	spiq_get_stats(&s->q, &st, 0);
+	BENCH_CHECK(st.depth_max == 7 && st.starved == 0);
+	BENCH_CHECK(st.prio_xfers[0] == 3 && st.prio_xfers[3] == 2);
+}
+
+/* a low priority transaction under a steady high priority load */
+static void test_starve(void)
+{
+	struct sim *s = &g_sim;
+	struct spiq_seg seg = { g_tx, NULL, 16, 0 };
+	struct spiq_xfer hi[2], lo;
+	struct spiq_stats st;
+	uint32_t i;
+
+	sim_init(s);
+	xfer_set(&hi[0], &s->dev[0], &seg, 1, 1);
+	xfer_set(&hi[1], &s->dev[0], &seg, 1, 1);
+	xfer_set(&lo, &s->dev[1], &seg, 1, 2);
+	lo.done = sim_done_once;
+	hi[0].prio = hi[1].prio = SPIQ_PRIO_NUM - 1;
+	lo.prio = 0;
+	s->resubmit = 1000;
+	BENCH_CHECK(spiq_submit(&s->q, &hi[0]) == 0);
+	BENCH_CHECK(spiq_submit(&s->q, &hi[1]) == 0);
+	BENCH_CHECK(spiq_submit(&s->q, &lo) == 0);
+	sim_run(s, s->now + 1000000);
+
+	for (i = 0; i < s->done_num && i < SIM_XFERS; i++) {
+		if (s->done_order[i] == 2)
+			break;
+	}
+	/* the active one, then SPIQ_STARVE_LIMIT picks passing it over */
+	BENCH_CHECK(i == SPIQ_STARVE_LIMIT + 1);
+	spiq_get_stats(&s->q, &st, 0);
+	BENCH_CHECK(st.starved == 1);
+}
+
+/* bad transactions are refused, abort returns the active one first */
+static void test_abort(void)
+{
+	struct sim *s = &g_sim;
+	struct spiq_seg good = { g_tx, NULL, 8, 0 };
+	struct spiq_seg bad[3] = {
+		{ g_tx, NULL, 0, 0 },
+		{ NULL, NULL, 8, 0 },
+		{ g_tx, NULL, SPIQ_SEG_LEN_MAX + 1, 0 },
+	};
+	struct spiq_xfer x[4], *l;
+	uint32_t i;
+
+	sim_init(s);
+	for (i = 0; i < 3; i++) {
+		xfer_set(&x[i], &s->dev[0], &bad[i], 1, i);
+		BENCH_CHECK(spiq_submit(&s->q, &x[i]) == -1);
+	}
+	xfer_set(&x[0], &s->dev[0], &good, 0, 0);
+	BENCH_CHECK(spiq_submit(&s->q, &x[0]) == -1);
+
+	for (i = 0; i < 4; i++) {
+		xfer_set(&x[i], &s->dev[i], &good, 1, i);
+		x[i].prio = i;
+		BENCH_CHECK(spiq_submit(&s->q, &x[i]) == 0);
+	}
+	l = spiq_abort(&s->q);
+	BENCH_CHECK(l == &x[0] && l->next == &x[3] && x[3].next == &x[2] &&
+	            x[2].next == &x[1] && x[1].next == NULL);
+	BENCH_CHECK(!spiq_busy(&s->q) && s->q.depth == 0);
+	for (i = 0; i < SPIQ_PRIO_NUM; i++)
+		BENCH_CHECK(s->q.head[i] == NULL && s->q.tail[i] == NULL);
+}
+
+/* a display, a flash and a sensor sharing a bus for SIM_TIME */
+#define SIM_TIME        1000000
+#define LOAD_DEVS       3
+#define LOAD_PARTS      8
+
+struct load {
+	const char         *name;
+	uint32_t            sclk;
+	uint8_t             mode;
+	uint8_t             prio;
+	uint32_t            period;
+	uint32_t            phase;
+	struct spiq_seg     seg[SIM_SEGS];
+	uint16_t            num;
+	uint16_t            parts;  /* transactions, num / parts segments each */
+	/* results */
+	uint32_t            next_at;
+	uint32_t            arrival;
+	int                 busy;
+	uint32_t            done;
+	uint32_t            overrun;
+	uint64_t            lat_sum;
+	uint32_t            lat_max;
+};
+
+static struct load g_load[LOAD_DEVS];
+static struct spiq_xfer g_load_xfer[LOAD_DEVS][LOAD_PARTS];
+
+static void load_init(void)
+{
+	static uint8_t rx[LOAD_DEVS][SIM_BUF];
+	struct load *l;
+	int i;
+
+	memset(g_load, 0, sizeof(g_load));
+
+	l = &g_load[0];         /* register read every ms */
+	l->name = "sensor 4 MHz, prio 3";
+	l->sclk = 4000000;
+	l->mode = 3;
+	l->prio = 3;
+	l->period = 1000;
+	l->seg[0] = (struct spiq_seg){ g_tx, NULL, 1, 0 };
+	l->seg[1] = (struct spiq_seg){ NULL, rx[0], 6, 0 };
+	l->num = 2;
+	l->parts = 1;
+
+	l = &g_load[1];         /* 2 KB read every 4 ms */
+	l->name = "flash 24 MHz, prio 2";
+	l->sclk = 24000000;
+	l->prio = 2;
+	l->period = 4000;
+	l->phase = 300;
+	l->seg[0] = (struct spiq_seg){ g_tx, NULL, 4, 0 };
+	l->seg[1] = (struct spiq_seg){ NULL, rx[1], 2048, 0 };
+	l->num = 2;
+	l->parts = 1;
+
+	l = &g_load[2];         /* 128x64 frame, a transaction per page */
+	l->name = "display 8 MHz, prio 1";
+	l->sclk = 8000000;
+	l->prio = 1;
+	l->period = 20000;
+	l->phase = 700;
+	for (i = 0; i < 8; i++) {
+		l->seg[2 * i] = (struct spiq_seg){ g_tx, NULL, 3, 0 };
+		l->seg[2 * i + 1] = (struct spiq_seg){ g_tx + 64, NULL, 128, 0 };
+	}
+	l->num = 16;
+	l->parts = 8;
+
+	for (i = 0; i < LOAD_DEVS; i++)
+		g_load[i].next_at = g_load[i].phase;
+}
+
+static void load_done(struct spiq_xfer *x, int status, void *arg)
+{
+	struct load *l = arg;
+	uint32_t lat = g_sim.now - l->arrival;
+
+	BENCH_CHECK(status == 0);
+	if (--l->busy > 0)
+		return;
+	l->done++;
+	l->lat_sum += lat;
+	if (lat > l->lat_max)
+		l->lat_max = lat;
+}
+
+static uint32_t load_next(void)
+{
+	uint32_t t = UINT32_MAX;
+	int i;
+
+	for (i = 0; i < LOAD_DEVS; i++) {
+		if (g_load[i].next_at < t)
+			t = g_load[i].next_at;
+	}
+	return t;
+}
+
+static uint32_t load_shift_us(void)
+{
+	uint32_t us = 0, i, k;
+
+	for (i = 0; i < LOAD_DEVS; i++) {
+		uint32_t bytes = 0;
+
+		for (k = 0; k < g_load[i].num; k++)
+			bytes += g_load[i].seg[k].len;
+		us += bus_us(&(struct sim_dev){ .sclk = g_load[i].sclk }, bytes) *
+		      g_load[i].done;
+	}
+	return us;
+}
+
+static void load_report(const char *how, uint32_t busy_us)
+{
+	int i;
+
+	printf("%s: bus shifting %.1f%%, held %.1f%%\n", how,
+	       load_shift_us() * 100.0 / SIM_TIME, busy_us * 100.0 / SIM_TIME);
+	for (i = 0; i < LOAD_DEVS; i++) {
+		struct load *l = &g_load[i];
+
+		printf("  %-24s %5u done %4u late, latency avg %6.1f us max %6u us\n",
+		       l->name, l->done, l->overrun,
+		       l->done ? (double)l->lat_sum / l->done : 0.0, l->lat_max);
+	}
+}
+
+static void sim_load_queue(uint32_t *lat_avg)
+{
+	struct sim *s = &g_sim;
+	struct spiq_stats st;
+	uint32_t t;
+	int i, k;
+
+	sim_init(s);
+	load_init();
+	for (i = 0; i < LOAD_DEVS; i++) {
+		s->dev[i].sclk = g_load[i].sclk;
+		s->dev[i].mode = g_load[i].mode;
+		s->dev[i].prio = g_load[i].prio;
+		struct load *l = &g_load[i];
+		uint16_t n = l->num / l->parts, k;
+
+		for (k = 0; k < l->parts; k++) {
+			struct spiq_xfer *x = &g_load_xfer[i][k];
+
+			xfer_set(x, &s->dev[i], l->seg + k * n, n, 0);
+			x->done = load_done;
+			x->arg = l;
+		}
+	}
+
+	while ((t = load_next()) < SIM_TIME) {
+		sim_run(s, t);
+		for (i = 0; i < LOAD_DEVS; i++) {
+			struct load *l = &g_load[i];
+
+			if (l->next_at != t)
+				continue;
+			l->next_at += l->period;
+			if (l->busy) {
+				l->overrun++;
+				continue;
+			}
+			l->busy = l->parts;
+			l->arrival = t;
+			for (k = 0; k < l->parts; k++)
+				BENCH_CHECK(spiq_submit(&s->q, &g_load_xfer[i][k]) == 0);
+		}
+	}
+	sim_run(s, SIM_TIME + 100000);
+
+	spiq_get_stats(&s->q, &st, 0);
+	load_report("queue", (uint32_t)st.busy_us);
+	printf("  %u xfers, %u bursts, %u merged, %u device switches, "
+	       "%u clock changes, wait max %u us\n", st.xfers, st.bursts,
+	       st.merged, st.dev_switch, s->set_dev, st.wait_max_us);
+	for (i = 0; i < LOAD_DEVS; i++)
+		lat_avg[i] = g_load[i].done ? (uint32_t)(g_load[i].lat_sum / g_load[i].done) : 0;
+}
+
+/* HAL_SPI_Open, HAL_SPI_CS, a HAL_SPI_Transmit or HAL_SPI_Receive per
+ * segment, polled up to the FIFO size and by DMA above, HAL_SPI_Close */
+static uint32_t blocking_us(const struct load *l)
+{
+	struct sim_dev d = { .sclk = l->sclk };
+	uint32_t us = COST_WAKE + COST_OPEN + COST_SET_DEV, k;
+	uint16_t n = l->num / l->parts;
+
+	for (k = 0; k < n; k++) {
+		us += COST_BURST + bus_us(&d, l->seg[k].len);
+		if (l->seg[k].len > FIFO_SIZE)
+			us += COST_DMA + COST_WAKE;
+	}
+	return us;
+}
+
+/* the threads take the port by priority, as they do the mutex */
+static void sim_load_blocking(uint32_t *lat_avg)
+{
+	uint32_t free_at = 0, busy_us = 0, t, end;
+	int i, sel;
+
+	load_init();
+	for (;;) {
+		/* arrivals while the bus was busy */
+		while ((t = load_next()) <= free_at && t < SIM_TIME) {
+			for (i = 0; i < LOAD_DEVS; i++) {
+				struct load *l = &g_load[i];
+
+				if (l->next_at != t)
+					continue;
+				l->next_at += l->period;
+				if (l->busy) {
+					l->overrun++;
+					continue;
+				}
+				l->busy = l->parts;
+				l->arrival = t;
+			}
+		}
+		sel = -1;
+		for (i = 0; i < LOAD_DEVS; i++) {
+			if (g_load[i].busy && (sel < 0 || g_load[i].prio > g_load[sel].prio))
+				sel = i;
+		}
+		if (sel < 0) {
+			if (t >= SIM_TIME)
+				break;
+			free_at = t;
+			continue;
+		}
+		end = free_at + blocking_us(&g_load[sel]);
+		busy_us += end - free_at;
+		g_sim.now = end;
+		load_done(NULL, 0, &g_load[sel]);
+		free_at = end;
+	}
+	load_report("blocking calls", busy_us);
+	for (i = 0; i < LOAD_DEVS; i++)
+		lat_avg[i] = g_load[i].done ? (uint32_t)(g_load[i].lat_sum / g_load[i].done) : 0;
+}
+
+static void sim_load(void)
+{
+	uint32_t q[LOAD_DEVS], b[LOAD_DEVS];
+	int i;
+
+	sim_load_blocking(b);
+	sim_load_queue(q);
+	/* no thread wakes between the bursts and transactions */
+	for (i = 0; i < LOAD_DEVS; i++)
+		BENCH_CHECK(q[i] < b[i]);
+}
+
+/* the cost of the queue alone, per transaction of a command and answer */
+static void null_start(void *ctx, const struct spiq_xfer *x, const struct spiq_burst *b)
+{
+}
+
+static uint32_t null_now(void *ctx)
+{
+	return 0;
+}
+
+static void bench_queue(void)
+{
+	static const struct spiq_ops ops = { null_start, null_now };
+	struct spiq q;
+	struct spiq_seg seg[2] = {
+		{ g_tx, NULL, 4, 0 },
+		{ NULL, g_rx[0], 256, 0 },
+	};
+	struct spiq_xfer x[4];
+	uint64_t t0;
+	uint32_t i, n = 1000000;
+
+	spiq_init(&q, &ops, NULL);
+	memset(x, 0, sizeof(x));
+	for (i = 0; i < 4; i++) {
+		x[i].seg = seg;
+		x[i].num = 2;
+		x[i].prio = i;
+	}
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		struct spiq_xfer *d;
+
+		BENCH_CHECK(spiq_submit(&q, &x[i & 3]) == 0);
+		if ((i & 3) == 3) {
+			while ((d = spiq_burst_done(&q, 0)) == NULL || spiq_busy(&q))
+				;
+		}
+	}
+	bench_report("submit + burst done, 4 deep", n, bench_now_ns() - t0);
+}
+
+int main(void)
+{
+	test_data();
+	test_priority();
+	test_starve();
+	test_abort();
+	sim_load();
+	bench_queue();
+
+	printf("spi queue checks passed\n");
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Stack usage table (src/kernel/os/FreeRTOS/os_stack_table.c): the watermark
+ * scan over stacks used to random depths, merging of the samples per name,
+ * the warning level, the recommended sizes and the cost of a scan.
+ */
+
+#include <string.h>
+#include "kernel/os/FreeRTOS/os_stack_table.h"
+#include "bench.h"
+
+#define SIM_STACK_SIZE  4096
+#define SIM_ROUNDS      20000
+#define BENCH_SCANS     20000
+
+static uint32_t g_stack[SIM_STACK_SIZE / 4];
+static uint32_t g_seed = 1;
+
+static uint32_t sim_rand(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+/* a descending stack used down to depth bytes from its top */
+static void sim_use(uint32_t *stack, uint32_t size, uint32_t depth)
+{
+	uint8_t *top = (uint8_t *)stack + size;
+
+	memset(top - depth, 0x5a, depth);
+}
+
+static void test_scan(void)
+{
+	uint32_t depth, min_free = SIM_STACK_SIZE, i;
+
+	stktab_fill(g_stack, SIM_STACK_SIZE);
+	BENCH_CHECK(stktab_scan(g_stack, SIM_STACK_SIZE) == SIM_STACK_SIZE);
+	BENCH_CHECK(stktab_scan(g_stack, 0) == 0);
+	BENCH_CHECK(stktab_scan(g_stack, 6) == 4);
+
+	/* the deepest use so far, rounded out to a word */
+	for (i = 0; i < SIM_ROUNDS; i++) {
+		depth = sim_rand() % (SIM_STACK_SIZE / 2);
+		if (i % 1000 == 999)
+			depth = SIM_STACK_SIZE / 2 + sim_rand() % (SIM_STACK_SIZE / 2);
+		sim_use(g_stack, SIM_STACK_SIZE, depth);
+		if (SIM_STACK_SIZE - ((depth + 3) & ~3U) < min_free)
+			min_free = SIM_STACK_SIZE - ((depth + 3) & ~3U);
+		BENCH_CHECK(stktab_scan(g_stack, SIM_STACK_SIZE) == min_free);
+	}
+
+	/* a byte holding the pattern by chance doesn't count, a word may */
+	stktab_fill(g_stack, SIM_STACK_SIZE);
+	((uint8_t *)g_stack)[101] = 0xa5;
+	((uint8_t *)g_stack)[102] = 0x00;
+	BENCH_CHECK(stktab_scan(g_stack, SIM_STACK_SIZE) == 100);
+	stktab_fill(g_stack, SIM_STACK_SIZE);
+	sim_use(g_stack, SIM_STACK_SIZE, SIM_STACK_SIZE);
+	BENCH_CHECK(stktab_scan(g_stack, SIM_STACK_SIZE) == 0);
+}
+
+static void test_table(void)
+{
+	struct stktab_entry entry[4];
+	struct stktab tab;
+	struct stktab_entry *e;
+	int warn;
+
+	stktab_init(&tab, entry, 4, 10);
+
+	/* merged per name, the least free and the most used kept */
+	e = stktab_update(&tab, "tcpip", 2048, 900, &warn);
+	BENCH_CHECK(e && !warn && e->min_free == 900 && e->used_max == 1148);
+	BENCH_CHECK(stktab_update(&tab, "tcpip", 2048, 1200, &warn) == e);
+	BENCH_CHECK(e->min_free == 900 && e->used_max == 1148 && e->samples == 2);
+
+	/* warned once when crossing the level */
+	BENCH_CHECK(stktab_update(&tab, "tcpip", 2048, 205, &warn) == e && !warn);
+	BENCH_CHECK(stktab_update(&tab, "tcpip", 2048, 204, &warn) == e && warn);
+	BENCH_CHECK(stktab_update(&tab, "tcpip", 2048, 100, &warn) == e && !warn);
+	BENCH_CHECK(e->min_free == 100 && e->used_max == 1948);
+
+	/* a thread created again with another size keeps its history */
+	e = stktab_update(&tab, "dhcpd", 1024, 600, &warn);
+	BENCH_CHECK(stktab_update(&tab, "dhcpd", 2048, 1800, &warn) == e);
+	BENCH_CHECK(e->size == 2048 && e->used_max == 424 && e->min_free == 600);
+
+	/* free past the size is clamped, names compare on the stored length */
+	e = stktab_update(&tab, "a_very_long_thread_name", 512, 600, &warn);
+	BENCH_CHECK(e && e->min_free == 512 && e->used_max == 0);
+	BENCH_CHECK(stktab_update(&tab, "a_very_long_thread_other", 512, 0, &warn) == e);
+	BENCH_CHECK(strlen(e->name) == STKTAB_NAME_LEN - 1);
+
+	/* full */
+	BENCH_CHECK(stktab_update(&tab, "[isr]", 1024, 512, &warn) != NULL);
+	BENCH_CHECK(stktab_update(&tab, "extra", 1024, 512, &warn) == NULL);
+	BENCH_CHECK(tab.num == 4 && tab.dropped == 1);
+}
+
+static void test_recommend(void)
+{
+	static const struct {
+		uint32_t used;
+		uint32_t size;
+	} r[] = {
+		{ 0, 256 },             /* the minimum margin */
+		{ 100, 384 },           /* 356 rounded up */
+		{ 1024, 1280 },         /* 25% */
+		{ 1025, 1344 },         /* 1281.25 rounded up */
+		{ 3000, 3776 },
+		{ 100000, 125056 },
+	};
+	struct stktab_entry e;
+	uint32_t i;
+
+	memset(&e, 0, sizeof(e));
+	for (i = 0; i < sizeof(r) / sizeof(r[0]); i++) {
+		e.used_max = r[i].used;
+		BENCH_CHECK(stktab_recommend(&e) == r[i].size);
+		BENCH_CHECK(stktab_recommend(&e) % STKTAB_ALIGN == 0);
+	}
+}
+
+static void bench_scan(void)
+{
+	volatile uint32_t sink = 0;
+	uint64_t t0;
+	uint32_t i;
+
+	stktab_fill(g_stack, SIM_STACK_SIZE);
+	sim_use(g_stack, SIM_STACK_SIZE, 1024);
+	t0 = bench_now_ns();
+	for (i = 0; i < BENCH_SCANS; i++)
+		sink += stktab_scan(g_stack, SIM_STACK_SIZE);
+	bench_report("scan 3 KB free of a 4 KB stack", BENCH_SCANS, bench_now_ns() - t0);
+	(void)sink;
+}
+
+int main(void)
+{
+	test_scan();
+	test_table();
+	test_recommend();
+	bench_scan();
+
+	printf("stack table checks passed\n");
+	return 0;
+}
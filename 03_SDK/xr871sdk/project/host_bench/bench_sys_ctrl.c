@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/os.h"
+#include "sys_ctrl.h"
+#include "bench.h"
+
+#define SYS_CTRL_EVENTS		100000
+#define SYS_CTRL_HANDLERS	20000
+
+static OS_Semaphore_t g_done;
+static uint32_t g_count;
+static uint32_t g_sum;
+
+static void user_event_cb(uint32_t event, uint32_t data, void *arg)
+{
+	g_sum += data;
+	if (++g_count == SYS_CTRL_EVENTS)
+		OS_SemaphoreRelease(&g_done);
+}
+
+static void handler_exec(event_msg *msg)
+{
+	g_count++;
+}
+
+int main(void)
+{
+	observer_base *obs;
+	uint64_t t;
+	uint32_t i;
+
+	BENCH_CHECK(OS_SemaphoreCreateBinary(&g_done) == OS_OK);
+	BENCH_CHECK(sys_ctrl_create() == 0);
+	obs = sys_callback_observer_create(CTRL_MSG_TYPE_USER, ALL_SUBTYPE,
+	                                   user_event_cb, NULL);
+	BENCH_CHECK(obs != NULL);
+	BENCH_CHECK(sys_ctrl_attach(obs) == 0);
+
+	t = bench_now_ns();
+	for (i = 0; i < SYS_CTRL_EVENTS; i++)
+		BENCH_CHECK(sys_event_send(CTRL_MSG_TYPE_USER, i & 0xFF, 1, OS_WAIT_FOREVER) == 0);
+	BENCH_CHECK(OS_SemaphoreWait(&g_done, 10000) == OS_OK);
+	bench_report("sys_event_send to a callback", SYS_CTRL_EVENTS, bench_now_ns() - t);
+	BENCH_CHECK(g_sum == SYS_CTRL_EVENTS);
+
+	g_count = 0;
+	t = bench_now_ns();
+	for (i = 0; i < SYS_CTRL_HANDLERS; i++)
+		BENCH_CHECK(sys_handler_send_wait_finish(handler_exec, i, OS_WAIT_FOREVER) == 0);
+	bench_report("sys_handler_send_wait_finish", SYS_CTRL_HANDLERS, bench_now_ns() - t);
+	BENCH_CHECK(g_count == SYS_CTRL_HANDLERS);
+
+	sys_ctrl_detach(obs);
+	sys_callback_observer_destroy(obs);
+	OS_SemaphoreDelete(&g_done);
+	return 0;
+}
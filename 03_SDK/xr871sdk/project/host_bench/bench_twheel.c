@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Timer wheel (src/kernel/os/FreeRTOS/os_timer_wheel.c) driven by a simulated
+ * tick: random starts, stops and clock jumps checked against a model of the
+ * pending timers, slack coalescing, periodic reload and the overrun figures,
+ * then the cost of the operations.
+ */
+
+#include <string.h>
+#include "kernel/os/FreeRTOS/os_timer_wheel.h"
+#include "bench.h"
+
+#define SIM_TIMERS      512
+#define SIM_STEPS       300000
+#define BENCH_TIMERS    10000
+#define BENCH_TICKS     200000
+
+static struct twheel g_wheel;
+static uint32_t g_seed = 1;
+static uint32_t g_now;          /* the simulated tick */
+
+static uint32_t sim_rand(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static void nop_cb(void *arg)
+{
+}
+
+static int before(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) < 0;
+}
+
+/* every distance, level and boundary, stepping one tick at a time */
+static void test_levels(void)
+{
+	static const uint32_t delays[] = {
+		0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 262143, 262144,
+		262145, 300000, 16777215, 16777216, 16777217, 20000000
+	};
+	struct twheel_timer t[sizeof(delays) / sizeof(delays[0])];
+	struct twheel_timer *e;
+	uint32_t i, n = sizeof(delays) / sizeof(delays[0]), start, next, fired = 0;
+
+	start = g_now = 0xfffff000;
+	twheel_init(&g_wheel, g_now, 1);
+	for (i = 0; i < n; i++) {
+		twheel_timer_init(&t[i], nop_cb, (void *)(uintptr_t)i, 0, 0);
+		twheel_add(&g_wheel, &t[i], g_now + delays[i]);
+	}
+
+	/* first one tick at a time, then a jump to each next expiry */
+	while (fired < n) {
+		if (g_now - start < 70000) {
+			g_now++;
+		} else {
+			BENCH_CHECK(twheel_next(&g_wheel, &next));
+			g_now = next;
+		}
+		while ((e = twheel_expire(&g_wheel, g_now)) != NULL) {
+			i = (uintptr_t)e->arg;
+			BENCH_CHECK(g_now - start == delays[i] + (delays[i] == 0));
+			BENCH_CHECK(!twheel_timer_pending(e));
+			fired++;
+		}
+	}
+	BENCH_CHECK(!twheel_next(&g_wheel, &next));
+	BENCH_CHECK(g_wheel.stats.fired == n && g_wheel.stats.late == 1); /* the 0 */
+}
+
+/*
+ * Random starts with distances of every scale, some slack and some periodic,
+ * stops, and clock steps from one tick to minutes. All the timers due by a
+ * tick, and only those, expire at it.
+ */
+static void test_model(void)
+{
+	static struct twheel_timer t[SIM_TIMERS];
+	static uint8_t pending[SIM_TIMERS];
+	static uint32_t expires[SIM_TIMERS];
+	struct twheel_timer *e;
+	uint32_t i, k, op, step, next, min, due, fired = 0;
+	int found;
+
+	g_now = 0xfff00000;
+	twheel_init(&g_wheel, g_now, 1);
+	memset(pending, 0, sizeof(pending));
+	for (i = 0; i < SIM_TIMERS; i++)
+		twheel_timer_init(&t[i], nop_cb, (void *)(uintptr_t)i, 0, 0);
+
+	for (step = 0; step < SIM_STEPS; step++) {
+		k = sim_rand() % SIM_TIMERS;
+		op = sim_rand() % 8;
+		switch (op) {
+		case 0:
+		case 1:
+		case 2:
+			t[k].slack = (sim_rand() & 1) ? 0 : sim_rand() % 200;
+			if (sim_rand() % 5 == 0) {
+				t[k].flags = TWHEEL_PERIODIC;
+				t[k].period = 1 + sim_rand() % 3000;
+			} else {
+				t[k].flags = 0;
+			}
+			due = g_now + sim_rand() % (1U << (sim_rand() % 26)) - 5;
+			twheel_add(&g_wheel, &t[k], due);
+			BENCH_CHECK(t[k].due == due && t[k].expires - due <= t[k].slack);
+			pending[k] = 1;
+			expires[k] = t[k].expires;
+			break;
+		case 3:
+			twheel_del(&g_wheel, &t[k]);
+			BENCH_CHECK(!twheel_timer_pending(&t[k]));
+			pending[k] = 0;
+			break;
+		default:
+			g_now += (sim_rand() % 64) ? sim_rand() % 40 : sim_rand() % 200000;
+			while ((e = twheel_expire(&g_wheel, g_now)) != NULL) {
+				i = e - t;
+				BENCH_CHECK(pending[i] && !before(g_now, expires[i]));
+				fired++;
+				if (!(e->flags & TWHEEL_PERIODIC)) {
+					BENCH_CHECK(!twheel_timer_pending(e));
+					pending[i] = 0;
+					continue;
+				}
+				/* the model of the reload: the first period ahead */
+				BENCH_CHECK(twheel_timer_pending(e));
+				BENCH_CHECK(before(g_now, e->due) && e->due - g_now <= e->period);
+				BENCH_CHECK(e->expires - e->due <= e->slack);
+				expires[i] = e->expires;
+			}
+			break;
+		}
+
+		/* nothing due is left, the wheel knows the first expiry */
+		found = 0;
+		min = 0;
+		for (i = 0; i < SIM_TIMERS; i++) {
+			BENCH_CHECK(twheel_timer_pending(&t[i]) == pending[i]);
+			if (!pending[i])
+				continue;
+			if (op > 3)
+				BENCH_CHECK(before(g_now, t[i].expires));
+			if (!found || before(t[i].expires, min))
+				min = t[i].expires;
+			found = 1;
+		}
+		BENCH_CHECK(twheel_next(&g_wheel, &next) == found);
+		if (found)
+			BENCH_CHECK(next == min);
+	}
+	BENCH_CHECK(g_wheel.stats.fired == fired);
+}
+
+static void test_slack(void)
+{
+	static struct twheel_timer t[1000];
+	static uint8_t used[1000];
+	struct twheel_timer *e;
+	uint32_t i, delay, ticks = 0, fired = 0;
+
+	g_now = 12345;
+	twheel_init(&g_wheel, g_now, 1);
+	memset(used, 0, sizeof(used));
+	for (i = 0; i < 1000; i++) {
+		/* 10% of slack, over one second of due ticks */
+		delay = 1000 + sim_rand() % 1000;
+		twheel_timer_init(&t[i], nop_cb, NULL, delay, 0);
+		t[i].slack = delay / 10;
+		twheel_add(&g_wheel, &t[i], g_now + delay);
+		used[t[i].expires - g_now - 1000] = 1;
+	}
+	for (i = 0; i < 1000; i++)
+		ticks += used[i];
+	BENCH_CHECK(ticks <= 16);
+
+	while (twheel_next(&g_wheel, &g_now)) {
+		while ((e = twheel_expire(&g_wheel, g_now)) != NULL)
+			fired++;
+	}
+	BENCH_CHECK(fired == 1000 && g_wheel.stats.late == 0);
+	printf("       1000 timers in 1000 ticks with 10%% slack: %u wakeups\n", ticks);
+}
+
+/* a periodic timer and a callback running 25 ticks as the OS service would */
+static void test_overrun(void)
+{
+	struct twheel_timer p, slow;
+	struct twheel_timer *e;
+	uint32_t start, end;
+
+	g_now = 0;
+	twheel_init(&g_wheel, g_now, 1);
+	twheel_timer_init(&p, nop_cb, NULL, 10, TWHEEL_PERIODIC);
+	twheel_timer_init(&slow, nop_cb, NULL, 0, 0);
+	twheel_add(&g_wheel, &p, 10);
+	twheel_add(&g_wheel, &slow, 15);
+
+	end = 100;
+	while (twheel_next(&g_wheel, &g_now) && before(g_now, end)) {
+		while ((e = twheel_expire(&g_wheel, g_now)) != NULL) {
+			start = g_now;
+			if (e == &slow)
+				g_now += 25;
+			twheel_ran(&g_wheel, g_now - start);
+		}
+	}
+
+	/* p at 10, slow at 15 until 40, p late at 40 for 20 then 50 60 ... 90 */
+	BENCH_CHECK(g_wheel.stats.overruns == 1 && g_wheel.stats.run_max == 25);
+	BENCH_CHECK(g_wheel.stats.missed == 2 && g_wheel.stats.late == 1);
+	BENCH_CHECK(g_wheel.stats.late_max == 20 && g_wheel.stats.fired == 1 + 1 + 1 + 5);
+	BENCH_CHECK(p.due == 100);
+}
+
+static void bench_ops(void)
+{
+	static struct twheel_timer t[BENCH_TIMERS];
+	uint64_t ns;
+	uint32_t i, fired = 0;
+
+	g_now = 0;
+	twheel_init(&g_wheel, g_now, 1);
+	for (i = 0; i < BENCH_TIMERS; i++)
+		twheel_timer_init(&t[i], nop_cb, NULL, 0, 0);
+
+	ns = bench_now_ns();
+	for (i = 0; i < 1000000; i++) {
+		twheel_add(&g_wheel, &t[i % BENCH_TIMERS], g_now + 1 + (i * 7919) % 100000);
+		if (i >= BENCH_TIMERS / 2)
+			twheel_del(&g_wheel, &t[(i - BENCH_TIMERS / 2) % BENCH_TIMERS]);
+	}
+	bench_report("twheel add and del", 1000000, bench_now_ns() - ns);
+
+	for (i = 0; i < BENCH_TIMERS; i++)
+		twheel_add(&g_wheel, &t[i], g_now + 1 + (i * 7919) % BENCH_TICKS);
+	ns = bench_now_ns();
+	for (g_now = 1; g_now <= BENCH_TICKS; g_now++) {
+		while (twheel_expire(&g_wheel, g_now) != NULL)
+			fired++;
+	}
+	BENCH_CHECK(fired == BENCH_TIMERS);
+	bench_report("twheel expire, per tick", BENCH_TICKS, bench_now_ns() - ns);
+}
+
+int main(void)
+{
+	test_levels();
+	test_model();
+	test_slack();
+	test_overrun();
+	bench_ops();
+	return 0;
+}
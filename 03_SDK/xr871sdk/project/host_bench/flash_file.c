@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "image/flash.h"
+#include "flash_file.h"
+
+/*
+ * The image/flash.h interface over a file, with NOR flash semantics: erase
+ * sets the bytes of whole blocks to 0xFF, and a write can only clear bits.
+ */
+static FILE *g_flash_fp;
+static flash_file_stat g_flash_stat;
+
+int flash_file_open(const char *path)
+{
+	uint8_t buf[FLASH_FILE_ERASE_BLOCK];
+	uint32_t i;
+
+	g_flash_fp = fopen(path, "r+b");
+	if (g_flash_fp == NULL) {
+		g_flash_fp = fopen(path, "w+b");
+		if (g_flash_fp == NULL)
+			return -1;
+		memset(buf, 0xFF, sizeof(buf));
+		for (i = 0; i < FLASH_FILE_SIZE; i += sizeof(buf))
+			fwrite(buf, 1, sizeof(buf), g_flash_fp);
+	}
+	memset(&g_flash_stat, 0, sizeof(g_flash_stat));
+	return 0;
+}
+
+void flash_file_close(void)
+{
+	if (g_flash_fp) {
+		fclose(g_flash_fp);
+		g_flash_fp = NULL;
+	}
+}
+
+void flash_file_get_stat(flash_file_stat *stat)
+{
+	*stat = g_flash_stat;
+}
+
+uint32_t flash_rw(uint32_t flash, uint32_t addr,
+                  void *buf, uint32_t size, int do_write)
+{
+	uint8_t old[256];
+	uint8_t *data = buf;
+	uint32_t done, len, i;
+
+	if (g_flash_fp == NULL || flash != 0 || addr + size > FLASH_FILE_SIZE)
+		return 0;
+
+	if (!do_write) {
+		fseek(g_flash_fp, addr, SEEK_SET);
+		done = fread(buf, 1, size, g_flash_fp);
+		g_flash_stat.read_bytes += done;
+		return done;
+	}
+
+	for (done = 0; done < size; done += len) {
+		len = size - done;
+		if (len > sizeof(old))
+			len = sizeof(old);
+		fseek(g_flash_fp, addr + done, SEEK_SET);
+		if (fread(old, 1, len, g_flash_fp) != len)
+			break;
+		for (i = 0; i < len; i++)
+			old[i] &= data[done + i];
+		fseek(g_flash_fp, addr + done, SEEK_SET);
+		if (fwrite(old, 1, len, g_flash_fp) != len)
+			break;
+	}
+	g_flash_stat.write_bytes += done;
+	return done;
+}
+
+int32_t flash_get_erase_block(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	if (flash != 0 || addr % FLASH_FILE_ERASE_BLOCK || size % FLASH_FILE_ERASE_BLOCK ||
+	    addr + size > FLASH_FILE_SIZE)
+		return -1;
+	return FLASH_FILE_ERASE_BLOCK;
+}
+
+int flash_erase(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	uint8_t buf[FLASH_FILE_ERASE_BLOCK];
+
+	if (flash_get_erase_block(flash, addr, size) < 0)
+		return -1;
+
+	memset(buf, 0xFF, sizeof(buf));
+	fseek(g_flash_fp, addr, SEEK_SET);
+	for (; size > 0; size -= sizeof(buf)) {
+		fwrite(buf, 1, sizeof(buf), g_flash_fp);
+		g_flash_stat.erase_blocks++;
+	}
+	return 0;
+}
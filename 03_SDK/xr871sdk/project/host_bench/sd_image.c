@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "driver/chip/sdmmc/sdmmc.h"
+#include "sd_image.h"
+
+/*
+ * The block interface of the SD card driver (driver/chip/sdmmc/sdmmc.h) over
+ * a sparse image file, each call counted as one card command. Writes can be
+ * made to fail, like on a card pulled out.
+ */
+static FILE *g_sd_fp;
+static uint32_t g_sd_sectors;
+static int g_sd_fail_writes;
+static sd_image_stat g_sd_stat;
+static struct mmc_card g_sd_card;
+
+int sd_image_open(const char *path, uint32_t sectors)
+{
+	g_sd_fp = fopen(path, "w+b");
+	if (g_sd_fp == NULL)
+		return -1;
+	if (ftruncate(fileno(g_sd_fp), (off_t)sectors * SD_IMAGE_SECTOR) != 0) {
+		sd_image_close();
+		return -1;
+	}
+	g_sd_sectors = sectors;
+	g_sd_fail_writes = 0;
+	memset(&g_sd_stat, 0, sizeof(g_sd_stat));
+	return 0;
+}
+
+void sd_image_close(void)
+{
+	if (g_sd_fp) {
+		fclose(g_sd_fp);
+		g_sd_fp = NULL;
+	}
+}
+
+void sd_image_fail_writes(int fail)
+{
+	g_sd_fail_writes = fail;
+}
+
+void sd_image_get_stat(sd_image_stat *stat)
+{
+	*stat = g_sd_stat;
+}
+
+void sd_image_reset_stat(void)
+{
+	memset(&g_sd_stat, 0, sizeof(g_sd_stat));
+}
+
+static int sd_image_rw(uint8_t *buf, uint32_t sector, uint32_t count, int do_write)
+{
+	size_t len = (size_t)count * SD_IMAGE_SECTOR;
+
+	if (g_sd_fp == NULL || sector + count > g_sd_sectors)
+		return -1;
+	fseeko(g_sd_fp, (off_t)sector * SD_IMAGE_SECTOR, SEEK_SET);
+	if (do_write)
+		return fwrite(buf, 1, len, g_sd_fp) == len ? 0 : -1;
+	return fread(buf, 1, len, g_sd_fp) == len ? 0 : -1;
+}
+
+static void sd_put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void sd_put32(uint8_t *p, uint32_t v)
+{
+	sd_put16(p, (uint16_t)v);
+	sd_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+/*
+ * Format the whole card as a FAT32 volume without partition table, as
+ * f_mkfs() is left out of the build (_USE_MKFS 0). The card must have
+ * enough clusters for FAT32, ie. 65525 at least.
+ */
+int sd_image_format(uint8_t sec_per_clus)
+{
+	const uint32_t rsvd = 32, nfats = 2;
+	uint8_t sec[SD_IMAGE_SECTOR];
+	uint32_t fatsz, clusters, i;
+
+	fatsz = ((g_sd_sectors - rsvd) / sec_per_clus + 2) * 4;
+	fatsz = (fatsz + SD_IMAGE_SECTOR - 1) / SD_IMAGE_SECTOR;
+	clusters = (g_sd_sectors - rsvd - nfats * fatsz) / sec_per_clus;
+	if (clusters < 65525)
+		return -1;
+
+	/* boot sector */
+	memset(sec, 0, sizeof(sec));
+	memcpy(sec, "\xEB\x58\x90" "MSDOS5.0", 11);
+	sd_put16(sec + 11, SD_IMAGE_SECTOR);
+	sec[13] = sec_per_clus;
+	sd_put16(sec + 14, rsvd);
+	sec[16] = nfats;
+	sec[21] = 0xF8;
+	sd_put16(sec + 24, 63);
+	sd_put16(sec + 26, 255);
+	sd_put32(sec + 32, g_sd_sectors);
+	sd_put32(sec + 36, fatsz);
+	sd_put32(sec + 44, 2);          /* root directory cluster */
+	sd_put16(sec + 48, 1);          /* FSInfo sector */
+	sd_put16(sec + 50, 6);          /* backup boot sector */
+	sec[64] = 0x80;
+	sec[66] = 0x29;
+	sd_put32(sec + 67, 0x20171234);
+	memcpy(sec + 71, "NO NAME    FAT32   ", 19);
+	sec[510] = 0x55;
+	sec[511] = 0xAA;
+	if (sd_image_rw(sec, 0, 1, 1) != 0 || sd_image_rw(sec, 6, 1, 1) != 0)
+		return -1;
+
+	/* FSInfo, free count and next free cluster unknown */
+	memset(sec, 0, sizeof(sec));
+	sd_put32(sec, 0x41615252);
+	sd_put32(sec + 484, 0x61417272);
+	sd_put32(sec + 488, 0xFFFFFFFF);
+	sd_put32(sec + 492, 0xFFFFFFFF);
+	sd_put32(sec + 508, 0xAA550000);
+	if (sd_image_rw(sec, 1, 1, 1) != 0 || sd_image_rw(sec, 7, 1, 1) != 0)
+		return -1;
+
+	/* FATs, media and end of chain, then the root directory cluster */
+	memset(sec, 0, sizeof(sec));
+	for (i = 0; i < nfats * fatsz; i++) {
+		if (sd_image_rw(sec, rsvd + i, 1, 1) != 0)
+			return -1;
+	}
+	sd_put32(sec, 0x0FFFFFF8);
+	sd_put32(sec + 4, 0x0FFFFFFF);
+	sd_put32(sec + 8, 0x0FFFFFFF);
+	for (i = 0; i < nfats; i++) {
+		if (sd_image_rw(sec, rsvd + i * fatsz, 1, 1) != 0)
+			return -1;
+	}
+	memset(sec, 0, sizeof(sec));
+	for (i = 0; i < sec_per_clus; i++) {
+		if (sd_image_rw(sec, rsvd + nfats * fatsz + i, 1, 1) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/* the card is always there and initialized, for fs_ctrl_mount() */
+int32_t mmc_card_create(uint8_t card_id)
+{
+	return (card_id == 0 && g_sd_fp != NULL) ? 0 : -1;
+}
+
+int32_t mmc_card_delete(uint8_t card_id, uint32_t flg)
+{
+	return 0;
+}
+
+int32_t mmc_rescan(struct mmc_card *card, uint32_t sdc_id)
+{
+	return 0;
+}
+
+int32_t mmc_card_deinit(struct mmc_card *card)
+{
+	return 0;
+}
+
+struct mmc_card *mmc_card_open(uint8_t card_id)
+{
+	if (card_id != 0 || g_sd_fp == NULL)
+		return NULL;
+	g_sd_card.state = MMC_STATE_PRESENT | MMC_STATE_BLOCKADDR;
+	return &g_sd_card;
+}
+
+int32_t mmc_card_close(uint8_t card_id)
+{
+	return 0;
+}
+
+int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk, uint32_t nblk)
+{
+	if (nblk > 1)
+		g_sd_stat.read_multi++;
+	else
+		g_sd_stat.read_single++;
+	g_sd_stat.read_sectors += nblk;
+	return sd_image_rw(buf, (uint32_t)sblk, nblk, 0);
+}
+
+int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk, uint32_t nblk)
+{
+	if (g_sd_fail_writes)
+		return -1;
+	if (nblk > 1)
+		g_sd_stat.write_multi++;
+	else
+		g_sd_stat.write_single++;
+	g_sd_stat.write_sectors += nblk;
+	return sd_image_rw((uint8_t *)buf, (uint32_t)sblk, nblk, 1);
+}
+
+int32_t mmc_block_write_vec(struct mmc_card *card, const uint8_t * const *bufs,
+                            uint64_t sblk, uint32_t nblk)
+{
+	uint32_t i;
+
+	if (g_sd_fail_writes || nblk > MMC_BLOCK_VEC_MAX)
+		return -1;
+	if (nblk > 1)
+		g_sd_stat.write_multi++;
+	else
+		g_sd_stat.write_single++;
+	g_sd_stat.write_sectors += nblk;
+	for (i = 0; i < nblk; i++) {
+		if (sd_image_rw((uint8_t *)bufs[i], (uint32_t)sblk + i, 1, 1) != 0)
+			return -1;
+	}
+	return 0;
+}
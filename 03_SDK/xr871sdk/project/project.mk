@@ -123,6 +123,14 @@ endif
 LINKER_SCRIPT_PATH ?= $(ROOT_PATH)/project/linker_script/gcc/$(CONFIG_CHIP_NAME)
 LINKER_SCRIPT ?= $(LINKER_SCRIPT_PATH)/appos$(SUFFIX_XIP)$(LINKER_SCRIPT_SUFFIX).ld
 
+# linker script fragment moving hot XIP code to SRAM, generated by
+# tools/xip_place.py, maybe set by the specific project. It MUST be in front
+# of the linker script to take precedence over the rules of .xip.
+XIP_HOT_LINKER_SCRIPT ?=
+ifneq ($(XIP_HOT_LINKER_SCRIPT),)
+  LINKER_SCRIPT_HOT := -T$(XIP_HOT_LINKER_SCRIPT)
+endif
+
 # ----------------------------------------------------------------------------
 # image
 # ----------------------------------------------------------------------------
@@ -151,6 +159,12 @@ else
 endif
 XZ_BINS ?= $(XZ_DEFAULT_BINS)
 
+# lz4 is a tool used to compress bins with the fast LZ codec, which is chosen
+# by setting IMAGE_ATTR_CODEC_LZ4 in the section attribute, eg. "attr": "0x31"
+# for "net.bin.lz4". The bins in LZ4_BINS should be removed from XZ_BINS.
+LZ4 := lz4 -f -q -l -12 -m
+LZ4_BINS ?=
+
 endif # __CONFIG_BIN_COMPRESS
 
 # output image path
@@ -201,7 +215,7 @@ endif
 all: $(PROJECT).bin size
 
 $(PROJECT).$(ELF_EXT): $(OBJS)
-	$(Q)$(CC) $(LD_FLAGS) -T$(LINKER_SCRIPT) $(LIBRARY_PATHS) -o $@ $(OBJS) $(LIBRARIES)
+	$(Q)$(CC) $(LD_FLAGS) $(LINKER_SCRIPT_HOT) -T$(LINKER_SCRIPT) $(LIBRARY_PATHS) -o $@ $(OBJS) $(LIBRARIES)
 
 %.bin: %.$(ELF_EXT)
 	$(Q)$(OBJCOPY) -O binary $(OBJCOPY_R_XIP) $(OBJCOPY_R_EXT) $< $@
@@ -260,6 +274,10 @@ image: install
 ifeq ($(__CONFIG_BIN_COMPRESS), y)
 	cd $(IMAGE_PATH) && \
 	$(Q)$(XZ) $(XZ_BINS)
+ifneq ($(LZ4_BINS),)
+	cd $(IMAGE_PATH) && \
+	$(Q)$(LZ4) $(LZ4_BINS)
+endif
 endif
 	cd $(IMAGE_PATH) && \
 	chmod a+r *.bin && \
@@ -267,7 +285,7 @@ endif
 
 image_clean:
 	cd $(IMAGE_PATH) && \
-	rm -f $(BIN_NAMES) app*.bin *.xz *.img
+	rm -f $(BIN_NAMES) app*.bin *.xz *.lz4 *.img
 
 endif # __PRJ_CONFIG_ETF
 
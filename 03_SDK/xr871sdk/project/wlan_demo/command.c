@@ -41,6 +41,7 @@
 #define COMMAND_DHCPD       0
 #define COMMAND_BRROADCAST  0
 #define COMMAND_ARP         0
+#define COMMAND_SOCKBENCH   0
 
 /*
  * net commands
@@ -100,6 +101,10 @@ static const struct cmd_data g_net_cmds[] = {
 #if COMMAND_ARP
 	{ "arp",        cmd_arp_exec },
 #endif
+
+#if COMMAND_SOCKBENCH
+	{ "sockbench",  cmd_sockbench_exec },
+#endif
 };
 
 static enum cmd_status cmd_net_exec(char *cmd)
@@ -128,6 +133,7 @@ static const struct cmd_data g_main_cmds[] = {
 	{ "mem",	cmd_mem_exec },
 	{ "heap",	cmd_heap_exec },
 	{ "thread",	cmd_thread_exec },
+	{ "prof",	cmd_prof_exec },
 	{ "upgrade",cmd_upgrade_exec },
 	{ "reboot", cmd_reboot_exec },
 #ifdef __PRJ_CONFIG_OTA
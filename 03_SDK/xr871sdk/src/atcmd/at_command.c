@@ -249,17 +249,49 @@ AT_ERROR_CODE at_help(void)
 	return AEC_OK;
 }
 
+/* indices of at_command_table sorted by command, for at_match() */
+static u8 at_command_index[TABLE_SIZE(at_command_table)];
+
+static void at_sort_commands(void)
+{
+	s32 i, j;
+	u8 idx;
+
+	for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
+		idx = i;
+		for (j = i; j > 0; j--) {
+			if (strcmp(at_command_table[at_command_index[j-1]].cmd, at_command_table[idx].cmd) <= 0) {
+				break;
+			}
+			at_command_index[j] = at_command_index[j-1];
+		}
+		at_command_index[j] = idx;
+	}
+}
+
 static s32 at_match(char *cmd)
 {
-	s32 i;
+	s32 lo, hi, mid;
+	s32 res;
 
 	if (cmd == NULL) {
 		return -2;
 	}
 
-	for (i = 0; i < TABLE_SIZE(at_command_table); i++) {
-		if (!strcmp(cmd, at_command_table[i].cmd)) {
-			return i;
+	lo = 0;
+	hi = TABLE_SIZE(at_command_table) - 1;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		res = strcmp(cmd, at_command_table[at_command_index[mid]].cmd);
+		if (res == 0) {
+			return at_command_index[mid];
+		}
+		else if (res < 0) {
+			hi = mid - 1;
+		}
+		else {
+			lo = mid + 1;
 		}
 	}
 
@@ -315,6 +347,8 @@ AT_ERROR_CODE at_init(at_callback_t *cb)
 
 	memset(&cache, 0, sizeof(cache));
 
+	at_sort_commands();
+
 	return AEC_OK;
 }
 
@@ -384,56 +418,50 @@ static AT_ERROR_CODE at_parse_cmd(char *cmdline, s32 size)
 AT_ERROR_CODE at_parse(void)
 {
 	AT_ERROR_CODE aec;
-	AT_QUEUE_ERROR_CODE aqec;
+	u8 *data;
+	s32 len;
+	s32 n;
 	u8 tmp;
 	u32 flag = 0;
 
 	while(1) {
-		aqec = at_queue_get(&tmp);
-
-		if(aqec == AQEC_OK) {
-			if (tmp == AT_LF) {
-				if(cache.cnt < CMD_CACHE_MAX_LEN) {
-					cache.buf[cache.cnt++] = tmp;
-				}
-				else {
-					cache.cnt = 0;
-					AT_DBG("command is discarded!\n");
-					continue; /* command is discarded */
-				}
+		len = at_queue_span(&data);
+		if (len <= 0) {
+			continue;
+		}
 
+		/* take the data up to and including the line end */
+		for (n = 0; n < len; n++) {
+			if (data[n] == AT_LF || data[n] == AT_CR) {
+				n++;
 				flag = 1;
+				break;
 			}
-			else if (tmp == AT_CR) {
-				cache.buf[cache.cnt++] = tmp;
+		}
+
+		if (cache.cnt + n >= CMD_CACHE_MAX_LEN) {
+			at_queue_consume(n);
+			cache.cnt = 0;
+			flag = 0;
+			AT_DBG("command is discarded!\n");
+			continue; /* command is discarded */
+		}
 
-				aqec = at_queue_peek(&tmp);
-				if(aqec == AQEC_OK && tmp == AT_LF) {
-					aqec = at_queue_peek(&tmp);
-					if(cache.cnt < CMD_CACHE_MAX_LEN) {
+		memcpy(&cache.buf[cache.cnt], data, n);
+		cache.cnt += n;
+		at_queue_consume(n);
+
+		if (flag) {
+			if (cache.buf[cache.cnt-1] == AT_CR) {
+				/* CR LF ends the line as well */
+				if (at_queue_peek(&tmp) == AQEC_OK && tmp == AT_LF) {
+					at_queue_consume(1);
+					if (cache.cnt < CMD_CACHE_MAX_LEN - 1) {
 						cache.buf[cache.cnt++] = tmp;
 					}
-					else {
-						cache.cnt = 0;
-						AT_DBG("command is discarded!\n");
-						continue; /* command is discarded */
-					}
 				}
-
-				flag = 1;
 			}
 
-			if(cache.cnt < CMD_CACHE_MAX_LEN) {
-				cache.buf[cache.cnt++] = tmp;
-			}
-			else {
-				cache.cnt = 0;
-				AT_DBG("command is discarded!\n");
-				continue; /* command is discarded */
-			}
-		}
-
-		if (flag) {
 			/* echo */
 			if (at_cfg.localecho1) {
 				cache.buf[cache.cnt] = '\0';
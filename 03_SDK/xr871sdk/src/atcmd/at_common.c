@@ -157,46 +157,50 @@ AT_ERROR_CODE at_reset(void)
 
 AT_ERROR_CODE at_mode(AT_MODE mode)
 {
-	AT_QUEUE_ERROR_CODE aqec;
 	at_callback_para_t para;
-	s32 len,escape_len;
-	u8 tmp;
+	s32 len,rlen,escape_len;
 
 	if (at_callback.handle_cb != NULL) {
 		memset(&para, 0, sizeof(para));
 		escape_len = strlen(at_cfg.escape_seq);
 		at_dump("Enter data mode.\r\n");
-		while (1) {
-			para.u.mode.buf = at_socket_buf;
 
-			len = 0;
+		/* the application passes received data to the serial port itself */
+		if (at_callback.handle_cb(ACC_MODE_START, &para, NULL) != AEC_OK) {
+			at_dump("Exit data mode.\r\n");
+			return AEC_OK;
+		}
 
-			while (len < AT_SOCKET_BUFFER_SIZE) {
-				aqec = at_queue_get(&tmp);
+		para.u.mode.buf = at_socket_buf;
+		len = 0;
 
-				//AT_DBG("aqec = %d\n", aqec);
-				//AT_DBG("len = %d\n", len);
-				if(aqec == AQEC_OK) {
-					at_socket_buf[len++] = tmp;
-				}
-				else {
-					break;
+		while (1) {
+			rlen = at_queue_read(&at_socket_buf[len], AT_SOCKET_BUFFER_SIZE - len);
+			if (rlen > 0) {
+				len += rlen;
+				if (len < AT_MODE_FLUSH_SIZE) {
+					continue;
 				}
 			}
-
-			if (len > 2 && (len >= escape_len && len <= escape_len + 2) &&
-				!strncmp(at_cfg.escape_seq, (const char *)at_socket_buf, escape_len)) {
+			else if (len > 2 && (len >= escape_len && len <= escape_len + 2) &&
+			         !strncmp(at_cfg.escape_seq, (const char *)at_socket_buf, escape_len)) {
+				/* escape sequence between two idle periods */
 				at_dump("Exit data mode.\r\n");
 				break;
 			}
 
+			/* full or idle, len is 0 when only polling the connection state */
 			para.u.mode.len = len;
-			//AT_DBG("Enter callback\n");
 			if (at_callback.handle_cb(ACC_MODE, &para, NULL) != AEC_OK) {
 				at_dump("Exit data mode.\r\n");
 				break;
 			}
+
+			len = 0;
 		}
+
+		para.u.mode.len = 0;
+		at_callback.handle_cb(ACC_MODE_STOP, &para, NULL);
 	}
 
 	return AEC_OK;
@@ -39,6 +39,10 @@ extern "C" {
 #define AT_SOCKET_BUFFER_SIZE	1024L
 #define MAX_DUMP_BUFF_SIZE	1024L
 
+/* data mode sends what came from the serial port once this much is buffered,
+   or when the serial port is idle, ie. the queue callback returns no data */
+#define AT_MODE_FLUSH_SIZE	AT_SOCKET_BUFFER_SIZE
+
 #define ANL_WINDOWS	0
 #define ANL_UNIX	1
 #define ANL_MAC		2
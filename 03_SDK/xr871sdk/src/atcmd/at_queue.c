@@ -52,37 +52,55 @@ s32 at_queue_init(void *buf, s32 size, at_queue_callback_t cb)
 	return 0;
 }
 
-AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
+/*
+ * Let the callback write into the free space of the ring, as much as is
+ * contiguous. Returns the number of bytes added.
+ */
+static s32 at_queue_fill(at_queue_t *q)
 {
-	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
+	s32 space;
 	s32 dcnt;
 
+	if (at_queue_callback == NULL) {
+		return 0;
+	}
+
 	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+		/* restart at the beginning to offer the largest span */
+		q->ridx = 0;
+		q->widx = 0;
+	}
+
+	space = q->qsize - q->qcnt;
+	if (space > q->qsize - q->widx) {
+		space = q->qsize - q->widx;
+	}
+	if (space <= 0) {
+		return 0;
+	}
+
+	dcnt = at_queue_callback(&q->qbuf[q->widx], space);
+	if (dcnt <= 0) {
+		return 0;
+	}
+	if (dcnt > space) {
+		AT_DBG("queue is overflow\n");
+		dcnt = space;
+	}
+
+	q->widx += dcnt;
+	q->widx = q->widx >= q->qsize ? 0 : q->widx;
+	q->qcnt += dcnt;
+
+	return dcnt;
+}
+
+AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
+{
+	at_queue_t *q = &at_queue;
+
+	if (q->qcnt <= 0 && at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx++];
@@ -95,37 +113,87 @@ AT_QUEUE_ERROR_CODE at_queue_get(u8 *element)
 AT_QUEUE_ERROR_CODE at_queue_peek(u8 *element)
 {
 	at_queue_t *q = &at_queue;
-	u8 winbuf[32];
-	s32 dcnt;
 
-	if (q->qcnt <= 0) {
-		if (at_queue_callback != NULL) {
-			dcnt = at_queue_callback(winbuf, sizeof(winbuf));
-
-			if (dcnt > 0) {
-				if (dcnt > q->qsize - q->qcnt) {
-					AT_DBG("queue is overflow\n");
-				}
-				else {
-					s32 i;
-
-					for (i=0; i < dcnt; i++) {
-						q->qbuf[q->widx++] = winbuf[i];
-						q->widx = q->widx >= q->qsize ? 0 : q->widx;
-						q->qcnt++;
-					}
-				}
-			}
-			else {
-				return AQEC_EMPTY;
-			}
-		}
-		else {
-			return AQEC_EMPTY;
-		}
+	if (q->qcnt <= 0 && at_queue_fill(q) <= 0) {
+		return AQEC_EMPTY;
 	}
 
 	*element = q->qbuf[q->ridx];
 
 	return AQEC_OK;
 }
+
+/**
+  * @brief  Read up to size bytes from the queue.
+  * @param	buf: destination buffer
+  * @param	size: size of the buffer
+  * @retval number of bytes read, 0 if no data arrived
+  */
+s32 at_queue_read(u8 *buf, s32 size)
+{
+	u8 *ptr;
+	s32 len;
+	s32 cnt = 0;
+
+	while (cnt < size) {
+		if (cnt > 0 && at_queue.qcnt <= 0) {
+			break; /* don't wait for more */
+		}
+
+		len = at_queue_span(&ptr);
+		if (len <= 0) {
+			break;
+		}
+		if (len > size - cnt) {
+			len = size - cnt;
+		}
+
+		memcpy(buf + cnt, ptr, len);
+		at_queue_consume(len);
+		cnt += len;
+	}
+
+	return cnt;
+}
+
+/**
+  * @brief  Get the data at the head of the queue without copying it.
+  * @note	The data stays in the queue until at_queue_consume() is called.
+  * @param	ptr: returns the head of the queue
+  * @retval number of contiguous bytes at ptr, 0 if no data arrived
+  */
+s32 at_queue_span(u8 **ptr)
+{
+	at_queue_t *q = &at_queue;
+	s32 len;
+
+	if (q->qcnt <= 0 && at_queue_fill(q) <= 0) {
+		return 0;
+	}
+
+	len = q->qsize - q->ridx;
+	if (len > q->qcnt) {
+		len = q->qcnt;
+	}
+	*ptr = &q->qbuf[q->ridx];
+
+	return len;
+}
+
+/**
+  * @brief  Drop len bytes from the head of the queue.
+  * @param	len: number of bytes, at most the length returned by at_queue_span()
+  * @retval None
+  */
+void at_queue_consume(s32 len)
+{
+	at_queue_t *q = &at_queue;
+
+	if (len > q->qcnt) {
+		len = q->qcnt;
+	}
+
+	q->ridx += len;
+	q->ridx = q->ridx >= q->qsize ? q->ridx - q->qsize : q->ridx;
+	q->qcnt -= len;
+}
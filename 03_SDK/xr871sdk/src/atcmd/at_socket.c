@@ -92,10 +92,8 @@ AT_ERROR_CODE at_sockw(char *id, s32 len)
 
 		para.u.sockw.len = rlen;
 
-		for (i = 0; i < rlen; i++) {
-			while (at_queue_get(&at_socket_buf[i]) != AQEC_OK) {
-				;
-			}
+		for (i = 0; i < rlen; ) {
+			i += at_queue_read(&at_socket_buf[i], rlen - i);
 		}
 
 		if (at_callback.handle_cb != NULL) {
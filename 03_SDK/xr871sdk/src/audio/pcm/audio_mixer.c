@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kernel/os/os.h"
+#include "audio/pcm/audio_pcm.h"
+#include "audio/pcm/audio_mixer.h"
+
+#define MIXER_DBG_ON    0
+
+#define MIXER_LOG(flags, fmt, arg...)   \
+	do {                                \
+		if (flags)                      \
+			printf("[MIXER]"fmt, ##arg); \
+	} while (0)
+
+#define MIXER_DBG(fmt, arg...)  MIXER_LOG(MIXER_DBG_ON, fmt, ##arg)
+#define MIXER_ERR(fmt, arg...)  MIXER_LOG(1, fmt, ##arg)
+
+/* SMLAD/QADD16 are only available on cores with the DSP extension (CM4) */
+#if (defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP)
+#define MIXER_USE_DSP           1
+#else
+#define MIXER_USE_DSP           0
+#endif
+
+#define MIXER_THREAD_STACK_SIZE (2 * 1024)
+#define MIXER_RATE_MIN          4000
+#define MIXER_RATE_MAX          96000
+
+#define MIXER_PHASE_BITS        16
+#define MIXER_PHASE_ONE         (1U << MIXER_PHASE_BITS)
+#define MIXER_FRAC_BITS         14      /* interpolation weights fit in int16 */
+#define MIXER_GAIN_SHIFT        8       /* ramped gain is kept in Q23 */
+#define MIXER_DUCK_GAIN_DEFAULT 0x2000  /* about -12dB */
+
+enum mixer_state {
+	MIXER_STATE_IDLE = 0,
+	MIXER_STATE_RUN,
+	MIXER_STATE_STOP,
+};
+
+struct snd_mixer_stream {
+	int16_t         *buf;       /* queued source frames, interleaved */
+	unsigned int    frames;     /* capacity of buf in frames */
+	unsigned int    rd;
+	unsigned int    wr;
+	unsigned int    avail;
+	unsigned int    channels;
+	uint32_t        step;       /* source frames per card frame, Q16 */
+	uint32_t        phase;      /* position between cur[] and next[], Q16 */
+	int16_t         cur[2];
+	int16_t         next[2];
+	int32_t         gain;       /* current gain, Q23 */
+	uint16_t        volume;     /* requested gain, Q15 */
+	uint8_t         priority;
+	uint8_t         used;
+	uint8_t         waiting;
+	OS_Semaphore_t  space;
+};
+
+struct snd_mixer {
+	struct pcm_config       *config;
+	unsigned int            card;
+	volatile uint8_t        state;
+	uint16_t                duck_gain;
+	unsigned int            period_frames;
+	int16_t                 *tmp;
+	struct snd_mixer_stat   stat;
+	OS_Mutex_t              lock;
+	OS_Thread_t             thread;
+	struct snd_mixer_stream stream[SND_MIXER_STREAM_MAX];
+};
+
+static struct snd_mixer snd_mixer_priv;
+
+#define mixer_lock(m)       OS_MutexLock(&(m)->lock, OS_WAIT_FOREVER)
+#define mixer_unlock(m)     OS_MutexUnlock(&(m)->lock)
+
+static __inline int16_t mixer_interp(int16_t a, int16_t b, uint32_t phase)
+{
+	int32_t f = phase >> (MIXER_PHASE_BITS - MIXER_FRAC_BITS);
+#if MIXER_USE_DSP
+	return (int16_t)(__SMUAD(__PKHBT((uint16_t)a, (uint16_t)b, 16),
+	                         __PKHBT((1 << MIXER_FRAC_BITS) - f, f, 16)) >> MIXER_FRAC_BITS);
+#else
+	return (int16_t)((a * ((1 << MIXER_FRAC_BITS) - f) + b * f) >> MIXER_FRAC_BITS);
+#endif
+}
+
+static __inline int16_t mixer_sat16(int32_t x)
+{
+#if MIXER_USE_DSP
+	return (int16_t)__SSAT(x, 16);
+#else
+	if (x > 32767)
+		return 32767;
+	if (x < -32768)
+		return -32768;
+	return (int16_t)x;
+#endif
+}
+
+/* dst[i] = sat16(dst[i] + src[i]), both buffers are 4 bytes aligned */
+static void mixer_add(int16_t *dst, const int16_t *src, unsigned int samples)
+{
+#if MIXER_USE_DSP
+	uint32_t *d = (uint32_t *)dst;
+	const uint32_t *s = (const uint32_t *)src;
+	unsigned int pairs = samples >> 1;
+
+	while (pairs--) {
+		*d = __QADD16(*d, *s);
+		d++;
+		s++;
+	}
+	if (samples & 1)
+		dst[samples - 1] = mixer_sat16(dst[samples - 1] + src[samples - 1]);
+#else
+	unsigned int i;
+
+	for (i = 0; i < samples; i++)
+		dst[i] = mixer_sat16(dst[i] + src[i]);
+#endif
+}
+
+static __inline void mixer_stream_pop(struct snd_mixer_stream *s)
+{
+	const int16_t *p = s->buf + s->rd * s->channels;
+
+	s->cur[0] = s->next[0];
+	s->cur[1] = s->next[1];
+	s->next[0] = p[0];
+	s->next[1] = (s->channels == 2) ? p[1] : p[0];
+	if (++s->rd == s->frames)
+		s->rd = 0;
+	s->avail--;
+}
+
+/*
+ * Resample, convert channels and apply the gain ramp of one stream into
+ * s16 card frames. Returns the number of frames rendered, less than @frames
+ * if the stream ran dry.
+ */
+static unsigned int mixer_stream_render(struct snd_mixer_stream *s, int16_t *out,
+                                        unsigned int frames, unsigned int out_ch,
+                                        int32_t target)
+{
+	unsigned int i;
+	int32_t gain = s->gain;
+	int32_t gstep = (target - gain) / (int32_t)frames;
+	int16_t l, r;
+
+	for (i = 0; i < frames; i++) {
+		while (s->phase >= MIXER_PHASE_ONE) {
+			if (s->avail == 0)
+				goto out;
+			mixer_stream_pop(s);
+			s->phase -= MIXER_PHASE_ONE;
+		}
+
+		l = mixer_interp(s->cur[0], s->next[0], s->phase);
+		r = mixer_interp(s->cur[1], s->next[1], s->phase);
+		s->phase += s->step;
+
+		gain += gstep;
+		if (out_ch == 2) {
+			*out++ = (int16_t)((l * (gain >> MIXER_GAIN_SHIFT)) >> 15);
+			*out++ = (int16_t)((r * (gain >> MIXER_GAIN_SHIFT)) >> 15);
+		} else {
+			*out++ = (int16_t)((((l + r) >> 1) * (gain >> MIXER_GAIN_SHIFT)) >> 15);
+		}
+	}
+	gain = target;
+out:
+	s->gain = gain;
+	return i;
+}
+
+static unsigned int mixer_duck_priority(struct snd_mixer *m)
+{
+	unsigned int i, prio = 0;
+
+	for (i = 0; i < SND_MIXER_STREAM_MAX; i++) {
+		if (m->stream[i].used && m->stream[i].avail && m->stream[i].priority > prio)
+			prio = m->stream[i].priority;
+	}
+	return prio;
+}
+
+static void mixer_task(void *arg)
+{
+	struct snd_mixer *m = arg;
+	struct snd_mixer_stream *s;
+	unsigned int i, n, prio, active, bytes;
+	unsigned int ch = m->config->channels;
+	int16_t *mix;
+	int32_t target;
+
+	MIXER_DBG("%s() start...\n", __func__);
+
+	while (m->state == MIXER_STATE_RUN) {
+		/* mix straight into the next free period of the card DMA buffer */
+		if (snd_pcm_mmap_begin(m->config, m->card, PCM_OUT, (void **)&mix, &bytes,
+		                       OS_WAIT_FOREVER) != 0) {
+			MIXER_ERR("mmap begin failed\n");
+			break;
+		}
+		memset(mix, 0, bytes);
+		active = 0;
+
+		mixer_lock(m);
+		prio = mixer_duck_priority(m);
+		for (i = 0; i < SND_MIXER_STREAM_MAX; i++) {
+			s = &m->stream[i];
+			if (!s->used || s->avail == 0)
+				continue;
+
+			target = s->volume;
+			if (s->priority < prio)
+				target = (target * m->duck_gain) >> 15;
+			target <<= MIXER_GAIN_SHIFT;
+
+			n = mixer_stream_render(s, m->tmp, m->period_frames, ch, target);
+			mixer_add(mix, m->tmp, n * ch);
+			if (n < m->period_frames)
+				m->stat.underruns++;
+			active++;
+
+			if (s->waiting) {
+				s->waiting = 0;
+				OS_SemaphoreRelease(&s->space);
+			}
+		}
+		m->stat.active_streams = active;
+		if (active)
+			m->stat.periods++;
+		else
+			m->stat.idle_periods++;
+		mixer_unlock(m);
+
+		/* silence is committed while idle to keep the card clocked */
+		snd_pcm_mmap_commit(m->config, m->card, PCM_OUT, mix);
+	}
+
+	MIXER_DBG("%s() exit\n", __func__);
+	m->state = MIXER_STATE_IDLE;
+	OS_ThreadDelete(&m->thread);
+}
+
+int snd_mixer_open(struct pcm_config *config, unsigned int card)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+
+	if (m->tmp != NULL || OS_ThreadIsValid(&m->thread)) {
+		MIXER_ERR("mixer busy\n");
+		return -1;
+	}
+	if (config->format != PCM_FORMAT_S16_LE ||
+	    (config->channels != 1 && config->channels != 2)) {
+		MIXER_ERR("invalid card format\n");
+		return -1;
+	}
+
+	memset(m, 0, sizeof(*m));
+	m->config = config;
+	m->card = card;
+	m->duck_gain = MIXER_DUCK_GAIN_DEFAULT;
+	/* the card DMA buffer is made of two periods */
+	m->period_frames = pcm_get_buffer_size(config) / 2;
+
+	m->tmp = pcm_zalloc(pcm_frames_to_bytes(config, m->period_frames));
+	if (m->tmp == NULL) {
+		MIXER_ERR("no mem\n");
+		goto err;
+	}
+
+	if (OS_MutexCreate(&m->lock) != OS_OK)
+		goto err;
+
+	if (snd_pcm_open(config, card, PCM_OUT) != 0) {
+		MIXER_ERR("pcm open failed\n");
+		goto err_lock;
+	}
+
+	m->state = MIXER_STATE_RUN;
+	if (OS_ThreadCreate(&m->thread, "snd_mixer", mixer_task, m,
+	                    OS_PRIORITY_ABOVE_NORMAL, MIXER_THREAD_STACK_SIZE) != OS_OK) {
+		MIXER_ERR("thread create failed\n");
+		m->state = MIXER_STATE_IDLE;
+		snd_pcm_close(card, PCM_OUT);
+		goto err_lock;
+	}
+	return 0;
+
+err_lock:
+	OS_MutexDelete(&m->lock);
+err:
+	pcm_free(m->tmp);
+	m->tmp = NULL;
+	return -1;
+}
+
+int snd_mixer_close(unsigned int card)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	unsigned int i;
+
+	if (m->tmp == NULL || m->card != card)
+		return -1;
+
+	if (m->state == MIXER_STATE_RUN)
+		m->state = MIXER_STATE_STOP;
+	while (OS_ThreadIsValid(&m->thread))
+		OS_MSleep(10);
+
+	for (i = 0; i < SND_MIXER_STREAM_MAX; i++) {
+		if (m->stream[i].used)
+			snd_mixer_stream_close(&m->stream[i]);
+	}
+
+	snd_pcm_flush(m->config, card);
+	snd_pcm_close(card, PCM_OUT);
+
+	OS_MutexDelete(&m->lock);
+	pcm_free(m->tmp);
+	m->tmp = NULL;
+	return 0;
+}
+
+int snd_mixer_set_duck_gain(uint16_t gain)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+
+	if (gain > SND_MIXER_VOLUME_MAX)
+		gain = SND_MIXER_VOLUME_MAX;
+	m->duck_gain = gain;
+	return 0;
+}
+
+int snd_mixer_get_stat(struct snd_mixer_stat *stat)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+
+	if (m->state != MIXER_STATE_RUN)
+		return -1;
+
+	mixer_lock(m);
+	memcpy(stat, &m->stat, sizeof(*stat));
+	mixer_unlock(m);
+	return 0;
+}
+
+snd_mixer_stream_t snd_mixer_stream_open(struct pcm_config *config, unsigned int priority)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	struct snd_mixer_stream *s = NULL;
+	unsigned int i;
+
+	if (m->state != MIXER_STATE_RUN)
+		return NULL;
+	if (config->format != PCM_FORMAT_S16_LE ||
+	    (config->channels != 1 && config->channels != 2) ||
+	    config->rate < MIXER_RATE_MIN || config->rate > MIXER_RATE_MAX ||
+	    priority >= SND_MIXER_PRIO_MAX) {
+		MIXER_ERR("invalid stream config\n");
+		return NULL;
+	}
+
+	mixer_lock(m);
+	for (i = 0; i < SND_MIXER_STREAM_MAX; i++) {
+		if (!m->stream[i].used) {
+			s = &m->stream[i];
+			break;
+		}
+	}
+	if (s == NULL) {
+		mixer_unlock(m);
+		MIXER_ERR("no free stream\n");
+		return NULL;
+	}
+
+	memset(s, 0, sizeof(*s));
+	s->frames = pcm_get_buffer_size(config);
+	if (s->frames < m->period_frames)
+		s->frames = m->period_frames;
+	s->buf = pcm_zalloc(s->frames * config->channels * sizeof(int16_t));
+	if (s->buf == NULL || OS_SemaphoreCreateBinary(&s->space) != OS_OK) {
+		pcm_free(s->buf);
+		mixer_unlock(m);
+		MIXER_ERR("no mem\n");
+		return NULL;
+	}
+	s->channels = config->channels;
+	s->step = (uint32_t)(((uint64_t)config->rate << MIXER_PHASE_BITS) / m->config->rate);
+	/* start from silence, the first card frame pulls in the first source frame */
+	s->phase = MIXER_PHASE_ONE;
+	s->volume = SND_MIXER_VOLUME_MAX;
+	s->gain = (int32_t)SND_MIXER_VOLUME_MAX << MIXER_GAIN_SHIFT;
+	s->priority = priority;
+	s->used = 1;
+	mixer_unlock(m);
+
+	MIXER_DBG("stream %d open, rate %u, ch %u, prio %u\n", i, config->rate,
+	          config->channels, priority);
+	return s;
+}
+
+int snd_mixer_stream_write(snd_mixer_stream_t stream, void *data, unsigned int count)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	struct snd_mixer_stream *s = stream;
+	const int16_t *src = data;
+	unsigned int frames = count / (s->channels * sizeof(int16_t));
+	unsigned int done = 0, n, part;
+
+	while (done < frames) {
+		mixer_lock(m);
+		if (!s->used || m->state != MIXER_STATE_RUN) {
+			mixer_unlock(m);
+			return -1;
+		}
+		n = s->frames - s->avail;
+		if (n == 0) {
+			s->waiting = 1;
+			mixer_unlock(m);
+			OS_SemaphoreWait(&s->space, OS_WAIT_FOREVER);
+			continue;
+		}
+		if (n > frames - done)
+			n = frames - done;
+
+		part = s->frames - s->wr;
+		if (part > n)
+			part = n;
+		memcpy(s->buf + s->wr * s->channels, src, part * s->channels * sizeof(int16_t));
+		if (n > part)
+			memcpy(s->buf, src + part * s->channels, (n - part) * s->channels * sizeof(int16_t));
+		s->wr += n;
+		if (s->wr >= s->frames)
+			s->wr -= s->frames;
+		s->avail += n;
+		mixer_unlock(m);
+
+		src += n * s->channels;
+		done += n;
+	}
+	return done * s->channels * sizeof(int16_t);
+}
+
+int snd_mixer_stream_drain(snd_mixer_stream_t stream)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	struct snd_mixer_stream *s = stream;
+
+	while (1) {
+		mixer_lock(m);
+		if (s->avail == 0 || m->state != MIXER_STATE_RUN) {
+			mixer_unlock(m);
+			break;
+		}
+		s->waiting = 1;
+		mixer_unlock(m);
+		OS_SemaphoreWait(&s->space, OS_WAIT_FOREVER);
+	}
+	return 0;
+}
+
+int snd_mixer_stream_close(snd_mixer_stream_t stream)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	struct snd_mixer_stream *s = stream;
+
+	mixer_lock(m);
+	if (!s->used) {
+		mixer_unlock(m);
+		return -1;
+	}
+	s->used = 0;
+	s->avail = 0;
+	pcm_free(s->buf);
+	s->buf = NULL;
+	OS_SemaphoreDelete(&s->space);
+	mixer_unlock(m);
+	return 0;
+}
+
+int snd_mixer_stream_set_volume(snd_mixer_stream_t stream, uint16_t volume)
+{
+	struct snd_mixer *m = &snd_mixer_priv;
+	struct snd_mixer_stream *s = stream;
+
+	if (volume > SND_MIXER_VOLUME_MAX)
+		volume = SND_MIXER_VOLUME_MAX;
+
+	mixer_lock(m);
+	s->volume = volume;
+	mixer_unlock(m);
+	return 0;
+}
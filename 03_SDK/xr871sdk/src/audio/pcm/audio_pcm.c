@@ -235,6 +235,64 @@ int snd_pcm_read(struct pcm_config *config, unsigned int card, void *data, unsig
 	return -1;
 }
 
+/*
+ * Zero-copy access to the card DMA buffer: @area returns the next period,
+ * free for playback or filled for capture, and @count its size in bytes.
+ * The period belongs to the caller until snd_pcm_mmap_commit(). @timeout is
+ * in ms, 0 to return at once if no period is ready (see
+ * snd_pcm_set_period_callback()). Do not mix with snd_pcm_write() on the
+ * same open playback stream.
+ */
+int snd_pcm_mmap_begin(struct pcm_config *config, unsigned int card, unsigned int flags,
+                       void **area, unsigned int *count, unsigned int timeout)
+{
+	PCM_ASSERT("Invalid card.\n", (card == SOUND_CARD_EXTERNAL_AUDIOCODEC));
+	int size;
+	uint8_t *buf = NULL;
+
+	if (flags == PCM_OUT) {
+		PCM_ASSERT("Data cached by snd_pcm_write.\n", (snd_pcm_priv.play_priv.length == 0));
+		size = HAL_I2S_Mmap_Begin(PLAYBACK, &buf, timeout);
+	} else {
+		size = HAL_I2S_Mmap_Begin(RECORD, &buf, timeout);
+	}
+	if (size <= 0)
+		return -1;
+
+	*area = buf;
+	*count = size;
+	return 0;
+}
+
+int snd_pcm_mmap_commit(struct pcm_config *config, unsigned int card, unsigned int flags,
+                        void *area)
+{
+	PCM_ASSERT("Invalid card.\n", (card == SOUND_CARD_EXTERNAL_AUDIOCODEC));
+
+	if (HAL_I2S_Mmap_Commit((flags == PCM_OUT) ? PLAYBACK : RECORD, area) != HAL_OK)
+		return -1;
+	return 0;
+}
+
+/* @cb is called in interrupt context each time the DMA completes a period */
+int snd_pcm_set_period_callback(unsigned int card, unsigned int flags,
+                                snd_pcm_period_cb cb, void *arg)
+{
+	PCM_ASSERT("Invalid card.\n", (card == SOUND_CARD_EXTERNAL_AUDIOCODEC));
+
+	if (HAL_I2S_SetPeriodCallback((flags == PCM_OUT) ? PLAYBACK : RECORD, cb, arg) != HAL_OK)
+		return -1;
+	return 0;
+}
+
+/* underruns for PCM_OUT, overruns for PCM_IN since the stream is opened */
+unsigned int snd_pcm_get_xrun(unsigned int card, unsigned int flags)
+{
+	if (card != SOUND_CARD_EXTERNAL_AUDIOCODEC)
+		return 0;
+	return HAL_I2S_GetXrunCount((flags == PCM_OUT) ? PLAYBACK : RECORD);
+}
+
 int snd_pcm_open(struct pcm_config *config, unsigned int card, unsigned int flags)
 {
 	if ((card == AUDIO_CARD1) && (flags == PCM_OUT)) {
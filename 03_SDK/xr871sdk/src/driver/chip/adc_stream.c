@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include "driver/chip/adc_stream.h"
+
+#define ADCS_SAMPLE_MASK    0xFFFU
+
+/* the ring is shared between the producer and the consumer */
+#define adcs_barrier()      __sync_synchronize()
+
+static void adcs_filter_reset(struct adcs_filter *f)
+{
+	memset(f->integ, 0, sizeof(f->integ));
+	memset(f->comb, 0, sizeof(f->comb));
+	f->phase = 0;
+	f->settle = f->order - 1;
+	f->cur.num = 0;
+}
+
+/**
+ * Set up the stream of nchan channels converted freq times a second in
+ * all, with a ring of ring_num blocks, a power of 2.
+ * Returns 0, or -1 on an invalid argument.
+ */
+int adcs_init(struct adcs *s, uint32_t freq, const struct adcs_chan_config *chan,
+              uint32_t nchan, struct adcs_block *ring, uint32_t ring_num)
+{
+	struct adcs_filter *f;
+	uint32_t i, j, k;
+
+	if (freq == 0 || nchan == 0 || nchan > ADCS_CHAN_MAX ||
+	    ring_num < 2 || (ring_num & (ring_num - 1)))
+		return -1;
+
+	memset(s, 0, sizeof(*s));
+	for (i = 0; i < nchan; i++) {
+		if (chan[i].chan >= ADCS_CHAN_MAX || chan[i].ratio == 0 ||
+		    chan[i].order == 0 || chan[i].order > ADCS_ORDER_MAX)
+			return -1;
+
+		/* in channel order, as the samples come */
+		for (j = i; j > 0 && s->f[j - 1].chan >= chan[i].chan; j--) {
+			if (s->f[j - 1].chan == chan[i].chan)
+				return -1;
+			s->f[j] = s->f[j - 1];
+		}
+		f = &s->f[j];
+		memset(f, 0, sizeof(*f));
+		f->chan = chan[i].chan;
+		f->order = chan[i].order;
+		f->ratio = chan[i].ratio;
+		f->div = 1;
+		for (k = 0; k < f->order; k++) {
+			if ((uint64_t)f->div * f->ratio > ADCS_GAIN_MAX)
+				return -1;
+			f->div *= f->ratio;
+		}
+	}
+
+	s->freq = freq;
+	s->nchan = nchan;
+	s->ring = ring;
+	s->mask = ring_num - 1;
+	return 0;
+}
+
+/**
+ * Start from the first channel, with the first conversion at t_us.
+ * The ring is emptied.
+ */
+void adcs_start(struct adcs *s, uint32_t t_us)
+{
+	uint32_t i;
+
+	for (i = 0; i < s->nchan; i++) {
+		adcs_filter_reset(&s->f[i]);
+		s->f[i].gap = 0;
+		s->f[i].seq = 0;
+	}
+	s->pos = 0;
+	s->t0_us = t_us;
+	s->conv = 0;
+	s->head = 0;
+	s->tail = 0;
+}
+
+static uint32_t adcs_publish(struct adcs *s, struct adcs_filter *f)
+{
+	struct adcs_block *b = &f->cur;
+	uint32_t depth = s->head - s->tail;
+
+	b->chan = f->chan;
+	b->seq = f->seq++;
+	b->flags = f->gap ? ADCS_BLOCK_GAP : 0;
+
+	if (depth > s->mask) {
+		s->stats.dropped++;
+		f->gap = 1;
+		b->num = 0;
+		return 0;
+	}
+
+	memcpy(&s->ring[s->head & s->mask], b,
+	       offsetof(struct adcs_block, data) + b->num * sizeof(b->data[0]));
+	adcs_barrier();
+	s->head++;
+	if (depth + 1 > s->stats.depth_max)
+		s->stats.depth_max = depth + 1;
+	s->stats.blocks++;
+	f->gap = 0;
+	b->num = 0;
+	return 1;
+}
+
+/**
+ * Take n samples from the FIFO, in their order.
+ * Returns the blocks published.
+ */
+uint32_t adcs_push(struct adcs *s, const uint16_t *data, uint32_t n)
+{
+	struct adcs_filter *f;
+	uint32_t i, k, x, y, t, ret = 0;
+
+	for (i = 0; i < n; i++, s->conv++) {
+		f = &s->f[s->pos];
+		if (++s->pos == s->nchan)
+			s->pos = 0;
+
+		x = data[i] & ADCS_SAMPLE_MASK;
+		f->integ[0] += x;
+		for (k = 1; k < f->order; k++)
+			f->integ[k] += f->integ[k - 1];
+		if (++f->phase < f->ratio)
+			continue;
+		f->phase = 0;
+
+		/* modulo 2^32, exact while ratio ^ order <= ADCS_GAIN_MAX */
+		y = f->integ[f->order - 1];
+		for (k = 0; k < f->order; k++) {
+			t = y;
+			y -= f->comb[k];
+			f->comb[k] = t;
+		}
+		if (f->settle) {
+			f->settle--;
+			continue;
+		}
+
+		if (f->cur.num == 0)
+			f->cur.t_us = s->t0_us + (uint32_t)(s->conv * 1000000 / s->freq);
+		f->cur.data[f->cur.num++] = (y + f->div / 2) / f->div;
+		if (f->cur.num == ADCS_BLOCK_SAMPLES)
+			ret += adcs_publish(s, f);
+	}
+	s->stats.conv += n;
+	return ret;
+}
+
+/**
+ * Publish the partly filled blocks.
+ * Returns the blocks published.
+ */
+uint32_t adcs_flush(struct adcs *s)
+{
+	uint32_t i, ret = 0;
+
+	for (i = 0; i < s->nchan; i++) {
+		if (s->f[i].cur.num)
+			ret += adcs_publish(s, &s->f[i]);
+	}
+	return ret;
+}
+
+/**
+ * Samples were lost, the conversions restart from the first channel at
+ * t_us. Returns the blocks published.
+ */
+uint32_t adcs_gap(struct adcs *s, uint32_t t_us)
+{
+	uint32_t i, ret;
+
+	ret = adcs_flush(s);
+	for (i = 0; i < s->nchan; i++) {
+		adcs_filter_reset(&s->f[i]);
+		s->f[i].gap = 1;
+	}
+	s->pos = 0;
+	s->t0_us = t_us;
+	s->conv = 0;
+	s->stats.gaps++;
+	return ret;
+}
+
+/**
+ * The oldest block, NULL if none. It stays in the ring until
+ * adcs_release().
+ */
+struct adcs_block *adcs_peek(struct adcs *s)
+{
+	if (s->head == s->tail)
+		return NULL;
+	adcs_barrier();
+	return &s->ring[s->tail & s->mask];
+}
+
+void adcs_release(struct adcs *s)
+{
+	adcs_barrier();
+	s->tail++;
+}
+
+void adcs_get_stats(struct adcs *s, struct adcs_stats *stats, int reset)
+{
+	*stats = s->stats;
+	if (reset)
+		memset(&s->stats, 0, sizeof(s->stats));
+}
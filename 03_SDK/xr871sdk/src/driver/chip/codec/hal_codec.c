@@ -606,9 +606,13 @@ static const struct soc_device_driver codec_drv = {
 	.resume = codec_resume,
 };
 
+static const char *const codec_deps[] = { "I2S", NULL };
+
 static struct soc_device codec_dev = {
 	.name = "CODEC",
 	.driver = &codec_drv,
+	.deps = codec_deps,
+	.async = 1,
 };
 
 #define CODEC_DEV (&codec_dev)
@@ -33,6 +33,7 @@
  */
 
 #include "driver/chip/hal_adc.h"
+#include "driver/chip/hal_rtc.h"
 #include "hal_base.h"
 #include "pm/pm.h"
 
@@ -54,11 +55,15 @@ typedef struct {
 
 	ADC_IRQCallback		IRQCallback[ADC_CHANNEL_NUM];
 	void			   *arg[ADC_CHANNEL_NUM];
+
+	struct adcs		   *stream;
+	HAL_Semaphore		streamSem;
 } ADC_Private;
 
 static ADC_Private gADCPrivate;
 
 #define ADC_FIFO_LEVEL				32
+#define ADC_FIFO_DEPTH				64
 
 #define ADC_ASSERT_CHANNEL(chan)	HAL_ASSERT_PARAM((chan) < ADC_CHANNEL_NUM)
 
@@ -409,6 +414,36 @@ __STATIC_INLINE uint32_t ADC_GetValue(ADC_Channel chan)
 	return HAL_GET_BIT(ADC->DATA[chan], ADC_DATA_MASK);
 }
 
+__STATIC_INLINE uint32_t ADC_StreamTime(void)
+{
+	return (uint32_t)HAL_RTC_GetFreeRunTime();
+}
+
+/* drain the FIFO into the stream */
+static void ADC_StreamIRQHandler(struct adcs *s, uint32_t overun)
+{
+	uint16_t buf[ADC_FIFO_DEPTH];
+	uint32_t i, n, ret = 0;
+
+	if (overun) {
+		/* the position in the channel cycle is lost, start it again */
+		ADC_DisableADC();
+		ADC_FlushFifo();
+		ret = adcs_gap(s, ADC_StreamTime());
+		ADC_EnableADC();
+	}
+
+	n = HAL_ADC_GetFifoDataCount();
+	if (n > ADC_FIFO_DEPTH)
+		n = ADC_FIFO_DEPTH;
+	for (i = 0; i < n; i++)
+		buf[i] = ADC_GetFifoData();
+	ret += adcs_push(s, buf, n);
+
+	if (ret)
+		HAL_SemaphoreRelease(&gADCPrivate.streamSem);
+}
+
 void GPADC_IRQHandler(void)
 {
 	if(gADCPrivate.mode == ADC_BURST_CONV) {
@@ -419,6 +454,11 @@ void GPADC_IRQHandler(void)
 		ADC_ClrFifoPending(fifoverunPending);
 		ADC_ClrFifoPending(fifodataPending);
 
+		if (gADCPrivate.stream) {
+			ADC_StreamIRQHandler(gADCPrivate.stream, fifoverunPending);
+			return;
+		}
+
 		if(fifodataPending) {
 			for (i = ADC_CHANNEL_0; i < ADC_CHANNEL_NUM; i++) {
 				if (ADC_GetChanPinMux(i) && (gADCPrivate.IRQCallback[i]))
@@ -1067,3 +1107,164 @@ uint8_t HAL_ADC_GetFifoDataCount(void)
 {
 	return (uint8_t)(HAL_GET_BIT_VAL(ADC->FIFO_STATUS, 8, 0x3F));
 }
+
+/**
+ * @brief Start sampling channels continuously, in FIFO mode
+ * @param[in] param Pointer to ADC_StreamParam structure
+ * @retval HAL_Status, HAL_OK on success, HAL_INVALID on invalid argument
+ * @note The ADC must not be initialized, the stream initializes it.
+ *       The FIFO is drained by its interrupt every ADC_FIFO_LEVEL samples.
+ *       Each channel is decimated and its samples are gathered in blocks of
+ *       ADC_STREAM_BLOCK_SAMPLES, read by a single thread with
+ *       HAL_ADC_StreamGet(). When the ring is full new blocks are dropped.
+ */
+HAL_Status HAL_ADC_StreamStart(const ADC_StreamParam *param)
+{
+	struct adcs_chan_config cfg[ADC_CHANNEL_NUM];
+	ADC_InitParam initParam;
+	unsigned long flags;
+	struct adcs *s;
+	HAL_Status ret;
+	uint32_t i;
+
+	if ((param->num == 0) || (param->num > ADC_CHANNEL_NUM)) {
+		HAL_ERR("invalid parameter, num: %d\n", param->num);
+		return HAL_INVALID;
+	}
+
+	s = HAL_Malloc(sizeof(*s) + param->blockNum * sizeof(ADC_StreamBlock));
+	if (s == NULL) {
+		HAL_ERR("no mem\n");
+		return HAL_ERROR;
+	}
+
+	for (i = 0; i < param->num; i++) {
+		cfg[i].chan = param->chan[i].chan;
+		cfg[i].order = param->chan[i].order;
+		cfg[i].ratio = param->chan[i].ratio;
+	}
+	if (adcs_init(s, param->freq, cfg, param->num, (ADC_StreamBlock *)(s + 1), param->blockNum) != 0) {
+		HAL_ERR("invalid stream parameter\n");
+		ret = HAL_INVALID;
+		goto failed;
+	}
+
+	initParam.freq = param->freq;
+	initParam.delay = param->delay;
+	initParam.mode = ADC_BURST_CONV;
+	ret = HAL_ADC_Init(&initParam);
+	if (ret != HAL_OK)
+		goto failed;
+
+	ret = HAL_SemaphoreInitBinary(&gADCPrivate.streamSem);
+	if (ret != HAL_OK)
+		goto failed_sem;
+
+	for (i = 0; i < param->num; i++) {
+		ret = HAL_ADC_FifoConfigChannel(param->chan[i].chan, ADC_SELECT_ENABLE);
+		if (ret != HAL_OK)
+			goto failed_chan;
+	}
+
+	flags = HAL_EnterCriticalSection();
+	ADC_EnableFifoOverunIRQ();
+	adcs_start(s, ADC_StreamTime());
+	gADCPrivate.stream = s;
+	HAL_ExitCriticalSection(flags);
+
+	ret = HAL_ADC_Start_Conv_IT();
+	if (ret != HAL_OK) {
+		gADCPrivate.stream = NULL;
+		goto failed_chan;
+	}
+	return HAL_OK;
+
+failed_chan:
+	HAL_SemaphoreDeinit(&gADCPrivate.streamSem);
+failed_sem:
+	HAL_ADC_DeInit();
+failed:
+	HAL_Free(s);
+	return ret;
+}
+
+/**
+ * @brief Stop the continuous sampling and deinitialize the ADC
+ * @retval HAL_Status, HAL_OK on success
+ * @note The blocks not read yet are lost, the reader must be done with them.
+ */
+HAL_Status HAL_ADC_StreamStop(void)
+{
+	unsigned long flags;
+	struct adcs *s;
+
+	s = gADCPrivate.stream;
+	if (s == NULL) {
+		HAL_WRN("ADC stream not started\n");
+		return HAL_ERROR;
+	}
+
+	HAL_ADC_Stop_Conv_IT();
+	flags = HAL_EnterCriticalSection();
+	gADCPrivate.stream = NULL;
+	HAL_ExitCriticalSection(flags);
+
+	HAL_ADC_DeInit();
+	HAL_SemaphoreDeinit(&gADCPrivate.streamSem);
+	HAL_Free(s);
+
+	return HAL_OK;
+}
+
+/**
+ * @brief Get the oldest block of the stream, waiting for one if none
+ * @param[in] msec Timeout value in millisecond
+ *                 HAL_WAIT_FOREVER for no timeout
+ * @return The block, or NULL on timeout. It stays valid until
+ *         HAL_ADC_StreamPut().
+ */
+ADC_StreamBlock *HAL_ADC_StreamGet(uint32_t msec)
+{
+	struct adcs *s = gADCPrivate.stream;
+	ADC_StreamBlock *b;
+
+	if (s == NULL)
+		return NULL;
+
+	while ((b = adcs_peek(s)) == NULL) {
+		if (HAL_SemaphoreWait(&gADCPrivate.streamSem, msec) != HAL_OK)
+			return adcs_peek(s);
+	}
+	return b;
+}
+
+/**
+ * @brief Give back the block returned by HAL_ADC_StreamGet()
+ * @retval None
+ */
+void HAL_ADC_StreamPut(void)
+{
+	if (gADCPrivate.stream)
+		adcs_release(gADCPrivate.stream);
+}
+
+/**
+ * @brief Get the counters of the stream
+ * @param[out] stats The counters since the start or the last reset
+ * @param[in] reset Clear the counters
+ * @retval HAL_Status, HAL_OK on success
+ */
+HAL_Status HAL_ADC_GetStreamStats(ADC_StreamStats *stats, int reset)
+{
+	unsigned long flags;
+	HAL_Status ret = HAL_ERROR;
+
+	flags = HAL_EnterCriticalSection();
+	if (gADCPrivate.stream) {
+		adcs_get_stats(gADCPrivate.stream, stats, reset);
+		ret = HAL_OK;
+	}
+	HAL_ExitCriticalSection(flags);
+
+	return ret;
+}
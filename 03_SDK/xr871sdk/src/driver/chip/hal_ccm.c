@@ -35,6 +35,12 @@
 #include "hal_base.h"
 #include "pm/pm.h"
 
+/*
+ * The bus clock and reset registers are shared by all the peripherals, whose
+ * drivers may be brought up concurrently (boot steps, parallel resume), so
+ * their bits are changed with the interrupts off.
+ */
+
 /**
  * @brief Configure AHB2 and APB clock
  * @param[in] AHB2Div AHB2 clock divider
@@ -101,7 +107,10 @@ uint32_t HAL_CCM_BusGetAPBClock(void)
  */
 void HAL_CCM_BusEnablePeriphClock(uint32_t periphMask)
 {
+	unsigned long flags = HAL_EnterCriticalSection();
+
 	HAL_SET_BIT(CCM->BUS_PERIPH_CLK_CTRL, periphMask);
+	HAL_ExitCriticalSection(flags);
 }
 
 /**
@@ -111,7 +120,10 @@ void HAL_CCM_BusEnablePeriphClock(uint32_t periphMask)
  */
 void HAL_CCM_BusDisablePeriphClock(uint32_t periphMask)
 {
+	unsigned long flags = HAL_EnterCriticalSection();
+
 	HAL_CLR_BIT(CCM->BUS_PERIPH_CLK_CTRL, periphMask);
+	HAL_ExitCriticalSection(flags);
 }
 
 /**
@@ -130,7 +142,10 @@ void HAL_CCM_BusDisableAllPeriphClock(void)
  */
 void HAL_CCM_BusForcePeriphReset(uint32_t periphMask)
 {
+	unsigned long flags = HAL_EnterCriticalSection();
+
 	HAL_CLR_BIT(CCM->BUS_PERIPH_RST_CTRL, periphMask);
+	HAL_ExitCriticalSection(flags);
 }
 
 /**
@@ -140,7 +155,10 @@ void HAL_CCM_BusForcePeriphReset(uint32_t periphMask)
  */
 void HAL_CCM_BusReleasePeriphReset(uint32_t periphMask)
 {
+	unsigned long flags = HAL_EnterCriticalSection();
+
 	HAL_SET_BIT(CCM->BUS_PERIPH_RST_CTRL, periphMask);
+	HAL_ExitCriticalSection(flags);
 }
 
 /**
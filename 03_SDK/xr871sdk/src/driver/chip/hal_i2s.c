@@ -36,6 +36,7 @@
 
 #include "driver/chip/hal_dma.h"
 #include "driver/chip/hal_i2s.h"
+#include "driver/chip/i2s_ring.h"
 #include "hal_base.h"
 #include "pm/pm.h"
 #include "driver/chip/hal_codec.h"
@@ -58,37 +59,27 @@
 
 typedef struct {
         volatile bool               isHwInit;
-        volatile bool               txRunning;
-        volatile bool               rxRunning;
-
-        uint8_t                     *txBuf;
-        uint8_t                     *rxBuf;
-        uint8_t                     *readPointer;
-        uint8_t                     *writePointer;
-		uint32_t					rxBufSize;
-		uint32_t					txBufSize;
+        struct i2s_ring             txRing;
+        struct i2s_ring             rxRing;
 
         DMA_Channel                 txDMAChan;
         DMA_Channel                 rxDMAChan;
         I2S_HWParam                 *hwParam;
         I2S_DataParam               pdataParam;
         I2S_DataParam               cdataParam;
-        volatile uint8_t           txHalfCallCount;
-        volatile uint8_t           rxHalfCallCount;
-        volatile uint8_t           txEndCallCount;
-        volatile uint8_t           rxEndCallCount;
-        uint8_t                     *txDmaPointer;
-        uint8_t                     *rxDmaPointer;
 
         HAL_Semaphore               txReady;
         HAL_Semaphore               rxReady;
-        bool                        isTxSemaphore;
-        bool                        isRxSemaphore;
         bool                        isTxInitiate;
         bool                        isRxInitiate;
 
         HAL_Mutex                   devSetLock;
 
+        I2S_PeriodCallback          txPeriodCb;
+        I2S_PeriodCallback          rxPeriodCb;
+        void                        *txPeriodArg;
+        void                        *rxPeriodArg;
+
         uint32_t                    audioPllParam;
         uint32_t                    audioPllPatParam;
 } I2S_Private;
@@ -121,9 +112,6 @@ typedef struct {
 #define I2S_FREE                     HAL_Free
 #define I2S_MEMSET                   HAL_Memset
 
-#define UNDERRUN_THRESHOLD           3
-#define OVERRUN_THRESHOLD            3
-
 #ifdef RESERVERD_MEMORY_FOR_I2S_TX
 static uint8_t I2STX_BUF[I2S_BUF_LENGTH];
 #endif
@@ -519,36 +507,41 @@ static HAL_Status I2S_SET_Channels(I2S_DataParam *param)
         return HAL_OK;
 }
 
+/**
+  * @internal
+  * @brief Account a period elapsed, wake the waiting writer/reader and stop
+  *        the DMA on an xrun.
+  * @param dir: the direction of stream.
+  * @param end: the DMA reached the end of the buffer, else its half.
+  * @retval None
+  */
 __nonxip_text
-static int I2S_DMA_BUFFER_CHECK_Threshold(uint8_t dir)
+static void I2S_DMAPeriodElapsed(I2S_StreamDir dir, int end)
 {
         I2S_Private *i2sPrivate = &gI2sPrivate;
-        if (dir == 0) {
-                if (i2sPrivate->txHalfCallCount >= UNDERRUN_THRESHOLD ||
-                        i2sPrivate->txEndCallCount >= UNDERRUN_THRESHOLD) {
+        uint32_t ev;
+
+        if (dir == PLAYBACK) {
+                ev = i2s_ring_elapsed(&i2sPrivate->txRing, end);
+                if (ev & I2S_RING_WAKE)
+                        HAL_SemaphoreRelease(&i2sPrivate->txReady);
+                if (i2sPrivate->txPeriodCb)
+                        i2sPrivate->txPeriodCb(i2sPrivate->txPeriodArg);
+                if (ev & I2S_RING_STOP) {
                         I2S_IT_ERROR("Tx : underrun and stop dma tx...\n");
                         HAL_I2S_Trigger(false,PLAYBACK);/*stop*/
-                        i2sPrivate->txRunning = false;
-                        i2sPrivate->writePointer = NULL;
-                        i2sPrivate->txHalfCallCount = 0;
-                        i2sPrivate->txEndCallCount = 0;
-                        i2sPrivate->txDmaPointer = NULL;
-                        return -1;
                 }
         } else {
-                if (i2sPrivate->rxHalfCallCount >= OVERRUN_THRESHOLD ||
-                        i2sPrivate->rxEndCallCount >= OVERRUN_THRESHOLD) {
+                ev = i2s_ring_elapsed(&i2sPrivate->rxRing, end);
+                if (ev & I2S_RING_WAKE)
+                        HAL_SemaphoreRelease(&i2sPrivate->rxReady);
+                if (i2sPrivate->rxPeriodCb)
+                        i2sPrivate->rxPeriodCb(i2sPrivate->rxPeriodArg);
+                if (ev & I2S_RING_STOP) {
                         I2S_IT_ERROR("Rx : overrun and stop dma rx...\n");
                         HAL_I2S_Trigger(false,RECORD);/*stop*/
-                        i2sPrivate->rxRunning = false;
-                        i2sPrivate->rxHalfCallCount = 0;
-                        i2sPrivate->rxEndCallCount = 0;
-                        i2sPrivate->readPointer = NULL;
-                        i2sPrivate->rxDmaPointer = NULL;
-                        return -1;
                 }
         }
-        return 0;
 }
 
 /**
@@ -561,26 +554,7 @@ static int I2S_DMA_BUFFER_CHECK_Threshold(uint8_t dir)
 __nonxip_text
 static void I2S_DMAHalfCallback(void *arg)
 {
-        I2S_Private *i2sPrivate = &gI2sPrivate;
-        if (arg == &(i2sPrivate->txReady)) {
-                i2sPrivate->txHalfCallCount ++;
-				if (i2sPrivate->isTxSemaphore) {
-                        i2sPrivate->isTxSemaphore = false;
-                        HAL_SemaphoreRelease((HAL_Semaphore *)arg);
-                }
-                if (I2S_DMA_BUFFER_CHECK_Threshold(0) != 0)
-                        return;
-                i2sPrivate->txDmaPointer = i2sPrivate->txBuf + i2sPrivate->txBufSize/2;
-        } else {
-                i2sPrivate->rxHalfCallCount ++;
-				if (i2sPrivate->isRxSemaphore) {
-				        i2sPrivate->isRxSemaphore = false;
-				        HAL_SemaphoreRelease((HAL_Semaphore *)arg);
-				}
-                if (I2S_DMA_BUFFER_CHECK_Threshold(1) != 0)
-                        return;
-				i2sPrivate->rxDmaPointer = i2sPrivate->rxBuf + i2sPrivate->rxBufSize/2;
-        }
+        I2S_DMAPeriodElapsed(arg == &gI2sPrivate.txReady ? PLAYBACK : RECORD, 0);
 }
 
 /**
@@ -593,26 +567,7 @@ static void I2S_DMAHalfCallback(void *arg)
 __nonxip_text
 static void I2S_DMAEndCallback(void *arg)
 {
-        I2S_Private *i2sPrivate = &gI2sPrivate;
-        if (arg == &(i2sPrivate->txReady)) {
-                i2sPrivate->txEndCallCount ++;
-				if (i2sPrivate->isTxSemaphore) {
-                        i2sPrivate->isTxSemaphore = false;
-                        HAL_SemaphoreRelease((HAL_Semaphore *)arg);
-                }
-                if (I2S_DMA_BUFFER_CHECK_Threshold(0) != 0)
-                        return;
-                i2sPrivate->txDmaPointer = i2sPrivate->txBuf;
-        } else {
-                i2sPrivate->rxEndCallCount ++;
-				if (i2sPrivate->isRxSemaphore) {
-					i2sPrivate->isRxSemaphore = false;
-					HAL_SemaphoreRelease((HAL_Semaphore *)arg);
-				}
-                if (I2S_DMA_BUFFER_CHECK_Threshold(1) != 0)
-                        return;
-                i2sPrivate->rxDmaPointer = i2sPrivate->rxBuf;
-        }
+        I2S_DMAPeriodElapsed(arg == &gI2sPrivate.txReady ? PLAYBACK : RECORD, 1);
 }
 
 /**
@@ -763,28 +718,28 @@ void HAL_I2S_Trigger(bool enable,I2S_StreamDir dir)
 
                         /* start dma*/
                         if (i2sPrivate->txDMAChan != DMA_CHANNEL_INVALID) {
-                                I2S_DMAStart(i2sPrivate->txDMAChan, (uint32_t)i2sPrivate->txBuf,
-                                                (uint32_t)&(I2S->DA_TXFIFO), i2sPrivate->txBufSize);
+                                I2S_DMAStart(i2sPrivate->txDMAChan, (uint32_t)i2sPrivate->txRing.buf,
+                                                (uint32_t)&(I2S->DA_TXFIFO), i2sPrivate->txRing.size);
                         }
-                        i2sPrivate->txRunning = true;
+                        i2sPrivate->txRing.running = true;
                 } else {
                         rx_enable(enable);
                         if (i2sPrivate->rxDMAChan != DMA_CHANNEL_INVALID)
                                 I2S_DMAStart(i2sPrivate->rxDMAChan, (uint32_t)&(I2S->DA_RXFIFO),
-                                                (uint32_t)i2sPrivate->rxBuf, i2sPrivate->rxBufSize);
-                        i2sPrivate->rxRunning = true;
+                                                (uint32_t)i2sPrivate->rxRing.buf, i2sPrivate->rxRing.size);
+                        i2sPrivate->rxRing.running = true;
                 }
         } else {
                 if (dir == PLAYBACK) {
                         tx_enable(enable);
                         if (i2sPrivate->txDMAChan != DMA_CHANNEL_INVALID)
                                 I2S_DMAStop(i2sPrivate->txDMAChan);
-                        i2sPrivate->txRunning = false;
+                        i2sPrivate->txRing.running = false;
                 } else {
                         rx_enable(enable);
                         if (i2sPrivate->rxDMAChan != DMA_CHANNEL_INVALID)
                                 I2S_DMAStop(i2sPrivate->rxDMAChan);
-                        i2sPrivate->rxRunning = false;
+                        i2sPrivate->rxRing.running = false;
                 }
         }
         #if 0
@@ -800,6 +755,90 @@ void HAL_I2S_Trigger(bool enable,I2S_StreamDir dir)
         }
 }
 
+/**
+  * @internal
+  * @brief Get the next period of the DMA buffer, free for writing (playback)
+  *        or filled by DMA (record). Start the record DMA if needed.
+  * @param dir: the direction of stream.
+  * @param buf: return the start address of the period in the DMA buffer.
+  * @param msec: time to wait for the period.
+  * @retval 0 on success, -1 on timeout
+  */
+static int I2S_PeriodAcquire(I2S_StreamDir dir, uint8_t **buf, uint32_t msec)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+	struct i2s_ring *ring;
+	HAL_Semaphore *ready;
+	int ret;
+
+	if (dir == PLAYBACK) {
+		ring = &i2sPrivate->txRing;
+		ready = &i2sPrivate->txReady;
+	} else {
+		ring = &i2sPrivate->rxRing;
+		ready = &i2sPrivate->rxReady;
+	}
+
+	HAL_DisableIRQ();
+	while (1) {
+		ret = i2s_ring_acquire(ring, buf);
+		if (ret == I2S_RING_START) {
+			HAL_EnableIRQ();
+			I2S_DEBUG("Rx: record start...\n");
+			HAL_I2S_Trigger(true, RECORD);
+			HAL_DisableIRQ();
+			continue;
+		}
+		if (ret != I2S_RING_WAIT)
+			break;
+
+		HAL_EnableIRQ();
+		if (HAL_SemaphoreWait(ready, msec) != HAL_OK) {
+			HAL_DisableIRQ();
+			ring->waiting = 0;
+			HAL_EnableIRQ();
+			return -1;
+		}
+		HAL_DisableIRQ();
+	}
+	HAL_EnableIRQ();
+
+	/* out of the loop, not to print with irq disabled */
+	if (ret == I2S_RING_XRUN) {
+		if (dir == PLAYBACK)
+			I2S_ERROR("Tx : underrun....\n");
+		else
+			I2S_ERROR("Rx : overrun....\n");
+	}
+	return 0;
+}
+
+/**
+  * @internal
+  * @brief Hand a period back to the DMA, filled (playback) or consumed
+  *        (record). Start the playback DMA on the first round.
+  * @param dir: the direction of stream.
+  * @param buf: period returned by I2S_PeriodAcquire().
+  * @retval None
+  */
+static void I2S_PeriodCommit(I2S_StreamDir dir, uint8_t *buf)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+	int start;
+
+	HAL_DisableIRQ();
+	if (dir == PLAYBACK)
+		start = i2s_ring_commit(&i2sPrivate->txRing, buf);
+	else
+		start = i2s_ring_commit(&i2sPrivate->rxRing, buf);
+	HAL_EnableIRQ();
+
+	if (start) {
+		I2S_DEBUG("Tx: play start...\n");
+		HAL_I2S_Trigger(true,PLAYBACK);/*play*/
+	}
+}
+
 /**
   * @brief Transmit an amount of data with DMA module
   * @param buf: pointer to the Transmit data buffer.
@@ -817,9 +856,8 @@ int32_t HAL_I2S_Write_DMA(uint8_t *buf, uint32_t size)
     I2S_Private *i2sPrivate = &gI2sPrivate;
 
     uint8_t *pdata = buf;
-    uint8_t *lastWritePointer = NULL;
-    uint32_t toWrite = 0, writeSize = i2sPrivate->txBufSize / 2;
-    uint8_t err_flag; /* temp solution to avoid outputing debug message when irq disabled */
+    uint8_t *period = NULL;
+    uint32_t toWrite = 0, writeSize = i2s_ring_period(&i2sPrivate->txRing);
 
 	if (writeSize == 0) {
 		I2S_ERROR("TxBuf not exist\n");
@@ -832,69 +870,10 @@ int32_t HAL_I2S_Write_DMA(uint8_t *buf, uint32_t size)
 
 	for ( ; size >= writeSize; pdata += writeSize, toWrite += writeSize, size -= writeSize)
 	{
-		if (i2sPrivate->txRunning == false) {
-			if (!i2sPrivate->writePointer)
-				i2sPrivate->writePointer = i2sPrivate->txBuf;
-			lastWritePointer = i2sPrivate->writePointer;
-
-			I2S_MEMCPY(lastWritePointer, pdata, writeSize);
-			lastWritePointer += writeSize;
-			if (lastWritePointer >= i2sPrivate->txBuf + i2sPrivate->txBufSize)
-				lastWritePointer = i2sPrivate->txBuf;
-			i2sPrivate->writePointer = lastWritePointer;
-			if (i2sPrivate->writePointer == i2sPrivate->txBuf) {
-				I2S_DEBUG("Tx: play start...\n");
-				HAL_I2S_Trigger(true,PLAYBACK);/*play*/
-				i2sPrivate->txRunning = true;
-			}
-		} else {
-			err_flag = 0;
-			HAL_DisableIRQ();
-			lastWritePointer = i2sPrivate->writePointer;
-			if (i2sPrivate->txHalfCallCount && i2sPrivate->txEndCallCount) {
-				err_flag = 1;
-				i2sPrivate->txHalfCallCount = 0;
-				i2sPrivate->txEndCallCount = 0;
-			} else if (i2sPrivate->txHalfCallCount) {
-				i2sPrivate->txHalfCallCount --;
-			} else if (i2sPrivate->txEndCallCount) {
-				i2sPrivate->txEndCallCount --;
-			} else {
-				i2sPrivate->isTxSemaphore = true;
-				HAL_EnableIRQ();
-				HAL_SemaphoreWait(&(i2sPrivate->txReady), HAL_WAIT_FOREVER);
-				HAL_DisableIRQ();
-				if (i2sPrivate->txHalfCallCount && i2sPrivate->txEndCallCount) {
-					err_flag = 1;
-					i2sPrivate->txHalfCallCount = 0;
-					i2sPrivate->txEndCallCount = 0;
-				} else {
-					if (i2sPrivate->txHalfCallCount)
-						i2sPrivate->txHalfCallCount --;
-					if (i2sPrivate->txEndCallCount)
-						i2sPrivate->txEndCallCount --;
-				}
-			}
-
-			if (err_flag) {
-				if (i2sPrivate->txDmaPointer == i2sPrivate->txBuf)
-					lastWritePointer = i2sPrivate->txBuf + writeSize;
-				else
-					lastWritePointer = i2sPrivate->txBuf;
-			}
-			I2S_MEMCPY(lastWritePointer, pdata, writeSize);
-			lastWritePointer += writeSize;
-            if (lastWritePointer >= i2sPrivate->txBuf + i2sPrivate->txBufSize)
-				lastWritePointer = i2sPrivate->txBuf;
-            i2sPrivate->writePointer = lastWritePointer;
-			HAL_EnableIRQ();
-
-			if (err_flag) {
-				I2S_ERROR("TxCount:(H:%u,F:%u)\n",i2sPrivate->txHalfCallCount,
-                                                  i2sPrivate->txEndCallCount);
-				I2S_ERROR("Tx : underrun....\n");
-			}
-		}
+		if (I2S_PeriodAcquire(PLAYBACK, &period, HAL_WAIT_FOREVER) != 0)
+			break;
+		I2S_MEMCPY(period, pdata, writeSize);
+		I2S_PeriodCommit(PLAYBACK, period);
 	}
 
     return toWrite;
@@ -915,10 +894,9 @@ int32_t HAL_I2S_Read_DMA(uint8_t *buf, uint32_t size)
     if (!buf || size <= 0)
             return HAL_INVALID;
     uint8_t *pdata = buf;
-    uint8_t *lastReadPointer = NULL;
-    uint32_t readSize = i2sPrivate->rxBufSize / 2;
+    uint8_t *period = NULL;
+    uint32_t readSize = i2s_ring_period(&i2sPrivate->rxRing);
     uint32_t toRead = 0;
-    uint8_t err_flag; /* temp solution to avoid outputing debug message when irq disabled */
 
 	if (readSize == 0) {
 		I2S_ERROR("RxBuf not exist\n");
@@ -930,70 +908,101 @@ int32_t HAL_I2S_Read_DMA(uint8_t *buf, uint32_t size)
     }
 
 	while (size >= readSize) {
-		if (i2sPrivate->rxRunning == false) {
-			if (!i2sPrivate->readPointer)
-				i2sPrivate->readPointer = i2sPrivate->rxBuf;
-		    I2S_DEBUG("Rx: record start...\n");
-		    HAL_I2S_Trigger(true, RECORD);
-		} else {
-			err_flag = 0;
-			/*disable irq*/
-			HAL_DisableIRQ();
-			lastReadPointer = i2sPrivate->readPointer;
-			if (i2sPrivate->rxHalfCallCount && i2sPrivate->rxEndCallCount) {
-				err_flag = 1;
-				i2sPrivate->rxHalfCallCount = 0;
-				i2sPrivate->rxEndCallCount = 0;
-			} else if (i2sPrivate->rxHalfCallCount) {
-				i2sPrivate->rxHalfCallCount --;
-			} else if (i2sPrivate->rxEndCallCount) {
-				i2sPrivate->rxEndCallCount --;
-			} else {
-				/**enable irq**/
-				i2sPrivate->isRxSemaphore = true;
-				HAL_EnableIRQ();
-				HAL_SemaphoreWait(&(i2sPrivate->rxReady), HAL_WAIT_FOREVER);
-				/**disable irq**/
-				HAL_DisableIRQ();
-				if (i2sPrivate->rxHalfCallCount && i2sPrivate->rxEndCallCount) {
-					err_flag = 1;
-					i2sPrivate->rxHalfCallCount = 0;
-					i2sPrivate->rxEndCallCount = 0;
-				} else {
-					if (i2sPrivate->rxHalfCallCount)
-						i2sPrivate->rxHalfCallCount --;
-					if (i2sPrivate->rxEndCallCount)
-						i2sPrivate->rxEndCallCount --;
-				}
-			}
-
-			if (err_flag) {
-				if (i2sPrivate->rxDmaPointer == i2sPrivate->rxBuf)
-					lastReadPointer = i2sPrivate->rxBuf + readSize;
-				else
-					lastReadPointer = i2sPrivate->rxBuf;
-			}
-			I2S_MEMCPY(pdata, lastReadPointer, readSize);
-			pdata += readSize;
-			lastReadPointer += readSize;
-			if (lastReadPointer >= i2sPrivate->rxBuf + i2sPrivate->rxBufSize)
-				lastReadPointer = i2sPrivate->rxBuf;
-			i2sPrivate->readPointer = lastReadPointer;
-			/**enable irq**/
-			HAL_EnableIRQ();
-			size -= readSize;
-			toRead += readSize;
-
-			if (err_flag) {
-				I2S_ERROR("Rx overrun, (H:%u,F:%u)\n",
-				          i2sPrivate->rxHalfCallCount,
-				          i2sPrivate->rxEndCallCount);
-			}
-		}
+		if (I2S_PeriodAcquire(RECORD, &period, HAL_WAIT_FOREVER) != 0)
+			break;
+		I2S_MEMCPY(pdata, period, readSize);
+		I2S_PeriodCommit(RECORD, period);
+		pdata += readSize;
+		size -= readSize;
+		toRead += readSize;
 	}
     return toRead;
 }
 
+/**
+  * @brief Get direct access to the next period of the DMA buffer
+  * @note For playback the period is free to be filled, for record it holds
+  *       captured data. Every successful call must be followed by
+  *       HAL_I2S_Mmap_Commit() with the same buffer before the next one.
+  * @param dir: the direction of stream.
+  * @param buf: return the start address of the period.
+  * @param msec: time to wait for the period, 0 to poll.
+  * @retval size of the period in bytes, or -1 on timeout/error
+  */
+int32_t HAL_I2S_Mmap_Begin(I2S_StreamDir dir, uint8_t **buf, uint32_t msec)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+	struct i2s_ring *ring;
+
+	if (!buf)
+		return HAL_INVALID;
+
+	ring = (dir == PLAYBACK) ? &i2sPrivate->txRing : &i2sPrivate->rxRing;
+	if (ring->size == 0 || ring->mmap)
+		return -1;
+	if (I2S_PeriodAcquire(dir, buf, msec) != 0)
+		return -1;
+	ring->mmap = *buf;
+	return i2s_ring_period(ring);
+}
+
+/**
+  * @brief Release the period obtained by HAL_I2S_Mmap_Begin()
+  * @param dir: the direction of stream.
+  * @param buf: the period returned by HAL_I2S_Mmap_Begin().
+  * @retval HAL status
+  */
+HAL_Status HAL_I2S_Mmap_Commit(I2S_StreamDir dir, uint8_t *buf)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+	struct i2s_ring *ring;
+
+	ring = (dir == PLAYBACK) ? &i2sPrivate->txRing : &i2sPrivate->rxRing;
+	if (!buf || buf != ring->mmap)
+		return HAL_INVALID;
+	ring->mmap = NULL;
+	I2S_PeriodCommit(dir, buf);
+	return HAL_OK;
+}
+
+/**
+  * @brief Register a callback called on each period elapsed
+  * @note The callback is called in interrupt context.
+  * @param dir: the direction of stream.
+  * @param cb: the callback, NULL to unregister.
+  * @param arg: argument passed to the callback.
+  * @retval HAL status
+  */
+HAL_Status HAL_I2S_SetPeriodCallback(I2S_StreamDir dir, I2S_PeriodCallback cb, void *arg)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+	unsigned long flags;
+
+	flags = HAL_EnterCriticalSection();
+	if (dir == PLAYBACK) {
+		i2sPrivate->txPeriodCb = cb;
+		i2sPrivate->txPeriodArg = arg;
+	} else {
+		i2sPrivate->rxPeriodCb = cb;
+		i2sPrivate->rxPeriodArg = arg;
+	}
+	HAL_ExitCriticalSection(flags);
+	return HAL_OK;
+}
+
+/**
+  * @brief Get the number of underruns (playback) or overruns (record)
+  *        since the stream is opened
+  * @param dir: the direction of stream.
+  * @retval the xrun count
+  */
+uint32_t HAL_I2S_GetXrunCount(I2S_StreamDir dir)
+{
+	I2S_Private *i2sPrivate = &gI2sPrivate;
+
+	return (dir == PLAYBACK) ? i2sPrivate->txRing.xrun : i2sPrivate->rxRing.xrun;
+}
+
 /**
   * @brief Open the I2S module according to the specified parameters
   *         in the I2S_DataParam.
@@ -1027,15 +1036,13 @@ HAL_Status HAL_I2S_Open(I2S_DataParam *param)
 
         if (param->direction == PLAYBACK) {
                 i2sPrivate->txDMAChan = DMA_CHANNEL_INVALID;
-                i2sPrivate->txBufSize = dataParam->bufSize;
-                i2sPrivate->txHalfCallCount = 0;
-                i2sPrivate->txEndCallCount = 0;
+                i2s_ring_init(&i2sPrivate->txRing, NULL, dataParam->bufSize, 1);
 #ifdef RESERVERD_MEMORY_FOR_I2S_TX
-                i2sPrivate->txBuf = I2STX_BUF;
+                i2sPrivate->txRing.buf = I2STX_BUF;
 #else
-                i2sPrivate->txBuf = I2S_MALLOC(i2sPrivate->txBufSize);
-                if(i2sPrivate->txBuf)
-                        I2S_MEMSET(i2sPrivate->txBuf, 0, i2sPrivate->txBufSize);
+                i2sPrivate->txRing.buf = I2S_MALLOC(i2sPrivate->txRing.size);
+                if(i2sPrivate->txRing.buf)
+                        I2S_MEMSET(i2sPrivate->txRing.buf, 0, i2sPrivate->txRing.size);
                 else {
                         I2S_ERROR("Malloc tx buf(for DMA),faild...\n");
                         return HAL_ERROR;
@@ -1046,7 +1053,7 @@ HAL_Status HAL_I2S_Open(I2S_DataParam *param)
                 if (i2sPrivate->txDMAChan == DMA_CHANNEL_INVALID) {
                         I2S_ERROR("Obtain I2S tx DMA channel,faild...\n");
 #ifndef RESERVERD_MEMORY_FOR_I2S_TX
-                        I2S_FREE(i2sPrivate->txBuf);
+                        I2S_FREE(i2sPrivate->txRing.buf);
 #endif
                         return HAL_ERROR;
                 } else
@@ -1054,15 +1061,13 @@ HAL_Status HAL_I2S_Open(I2S_DataParam *param)
                 HAL_SemaphoreInitBinary(&i2sPrivate->txReady);
         } else {
                 i2sPrivate->rxDMAChan = DMA_CHANNEL_INVALID;
-                i2sPrivate->rxBufSize = dataParam->bufSize;
-                i2sPrivate->rxHalfCallCount = 0;
-                i2sPrivate->rxEndCallCount = 0;
+                i2s_ring_init(&i2sPrivate->rxRing, NULL, dataParam->bufSize, 0);
 #ifdef RESERVERD_MEMORY_FOR_I2S_RX
-                i2sPrivate->rxBuf = I2SRX_BUF;
+                i2sPrivate->rxRing.buf = I2SRX_BUF;
 #else
-                i2sPrivate->rxBuf = I2S_MALLOC(i2sPrivate->rxBufSize);
-                if(i2sPrivate->rxBuf)
-                        I2S_MEMSET(i2sPrivate->rxBuf, 0, i2sPrivate->rxBufSize);
+                i2sPrivate->rxRing.buf = I2S_MALLOC(i2sPrivate->rxRing.size);
+                if(i2sPrivate->rxRing.buf)
+                        I2S_MEMSET(i2sPrivate->rxRing.buf, 0, i2sPrivate->rxRing.size);
                 else {
                         I2S_ERROR("Malloc rx buf(for DMA),faild...\n");
                         return HAL_ERROR;
@@ -1072,7 +1077,7 @@ HAL_Status HAL_I2S_Open(I2S_DataParam *param)
                 if (i2sPrivate->rxDMAChan == DMA_CHANNEL_INVALID) {
                         I2S_ERROR("Obtain I2S rx DMA channel,faild...\n");
 #ifndef RESERVERD_MEMORY_FOR_I2S_TX
-                        I2S_FREE(i2sPrivate->rxBuf);
+                        I2S_FREE(i2sPrivate->rxRing.buf);
 #endif
                         return HAL_ERROR;
                 } else
@@ -1112,7 +1117,6 @@ HAL_Status HAL_I2S_Close(uint32_t dir)
         if (dir == PLAYBACK) {
                 HAL_I2S_Trigger(false,PLAYBACK);
                 I2S_DisableTx();
-                i2sPrivate->txRunning = false;
                 i2sPrivate->isTxInitiate = false;
                 if (i2sPrivate->txDMAChan != DMA_CHANNEL_INVALID) {
                         HAL_DMA_DeInit(i2sPrivate->txDMAChan);
@@ -1122,19 +1126,16 @@ HAL_Status HAL_I2S_Close(uint32_t dir)
                 }
                 I2S_MEMSET(&(i2sPrivate->pdataParam), 0, sizeof(I2S_DataParam));
 #ifndef RESERVERD_MEMORY_FOR_I2S_TX
-                I2S_FREE(i2sPrivate->txBuf);
+                I2S_FREE(i2sPrivate->txRing.buf);
 #endif
                 HAL_SemaphoreDeinit(&i2sPrivate->txReady);
-                i2sPrivate->txBuf = NULL;
-                i2sPrivate->txBufSize = 0;
-                i2sPrivate->writePointer = NULL;
-                i2sPrivate->txHalfCallCount = 0;
-                i2sPrivate->txEndCallCount = 0;
+                i2s_ring_init(&i2sPrivate->txRing, NULL, 0, 1);
+                i2sPrivate->txPeriodCb = NULL;
+                i2sPrivate->txPeriodArg = NULL;
         } else {
                 HAL_I2S_Trigger(false,RECORD);
                 I2S_DisableRx();
                 i2sPrivate->isRxInitiate = false;
-                i2sPrivate->rxRunning = false;
                 if (i2sPrivate->rxDMAChan != DMA_CHANNEL_INVALID) {
                         HAL_DMA_DeInit(i2sPrivate->rxDMAChan);
                         HAL_DMA_Release(i2sPrivate->rxDMAChan);
@@ -1143,15 +1144,12 @@ HAL_Status HAL_I2S_Close(uint32_t dir)
                 }
                 I2S_MEMSET(&(i2sPrivate->cdataParam), 0, sizeof(I2S_DataParam));
 #ifndef RESERVERD_MEMORY_FOR_I2S_TX
-                I2S_FREE(i2sPrivate->rxBuf);
+                I2S_FREE(i2sPrivate->rxRing.buf);
 #endif
                 HAL_SemaphoreDeinit(&i2sPrivate->rxReady);
-                i2sPrivate->rxBuf = NULL;
-                i2sPrivate->rxBufSize = 0;
-                i2sPrivate->readPointer = NULL;
-
-                i2sPrivate->rxHalfCallCount = 0;
-                i2sPrivate->rxEndCallCount = 0;
+                i2s_ring_init(&i2sPrivate->rxRing, NULL, 0, 0);
+                i2sPrivate->rxPeriodCb = NULL;
+                i2sPrivate->rxPeriodArg = NULL;
         }
         return HAL_OK;
 }
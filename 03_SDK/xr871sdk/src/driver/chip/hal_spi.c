@@ -35,6 +35,7 @@
 #include <stdbool.h>
 #include "hal_base.h"
 #include "driver/chip/hal_spi.h"
+#include "driver/chip/hal_rtc.h"
 #include "pm/pm.h"
 #include "sys/xr_debug.h"
 
@@ -531,6 +532,13 @@ typedef struct {
 	SPI_IO_Mode			ioMode;
 	bool				cs_idle;
 	SPI_CS				cs_using;
+	bool				queued;		/* opened by HAL_SPI_QueueStart */
+	struct spiq			queue;
+	const SPI_QueueDevice *q_dev;	/* the controller is set for */
+	uint8_t				q_csMask;	/* cs pins muxed */
+	uint8_t				q_pending;	/* events left to complete the burst */
+	bool				q_txDMA;
+	bool				q_rxDMA;
 } SPI_Handler;
 
 
@@ -697,6 +705,80 @@ static void HAL_SPI_RxDMAIntFunc(void *arg)
 	HAL_SemaphoreRelease(&hdl->block);
 }
 
+/*
+ * @brief Request and set the DMA channels moving the data of a port.
+ * @note txEnd may be NULL to have no interrupt on the transmit channel.
+ */
+static HAL_Status HAL_SPI_InitDMA(SPI_Port port, DMA_IRQCallback txEnd, DMA_IRQCallback rxEnd)
+{
+	SPI_Handler *hdl = HAL_SPI_GetInstance(port);
+	SPI_T *spi = hdl->spi;
+	DMA_ChannelInitParam tx_param;
+	DMA_ChannelInitParam rx_param;
+	HAL_Memset(&tx_param, 0, sizeof(tx_param));
+	HAL_Memset(&rx_param, 0, sizeof(rx_param));
+
+	if ((hdl->tx_dmaChannel = HAL_DMA_Request()) == DMA_CHANNEL_INVALID) {
+		SPI_ALERT("DMA request failed \n");
+		return HAL_BUSY;
+	}
+	if ((hdl->rx_dmaChannel = HAL_DMA_Request()) == DMA_CHANNEL_INVALID) {
+		SPI_ALERT("DMA request failed \n");
+		HAL_DMA_Release(hdl->tx_dmaChannel);
+		return HAL_BUSY;
+	}
+
+	tx_param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
+										   DMA_WAIT_CYCLE_2,
+										   DMA_BYTE_CNT_MODE_REMAIN,
+										   DMA_DATA_WIDTH_32BIT,
+										   DMA_BURST_LEN_1,
+										   DMA_ADDR_MODE_FIXED,
+										   (DMA_Periph)(DMA_PERIPH_SPI0 + port),
+										   DMA_DATA_WIDTH_8BIT,
+										   DMA_BURST_LEN_4,
+										   DMA_ADDR_MODE_INC,
+										   DMA_PERIPH_SRAM);
+	tx_param.irqType = txEnd ? DMA_IRQ_TYPE_END : DMA_IRQ_TYPE_NONE;
+	tx_param.endCallback = txEnd;
+	tx_param.endArg = hdl;
+	SPI_SetTxFifoThreshold(spi, 4);
+
+	rx_param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
+										   DMA_WAIT_CYCLE_2,
+										   DMA_BYTE_CNT_MODE_REMAIN,
+										   DMA_DATA_WIDTH_8BIT,
+										   DMA_BURST_LEN_4,
+										   DMA_ADDR_MODE_INC,
+										   DMA_PERIPH_SRAM,
+										   DMA_DATA_WIDTH_32BIT,
+										   DMA_BURST_LEN_1,
+										   DMA_ADDR_MODE_FIXED,
+										   (DMA_Periph)(DMA_PERIPH_SPI0 + port));
+	rx_param.irqType = DMA_IRQ_TYPE_END;
+	rx_param.endCallback = rxEnd;
+	rx_param.endArg = hdl;
+	SPI_SetRxFifoThreshold(spi, 4);
+
+	HAL_DMA_Init(hdl->rx_dmaChannel, &rx_param);
+	HAL_DMA_Init(hdl->tx_dmaChannel, &tx_param);
+
+	return HAL_OK;
+}
+
+/*
+ * @brief
+ */
+static void HAL_SPI_DeinitDMA(SPI_Handler *hdl)
+{
+	HAL_DMA_Stop(hdl->tx_dmaChannel);
+	HAL_DMA_Stop(hdl->rx_dmaChannel);
+	HAL_DMA_DeInit(hdl->tx_dmaChannel);
+	HAL_DMA_DeInit(hdl->rx_dmaChannel);
+	HAL_DMA_Release(hdl->tx_dmaChannel);
+	HAL_DMA_Release(hdl->rx_dmaChannel);
+}
+
 /************************ public **************************************/
 
 /**
@@ -849,55 +931,8 @@ HAL_Status HAL_SPI_Open(SPI_Port port, SPI_CS cs, SPI_Config *config, uint32_t m
 
 	// DMA config
 	if (config->opMode == SPI_OPERATION_MODE_DMA) {
-		DMA_ChannelInitParam tx_param;
-		DMA_ChannelInitParam rx_param;
-		HAL_Memset(&tx_param, 0, sizeof(tx_param));
-		HAL_Memset(&rx_param, 0, sizeof(rx_param));
-
-		if ((hdl->tx_dmaChannel = HAL_DMA_Request()) == DMA_CHANNEL_INVALID) {
-			SPI_ALERT("DMA request failed \n");
+		if ((ret = HAL_SPI_InitDMA(port, HAL_SPI_TxDMAIntFunc, HAL_SPI_RxDMAIntFunc)) != HAL_OK)
 			goto init_failed;
-		}
-		if ((hdl->rx_dmaChannel = HAL_DMA_Request()) == DMA_CHANNEL_INVALID) {
-			SPI_ALERT("DMA request failed \n");
-			HAL_DMA_Release(hdl->tx_dmaChannel);
-			goto init_failed;
-		}
-
-		tx_param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-											   DMA_WAIT_CYCLE_2,
-											   DMA_BYTE_CNT_MODE_REMAIN,
-											   DMA_DATA_WIDTH_32BIT,
-											   DMA_BURST_LEN_1,
-											   DMA_ADDR_MODE_FIXED,
-											   (DMA_Periph)(DMA_PERIPH_SPI0 + port),
-											   DMA_DATA_WIDTH_8BIT,
-											   DMA_BURST_LEN_4,
-											   DMA_ADDR_MODE_INC,
-											   DMA_PERIPH_SRAM);
-		tx_param.irqType = DMA_IRQ_TYPE_END;
-		tx_param.endCallback = HAL_SPI_TxDMAIntFunc;
-		tx_param.endArg = hdl;
-		SPI_SetTxFifoThreshold(spi, 4);
-
-		rx_param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
-											   DMA_WAIT_CYCLE_2,
-											   DMA_BYTE_CNT_MODE_REMAIN,
-											   DMA_DATA_WIDTH_8BIT,
-											   DMA_BURST_LEN_4,
-											   DMA_ADDR_MODE_INC,
-											   DMA_PERIPH_SRAM,
-											   DMA_DATA_WIDTH_32BIT,
-											   DMA_BURST_LEN_1,
-											   DMA_ADDR_MODE_FIXED,
-											   (DMA_Periph)(DMA_PERIPH_SPI0 + port));
-		rx_param.irqType = DMA_IRQ_TYPE_END;
-		rx_param.endCallback = HAL_SPI_RxDMAIntFunc;
-		rx_param.endArg = hdl;
-		SPI_SetRxFifoThreshold(spi, 4);
-
-		HAL_DMA_Init(hdl->rx_dmaChannel, &rx_param);
-		HAL_DMA_Init(hdl->tx_dmaChannel, &tx_param);
 	}
 
 	SPI_Disable(spi);
@@ -909,12 +944,8 @@ HAL_Status HAL_SPI_Open(SPI_Port port, SPI_CS cs, SPI_Config *config, uint32_t m
 		SPI_SetSclkMode(spi, config->sclkMode);
 		ret = SPI_SetClkDiv(spi, hdl->mclk, config->sclk);
 		if (ret != HAL_OK) {
-			if (config->opMode == SPI_OPERATION_MODE_DMA) {
-				HAL_DMA_DeInit(hdl->rx_dmaChannel);
-				HAL_DMA_DeInit(hdl->tx_dmaChannel);
-				HAL_DMA_Release(hdl->rx_dmaChannel);
-				HAL_DMA_Release(hdl->tx_dmaChannel);
-			}
+			if (config->opMode == SPI_OPERATION_MODE_DMA)
+				HAL_SPI_DeinitDMA(hdl);
 			goto init_failed;
 		}
 		SPI_SetDuplex(spi, SPI_TCTRL_DHB_HALF_DUPLEX);
@@ -969,14 +1000,8 @@ HAL_Status HAL_SPI_Close(SPI_Port port)
 	}
 	hdl->sm.status = SPI_STATUS_READY;
 
-	if (hdl->config.opMode == SPI_OPERATION_MODE_DMA) {
-		HAL_DMA_Stop(hdl->tx_dmaChannel);
-		HAL_DMA_Stop(hdl->rx_dmaChannel);
-		HAL_DMA_DeInit(hdl->tx_dmaChannel);
-		HAL_DMA_DeInit(hdl->rx_dmaChannel);
-		HAL_DMA_Release(hdl->tx_dmaChannel);
-		HAL_DMA_Release(hdl->rx_dmaChannel);
-	}
+	if (hdl->config.opMode == SPI_OPERATION_MODE_DMA)
+		HAL_SPI_DeinitDMA(hdl);
 
 	HAL_BoardIoctl(HAL_BIR_PINMUX_DEINIT, HAL_MKDEV(HAL_DEV_MAJOR_SPI, port), hdl->cs_using);
 	SPI_Disable(hdl->spi);
@@ -1314,3 +1339,348 @@ out:
 }
 
 
+
+/************************ queue **************************************/
+
+/*
+ * The queue runs a burst at a time (see spi_queue.h) and completes it from
+ * the transfer complete interrupt, and from the rx DMA end when the data is
+ * received by DMA. Up to SPI_FIFO_SIZE bytes are moved by the CPU through
+ * the FIFO instead, a command or a register access doesn't need a DMA
+ * start and stop.
+ */
+
+static uint32_t HAL_SPI_QueueNow(void *ctx)
+{
+	return (uint32_t)HAL_RTC_GetFreeRunTime();
+}
+
+/* the same dividers as SPI_SetClkDiv() */
+static bool HAL_SPI_QueueClkValid(uint32_t mclk, uint32_t sclk)
+{
+	uint32_t div;
+
+	if (sclk == 0 || mclk < sclk || (mclk % sclk) != 0)
+		return 0;
+	div = mclk / sclk;
+	return ((div & (div - 1)) == 0) || ((div % 2) == 0);
+}
+
+__nonxip_text
+static void HAL_SPI_QueueSetDevice(SPI_Handler *hdl, const SPI_QueueDevice *dev)
+{
+	SPI_T *spi = hdl->spi;
+	const SPI_QueueDevice *cur = hdl->q_dev;
+
+	if (cur == NULL || cur->sclk != dev->sclk || cur->firstBit != dev->firstBit ||
+	    cur->sclkMode != dev->sclkMode) {
+		SPI_Disable(spi);
+		SPI_SetFirstTransmitBit(spi, dev->firstBit);
+		SPI_SetSclkMode(spi, dev->sclkMode);
+		SPI_SetClkDiv(spi, hdl->mclk, dev->sclk);
+		SPI_Enable(spi);
+	}
+	SPI_ManualChipSelect(spi, dev->cs);
+	hdl->q_dev = dev;
+}
+
+__nonxip_text
+static void HAL_SPI_QueueStartBurst(void *ctx, const struct spiq_xfer *x,
+                                    const struct spiq_burst *b)
+{
+	SPI_Handler *hdl = (SPI_Handler *)ctx;
+	SPI_T *spi = hdl->spi;
+	uint32_t i;
+
+	if (b->cs_first) {
+		if (x->dev != hdl->q_dev)
+			HAL_SPI_QueueSetDevice(hdl, x->dev);
+		SPI_SetCsLevel(spi, !hdl->cs_idle);
+	}
+
+	SPI_SetDuplex(spi, b->duplex ? SPI_TCTRL_DHB_FULL_DUPLEX : SPI_TCTRL_DHB_HALF_DUPLEX);
+	if (b->dual_rx)
+		SPI_EnableDualMode(spi);
+	SPI_ResetTxFifo(spi);
+	SPI_ResetRxFifo(spi);
+	SPI_SetDataSize(spi, b->tx_len, b->duplex ? 0 : b->rx_len);
+
+	hdl->q_txDMA = b->tx_len > SPI_FIFO_SIZE;
+	hdl->q_rxDMA = b->rx_len > SPI_FIFO_SIZE;
+	if (hdl->q_rxDMA)
+		HAL_DMA_Start(hdl->rx_dmaChannel, (uint32_t)SPI_RxAddress(spi), (uint32_t)b->rx, b->rx_len);
+	if (hdl->q_txDMA) {
+		HAL_DMA_Start(hdl->tx_dmaChannel, (uint32_t)b->tx, (uint32_t)SPI_TxAddress(spi), b->tx_len);
+	} else {
+		for (i = 0; i < b->tx_len; i++)
+			SPI_Write(spi, (uint8_t *)&b->tx[i]);
+	}
+	SPI_DMA(spi, hdl->q_txDMA, hdl->q_rxDMA);
+
+	hdl->q_pending = 1 + hdl->q_rxDMA;
+	SPI_StartTransmit(spi);
+}
+
+static const struct spiq_ops spi_queue_ops = {
+	.start	= HAL_SPI_QueueStartBurst,
+	.now_us	= HAL_SPI_QueueNow,
+};
+
+/* one of the events completing a burst, the last one starts the next */
+__nonxip_text
+static void HAL_SPI_QueueEvent(SPI_Handler *hdl)
+{
+	const struct spiq_burst *b = &hdl->queue.burst;
+	SPI_T *spi = hdl->spi;
+	struct spiq_xfer *x;
+	unsigned long flags;
+	uint32_t i;
+
+	flags = HAL_EnterCriticalSection();
+	if (hdl->q_pending == 0 || --hdl->q_pending != 0) {
+		HAL_ExitCriticalSection(flags);
+		return;
+	}
+
+	SPI_DMA(spi, 0, 0);
+	if (hdl->q_txDMA)
+		HAL_DMA_Stop(hdl->tx_dmaChannel);
+	if (hdl->q_rxDMA) {
+		HAL_DMA_Stop(hdl->rx_dmaChannel);
+	} else {
+		for (i = 0; i < b->rx_len; i++)
+			SPI_Read(spi, &b->rx[i]);
+	}
+	if (b->dual_rx)
+		SPI_DisableDualMode(spi);
+	if (b->cs_last)
+		SPI_SetCsLevel(spi, hdl->cs_idle);
+
+	x = spiq_burst_done(&hdl->queue, HAL_OK);
+	HAL_ExitCriticalSection(flags);
+
+	if (x && x->done)
+		x->done(x, HAL_OK, x->arg);
+}
+
+__nonxip_text
+static void HAL_SPI_QueueRxDMAIntFunc(void *arg)
+{
+	HAL_SPI_QueueEvent((SPI_Handler *)arg);
+}
+
+__nonxip_text
+static void HAL_SPI_QueueIRQHandler(SPI_Handler *hdl)
+{
+	if (SPI_IntState(hdl->spi, SPI_INT_TRANSFER_COMPLETE)) {
+		SPI_ClearInt(hdl->spi, SPI_INT_TRANSFER_COMPLETE);
+		HAL_SPI_QueueEvent(hdl);
+	}
+}
+
+__nonxip_text
+static void HAL_SPI0_IRQHandler(void)
+{
+	HAL_SPI_QueueIRQHandler(&spi_handler[SPI0]);
+}
+
+__nonxip_text
+static void HAL_SPI1_IRQHandler(void)
+{
+	HAL_SPI_QueueIRQHandler(&spi_handler[SPI1]);
+}
+
+/**
+  * @brief Open a SPI port for queued transactions (HAL_SPI_Submit).
+  * @note The port is owned by the queue until HAL_SPI_QueueStop, called by
+  *       the same thread: HAL_SPI_Open of other threads waits for it.
+  *       Transactions of all the devices on the port are run back to back
+  *       by priority, each device is selected and the controller set for it
+  *       by the driver.
+  * @param port: spi port
+  * @param msec: timeout in millisecond to get the port
+  * @retval HAL_Status: The status of driver
+  */
+HAL_Status HAL_SPI_QueueStart(SPI_Port port, uint32_t msec)
+{
+	SPI_Handler *hdl = HAL_SPI_GetInstance(port);
+	SPI_T *spi = hdl->spi;
+	HAL_Status ret;
+	unsigned long flags;
+
+	SPI_ENTRY();
+
+	if ((ret = HAL_MutexLock(&hdl->sm.lock, msec)) != HAL_OK)
+		goto out;
+
+	flags = HAL_EnterCriticalSection();
+	if (hdl->sm.status != SPI_STATUS_READY) {
+		HAL_ExitCriticalSection(flags);
+		ret = HAL_ERROR;
+		SPI_ALERT("Changing State incorrectly in %s, state: %d -> busy\n", __func__, hdl->sm.status);
+		goto failed;
+	}
+	hdl->sm.status = SPI_STATUS_BUSY;
+	HAL_ExitCriticalSection(flags);
+
+	HAL_SPI_EnableCCMU(port);
+	if ((ret = HAL_SPI_InitDMA(port, NULL, HAL_SPI_QueueRxDMAIntFunc)) != HAL_OK) {
+		HAL_SPI_DisableCCMU(port);
+		hdl->sm.status = SPI_STATUS_READY;
+		goto failed;
+	}
+
+	spiq_init(&hdl->queue, &spi_queue_ops, hdl);
+	hdl->q_dev = NULL;
+	hdl->q_csMask = 0;
+	hdl->q_pending = 0;
+	hdl->queued = 1;
+
+	SPI_Disable(spi);
+	SPI_SetMode(spi, SPI_CTRL_MODE_MASTER);
+	SPI_SetCsLevel(spi, hdl->cs_idle);
+	SPI_SetDataSize(spi, 0, 0);
+	SPI_ClearInt(spi, SPI_INT_TRANSFER_COMPLETE);
+	SPI_EnableInt(spi, SPI_INT_TRANSFER_COMPLETE);
+	SPI_Enable(spi);
+	HAL_NVIC_ConfigExtIRQ(port == SPI0 ? SPI0_IRQn : SPI1_IRQn,
+	                      port == SPI0 ? HAL_SPI0_IRQHandler : HAL_SPI1_IRQHandler,
+	                      NVIC_PERIPH_PRIO_DEFAULT);
+	SPI_REG_ALL(spi, "queue started");
+	goto out;
+
+failed:
+	HAL_MutexUnlock(&hdl->sm.lock);
+out:
+	SPI_EXIT(ret);
+	return ret;
+}
+
+/**
+  * @brief Close a SPI port opened by HAL_SPI_QueueStart.
+  * @note Waits SPI_MAX_WAIT_MS for the queued transactions, those left are
+  *       completed with HAL_TIMEOUT.
+  * @param port: spi port
+  * @retval HAL_Status: The status of driver
+  */
+HAL_Status HAL_SPI_QueueStop(SPI_Port port)
+{
+	SPI_Handler *hdl = HAL_SPI_GetInstance(port);
+	SPI_T *spi = hdl->spi;
+	struct spiq_xfer *x, *next;
+	HAL_Status ret = HAL_OK;
+	uint32_t end;
+	unsigned long flags;
+	int cs;
+
+	SPI_ENTRY();
+
+	if (hdl->sm.status != SPI_STATUS_BUSY || !hdl->queued) {
+		ret = HAL_ERROR;
+		SPI_ALERT("Changing State incorrectly in %s, state: %d -> ready\n", __func__, hdl->sm.status);
+		goto out;
+	}
+
+	end = HAL_Ticks() + HAL_MSecsToTicks(SPI_MAX_WAIT_MS);
+	while (spiq_busy(&hdl->queue) && HAL_TimeBefore(HAL_Ticks(), end))
+		HAL_MSleep(1);
+
+	HAL_NVIC_DisableIRQ(port == SPI0 ? SPI0_IRQn : SPI1_IRQn);
+	flags = HAL_EnterCriticalSection();
+	SPI_DisableInt(spi, SPI_INT_TRANSFER_COMPLETE);
+	SPI_DMA(spi, 0, 0);
+	hdl->q_pending = 0;
+	x = spiq_abort(&hdl->queue);
+	hdl->queued = 0;
+	HAL_ExitCriticalSection(flags);
+
+	if (x) {
+		ret = HAL_TIMEOUT;
+		SPI_ALERT("%s, transactions left\n", __func__);
+	}
+	for (; x; x = next) {
+		next = x->next;
+		if (x->done)
+			x->done(x, HAL_TIMEOUT, x->arg);
+	}
+
+	HAL_SPI_DeinitDMA(hdl);
+	SPI_SetCsLevel(spi, hdl->cs_idle);
+	SPI_DisableDualMode(spi);
+	for (cs = 0; cs < 4; cs++) {
+		if (hdl->q_csMask & (1 << cs))
+			HAL_BoardIoctl(HAL_BIR_PINMUX_DEINIT, HAL_MKDEV(HAL_DEV_MAJOR_SPI, port),
+			               cs << SPI_TCTRL_SS_SEL_SHIFT);
+	}
+	SPI_Disable(spi);
+	HAL_SPI_DisableCCMU(port);
+
+	/* HAL_SPI_Open sets it again */
+	HAL_Memset(&hdl->config, 0, sizeof(hdl->config));
+	hdl->sm.status = SPI_STATUS_READY;
+	HAL_MutexUnlock(&hdl->sm.lock);
+
+out:
+	SPI_EXIT(ret);
+	return ret;
+}
+
+/**
+  * @brief Queue a transaction on a port opened by HAL_SPI_QueueStart.
+  * @note Returns at once, xfer->done is called from the interrupt completing
+  *       the transaction and may submit the next one. The first transaction
+  *       of a cs pin sets the pin up and must be submitted by a thread.
+  * @param port: spi port
+  * @param dev: the device, valid until the transaction is done.
+  * @param xfer: the transaction, xfer->seg, num, done and arg set.
+  * @retval HAL_Status: The status of driver
+  */
+HAL_Status HAL_SPI_Submit(SPI_Port port, const SPI_QueueDevice *dev, SPI_Xfer *xfer)
+{
+	SPI_Handler *hdl = HAL_SPI_GetInstance(port);
+	uint8_t csBit;
+	unsigned long flags;
+	int err;
+
+	if (!hdl->queued || dev == NULL || xfer == NULL ||
+	    !HAL_SPI_QueueClkValid(hdl->mclk, dev->sclk))
+		return HAL_INVALID;
+
+	csBit = 1 << (dev->cs >> SPI_TCTRL_SS_SEL_SHIFT);
+	if (!(hdl->q_csMask & csBit)) {
+		HAL_BoardIoctl(HAL_BIR_PINMUX_INIT, HAL_MKDEV(HAL_DEV_MAJOR_SPI, port), dev->cs);
+		hdl->q_csMask |= csBit;
+	}
+
+	xfer->dev = dev;
+	xfer->prio = dev->priority;
+	flags = HAL_EnterCriticalSection();
+	err = spiq_submit(&hdl->queue, xfer);
+	HAL_ExitCriticalSection(flags);
+
+	return err ? HAL_INVALID : HAL_OK;
+}
+
+/**
+  * @brief Get the statistics of the queue of a port: transactions, bursts,
+  *        bytes, the time the bus was busy out of the time spanned, and the
+  *        waits from submit to start.
+  * @param port: spi port
+  * @param stats: filled if not NULL
+  * @param reset: restart the statistics
+  * @retval None
+  */
+void HAL_SPI_GetQueueStats(SPI_Port port, SPI_QueueStats *stats, int reset)
+{
+	SPI_Handler *hdl = HAL_SPI_GetInstance(port);
+	unsigned long flags;
+
+	if (hdl->queue.ops == NULL) {	/* never started */
+		if (stats)
+			HAL_Memset(stats, 0, sizeof(*stats));
+		return;
+	}
+	flags = HAL_EnterCriticalSection();
+	spiq_get_stats(&hdl->queue, stats, reset);
+	HAL_ExitCriticalSection(flags);
+}
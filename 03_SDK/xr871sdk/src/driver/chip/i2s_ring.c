@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "compiler.h"
+#include "driver/chip/i2s_ring.h"
+
+void i2s_ring_init(struct i2s_ring *r, uint8_t *buf, uint32_t size, int tx)
+{
+	memset(r, 0, sizeof(*r));
+	r->buf = buf;
+	r->size = size;
+	r->tx = tx;
+}
+
+int i2s_ring_acquire(struct i2s_ring *r, uint8_t **period)
+{
+	int ret = I2S_RING_OK;
+
+	if (!r->running) {
+		/* first round, or stopped on an xrun */
+		if (!r->app)
+			r->app = r->buf;
+		if (!r->tx)
+			return I2S_RING_START;
+		*period = r->app;
+		return I2S_RING_OK;
+	}
+
+	if (r->half && r->end) {
+		/* both periods missed, go on with the one after the DMA's */
+		r->half = 0;
+		r->end = 0;
+		r->xrun++;
+		if (r->dma == r->buf)
+			r->app = r->buf + r->size / 2;
+		else
+			r->app = r->buf;
+		ret = I2S_RING_XRUN;
+	} else if (r->half) {
+		r->half--;
+	} else if (r->end) {
+		r->end--;
+	} else {
+		r->waiting = 1;
+		return I2S_RING_WAIT;
+	}
+
+	*period = r->app;
+	return ret;
+}
+
+/* returns 1 when the DMA is to be started */
+int i2s_ring_commit(struct i2s_ring *r, uint8_t *period)
+{
+	uint8_t *next = period + r->size / 2;
+
+	if (next >= r->buf + r->size)
+		next = r->buf;
+	r->app = next;
+
+	return r->tx && !r->running && next == r->buf;
+}
+
+__nonxip_text
+uint32_t i2s_ring_elapsed(struct i2s_ring *r, int end)
+{
+	uint32_t ev = 0;
+
+	if (end)
+		r->end++;
+	else
+		r->half++;
+
+	if (r->waiting) {
+		r->waiting = 0;
+		ev |= I2S_RING_WAKE;
+	}
+
+	if (r->half >= I2S_RING_XRUN_THRESHOLD ||
+	    r->end >= I2S_RING_XRUN_THRESHOLD) {
+		r->xrun++;
+		r->running = 0;
+		r->half = 0;
+		r->end = 0;
+		r->app = NULL;
+		r->dma = NULL;
+		return ev | I2S_RING_STOP;
+	}
+
+	/* the DMA goes on with the other period */
+	r->dma = end ? r->buf : r->buf + r->size / 2;
+	return ev;
+}
@@ -657,10 +657,39 @@ int mmc_set_blocklen(struct mmc_card *card, unsigned int blocklen)
 	if (mmc_card_blockaddr(card) || mmc_card_ddr_mode(card))
 		return 0;
 
+	/* CMD16 is sticky until the card is reset, skip it when unchanged */
+	if (card->blocklen == blocklen)
+		return 0;
+
 	cmd.opcode = MMC_SET_BLOCKLEN;
 	cmd.arg = blocklen;
 	cmd.flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
-	return mmc_wait_for_cmd(card->host, &cmd);
+	if (mmc_wait_for_cmd(card->host, &cmd)) {
+		card->blocklen = 0;
+		return -1;
+	}
+	card->blocklen = blocklen;
+	return 0;
+}
+
+/*
+ * ACMD23, let the SD card pre-erase the blocks of the following multiple
+ * block write. It is only a hint, the write goes on if the card rejects it.
+ */
+static void mmc_sd_set_wr_blk_erase_count(struct mmc_card *card, uint32_t nblk)
+{
+#ifdef CONFIG_USE_SD
+	struct mmc_command cmd = {0};
+
+	if (!mmc_card_sd(card) || nblk < 2)
+		return;
+
+	cmd.opcode = SET_WR_BLK_ERASE_CNT;
+	cmd.arg = nblk & 0x7FFFFF;
+	cmd.flags = MMC_RSP_SPI_R1 | MMC_RSP_R1 | MMC_CMD_AC;
+	if (mmc_wait_for_app_cmd(card->host, card, &cmd))
+		SD_LOGD("%s nblk:%u fail\n", __func__, nblk);
+#endif
 }
 
 /**
@@ -678,6 +707,7 @@ int mmc_set_blocklen(struct mmc_card *card, unsigned int blocklen)
 int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk, uint32_t nblk)
 {
 	int32_t err;
+	uint32_t cnt;
 	struct scatterlist sg = {0};
 
 	if (!card->host) {
@@ -685,27 +715,21 @@ int32_t mmc_block_read(struct mmc_card *card, uint8_t *buf, uint64_t sblk, uint3
 		return -1;
 	}
 
-	if (nblk > SDXC_MAX_TRANS_LEN/512) {
-		SD_LOGW("%s only support len < %d\n", __func__, SDXC_MAX_TRANS_LEN/512);
-		return -1;
-	}
-
 	mmc_claim_host(card->host);
 
 	err = mmc_set_blocklen(card, 512);
-	if (err)
-		goto out;
-
-	sg.len = 512 * nblk;
-	sg.buffer = buf;
-	//if ((unsigned int)buf & 0x03) {
-	//	SD_LOGW("%s buf not align 4!!!\n", __func__);
-	//	return -1;
-	//}
 
-	err = __sdmmc_block_rw(card, sblk, nblk, 1, &sg, 0);
+	/* one open-ended CMD18 per host transfer limit */
+	while (!err && nblk) {
+		cnt = (nblk > SDXC_MAX_TRANS_LEN/512) ? SDXC_MAX_TRANS_LEN/512 : nblk;
+		sg.len = 512 * cnt;
+		sg.buffer = buf;
+		err = __sdmmc_block_rw(card, sblk, cnt, 1, &sg, 0);
+		buf += sg.len;
+		sblk += cnt;
+		nblk -= cnt;
+	}
 
-out:
 	mmc_release_host(card->host);
 	return err;
 }
@@ -725,6 +749,7 @@ out:
 int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk, uint32_t nblk)
 {
 	int32_t err;
+	uint32_t cnt;
 	struct scatterlist sg = {0};
 
 	if (!card->host) {
@@ -732,25 +757,68 @@ int32_t mmc_block_write(struct mmc_card *card, const uint8_t *buf, uint64_t sblk
 		return -1;
 	}
 
-	if (nblk > SDXC_MAX_TRANS_LEN/512) {
-		SD_LOGW("%s only support block number < %d\n", __func__, SDXC_MAX_TRANS_LEN/512);
+	mmc_claim_host(card->host);
+
+	err = mmc_set_blocklen(card, 512);
+
+	/* one open-ended CMD25 per host transfer limit */
+	while (!err && nblk) {
+		cnt = (nblk > SDXC_MAX_TRANS_LEN/512) ? SDXC_MAX_TRANS_LEN/512 : nblk;
+		sg.len = 512 * cnt;
+		sg.buffer = (uint8_t *)buf;
+		mmc_sd_set_wr_blk_erase_count(card, cnt);
+		err = __sdmmc_block_rw(card, sblk, cnt, 1, &sg, 1);
+		buf += sg.len;
+		sblk += cnt;
+		nblk -= cnt;
+	}
+
+	mmc_release_host(card->host);
+	return err;
+}
+
+/**
+ * @brief write SD card from non-contiguous blocks in one transfer.
+ * @param card:
+ *        @arg card->card handler.
+ * @param bufs:
+ *        @arg bufs->nblk pointers to 512 bytes blocks, 4 bytes aligned.
+ * @param sblk:
+ *        @arg sblk->start block num.
+ * @param nblk:
+ *        @arg nblk->number of blocks, no more than MMC_BLOCK_VEC_MAX.
+ * @retval  0 if success or other if failed.
+ */
+int32_t mmc_block_write_vec(struct mmc_card *card, const uint8_t * const *bufs,
+                            uint64_t sblk, uint32_t nblk)
+{
+	int32_t err;
+	uint32_t i;
+	struct scatterlist sg[MMC_BLOCK_VEC_MAX];
+
+	if (!card->host) {
+		SD_LOGE("%s,%d err", __func__, __LINE__);
+		return -1;
+	}
+
+	if (nblk == 0 || nblk > MMC_BLOCK_VEC_MAX) {
+		SD_LOGW("%s only support block number <= %d\n", __func__, MMC_BLOCK_VEC_MAX);
 		return -1;
 	}
 
+	for (i = 0; i < nblk; i++) {
+		sg[i].buffer = (uint8_t *)bufs[i];
+		sg[i].len = 512;
+	}
+
 	mmc_claim_host(card->host);
 
 	err = mmc_set_blocklen(card, 512);
 	if (err)
 		goto out;
 
-	sg.len = 512 * nblk;
-	sg.buffer = (uint8_t *)buf;
-	//if ((unsigned int)buf & 0x03) {
-	//	SD_LOGW("%s buf not align 4!!!\n", __func__);
-	//	return -1;
-	//}
-
-	err = __sdmmc_block_rw(card, sblk, nblk, 1, &sg, 1);
+	mmc_sd_set_wr_blk_erase_count(card, nblk);
+	err = __sdmmc_block_rw(card, sblk, nblk, nblk, sg, 1);
 
 out:
 	mmc_release_host(card->host);
@@ -908,6 +976,7 @@ int32_t mmc_rescan(struct mmc_card *card, uint32_t sdc_id)
 	}
 
 	card->host = host;
+	card->blocklen = 0;
 
 	mmc_claim_host(host);
 
@@ -1337,6 +1337,7 @@ static struct soc_device sdc_dev = {
 	.name = "sdc",
 	.driver = &sdc_drv,
 	.platform_data = (void *)&_mci_host_rel,
+	.async = 1,
 };
 
 #define SDC_DEV (&sdc_dev)
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "driver/chip/spi_queue.h"
+
+void spiq_init(struct spiq *q, const struct spiq_ops *ops, void *ctx)
+{
+	memset(q, 0, sizeof(*q));
+	q->ops = ops;
+	q->ctx = ctx;
+	q->t_stats = ops->now_us(ctx);
+}
+
+/* fill q->burst from the segments of x starting at x->cur */
+static void spiq_plan(struct spiq *q, struct spiq_xfer *x)
+{
+	struct spiq_burst *b = &q->burst;
+	const struct spiq_seg *s = &x->seg[x->cur];
+	const struct spiq_seg *n;
+	uint8_t cs_first;
+
+	cs_first = (x->cur == 0) || b->cs_last;
+	memset(b, 0, sizeof(*b));
+	b->cs_first = cs_first;
+	b->nseg = 1;
+
+	if (s->tx && s->rx) {
+		b->tx = s->tx;
+		b->rx = s->rx;
+		b->tx_len = s->len;
+		b->rx_len = s->len;
+		b->duplex = 1;
+	} else if (s->tx) {
+		b->tx = s->tx;
+		b->tx_len = s->len;
+		n = s + 1;
+		if (!(s->flags & SPIQ_SEG_CS_CHANGE) && x->cur + 1 < x->num &&
+		    !n->tx && s->len + n->len <= SPIQ_SEG_LEN_MAX) {
+			/* command and answer, the receive starts when the
+			 * transmit ends */
+			b->rx = n->rx;
+			b->rx_len = n->len;
+			b->dual_rx = !!(n->flags & SPIQ_SEG_DUAL_RX);
+			b->nseg = 2;
+			s = n;
+			q->stats.merged++;
+		}
+	} else {
+		b->rx = s->rx;
+		b->rx_len = s->len;
+		b->dual_rx = !!(s->flags & SPIQ_SEG_DUAL_RX);
+	}
+
+	b->cs_last = (x->cur + b->nseg >= x->num) ||
+	             (s->flags & SPIQ_SEG_CS_CHANGE);
+}
+
+static void spiq_start(struct spiq *q, struct spiq_xfer *x)
+{
+	spiq_plan(q, x);
+	q->stats.bursts++;
+	q->stats.bytes += q->burst.duplex ? q->burst.tx_len :
+	                  q->burst.tx_len + q->burst.rx_len;
+	q->t_burst = q->ops->now_us(q->ctx);
+	q->ops->start(q->ctx, x, &q->burst);
+}
+
+/* the first waiting transaction of the highest priority, unless a lower
+ * priority was passed over too often */
+static struct spiq_xfer *spiq_pick(struct spiq *q)
+{
+	struct spiq_xfer *x;
+	int p, top, sel;
+
+	for (top = SPIQ_PRIO_NUM - 1; top >= 0; top--) {
+		if (q->head[top])
+			break;
+	}
+	if (top < 0)
+		return NULL;
+
+	sel = top;
+	for (p = top - 1; p >= 0; p--) {
+		if (q->head[p] && q->passed[p] >= SPIQ_STARVE_LIMIT) {
+			sel = p;
+			q->stats.starved++;
+			break;
+		}
+	}
+	for (p = 0; p < top; p++) {
+		if (p != sel && q->head[p])
+			q->passed[p]++;
+	}
+	q->passed[sel] = 0;
+
+	x = q->head[sel];
+	q->head[sel] = x->next;
+	if (q->head[sel] == NULL)
+		q->tail[sel] = NULL;
+	x->next = NULL;
+	q->depth--;
+	return x;
+}
+
+static void spiq_dispatch(struct spiq *q)
+{
+	struct spiq_xfer *x;
+	uint32_t wait;
+
+	x = spiq_pick(q);
+	q->active = x;
+	if (x == NULL)
+		return;
+
+	wait = q->ops->now_us(q->ctx) - x->t_submit;
+	q->stats.wait_sum_us += wait;
+	if (wait > q->stats.wait_max_us)
+		q->stats.wait_max_us = wait;
+	if (x->dev != q->last_dev) {
+		q->last_dev = x->dev;
+		q->stats.dev_switch++;
+	}
+	spiq_start(q, x);
+}
+
+/**
+ * Queue a transaction, starting it when the bus is idle.
+ * Returns 0, or -1 when the transaction has no segments or a segment is
+ * empty, too long or has neither buffer.
+ */
+int spiq_submit(struct spiq *q, struct spiq_xfer *x)
+{
+	uint16_t i;
+	uint8_t p;
+
+	if (x->num == 0 || x->seg == NULL)
+		return -1;
+	for (i = 0; i < x->num; i++) {
+		if (x->seg[i].len == 0 || x->seg[i].len > SPIQ_SEG_LEN_MAX ||
+		    (!x->seg[i].tx && !x->seg[i].rx))
+			return -1;
+	}
+
+	p = x->prio < SPIQ_PRIO_NUM ? x->prio : SPIQ_PRIO_NUM - 1;
+	x->prio = p;
+	x->next = NULL;
+	x->cur = 0;
+	x->t_submit = q->ops->now_us(q->ctx);
+	if (q->tail[p])
+		q->tail[p]->next = x;
+	else
+		q->head[p] = x;
+	q->tail[p] = x;
+	if (++q->depth > q->stats.depth_max)
+		q->stats.depth_max = q->depth;
+
+	if (q->active == NULL)
+		spiq_dispatch(q);
+	return 0;
+}
+
+/**
+ * The active burst completed. Starts the next burst, of the same
+ * transaction or of the next one, and returns the transaction done with it,
+ * or NULL. A status other than 0 ends the transaction.
+ */
+struct spiq_xfer *spiq_burst_done(struct spiq *q, int status)
+{
+	struct spiq_xfer *x = q->active;
+	uint32_t now;
+
+	if (x == NULL)
+		return NULL;
+
+	now = q->ops->now_us(q->ctx);
+	q->stats.busy_us += now - q->t_burst;
+	q->stats.span_us += now - q->t_stats;
+	q->t_stats = now;
+
+	x->cur += q->burst.nseg;
+	if (status == 0 && x->cur < x->num) {
+		spiq_start(q, x);
+		return NULL;
+	}
+
+	q->stats.xfers++;
+	q->stats.prio_xfers[x->prio]++;
+	if (status != 0)
+		q->stats.errors++;
+	spiq_dispatch(q);
+	return x;
+}
+
+/**
+ * Take the active and the waiting transactions off the queue, the active
+ * one first, as a list linked by next. The caller stops the hardware.
+ */
+struct spiq_xfer *spiq_abort(struct spiq *q)
+{
+	struct spiq_xfer *list = NULL, **tail = &list;
+	int p;
+
+	if (q->active) {
+		*tail = q->active;
+		tail = &q->active->next;
+		q->active = NULL;
+		q->stats.errors++;
+	}
+	for (p = SPIQ_PRIO_NUM - 1; p >= 0; p--) {
+		while (q->head[p]) {
+			*tail = q->head[p];
+			tail = &q->head[p]->next;
+			q->head[p] = q->head[p]->next;
+			q->stats.errors++;
+		}
+		q->tail[p] = NULL;
+		q->passed[p] = 0;
+	}
+	*tail = NULL;
+	q->depth = 0;
+	q->last_dev = NULL;
+	return list;
+}
+
+void spiq_get_stats(struct spiq *q, struct spiq_stats *stats, int reset)
+{
+	uint32_t now = q->ops->now_us(q->ctx);
+
+	q->stats.span_us += now - q->t_stats;
+	q->t_stats = now;
+	if (stats)
+		memcpy(stats, &q->stats, sizeof(*stats));
+	if (reset)
+		memset(&q->stats, 0, sizeof(q->stats));
+}
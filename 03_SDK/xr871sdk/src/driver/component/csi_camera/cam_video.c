@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "kernel/os/os.h"
+#include "sys/interrupt.h"
+#include "driver/chip/hal_dma.h"
+#include "driver/chip/hal_csi.h"
+#include "driver/chip/hal_rtc.h"
+
+#include "driver/component/csi_camera/cam_video.h"
+
+/*
+ * Takes over the CSI interrupt from the sensor driver, which keeps doing
+ * the sensor and CSI setup. Each FIFO is moved by DMA to where the frame
+ * pool says, or to a scratch buffer when the frame is being skipped, the
+ * FIFO has to be read either way.
+ */
+
+#define CAM_FIFO_SIZE       512
+
+struct cam_video {
+	struct frame_pool   pool;
+	uint8_t            *mem;
+	DMA_Channel         dma_a;
+	DMA_Channel         dma_b;
+	OS_Semaphore_t      sem;
+	uint32_t            waiters;
+	uint8_t             run;
+};
+
+static struct cam_video cam_video;
+static uint32_t cam_scratch[CAM_FIFO_SIZE / 4];
+
+static uint32_t cam_now_us(void)
+{
+	return (uint32_t)HAL_RTC_GetFreeRunTime();
+}
+
+static void cam_dma_stop(void *arg)
+{
+	HAL_DMA_Stop(*(DMA_Channel *)arg);
+}
+
+static DMA_Channel cam_dma_request(DMA_Channel *ch)
+{
+	DMA_ChannelInitParam param;
+
+	*ch = HAL_DMA_Request();
+	if (*ch == DMA_CHANNEL_INVALID)
+		return DMA_CHANNEL_INVALID;
+
+	param.cfg = HAL_DMA_MakeChannelInitCfg(DMA_WORK_MODE_SINGLE,
+	                                       DMA_WAIT_CYCLE_1,
+	                                       DMA_BYTE_CNT_MODE_NORMAL,
+	                                       DMA_DATA_WIDTH_32BIT,
+	                                       DMA_BURST_LEN_4,
+	                                       DMA_ADDR_MODE_INC,
+	                                       DMA_PERIPH_SRAM,
+	                                       DMA_DATA_WIDTH_32BIT,
+	                                       DMA_BURST_LEN_4,
+	                                       DMA_ADDR_MODE_INC,
+	                                       DMA_PERIPH_SRAM);
+	param.endArg = ch;
+	param.endCallback = cam_dma_stop;
+	param.irqType = DMA_IRQ_TYPE_END;
+	HAL_DMA_Init(*ch, &param);
+	return *ch;
+}
+
+static void cam_read_fifo(DMA_Channel ch, uint32_t fifo, uint32_t len)
+{
+	uint8_t *dst;
+
+	if (len == 0)
+		return;
+	dst = frame_pool_write(&cam_video.pool, len);
+	if (dst == NULL)
+		dst = (uint8_t *)cam_scratch;
+	HAL_DMA_Start(ch, fifo, (uint32_t)dst, len);
+}
+
+static void cam_video_irq(void *arg)
+{
+	struct cam_video *v = &cam_video;
+	uint32_t irq_sta = HAL_CSI_Interrupt_Sta();
+	CSI_FIFO_Data_Len len;
+
+	HAL_CSI_Interrupt_Clear();
+	len = HAL_CSI_FIFO_Data_Len();
+
+	if (irq_sta & CSI_FIFO_0_OVERFLOW_IRQ)
+		frame_pool_abort(&v->pool);
+
+	if (irq_sta & CSI_FIFO_0_A_READY_IRQ)
+		cam_read_fifo(v->dma_a, CSI_FIFO_A, len.FIFO_0_A_Data_Len);
+	if (irq_sta & CSI_FIFO_0_B_READY_IRQ)
+		cam_read_fifo(v->dma_b, CSI_FIFO_B, len.FIFO_0_B_Data_Len);
+
+	if (irq_sta & CSI_FRAME_DONE_IRQ) {
+		/* the last FIFO of the frame may still be on its way */
+		while (HAL_DMA_IsBusy(v->dma_a) || HAL_DMA_IsBusy(v->dma_b))
+			;
+		if (frame_pool_done(&v->pool, cam_now_us()) != NULL) {
+			for (; v->waiters; v->waiters--)
+				OS_SemaphoreRelease(&v->sem);
+		}
+	}
+}
+
+/**
+  * @brief Start capturing into the frame pool.
+  * @note The sensor must have been initialized, e.g. by Drv_GC0308_Init().
+  *       Its capture callback is replaced until the sensor is initialized
+  *       again.
+  * @param param: The number and size of the buffers.
+  * @retval Component_Status : The driver status.
+  */
+Component_Status Drv_Cam_Video_Start(const Cam_VideoParam *param)
+{
+	struct cam_video *v = &cam_video;
+	CSI_Call_Back cb;
+
+	if (v->run || param->num < 2 || param->num > FRAME_POOL_MAX)
+		return COMP_ERROR;
+
+	memset(v, 0, sizeof(*v));
+	v->dma_a = DMA_CHANNEL_INVALID;
+	v->dma_b = DMA_CHANNEL_INVALID;
+	v->mem = malloc(param->num * param->size);
+	if (v->mem == NULL) {
+		COMPONENT_WARN("frame pool malloc error\n");
+		return COMP_ERROR;
+	}
+	frame_pool_init(&v->pool, v->mem, param->size, param->num, param->jpeg);
+
+	if (OS_SemaphoreCreate(&v->sem, 0, FRAME_POOL_MAX) != OS_OK)
+		goto err;
+	if (cam_dma_request(&v->dma_a) == DMA_CHANNEL_INVALID ||
+	    cam_dma_request(&v->dma_b) == DMA_CHANNEL_INVALID) {
+		COMPONENT_WARN("no DMA channel\n");
+		goto err;
+	}
+
+	HAL_CSI_Moudle_Enalbe(CSI_DISABLE);
+	HAL_CIS_JPEG_Mode_Enable(param->jpeg ? CSI_ENABLE : CSI_DISABLE);
+	cb.arg = v;
+	cb.callBack = cam_video_irq;
+	HAL_CSI_Interrupt_Enable(&cb, CSI_ENABLE);
+	v->run = 1;
+	HAL_CSI_Moudle_Enalbe(CSI_ENABLE);
+	HAL_CSI_Capture_Enable(CSI_VIDEO_MODE, CSI_ENABLE);
+	return COMP_OK;
+
+err:
+	if (v->dma_a != DMA_CHANNEL_INVALID)
+		HAL_DMA_Release(v->dma_a);
+	if (v->dma_b != DMA_CHANNEL_INVALID)
+		HAL_DMA_Release(v->dma_b);
+	if (OS_SemaphoreIsValid(&v->sem))
+		OS_SemaphoreDelete(&v->sem);
+	free(v->mem);
+	v->mem = NULL;
+	return COMP_ERROR;
+}
+
+/**
+  * @brief Stop the capture and free the buffers.
+  * @note Readers must have stopped and put their frames back.
+  */
+void Drv_Cam_Video_Stop(void)
+{
+	struct cam_video *v = &cam_video;
+
+	if (!v->run)
+		return;
+
+	HAL_CSI_Capture_Enable(CSI_VIDEO_MODE, CSI_DISABLE);
+	HAL_CSI_Interrupt_Enable(NULL, CSI_DISABLE);
+	v->run = 0;
+	while (HAL_DMA_IsBusy(v->dma_a) || HAL_DMA_IsBusy(v->dma_b))
+		;
+	HAL_DMA_Release(v->dma_a);
+	HAL_DMA_Release(v->dma_b);
+	OS_SemaphoreDelete(&v->sem);
+	free(v->mem);
+	v->mem = NULL;
+}
+
+/**
+  * @brief Get the latest frame.
+  * @param seq: The seq of the last frame got, 0 for none. Waits for a newer
+  *        frame if the latest one is still seq.
+  * @param timeout_ms: How long to wait for it.
+  * @retval The frame, valid until Drv_Cam_Frame_Put(), NULL on timeout.
+  */
+Cam_Frame *Drv_Cam_Frame_Get(uint32_t seq, uint32_t timeout_ms)
+{
+	struct cam_video *v = &cam_video;
+	OS_Time_t end = OS_GetTicks() + OS_MSecsToTicks(timeout_ms);
+	struct frame *f;
+	unsigned long flags;
+	int32_t left;
+
+	while (v->run) {
+		flags = arch_irq_save();
+		f = frame_pool_get(&v->pool, seq);
+		if (f == NULL)
+			v->waiters++;
+		arch_irq_restore(flags);
+		if (f)
+			return f;
+
+		left = (int32_t)(end - OS_GetTicks());
+		if (timeout_ms != OS_WAIT_FOREVER && left <= 0) {
+			flags = arch_irq_save();
+			if (v->waiters)
+				v->waiters--;
+			arch_irq_restore(flags);
+			break;
+		}
+		/* a release left over by a timed out waiter only costs a retry */
+		OS_SemaphoreWait(&v->sem, timeout_ms == OS_WAIT_FOREVER ?
+		                 OS_WAIT_FOREVER : OS_TicksToMSecs(left));
+	}
+	return NULL;
+}
+
+void Drv_Cam_Frame_Put(Cam_Frame *frame)
+{
+	unsigned long flags = arch_irq_save();
+
+	frame_pool_put(&cam_video.pool, frame);
+	arch_irq_restore(flags);
+}
+
+/**
+  * @brief Account the frame as sent, for the frame to network latency.
+  * @note To call once its last byte has been handed to the network.
+  */
+void Drv_Cam_Frame_Sent(const Cam_Frame *frame)
+{
+	unsigned long flags = arch_irq_save();
+
+	frame_pool_sent(&cam_video.pool, frame, cam_now_us());
+	arch_irq_restore(flags);
+}
+
+void Drv_Cam_Video_Stats(Cam_VideoStats *stats, int reset)
+{
+	unsigned long flags = arch_irq_save();
+
+	frame_pool_get_stats(&cam_video.pool, stats, reset);
+	arch_irq_restore(flags);
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "driver/component/csi_camera/frame_pool.h"
+
+/**
+ * Set up num buffers of size bytes each, one after the other in mem.
+ * Returns 0, or -1 on an invalid argument.
+ */
+int frame_pool_init(struct frame_pool *p, uint8_t *mem, uint32_t size, uint32_t num, int jpeg)
+{
+	uint32_t i;
+
+	if (num < 2 || num > FRAME_POOL_MAX || size == 0)
+		return -1;
+
+	memset(p, 0, sizeof(*p));
+	for (i = 0; i < num; i++) {
+		p->f[i].buf = mem + i * size;
+		p->f[i].size = size;
+	}
+	p->num = num;
+	p->jpeg = !!jpeg;
+	return 0;
+}
+
+static struct frame *frame_pool_alloc(struct frame_pool *p)
+{
+	uint32_t i;
+
+	for (i = 0; i < p->num; i++) {
+		if (p->f[i].state == FRAME_FREE)
+			return &p->f[i];
+	}
+	return NULL;
+}
+
+static void frame_pool_free(struct frame *f)
+{
+	f->state = FRAME_FREE;
+	f->len = 0;
+}
+
+/**
+ * Where the next len bytes of the frame go, the first ones starting a
+ * frame. NULL if the frame is skipped or dropped, the bytes are to be
+ * discarded.
+ */
+uint8_t *frame_pool_write(struct frame_pool *p, uint32_t len)
+{
+	struct frame *f = p->fill;
+	uint8_t *dst;
+
+	if (f == NULL) {
+		if (p->skip)
+			return NULL;
+		f = frame_pool_alloc(p);
+		if (f == NULL) {
+			p->stats.no_buf++;
+			p->skip = 1;
+			return NULL;
+		}
+		f->state = FRAME_FILLING;
+		f->len = 0;
+		f->bad = 0;
+		p->fill = f;
+	}
+
+	if (f->bad)
+		return NULL;
+	if (len > f->size - f->len) {
+		f->bad = 1;
+		return NULL;
+	}
+	dst = f->buf + f->len;
+	f->len += len;
+	return dst;
+}
+
+/**
+ * The FIFO overflowed, the rest of the frame is skipped.
+ */
+void frame_pool_abort(struct frame_pool *p)
+{
+	if (!p->skip)
+		p->stats.overflow++;
+	if (p->fill) {
+		frame_pool_free(p->fill);
+		p->fill = NULL;
+	}
+	p->skip = 1;
+}
+
+/* a JPEG starts with SOI, and ends with EOI followed by padding */
+static int frame_jpeg_trim(struct frame *f)
+{
+	uint32_t i, end;
+
+	if (f->len < 4 || f->buf[0] != 0xFF || f->buf[1] != 0xD8)
+		return 0;
+
+	end = f->len > FRAME_JPEG_TAIL + 2 ? f->len - FRAME_JPEG_TAIL : 2;
+	for (i = f->len - 1; i >= end + 1; i--) {
+		if (f->buf[i] == 0xD9 && f->buf[i - 1] == 0xFF) {
+			f->len = i + 1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * End of the frame, at t_us. Returns the frame published, NULL if it was
+ * skipped or dropped.
+ */
+struct frame *frame_pool_done(struct frame_pool *p, uint32_t t_us)
+{
+	struct frame *f = p->fill, *old;
+
+	p->fill = NULL;
+	p->skip = 0;
+	if (f == NULL)
+		return NULL;
+
+	if (f->bad) {
+		p->stats.overflow++;
+		frame_pool_free(f);
+		return NULL;
+	}
+	if (f->len == 0 || (p->jpeg && !frame_jpeg_trim(f))) {
+		p->stats.bad_jpeg += p->jpeg;
+		frame_pool_free(f);
+		return NULL;
+	}
+
+	f->seq = ++p->seq;
+	f->t_us = t_us;
+	f->state = FRAME_READY;
+	f->ref = 0;
+	f->taken = 0;
+	p->stats.frames++;
+
+	old = p->latest;
+	p->latest = f;
+	if (old && old->ref == 0) {
+		if (!old->taken)
+			p->stats.stale++;
+		frame_pool_free(old);
+	}
+	return f;
+}
+
+/**
+ * The latest frame if it is not seq, the last one the reader got (0 for
+ * none). It stays valid until frame_pool_put().
+ */
+struct frame *frame_pool_get(struct frame_pool *p, uint32_t seq)
+{
+	struct frame *f = p->latest;
+
+	if (f == NULL || f->seq == seq)
+		return NULL;
+	f->ref++;
+	f->taken = 1;
+	return f;
+}
+
+void frame_pool_put(struct frame_pool *p, struct frame *f)
+{
+	if (--f->ref == 0 && f != p->latest)
+		frame_pool_free(f);
+}
+
+/**
+ * The last byte of the frame was handed to the network at t_us.
+ */
+void frame_pool_sent(struct frame_pool *p, const struct frame *f, uint32_t t_us)
+{
+	uint32_t lat = t_us - f->t_us;
+
+	p->stats.sent++;
+	p->stats.lat_sum_us += lat;
+	if (lat > p->stats.lat_max_us)
+		p->stats.lat_max_us = lat;
+}
+
+void frame_pool_get_stats(struct frame_pool *p, struct frame_pool_stats *stats, int reset)
+{
+	*stats = p->stats;
+	if (reset)
+		memset(&p->stats, 0, sizeof(p->stats));
+}
@@ -42,6 +42,7 @@
 #include "driver/chip/hal_def.h"
 #include "driver/component/oled/drv_oled.h"
 #include "ssd1306.h"
+#include "oled_fb.h"
 
 #define OLED_DBG 0
 #define LOG(flags, fmt, arg...)	\
@@ -53,38 +54,40 @@
 #define DRV_OLDE_DBG(fmt, arg...)	\
 			//LOG(OLED_DBG, "[OLED] "fmt, ##arg)
 
-#define OLED_MAX_TRANSFER_DATA_LEN 128
-
 static SSD1306_t oled_t;
 static OS_Mutex_t OLED_WR_LOCK;
+static struct oled_fb oled_fb;
+static OS_Time_t oled_flush_time;
+static OS_Time_t oled_frame_ticks;
 
 static void oled_wrcmd (uint8_t cmd)
 {
 	oled_t.SSD1306_Write(cmd, SSD1306_CMD);
 }
 
-static Component_Status oled_wrdata(const uint8_t *data, uint32_t len)
+static int oled_fb_wr(void *ctx, const uint8_t *buf, uint32_t len, int cmd)
 {
-	int i=0;
-	if (len <= OLED_MAX_TRANSFER_DATA_LEN)
-		for (i = 0; i < len; i++)
-			oled_t.SSD1306_Write(*(data++), SSD1306_DATA);
-	return COMP_OK;
+	if (oled_t.SSD1306_WriteBuf(buf, len, cmd ? SSD1306_CMD : SSD1306_DATA) != HAL_OK)
+		return -1;
+	return 0;
 }
 
-static Component_Status oled_setpos(uint8_t column, uint8_t page)
+/* send the dirty part of the framebuffer, with OLED_WR_LOCK held */
+static int oled_flush(void)
 {
-    oled_wrcmd(0xb0 + page);
-    oled_wrcmd(((column&0xf0)>>4)|0x10);
-    oled_wrcmd((column&0x0f)|0x00);
-    return COMP_OK;
+	int ret = oled_fb_flush(&oled_fb, oled_fb_wr, NULL);
+
+	if (ret < 0)
+		COMPONENT_WARN("oled flush error %d\n", ret);
+	return ret;
 }
 
-static Component_Status oled_write(uint8_t column, uint8_t page , const uint8_t *data, uint32_t len)
+/* draw a 8x16 char of ascii_1608 at x, y in pixels */
+static void oled_char_1608(int x, int y, uint8_t chr)
 {
-	oled_setpos(column, page);
-	oled_wrdata(data, len);
-	return COMP_OK;
+	if (chr < ' ' || chr > '~')
+		chr = ' ';
+	oled_fb_blit(&oled_fb, x, y, 8, 16, &ascii_1608[chr - ' '][0]);
 }
 
 static void Oled_Reset_Io_Init()
@@ -107,49 +110,19 @@ static void Oled_Reset_Io_Init()
   */
 Component_Status DRV_Oled_Pnxm_Bmp(uint8_t column, uint8_t page, uint8_t width, uint8_t hight, const uint8_t *bmp)
 {
-	OS_MutexLock(&OLED_WR_LOCK, 1000000);
-    int pages = hight / 8;
+	int pages = hight / 8;
 	if ((hight % 8) > 0)
 		pages += 1;
-    if (pages > 8) {
+	if (pages > 8) {
 		COMPONENT_WARN("oled show bmp error\n");
 		return COMP_ERROR;
-    }
-    // draw 1st page
-    page = 7 - page;
-    if (pages >= 1) {
-		oled_write(column, page, bmp, width);
-    }
-    // draw 2nd page
-    if (pages >= 2) {
-		oled_write(column, page - 1,&bmp[width], width);
-    }
-    // draw 3rd page
-    if (pages >= 3) {
-		oled_write(column, page - 2, &bmp[width * 2], width);
-    }
-    // draw 4th page
-    if (pages >= 4) {
-		oled_write(column, page - 3, &bmp[width * 3], width);
-    }
-	// draw 5th page
-	if (pages >= 5) {
-		oled_write(column, page - 4, &bmp[width *4], width);
-	}
-	// draw 6th page
-	if (pages >= 6) {
-		oled_write(column, page - 5, &bmp[width* 5], width);
-	}
-	// draw 7th page
-	if (pages >= 7) {
-		oled_write(column, page - 6, &bmp[width * 6], width);
-	}
-	// draw 8th page
-	if (pages == 8) {
-		oled_write(column, page - 7, &bmp[width * 7], width);
 	}
+
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	oled_fb_blit(&oled_fb, column, page * 8, width, pages * 8, bmp);
+	int ret = oled_flush();
 	OS_MutexUnlock(&OLED_WR_LOCK);
-    return COMP_OK;
+	return ret < 0 ? COMP_ERROR : COMP_OK;
 }
 
 /**
@@ -190,20 +163,16 @@ void DRV_Oled_Reset()
   */
 Component_Status  DRV_Oled_Showchar_1608(uint8_t x, uint8_t y, uint8_t chr)
 {
-	OS_MutexLock(&OLED_WR_LOCK, 1000000);
-	const uint8_t *temp;
-	chr -= ' ';
 	if (x > 128 || y > 7) {
 		COMPONENT_WARN("oled show char error\n");
 		return COMP_ERROR;
 	}
 
-	y = 7 - y;
-	temp = &ascii_1608[chr][0];
-	oled_write(x, y, temp, 8);
-	oled_write(x, y - 1, &temp[8], 8);
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	oled_char_1608(x, y * 8, chr);
+	int ret = oled_flush();
 	OS_MutexUnlock(&OLED_WR_LOCK);
-	return COMP_OK;
+	return ret < 0 ? COMP_ERROR : COMP_OK;
 }
 
 /**
@@ -219,16 +188,20 @@ Component_Status DRV_Oled_Show_Str_1608(uint8_t column, uint8_t page, const char
 		COMPONENT_WARN("oled show str error\n");
 		return COMP_ERROR;
 	}
-    const char *p = str;
-    while (*p != '\0') {
-		DRV_Oled_Showchar_1608(column, page, *(p++));
+
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	const char *p = str;
+	while (*p != '\0') {
+		oled_char_1608(column, page * 8, *(p++));
 		column += 8;
 		if (column > 128 || (128 - column) < 8) {
 			page += 2;
 			column = 0;
 		}
 	}
-    return COMP_OK;
+	int ret = oled_flush();
+	OS_MutexUnlock(&OLED_WR_LOCK);
+	return ret < 0 ? COMP_ERROR : COMP_OK;
 }
 
 /**
@@ -242,9 +215,88 @@ Component_Status DRV_Oled_Show_Str_1608(uint8_t column, uint8_t page, const char
 int DRV_Oled_P8xnstr(uint8_t column, uint8_t page, const uint8_t* str, uint8_t len)
 {
 	OS_MutexLock(&OLED_WR_LOCK, 1000000);
-	oled_write(column, page, str, len);
+	/* page is the panel's page here */
+	oled_fb_blit(&oled_fb, column, (7 - page) * 8, len, 8, str);
+	int ret = oled_flush();
+	OS_MutexUnlock(&OLED_WR_LOCK);
+	return ret < 0 ? -1 : 0;
+}
+
+/**
+  * @brief Fill a rectangle of the framebuffer, sent by DRV_Oled_Flush().
+  * @param x: Left, in pixels.
+  * @param y: Top, in pixels.
+  * @param w: Width.
+  * @param h: Height.
+  * @param color: OLED_BLACK, OLED_WHITE or OLED_INVERT.
+  * @retval None.
+  */
+void DRV_Oled_Fb_Fill(int x, int y, int w, int h, int color)
+{
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	oled_fb_fill(&oled_fb, x, y, w, h, color);
+	OS_MutexUnlock(&OLED_WR_LOCK);
+}
+
+/**
+  * @brief Draw a picture in the framebuffer, sent by DRV_Oled_Flush().
+  * @param x: Left, in pixels.
+  * @param y: Top, in pixels, need not be a multiple of 8.
+  * @param w: The width of picture.
+  * @param h: The hight of picture.
+  * @param *bmp: Picture data, as for DRV_Oled_Pnxm_Bmp().
+  * @retval None.
+  */
+void DRV_Oled_Fb_Bmp(int x, int y, int w, int h, const uint8_t *bmp)
+{
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	oled_fb_blit(&oled_fb, x, y, w, h, bmp);
+	OS_MutexUnlock(&OLED_WR_LOCK);
+}
+
+/**
+  * @brief Draw a string in the framebuffer, sent by DRV_Oled_Flush().
+  * @param x: Left, in pixels.
+  * @param y: Top, in pixels.
+  * @param str: The string, clipped at the screen edge.
+  * @retval None.
+  */
+void DRV_Oled_Fb_Str_1608(int x, int y, const char *str)
+{
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	for (; *str != '\0' && x < OLED_FB_WIDTH; x += 8)
+		oled_char_1608(x, y, *(str++));
 	OS_MutexUnlock(&OLED_WR_LOCK);
-    return 0;
+}
+
+/**
+  * @brief Send what changed in the framebuffer since the last flush, no
+  *        sooner than the frame rate set by DRV_Oled_Set_Frame_Rate().
+  * @retval int: The bytes sent, -1 on error.
+  */
+int DRV_Oled_Flush()
+{
+	OS_Time_t next = oled_flush_time + oled_frame_ticks;
+	OS_Time_t now = OS_GetTicks();
+
+	if (oled_frame_ticks && OS_TimeBefore(now, next))
+		OS_MSleep(OS_TicksToMSecs(next - now));
+
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	int ret = oled_flush();
+	oled_flush_time = OS_GetTicks();
+	OS_MutexUnlock(&OLED_WR_LOCK);
+	return ret < 0 ? -1 : ret;
+}
+
+/**
+  * @brief Cap the rate of DRV_Oled_Flush().
+  * @param fps: Frames per second, 0 for no cap.
+  * @retval None.
+  */
+void DRV_Oled_Set_Frame_Rate(uint32_t fps)
+{
+	oled_frame_ticks = fps ? OS_MSecsToTicks(OS_MSEC_PER_SEC / fps) : 0;
 }
 
 /**
@@ -272,10 +324,10 @@ void DRV_Oled_OnOff(int onoff)
 void DRV_Oled_Clear_Screen()
 {
 	DRV_OLDE_DBG("oled_clear_screen\n");
-	uint8_t data[128] = {0};
-	int i = 0;
-	for (i = 0; i <= 7; i++)
-    	DRV_Oled_P8xnstr(0, i, data, 128);
+	OS_MutexLock(&OLED_WR_LOCK, 1000000);
+	oled_fb_fill(&oled_fb, 0, 0, OLED_FB_WIDTH, OLED_FB_HEIGHT, OLED_FB_BLACK);
+	oled_flush();
+	OS_MutexUnlock(&OLED_WR_LOCK);
 }
 
 /**
@@ -314,6 +366,7 @@ Component_Status  DRV_Oled_Init(Oled_Config *cfg)
 	Oled_Reset_Io_Init();
 	DRV_Oled_Reset();
 	SSD1306_Init();
+	oled_fb_init(&oled_fb);
 	DRV_Oled_Clear_Screen();
 
 	COMPONENT_TRACK("end\n");
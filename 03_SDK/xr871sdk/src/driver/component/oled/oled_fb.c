@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "oled_fb.h"
+
+/* SSD1306_HV_COLUMN_ADDRESS and SSD1306_HV_PAGE_ADDRESS */
+#define OLED_FB_CMD_COLUMN  0x21
+#define OLED_FB_CMD_PAGE    0x22
+
+#define OLED_FB_PAGE(y)     (OLED_FB_PAGES - 1 - (y) / 8)
+#define OLED_FB_MIN(a, b)   ((a) < (b) ? (a) : (b))
+#define OLED_FB_MAX(a, b)   ((a) > (b) ? (a) : (b))
+
+void oled_fb_init(struct oled_fb *fb)
+{
+	memset(fb->buf, 0, sizeof(fb->buf));
+	memset(fb->dirty_lo, 0xff, sizeof(fb->dirty_lo));
+	memset(fb->dirty_hi, 0, sizeof(fb->dirty_hi));
+}
+
+/* clip to the screen, 0 if nothing is left */
+static int oled_fb_clip(int *x, int *y, int *w, int *h)
+{
+	if (*x < 0) {
+		*w += *x;
+		*x = 0;
+	}
+	if (*y < 0) {
+		*h += *y;
+		*y = 0;
+	}
+	if (*x + *w > OLED_FB_WIDTH)
+		*w = OLED_FB_WIDTH - *x;
+	if (*y + *h > OLED_FB_HEIGHT)
+		*h = OLED_FB_HEIGHT - *y;
+	return *w > 0 && *h > 0;
+}
+
+/* the bits of rows y0..y1 (inclusive) of the row page holding them */
+static uint8_t oled_fb_rows(int y0, int y1)
+{
+	return (uint8_t)((0xff >> (y0 % 8)) & (0xff << (7 - y1 % 8)));
+}
+
+static void oled_fb_mark_clipped(struct oled_fb *fb, int x, int y, int w, int h)
+{
+	int r, p;
+
+	for (r = y / 8; r <= (y + h - 1) / 8; r++) {
+		p = OLED_FB_PAGES - 1 - r;
+		fb->dirty_lo[p] = OLED_FB_MIN(fb->dirty_lo[p], x);
+		fb->dirty_hi[p] = OLED_FB_MAX(fb->dirty_hi[p], x + w - 1);
+	}
+}
+
+/**
+ * Mark a rectangle to be sent by the next flush, e.g. after writing
+ * fb->buf directly.
+ */
+void oled_fb_mark(struct oled_fb *fb, int x, int y, int w, int h)
+{
+	if (oled_fb_clip(&x, &y, &w, &h))
+		oled_fb_mark_clipped(fb, x, y, w, h);
+}
+
+void oled_fb_mark_all(struct oled_fb *fb)
+{
+	oled_fb_mark_clipped(fb, 0, 0, OLED_FB_WIDTH, OLED_FB_HEIGHT);
+}
+
+/**
+ * Fill a rectangle with OLED_FB_BLACK, OLED_FB_WHITE or OLED_FB_INVERT.
+ */
+void oled_fb_fill(struct oled_fb *fb, int x, int y, int w, int h, int color)
+{
+	uint8_t mask, *d;
+	int r, y0, y1, i;
+
+	if (!oled_fb_clip(&x, &y, &w, &h))
+		return;
+
+	for (r = y / 8; r <= (y + h - 1) / 8; r++) {
+		y0 = OLED_FB_MAX(y, r * 8);
+		y1 = OLED_FB_MIN(y + h - 1, r * 8 + 7);
+		mask = oled_fb_rows(y0, y1);
+		d = &fb->buf[OLED_FB_PAGES - 1 - r][x];
+		for (i = 0; i < w; i++) {
+			if (color == OLED_FB_WHITE)
+				d[i] |= mask;
+			else if (color == OLED_FB_INVERT)
+				d[i] ^= mask;
+			else
+				d[i] &= ~mask;
+		}
+	}
+	oled_fb_mark_clipped(fb, x, y, w, h);
+}
+
+/**
+ * Copy a w x h bitmap to x, y. The bitmap has the layout of
+ * DRV_Oled_Pnxm_Bmp(): (h + 7) / 8 rows of w bytes, each byte a column of 8
+ * pixels with the top one in bit 7. Pixels off the screen are dropped.
+ */
+void oled_fb_blit(struct oled_fb *fb, int x, int y, int w, int h, const uint8_t *bmp)
+{
+	int cx = x, cy = y, cw = w, ch = h;
+	int spages = (h + 7) / 8;
+	int r, s, k, off, y0, y1, i;
+	uint8_t mask, *d;
+	uint16_t v;
+
+	if (!oled_fb_clip(&cx, &cy, &cw, &ch))
+		return;
+
+	for (r = cy / 8; r <= (cy + ch - 1) / 8; r++) {
+		y0 = OLED_FB_MAX(cy, r * 8);
+		y1 = OLED_FB_MIN(cy + ch - 1, r * 8 + 7);
+		mask = oled_fb_rows(y0, y1);
+		d = &fb->buf[OLED_FB_PAGES - 1 - r][cx];
+
+		/* source rows s..s+7 land on this row page */
+		s = r * 8 - y;
+		k = s >= 0 ? s / 8 : -1;
+		off = s - k * 8;
+		for (i = 0; i < cw; i++) {
+			const uint8_t *c = bmp + (cx - x) + i;
+
+			v = 0;
+			if (k >= 0 && k < spages)
+				v = (uint16_t)(c[k * w] << 8);
+			if (off && k + 1 < spages)
+				v |= c[(k + 1) * w];
+			d[i] = (d[i] & ~mask) | ((uint8_t)((v << off) >> 8) & mask);
+		}
+	}
+	oled_fb_mark_clipped(fb, cx, cy, cw, ch);
+}
+
+static int oled_fb_cost(const struct oled_fb_region *r)
+{
+	return OLED_FB_REGION_COST +
+	       (r->page1 - r->page0 + 1) * (r->col1 - r->col0 + 1);
+}
+
+/**
+ * Turn the dirty pages into at most max regions, and mark them clean.
+ * Returns the number of regions.
+ */
+int oled_fb_plan(struct oled_fb *fb, struct oled_fb_region *r, int max)
+{
+	struct oled_fb_region c, m;
+	int n = 0, p;
+
+	for (p = 0; p < OLED_FB_PAGES; p++) {
+		if (fb->dirty_lo[p] > fb->dirty_hi[p])
+			continue;
+		c.page0 = c.page1 = p;
+		c.col0 = fb->dirty_lo[p];
+		c.col1 = fb->dirty_hi[p];
+		fb->dirty_lo[p] = 0xff;
+		fb->dirty_hi[p] = 0;
+
+		if (n > 0) {
+			m.page0 = r[n - 1].page0;
+			m.page1 = p;
+			m.col0 = OLED_FB_MIN(r[n - 1].col0, c.col0);
+			m.col1 = OLED_FB_MAX(r[n - 1].col1, c.col1);
+			if (n == max || oled_fb_cost(&m) <= oled_fb_cost(&r[n - 1]) + oled_fb_cost(&c)) {
+				r[n - 1] = m;
+				continue;
+			}
+		}
+		r[n++] = c;
+	}
+	return n;
+}
+
+/**
+ * Send the dirty regions: the address window, then the data, at once when
+ * the region has full rows and a write per page otherwise. Returns the
+ * bytes sent, or the error of write() with the regions left dirty.
+ */
+int oled_fb_flush(struct oled_fb *fb, oled_fb_write write, void *ctx)
+{
+	struct oled_fb_region r[OLED_FB_PAGES];
+	uint8_t cmd[6];
+	int n, i, p, len, ret, sent = 0;
+
+	n = oled_fb_plan(fb, r, OLED_FB_PAGES);
+	for (i = 0; i < n; i++) {
+		cmd[0] = OLED_FB_CMD_COLUMN;
+		cmd[1] = r[i].col0;
+		cmd[2] = r[i].col1;
+		cmd[3] = OLED_FB_CMD_PAGE;
+		cmd[4] = r[i].page0;
+		cmd[5] = r[i].page1;
+		if ((ret = write(ctx, cmd, sizeof(cmd), 1)) < 0)
+			goto failed;
+		sent += sizeof(cmd);
+
+		len = r[i].col1 - r[i].col0 + 1;
+		if (len == OLED_FB_WIDTH) {
+			len *= r[i].page1 - r[i].page0 + 1;
+			if ((ret = write(ctx, fb->buf[r[i].page0], len, 0)) < 0)
+				goto failed;
+			sent += len;
+			continue;
+		}
+		for (p = r[i].page0; p <= r[i].page1; p++) {
+			if ((ret = write(ctx, &fb->buf[p][r[i].col0], len, 0)) < 0)
+				goto failed;
+			sent += len;
+		}
+	}
+	return sent;
+
+failed:
+	for (; i < n; i++) {
+		for (p = r[i].page0; p <= r[i].page1; p++) {
+			fb->dirty_lo[p] = OLED_FB_MIN(fb->dirty_lo[p], r[i].col0);
+			fb->dirty_hi[p] = OLED_FB_MAX(fb->dirty_hi[p], r[i].col1);
+		}
+	}
+	return ret;
+}
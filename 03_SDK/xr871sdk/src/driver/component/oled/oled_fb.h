@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OLED_FB_H_
+#define _OLED_FB_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Framebuffer of a 128x64 monochrome panel, kept in the controller's own
+ * layout so a region is sent without conversion: a byte per column of 8
+ * rows, the panel's pages in order. The drawing functions take x, y with
+ * the origin at the top left of the mounted panel, whose rows run upside
+ * down (page 7 - y / 8, bit 7 - y % 8), and mark the columns they change
+ * in each page.
+ *
+ * oled_fb_flush() turns the dirty pages into rectangular regions, each
+ * sent as a column/page address window and its data in horizontal
+ * addressing mode. Two regions are merged when rewriting the clean bytes
+ * between them costs less than a region's command and transfer overhead.
+ */
+
+#define OLED_FB_WIDTH       128
+#define OLED_FB_HEIGHT      64
+#define OLED_FB_PAGES       (OLED_FB_HEIGHT / 8)
+
+/* bytes worth the window commands and the transfers of a region */
+#define OLED_FB_REGION_COST 24
+
+#define OLED_FB_BLACK       0
+#define OLED_FB_WHITE       1
+#define OLED_FB_INVERT      2
+
+struct oled_fb {
+	uint8_t     buf[OLED_FB_PAGES][OLED_FB_WIDTH];  /* by panel page */
+	uint8_t     dirty_lo[OLED_FB_PAGES];    /* dirty columns, none if lo > hi */
+	uint8_t     dirty_hi[OLED_FB_PAGES];
+};
+
+struct oled_fb_region {
+	uint8_t     page0, page1;   /* panel pages */
+	uint8_t     col0, col1;
+};
+
+/* send len bytes, commands when cmd is set */
+typedef int (*oled_fb_write)(void *ctx, const uint8_t *buf, uint32_t len, int cmd);
+
+void oled_fb_init(struct oled_fb *fb);
+void oled_fb_mark(struct oled_fb *fb, int x, int y, int w, int h);
+void oled_fb_mark_all(struct oled_fb *fb);
+void oled_fb_fill(struct oled_fb *fb, int x, int y, int w, int h, int color);
+void oled_fb_blit(struct oled_fb *fb, int x, int y, int w, int h, const uint8_t *bmp);
+int oled_fb_plan(struct oled_fb *fb, struct oled_fb_region *r, int max);
+int oled_fb_flush(struct oled_fb *fb, oled_fb_write write, void *ctx);
+
+static __inline int oled_fb_dirty(const struct oled_fb *fb)
+{
+	int p;
+
+	for (p = 0; p < OLED_FB_PAGES; p++) {
+		if (fb->dirty_lo[p] <= fb->dirty_hi[p])
+			return 1;
+	}
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OLED_FB_H_ */
@@ -69,6 +69,24 @@ HAL_Status SSD1306_SPI_Write(uint8_t data, SSD1306_WR_MODE mode)
 	return sta;
 }
 
+/* a burst of commands or data in one transfer, by DMA */
+HAL_Status SSD1306_SPI_WriteBuf(const uint8_t *buf, uint32_t len, SSD1306_WR_MODE mode)
+{
+	OS_MutexLock(&SSD1306_SPI_WR_LOCK, 10000000);
+	HAL_Status sta;
+	if(mode == SSD1306_CMD) {
+		HAL_GPIO_WritePin(SSD1306_dsPort, SSD1306_dsPin, GPIO_PIN_LOW);
+	} else if(mode == SSD1306_DATA) {
+		HAL_GPIO_WritePin(SSD1306_dsPort, SSD1306_dsPin, GPIO_PIN_HIGH);
+	}
+	sta = HAL_SPI_Transmit(SSD1306_SPI_ID, (uint8_t *)buf, len);
+	if (sta != HAL_OK)
+		COMPONENT_WARN("spi write error error %d\n", sta);
+
+	OS_MutexUnlock(&SSD1306_SPI_WR_LOCK);
+	return sta;
+}
+
 HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config)
 {
 	SPI_Global_Config gconfig;
@@ -84,7 +102,7 @@ HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config)
 	SPI_Config spi_Config;
 	spi_Config.firstBit = SPI_TCTRL_FBS_MSB;
 	spi_Config.mode = SPI_CTRL_MODE_MASTER;
-	spi_Config.opMode = SPI_OPERATION_MODE_POLL;
+	spi_Config.opMode = SPI_OPERATION_MODE_DMA;
 	spi_Config.sclk = SSD1306config->SSD1306_SPI_MCLK;
 	spi_Config.sclkMode = SPI_SCLK_Mode0;
 
@@ -106,6 +124,7 @@ HAL_Status SSD1306_SPI_Init(SSD1306_t *SSD1306config)
 	SSD1306_dsPin = SSD1306config->SSD1306_dsPin;
 
 	SSD1306config->SSD1306_Write = SSD1306_SPI_Write;
+	SSD1306config->SSD1306_WriteBuf = SSD1306_SPI_WriteBuf;
 	sta = HAL_SPI_CS(SSD1306_SPI_ID, 1);
 	if (sta != HAL_OK)
 		COMPONENT_WARN("spi cs init error %d\n", sta);
@@ -136,33 +155,28 @@ void SSD1306_set_brightness(uint8_t brightness)
 	SSD1306_SPI_Write(brightness, SSD1306_CMD); //set brightness
 }
 
+/* in ram, for the dma */
+static uint8_t SSD1306_init_cmd[] = {
+	SSD1306_DISPLAYOFF,
+	SSD1306_SETDISPLAYCLOCKDIV, 80,
+	SSD1306_SETMULTIPLEX, 0x3F,
+	SSD1306_SETDISPLAYOFFSET, 0x00,
+	SSD1306_SETSTARTLINE,
+	SSD1306_ENABLE_CHARGE_PUMP, 0x14,
+	SSD1306_MEMORYMODE, 0x00,		/* horizontal, for the framebuffer flush */
+	0xA1,
+	SSD1306_COMSCANINC,
+	SSD1306_SETCOMPINS, 0X12,
+	SSD1306_SETCONTRAST, 0x1F,		/* set brightness */
+	SSD1306_SETPRECHARGE, 0xF1,
+	SSD1306_SETVCOMDETECT, 0x30,
+	SSD1306_DISPLAYALLON_RESUME,
+	SSD1306_NORMALDISPLAY,
+	SSD1306_DISPLAYON,
+};
+
 void SSD1306_Init(SSD1306_t *SSD1306config)
 {
-	SSD1306_SPI_Write(SSD1306_DISPLAYOFF, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETDISPLAYCLOCKDIV, SSD1306_CMD);
-	SSD1306_SPI_Write(80, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETMULTIPLEX, SSD1306_CMD);
-	SSD1306_SPI_Write(0x3F, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETDISPLAYOFFSET, SSD1306_CMD);
-	SSD1306_SPI_Write(0x00, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETSTARTLINE, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_ENABLE_CHARGE_PUMP, SSD1306_CMD);
-	SSD1306_SPI_Write(0x14, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_MEMORYMODE, SSD1306_CMD);
-	SSD1306_SPI_Write(0x02, SSD1306_CMD);
-	SSD1306_SPI_Write(0xA1, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_COMSCANINC, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETCOMPINS, SSD1306_CMD);
-	SSD1306_SPI_Write(0X12, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETCONTRAST, SSD1306_CMD);
-	SSD1306_SPI_Write(0x1F, SSD1306_CMD); //set brightness
-	SSD1306_SPI_Write(SSD1306_SETPRECHARGE, SSD1306_CMD);
-	SSD1306_SPI_Write(0xF1, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_SETVCOMDETECT, SSD1306_CMD);
-	SSD1306_SPI_Write(0x30, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_DISPLAYALLON_RESUME, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_NORMALDISPLAY, SSD1306_CMD);
-	SSD1306_SPI_Write(SSD1306_DISPLAYON, SSD1306_CMD);
+	SSD1306_SPI_WriteBuf(SSD1306_init_cmd, sizeof(SSD1306_init_cmd), SSD1306_CMD);
 	COMPONENT_TRACK("end\n");
 }
-
@@ -89,6 +89,7 @@ typedef enum {
 
 typedef struct {
 	HAL_Status (*SSD1306_Write)(uint8_t data, SSD1306_WR_MODE mode);
+	HAL_Status (*SSD1306_WriteBuf)(const uint8_t *buf, uint32_t len, SSD1306_WR_MODE mode);
 	SPI_Port SSD1306_SPI_ID;
 	SPI_TCTRL_SS_Sel SSD1306_SPI_CS;
 	uint32_t SSD1306_SPI_MCLK;
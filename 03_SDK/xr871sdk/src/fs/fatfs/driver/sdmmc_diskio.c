@@ -27,10 +27,46 @@
 /* Block Size in Bytes */
 #define BLOCK_SIZE                512
 
+/*
+ * Sector cache between FatFS and the card:
+ *  - SDMMC_CACHE_LINES single sectors (FAT, directory) with LRU replacement
+ *    and write-back, dirty neighbours are written together by one CMD25.
+ *  - a read-ahead window filled by one CMD18 when single sector reads are
+ *    sequential, e.g. small f_read() on a media file.
+ * Multi-sector requests go straight to the card.
+ */
+#define SDMMC_CACHE_LINES         8
+#define SDMMC_READ_AHEAD          8
+
+#if (SDMMC_CACHE_LINES > MMC_BLOCK_VEC_MAX)
+#error "SDMMC_CACHE_LINES too large"
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 /* Disk status */
 static volatile DSTATUS Stat = STA_NOINIT;
 
+struct sdmmc_cache_line {
+	DWORD    sector;
+	uint32_t stamp;
+	uint8_t  valid;
+	uint8_t  dirty;
+	BYTE     *data;
+};
+
+struct sdmmc_cache {
+	struct sdmmc_cache_line line[SDMMC_CACHE_LINES];
+	BYTE     *ra_buf;
+	DWORD    ra_sector;     /* first sector of the read-ahead window */
+	UINT     ra_count;      /* valid sectors in the window */
+	DWORD    next_sector;   /* sector following the last read */
+	uint32_t stamp;
+};
+
+/* card is held from SDMMC_initialize() to CTRL_EJECT, calls are serialized by FatFS */
+static struct mmc_card *sdmmc_card;
+static struct sdmmc_cache *sdmmc_cache;
+
 /* Private function prototypes -----------------------------------------------*/
 DSTATUS SD_initialize (BYTE);
 DSTATUS SD_status (BYTE);
@@ -52,6 +88,202 @@ DRESULT SD_read (BYTE, BYTE*, DWORD, UINT);
 #define SDMMC_ENTRY()
 #endif
 
+static struct sdmmc_cache *sdmmc_cache_create(void)
+{
+	struct sdmmc_cache *cache;
+	BYTE *mem;
+	int i;
+
+	cache = malloc(sizeof(*cache) + (SDMMC_CACHE_LINES + SDMMC_READ_AHEAD) * BLOCK_SIZE);
+	if (cache == NULL)
+		return NULL;
+
+	memset(cache, 0, sizeof(*cache));
+	mem = (BYTE *)(cache + 1);
+	for (i = 0; i < SDMMC_CACHE_LINES; i++, mem += BLOCK_SIZE)
+		cache->line[i].data = mem;
+	cache->ra_buf = mem;
+	return cache;
+}
+
+static struct sdmmc_cache_line *sdmmc_cache_find(struct sdmmc_cache *cache, DWORD sector)
+{
+	int i;
+
+	for (i = 0; i < SDMMC_CACHE_LINES; i++) {
+		if (cache->line[i].valid && cache->line[i].sector == sector)
+			return &cache->line[i];
+	}
+	return NULL;
+}
+
+static struct sdmmc_cache_line *sdmmc_cache_find_dirty(struct sdmmc_cache *cache, DWORD sector)
+{
+	struct sdmmc_cache_line *line = sdmmc_cache_find(cache, sector);
+
+	return (line && line->dirty) ? line : NULL;
+}
+
+/* write the dirty run of contiguous sectors around @line with a single transfer */
+static DRESULT sdmmc_cache_flush_run(struct sdmmc_cache *cache, struct sdmmc_cache_line *line)
+{
+	const uint8_t *bufs[SDMMC_CACHE_LINES];
+	struct sdmmc_cache_line *run;
+	DWORD first = line->sector;
+	UINT i, n = 0;
+
+	while (first > 0 && sdmmc_cache_find_dirty(cache, first - 1))
+		first--;
+
+	while ((run = sdmmc_cache_find_dirty(cache, first + n)) != NULL)
+		bufs[n++] = run->data;
+
+	if (mmc_block_write_vec(sdmmc_card, bufs, first, n) != 0) {
+		SDMMC_DEBUG("sdmmc flush %u+%u failed\n", first, n);
+		return RES_ERROR;
+	}
+
+	for (i = 0; i < n; i++)
+		sdmmc_cache_find(cache, first + i)->dirty = 0;
+	return RES_OK;
+}
+
+static DRESULT sdmmc_cache_flush(struct sdmmc_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < SDMMC_CACHE_LINES; i++) {
+		if (cache->line[i].valid && cache->line[i].dirty &&
+		    sdmmc_cache_flush_run(cache, &cache->line[i]) != RES_OK)
+			return RES_ERROR;
+	}
+	return RES_OK;
+}
+
+/* get a line for @sector, evicting the least recently used one */
+static struct sdmmc_cache_line *sdmmc_cache_alloc(struct sdmmc_cache *cache, DWORD sector)
+{
+	struct sdmmc_cache_line *victim = &cache->line[0];
+	int i;
+
+	for (i = 0; i < SDMMC_CACHE_LINES; i++) {
+		if (!cache->line[i].valid) {
+			victim = &cache->line[i];
+			break;
+		}
+		if (cache->line[i].stamp < victim->stamp)
+			victim = &cache->line[i];
+	}
+
+	if (victim->valid && victim->dirty &&
+	    sdmmc_cache_flush_run(cache, victim) != RES_OK)
+		return NULL;
+
+	victim->valid = 0;
+	victim->dirty = 0;
+	victim->sector = sector;
+	return victim;
+}
+
+static __inline void sdmmc_cache_touch(struct sdmmc_cache *cache, struct sdmmc_cache_line *line)
+{
+	line->stamp = ++cache->stamp;
+}
+
+/* copy dirty cached sectors over data just read from the card */
+static void sdmmc_cache_overlay(struct sdmmc_cache *cache, BYTE *buff, DWORD sector, UINT count)
+{
+	int i;
+
+	for (i = 0; i < SDMMC_CACHE_LINES; i++) {
+		struct sdmmc_cache_line *line = &cache->line[i];
+		if (line->valid && line->dirty &&
+		    line->sector >= sector && line->sector < sector + count)
+			memcpy(buff + (line->sector - sector) * BLOCK_SIZE, line->data, BLOCK_SIZE);
+	}
+}
+
+static DRESULT sdmmc_cache_read(struct sdmmc_cache *cache, BYTE *buff, DWORD sector)
+{
+	struct sdmmc_cache_line *line;
+	int sequential = (sector == cache->next_sector);
+
+	cache->next_sector = sector + 1;
+
+	line = sdmmc_cache_find(cache, sector);
+	if (line) {
+		sdmmc_cache_touch(cache, line);
+		memcpy(buff, line->data, BLOCK_SIZE);
+		return RES_OK;
+	}
+
+	if (cache->ra_count && sector >= cache->ra_sector &&
+	    sector < cache->ra_sector + cache->ra_count) {
+		memcpy(buff, cache->ra_buf + (sector - cache->ra_sector) * BLOCK_SIZE, BLOCK_SIZE);
+		return RES_OK;
+	}
+
+	if (sequential) {
+		cache->ra_count = 0;
+		if (mmc_block_read(sdmmc_card, cache->ra_buf, sector, SDMMC_READ_AHEAD) == 0) {
+			cache->ra_sector = sector;
+			cache->ra_count = SDMMC_READ_AHEAD;
+			sdmmc_cache_overlay(cache, cache->ra_buf, sector, SDMMC_READ_AHEAD);
+			memcpy(buff, cache->ra_buf, BLOCK_SIZE);
+			return RES_OK;
+		}
+		/* may run past the end of the card, fall back to a single sector */
+	}
+
+	line = sdmmc_cache_alloc(cache, sector);
+	if (line == NULL)
+		return RES_ERROR;
+	if (mmc_block_read(sdmmc_card, line->data, sector, 1) != 0)
+		return RES_ERROR;
+	line->valid = 1;
+	sdmmc_cache_touch(cache, line);
+	memcpy(buff, line->data, BLOCK_SIZE);
+	return RES_OK;
+}
+
+static DRESULT sdmmc_cache_write(struct sdmmc_cache *cache, const BYTE *buff, DWORD sector)
+{
+	struct sdmmc_cache_line *line;
+
+	line = sdmmc_cache_find(cache, sector);
+	if (line == NULL) {
+		line = sdmmc_cache_alloc(cache, sector);
+		if (line == NULL)
+			return RES_ERROR;
+	}
+	memcpy(line->data, buff, BLOCK_SIZE);
+	line->valid = 1;
+	line->dirty = 1;
+	sdmmc_cache_touch(cache, line);
+
+	if (cache->ra_count && sector >= cache->ra_sector &&
+	    sector < cache->ra_sector + cache->ra_count)
+		memcpy(cache->ra_buf + (sector - cache->ra_sector) * BLOCK_SIZE, buff, BLOCK_SIZE);
+	return RES_OK;
+}
+
+/* sectors overwritten by a direct multi-sector write */
+static void sdmmc_cache_invalidate(struct sdmmc_cache *cache, DWORD sector, UINT count)
+{
+	int i;
+
+	for (i = 0; i < SDMMC_CACHE_LINES; i++) {
+		struct sdmmc_cache_line *line = &cache->line[i];
+		if (line->valid && line->sector >= sector && line->sector < sector + count) {
+			line->valid = 0;
+			line->dirty = 0;
+		}
+	}
+
+	if (cache->ra_count && sector < cache->ra_sector + cache->ra_count &&
+	    sector + count > cache->ra_sector)
+		cache->ra_count = 0;
+}
 
 /**
   * @brief  Initializes a Drive
@@ -64,14 +296,21 @@ DSTATUS SDMMC_initialize()
 
 	SDMMC_ENTRY();
 
+	if (sdmmc_card != NULL && !(Stat & STA_NOINIT))
+		return Stat;
+
 	Stat = STA_NOINIT;
 	card = mmc_card_open(0);
 	if (card != NULL) {
 		if (mmc_card_present(card)) {
 			Stat &= ~STA_NOINIT;
+			sdmmc_card = card;
+			/* run uncached if there is no memory for the cache */
+			sdmmc_cache = sdmmc_cache_create();
+			return Stat;
 		}
+		mmc_card_close(0);
 	}
-	mmc_card_close(0);
 	return Stat;
 }
 
@@ -96,20 +335,24 @@ DSTATUS SDMMC_status()
   */
 DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
 {
-  SDMMC_ENTRY();
-  DRESULT res = RES_ERROR;
-  struct mmc_card *card;
+	SDMMC_ENTRY();
+
+	if (sdmmc_card == NULL)
+		return RES_NOTRDY;
+
+	if (sdmmc_cache != NULL && count == 1)
+		return sdmmc_cache_read(sdmmc_cache, buff, sector);
 
-  card = mmc_card_open(0);
-  if (card != NULL) {
-  	if (mmc_block_read(card, buff, sector, count) != 0) {
+	if (mmc_block_read(sdmmc_card, buff, sector, count) != 0) {
 		SDMMC_DEBUG("sdmmc driver read failed\n");
- 	} else
-		res = RES_OK;
-  }
-  mmc_card_close(0);
+		return RES_ERROR;
+	}
 
-  return res;
+	if (sdmmc_cache != NULL) {
+		sdmmc_cache_overlay(sdmmc_cache, buff, sector, count);
+		sdmmc_cache->next_sector = sector + count;
+	}
+	return RES_OK;
 }
 
 /**
@@ -123,23 +366,22 @@ DRESULT SDMMC_read(BYTE *buff, const DWORD sector, UINT count)
 //#if _USE_WRITE == 1
 DRESULT SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
 {
-	int32_t err;
-	struct mmc_card *card;
-
 	SDMMC_ENTRY();
-	DRESULT res = RES_ERROR;
 
-	card = mmc_card_open(0);
-	if (card != NULL) {
-		err = mmc_block_write(card, (uint8_t *)buff, sector, count);
-		if (err != 0) {
-			SDMMC_DEBUG("sdmmc driver write failed\n");
-		} else
-			res = RES_OK;
+	if (sdmmc_card == NULL)
+		return RES_NOTRDY;
+
+	if (sdmmc_cache != NULL && count == 1)
+		return sdmmc_cache_write(sdmmc_cache, buff, sector);
+
+	if (mmc_block_write(sdmmc_card, (uint8_t *)buff, sector, count) != 0) {
+		SDMMC_DEBUG("sdmmc driver write failed\n");
+		return RES_ERROR;
 	}
-	mmc_card_close(0);
 
-	return res;
+	if (sdmmc_cache != NULL)
+		sdmmc_cache_invalidate(sdmmc_cache, sector, count);
+	return RES_OK;
 }
 //#endif /* _USE_WRITE == 1 */
 
@@ -156,13 +398,28 @@ DRESULT SDMMC_ioctl(BYTE cmd, void *buff)
 	SDMMC_ENTRY();
   DRESULT res = RES_ERROR;
 
-  if (Stat & STA_NOINIT) return RES_NOTRDY;
+  if (Stat & STA_NOINIT) return (cmd == CTRL_EJECT) ? RES_OK : RES_NOTRDY;
 
   switch (cmd)
   {
   /* Make sure that no pending write process */
   case CTRL_SYNC :
     res = RES_OK;
+    if (sdmmc_cache != NULL)
+      res = sdmmc_cache_flush(sdmmc_cache);
+    break;
+
+  /* Flush and release the card before it is deinit */
+  case CTRL_EJECT :
+    res = RES_OK;
+    if (sdmmc_cache != NULL) {
+      res = sdmmc_cache_flush(sdmmc_cache);
+      free(sdmmc_cache);
+      sdmmc_cache = NULL;
+    }
+    sdmmc_card = NULL;
+    mmc_card_close(0);
+    Stat = STA_NOINIT;
     break;
 
   /* Get number of sectors on the disk (DWORD) */
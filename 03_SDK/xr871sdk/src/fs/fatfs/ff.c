@@ -543,6 +543,13 @@ static BYTE CurrVol;			/* Current drive */
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if _USE_FASTSEEK && _FS_CLMT_FILES
+static struct {
+	FIL*	fp;					/* File object using the CLMT (0:blank) */
+	DWORD*	tbl;				/* Cluster link map table of the file */
+} ClmtFiles[_FS_CLMT_FILES];	/* CLMTs attached to the file objects */
+#endif
+
 #if _USE_LFN == 0		/* Non-LFN configuration */
 #define	DEF_NAMBUF
 #define INIT_NAMBUF(fs)
@@ -1434,6 +1441,70 @@ DWORD create_chain (	/* 0:No free cluster, 1:Internal error, 0xFFFFFFFF:Disk err
 
 
 #if _USE_FASTSEEK
+#if _FS_CLMT_FILES
+/*-----------------------------------------------------------------------*/
+/* CLMT attached to a file object (kept out of FIL)                      */
+/*-----------------------------------------------------------------------*/
+
+static
+DWORD* clmt_get (	/* Pointer to the CLMT of the file (0:Not in fast seek mode) */
+	const FIL* fp	/* Pointer to the file object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_CLMT_FILES; i++) {
+		if (ClmtFiles[i].fp == fp) return ClmtFiles[i].tbl;
+	}
+	return 0;
+}
+
+
+static
+int clmt_set (	/* 1:OK, 0:No free entry */
+	FIL* fp,	/* Pointer to the file object */
+	DWORD* tbl	/* Pointer to the CLMT (0:Disable fast seek mode) */
+)
+{
+	UINT i, be = _FS_CLMT_FILES;
+
+
+	for (i = 0; i < _FS_CLMT_FILES; i++) {
+		if (ClmtFiles[i].fp == fp) break;
+		if (!ClmtFiles[i].fp && be == _FS_CLMT_FILES) be = i;
+	}
+	if (i == _FS_CLMT_FILES) {	/* Not registered yet */
+		if (!tbl) return 1;
+		if (be == _FS_CLMT_FILES) return 0;	/* Table is full */
+		i = be;
+	}
+	ClmtFiles[i].fp = tbl ? fp : 0;
+	ClmtFiles[i].tbl = tbl;
+	return 1;
+}
+
+
+static
+void clmt_release (	/* Release the CLMT slot of the file, also without the volume lock */
+	const FIL* fp	/* Pointer to the file object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_CLMT_FILES; i++) {
+		if (ClmtFiles[i].fp == fp) ClmtFiles[i].fp = 0;	/* A single store frees the slot */
+	}
+}
+
+#define FIL_CLTBL(fp)	clmt_get(fp)
+#else
+#define FIL_CLTBL(fp)	((fp)->cltbl)
+#endif
+
+
+
 /*-----------------------------------------------------------------------*/
 /* FAT handling - Convert offset into cluster with link map table        */
 /*-----------------------------------------------------------------------*/
@@ -1448,7 +1519,7 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 	FATFS *fs = fp->obj.fs;
 
 
-	tbl = fp->cltbl + 1;	/* Top of CLMT */
+	tbl = FIL_CLTBL(fp) + 1;	/* Top of CLMT */
 	cl = (DWORD)(ofs / SS(fs) / fs->csize);	/* Cluster order from top of the file */
 	for (;;) {
 		ncl = *tbl++;			/* Number of cluters in the fragment */
@@ -3448,7 +3519,11 @@ FRESULT f_open (
 				fp->obj.objsize = ld_dword(dj.dir + DIR_FileSize);
 			}
 #if _USE_FASTSEEK
+#if _FS_CLMT_FILES
+			clmt_set(fp, 0);		/* Disable fast seek mode */
+#else
 			fp->cltbl = 0;			/* Disable fast seek mode */
+#endif
 #endif
 			fp->obj.fs = fs;	 	/* Validate the file object */
 			fp->obj.id = fs->id;
@@ -3530,7 +3605,7 @@ FRESULT f_read (
 					clst = fp->obj.sclust;		/* Follow cluster chain from the origin */
 				} else {						/* Middle or end of the file */
 #if _USE_FASTSEEK
-					if (fp->cltbl) {
+					if (FIL_CLTBL(fp)) {
 						clst = clmt_clust(fp, fp->fptr);	/* Get cluster# from the CLMT */
 					} else
 #endif
@@ -3635,7 +3710,7 @@ FRESULT f_write (
 					}
 				} else {					/* On the middle or end of the file */
 #if _USE_FASTSEEK
-					if (fp->cltbl) {
+					if (FIL_CLTBL(fp)) {
 						clst = clmt_clust(fp, fp->fptr);	/* Get cluster# from the CLMT */
 					} else
 #endif
@@ -3827,6 +3902,9 @@ FRESULT f_close (
 #endif
 		}
 	}
+#if _USE_FASTSEEK && _FS_CLMT_FILES
+	clmt_release(fp);	/* Release the CLMT slot even on error, the caller frees the table */
+#endif
 	return res;
 }
 
@@ -4012,9 +4090,9 @@ FRESULT f_lseek (
 	if (res != FR_OK) LEAVE_FF(fs, res);
 
 #if _USE_FASTSEEK
-	if (fp->cltbl) {	/* Fast seek */
+	if (FIL_CLTBL(fp)) {	/* Fast seek */
 		if (ofs == CREATE_LINKMAP) {	/* Create CLMT */
-			tbl = fp->cltbl;
+			tbl = FIL_CLTBL(fp);
 			tlen = *tbl++; ulen = 2;	/* Given table size and required table size */
 			cl = fp->obj.sclust;		/* Origin of the chain */
 			if (cl) {
@@ -4032,7 +4110,7 @@ FRESULT f_lseek (
 					}
 				} while (cl < fs->n_fatent);	/* Repeat until end of chain */
 			}
-			*fp->cltbl = ulen;	/* Number of items used */
+			*FIL_CLTBL(fp) = ulen;	/* Number of items used */
 			if (ulen <= tlen) {
 				*tbl = 0;		/* Terminate table */
 			} else {
@@ -5213,6 +5291,35 @@ FRESULT f_expand (
 
 
 
+#if _USE_FASTSEEK
+/*-----------------------------------------------------------------------*/
+/* Set/Clear the Cluster Link Map Table of the File                      */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_setclmt (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD* tbl		/* Pointer to the CLMT, tbl[0] is the table size in items (0:Disable fast seek mode) */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+
+
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK) {
+#if _FS_CLMT_FILES
+		if (!clmt_set(fp, tbl)) res = FR_TOO_MANY_OPEN_FILES;
+#else
+		fp->cltbl = tbl;
+#endif
+	}
+	LEAVE_FF(fs, res);
+}
+
+#endif /* _USE_FASTSEEK */
+
+
+
 #if _USE_FORWARD
 /*-----------------------------------------------------------------------*/
 /* Forward data to the stream directly                                   */
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_BIN_COMPRESS
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "kernel/os/os.h"
+#include "image/image.h"
+#include "image/decomp.h"
+#include "image_debug.h"
+
+#define DECOMP_INBUF_SIZE       (4 * 1024)
+
+#ifndef __CONFIG_BOOTLOADER
+/* read the next chunk of flash in a thread while decoding the current one */
+#define DECOMP_READ_AHEAD       1
+#define DECOMP_THREAD_PRIO      OS_PRIORITY_ABOVE_NORMAL
+#define DECOMP_THREAD_STACK     (1 * 1024)
+#else
+#define DECOMP_READ_AHEAD       0
+#endif
+
+static const image_codec_t * const decomp_codecs[] = {
+	[IMAGE_ATTR_CODEC_XZ >> IMAGE_ATTR_CODEC_SHIFT]  = &image_codec_xz,
+	[IMAGE_ATTR_CODEC_LZ4 >> IMAGE_ATTR_CODEC_SHIFT] = &image_codec_lz4,
+};
+
+struct decomp_reader {
+	uint32_t id;
+	uint32_t offset;
+	uint32_t left;
+	uint16_t chksum;
+	uint8_t *buf[2];
+	uint32_t len[2];        /* 0 on read error */
+#if DECOMP_READ_AHEAD
+	volatile uint8_t stop;
+	OS_Semaphore_t empty;   /* number of buffers to be filled */
+	OS_Semaphore_t filled;  /* number of buffers to be decoded */
+	OS_Semaphore_t done;    /* released on the reader thread exit */
+	OS_Thread_t thread;
+#endif
+};
+
+/* read the next chunk of the body into buf[idx], return its length */
+static uint32_t decomp_read_chunk(struct decomp_reader *r, int idx)
+{
+	uint32_t size, len;
+
+	size = r->left > DECOMP_INBUF_SIZE ? DECOMP_INBUF_SIZE : r->left;
+	len = image_read(r->id, IMAGE_SEG_BODY, r->offset, r->buf[idx], size);
+	if (len != size) {
+		IMAGE_ERR("read img body fail, id %#x, off %u, len %u != %u\n",
+		          r->id, r->offset, len, size);
+		r->len[idx] = 0;
+		return 0;
+	}
+	r->chksum += image_get_checksum(r->buf[idx], len);
+	r->offset += len;
+	r->left -= len;
+	r->len[idx] = len;
+	return len;
+}
+
+#if DECOMP_READ_AHEAD
+static void decomp_reader_task(void *arg)
+{
+	struct decomp_reader *r = arg;
+	int idx = 0;
+
+	while (r->left) {
+		OS_SemaphoreWait(&r->empty, OS_WAIT_FOREVER);
+		if (r->stop)
+			break;
+		if (decomp_read_chunk(r, idx) == 0) {
+			OS_SemaphoreRelease(&r->filled);
+			break;
+		}
+		OS_SemaphoreRelease(&r->filled);
+		idx ^= 1;
+	}
+	OS_SemaphoreRelease(&r->done);
+	OS_ThreadDelete(NULL);
+}
+
+static void decomp_reader_stop(struct decomp_reader *r);
+
+static int decomp_reader_start(struct decomp_reader *r)
+{
+	OS_SemaphoreSetInvalid(&r->empty);
+	OS_SemaphoreSetInvalid(&r->filled);
+	OS_SemaphoreSetInvalid(&r->done);
+	OS_ThreadSetInvalid(&r->thread);
+	r->stop = 0;
+
+	if (OS_SemaphoreCreate(&r->empty, 2, 2) != OS_OK ||
+	    OS_SemaphoreCreate(&r->filled, 0, 2) != OS_OK ||
+	    OS_SemaphoreCreateBinary(&r->done) != OS_OK ||
+	    OS_ThreadCreate(&r->thread, "img_read", decomp_reader_task, r,
+	                    DECOMP_THREAD_PRIO, DECOMP_THREAD_STACK) != OS_OK) {
+		IMAGE_WRN("no read ahead\n");
+		decomp_reader_stop(r);
+		return -1;
+	}
+	return 0;
+}
+
+static void decomp_reader_stop(struct decomp_reader *r)
+{
+	if (OS_ThreadIsValid(&r->thread)) {
+		r->stop = 1;
+		OS_SemaphoreRelease(&r->empty);
+		OS_SemaphoreWait(&r->done, OS_WAIT_FOREVER);
+	}
+	if (OS_SemaphoreIsValid(&r->done))
+		OS_SemaphoreDelete(&r->done);
+	if (OS_SemaphoreIsValid(&r->filled))
+		OS_SemaphoreDelete(&r->filled);
+	if (OS_SemaphoreIsValid(&r->empty))
+		OS_SemaphoreDelete(&r->empty);
+}
+#endif /* DECOMP_READ_AHEAD */
+
+/**
+ * @brief Decompress the body of a compressed section
+ * @param[in] sh Pointer to the section header
+ * @param[in] out Pointer to the output buffer, normally sh->load_addr
+ * @param[in] out_size Size of the output buffer
+ * @param[out] out_len Length of the decompressed data, can be NULL
+ * @return 0 on success, -1 on failure
+ *
+ * The codec is selected by IMAGE_ATTR_CODEC_MASK of the section attribute.
+ * The body is read from flash in chunks. Unless in bootloader, the next
+ * chunk is read by a helper thread while the current one is decoded, the
+ * flash read being done by DMA.
+ */
+int image_decompress(const section_header_t *sh, void *out, uint32_t out_size,
+                     uint32_t *out_len)
+{
+	const image_codec_t *codec;
+	struct decomp_reader r;
+	void *dec;
+	uint32_t codec_id, len, left;
+	image_codec_ret_t cret = IMAGE_CODEC_MORE;
+	int idx = 0, ahead = 0;
+	int ret = -1;
+#if IMAGE_DBG_ON
+	OS_Time_t tm = OS_GetTicks();
+#endif
+
+	codec_id = (sh->attribute & IMAGE_ATTR_CODEC_MASK) >> IMAGE_ATTR_CODEC_SHIFT;
+	if (codec_id >= sizeof(decomp_codecs) / sizeof(decomp_codecs[0]) ||
+	    decomp_codecs[codec_id] == NULL) {
+		IMAGE_ERR("unsupported codec %u\n", codec_id);
+		return -1;
+	}
+	codec = decomp_codecs[codec_id];
+
+	memset(&r, 0, sizeof(r));
+	r.id = sh->id;
+	r.left = sh->body_len;
+	r.chksum = sh->data_chksum;
+	r.buf[0] = malloc(DECOMP_INBUF_SIZE * (DECOMP_READ_AHEAD + 1));
+	if (r.buf[0] == NULL) {
+		IMAGE_ERR("no mem\n");
+		return -1;
+	}
+	r.buf[1] = r.buf[0] + DECOMP_INBUF_SIZE * DECOMP_READ_AHEAD;
+
+	dec = codec->init(out, out_size);
+	if (dec == NULL) {
+		IMAGE_ERR("%s init fail\n", codec->name);
+		free(r.buf[0]);
+		return -1;
+	}
+
+#if DECOMP_READ_AHEAD
+	ahead = (r.left > DECOMP_INBUF_SIZE && decomp_reader_start(&r) == 0);
+#endif
+
+	/*
+	 * Decode the body chunk by chunk. The rest of the body after the end of
+	 * the stream is still read, for the checksum covers the whole body.
+	 */
+	left = sh->body_len;
+	while (left) {
+#if DECOMP_READ_AHEAD
+		if (ahead) {
+			OS_SemaphoreWait(&r.filled, OS_WAIT_FOREVER);
+			len = r.len[idx];
+		} else
+#endif
+		{
+			len = decomp_read_chunk(&r, 0);
+		}
+		if (len == 0) {
+			cret = IMAGE_CODEC_ERROR;
+			break;
+		}
+		left -= len;
+
+		if (cret == IMAGE_CODEC_MORE) {
+			cret = codec->run(dec, r.buf[idx], len, left == 0);
+			if (cret == IMAGE_CODEC_ERROR) {
+				IMAGE_ERR("%s decode fail, off %u\n", codec->name,
+				          sh->body_len - left - len);
+				break;
+			}
+		}
+
+#if DECOMP_READ_AHEAD
+		if (ahead) {
+			OS_SemaphoreRelease(&r.empty);
+			idx ^= 1;
+		}
+#endif
+	}
+
+#if DECOMP_READ_AHEAD
+	if (ahead)
+		decomp_reader_stop(&r);
+#endif
+
+	if (cret == IMAGE_CODEC_MORE) {
+		IMAGE_ERR("no more input data\n");
+	} else if (cret == IMAGE_CODEC_END) {
+		len = codec->out_len(dec);
+#if IMAGE_DBG_ON
+		tm = OS_GetTicks() - tm;
+		IMAGE_DBG("%s() %s, size %u --> %u, cost %u ms\n", __func__,
+		          codec->name, sh->body_len, len, tm);
+#endif
+		if (r.chksum != 0xFFFF) {
+			IMAGE_ERR("invalid checksum %#x\n", r.chksum);
+		} else {
+			if (out_len)
+				*out_len = len;
+			ret = 0;
+		}
+	}
+
+	codec->deinit(dec);
+	free(r.buf[0]);
+	return ret;
+}
+
+#endif /* __CONFIG_BIN_COMPRESS */
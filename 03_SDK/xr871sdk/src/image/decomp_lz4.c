@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_BIN_COMPRESS
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "image/decomp.h"
+
+/*
+ * Streaming decoder of the LZ4 legacy frame format, as written by "lz4 -l":
+ *
+ *   magic (0x184C2102) | block size | block | block size | block | ...
+ *
+ * All sizes are 32-bit little endian. Each block is an LZ4 block holding up
+ * to 8 MiB of output. The matches are copied from the output buffer, so no
+ * window is kept, and the input may be split at any byte.
+ *
+ * The format has no end mark. Like the lz4 tool, a block size of 0 or one
+ * larger than a block can be ends the stream, and so does the end of the
+ * input inside a block size. The rest of the input, eg. the padding of the
+ * section body, is ignored then.
+ */
+#define LZ4_LEGACY_MAGIC    0x184C2102
+#define LZ4_LEGACY_BLOCK    (8 * 1024 * 1024)
+#define LZ4_BLOCK_MAX       (LZ4_LEGACY_BLOCK + LZ4_LEGACY_BLOCK / 255 + 16)
+#define LZ4_MIN_MATCH       4
+
+enum decomp_lz4_state {
+	LZ4_ST_MAGIC,
+	LZ4_ST_BLOCK,       /* block size */
+	LZ4_ST_TOKEN,
+	LZ4_ST_LIT_LEN,     /* extra bytes of literal length */
+	LZ4_ST_LIT,
+	LZ4_ST_OFFSET,
+	LZ4_ST_MATCH_LEN,   /* extra bytes of match length */
+	LZ4_ST_END,
+};
+
+struct decomp_lz4 {
+	uint8_t *out;
+	uint32_t out_pos;
+	uint32_t out_size;
+	uint32_t block_left;    /* input bytes left in the current block */
+	uint32_t lit_len;
+	uint32_t match_len;
+	uint32_t word;          /* multi-byte field being assembled */
+	uint8_t word_len;
+	uint8_t token;
+	uint8_t state;
+};
+
+static void *decomp_lz4_init(uint8_t *out, uint32_t out_size)
+{
+	struct decomp_lz4 *d;
+
+	d = malloc(sizeof(*d));
+	if (d == NULL)
+		return NULL;
+
+	memset(d, 0, sizeof(*d));
+	d->out = out;
+	d->out_size = out_size;
+	d->state = LZ4_ST_MAGIC;
+	return d;
+}
+
+static int decomp_lz4_copy_match(struct decomp_lz4 *d, uint32_t offset)
+{
+	uint8_t *dst, *src;
+	uint32_t len = d->match_len;
+
+	if (offset == 0 || offset > d->out_pos || len > d->out_size - d->out_pos)
+		return -1;
+
+	dst = d->out + d->out_pos;
+	src = dst - offset;
+	d->out_pos += len;
+	if (offset >= len) {
+		memcpy(dst, src, len);
+	} else {
+		while (len--)   /* overlapped, repeat the last offset bytes */
+			*dst++ = *src++;
+	}
+	return 0;
+}
+
+/* state after the literals of a sequence */
+static void decomp_lz4_end_literals(struct decomp_lz4 *d)
+{
+	/* the last sequence of a block has literals only */
+	d->state = d->block_left ? LZ4_ST_OFFSET : LZ4_ST_BLOCK;
+}
+
+static image_codec_ret_t decomp_lz4_run(void *dec, const uint8_t *in,
+                                        uint32_t len, int last)
+{
+	struct decomp_lz4 *d = dec;
+	const uint8_t *end = in + len;
+	uint32_t n;
+
+	while (in < end) {
+		if (d->state == LZ4_ST_END)
+			return IMAGE_CODEC_END;
+		if (d->state > LZ4_ST_BLOCK && d->block_left == 0)
+			return IMAGE_CODEC_ERROR; /* sequence across the block end */
+
+		switch (d->state) {
+		case LZ4_ST_MAGIC:
+		case LZ4_ST_BLOCK:
+			d->word |= (uint32_t)*in++ << (8 * d->word_len);
+			if (++d->word_len < 4)
+				break;
+			n = d->word;
+			d->word = 0;
+			d->word_len = 0;
+			if (n == LZ4_LEGACY_MAGIC) {
+				d->state = LZ4_ST_BLOCK; /* frames may be concatenated */
+			} else if (d->state == LZ4_ST_MAGIC) {
+				return IMAGE_CODEC_ERROR;
+			} else if (n == 0 || n > LZ4_BLOCK_MAX) {
+				d->state = LZ4_ST_END;
+			} else {
+				d->block_left = n;
+				d->state = LZ4_ST_TOKEN;
+			}
+			break;
+		case LZ4_ST_TOKEN:
+			d->token = *in++;
+			d->block_left--;
+			d->lit_len = d->token >> 4;
+			if (d->lit_len == 15)
+				d->state = LZ4_ST_LIT_LEN;
+			else if (d->lit_len)
+				d->state = LZ4_ST_LIT;
+			else
+				decomp_lz4_end_literals(d);
+			break;
+		case LZ4_ST_LIT_LEN:
+			n = *in++;
+			d->block_left--;
+			d->lit_len += n;
+			if (n != 255)
+				d->state = LZ4_ST_LIT;
+			break;
+		case LZ4_ST_LIT:
+			n = end - in;
+			if (n > d->lit_len)
+				n = d->lit_len;
+			if (n > d->block_left || n > d->out_size - d->out_pos)
+				return IMAGE_CODEC_ERROR;
+			memcpy(d->out + d->out_pos, in, n);
+			in += n;
+			d->out_pos += n;
+			d->block_left -= n;
+			d->lit_len -= n;
+			if (d->lit_len == 0)
+				decomp_lz4_end_literals(d);
+			break;
+		case LZ4_ST_OFFSET:
+			d->word |= (uint32_t)*in++ << (8 * d->word_len);
+			d->block_left--;
+			if (++d->word_len < 2)
+				break;
+			d->match_len = (d->token & 0xF) + LZ4_MIN_MATCH;
+			if ((d->token & 0xF) == 0xF) {
+				d->state = LZ4_ST_MATCH_LEN;
+				break;
+			}
+			if (decomp_lz4_copy_match(d, d->word) != 0)
+				return IMAGE_CODEC_ERROR;
+			d->word = 0;
+			d->word_len = 0;
+			d->state = LZ4_ST_TOKEN;
+			break;
+		case LZ4_ST_MATCH_LEN:
+			n = *in++;
+			d->block_left--;
+			d->match_len += n;
+			if (n == 255)
+				break;
+			if (decomp_lz4_copy_match(d, d->word) != 0)
+				return IMAGE_CODEC_ERROR;
+			d->word = 0;
+			d->word_len = 0;
+			d->state = LZ4_ST_TOKEN;
+			break;
+		default:
+			return IMAGE_CODEC_ERROR;
+		}
+	}
+
+	if (!last)
+		return IMAGE_CODEC_MORE;
+
+	/* the input must end between blocks */
+	if (d->state == LZ4_ST_BLOCK || d->state == LZ4_ST_END)
+		return IMAGE_CODEC_END;
+	return IMAGE_CODEC_ERROR;
+}
+
+static uint32_t decomp_lz4_out_len(void *dec)
+{
+	struct decomp_lz4 *d = dec;
+
+	return d->out_pos;
+}
+
+static void decomp_lz4_deinit(void *dec)
+{
+	free(dec);
+}
+
+const image_codec_t image_codec_lz4 = {
+	.name     = "lz4",
+	.init     = decomp_lz4_init,
+	.run      = decomp_lz4_run,
+	.out_len  = decomp_lz4_out_len,
+	.deinit   = decomp_lz4_deinit,
+};
+
+#endif /* __CONFIG_BIN_COMPRESS */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef __CONFIG_BIN_COMPRESS
+
+#include <stdlib.h>
+
+#include "xz/xz.h"
+#include "image/decomp.h"
+
+/*
+ * Support up to DECOMP_XZ_DICT_MAX KiB dictionary. The actually needed
+ * memory is allocated once the headers have been parsed.
+ */
+#define DECOMP_XZ_DICT_MAX      (32 * 1024)
+
+struct decomp_xz {
+	struct xz_dec *s;
+	struct xz_buf b;
+};
+
+static void *decomp_xz_init(uint8_t *out, uint32_t out_size)
+{
+	struct decomp_xz *d;
+
+	d = malloc(sizeof(*d));
+	if (d == NULL)
+		return NULL;
+
+	d->s = xz_dec_init(XZ_DYNALLOC, DECOMP_XZ_DICT_MAX);
+	if (d->s == NULL) {
+		free(d);
+		return NULL;
+	}
+	d->b.in = NULL;
+	d->b.in_pos = 0;
+	d->b.in_size = 0;
+	d->b.out = out;
+	d->b.out_pos = 0;
+	d->b.out_size = out_size;
+	return d;
+}
+
+static image_codec_ret_t decomp_xz_run(void *dec, const uint8_t *in,
+                                       uint32_t len, int last)
+{
+	struct decomp_xz *d = dec;
+	enum xz_ret xzret;
+
+	d->b.in = in;
+	d->b.in_pos = 0;
+	d->b.in_size = len;
+
+	while (1) {
+		xzret = xz_dec_run(d->s, &d->b);
+
+		if (d->b.out_pos == d->b.out_size)
+			return IMAGE_CODEC_ERROR; /* output overflow */
+
+		if (xzret == XZ_STREAM_END)
+			return IMAGE_CODEC_END;
+		else if (xzret != XZ_OK)
+			return IMAGE_CODEC_ERROR;
+
+		if (d->b.in_pos == d->b.in_size)
+			return IMAGE_CODEC_MORE;
+	}
+}
+
+static uint32_t decomp_xz_out_len(void *dec)
+{
+	struct decomp_xz *d = dec;
+
+	return d->b.out_pos;
+}
+
+static void decomp_xz_deinit(void *dec)
+{
+	struct decomp_xz *d = dec;
+
+	xz_dec_end(d->s);
+	free(d);
+}
+
+const image_codec_t image_codec_xz = {
+	.name     = "xz",
+	.init     = decomp_xz_init,
+	.run      = decomp_xz_run,
+	.out_len  = decomp_xz_out_len,
+	.deinit   = decomp_xz_deinit,
+};
+
+#endif /* __CONFIG_BIN_COMPRESS */
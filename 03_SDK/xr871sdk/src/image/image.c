@@ -42,6 +42,7 @@
 #define image_free(p)			free(p)
 #define image_memcpy(d, s, n)	memcpy(d, s, n)
 #define image_memset(s, c, n) 	memset(s, c, n)
+#define image_memmove(d, s, n)	memmove(d, s, n)
 #define image_memcmp(a, b, l)	memcmp(a, b, l)
 
 #define IMAGE_CHECK_SIZE		(1024)
@@ -57,10 +58,33 @@ typedef struct {
 	uint32_t	addr;
 } sec_addr_t;
 
+/* record of a section whose data has been verified */
+typedef struct {
+	uint32_t	id;				/* section ID, 0 for an empty record */
+	uint32_t	version;		/* section version */
+	uint32_t	addr;			/* section address */
+	uint16_t	header_chksum;	/* header checksum */
+	uint8_t		flash;			/* flash ID which the section on */
+	uint8_t		seq;			/* image sequence */
+} image_vrec_t;
+
+#define IMAGE_VCACHE_MAGIC		(0x48435649) /* IVCH */
+#define IMAGE_VCACHE_REC_NUM	(8 * IMAGE_SEQ_NUM)
+
+typedef struct {
+	uint32_t		magic;
+	image_vrec_t	rec[IMAGE_VCACHE_REC_NUM];
+} image_vcache_t;
+
 typedef struct {
 	image_ota_param_t	iop;
 	uint8_t				sec_num[IMAGE_SEQ_NUM];
 	sec_addr_t		   *sec_addr[IMAGE_SEQ_NUM];
+	image_vcache_t	   *vcache;		/* NULL if verified cache is disabled */
+	uint8_t				vcache_dirty;
+	uint32_t			vcache_flash;
+	uint32_t			vcache_addr;
+	uint32_t			vcache_size;
 } image_priv_t;
 
 static image_priv_t	image_priv;
@@ -234,6 +258,7 @@ void image_deinit(void)
 {
 	image_priv_t *img = &image_priv;
 	image_clear_sec_addr(img);
+	image_vcache_deinit();
 	image_memset(img, 0, sizeof(image_priv_t));
 }
 
@@ -368,6 +393,236 @@ uint32_t image_get_section_addr(uint32_t id)
 	return image_get_addr(&image_priv, image_priv.iop.running_seq, id);
 }
 
+/*
+ * Verified cache
+ *
+ * A section is recorded after its data checksum has been verified, keyed on
+ * its location, ID, version and header checksum. The header checksum covers
+ * the data checksum and size, so a recorded section whose header is unchanged
+ * need not be read again to be checked. Records of an image sequence MUST be
+ * dropped before the sequence is rewritten, see image_vcache_drop().
+ */
+static int image_vcache_find(image_priv_t *img, image_seq_t seq,
+                             uint32_t flash, uint32_t addr,
+                             const section_header_t *sh)
+{
+	int i;
+	image_vrec_t *rec;
+
+	if (img->vcache == NULL) {
+		return -1;
+	}
+
+	for (i = 0; i < IMAGE_VCACHE_REC_NUM; ++i) {
+		rec = &img->vcache->rec[i];
+		if (rec->id == sh->id &&
+		    rec->addr == addr &&
+		    rec->flash == flash &&
+		    rec->seq == seq &&
+		    rec->version == sh->version &&
+		    rec->header_chksum == sh->header_chksum) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void image_vcache_add(image_priv_t *img, image_seq_t seq,
+                             uint32_t flash, uint32_t addr,
+                             const section_header_t *sh)
+{
+	int i;
+	image_vrec_t *rec;
+
+	if (img->vcache == NULL || image_vcache_find(img, seq, flash, addr, sh) >= 0) {
+		return;
+	}
+
+	/* reuse the record at the same location, or an empty one */
+	for (i = 0; i < IMAGE_VCACHE_REC_NUM; ++i) {
+		rec = &img->vcache->rec[i];
+		if (rec->id == 0 || (rec->addr == addr && rec->flash == flash)) {
+			break;
+		}
+	}
+	if (i == IMAGE_VCACHE_REC_NUM) {
+		/* full, evict the oldest one */
+		image_memmove(&img->vcache->rec[0], &img->vcache->rec[1],
+		              (IMAGE_VCACHE_REC_NUM - 1) * sizeof(image_vrec_t));
+		i = IMAGE_VCACHE_REC_NUM - 1;
+	}
+
+	rec = &img->vcache->rec[i];
+	rec->id = sh->id;
+	rec->version = sh->version;
+	rec->addr = addr;
+	rec->header_chksum = sh->header_chksum;
+	rec->flash = flash;
+	rec->seq = seq;
+	img->vcache_dirty = 1;
+}
+
+static void image_vcache_flush(image_priv_t *img)
+{
+	fdcm_handle_t *fdcm_hdl;
+
+	if (img->vcache == NULL || !img->vcache_dirty) {
+		return;
+	}
+
+	fdcm_hdl = fdcm_open(img->vcache_flash, img->vcache_addr, img->vcache_size);
+	if (fdcm_hdl == NULL) {
+		IMAGE_ERR("fdcm_open() failed\n");
+		return;
+	}
+	if (fdcm_write(fdcm_hdl, img->vcache, sizeof(image_vcache_t)) !=
+	    sizeof(image_vcache_t)) {
+		IMAGE_ERR("fdcm write failed\n");
+	} else {
+		img->vcache_dirty = 0;
+	}
+	fdcm_close(fdcm_hdl);
+}
+
+/**
+ * @brief Initialize the verified cache, which lets unchanged sections skip
+ *        checking their data again
+ * @param[in] flash Flash device number of the cache area
+ * @param[in] addr Start address of the cache area, aligned to erase block
+ * @param[in] size Size of the cache area, aligned to erase block
+ * @retval 0 on success, -1 on failure
+ */
+int image_vcache_init(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	fdcm_handle_t *fdcm_hdl;
+	image_priv_t *img = &image_priv;
+
+	if (img->vcache != NULL) {
+		return 0;
+	}
+
+	fdcm_hdl = fdcm_open(flash, addr, size);
+	if (fdcm_hdl == NULL) {
+		IMAGE_ERR("fdcm_open() failed\n");
+		return -1;
+	}
+
+	img->vcache = image_malloc(sizeof(image_vcache_t));
+	if (img->vcache == NULL) {
+		IMAGE_ERR("no mem\n");
+		fdcm_close(fdcm_hdl);
+		return -1;
+	}
+
+	if ((fdcm_read(fdcm_hdl, img->vcache, sizeof(image_vcache_t)) !=
+	     sizeof(image_vcache_t)) || (img->vcache->magic != IMAGE_VCACHE_MAGIC)) {
+		IMAGE_DBG("empty verified cache\n");
+		image_memset(img->vcache, 0, sizeof(image_vcache_t));
+		img->vcache->magic = IMAGE_VCACHE_MAGIC;
+	}
+	fdcm_close(fdcm_hdl);
+
+	img->vcache_dirty = 0;
+	img->vcache_flash = flash;
+	img->vcache_addr = addr;
+	img->vcache_size = size;
+	return 0;
+}
+
+/**
+ * @brief DeInitialize the verified cache
+ * @return None
+ */
+void image_vcache_deinit(void)
+{
+	image_priv_t *img = &image_priv;
+
+	if (img->vcache) {
+		image_vcache_flush(img);
+		image_free(img->vcache);
+		img->vcache = NULL;
+	}
+}
+
+/**
+ * @brief Drop the verified records of the specified image
+ * @param[in] seq Sequence of the specified image
+ * @return None
+ *
+ * @note Call it before writing the image, eg. before OTA erases the image
+ */
+void image_vcache_drop(image_seq_t seq)
+{
+	int i;
+	image_priv_t *img = &image_priv;
+
+	if (img->vcache == NULL) {
+		return;
+	}
+
+	for (i = 0; i < IMAGE_VCACHE_REC_NUM; ++i) {
+		if (img->vcache->rec[i].id != 0 && img->vcache->rec[i].seq == seq) {
+			image_memset(&img->vcache->rec[i], 0, sizeof(image_vrec_t));
+			img->vcache_dirty = 1;
+		}
+	}
+	image_vcache_flush(img);
+}
+
+/**
+ * @brief Check whether the data of the specified section in running image
+ *        has been verified, with the same header
+ * @param[in] id ID of the specified section
+ * @param[in] sh Pointer to the valid section header read from flash
+ * @retval image_val_t, IMAGE_VALID if verified, IMAGE_INVALID if not
+ */
+image_val_t image_get_verified(uint32_t id, const section_header_t *sh)
+{
+	uint32_t addr;
+	image_priv_t *img = &image_priv;
+	image_seq_t seq = img->iop.running_seq;
+
+	if (img->vcache == NULL || seq >= IMAGE_SEQ_NUM) {
+		return IMAGE_INVALID;
+	}
+
+	addr = image_get_addr(img, seq, id);
+	if (addr == IMAGE_INVALID_ADDR) {
+		return IMAGE_INVALID;
+	}
+
+	if (image_vcache_find(img, seq, img->iop.flash[seq], addr, sh) < 0) {
+		return IMAGE_INVALID;
+	}
+	return IMAGE_VALID;
+}
+
+/**
+ * @brief Record that the data of the specified section in running image has
+ *        been verified
+ * @param[in] id ID of the specified section
+ * @param[in] sh Pointer to the valid section header read from flash
+ * @return None
+ */
+void image_set_verified(uint32_t id, const section_header_t *sh)
+{
+	uint32_t addr;
+	image_priv_t *img = &image_priv;
+	image_seq_t seq = img->iop.running_seq;
+
+	if (img->vcache == NULL || seq >= IMAGE_SEQ_NUM) {
+		return;
+	}
+
+	addr = image_get_addr(img, seq, id);
+	if (addr == IMAGE_INVALID_ADDR) {
+		return;
+	}
+
+	image_vcache_add(img, seq, img->iop.flash[seq], addr, sh);
+	image_vcache_flush(img);
+}
+
 /**
  * @brief Read/Write an amount of image data from/to flash
  * @param[in] id Section ID of the image data
@@ -427,26 +682,74 @@ uint32_t image_rw(uint32_t id, image_seg_t seg, uint32_t offset,
 	}
 
 	if (do_write) {
+		image_vcache_drop(seq);
 		return flash_write(iop->flash[seq], addr + offset, buf, size);
 	} else {
 		return flash_read(iop->flash[seq], addr + offset, buf, size);
 	}
 }
 
+/*
+ * The checksum is the sum of all little-endian 16-bit words, modulo 2^16.
+ *
+ * Data is loaded a 32-bit word at a time: the low 16 bits of (w + (w >> 16))
+ * are the sum of both halfwords of w, and the bits above only carry upwards,
+ * so a 32-bit accumulator truncated at the end gives the same result as the
+ * halfword loop with half of the loads.
+ */
+#define IMAGE_CHECKSUM_ADD_WORD(cs, w)	((cs) += (w) + ((w) >> 16))
+
 static uint16_t image_checksum16(uint8_t *data, uint32_t len)
 {
-	uint16_t cs = 0;
-	uint16_t *p = (uint16_t *)data;
+	uint32_t cs = 0;
+	uint32_t w;
+	const uint32_t *p;
+
+	if ((uintptr_t)data & 0x1) {
+		/* halfwords are unaligned, build them from bytes */
+		while (len > 1) {
+			cs += data[0] | ((uint32_t)data[1] << 8);
+			data += 2;
+			len -= 2;
+		}
+	} else {
+		if (((uintptr_t)data & 0x2) && (len > 1)) {
+			cs += *(uint16_t *)data;
+			data += 2;
+			len -= 2;
+		}
 
-	while (len > 1) {
-		cs += *p++;
-		len -= 2;
+		p = (const uint32_t *)data;
+		while (len >= 16) {
+			w = p[0];
+			IMAGE_CHECKSUM_ADD_WORD(cs, w);
+			w = p[1];
+			IMAGE_CHECKSUM_ADD_WORD(cs, w);
+			w = p[2];
+			IMAGE_CHECKSUM_ADD_WORD(cs, w);
+			w = p[3];
+			IMAGE_CHECKSUM_ADD_WORD(cs, w);
+			p += 4;
+			len -= 16;
+		}
+		while (len >= 4) {
+			w = *p++;
+			IMAGE_CHECKSUM_ADD_WORD(cs, w);
+			len -= 4;
+		}
+
+		data = (uint8_t *)p;
+		if (len > 1) {
+			cs += *(uint16_t *)data;
+			data += 2;
+			len -= 2;
+		}
 	}
 	if (len) {
-		cs += *(uint8_t *)p;
+		cs += *data;
 	}
 
-	return cs;
+	return (uint16_t)cs;
 }
 
 /**
@@ -540,6 +843,7 @@ image_val_t image_check_data(section_header_t *sh, void *body, uint32_t body_len
 
 /**
  * @brief Check vadility of the section placed at the specified address
+ * @param[in] seq Sequence of the image which the section belongs to
  * @param[in] flash Flash device number of the section
  * @param[in] flash Address of the section
  * @param[in] buf Temporary buffer helping to read data
@@ -547,14 +851,17 @@ image_val_t image_check_data(section_header_t *sh, void *body, uint32_t body_len
  * @param[out] next_addr Pointer to the the next section offset
  * @retval image_val_t, IMAGE_VALID on valid, IMAGE_INVALID on invalid
  */
-static image_val_t _image_check_section(uint32_t flash, uint32_t addr,
+static image_val_t _image_check_section(image_seq_t seq,
+                                        uint32_t flash, uint32_t addr,
                                         uint8_t *buf, uint32_t buf_len,
                                         uint32_t *next_addr)
 {
+	uint32_t			sec_addr = addr;
 	uint32_t			offset;
 	uint16_t			data_chksum;
 	uint32_t			data_size;
 	section_header_t   *sh;
+	image_priv_t	   *img = &image_priv;
 
 	if (flash_read(flash, addr, buf, IMAGE_HEADER_SIZE) != IMAGE_HEADER_SIZE) {
 		return IMAGE_INVALID;
@@ -568,6 +875,14 @@ static image_val_t _image_check_section(uint32_t flash, uint32_t addr,
 	data_size = sh->data_size;
 	offset = sh->next_addr;
 
+	if (image_vcache_find(img, seq, flash, sec_addr, sh) >= 0) {
+		IMAGE_DBG("%s() verified, flash %u, addr %#x\n", __func__, flash, sec_addr);
+		if (next_addr) {
+			*next_addr = offset;
+		}
+		return IMAGE_VALID;
+	}
+
 	addr += IMAGE_HEADER_SIZE;
 	while (data_size > 0) {
 		if (data_size >= buf_len) {
@@ -592,6 +907,12 @@ static image_val_t _image_check_section(uint32_t flash, uint32_t addr,
 		return IMAGE_INVALID;
 	}
 
+	/* buf is overwritten by the data, read the header again for the record */
+	if (img->vcache &&
+	    flash_read(flash, sec_addr, buf, IMAGE_HEADER_SIZE) == IMAGE_HEADER_SIZE) {
+		image_vcache_add(img, seq, flash, sec_addr, (section_header_t *)buf);
+	}
+
 	if (next_addr) {
 		*next_addr = offset;
 	}
@@ -625,9 +946,10 @@ image_val_t image_check_section(image_seq_t seq, uint32_t id)
 		return IMAGE_INVALID;
 	}
 
-	ret = _image_check_section(img->iop.flash[seq], addr,
+	ret = _image_check_section(seq, img->iop.flash[seq], addr,
 	                           buf, IMAGE_CHECK_SIZE, NULL);
 	image_free(buf);
+	image_vcache_flush(img);
 	return ret;
 }
 
@@ -656,11 +978,12 @@ image_val_t image_check_sections(image_seq_t seq)
 	addr = IMG_BL_ADDR(iop);
 
 	while (1) {
-		if (_image_check_section(flash, addr, buf, IMAGE_CHECK_SIZE,
+		if (_image_check_section(seq, flash, addr, buf, IMAGE_CHECK_SIZE,
 		                         &next_addr) == IMAGE_INVALID) {
 			IMAGE_WRN("%s(), invalid section, seq %d, flash %d, addr %#x\n",
 					  __func__, seq, flash, addr);
 			image_free(buf);
+			image_vcache_flush(&image_priv);
 			return IMAGE_INVALID;
 		}
 		if (next_addr == IMAGE_INVALID_ADDR)
@@ -671,6 +994,7 @@ image_val_t image_check_sections(image_seq_t seq)
 	}
 
 	image_free(buf);
+	image_vcache_flush(&image_priv);
 	return IMAGE_VALID;
 }
 
@@ -390,6 +390,7 @@ void vPortEnterCritical( void )
 	assert function also uses a critical section. */
 	if( uxCriticalNesting == 1 )
 	{
+		traceCRITICAL_ENTER();
 		configASSERT( ( portNVIC_INT_CTRL_REG & portVECTACTIVE_MASK ) == 0 );
 	}
 }
@@ -401,6 +402,7 @@ void vPortExitCritical( void )
 	uxCriticalNesting--;
 	if( uxCriticalNesting == 0 )
 	{
+		traceCRITICAL_EXIT();
 		portENABLE_INTERRUPTS();
 	}
 }
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "kernel/FreeRTOS/rtstat.h"
+
+static void rtstat_hist_add(struct rtstat_hist *hist, uint64_t duration)
+{
+	uint32_t ticks = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+	int n = ticks < 2 ? 0 : 31 - __builtin_clz(ticks);
+
+	if (n >= RTSTAT_HIST_NUM)
+		n = RTSTAT_HIST_NUM - 1;
+	hist->count[n]++;
+	hist->sum += ticks;
+	if (ticks > hist->max)
+		hist->max = ticks;
+}
+
+/* the task's figures are cleared the first time it is seen after a reset */
+static __inline void rtstat_task_check(const struct rtstat *st, struct rtstat_task *task)
+{
+	if (task->epoch != st->epoch) {
+		memset(task, 0, sizeof(*task));
+		task->epoch = st->epoch;
+	}
+}
+
+void rtstat_reset(struct rtstat *st, uint64_t now)
+{
+	uint8_t epoch = st->epoch + 1;
+	struct rtstat_task *current = st->current;
+	uint64_t critical_at = st->critical_at;
+
+	/* it may be called in a critical section, which goes on */
+	memset(st, 0, sizeof(*st));
+	st->epoch = epoch;
+	st->current = current;
+	st->critical_at = critical_at;
+	st->switched_at = now;
+	st->reset_at = now;
+}
+
+void rtstat_task_ready(struct rtstat *st, struct rtstat_task *task, uint64_t now)
+{
+	rtstat_task_check(st, task);
+	if (!task->ready) {
+		task->ready = 1;
+		task->ready_at = now;
+	}
+}
+
+void rtstat_switch_out(struct rtstat *st, struct rtstat_task *task, int ready, uint64_t now)
+{
+	rtstat_task_check(st, task);
+	task->run_time += now - st->switched_at;
+	task->ready = ready;
+	task->ready_at = now;
+	st->switched_at = now;
+}
+
+void rtstat_switch_in(struct rtstat *st, struct rtstat_task *task)
+{
+	uint64_t latency;
+
+	rtstat_task_check(st, task);
+	if (task == st->current) {
+		/* it goes on running */
+		task->ready = 0;
+		return;
+	}
+	st->current = task;
+	task->switches++;
+	if (task->ready) {
+		task->ready = 0;
+		latency = st->switched_at - task->ready_at;
+		rtstat_hist_add(&st->latency, latency);
+		if (latency > task->latency_max)
+			task->latency_max = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+	}
+}
+
+void rtstat_critical_enter(struct rtstat *st, uint64_t now)
+{
+	st->critical_at = now;
+}
+
+void rtstat_critical_exit(struct rtstat *st, uint64_t now)
+{
+	rtstat_hist_add(&st->critical, now - st->critical_at);
+}
+
+void rtstat_task_get(const struct rtstat *st, const struct rtstat_task *task,
+                     struct rtstat_task *out)
+{
+	if (task->epoch == st->epoch)
+		*out = *task;
+	else
+		memset(out, 0, sizeof(*out));
+}
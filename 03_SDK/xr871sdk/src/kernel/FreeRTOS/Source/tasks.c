@@ -176,6 +176,14 @@ typedef struct tskTaskControlBlock
 		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
 	#endif
 
+	#if ( configDEBUG_RTSTAT_EN == 1 )
+		struct rtstat_task	xRtStat;		/*< Run time and latency of the task, see rtstat.h. */
+	#endif
+
+	#if ( configDEBUG_TRACE_TASK_MOREINFO == 1 )
+		uint16_t		usStackDepth;		/*< Size of the stack in words, as created. */
+	#endif
+
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		/* Allocate a Newlib reent structure that is specific to this task.
 		Note Newlib support has been included by popular demand, but is not
@@ -2904,6 +2912,18 @@ UBaseType_t x;
 	}
 	#endif /* configGENERATE_RUN_TIME_STATS */
 
+	#if ( configDEBUG_RTSTAT_EN == 1 )
+	{
+		memset( &( pxTCB->xRtStat ), 0, sizeof( pxTCB->xRtStat ) );
+	}
+	#endif /* configDEBUG_RTSTAT_EN */
+
+	#if ( configDEBUG_TRACE_TASK_MOREINFO == 1 )
+	{
+		pxTCB->usStackDepth = usStackDepth;
+	}
+	#endif /* configDEBUG_TRACE_TASK_MOREINFO */
+
 	#if ( portUSING_MPU_WRAPPERS == 1 )
 	{
 		vPortStoreTaskMPUSettings( &( pxTCB->xMPUSettings ), xRegions, pxTCB->pxStack, usStackDepth );
@@ -3200,6 +3220,7 @@ TCB_t *pxNewTCB;
 #if configDEBUG_TRACE_TASK_MOREINFO
 				pxTaskStatusArray[ uxTask ].pxTopOfStack = pxNextTCB->pxTopOfStack;
 				pxTaskStatusArray[ uxTask ].pxStack = pxNextTCB->pxStack;
+				pxTaskStatusArray[ uxTask ].usStackDepth = pxNextTCB->usStackDepth;
 #endif
 				#if ( INCLUDE_vTaskSuspend == 1 )
 				{
@@ -3236,6 +3257,12 @@ TCB_t *pxNewTCB;
 				}
 				#endif
 
+				#if ( configDEBUG_RTSTAT_EN == 1 )
+				{
+					pxTaskStatusArray[ uxTask ].xRtStat = pxNextTCB->xRtStat;
+				}
+				#endif
+
 				#if ( portSTACK_GROWTH > 0 )
 				{
 					pxTaskStatusArray[ uxTask ].usStackHighWaterMark = prvTaskCheckFreeStackSpace( ( uint8_t * ) pxNextTCB->pxEndOfStack );
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/FreeRTOS/os_rtstat.h"
+#include "task.h"
+#include "driver/chip/hal_timer.h"
+#include "driver/chip/hal_clock.h"
+#include "os_util.h"
+
+#if (configDEBUG_RTSTAT_EN == 1)
+
+/* free running counter, not available to others while started */
+#define OS_RTSTAT_TIMER_ID      TIMER0_ID
+#define OS_RTSTAT_TIMER_DIV     8   /* 3 MHz from a 24 MHz HFCLK, wraps in 23 minutes */
+
+static struct rtstat g_rtstat;
+static uint32_t g_rtstat_hz;
+static uint32_t g_rtstat_last;  /* counter value at the last read */
+static uint32_t g_rtstat_high;  /* upper word of the 64-bit counter */
+static volatile uint8_t g_rtstat_on;
+
+/*
+ * The timer counts down, its 32 bits are extended to 64 by counting the wraps
+ * seen between two reads. It is read on every kernel tick and critical section,
+ * far more often than it wraps. Called with the kernel interrupts masked.
+ */
+static __always_inline uint64_t rtstat_now(void)
+{
+	uint32_t now = ~HAL_TIMER_GetCurrentValue(OS_RTSTAT_TIMER_ID);
+
+	if (now < g_rtstat_last)
+		g_rtstat_high++;
+	g_rtstat_last = now;
+	return ((uint64_t)g_rtstat_high << 32) | now;
+}
+
+static uint64_t rtstat_ticks_to_us(uint64_t ticks)
+{
+	return ticks * 1000000 / g_rtstat_hz;
+}
+
+/*
+ * The hooks are called from the kernel with its interrupts masked.
+ */
+void vRtStatTaskReady(struct rtstat_task *pxTask)
+{
+	if (g_rtstat_on)
+		rtstat_task_ready(&g_rtstat, pxTask, rtstat_now());
+}
+
+void vRtStatTaskSwitchedOut(struct rtstat_task *pxTask, int xReady)
+{
+	if (g_rtstat_on)
+		rtstat_switch_out(&g_rtstat, pxTask, xReady, rtstat_now());
+}
+
+void vRtStatTaskSwitchedIn(struct rtstat_task *pxTask)
+{
+	if (g_rtstat_on)
+		rtstat_switch_in(&g_rtstat, pxTask);
+}
+
+void vRtStatCriticalEnter(void)
+{
+	if (g_rtstat_on)
+		rtstat_critical_enter(&g_rtstat, rtstat_now());
+}
+
+void vRtStatCriticalExit(void)
+{
+	if (g_rtstat_on)
+		rtstat_critical_exit(&g_rtstat, rtstat_now());
+}
+
+void vRtStatTick(void)
+{
+	if (g_rtstat_on)
+		rtstat_now();
+}
+
+/**
+ * @brief Start the run time statistic
+ *
+ * It takes TIMER0 as a free running counter, then counts the run time of the
+ * threads, how long they wait to run once ready and how long the kernel
+ * interrupts are masked. The figures start from zero.
+ *
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_RtStatStart(void)
+{
+	TIMER_InitParam param;
+
+	if (g_rtstat_on)
+		return OS_OK;
+
+	param.cfg = HAL_TIMER_MakeInitCfg(TIMER_MODE_REPEAT, TIMER_CLK_SRC_HFCLK,
+	                                  TIMER_CLK_PRESCALER_8);
+	param.period = 0xffffffffU;
+	param.isEnableIRQ = 0;
+	param.callback = NULL;
+	param.arg = NULL;
+	if (HAL_TIMER_Init(OS_RTSTAT_TIMER_ID, &param) != HAL_OK) {
+		OS_ERR("timer init failed\n");
+		return OS_FAIL;
+	}
+	HAL_TIMER_Start(OS_RTSTAT_TIMER_ID);
+	g_rtstat_hz = HAL_GetHFClock() / OS_RTSTAT_TIMER_DIV;
+
+	taskENTER_CRITICAL();
+	g_rtstat_last = 0;
+	g_rtstat_high = 0;
+	rtstat_reset(&g_rtstat, rtstat_now());
+	g_rtstat.current = NULL;
+	g_rtstat_on = 1;
+	taskEXIT_CRITICAL();
+	return OS_OK;
+}
+
+/**
+ * @brief Stop the run time statistic and release TIMER0
+ *
+ * The figures are kept until the next start.
+ */
+void OS_RtStatStop(void)
+{
+	if (!g_rtstat_on)
+		return;
+
+	taskENTER_CRITICAL();
+	g_rtstat_on = 0;
+	taskEXIT_CRITICAL();
+	HAL_TIMER_Stop(OS_RTSTAT_TIMER_ID);
+	HAL_TIMER_DeInit(OS_RTSTAT_TIMER_ID);
+}
+
+/**
+ * @brief Restart the run time statistic from zero
+ */
+void OS_RtStatReset(void)
+{
+	taskENTER_CRITICAL();
+	rtstat_reset(&g_rtstat, rtstat_now());
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Get the run time statistic of the threads
+ * @param[out] threads The threads' figures
+ * @param[in] num Size of threads
+ * @param[out] elapsed Time since the last reset (in microsecond), or NULL
+ * @return The number of threads filled in, at most num
+ */
+int OS_RtStatGetThreads(OS_RtStatThread_t *threads, int num, uint64_t *elapsed)
+{
+	TaskStatus_t *status;
+	TaskHandle_t current;
+	struct rtstat st;
+	struct rtstat_task task;
+	UBaseType_t taskNum, i;
+	uint64_t now;
+
+	taskNum = uxTaskGetNumberOfTasks();
+	status = OS_Malloc(taskNum * sizeof(TaskStatus_t));
+	if (status == NULL) {
+		OS_ERR("no mem\n");
+		return 0;
+	}
+
+	taskNum = uxTaskGetSystemState(status, taskNum, NULL);
+	current = xTaskGetCurrentTaskHandle();
+	taskENTER_CRITICAL();
+	now = rtstat_now();
+	st = g_rtstat;
+	taskEXIT_CRITICAL();
+
+	if (elapsed)
+		*elapsed = rtstat_ticks_to_us(now - st.reset_at);
+	for (i = 0; i < taskNum && i < num; ++i) {
+		rtstat_task_get(&st, &status[i].xRtStat, &task);
+		if (status[i].xHandle == current) /* not switched out yet */
+			task.run_time += now - st.switched_at;
+		OS_Memcpy(threads[i].name, status[i].pcTaskName, configMAX_TASK_NAME_LEN);
+		threads[i].name[configMAX_TASK_NAME_LEN - 1] = '\0';
+		threads[i].priority = status[i].uxCurrentPriority;
+		threads[i].runTime = rtstat_ticks_to_us(task.run_time);
+		threads[i].switches = task.switches;
+		threads[i].latencyMax = rtstat_ticks_to_us(task.latency_max);
+	}
+	OS_Free(status);
+	return i;
+}
+
+/**
+ * @brief Get a histogram of the run time statistic
+ * @param[in] type The histogram to get
+ * @param[out] hist The histogram, durations in microsecond
+ */
+void OS_RtStatGetHist(OS_RtStatHistType type, OS_RtStatHist_t *hist)
+{
+	struct rtstat_hist h;
+
+	taskENTER_CRITICAL();
+	h = (type == OS_RTSTAT_LATENCY) ? g_rtstat.latency : g_rtstat.critical;
+	taskEXIT_CRITICAL();
+
+	OS_Memcpy(hist->count, h.count, sizeof(hist->count));
+	hist->max = rtstat_ticks_to_us(h.max);
+	hist->sum = rtstat_ticks_to_us(h.sum);
+}
+
+/**
+ * @brief Get the lower bound of a histogram bucket
+ * @param[in] n The bucket, from 0 to OS_RTSTAT_HIST_NUM
+ * @return The lower bound, in microsecond
+ */
+uint32_t OS_RtStatHistBound(int n)
+{
+	return n == 0 ? 0 : rtstat_ticks_to_us(1ULL << n);
+}
+
+static void rtstat_show_hist(const char *name, OS_RtStatHistType type)
+{
+	OS_RtStatHist_t hist;
+	uint32_t num = 0;
+	int i;
+
+	OS_RtStatGetHist(type, &hist);
+	for (i = 0; i < OS_RTSTAT_HIST_NUM; ++i)
+		num += hist.count[i];
+	OS_LOG(1, "%s: %u, avg %u us, max %u us\n", name, num,
+	       num ? (uint32_t)(hist.sum / num) : 0, hist.max);
+	for (i = 0; i < OS_RTSTAT_HIST_NUM; ++i) {
+		if (hist.count[i] == 0)
+			continue;
+		if (i == OS_RTSTAT_HIST_NUM - 1)
+			OS_LOG(1, "  %7u us -          : %u\n", OS_RtStatHistBound(i), hist.count[i]);
+		else
+			OS_LOG(1, "  %7u us - %7u us: %u\n", OS_RtStatHistBound(i),
+			       OS_RtStatHistBound(i + 1), hist.count[i]);
+	}
+}
+
+/**
+ * @brief Print the run time statistic
+ */
+void OS_RtStatShow(void)
+{
+	OS_RtStatThread_t *threads;
+	uint64_t elapsed;
+	int num, i;
+
+	if (g_rtstat_hz == 0) {
+		OS_WRN("rtstat not started\n");
+		return;
+	}
+
+	num = uxTaskGetNumberOfTasks();
+	threads = OS_Malloc(num * sizeof(OS_RtStatThread_t));
+	if (threads == NULL) {
+		OS_ERR("no mem\n");
+		return;
+	}
+	num = OS_RtStatGetThreads(threads, num, &elapsed);
+
+	OS_LOG(1, "elapsed %u ms\n", (uint32_t)(elapsed / 1000));
+	OS_LOG(1, "%*sPri RunTime(ms) CPU   Switches LatMax(us)\n",
+	       -configMAX_TASK_NAME_LEN, "Name");
+	for (i = 0; i < num; ++i) {
+		OS_LOG(1, "%*.*s%-3u %-11u %3u.%u%% %-8u %u\n",
+		       -configMAX_TASK_NAME_LEN, configMAX_TASK_NAME_LEN,
+		       threads[i].name, threads[i].priority,
+		       (uint32_t)(threads[i].runTime / 1000),
+		       elapsed ? (uint32_t)(threads[i].runTime * 1000 / elapsed) / 10 : 0,
+		       elapsed ? (uint32_t)(threads[i].runTime * 1000 / elapsed) % 10 : 0,
+		       threads[i].switches, threads[i].latencyMax);
+	}
+	OS_Free(threads);
+
+	rtstat_show_hist("latency", OS_RTSTAT_LATENCY);
+	rtstat_show_hist("critical", OS_RTSTAT_CRITICAL);
+}
+
+#endif /* configDEBUG_RTSTAT_EN */
@@ -0,0 +1,152 @@
+/**
+ * @file os_stack_table.c
+ * @author XRADIO IOT WLAN Team
+ */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "kernel/os/FreeRTOS/os_stack_table.h"
+
+/**
+ * @brief Get the space never used of a stack growing down
+ * @param[in] bottom The lowest address of the stack, word aligned
+ * @param[in] size Size of the stack, in byte
+ * @return Bytes from the bottom still holding the fill pattern
+ */
+uint32_t stktab_scan(const void *bottom, uint32_t size)
+{
+	const uint32_t *p = bottom;
+	const uint32_t *end = p + size / sizeof(uint32_t);
+
+	while (p < end && *p == STKTAB_FILL_WORD)
+		p++;
+	return (uint32_t)(p - (const uint32_t *)bottom) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Fill a stack area with the pattern stktab_scan() looks for
+ * @param[in] bottom The lowest address to fill, word aligned
+ * @param[in] size Bytes to fill
+ */
+void stktab_fill(void *bottom, uint32_t size)
+{
+	uint32_t *p = bottom;
+	uint32_t *end = p + size / sizeof(uint32_t);
+
+	while (p < end)
+		*p++ = STKTAB_FILL_WORD;
+}
+
+/**
+ * @brief Initialize a table
+ * @param[in] t The table
+ * @param[in] entry Storage for max entries
+ * @param[in] max Number of entries, names past it are dropped
+ * @param[in] warn_pct Warn when less than this percent of a stack is free
+ */
+void stktab_init(struct stktab *t, struct stktab_entry *entry, uint16_t max,
+                 uint8_t warn_pct)
+{
+	memset(t, 0, sizeof(*t));
+	memset(entry, 0, max * sizeof(*entry));
+	t->entry = entry;
+	t->max = max;
+	t->warn_pct = warn_pct;
+}
+
+static struct stktab_entry *stktab_find(struct stktab *t, const char *name)
+{
+	struct stktab_entry *e;
+	uint16_t i;
+
+	for (i = 0; i < t->num; i++) {
+		if (strncmp(t->entry[i].name, name, STKTAB_NAME_LEN - 1) == 0)
+			return &t->entry[i];
+	}
+	if (t->num == t->max)
+		return NULL;
+
+	e = &t->entry[t->num++];
+	strncpy(e->name, name, STKTAB_NAME_LEN - 1);
+	e->min_free = UINT32_MAX;
+	return e;
+}
+
+/**
+ * @brief Merge a sample of a stack into the table
+ * @param[in] t The table
+ * @param[in] name Name of the thread, or of the stack
+ * @param[in] size Size of the stack, in byte
+ * @param[in] free Bytes never used, from stktab_scan() or the kernel
+ * @param[out] warn Set to 1 the first time the entry has less than warn_pct
+ *                  percent of its size free, 0 otherwise
+ * @return The entry, NULL if the table is full
+ */
+struct stktab_entry *stktab_update(struct stktab *t, const char *name,
+                                   uint32_t size, uint32_t free, int *warn)
+{
+	struct stktab_entry *e;
+
+	*warn = 0;
+	e = stktab_find(t, name);
+	if (e == NULL) {
+		t->dropped++;
+		return NULL;
+	}
+
+	if (free > size)
+		free = size;
+	e->size = size;
+	e->samples++;
+	if (free < e->min_free)
+		e->min_free = free;
+	if (size - free > e->used_max)
+		e->used_max = size - free;
+	if (!e->warned && (uint64_t)free * 100 < (uint64_t)size * t->warn_pct) {
+		e->warned = 1;
+		*warn = 1;
+	}
+	return e;
+}
+
+/**
+ * @brief Get the stack size recommended for an entry
+ * @return Size in byte, a multiple of STKTAB_ALIGN
+ */
+uint32_t stktab_recommend(const struct stktab_entry *e)
+{
+	uint32_t margin = e->used_max / 100 * STKTAB_MARGIN_PCT +
+	                  e->used_max % 100 * STKTAB_MARGIN_PCT / 100;
+
+	if (margin < STKTAB_MARGIN_MIN)
+		margin = STKTAB_MARGIN_MIN;
+	return (e->used_max + margin + STKTAB_ALIGN - 1) & ~(STKTAB_ALIGN - 1);
+}
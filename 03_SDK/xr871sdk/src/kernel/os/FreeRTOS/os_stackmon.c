@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/FreeRTOS/os_stackmon.h"
+#include "kernel/os/FreeRTOS/os_stack_table.h"
+#include "kernel/os/FreeRTOS/os_thread.h"
+#include "kernel/os/FreeRTOS/os_mutex.h"
+#include "kernel/os/FreeRTOS/os_semaphore.h"
+#include "sys/interrupt.h"
+#include "task.h"
+#include "os_util.h"
+
+#if (configDEBUG_STACKMON_EN == 1)
+
+#define OS_STACKMON_ENTRY_NUM           32  /* at most 32, see warnMask */
+#define OS_STACKMON_THREAD_STACK_SIZE   (1 * 1024)
+
+#ifdef configMSP_STACK_SIZE
+/* the interrupt stack is the top of RAM, the heap ends below it */
+extern uint8_t _estack[];
+#define OS_STACKMON_ISR_BOTTOM          (_estack - configMSP_STACK_SIZE)
+#endif
+
+struct os_stackmon {
+	struct stktab       tab;
+	struct stktab_entry entry[OS_STACKMON_ENTRY_NUM];
+	OS_Mutex_t          lock;       /* of tab */
+	OS_Thread_t         thread;
+	OS_Semaphore_t      wake;       /* cuts the sampling period short */
+	uint32_t            period;
+	volatile uint8_t    run;
+	uint8_t             isrFilled;
+};
+
+static struct os_stackmon g_stackmon;
+
+/*
+ * Nothing fills the interrupt stack at boot. Fill the part below the current
+ * MSP, unused while threads run, with the interrupts masked so that no
+ * handler is using it meanwhile. What was used before this is not seen.
+ */
+static void stackmon_fill_isr(void)
+{
+#ifdef OS_STACKMON_ISR_BOTTOM
+	unsigned long flags;
+	uint8_t *sp;
+
+	flags = arch_irq_save();
+	sp = (uint8_t *)__get_MSP();
+	if (sp > OS_STACKMON_ISR_BOTTOM && sp <= _estack)
+		stktab_fill(OS_STACKMON_ISR_BOTTOM, (sp - OS_STACKMON_ISR_BOTTOM) & ~3U);
+	arch_irq_restore(flags);
+	g_stackmon.isrFilled = 1;
+#endif
+}
+
+static void stackmon_task(void *arg)
+{
+	while (g_stackmon.run) {
+		OS_StackMonSample();
+		OS_SemaphoreWait(&g_stackmon.wake, g_stackmon.period);
+	}
+	OS_ThreadDelete(&g_stackmon.thread);
+}
+
+/**
+ * @brief Start sampling the stack usage of all the threads periodically
+ *
+ * The least free space seen is kept per thread name, including threads gone
+ * since, and the interrupt stack is kept as OS_STACKMON_ISR_NAME. A warning
+ * is printed once per name that has less than warnPercent of its stack free.
+ * The figures start from zero.
+ *
+ * @param[in] periodMS Sampling period, in millisecond
+ * @param[in] warnPercent Warning level, in percent of the stack size
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_StackMonStart(uint32_t periodMS, uint8_t warnPercent)
+{
+	if (OS_ThreadIsValid(&g_stackmon.thread))
+		return OS_OK;
+
+	if (!OS_MutexIsValid(&g_stackmon.lock) &&
+	    OS_MutexCreate(&g_stackmon.lock) != OS_OK) {
+		OS_ERR("mutex create failed\n");
+		return OS_FAIL;
+	}
+	if (OS_SemaphoreCreateBinary(&g_stackmon.wake) != OS_OK) {
+		OS_ERR("sem create failed\n");
+		return OS_FAIL;
+	}
+
+	OS_MutexLock(&g_stackmon.lock, OS_WAIT_FOREVER);
+	stktab_init(&g_stackmon.tab, g_stackmon.entry, OS_STACKMON_ENTRY_NUM,
+	            warnPercent);
+	stackmon_fill_isr();
+	OS_MutexUnlock(&g_stackmon.lock);
+
+	g_stackmon.period = periodMS;
+	g_stackmon.run = 1;
+	if (OS_ThreadCreate(&g_stackmon.thread, "stackmon", stackmon_task, NULL,
+	                    OS_PRIORITY_LOW, OS_STACKMON_THREAD_STACK_SIZE) != OS_OK) {
+		OS_ERR("thread create failed\n");
+		g_stackmon.run = 0;
+		OS_SemaphoreDelete(&g_stackmon.wake);
+		return OS_FAIL;
+	}
+	return OS_OK;
+}
+
+/**
+ * @brief Stop the periodic sampling
+ *
+ * The figures are kept until the next start.
+ */
+void OS_StackMonStop(void)
+{
+	if (!OS_ThreadIsValid(&g_stackmon.thread))
+		return;
+
+	g_stackmon.run = 0;
+	OS_SemaphoreRelease(&g_stackmon.wake);
+	while (OS_ThreadIsValid(&g_stackmon.thread))
+		OS_MSleep(1); /* wait for thread termination */
+	OS_SemaphoreDelete(&g_stackmon.wake);
+}
+
+/**
+ * @brief Sample the stack usage of all the threads now
+ */
+void OS_StackMonSample(void)
+{
+	TaskStatus_t *status;
+	struct stktab_entry *e;
+	UBaseType_t num, i;
+	uint32_t warnMask = 0;
+	int warn;
+
+	if (!OS_MutexIsValid(&g_stackmon.lock))
+		return;
+
+	num = uxTaskGetNumberOfTasks();
+	status = OS_Malloc(num * sizeof(TaskStatus_t));
+	if (status == NULL) {
+		OS_ERR("no mem\n");
+		return;
+	}
+
+	OS_MutexLock(&g_stackmon.lock, OS_WAIT_FOREVER);
+	/* keep the deleted tasks' names valid while they are copied */
+	vTaskSuspendAll();
+	num = uxTaskGetSystemState(status, num, NULL);
+	for (i = 0; i < num; ++i) {
+		e = stktab_update(&g_stackmon.tab, status[i].pcTaskName,
+		                  status[i].usStackDepth * sizeof(StackType_t),
+		                  status[i].usStackHighWaterMark * sizeof(StackType_t),
+		                  &warn);
+		if (warn)
+			warnMask |= 1U << (e - g_stackmon.entry);
+	}
+	xTaskResumeAll();
+
+#ifdef OS_STACKMON_ISR_BOTTOM
+	if (g_stackmon.isrFilled) {
+		e = stktab_update(&g_stackmon.tab, OS_STACKMON_ISR_NAME, configMSP_STACK_SIZE,
+		                  stktab_scan(OS_STACKMON_ISR_BOTTOM, configMSP_STACK_SIZE),
+		                  &warn);
+		if (warn)
+			warnMask |= 1U << (e - g_stackmon.entry);
+	}
+#endif
+
+	for (i = 0; warnMask; ++i, warnMask >>= 1) {
+		if (warnMask & 1) {
+			e = &g_stackmon.entry[i];
+			OS_WRN("stack %s: %u of %u bytes free\n", e->name,
+			       e->min_free, e->size);
+		}
+	}
+	OS_MutexUnlock(&g_stackmon.lock);
+	OS_Free(status);
+}
+
+/**
+ * @brief Get the stack usage figures
+ * @param[out] entries The figures, one per thread name
+ * @param[in] num Size of entries
+ * @return The number of entries filled in, at most num
+ */
+int OS_StackMonGet(OS_StackMonEntry_t *entries, int num)
+{
+	struct stktab_entry *e;
+	int i;
+
+	if (!OS_MutexIsValid(&g_stackmon.lock))
+		return 0;
+
+	OS_MutexLock(&g_stackmon.lock, OS_WAIT_FOREVER);
+	for (i = 0; i < g_stackmon.tab.num && i < num; ++i) {
+		e = &g_stackmon.entry[i];
+		OS_Memcpy(entries[i].name, e->name, configMAX_TASK_NAME_LEN);
+		entries[i].name[configMAX_TASK_NAME_LEN - 1] = '\0';
+		entries[i].size = e->size;
+		entries[i].minFree = e->min_free;
+		entries[i].usedMax = e->used_max;
+		entries[i].recommend = stktab_recommend(e);
+		entries[i].samples = e->samples;
+	}
+	OS_MutexUnlock(&g_stackmon.lock);
+	return i;
+}
+
+/**
+ * @brief Print the stack usage and the recommended stack sizes
+ */
+void OS_StackMonShow(void)
+{
+	OS_StackMonEntry_t *entries;
+	int32_t saved = 0;
+	int num, i;
+
+	if (!OS_MutexIsValid(&g_stackmon.lock)) {
+		OS_WRN("stackmon not started\n");
+		return;
+	}
+
+	entries = OS_Malloc(OS_STACKMON_ENTRY_NUM * sizeof(OS_StackMonEntry_t));
+	if (entries == NULL) {
+		OS_ERR("no mem\n");
+		return;
+	}
+	num = OS_StackMonGet(entries, OS_STACKMON_ENTRY_NUM);
+
+	OS_LOG(1, "%*sSize   MinFree UsedMax Recommend Samples\n",
+	       -configMAX_TASK_NAME_LEN, "Name");
+	for (i = 0; i < num; ++i) {
+		OS_LOG(1, "%*.*s%-6u %-7u %-7u %-9u %u%s\n",
+		       -configMAX_TASK_NAME_LEN, configMAX_TASK_NAME_LEN,
+		       entries[i].name, entries[i].size, entries[i].minFree,
+		       entries[i].usedMax, entries[i].recommend, entries[i].samples,
+		       entries[i].recommend > entries[i].size ? " (grow)" : "");
+		saved += (int32_t)entries[i].size - (int32_t)entries[i].recommend;
+	}
+	OS_LOG(1, "%d bytes saved at the recommended sizes", (int)saved);
+	if (g_stackmon.tab.dropped)
+		OS_LOG(1, ", %u samples of names not kept", g_stackmon.tab.dropped);
+	OS_LOG(1, "\n");
+	OS_Free(entries);
+}
+
+#endif /* configDEBUG_STACKMON_EN */
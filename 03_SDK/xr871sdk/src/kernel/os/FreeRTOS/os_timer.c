@@ -35,6 +35,396 @@
 #include "kernel/os/FreeRTOS/os_timer.h"
 #include "os_util.h"
 
+#if OS_TIMER_USE_WHEEL
+
+#include "kernel/os/FreeRTOS/os_thread.h"
+#include "kernel/os/FreeRTOS/os_semaphore.h"
+
+/* as the FreeRTOS timer task, the callbacks run one at a time in the thread */
+#define OS_TIMER_THREAD_PRIO	OS_PRIORITY_REAL_TIME
+#define OS_TIMER_THREAD_STACK	(configTIMER_TASK_STACK_DEPTH * sizeof(StackType_t))
+
+/* a callback running longer counts as an overrun */
+#define OS_TIMER_BUDGET_MS		1
+
+/* the wheel timer is the caller's, a flag the wheel leaves alone */
+#define OS_TIMER_FLAG_STATIC	(1U << 7)
+
+/*
+ * The wheel is changed in critical sections, from threads and ISRs alike, so
+ * starting and stopping a timer never waits nor fails. The thread sleeps
+ * until the first expiry and is woken when an earlier one is filed.
+ */
+static struct {
+	struct twheel       wheel;
+	OS_Thread_t         thread;
+	OS_Semaphore_t      wake;
+	OS_Time_t           wakeAt;     /* the tick the thread sleeps until */
+	uint8_t             sleeping;
+	struct twheel_timer *free;      /* of the pool, linked by next */
+} g_os_timer;
+
+static struct twheel_timer g_os_timer_pool[OS_TIMER_POOL_NUM];
+
+static __always_inline UBaseType_t OS_TimerLock(void)
+{
+	if (OS_IsISRContext())
+		return taskENTER_CRITICAL_FROM_ISR();
+	taskENTER_CRITICAL();
+	return 0;
+}
+
+static __always_inline void OS_TimerUnlock(UBaseType_t flags)
+{
+	if (OS_IsISRContext())
+		taskEXIT_CRITICAL_FROM_ISR(flags);
+	else
+		taskEXIT_CRITICAL();
+}
+
+static __always_inline OS_Time_t OS_TimerGetTicks(void)
+{
+	return OS_IsISRContext() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+}
+
+static uint32_t OS_TimerTicks(OS_Time_t periodMS)
+{
+	uint32_t ticks = OS_MSecsToTicks(periodMS);
+
+	if (ticks == 0)
+		return 1;
+	if (ticks > TWHEEL_MAX_DELAY)
+		return TWHEEL_MAX_DELAY;
+	return ticks;
+}
+
+static void OS_TimerThread(void *arg)
+{
+	struct twheel_timer *t;
+	twheel_func_t func = NULL;
+	void *funcArg = NULL;
+	OS_Time_t now, next;
+	TickType_t wait = 0;
+
+	while (1) {
+		taskENTER_CRITICAL();
+		g_os_timer.sleeping = 0;
+		now = OS_GetTicks();
+		t = twheel_expire(&g_os_timer.wheel, now);
+		if (t != NULL) {
+			/* the timer may be deleted as soon as the lock is dropped */
+			func = t->func;
+			funcArg = t->arg;
+		} else if (twheel_next(&g_os_timer.wheel, &next)) {
+			g_os_timer.sleeping = 1;
+			g_os_timer.wakeAt = next;
+			wait = OS_TimeAfter(next, now) ? next - now : 0;
+		} else {
+			g_os_timer.sleeping = 1;
+			g_os_timer.wakeAt = now + TWHEEL_MAX_DELAY;
+			wait = portMAX_DELAY;
+		}
+		taskEXIT_CRITICAL();
+
+		if (t == NULL) {
+			if (wait)
+				xSemaphoreTake(g_os_timer.wake.handle, wait);
+			continue;
+		}
+
+		func(funcArg);
+
+		next = OS_GetTicks();
+		taskENTER_CRITICAL();
+		twheel_ran(&g_os_timer.wheel, next - now);
+		taskEXIT_CRITICAL();
+	}
+}
+
+static OS_Status OS_TimerInit(void)
+{
+	OS_Status ret = OS_OK;
+	int i;
+
+	if (OS_ThreadIsValid(&g_os_timer.thread))
+		return OS_OK;
+
+	vTaskSuspendAll();
+	if (!OS_ThreadIsValid(&g_os_timer.thread)) {
+		twheel_init(&g_os_timer.wheel, OS_GetTicks(),
+		            OS_MSecsToTicks(OS_TIMER_BUDGET_MS));
+		for (i = 0; i < OS_TIMER_POOL_NUM; i++) {
+			g_os_timer_pool[i].next = g_os_timer.free;
+			g_os_timer.free = &g_os_timer_pool[i];
+		}
+		ret = OS_SemaphoreCreateBinary(&g_os_timer.wake);
+		if (ret == OS_OK) {
+			ret = OS_ThreadCreate(&g_os_timer.thread, "os_timer",
+			                      OS_TimerThread, NULL,
+			                      OS_TIMER_THREAD_PRIO, OS_TIMER_THREAD_STACK);
+			if (ret != OS_OK)
+				OS_SemaphoreDelete(&g_os_timer.wake);
+		}
+	}
+	xTaskResumeAll();
+	return ret;
+}
+
+static struct twheel_timer *OS_TimerAlloc(void)
+{
+	struct twheel_timer *t;
+
+	taskENTER_CRITICAL();
+	t = g_os_timer.free;
+	if (t != NULL)
+		g_os_timer.free = t->next;
+	taskEXIT_CRITICAL();
+
+	if (t == NULL)
+		t = OS_Malloc(sizeof(*t));
+	return t;
+}
+
+static void OS_TimerFree(struct twheel_timer *t)
+{
+	if (t->flags & OS_TIMER_FLAG_STATIC)
+		return;
+
+	if (t < g_os_timer_pool || t >= g_os_timer_pool + OS_TIMER_POOL_NUM) {
+		OS_Free(t);
+		return;
+	}
+
+	taskENTER_CRITICAL();
+	t->next = g_os_timer.free;
+	g_os_timer.free = t;
+	taskEXIT_CRITICAL();
+}
+
+/* file a timer for its period from now, waking the thread if it is the first */
+static void OS_TimerArm(struct twheel_timer *t, int setPeriod, uint32_t period)
+{
+	UBaseType_t flags;
+	int wake = 0;
+
+	flags = OS_TimerLock();
+	if (setPeriod)
+		t->period = period;
+	twheel_add(&g_os_timer.wheel, t, OS_TimerGetTicks() + t->period);
+	if (g_os_timer.sleeping && OS_TimeBefore(t->expires, g_os_timer.wakeAt)) {
+		g_os_timer.sleeping = 0;
+		wake = 1;
+	}
+	OS_TimerUnlock(flags);
+
+	if (wake)
+		OS_SemaphoreRelease(&g_os_timer.wake);
+}
+
+static void OS_TimerSetup(OS_Timer_t *timer, struct twheel_timer *t,
+                          OS_TimerType type, OS_TimerCallback_t cb, void *arg,
+                          uint32_t periodMS, uint8_t flags)
+{
+	if (type == OS_TIMER_PERIODIC)
+		flags |= TWHEEL_PERIODIC;
+	twheel_timer_init(t, cb, arg, OS_TimerTicks(periodMS), flags);
+	timer->handle = t;
+}
+
+/**
+ * @brief Create and initialize a timer object
+ *
+ * @note Creating a timer does not start the timer running. The OS_TimerStart()
+ *       and OS_TimerChangePeriod() API functions can all be used to start the
+ *       timer running.
+ * @note Periods are limited to TWHEEL_MAX_DELAY ticks.
+ * @note The wheel timer comes from a pool of OS_TIMER_POOL_NUM, or from the
+ *       heap once the pool is used up, see OS_TimerCreateStatic() for none.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] type Timer type
+ * @param[in] cb Timer expire callback function
+ * @param[in] arg Argument of timer expire callback function
+ * @param[in] periodMS Timer period in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerCreate(OS_Timer_t *timer, OS_TimerType type,
+                         OS_TimerCallback_t cb, void *arg, uint32_t periodMS)
+{
+	struct twheel_timer *t;
+	OS_Status ret;
+
+	OS_HANDLE_ASSERT(!OS_TimerIsValid(timer), timer->handle);
+
+	ret = OS_TimerInit();
+	if (ret != OS_OK) {
+		OS_ERR("err %d\n", ret);
+		return ret;
+	}
+
+	t = OS_TimerAlloc();
+	if (t == NULL)
+		return OS_E_NOMEM;
+
+	OS_TimerSetup(timer, t, type, cb, arg, periodMS, 0);
+	return OS_OK;
+}
+
+/**
+ * @brief Create and initialize a timer object in the caller's storage
+ *
+ * As OS_TimerCreate(), without taking a wheel timer from the pool or the heap.
+ * The storage must stay valid until the timer is deleted.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] storage Wheel timer to use
+ * @param[in] type Timer type
+ * @param[in] cb Timer expire callback function
+ * @param[in] arg Argument of timer expire callback function
+ * @param[in] periodMS Timer period in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerCreateStatic(OS_Timer_t *timer, struct twheel_timer *storage,
+                               OS_TimerType type, OS_TimerCallback_t cb,
+                               void *arg, uint32_t periodMS)
+{
+	OS_Status ret;
+
+	OS_HANDLE_ASSERT(!OS_TimerIsValid(timer), timer->handle);
+
+	ret = OS_TimerInit();
+	if (ret != OS_OK) {
+		OS_ERR("err %d\n", ret);
+		return ret;
+	}
+
+	OS_TimerSetup(timer, storage, type, cb, arg, periodMS, OS_TIMER_FLAG_STATIC);
+	return OS_OK;
+}
+
+/**
+ * @brief Delete the timer object
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerDelete(OS_Timer_t *timer)
+{
+	UBaseType_t flags;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	flags = OS_TimerLock();
+	twheel_del(&g_os_timer.wheel, timer->handle);
+	OS_TimerUnlock(flags);
+
+	OS_TimerFree(timer->handle);
+	OS_TimerSetInvalid(timer);
+	return OS_OK;
+}
+
+/**
+ * @brief Start a timer running.
+ * @note If the timer is already running, this function will re-start the timer.
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerStart(OS_Timer_t *timer)
+{
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	OS_TimerArm(timer->handle, 0, 0);
+	return OS_OK;
+}
+
+/**
+ * @brief Change the period of a timer
+ *
+ * If OS_TimerChangePeriod() is used to change the period of a timer that is
+ * already running, then the timer will use the new period value to recalculate
+ * its expiry time. The recalculated expiry time will then be relative to when
+ * OS_TimerChangePeriod() was called, and not relative to when the timer was
+ * originally started.
+
+ * If OS_TimerChangePeriod() is used to change the period of a timer that is
+ * not already running, then the timer will use the new period value to
+ * calculate an expiry time, and the timer will start running.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] periodMS New timer period in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerChangePeriod(OS_Timer_t *timer, uint32_t periodMS)
+{
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	OS_TimerArm(timer->handle, 1, OS_TimerTicks(periodMS));
+	return OS_OK;
+}
+
+/**
+ * @brief Stop a timer running.
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerStop(OS_Timer_t *timer)
+{
+	UBaseType_t flags;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	flags = OS_TimerLock();
+	twheel_del(&g_os_timer.wheel, timer->handle);
+	OS_TimerUnlock(flags);
+	return OS_OK;
+}
+
+/**
+ * @brief Set how late a timer may expire
+ *
+ * A timer with some slack expires at the time in its slack shared with the
+ * most other timers, so that they are served by one wakeup of the system.
+ * It applies from the next start of the timer.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] slackMS Time the timer may expire late by, in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerSetSlack(OS_Timer_t *timer, OS_Time_t slackMS)
+{
+	UBaseType_t flags;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	flags = OS_TimerLock();
+	timer->handle->slack = OS_MSecsToTicks(slackMS);
+	OS_TimerUnlock(flags);
+	return OS_OK;
+}
+
+/**
+ * @brief Get the statistics of the timers
+ * @param[out] stats Pointer to the statistics
+ * @return None
+ */
+void OS_TimerGetStats(OS_TimerStats_t *stats)
+{
+	struct twheel_stats st;
+	UBaseType_t flags;
+
+	flags = OS_TimerLock();
+	st = g_os_timer.wheel.stats;
+	OS_TimerUnlock(flags);
+
+	stats->fired = st.fired;
+	stats->late = st.late;
+	stats->lateMaxMS = OS_TicksToMSecs(st.late_max);
+	stats->missed = st.missed;
+	stats->overruns = st.overruns;
+	stats->runMaxMS = OS_TicksToMSecs(st.run_max);
+}
+
+#else /* OS_TIMER_USE_WHEEL */
+
 
 /* TODO: what block time should be used ? */
 #define OS_TIMER_WAIT_FOREVER	portMAX_DELAY
@@ -260,3 +650,5 @@ OS_Status OS_TimerStop(OS_Timer_t *timer)
 
 	return OS_OK;
 }
+
+#endif /* OS_TIMER_USE_WHEEL */
@@ -0,0 +1,358 @@
+/**
+ * @file os_timer_wheel.c
+ * @author XRADIO IOT WLAN Team
+ */
+
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "kernel/os/FreeRTOS/os_timer_wheel.h"
+
+#define TWHEEL_BEFORE(a, b)     ((int32_t)((a) - (b)) < 0)
+#define TWHEEL_SLOT_NUM         (TWHEEL_LVL_NUM * TWHEEL_LVL_SIZE)
+#define TWHEEL_NONE             TWHEEL_LVL_SIZE
+
+static __inline void twheel_map_set(uint32_t *map, uint32_t idx)
+{
+	map[idx >> 5] |= 1U << (idx & 31);
+}
+
+static __inline void twheel_map_clr(uint32_t *map, uint32_t idx)
+{
+	map[idx >> 5] &= ~(1U << (idx & 31));
+}
+
+/* distance from a slot to the first used one at or after it, going round */
+static uint32_t twheel_map_find(const uint32_t *map, uint32_t from)
+{
+	uint32_t i, n, bits;
+
+	for (i = 0; i <= TWHEEL_MAP_WORDS; i++) {
+		n = ((from >> 5) + i) % TWHEEL_MAP_WORDS;
+		bits = map[n];
+		if (i == 0)
+			bits &= ~0U << (from & 31);
+		else if (i == TWHEEL_MAP_WORDS)
+			bits &= ~(~0U << (from & 31));
+		if (bits)
+			return ((n << 5) + __builtin_ctz(bits) - from) & TWHEEL_LVL_MASK;
+	}
+	return TWHEEL_NONE;
+}
+
+/* the tick in [due, due + slack] with the most low zero bits, so that timers
+ * with some slack end up sharing ticks */
+static uint32_t twheel_apply_slack(uint32_t due, uint32_t slack)
+{
+	uint32_t limit = due + slack;
+	uint32_t mask = due ^ limit;
+
+	if (mask == 0)
+		return due;
+	mask = (1U << (31 - __builtin_clz(mask))) - 1;
+	return limit & ~mask;
+}
+
+static void twheel_link(struct twheel_timer **head, struct twheel_timer *t)
+{
+	t->next = *head;
+	if (t->next)
+		t->next->pprev = &t->next;
+	*head = t;
+	t->pprev = head;
+}
+
+static void twheel_unlink(struct twheel *w, struct twheel_timer *t)
+{
+	struct twheel_timer **pprev = t->pprev;
+	uint32_t n;
+
+	*pprev = t->next;
+	if (t->next)
+		t->next->pprev = pprev;
+
+	/* the last one out of a slot clears its bit */
+	n = (uint32_t)(pprev - &w->slot[0][0]);
+	if (pprev >= &w->slot[0][0] && n < TWHEEL_SLOT_NUM && *pprev == NULL)
+		twheel_map_clr(w->map[n / TWHEEL_LVL_SIZE], n % TWHEEL_LVL_SIZE);
+
+	t->next = NULL;
+	t->pprev = NULL;
+}
+
+static void twheel_file(struct twheel *w, struct twheel_timer *t)
+{
+	uint32_t expires = t->expires;
+	uint32_t delta = expires - w->clk;
+	uint32_t idx;
+	int lvl;
+
+	if ((int32_t)delta < 0) {
+		/* a tick passed already, expired right away */
+		twheel_link(&w->expired, t);
+		return;
+	} else if (delta >= TWHEEL_SPAN) {
+		/* the top slots are refiled when reached */
+		delta = TWHEEL_SPAN - 1;
+		expires = w->clk + delta;
+	}
+
+	for (lvl = 0; lvl < TWHEEL_LVL_NUM - 1; lvl++) {
+		if (delta < (1U << ((lvl + 1) * TWHEEL_LVL_BITS)))
+			break;
+	}
+	idx = (expires >> (lvl * TWHEEL_LVL_BITS)) & TWHEEL_LVL_MASK;
+	twheel_link(&w->slot[lvl][idx], t);
+	twheel_map_set(w->map[lvl], idx);
+}
+
+/*
+ * The first used slot of a level and the tick the wheel reaches it at. A
+ * slot of an upper level is reached at its first tick, when it is moved down,
+ * the current one has been moved already unless the wheel is at its start.
+ */
+static int twheel_lvl_next(struct twheel *w, int lvl, uint32_t *tick)
+{
+	uint32_t shift = lvl * TWHEEL_LVL_BITS;
+	uint32_t cur = (w->clk >> shift) & TWHEEL_LVL_MASK;
+	uint32_t skip = (w->clk & ((1U << shift) - 1)) ? 1 : 0;
+	uint32_t d;
+
+	d = twheel_map_find(w->map[lvl], (cur + skip) & TWHEEL_LVL_MASK);
+	if (d == TWHEEL_NONE)
+		return -1;
+	d += skip;
+	*tick = ((w->clk >> shift) + d) << shift;
+	return (cur + d) & TWHEEL_LVL_MASK;
+}
+
+static void twheel_cascade(struct twheel *w, int lvl)
+{
+	uint32_t idx = (w->clk >> (lvl * TWHEEL_LVL_BITS)) & TWHEEL_LVL_MASK;
+	struct twheel_timer *t, *next;
+
+	t = w->slot[lvl][idx];
+	w->slot[lvl][idx] = NULL;
+	twheel_map_clr(w->map[lvl], idx);
+	for (; t != NULL; t = next) {
+		next = t->next;
+		twheel_file(w, t);
+	}
+}
+
+/* process the tick the wheel is at and move to the next one */
+static void twheel_tick(struct twheel *w)
+{
+	uint32_t idx;
+	int lvl;
+
+	for (lvl = 1; lvl < TWHEEL_LVL_NUM; lvl++) {
+		if (w->clk & ((1U << (lvl * TWHEEL_LVL_BITS)) - 1))
+			break;
+		twheel_cascade(w, lvl);
+	}
+
+	idx = w->clk & TWHEEL_LVL_MASK;
+	if (w->slot[0][idx] != NULL) {
+		w->expired = w->slot[0][idx];
+		w->expired->pprev = &w->expired;
+		w->slot[0][idx] = NULL;
+		twheel_map_clr(w->map[0], idx);
+	}
+	w->clk++;
+}
+
+/**
+ * @brief Initialize a timer wheel
+ * @param[in] w Pointer to the wheel
+ * @param[in] now Current tick
+ * @param[in] budget Ticks a callback may run before it counts as an overrun
+ * @return None
+ */
+void twheel_init(struct twheel *w, uint32_t now, uint32_t budget)
+{
+	memset(w, 0, sizeof(*w));
+	w->clk = now;
+	w->budget = budget;
+}
+
+/**
+ * @brief Initialize a timer
+ * @param[in] t Pointer to the timer
+ * @param[in] func Expire callback function, run by the caller of the wheel
+ * @param[in] arg Argument of the expire callback function
+ * @param[in] period Ticks between the reloads of a periodic timer
+ * @param[in] flags TWHEEL_PERIODIC or 0
+ * @return None
+ */
+void twheel_timer_init(struct twheel_timer *t, twheel_func_t func, void *arg,
+                       uint32_t period, uint8_t flags)
+{
+	memset(t, 0, sizeof(*t));
+	t->func = func;
+	t->arg = arg;
+	t->period = period;
+	t->flags = flags;
+}
+
+/**
+ * @brief File a timer for a tick, refiling it if pending
+ *
+ * The timer expires at the tick in [due, due + t->slack] shared with the most
+ * other timers. A timer for a tick the wheel has passed already expires at
+ * the next call of twheel_expire().
+ *
+ * @param[in] w Pointer to the wheel
+ * @param[in] t Pointer to the timer
+ * @param[in] due The tick, at most TWHEEL_MAX_DELAY ticks from now
+ * @return None
+ */
+void twheel_add(struct twheel *w, struct twheel_timer *t, uint32_t due)
+{
+	if (t->pprev != NULL)
+		twheel_unlink(w, t);
+	t->due = due;
+	t->expires = t->slack ? twheel_apply_slack(due, t->slack) : due;
+	twheel_file(w, t);
+}
+
+/**
+ * @brief Remove a timer from the wheel, if pending
+ * @param[in] w Pointer to the wheel
+ * @param[in] t Pointer to the timer
+ * @return None
+ */
+void twheel_del(struct twheel *w, struct twheel_timer *t)
+{
+	if (t->pprev != NULL)
+		twheel_unlink(w, t);
+}
+
+/**
+ * @brief Take the next timer expired up to a tick
+ *
+ * The timer is taken out of the wheel, and filed again for its next period if
+ * periodic, the caller runs its callback. Periods it is already late for are
+ * skipped, not caught up with.
+ *
+ * @param[in] w Pointer to the wheel
+ * @param[in] now Current tick
+ * @return The expired timer, NULL if none is left
+ */
+struct twheel_timer *twheel_expire(struct twheel *w, uint32_t now)
+{
+	struct twheel_timer *t;
+	uint32_t tick, next, late, n;
+	int lvl;
+
+	while (w->expired == NULL) {
+		if (TWHEEL_BEFORE(now, w->clk))
+			return NULL;
+
+		/* straight to the first tick up to now with something to do */
+		next = now + 1;
+		for (lvl = 0; lvl < TWHEEL_LVL_NUM; lvl++) {
+			if (twheel_lvl_next(w, lvl, &tick) >= 0 && TWHEEL_BEFORE(tick, next))
+				next = tick;
+		}
+		w->clk = next;
+		if (next == now + 1)
+			return NULL;
+		twheel_tick(w);
+	}
+
+	t = w->expired;
+	twheel_unlink(w, t);
+
+	w->stats.fired++;
+	late = now - t->due;
+	if ((int32_t)late > 0) {
+		if (late > t->slack)
+			w->stats.late++;
+		if (late > w->stats.late_max)
+			w->stats.late_max = late;
+	}
+
+	if (t->flags & TWHEEL_PERIODIC) {
+		next = t->due + t->period;
+		if (!TWHEEL_BEFORE(now, next)) {
+			n = (now - next) / t->period + 1;
+			next += n * t->period;
+			w->stats.missed += n;
+		}
+		twheel_add(w, t, next);
+	}
+	return t;
+}
+
+/**
+ * @brief Get the tick the first pending timer expires at
+ * @param[in] w Pointer to the wheel
+ * @param[out] expires The tick, may be in the past
+ * @return 1 if a timer is pending, 0 if none
+ */
+int twheel_next(struct twheel *w, uint32_t *expires)
+{
+	struct twheel_timer *t;
+	uint32_t tick;
+	int lvl, idx, found = 0;
+
+	/* the expired ones, then the first used slot of each level, holding its
+	 * earliest timers */
+	t = w->expired;
+	for (lvl = -1; lvl < TWHEEL_LVL_NUM; lvl++) {
+		if (lvl >= 0) {
+			idx = twheel_lvl_next(w, lvl, &tick);
+			if (idx < 0)
+				continue;
+			t = w->slot[lvl][idx];
+		}
+		for (; t != NULL; t = t->next) {
+			if (!found || TWHEEL_BEFORE(t->expires, *expires))
+				*expires = t->expires;
+			found = 1;
+		}
+	}
+	return found;
+}
+
+/**
+ * @brief Account a callback run
+ * @param[in] w Pointer to the wheel
+ * @param[in] ticks Ticks the callback ran for
+ * @return None
+ */
+void twheel_ran(struct twheel *w, uint32_t ticks)
+{
+	if (ticks > w->stats.run_max)
+		w->stats.run_max = ticks;
+	if (ticks > w->budget)
+		w->stats.overruns++;
+}
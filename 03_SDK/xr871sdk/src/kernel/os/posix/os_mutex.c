@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/posix/os_mutex.h"
+#include "os_util.h"
+
+struct OS_MutexCB {
+	pthread_mutex_t     lock;
+	pthread_cond_t      cond;
+	OS_ThreadHandle_t   owner;
+	uint32_t            count;      /* times locked by the owner */
+	uint8_t             recursive;
+};
+
+static OS_Status OS_MutexCreateCommon(OS_Mutex_t *mutex, uint8_t recursive)
+{
+	struct OS_MutexCB *cb;
+
+	OS_HANDLE_ASSERT(!OS_MutexIsValid(mutex), mutex->handle);
+
+	cb = OS_Malloc(sizeof(struct OS_MutexCB));
+	if (cb == NULL) {
+		OS_ERR("no mem\n");
+		return OS_E_NOMEM;
+	}
+
+	pthread_mutex_init(&cb->lock, NULL);
+	OS_CondInit(&cb->cond);
+	cb->owner = NULL;
+	cb->count = 0;
+	cb->recursive = recursive;
+	mutex->handle = cb;
+	return OS_OK;
+}
+
+static OS_Status OS_MutexLockCommon(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	struct OS_MutexCB *cb;
+	OS_ThreadHandle_t self;
+	struct timespec deadline;
+
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	cb = mutex->handle;
+	self = OS_ThreadGetCurrentHandle();
+	if (waitMS != 0 && waitMS != OS_WAIT_FOREVER)
+		OS_CalcDeadline(&deadline, waitMS);
+
+	pthread_mutex_lock(&cb->lock);
+	if (cb->recursive && cb->owner == self) {
+		cb->count++;
+		pthread_mutex_unlock(&cb->lock);
+		return OS_OK;
+	}
+
+	/* a normal mutex locked twice by its owner blocks, as on target */
+	while (cb->owner != NULL) {
+		if (OS_CondWait(&cb->cond, &cb->lock, waitMS, &deadline) == ETIMEDOUT &&
+		    cb->owner != NULL) {
+			pthread_mutex_unlock(&cb->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+	cb->owner = self;
+	cb->count = 1;
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
+
+static OS_Status OS_MutexUnlockCommon(OS_Mutex_t *mutex)
+{
+	struct OS_MutexCB *cb;
+
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	cb = mutex->handle;
+	pthread_mutex_lock(&cb->lock);
+	if (cb->owner != OS_ThreadGetCurrentHandle()) {
+		pthread_mutex_unlock(&cb->lock);
+		OS_DBG("%s() fail @ %d\n", __func__, __LINE__);
+		return OS_FAIL;
+	}
+	if (--cb->count == 0) {
+		cb->owner = NULL;
+		pthread_cond_signal(&cb->cond);
+	}
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
+
+/**
+ * @brief Create and initialize a mutex object
+ * @note A mutex can only be locked by a single thread at any given time.
+ * @param[in] mutex Pointer to the mutex object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	return OS_MutexCreateCommon(mutex, 0);
+}
+
+/**
+ * @brief Delete the mutex object
+ * @param[in] mutex Pointer to the mutex object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	struct OS_MutexCB *cb;
+
+	OS_HANDLE_ASSERT(OS_MutexIsValid(mutex), mutex->handle);
+
+	cb = mutex->handle;
+	pthread_cond_destroy(&cb->cond);
+	pthread_mutex_destroy(&cb->lock);
+	OS_Free(cb);
+	OS_MutexSetInvalid(mutex);
+	return OS_OK;
+}
+
+/**
+ * @brief Lock the mutex object
+ * @note A mutex can only be locked by a single thread at any given time. If
+ *       the mutex is already locked, the caller will be blocked for the
+ *       specified time duration.
+ * @param[in] mutex Pointer to the mutex object
+ * @param[in] waitMS The maximum amount of time (in millisecond) the thread
+ *                   should remain in the blocked state to wait for the mutex
+ *                   to become unlocked.
+ *                   OS_WAIT_FOREVER for waiting forever, zero for no waiting.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	return OS_MutexLockCommon(mutex, waitMS);
+}
+
+/**
+ * @brief Unlock the mutex object previously locked using OS_MutexLock()
+ * @note The mutex should be unlocked from the same thread context from which
+ *       it was locked.
+ * @param[in] mutex Pointer to the mutex object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	return OS_MutexUnlockCommon(mutex);
+}
+
+/**
+ * @brief Create and initialize a recursive mutex object
+ * @note A recursive mutex can be locked repeatedly by one single thread.
+ *       The mutex doesn't become available again until the owner has called
+ *       OS_RecursiveMutexUnlock() for each successful OS_RecursiveMutexLock().
+ * @param[in] mutex Pointer to the recursive mutex object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_RecursiveMutexCreate(OS_Mutex_t *mutex)
+{
+	return OS_MutexCreateCommon(mutex, 1);
+}
+
+/**
+ * @brief Lock the recursive mutex object
+ * @note A recursive mutex can be locked repeatedly by one single thread.
+ *       If the recursive mutex is already locked by other thread, the caller
+ *       will be blocked for the specified time duration.
+ * @param[in] mutex Pointer to the recursive mutex object
+ * @param[in] waitMS The maximum amount of time (in millisecond) the thread
+ *                   should remain in the blocked state to wait for the
+ *                   recursive mutex to become unlocked.
+ *                   OS_WAIT_FOREVER for waiting forever, zero for no waiting.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_RecursiveMutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	return OS_MutexLockCommon(mutex, waitMS);
+}
+
+/**
+ * @brief Unlock the recursive mutex object previously locked using
+ *        OS_RecursiveMutexLock()
+ * @note The recursive mutex should be unlocked from the same thread context
+ *       from which it was locked.
+ * @param[in] mutex Pointer to the mutex object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_RecursiveMutexUnlock(OS_Mutex_t *mutex)
+{
+	return OS_MutexUnlockCommon(mutex);
+}
+
+/**
+ * @brief Get the thread holding the mutex
+ * @param[in] mutex Pointer to the mutex object
+ * @return Handle of the owner thread, NULL if the mutex is not locked
+ */
+OS_ThreadHandle_t OS_MutexGetOwner(OS_Mutex_t *mutex)
+{
+	struct OS_MutexCB *cb = mutex->handle;
+	OS_ThreadHandle_t owner;
+
+	pthread_mutex_lock(&cb->lock);
+	owner = cb->owner;
+	pthread_mutex_unlock(&cb->lock);
+	return owner;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/posix/os_queue.h"
+#include "os_util.h"
+
+struct OS_QueueCB {
+	pthread_mutex_t lock;
+	pthread_cond_t  notEmpty;
+	pthread_cond_t  notFull;
+	uint32_t        queueLen;
+	uint32_t        itemSize;
+	uint32_t        count;
+	uint32_t        head;       /* index of the next item to receive */
+	uint8_t        *items;
+};
+
+/**
+ * @brief Create and initialize a queue object
+ * @param[in] queue Pointer to the queue object
+ * @param[in] queueLen The maximum number of items that the queue can hold at
+ *                     any one time.
+ * @param[in] itemSize The size, in bytes, of each data item that can be stored
+ *                     in the queue.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_QueueCreate(OS_Queue_t *queue, uint32_t queueLen, uint32_t itemSize)
+{
+	struct OS_QueueCB *cb;
+
+	if (queueLen == 0 || itemSize == 0) {
+		OS_ERR("len %u, size %u\n", queueLen, itemSize);
+		return OS_E_PARAM;
+	}
+
+	cb = OS_Malloc(sizeof(struct OS_QueueCB) + queueLen * itemSize);
+	if (cb == NULL) {
+		OS_ERR("no mem\n");
+		return OS_E_NOMEM;
+	}
+
+	pthread_mutex_init(&cb->lock, NULL);
+	OS_CondInit(&cb->notEmpty);
+	OS_CondInit(&cb->notFull);
+	cb->queueLen = queueLen;
+	cb->itemSize = itemSize;
+	cb->count = 0;
+	cb->head = 0;
+	cb->items = (uint8_t *)(cb + 1);
+	queue->handle = cb;
+	return OS_OK;
+}
+
+/**
+ * @brief Delete the queue object
+ * @param[in] queue Pointer to the queue object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_QueueDelete(OS_Queue_t *queue)
+{
+	struct OS_QueueCB *cb;
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	cb = queue->handle;
+	if (cb->count > 0) {
+		OS_ERR("queue %"OS_HANDLE_F" is not empty\n", queue->handle);
+		return OS_FAIL;
+	}
+
+	pthread_cond_destroy(&cb->notFull);
+	pthread_cond_destroy(&cb->notEmpty);
+	pthread_mutex_destroy(&cb->lock);
+	OS_Free(cb);
+	OS_QueueSetInvalid(queue);
+	return OS_OK;
+}
+
+/**
+ * @brief Send (write) an item to the back of the queue
+ * @param[in] queue Pointer to the queue object
+ * @param[in] item Pointer to the data to be copied into the queue.
+ *                 The size of each item the queue can hold is set when the
+ *                 queue is created, and that many bytes will be copied from
+ *                 item into the queue storage area.
+ * @param[in] waitMS The maximum amount of time the thread should remain in the
+ *                   blocked state to wait for space to become available on the
+ *                   queue, should the queue already be full.
+ *                   OS_WAIT_FOREVER for waiting forever, zero for no waiting.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_QueueSend(OS_Queue_t *queue, const void *item, OS_Time_t waitMS)
+{
+	struct OS_QueueCB *cb;
+	struct timespec deadline;
+	uint32_t tail;
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	cb = queue->handle;
+	if (waitMS != 0 && waitMS != OS_WAIT_FOREVER)
+		OS_CalcDeadline(&deadline, waitMS);
+
+	pthread_mutex_lock(&cb->lock);
+	while (cb->count == cb->queueLen) {
+		if (OS_CondWait(&cb->notFull, &cb->lock, waitMS, &deadline) == ETIMEDOUT &&
+		    cb->count == cb->queueLen) {
+			pthread_mutex_unlock(&cb->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+
+	tail = cb->head + cb->count;
+	if (tail >= cb->queueLen)
+		tail -= cb->queueLen;
+	OS_Memcpy(cb->items + tail * cb->itemSize, item, cb->itemSize);
+	cb->count++;
+	pthread_cond_signal(&cb->notEmpty);
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
+
+/**
+ * @brief Receive (read) an item from the queue
+ * @param[in] queue Pointer to the queue object
+ * @param[in] item Pointer to the memory into which the received item will be
+ *                 copied. The size of each item the queue can hold is set when
+ *                 the queue is created, and that many bytes will be copied
+ *                 from the queue storage area into item.
+ * @param[in] waitMS The maximum amount of time the thread should remain in the
+ *                   blocked state to wait for item to become available on the
+ *                   queue, should the queue already be empty.
+ *                   OS_WAIT_FOREVER for waiting forever, zero for no waiting.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_QueueReceive(OS_Queue_t *queue, void *item, OS_Time_t waitMS)
+{
+	struct OS_QueueCB *cb;
+	struct timespec deadline;
+
+	OS_HANDLE_ASSERT(OS_QueueIsValid(queue), queue->handle);
+
+	cb = queue->handle;
+	if (waitMS != 0 && waitMS != OS_WAIT_FOREVER)
+		OS_CalcDeadline(&deadline, waitMS);
+
+	pthread_mutex_lock(&cb->lock);
+	while (cb->count == 0) {
+		if (OS_CondWait(&cb->notEmpty, &cb->lock, waitMS, &deadline) == ETIMEDOUT &&
+		    cb->count == 0) {
+			pthread_mutex_unlock(&cb->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+
+	OS_Memcpy(item, cb->items + cb->head * cb->itemSize, cb->itemSize);
+	if (++cb->head == cb->queueLen)
+		cb->head = 0;
+	cb->count--;
+	pthread_cond_signal(&cb->notFull);
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
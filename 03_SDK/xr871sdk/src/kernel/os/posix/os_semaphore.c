@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/posix/os_semaphore.h"
+#include "os_util.h"
+
+struct OS_SemaphoreCB {
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+	uint32_t        count;
+	uint32_t        maxCount;
+};
+
+/**
+ * @brief Create and initialize a counting semaphore object
+ * @param[in] sem Pointer to the semaphore object
+ * @param[in] initCount The count value assigned to the semaphore when it is
+ *                      created.
+ * @param[in] maxCount The maximum count value that can be reached. When the
+ *                     semaphore reaches this value it can no longer be
+ *                     released.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_SemaphoreCreate(OS_Semaphore_t *sem, uint32_t initCount, uint32_t maxCount)
+{
+	struct OS_SemaphoreCB *cb;
+
+	if (maxCount == 0 || initCount > maxCount) {
+		OS_ERR("count %u, max %u\n", initCount, maxCount);
+		return OS_E_PARAM;
+	}
+
+	cb = OS_Malloc(sizeof(struct OS_SemaphoreCB));
+	if (cb == NULL) {
+		OS_ERR("no mem\n");
+		return OS_E_NOMEM;
+	}
+
+	pthread_mutex_init(&cb->lock, NULL);
+	OS_CondInit(&cb->cond);
+	cb->count = initCount;
+	cb->maxCount = maxCount;
+	sem->handle = cb;
+	return OS_OK;
+}
+
+/**
+ * @brief Create and initialize a binary semaphore object
+ * @note A binary semaphore is equal to a counting semaphore created by calling
+         OS_SemaphoreCreate(sem, 0, 1).
+ * @param[in] sem Pointer to the semaphore object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	return OS_SemaphoreCreate(sem, 0, 1);
+}
+
+/**
+ * @brief Delete the semaphore object
+ * @param[in] sem Pointer to the semaphore object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	struct OS_SemaphoreCB *cb;
+
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	cb = sem->handle;
+	pthread_cond_destroy(&cb->cond);
+	pthread_mutex_destroy(&cb->lock);
+	OS_Free(cb);
+	OS_SemaphoreSetInvalid(sem);
+	return OS_OK;
+}
+
+/**
+ * @brief Wait until the semaphore object becomes available
+ * @param[in] sem Pointer to the semaphore object
+ * @param[in] waitMS The maximum amount of time (in millisecond) the thread
+ *                   should remain in the blocked state to wait for the
+ *                   semaphore to become available.
+ *                   OS_WAIT_FOREVER for waiting forever, zero for no waiting.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	struct OS_SemaphoreCB *cb;
+	struct timespec deadline;
+
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	cb = sem->handle;
+	if (waitMS != 0 && waitMS != OS_WAIT_FOREVER)
+		OS_CalcDeadline(&deadline, waitMS);
+
+	pthread_mutex_lock(&cb->lock);
+	while (cb->count == 0) {
+		if (OS_CondWait(&cb->cond, &cb->lock, waitMS, &deadline) == ETIMEDOUT &&
+		    cb->count == 0) {
+			pthread_mutex_unlock(&cb->lock);
+			OS_DBG("%s() fail @ %d, %"OS_TIME_F" ms\n", __func__, __LINE__, waitMS);
+			return OS_E_TIMEOUT;
+		}
+	}
+	cb->count--;
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
+
+/**
+ * @brief Release the semaphore object
+ * @param[in] sem Pointer to the semaphore object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	struct OS_SemaphoreCB *cb;
+
+	OS_HANDLE_ASSERT(OS_SemaphoreIsValid(sem), sem->handle);
+
+	cb = sem->handle;
+	pthread_mutex_lock(&cb->lock);
+	if (cb->count >= cb->maxCount) {
+		pthread_mutex_unlock(&cb->lock);
+		OS_DBG("%s() fail @ %d\n", __func__, __LINE__);
+		return OS_FAIL;
+	}
+	cb->count++;
+	pthread_cond_signal(&cb->cond);
+	pthread_mutex_unlock(&cb->lock);
+
+	return OS_OK;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits.h>
+#include "kernel/os/posix/os_thread.h"
+#include "os_util.h"
+
+#define OS_THREAD_NAME_LEN	16
+
+struct OS_ThreadCB {
+	pthread_t           tid;
+	OS_ThreadEntry_t    entry;
+	void               *arg;
+	OS_Priority         priority;
+	uint32_t            stackSize;
+	char                name[OS_THREAD_NAME_LEN];
+	struct OS_ThreadCB *next;
+};
+
+/* the threads created by OS_ThreadCreate(), for OS_ThreadList() */
+static struct OS_ThreadCB *g_os_thread_list;
+static pthread_mutex_t g_os_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* the thread calling this module, a static one for threads not created here */
+static __thread struct OS_ThreadCB *g_os_thread_self;
+static __thread struct OS_ThreadCB g_os_thread_foreign;
+
+static pthread_mutex_t g_os_sched_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static void OS_ThreadListDel(struct OS_ThreadCB *cb)
+{
+	struct OS_ThreadCB **pcb;
+
+	pthread_mutex_lock(&g_os_thread_lock);
+	for (pcb = &g_os_thread_list; *pcb != NULL; pcb = &(*pcb)->next) {
+		if (*pcb == cb) {
+			*pcb = cb->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&g_os_thread_lock);
+}
+
+static void *OS_ThreadEntry(void *arg)
+{
+	struct OS_ThreadCB *cb = arg;
+
+	g_os_thread_self = cb;
+#ifdef __GLIBC__
+	/* here, the thread may be deleted before OS_ThreadCreate() returns */
+	pthread_setname_np(pthread_self(), cb->name);
+#endif
+	cb->entry(cb->arg);
+
+	/* returned without OS_ThreadDelete(), undefined on target */
+	OS_WRN("thread %s returned from entry\n", cb->name);
+	OS_ThreadListDel(cb);
+	OS_Free(cb);
+	return NULL;
+}
+
+/**
+ * @brief Create and start a thread
+ *
+ * This function starts a new thread. The new thread starts execution by
+ * invoking entry(). The argument arg is passed as the sole argument of entry().
+ *
+ * @note After finishing execution, the new thread should call OS_ThreadDelete()
+ *       to delete itself. Failing to do this and just returning from entry()
+ *       will result in undefined behavior.
+ * @note The priority is ignored, and the stack is at least
+ *       OS_THREAD_STACK_SIZE_MIN bytes.
+ *
+ * @param[in] thread Pointer to the thread object
+ * @param[in] name A descriptive name for the thread. This is mainly used to
+ *                 facilitate debugging.
+ * @param[in] entry Entry, which is a function pointer, to the thread function
+ * @param[in] arg The sole argument passed to entry()
+ * @param[in] priority The priority at which the thread will execute
+ * @param[in] stackSize The number of bytes the thread stack can hold
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                          OS_ThreadEntry_t entry, void *arg,
+                          OS_Priority priority, uint32_t stackSize)
+{
+	struct OS_ThreadCB *cb;
+	pthread_attr_t attr;
+	int ret;
+
+	OS_HANDLE_ASSERT(!OS_ThreadIsValid(thread), thread->handle);
+
+	cb = OS_Malloc(sizeof(struct OS_ThreadCB));
+	if (cb == NULL) {
+		OS_ERR("no mem\n");
+		return OS_E_NOMEM;
+	}
+	OS_Memset(cb, 0, sizeof(struct OS_ThreadCB));
+	cb->entry = entry;
+	cb->arg = arg;
+	cb->priority = priority;
+	cb->stackSize = stackSize;
+	if (name)
+		strncpy(cb->name, name, OS_THREAD_NAME_LEN - 1);
+
+	if (stackSize < OS_THREAD_STACK_SIZE_MIN)
+		stackSize = OS_THREAD_STACK_SIZE_MIN;
+	if (stackSize < PTHREAD_STACK_MIN)
+		stackSize = PTHREAD_STACK_MIN;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_attr_setstacksize(&attr, stackSize);
+
+	/* publish the handle before the thread may look at it */
+	thread->handle = cb;
+	pthread_mutex_lock(&g_os_thread_lock);
+	cb->next = g_os_thread_list;
+	g_os_thread_list = cb;
+	ret = pthread_create(&cb->tid, &attr, OS_ThreadEntry, cb);
+	pthread_mutex_unlock(&g_os_thread_lock);
+	pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		OS_ERR("err %d\n", ret);
+		OS_ThreadListDel(cb);
+		OS_Free(cb);
+		OS_ThreadSetInvalid(thread);
+		return OS_FAIL;
+	}
+	return OS_OK;
+}
+
+/**
+ * @brief Terminate the thread
+ * @note Deleting another thread cancels it, which is only safe if it is
+ *       blocked in the OS functions. Let threads delete themselves.
+ * @param[in] thread Pointer to the thread object to be deleted.
+ *                   A thread can delete itself by passing NULL in place of a
+ *                   valid thread object.
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	struct OS_ThreadCB *cb;
+	struct OS_ThreadCB *curCB;
+
+	curCB = OS_ThreadGetCurrentHandle();
+	if (thread == NULL) {
+		cb = curCB;
+	} else {
+		OS_HANDLE_ASSERT(OS_ThreadIsValid(thread), thread->handle);
+		cb = thread->handle;
+	}
+
+	if (cb == curCB) {
+		/* delete self */
+		if (thread)
+			OS_ThreadSetInvalid(thread);
+		if (cb != &g_os_thread_foreign) {
+			OS_ThreadListDel(cb);
+			OS_Free(cb);
+		}
+		pthread_exit(NULL);
+	} else {
+		/* delete other thread */
+		OS_WRN("thread %"OS_HANDLE_F" delete %"OS_HANDLE_F"\n", curCB, cb);
+		OS_ThreadListDel(cb);
+		pthread_cancel(cb->tid);
+		OS_Free(cb);
+		OS_ThreadSetInvalid(thread);
+	}
+
+	return OS_OK;
+}
+
+/**
+ * @brief Get the handle of the current thread
+ * @return Handle of the current thread
+ */
+OS_ThreadHandle_t OS_ThreadGetCurrentHandle(void)
+{
+	if (g_os_thread_self == NULL) {
+		g_os_thread_foreign.tid = pthread_self();
+		strcpy(g_os_thread_foreign.name, "host");
+		g_os_thread_self = &g_os_thread_foreign;
+	}
+	return g_os_thread_self;
+}
+
+/**
+ * @brief Start the scheduler, ie. end the calling thread and keep the
+ *        process running until all the OS threads are deleted
+ * @return None
+ */
+void OS_ThreadStartScheduler(void)
+{
+	pthread_exit(NULL);
+}
+
+void OS_ThreadSuspendScheduler(void)
+{
+	pthread_mutex_lock(&g_os_sched_lock);
+}
+
+void OS_ThreadResumeScheduler(void)
+{
+	pthread_mutex_unlock(&g_os_sched_lock);
+}
+
+void OS_ThreadList(void)
+{
+	struct OS_ThreadCB *cb;
+
+	OS_LOG(1, "%-*s Pri StkSize\n", OS_THREAD_NAME_LEN, "Name");
+	pthread_mutex_lock(&g_os_thread_lock);
+	for (cb = g_os_thread_list; cb != NULL; cb = cb->next) {
+		OS_LOG(1, "%-*s %-3d %u\n", OS_THREAD_NAME_LEN, cb->name,
+		       cb->priority, cb->stackSize);
+	}
+	pthread_mutex_unlock(&g_os_thread_lock);
+}
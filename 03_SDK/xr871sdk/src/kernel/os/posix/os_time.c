@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/posix/os_time.h"
+#include "os_util.h"
+
+static struct timespec g_os_start;
+static pthread_once_t g_os_start_once = PTHREAD_ONCE_INIT;
+
+static void OS_TimeInit(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &g_os_start);
+}
+
+/**
+ * @brief Get the number of ticks since the first call, ie. OS start
+ * @return The number of ticks, wraps around like the FreeRTOS tick count
+ */
+OS_Time_t OS_GetTicks(void)
+{
+	struct timespec now;
+	int64_t usec;
+
+	pthread_once(&g_os_start_once, OS_TimeInit);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	usec = (int64_t)(now.tv_sec - g_os_start.tv_sec) * OS_USEC_PER_SEC +
+	       (now.tv_nsec - g_os_start.tv_nsec) / 1000;
+	return (OS_Time_t)(usec / OS_TICK);
+}
+
+/**
+ * @brief Sleep for the given milliseconds
+ * @param[in] msec Milliseconds to sleep, zero just yields the CPU
+ * @return None
+ */
+void OS_MSleep(OS_Time_t msec)
+{
+	struct timespec ts;
+
+	if (msec == 0) {
+		sched_yield();
+		return;
+	}
+
+	ts.tv_sec = msec / OS_MSEC_PER_SEC;
+	ts.tv_nsec = (long)(msec % OS_MSEC_PER_SEC) * 1000000L;
+	while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+		;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "kernel/os/posix/os_timer.h"
+#include "kernel/os/posix/os_time.h"
+#include "os_util.h"
+
+struct OS_TimerCB {
+	struct OS_TimerCB  *next;       /* in the active list */
+	OS_TimerCallback_t  callback;
+	void               *argument;
+	OS_Time_t           period;     /* in ticks */
+	OS_Time_t           expiry;     /* in ticks */
+	uint8_t             type;
+	uint8_t             active;
+};
+
+/*
+ * The active timers sorted by expiry, served by one timer thread like the
+ * FreeRTOS timer task. A callback runs without the lock held, so it can
+ * start and stop timers, OS_TimerDelete() waits for a running callback
+ * unless it is called from the timer thread.
+ */
+static struct {
+	pthread_mutex_t     lock;
+	pthread_cond_t      cond;       /* the list head changed */
+	pthread_cond_t      done;       /* a callback returned */
+	struct OS_TimerCB  *list;
+	struct OS_TimerCB  *running;
+	pthread_t           tid;
+} g_os_timer = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+static pthread_once_t g_os_timer_once = PTHREAD_ONCE_INIT;
+
+static void OS_TimerListDel(struct OS_TimerCB *cb)
+{
+	struct OS_TimerCB **pcb;
+
+	for (pcb = &g_os_timer.list; *pcb != NULL; pcb = &(*pcb)->next) {
+		if (*pcb == cb) {
+			*pcb = cb->next;
+			break;
+		}
+	}
+	cb->active = 0;
+}
+
+static void OS_TimerListAdd(struct OS_TimerCB *cb)
+{
+	struct OS_TimerCB **pcb;
+
+	for (pcb = &g_os_timer.list; *pcb != NULL; pcb = &(*pcb)->next) {
+		if (OS_TimeBefore(cb->expiry, (*pcb)->expiry))
+			break;
+	}
+	cb->next = *pcb;
+	*pcb = cb;
+	cb->active = 1;
+	if (g_os_timer.list == cb)
+		pthread_cond_signal(&g_os_timer.cond);
+}
+
+static void *OS_TimerThread(void *arg)
+{
+	struct OS_TimerCB *cb;
+	struct timespec deadline;
+	OS_Time_t now;
+
+	pthread_mutex_lock(&g_os_timer.lock);
+	while (1) {
+		cb = g_os_timer.list;
+		if (cb == NULL) {
+			pthread_cond_wait(&g_os_timer.cond, &g_os_timer.lock);
+			continue;
+		}
+
+		now = OS_GetTicks();
+		if (OS_TimeBefore(now, cb->expiry)) {
+			OS_CalcDeadline(&deadline, OS_TicksToMSecs(cb->expiry - now));
+			pthread_cond_timedwait(&g_os_timer.cond, &g_os_timer.lock, &deadline);
+			continue;
+		}
+
+		OS_TimerListDel(cb);
+		if (cb->type == OS_TIMER_PERIODIC) {
+			/* reload from the expiry, not from now, to avoid drift */
+			cb->expiry += cb->period;
+			OS_TimerListAdd(cb);
+		}
+
+		g_os_timer.running = cb;
+		pthread_mutex_unlock(&g_os_timer.lock);
+		cb->callback(cb->argument);
+		pthread_mutex_lock(&g_os_timer.lock);
+		g_os_timer.running = NULL;
+		pthread_cond_broadcast(&g_os_timer.done);
+	}
+
+	return NULL;
+}
+
+static void OS_TimerInit(void)
+{
+	pthread_attr_t attr;
+
+	OS_CondInit(&g_os_timer.cond);
+	OS_CondInit(&g_os_timer.done);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (pthread_create(&g_os_timer.tid, &attr, OS_TimerThread, NULL) != 0)
+		OS_ERR("create timer thread failed\n");
+	pthread_attr_destroy(&attr);
+}
+
+/**
+ * @brief Create and initialize a timer object
+ *
+ * @note Creating a timer does not start the timer running. The OS_TimerStart()
+ *       and OS_TimerChangePeriod() API functions can all be used to start the
+ *       timer running.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] type Timer type
+ * @param[in] cb Timer expire callback function
+ * @param[in] arg Argument of Timer expire callback function
+ * @param[in] periodMS Timer period in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerCreate(OS_Timer_t *timer, OS_TimerType type,
+                         OS_TimerCallback_t cb, void *arg, OS_Time_t periodMS)
+{
+	struct OS_TimerCB *tcb;
+
+	OS_HANDLE_ASSERT(!OS_TimerIsValid(timer), timer->handle);
+
+	pthread_once(&g_os_timer_once, OS_TimerInit);
+
+	tcb = OS_Malloc(sizeof(struct OS_TimerCB));
+	if (tcb == NULL) {
+		return OS_E_NOMEM;
+	}
+
+	OS_Memset(tcb, 0, sizeof(struct OS_TimerCB));
+	tcb->callback = cb;
+	tcb->argument = arg;
+	tcb->type = type;
+	tcb->period = OS_MSecsToTicks(periodMS);
+	if (tcb->period == 0)
+		tcb->period = 1;
+	timer->handle = tcb;
+	return OS_OK;
+}
+
+/**
+ * @brief Delete the timer object
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerDelete(OS_Timer_t *timer)
+{
+	struct OS_TimerCB *tcb;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	tcb = timer->handle;
+	pthread_mutex_lock(&g_os_timer.lock);
+	if (tcb->active)
+		OS_TimerListDel(tcb);
+	if (!pthread_equal(pthread_self(), g_os_timer.tid)) {
+		while (g_os_timer.running == tcb)
+			pthread_cond_wait(&g_os_timer.done, &g_os_timer.lock);
+	}
+	pthread_mutex_unlock(&g_os_timer.lock);
+
+	OS_Free(tcb);
+	OS_TimerSetInvalid(timer);
+	return OS_OK;
+}
+
+/**
+ * @brief Start a timer running.
+ * @note If the timer is already running, this function will re-start the timer.
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerStart(OS_Timer_t *timer)
+{
+	struct OS_TimerCB *tcb;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	tcb = timer->handle;
+	pthread_mutex_lock(&g_os_timer.lock);
+	if (tcb->active)
+		OS_TimerListDel(tcb);
+	tcb->expiry = OS_GetTicks() + tcb->period;
+	OS_TimerListAdd(tcb);
+	pthread_mutex_unlock(&g_os_timer.lock);
+
+	return OS_OK;
+}
+
+/**
+ * @brief Change the period of a timer
+ *
+ * If OS_TimerChangePeriod() is used to change the period of a timer that is
+ * already running, then the timer will use the new period value to recalculate
+ * its expiry time. The recalculated expiry time will then be relative to when
+ * OS_TimerChangePeriod() was called, and not relative to when the timer was
+ * originally started.
+
+ * If OS_TimerChangePeriod() is used to change the period of a timer that is
+ * not already running, then the timer will use the new period value to
+ * calculate an expiry time, and the timer will start running.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @param[in] periodMS New timer period in milliseconds
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerChangePeriod(OS_Timer_t *timer, OS_Time_t periodMS)
+{
+	struct OS_TimerCB *tcb;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	tcb = timer->handle;
+	pthread_mutex_lock(&g_os_timer.lock);
+	tcb->period = OS_MSecsToTicks(periodMS);
+	if (tcb->period == 0)
+		tcb->period = 1;
+	pthread_mutex_unlock(&g_os_timer.lock);
+
+	return OS_TimerStart(timer);
+}
+
+/**
+ * @brief Stop a timer running.
+ * @param[in] timer Pointer to the timer object
+ * @retval OS_Status, OS_OK on success
+ */
+OS_Status OS_TimerStop(OS_Timer_t *timer)
+{
+	struct OS_TimerCB *tcb;
+
+	OS_HANDLE_ASSERT(OS_TimerIsValid(timer), timer->handle);
+
+	tcb = timer->handle;
+	pthread_mutex_lock(&g_os_timer.lock);
+	if (tcb->active)
+		OS_TimerListDel(tcb);
+	pthread_mutex_unlock(&g_os_timer.lock);
+
+	return OS_OK;
+}
+
+/**
+ * @brief Check whether the timer is active or not
+ *
+ * A timer is inactive when it is in one of the following cases:
+ *   - The timer has been created, but not started.
+ *   - The timer is a one shot timer that has not been restarted since it
+ *     expired.
+ *
+ * @param[in] timer Pointer to the timer object
+ * @return 1 on active, 0 on inactive
+ */
+int OS_TimerIsActive(OS_Timer_t *timer)
+{
+	struct OS_TimerCB *tcb = timer->handle;
+	int active;
+
+	pthread_mutex_lock(&g_os_timer.lock);
+	active = tcb->active;
+	pthread_mutex_unlock(&g_os_timer.lock);
+	return active;
+}
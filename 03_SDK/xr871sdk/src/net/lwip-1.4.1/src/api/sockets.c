@@ -835,7 +835,7 @@ lwip_send(int s, const void *data, size_t size, int flags)
 #endif /* (LWIP_UDP || LWIP_RAW || LWIP_PACKET) */
   }
 
-  write_flags = NETCONN_COPY |
+  write_flags = ((flags & MSG_NOCOPY)   ? NETCONN_NOCOPY    : NETCONN_COPY) |
     ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
     ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
   written = 0;
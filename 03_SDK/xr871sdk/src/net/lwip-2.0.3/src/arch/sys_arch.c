@@ -93,6 +93,32 @@ void sys_mutex_free(sys_mutex_t *mutex)
 }
 #endif /* LWIP_COMPAT_MUTEX */
 
+#if LWIP_TCPIP_CORE_LOCKING
+/*
+ * The core lock is a FreeRTOS mutex, whose priority inheritance keeps a low
+ * priority thread holding the core from being preempted by middle priority
+ * threads while the tcpip thread (or a high priority API caller) waits for
+ * it. The lock is not recursive, so lwIP functions MUST NOT be called through
+ * the socket/netconn/netifapi API from a callback run with the core locked.
+ */
+extern sys_mutex_t lock_tcpip_core;
+static OS_ThreadHandle_t s_tcpip_core_owner;
+
+void sys_lock_tcpip_core(void)
+{
+	LWIP_ASSERT("core lock is not recursive",
+	            s_tcpip_core_owner != OS_ThreadGetCurrentHandle());
+	OS_MutexLock(&lock_tcpip_core, OS_WAIT_FOREVER);
+	s_tcpip_core_owner = OS_ThreadGetCurrentHandle();
+}
+
+void sys_unlock_tcpip_core(void)
+{
+	s_tcpip_core_owner = NULL;
+	OS_MutexUnlock(&lock_tcpip_core);
+}
+#endif /* LWIP_TCPIP_CORE_LOCKING */
+
 /** Create a new semaphore
  * @param sem pointer to the semaphore to create
  * @param count initial count of the semaphore
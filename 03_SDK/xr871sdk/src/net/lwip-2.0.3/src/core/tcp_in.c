@@ -79,6 +79,12 @@ static u8_t flags;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_SACK_IN
+/* SACK blocks (left and right edges) of the incoming segment */
+static u32_t sack_blocks[2 * LWIP_TCP_SACK_MAX_IN];
+static u8_t sack_num;
+#endif /* LWIP_TCP_SACK_IN */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
@@ -1000,6 +1006,42 @@ tcp_oos_insert_segment(struct tcp_seg *cseg, struct tcp_seg *next)
 }
 #endif /* TCP_QUEUE_OOSEQ */
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Mark the unacked segments covered by the SACK blocks of the incoming
+ * segment. Only whole segments are marked, D-SACK blocks (RFC 2883) and
+ * blocks beyond snd_nxt are ignored.
+ *
+ * Called from tcp_receive()
+ */
+static void
+tcp_sack_mark(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+  u32_t left, right, segno;
+  u8_t i;
+
+  for (i = 0; i < sack_num; i++) {
+    left = sack_blocks[2 * i];
+    right = sack_blocks[2 * i + 1];
+    if (!TCP_SEQ_LT(left, right) || TCP_SEQ_LEQ(left, ackno) ||
+        TCP_SEQ_GT(right, pcb->snd_nxt)) {
+      continue;
+    }
+    for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+      segno = lwip_ntohl(seg->tcphdr->seqno);
+      if (TCP_SEQ_GEQ(segno, right)) {
+        break;
+      }
+      if (TCP_SEQ_GEQ(segno, left) &&
+          TCP_SEQ_LEQ(segno + TCP_TCPLEN(seg), right)) {
+        seg->flags |= TF_SEG_SACKED;
+      }
+    }
+  }
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 /**
  * Called by tcp_process. Checks if the given segment is an ACK for outstanding
  * data, and if so frees the memory of the buffered data. Next, it places the
@@ -1018,6 +1060,7 @@ tcp_receive(struct tcp_pcb *pcb)
   struct tcp_seg *next;
 #if TCP_QUEUE_OOSEQ
   struct tcp_seg *prev, *cseg;
+  u8_t fills_hole;
 #endif /* TCP_QUEUE_OOSEQ */
   s32_t off;
   s16_t m;
@@ -1034,6 +1077,12 @@ tcp_receive(struct tcp_pcb *pcb)
   if (flags & TCP_ACK) {
     right_wnd_edge = pcb->snd_wnd + pcb->snd_wl2;
 
+#if LWIP_TCP_SACK_IN
+    if (sack_num > 0 && (pcb->flags & TF_SACK)) {
+      tcp_sack_mark(pcb);
+    }
+#endif /* LWIP_TCP_SACK_IN */
+
     /* Update window. */
     if (TCP_SEQ_LT(pcb->snd_wl1, seqno) ||
        (pcb->snd_wl1 == seqno && TCP_SEQ_LT(pcb->snd_wl2, ackno)) ||
@@ -1108,6 +1157,12 @@ tcp_receive(struct tcp_pcb *pcb)
                 if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
                   pcb->cwnd += pcb->mss;
                 }
+#if LWIP_TCP_SACK_IN
+                /* repair the next hole reported by SACK */
+                if ((pcb->flags & (TF_INFR | TF_SACK)) == (TF_INFR | TF_SACK)) {
+                  tcp_rexmit_sack(pcb);
+                }
+#endif /* LWIP_TCP_SACK_IN */
               } else if (pcb->dupacks == 3) {
                 /* Do fast retransmit */
                 tcp_rexmit_fast(pcb);
@@ -1128,8 +1183,21 @@ tcp_receive(struct tcp_pcb *pcb)
          in fast retransmit. Also reset the congestion window to the
          slow start threshold. */
       if (pcb->flags & TF_INFR) {
-        pcb->flags &= ~TF_INFR;
-        pcb->cwnd = pcb->ssthresh;
+#if LWIP_TCP_SACK_IN
+        if ((pcb->flags & TF_SACK) && TCP_SEQ_LT(ackno, pcb->sack_recover)) {
+          /* Partial ACK: more segments of the window were lost, stay in
+             fast recovery and retransmit them below. Deflate the window
+             by the amount acked and add back one MSS (RFC 6582). */
+          if (pcb->cwnd > (tcpwnd_size_t)(ackno - pcb->lastack)) {
+            pcb->cwnd -= (tcpwnd_size_t)(ackno - pcb->lastack);
+          }
+          pcb->cwnd += pcb->mss;
+        } else
+#endif /* LWIP_TCP_SACK_IN */
+        {
+          pcb->flags &= ~TF_INFR;
+          pcb->cwnd = pcb->ssthresh;
+        }
       }
 
       /* Reset the number of retransmissions. */
@@ -1144,7 +1212,7 @@ tcp_receive(struct tcp_pcb *pcb)
 
       /* Update the congestion control variables (cwnd and
          ssthresh). */
-      if (pcb->state >= ESTABLISHED) {
+      if (pcb->state >= ESTABLISHED && !(pcb->flags & TF_INFR)) {
         if (pcb->cwnd < pcb->ssthresh) {
           if ((tcpwnd_size_t)(pcb->cwnd + pcb->mss) > pcb->cwnd) {
             pcb->cwnd += pcb->mss;
@@ -1200,6 +1268,12 @@ tcp_receive(struct tcp_pcb *pcb)
         pcb->rtime = 0;
       }
 
+#if LWIP_TCP_SACK_IN
+      if (pcb->flags & TF_INFR) {
+        tcp_rexmit_sack(pcb);
+      }
+#endif /* LWIP_TCP_SACK_IN */
+
       pcb->polltmr = 0;
 
 #if LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS
@@ -1384,6 +1458,9 @@ tcp_receive(struct tcp_pcb *pcb)
            we have to trim the end of the segment and update rcv_nxt
            and pass the data to the application. */
         tcplen = TCP_TCPLEN(&inseg);
+#if TCP_QUEUE_OOSEQ
+        fills_hole = (pcb->ooseq != NULL);
+#endif /* TCP_QUEUE_OOSEQ */
 
         if (tcplen > pcb->rcv_wnd) {
           LWIP_DEBUGF(TCP_INPUT_DEBUG,
@@ -1532,7 +1609,15 @@ tcp_receive(struct tcp_pcb *pcb)
 
 
         /* Acknowledge the segment(s). */
-        tcp_ack(pcb);
+#if TCP_QUEUE_OOSEQ
+        if (fills_hole) {
+          /* a hole was filled (partly), let the sender know at once */
+          tcp_ack_now(pcb);
+        } else
+#endif /* TCP_QUEUE_OOSEQ */
+        {
+          tcp_ack(pcb);
+        }
 
 #if LWIP_IPV6 && LWIP_ND6_TCP_REACHABILITY_HINTS
         if (ip_current_is_v6()) {
@@ -1543,8 +1628,10 @@ tcp_receive(struct tcp_pcb *pcb)
 
       } else {
         /* We get here if the incoming segment is out-of-sequence. */
-        tcp_send_empty_ack(pcb);
 #if TCP_QUEUE_OOSEQ
+#if LWIP_TCP_SACK_OUT
+        pcb->rcv_sack_last = seqno;
+#endif /* LWIP_TCP_SACK_OUT */
         /* We queue the segment on the ->ooseq queue. */
         if (pcb->ooseq == NULL) {
           pcb->ooseq = tcp_seg_copy(&inseg);
@@ -1691,6 +1778,9 @@ tcp_receive(struct tcp_pcb *pcb)
         }
 #endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
 #endif /* TCP_QUEUE_OOSEQ */
+        /* The duplicate ACK is sent after queueing, so that the SACK blocks
+           include the incoming segment. */
+        tcp_send_empty_ack(pcb);
       }
     } else {
       /* The incoming segment is not within the window. */
@@ -1733,6 +1823,12 @@ tcp_parseopt(struct tcp_pcb *pcb)
 #if LWIP_TCP_TIMESTAMPS
   u32_t tsval;
 #endif
+#if LWIP_TCP_SACK_IN
+  u32_t edge;
+  u8_t i;
+
+  sack_num = 0;
+#endif
 
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
@@ -1786,6 +1882,43 @@ tcp_parseopt(struct tcp_pcb *pcb)
         }
         break;
 #endif
+#if LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN
+      case LWIP_TCP_OPT_SACK_PERM:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK_PERM\n"));
+        if (tcp_getoptbyte() != LWIP_TCP_OPT_LEN_SACK_PERM || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_SACK_PERM) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        /* only valid in a SYN */
+        if (flags & TCP_SYN) {
+          pcb->flags |= TF_SACK;
+        }
+        break;
+#endif /* LWIP_TCP_SACK_OUT || LWIP_TCP_SACK_IN */
+#if LWIP_TCP_SACK_IN
+      case LWIP_TCP_OPT_SACK:
+        LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: SACK\n"));
+        data = tcp_getoptbyte();
+        if (data < 10 || ((data - 2) % 8) != 0 || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+          /* Bad length */
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+          return;
+        }
+        for (data = (u8_t)((data - 2) / 4), i = 0; i < data; i++) {
+          edge = (u32_t)tcp_getoptbyte() << 24;
+          edge |= (u32_t)tcp_getoptbyte() << 16;
+          edge |= (u32_t)tcp_getoptbyte() << 8;
+          edge |= tcp_getoptbyte();
+          if (sack_num < LWIP_TCP_SACK_MAX_IN) {
+            sack_blocks[2 * sack_num + (i & 1)] = edge;
+            if (i & 1) {
+              sack_num++;
+            }
+          }
+        }
+        break;
+#endif /* LWIP_TCP_SACK_IN */
 #if LWIP_TCP_TIMESTAMPS
       case LWIP_TCP_OPT_TS:
         LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: TS\n"));
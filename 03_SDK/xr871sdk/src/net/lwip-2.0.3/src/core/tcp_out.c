@@ -813,6 +813,12 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
       optflags |= TF_SEG_OPTS_WND_SCALE;
     }
 #endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_IN
+    if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_SACK)) {
+      /* Same for SACK permitted */
+      optflags |= TF_SEG_OPTS_SACK_PERM;
+    }
+#endif /* LWIP_TCP_SACK_IN */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
@@ -909,6 +915,70 @@ tcp_build_wnd_scale_option(u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK_OUT
+/**
+ * Get the SACK blocks to send from the ooseq queue. The block holding the
+ * segment received last is reported first (RFC 2018, section 4), the others
+ * follow in sequence order.
+ *
+ * @param pcb tcp_pcb
+ * @param blocks where to store the left and right edges of the blocks
+ * @return number of blocks, at most LWIP_TCP_SACK_MAX_OUT
+ */
+static u8_t
+tcp_get_sack_blocks(struct tcp_pcb *pcb, u32_t *blocks)
+{
+  struct tcp_seg *seg;
+  u32_t left, right;
+  u8_t num = 1; /* blocks[0] is for the block received last */
+  u8_t last = 0;
+
+  for (seg = pcb->ooseq; seg != NULL; ) {
+    /* ooseq is sorted, contiguous segments make up one block */
+    left = seg->tcphdr->seqno;
+    right = left + TCP_TCPLEN(seg);
+    for (seg = seg->next; seg != NULL && seg->tcphdr->seqno == right; seg = seg->next) {
+      right += TCP_TCPLEN(seg);
+    }
+    if (!last && TCP_SEQ_BETWEEN(pcb->rcv_sack_last, left, right - 1)) {
+      blocks[0] = left;
+      blocks[1] = right;
+      last = 1;
+    } else if (num < LWIP_TCP_SACK_MAX_OUT) {
+      blocks[2 * num] = left;
+      blocks[2 * num + 1] = right;
+      num++;
+    }
+  }
+  if (!last) {
+    /* the segment received last was dropped from ooseq */
+    if (--num > 0) {
+      blocks[0] = blocks[2 * num];
+      blocks[1] = blocks[2 * num + 1];
+    }
+  }
+  return num;
+}
+
+/** Build a SACK option (2 + 8 * num bytes long) at the specified options pointer
+ *
+ * @param opts option pointer where to store the SACK option
+ * @param blocks left and right edges of the blocks
+ * @param num number of blocks
+ */
+static void
+tcp_build_sack_option(u32_t *opts, const u32_t *blocks, u8_t num)
+{
+  u8_t i;
+
+  /* Pad with two NOP options to make everything nicely aligned */
+  opts[0] = lwip_htonl(0x01010500 | (2 + 8 * num));
+  for (i = 0; i < 2 * num; i++) {
+    opts[1 + i] = lwip_htonl(blocks[i]);
+  }
+}
+#endif /* LWIP_TCP_SACK_OUT */
+
 /**
  * Send an ACK without data.
  *
@@ -921,15 +991,27 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   struct pbuf *p;
   u8_t optlen = 0;
   struct netif *netif;
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT
   struct tcp_hdr *tcphdr;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_SACK_OUT
+  u32_t sack_blocks[2 * LWIP_TCP_SACK_MAX_OUT];
+  u8_t sack_num = 0;
+#endif /* LWIP_TCP_SACK_OUT */
 
 #if LWIP_TCP_TIMESTAMPS
   if (pcb->flags & TF_TIMESTAMP) {
     optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
   }
 #endif
+#if LWIP_TCP_SACK_OUT
+  if ((pcb->flags & TF_SACK) && pcb->ooseq != NULL) {
+    sack_num = tcp_get_sack_blocks(pcb, sack_blocks);
+    if (sack_num > 0) {
+      optlen += LWIP_TCP_OPT_LEN_SACK_OUT(sack_num);
+    }
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
   p = tcp_output_alloc_header(pcb, optlen, 0, lwip_htonl(pcb->snd_nxt));
   if (p == NULL) {
@@ -938,9 +1020,9 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output: (ACK) could not allocate pbuf\n"));
     return ERR_BUF;
   }
-#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP
+#if LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT
   tcphdr = (struct tcp_hdr *)p->payload;
-#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP */
+#endif /* LWIP_TCP_TIMESTAMPS || CHECKSUM_GEN_TCP || LWIP_TCP_SACK_OUT */
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG,
               ("tcp_output: sending ACK for %"U32_F"\n", pcb->rcv_nxt));
 
@@ -952,6 +1034,13 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
   }
 #endif
+#if LWIP_TCP_SACK_OUT
+  if (sack_num > 0) {
+    tcp_build_sack_option((u32_t *)(void *)((u8_t *)(tcphdr + 1) + optlen -
+                                            LWIP_TCP_OPT_LEN_SACK_OUT(sack_num)),
+                          sack_blocks, sack_num);
+  }
+#endif /* LWIP_TCP_SACK_OUT */
 
   netif = ip_route(&pcb->local_ip, &pcb->remote_ip);
   if (netif == NULL) {
@@ -1245,6 +1334,13 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     opts += 1;
   }
 #endif
+#if LWIP_TCP_SACK_IN
+  if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+    /* Pad with two NOP options to make everything nicely aligned */
+    *opts = PP_HTONL(0x01010402);
+    opts += 1;
+  }
+#endif
 
   /* Set retransmission timer running if it is not currently enabled
      This must be set before checking the route. */
@@ -1405,7 +1501,15 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
   }
 
   /* Move all unacked segments to the head of the unsent queue */
-  for (seg = pcb->unacked; seg->next != NULL; seg = seg->next);
+  for (seg = pcb->unacked; seg->next != NULL; seg = seg->next) {
+#if LWIP_TCP_SACK_IN
+    /* the receiver may have discarded SACKed data, forget it (RFC 2018) */
+    seg->flags &= ~TF_SEG_SACKED;
+#endif /* LWIP_TCP_SACK_IN */
+  }
+#if LWIP_TCP_SACK_IN
+  seg->flags &= ~TF_SEG_SACKED;
+#endif /* LWIP_TCP_SACK_IN */
   /* concatenate unsent queue after unacked queue */
   seg->next = pcb->unsent;
 #if TCP_OVERSIZE_DBGCHECK
@@ -1432,27 +1536,17 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
 }
 
 /**
- * Requeue the first unacked segment for retransmission
- *
- * Called by tcp_receive() for fast retransmit.
+ * Move a segment removed from the unacked queue to the unsent queue, keeping
+ * the unsent queue sorted.
  *
- * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ * @param pcb the tcp_pcb the segment belongs to
+ * @param seg the segment to requeue
  */
-void
-tcp_rexmit(struct tcp_pcb *pcb)
+static void
+tcp_rexmit_requeue(struct tcp_pcb *pcb, struct tcp_seg *seg)
 {
-  struct tcp_seg *seg;
   struct tcp_seg **cur_seg;
 
-  if (pcb->unacked == NULL) {
-    return;
-  }
-
-  /* Move the first unacked segment to the unsent queue */
-  /* Keep the unsent queue sorted. */
-  seg = pcb->unacked;
-  pcb->unacked = seg->next;
-
   cur_seg = &(pcb->unsent);
   while (*cur_seg &&
     TCP_SEQ_LT(lwip_ntohl((*cur_seg)->tcphdr->seqno), lwip_ntohl(seg->tcphdr->seqno))) {
@@ -1466,6 +1560,28 @@ tcp_rexmit(struct tcp_pcb *pcb)
     pcb->unsent_oversize = 0;
   }
 #endif /* TCP_OVERSIZE */
+}
+
+/**
+ * Requeue the first unacked segment for retransmission
+ *
+ * Called by tcp_receive() for fast retransmit.
+ *
+ * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ */
+void
+tcp_rexmit(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+
+  if (pcb->unacked == NULL) {
+    return;
+  }
+
+  /* Move the first unacked segment to the unsent queue */
+  seg = pcb->unacked;
+  pcb->unacked = seg->next;
+  tcp_rexmit_requeue(pcb, seg);
 
   if (pcb->nrtx < 0xFF) {
     ++pcb->nrtx;
@@ -1480,6 +1596,58 @@ tcp_rexmit(struct tcp_pcb *pcb)
      and thus tcp_output directly returns. */
 }
 
+#if LWIP_TCP_SACK_IN
+/**
+ * Requeue the next hole for retransmission in fast recovery: the first
+ * unacked segment, not yet retransmitted in this recovery, that is not
+ * SACKed while a segment after it is (RFC 6675, NextSeg() rule 1).
+ *
+ * Called by tcp_receive() for every duplicate or partial ACK in fast
+ * recovery, so at most one segment is retransmitted per ACK.
+ *
+ * @param pcb the tcp_pcb for which to retransmit the next hole
+ */
+void
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg, *prev, *hole, *hole_prev;
+
+  hole = hole_prev = NULL;
+  for (prev = NULL, seg = pcb->unacked; seg != NULL; prev = seg, seg = seg->next) {
+    if (seg->flags & TF_SEG_SACKED) {
+      if (hole != NULL) {
+        break;
+      }
+    } else if (hole == NULL &&
+               TCP_SEQ_GEQ(lwip_ntohl(seg->tcphdr->seqno), pcb->sack_rexmit)) {
+      hole = seg;
+      hole_prev = prev;
+    }
+  }
+  if (seg == NULL) {
+    /* no hole, or nothing SACKed after it */
+    return;
+  }
+
+  LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: hole %"U32_F":%"U32_F"\n",
+                             lwip_ntohl(hole->tcphdr->seqno),
+                             lwip_ntohl(hole->tcphdr->seqno) + TCP_TCPLEN(hole)));
+  if (hole_prev != NULL) {
+    hole_prev->next = hole->next;
+  } else {
+    pcb->unacked = hole->next;
+  }
+  tcp_rexmit_requeue(pcb, hole);
+  pcb->sack_rexmit = lwip_ntohl(hole->tcphdr->seqno) + TCP_TCPLEN(hole);
+
+  /* Don't take any rtt measurements after retransmitting. */
+  pcb->rttest = 0;
+
+  MIB2_STATS_INC(mib2.tcpretranssegs);
+  /* tcp_output is called when tcp_input() is done */
+}
+#endif /* LWIP_TCP_SACK_IN */
+
 
 /**
  * Handle retransmission after three dupacks received
@@ -1496,6 +1664,10 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  "), fast retransmit %"U32_F"\n",
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
+#if LWIP_TCP_SACK_IN
+    pcb->sack_recover = pcb->snd_nxt;
+    pcb->sack_rexmit = lwip_ntohl(pcb->unacked->tcphdr->seqno) + TCP_TCPLEN(pcb->unacked);
+#endif /* LWIP_TCP_SACK_IN */
     tcp_rexmit(pcb);
 
     /* Set ssthresh to half of the minimum of the current
@@ -4,6 +4,7 @@
 #include "udp/test_udp.h"
 #include "tcp/test_tcp.h"
 #include "tcp/test_tcp_oos.h"
+#include "tcp/test_tcp_sack.h"
 #include "core/test_mem.h"
 #include "core/test_pbuf.h"
 #include "etharp/test_etharp.h"
@@ -42,6 +43,7 @@ int main(void)
     udp_suite,
     tcp_suite,
     tcp_oos_suite,
+    tcp_sack_suite,
     mem_suite,
     pbuf_suite,
     etharp_suite,
@@ -0,0 +1,497 @@
+#include "test_tcp_sack.h"
+
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/stats.h"
+#include "lwip/ip.h"
+#include "lwip/prot/ip4.h"
+#include "tcp_helper.h"
+
+#include <string.h>
+
+#if !LWIP_STATS || !TCP_STATS || !MEMP_STATS
+#error "This tests needs TCP- and MEMP-statistics enabled"
+#endif
+#if !LWIP_TCP_SACK_OUT || !LWIP_TCP_SACK_IN
+#error "This tests needs LWIP_TCP_SACK_OUT and LWIP_TCP_SACK_IN enabled"
+#endif
+
+/* A deterministic link between two pcbs of the same stack: every packet
+   output is copied to a queue and passed to ip_input() one step later.
+   Data segments of the sender are dropped or delayed by one step according
+   to a fixed pseudo random sequence. */
+
+#define LINK_MAX_PKTS       64
+#define LINK_STEP_MS        10  /* one way delay */
+#define LINK_TMR_STEPS      (TCP_TMR_INTERVAL / LINK_STEP_MS)
+
+struct link_pkt {
+  u16_t len;
+  u8_t *data;
+};
+
+struct link {
+  struct link_pkt pkts[LINK_MAX_PKTS];
+  int num;
+  u32_t rand;
+  u8_t loss_pct;
+  u8_t reorder_pct;
+  u16_t data_port;      /* source port of the data segments */
+  u32_t snd_high;       /* highest data seqno sent + 1 */
+  u8_t snd_high_valid;
+  u32_t rexmit_bytes;
+  u32_t dropped;
+  u32_t reordered;
+};
+
+static struct link test_link;
+
+/* the last ACK captured by tcp_sack_capture_output */
+static u8_t last_ack[128];
+static u16_t last_ack_len;
+
+static u32_t
+link_rand(struct link *l)
+{
+  l->rand = l->rand * 1103515245 + 12345;
+  return (l->rand >> 16) % 100;
+}
+
+static struct tcp_hdr *
+pkt_tcphdr(u8_t *data)
+{
+  return (struct tcp_hdr *)(data + IPH_HL((struct ip_hdr *)data) * 4);
+}
+
+static u16_t
+pkt_tcp_datalen(u8_t *data, u16_t len)
+{
+  struct tcp_hdr *tcphdr = pkt_tcphdr(data);
+  return (u16_t)(len - ((u8_t *)tcphdr - data) - TCPH_HDRLEN(tcphdr) * 4);
+}
+
+static err_t
+link_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct link *l = &test_link;
+  struct link_pkt *pkt;
+  struct tcp_hdr *tcphdr;
+  u32_t seqno, end;
+  u16_t datalen;
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+
+  EXPECT_RETX(l->num < LINK_MAX_PKTS, ERR_MEM);
+  pkt = &l->pkts[l->num++];
+  pkt->len = p->tot_len;
+  pkt->data = (u8_t *)malloc(p->tot_len);
+  EXPECT_RETX(pkt->data != NULL, ERR_MEM);
+  pbuf_copy_partial(p, pkt->data, p->tot_len, 0);
+
+  /* count retransmitted data bytes */
+  tcphdr = pkt_tcphdr(pkt->data);
+  datalen = pkt_tcp_datalen(pkt->data, pkt->len);
+  if (lwip_ntohs(tcphdr->src) == l->data_port && datalen > 0) {
+    seqno = lwip_ntohl(tcphdr->seqno);
+    end = seqno + datalen;
+    if (!l->snd_high_valid) {
+      l->snd_high = end;
+      l->snd_high_valid = 1;
+    } else if (TCP_SEQ_LT(seqno, l->snd_high)) {
+      l->rexmit_bytes += TCP_SEQ_LT(end, l->snd_high) ? datalen : l->snd_high - seqno;
+    }
+    if (TCP_SEQ_GT(end, l->snd_high)) {
+      l->snd_high = end;
+    }
+  }
+  return ERR_OK;
+}
+
+/** Pass the packets queued in the previous step to the stack */
+static void
+link_step(struct link *l, struct netif *netif)
+{
+  struct link_pkt pkts[LINK_MAX_PKTS];
+  struct link_pkt late = {0, NULL};
+  struct pbuf *p;
+  int i, num;
+
+  num = l->num;
+  memcpy(pkts, l->pkts, num * sizeof(pkts[0]));
+  l->num = 0;
+
+  for (i = 0; i < num; i++) {
+    struct tcp_hdr *tcphdr = pkt_tcphdr(pkts[i].data);
+    if (lwip_ntohs(tcphdr->src) == l->data_port &&
+        pkt_tcp_datalen(pkts[i].data, pkts[i].len) > 0) {
+      if (link_rand(l) < l->loss_pct) {
+        l->dropped++;
+        free(pkts[i].data);
+        continue;
+      }
+      if (late.data == NULL && link_rand(l) < l->reorder_pct) {
+        /* deliver it after the next one */
+        l->reordered++;
+        late = pkts[i];
+        continue;
+      }
+    }
+    p = pbuf_alloc(PBUF_RAW, pkts[i].len, PBUF_POOL);
+    EXPECT_RET(p != NULL);
+    pbuf_take(p, pkts[i].data, pkts[i].len);
+    free(pkts[i].data);
+    ip_input(p, netif);
+    if (late.data != NULL && i + 1 < num) {
+      /* insert it after the one just passed */
+      memmove(&pkts[i + 2], &pkts[i + 1], (num - i - 1) * sizeof(pkts[0]));
+      pkts[i + 1] = late;
+      late.data = NULL;
+      num++;
+      i++;
+      p = pbuf_alloc(PBUF_RAW, pkts[i].len, PBUF_POOL);
+      EXPECT_RET(p != NULL);
+      pbuf_take(p, pkts[i].data, pkts[i].len);
+      free(pkts[i].data);
+      ip_input(p, netif);
+    }
+  }
+  if (late.data != NULL) {
+    /* nothing to overtake it in this step, keep it for the next one */
+    EXPECT_RET(l->num < LINK_MAX_PKTS);
+    l->pkts[l->num++] = late;
+  }
+}
+
+static void
+link_flush(struct link *l)
+{
+  int i;
+  for (i = 0; i < l->num; i++) {
+    free(l->pkts[i].data);
+  }
+  l->num = 0;
+}
+
+/* transfer state */
+#define XFER_PORT   7
+#define XFER_BYTES  (256 * 1024)
+
+struct xfer {
+  struct tcp_pcb *client;
+  struct tcp_pcb *server;
+  u32_t sent;
+  u32_t recved;
+  u8_t connected;
+  u8_t corrupt;
+  u8_t sack;
+};
+
+static u8_t
+xfer_byte(u32_t off)
+{
+  return (u8_t)((off * 7) ^ (off >> 8));
+}
+
+static void
+xfer_send(struct xfer *x)
+{
+  u8_t buf[256];
+  u16_t len;
+  u32_t i;
+
+  while (x->sent < XFER_BYTES) {
+    len = (u16_t)LWIP_MIN(tcp_sndbuf(x->client), sizeof(buf));
+    len = (u16_t)LWIP_MIN(len, XFER_BYTES - x->sent);
+    if (len == 0 || tcp_sndqueuelen(x->client) >= TCP_SND_QUEUELEN - 1) {
+      break;
+    }
+    for (i = 0; i < len; i++) {
+      buf[i] = xfer_byte(x->sent + i);
+    }
+    if (tcp_write(x->client, buf, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+      break;
+    }
+    x->sent += len;
+  }
+  tcp_output(x->client);
+}
+
+static err_t
+xfer_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  struct xfer *x = (struct xfer *)arg;
+  struct pbuf *q;
+  u16_t i;
+  LWIP_UNUSED_ARG(err);
+
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  for (q = p; q != NULL; q = q->next) {
+    for (i = 0; i < q->len; i++) {
+      if (((u8_t *)q->payload)[i] != xfer_byte(x->recved + i)) {
+        x->corrupt = 1;
+      }
+    }
+    x->recved += q->len;
+  }
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t
+xfer_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  struct xfer *x = (struct xfer *)arg;
+  LWIP_UNUSED_ARG(err);
+
+  x->server = newpcb;
+  tcp_arg(newpcb, x);
+  tcp_recv(newpcb, xfer_recv);
+  return ERR_OK;
+}
+
+static err_t
+xfer_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  struct xfer *x = (struct xfer *)arg;
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(err);
+
+  x->connected = 1;
+  return ERR_OK;
+}
+
+/** Run a transfer over a lossy link, return the time needed in ms */
+static u32_t
+xfer_run(u8_t sack, u8_t loss_pct, u8_t reorder_pct, u32_t *rexmit_bytes)
+{
+  struct xfer x;
+  struct netif netif;
+  struct tcp_pcb *lpcb, *cpcb;
+  ip_addr_t ip, netmask;
+  u32_t steps;
+  err_t err;
+
+  memset(&x, 0, sizeof(x));
+  memset(&test_link, 0, sizeof(test_link));
+  test_link.rand = 0x5ac3;
+
+  IP_ADDR4(&ip, 192, 168, 1, 1);
+  IP_ADDR4(&netmask, 255, 255, 255, 0);
+  test_tcp_init_netif(&netif, NULL, &ip, &netmask);
+  netif.output = link_output;
+
+  lpcb = tcp_new();
+  EXPECT_RETX(lpcb != NULL, 0);
+  err = tcp_bind(lpcb, &ip, XFER_PORT);
+  EXPECT_RETX(err == ERR_OK, 0);
+  lpcb = tcp_listen(lpcb);
+  EXPECT_RETX(lpcb != NULL, 0);
+  tcp_arg(lpcb, &x);
+  tcp_accept(lpcb, xfer_accept);
+
+  cpcb = tcp_new();
+  EXPECT_RETX(cpcb != NULL, 0);
+  x.client = cpcb;
+  tcp_arg(cpcb, &x);
+  err = tcp_connect(cpcb, &ip, XFER_PORT, xfer_connected);
+  EXPECT_RETX(err == ERR_OK, 0);
+  test_link.data_port = cpcb->local_port;
+
+  /* the handshake is not disturbed */
+  for (steps = 0; steps < 10 && !(x.connected && x.server != NULL); steps++) {
+    link_step(&test_link, &netif);
+  }
+  EXPECT_RETX(x.connected && x.server != NULL, 0);
+  /* SACK is negotiated, disable it for the reference run */
+  EXPECT((cpcb->flags & TF_SACK) && (x.server->flags & TF_SACK));
+  if (!sack) {
+    cpcb->flags &= ~TF_SACK;
+    x.server->flags &= ~TF_SACK;
+  }
+
+  test_link.loss_pct = loss_pct;
+  test_link.reorder_pct = reorder_pct;
+  for (steps = 0; x.recved < XFER_BYTES && steps < 100000; steps++) {
+    xfer_send(&x);
+    link_step(&test_link, &netif);
+    if ((steps % LINK_TMR_STEPS) == 0) {
+      tcp_tmr();
+    }
+  }
+  EXPECT(x.recved == XFER_BYTES);
+  EXPECT(!x.corrupt);
+
+  LWIP_PLATFORM_DIAG(("tcp_sack: %s, loss %u%%, reorder %u%%: %"U32_F" ms, "
+                      "goodput %"U32_F" KB/s, rexmit %"U32_F" bytes "
+                      "(dropped %"U32_F", reordered %"U32_F")\n",
+                      sack ? "SACK" : "no SACK", loss_pct, reorder_pct,
+                      steps * LINK_STEP_MS,
+                      (u32_t)XFER_BYTES * 1000 / 1024 / (steps * LINK_STEP_MS),
+                      test_link.rexmit_bytes, test_link.dropped, test_link.reordered));
+
+  *rexmit_bytes = test_link.rexmit_bytes;
+  link_flush(&test_link);
+  tcp_abort(cpcb);
+  if (x.server != NULL) {
+    tcp_abort(x.server);
+  }
+  tcp_close(lpcb);
+  netif_list = NULL;
+  netif_default = NULL;
+  return steps * LINK_STEP_MS;
+}
+
+static err_t
+tcp_sack_capture_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(ipaddr);
+  last_ack_len = pbuf_copy_partial(p, last_ack, sizeof(last_ack), 0);
+  return ERR_OK;
+}
+
+/** Find the SACK option of a captured segment, return the number of blocks */
+static int
+tcp_sack_parse(u8_t *data, u32_t *blocks, int max)
+{
+  struct tcp_hdr *tcphdr = pkt_tcphdr(data);
+  u8_t *opt = (u8_t *)(tcphdr + 1);
+  u8_t *end = (u8_t *)tcphdr + TCPH_HDRLEN(tcphdr) * 4;
+  int i, num;
+
+  while (opt < end) {
+    if (opt[0] == LWIP_TCP_OPT_EOL) {
+      break;
+    } else if (opt[0] == LWIP_TCP_OPT_NOP) {
+      opt++;
+    } else if (opt[0] == LWIP_TCP_OPT_SACK) {
+      num = (opt[1] - 2) / 8;
+      for (i = 0; i < 2 * num && i < 2 * max; i++) {
+        blocks[i] = ((u32_t)opt[2 + 4 * i] << 24) | ((u32_t)opt[3 + 4 * i] << 16) |
+                    ((u32_t)opt[4 + 4 * i] << 8) | opt[5 + 4 * i];
+      }
+      return num;
+    } else {
+      opt += opt[1];
+    }
+  }
+  return 0;
+}
+
+static void
+tcp_sack_setup(void)
+{
+  tcp_remove_all();
+}
+
+static void
+tcp_sack_teardown(void)
+{
+  tcp_remove_all();
+  netif_list = NULL;
+  netif_default = NULL;
+}
+
+/* Test functions */
+
+/** The duplicate ACKs sent for out-of-sequence segments carry SACK blocks,
+ * the block of the segment received last first */
+START_TEST(test_tcp_sack_out_blocks)
+{
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  struct netif netif;
+  ip_addr_t remote_ip, local_ip, netmask;
+  u32_t blocks[2 * LWIP_TCP_SACK_MAX_OUT];
+  u32_t rcv_nxt;
+  char data[8 * 100];
+  LWIP_UNUSED_ARG(_i);
+
+  memset(data, 0x5a, sizeof(data));
+  IP_ADDR4(&local_ip, 192, 168, 1, 1);
+  IP_ADDR4(&remote_ip, 192, 168, 1, 2);
+  IP_ADDR4(&netmask,   255, 255, 255, 0);
+  test_tcp_init_netif(&netif, NULL, &local_ip, &netmask);
+  netif.output = tcp_sack_capture_output;
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &local_ip, &remote_ip, 0x101, 0x100);
+  pcb->flags |= TF_SACK;
+  rcv_nxt = pcb->rcv_nxt;
+
+  /* segments 2, 4 and 5 of 100 bytes each */
+  p = tcp_create_rx_segment(pcb, data, 100, 200, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(tcp_sack_parse(last_ack, blocks, LWIP_TCP_SACK_MAX_OUT) == 1);
+  EXPECT(blocks[0] == rcv_nxt + 200 && blocks[1] == rcv_nxt + 300);
+
+  p = tcp_create_rx_segment(pcb, data, 100, 500, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  p = tcp_create_rx_segment(pcb, data, 100, 400, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(tcp_sack_parse(last_ack, blocks, LWIP_TCP_SACK_MAX_OUT) == 2);
+  EXPECT(blocks[0] == rcv_nxt + 400 && blocks[1] == rcv_nxt + 600);
+  EXPECT(blocks[2] == rcv_nxt + 200 && blocks[3] == rcv_nxt + 300);
+  EXPECT(lwip_ntohl(pkt_tcphdr(last_ack)->ackno) == rcv_nxt);
+
+  /* filling the first hole is acked at once, with the remaining block */
+  p = tcp_create_rx_segment(pcb, data, 200, 0, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(counters.recved_bytes == 300);
+  EXPECT(lwip_ntohl(pkt_tcphdr(last_ack)->ackno) == rcv_nxt + 300);
+  EXPECT_RET(tcp_sack_parse(last_ack, blocks, LWIP_TCP_SACK_MAX_OUT) == 1);
+  EXPECT(blocks[0] == rcv_nxt + 400 && blocks[1] == rcv_nxt + 600);
+
+  /* no SACK option once ooseq is empty */
+  p = tcp_create_rx_segment(pcb, data, 100, 0, 0, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(counters.recved_bytes == 600);
+  EXPECT(pcb->ooseq == NULL);
+  EXPECT(tcp_sack_parse(last_ack, blocks, LWIP_TCP_SACK_MAX_OUT) == 0);
+
+  tcp_abort(pcb);
+}
+END_TEST
+
+/** Transfer data over a link with loss and reordering, with and without
+ * SACK. The retransmitted bytes are about the same (an RTO retransmits all
+ * unacked segments either way), but SACK recovers more losses without
+ * waiting for the retransmission timer. */
+START_TEST(test_tcp_sack_lossy_transfer)
+{
+  u32_t ms_sack, ms_ref, rexmit_sack, rexmit_ref;
+  LWIP_UNUSED_ARG(_i);
+
+  ms_ref = xfer_run(0, 3, 3, &rexmit_ref);
+  ms_sack = xfer_run(1, 3, 3, &rexmit_sack);
+  EXPECT(ms_sack > 0 && ms_ref > 0);
+  EXPECT(ms_sack < ms_ref);
+
+  ms_ref = xfer_run(0, 5, 0, &rexmit_ref);
+  ms_sack = xfer_run(1, 5, 0, &rexmit_sack);
+  EXPECT(ms_sack > 0 && ms_ref > 0);
+  EXPECT(ms_sack < ms_ref);
+}
+END_TEST
+
+
+/** Create the suite including all tests for this module */
+Suite *
+tcp_sack_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_tcp_sack_out_blocks),
+    TESTFUNC(test_tcp_sack_lossy_transfer)
+  };
+  return create_suite("TCP_SACK", tests, sizeof(tests)/sizeof(testfunc), tcp_sack_setup, tcp_sack_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_TCP_SACK_H
+#define LWIP_HDR_TEST_TCP_SACK_H
+
+#include "../lwip_check.h"
+
+Suite *tcp_sack_suite(void);
+
+#endif
@@ -54,6 +54,21 @@
 
 #define NOPOLL_DELIVER_PONG_FRAME  0
 
+/* frames up to this size (header included) are parsed in place from a
+ * per connection buffer, larger ones are streamed in pieces */
+#ifndef NOPOLL_RECV_BUF_SIZE
+#define NOPOLL_RECV_BUF_SIZE       1024
+#endif
+
+/* writev(2) gathers header and payload into the same segments; lwIP's
+ * does a tcp_write() and tcp_output() per vector, which would send the
+ * header on its own, so frames are copied into a send buffer there */
+#if defined(NOPOLL_OS_UNIX)
+# include <sys/uio.h>
+# define NOPOLL_HAVE_WRITEV        1
+# define NOPOLL_IOV_MAX            8
+#endif
+
 /**
  * @brief Allows to enable/disable non-blocking/blocking behavior on
  * the provided socket.
@@ -1794,6 +1809,8 @@ void           nopoll_conn_set_socket (noPollConn * conn, NOPOLL_SOCKET _socket)
 	if (conn == NULL)
 		return;
 	conn->session = _socket;
+	if (conn->ctx)
+		conn->ctx->conn_changes++;
 	return;
 }
 
@@ -2073,6 +2090,10 @@ void          nopoll_conn_shutdown (noPollConn * conn)
 	}
 	conn->session = NOPOLL_INVALID_SOCKET;
 
+	/* let the loop drop it from its watching set */
+	if (conn->ctx)
+		conn->ctx->conn_changes++;
+
 	return;
 }
 
@@ -2273,6 +2294,16 @@ void nopoll_conn_unref (noPollConn * conn)
 	if (conn->previous_msg)
 		nopoll_msg_unref (conn->previous_msg);
 
+	/* release the receive buffer, unless the application keeps the
+	 * last message parsed in place */
+	if (conn->rbuf_msg && nopoll_msg_ref_count (conn->rbuf_msg) > 1) {
+		conn->rbuf_msg->payload_buf = conn->rbuf;
+		conn->rbuf = NULL;
+	} /* end if */
+	nopoll_msg_unref (conn->rbuf_msg);
+	nopoll_free (conn->rbuf);
+	nopoll_free (conn->send_buf);
+
 #if defined(NOPOLL_MBEDTLS)
 	if (conn->fd_ctx) {
 		nopoll_free(conn->fd_ctx);
@@ -2525,6 +2556,21 @@ int         __nopoll_conn_receive  (noPollConn * conn, char  * buffer, int  maxl
 
 	} /* end if */
 
+	if (conn->rbuf_start < conn->rbuf_len) {
+		/* serve first the bytes read ahead by the in place
+		 * parser (see __nopoll_conn_get_msg_in_place) */
+		nread = conn->rbuf_len - conn->rbuf_start;
+		if (nread > maxlen)
+			nread = maxlen;
+		memcpy (buffer, conn->rbuf + conn->rbuf_start, nread);
+		conn->rbuf_start += nread;
+		if (nread == maxlen)
+			return nread;
+
+		maxlen = __nopoll_conn_receive (conn, buffer + nread, maxlen - nread);
+		return maxlen > 0 ? nread + maxlen : nread;
+	} /* end if */
+
  keep_reading:
 	/* clear buffer */
 	/* memset (buffer, 0, maxlen * sizeof (char )); */
@@ -3188,20 +3234,290 @@ void nopoll_conn_complete_handshake (noPollConn * conn)
 
 void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp)
 {
-	int iter       = 0;
-	int mask_index = 0;
-
-	while (iter < payload_size) {
-		/* rotate mask and apply it */
-		mask_index = (iter + desp) % 4;
-		payload[iter] ^= mask[mask_index];
-		iter++;
+	unsigned char * iter = (unsigned char *) payload;
+	unsigned char * end  = iter + payload_size;
+	unsigned char   key[4];
+	unsigned int    word;
+	int             i;
+
+	/* byte-wise up to the first aligned address */
+	while (iter < end && ((unsigned long) iter & 3)) {
+		*iter++ ^= mask[desp & 3];
+		desp++;
 	} /* end while */
 
+	/* from there the mask, rotated to the current offset, repeats
+	 * every word in memory order whatever the endianness */
+	for (i = 0; i < 4; i++)
+		key[i] = mask[(desp + i) & 3];
+	memcpy (&word, key, 4);
+
+	while (end - iter >= 4) {
+		*(unsigned int *) iter ^= word;
+		iter += 4;
+	} /* end while */
+
+	/* and the tail */
+	for (i = 0; iter < end; i++)
+		*iter++ ^= key[i];
+
 	return;
 }
 
 
+/**
+ * @internal Reads whatever is available into the free tail of the
+ * connection receive buffer.
+ *
+ * @return The number of bytes read, 0 when nothing was available and
+ * -1 when the connection was closed or failed (and was shut down).
+ */
+static int __nopoll_conn_fill_rbuf (noPollConn * conn)
+{
+	int nread;
+
+ keep_reading:
+#if defined(NOPOLL_OS_UNIX)
+	errno = 0;
+#elif defined(NOPOLL_OS_WIN32)
+	WSASetLastError(0);
+#elif defined(NOPOLL_OS_FREERTOS)
+	OS_SetErrno(0);
+#endif
+	nread = conn->receive (conn, conn->rbuf + conn->rbuf_len, NOPOLL_RECV_BUF_SIZE - conn->rbuf_len);
+	if (nread == NOPOLL_SOCKET_ERROR) {
+		if (errno == NOPOLL_EAGAIN || errno == NOPOLL_EWOULDBLOCK)
+			return 0;
+		if (errno == NOPOLL_EINTR)
+			goto keep_reading;
+
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "unable to read from conn-id=%d, error code was: %d (%s) (shutting down connection)",
+			    conn->id, errno, strerror (errno));
+		nopoll_conn_shutdown (conn);
+		return -1;
+	} /* end if */
+
+	if (nread <= 0) {
+		if (errno == NOPOLL_EAGAIN || errno == NOPOLL_EWOULDBLOCK)
+			return 0;
+
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "received connection close while reading from conn id %d, shutting down connection..",
+			    conn->id);
+		nopoll_conn_shutdown (conn);
+		return -1;
+	} /* end if */
+
+	conn->rbuf_len += nread;
+	return nread;
+}
+
+/**
+ * @internal Checks the frame found at rbuf_start. Its first byte
+ * isn't looked at: it may still be held (see rbuf_hold).
+ *
+ * @return The frame header size when the whole frame is buffered, 0
+ * when more bytes are needed or -1 when it doesn't fit the buffer.
+ */
+static int __nopoll_conn_frame_in_place (noPollConn * conn, long * payload_size)
+{
+	const unsigned char * frame       = (const unsigned char *) conn->rbuf + conn->rbuf_start;
+	int                   bytes       = conn->rbuf_len - conn->rbuf_start;
+	int                   header_size = 2;
+
+	if (bytes < 2)
+		return 0;
+
+	*payload_size = frame[1] & 0x7F;
+	if (*payload_size == 127)
+		return -1;
+	if (*payload_size == 126) {
+		header_size += 2;
+		if (bytes < header_size)
+			return 0;
+		*payload_size = (frame[2] << 8) | frame[3];
+	} /* end if */
+
+	/* mask */
+	if (frame[1] & 0x80)
+		header_size += 4;
+
+	if (header_size + *payload_size > NOPOLL_RECV_BUF_SIZE)
+		return -1;
+	if (bytes < header_size + *payload_size)
+		return 0;
+	return header_size;
+}
+
+/**
+ * @internal Allows to check if a whole frame is waiting in the
+ * connection receive buffer, where select() wouldn't report it.
+ */
+nopoll_bool __nopoll_conn_has_frame_buffered (noPollConn * conn)
+{
+	long payload_size;
+
+	if (conn == NULL || conn->rbuf == NULL || conn->previous_msg || conn->pending_buf_bytes > 0)
+		return nopoll_false;
+
+	return __nopoll_conn_frame_in_place (conn, &payload_size) > 0;
+}
+
+/**
+ * @internal Reads the next frame into the connection receive buffer
+ * and reports it from there, unmasked in place and reusing the same
+ * message object, so a steady flow of small frames doesn't allocate.
+ *
+ * The payload stays valid until the next call; when the application
+ * still holds a reference to the message by then, the buffer goes
+ * along with it and the connection takes a new one.
+ *
+ * @param handled Set to nopoll_false when the frame must be read by
+ * the streaming path instead (it doesn't fit the buffer or that path
+ * is in the middle of a frame).
+ */
+static noPollMsg * __nopoll_conn_get_msg_in_place (noPollConn * conn, nopoll_bool * handled)
+{
+	noPollMsg * msg;
+	char      * frame;
+	char      * rbuf;
+	long        payload_size = 0;
+	int         header_size;
+
+	*handled = nopoll_false;
+
+	/* the streaming path is finishing a frame */
+	if (conn->previous_msg || conn->pending_buf_bytes > 0)
+		return NULL;
+
+	if (conn->rbuf_msg && nopoll_msg_ref_count (conn->rbuf_msg) > 1) {
+		/* the last message is still in use: let it keep the
+		 * buffer and move what follows to a new one */
+		rbuf = nopoll_new (char, NOPOLL_RECV_BUF_SIZE + 1);
+		if (rbuf == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Failed to allocate memory for received message, closing session id: %d",
+				    conn->id);
+			nopoll_conn_shutdown (conn);
+			*handled = nopoll_true;
+			return NULL;
+		} /* end if */
+
+		conn->rbuf_len -= conn->rbuf_start;
+		memcpy (rbuf, conn->rbuf + conn->rbuf_start, conn->rbuf_len);
+		if (conn->rbuf_held)
+			rbuf[0] = conn->rbuf_hold;
+
+		conn->rbuf_msg->payload_buf = conn->rbuf;
+		nopoll_msg_unref (conn->rbuf_msg);
+		conn->rbuf_msg   = NULL;
+		conn->rbuf       = rbuf;
+		conn->rbuf_start = 0;
+		conn->rbuf_held  = nopoll_false;
+	} else if (conn->rbuf_held) {
+		conn->rbuf[conn->rbuf_start] = conn->rbuf_hold;
+		conn->rbuf_held = nopoll_false;
+	} /* end if */
+
+	if (conn->rbuf == NULL) {
+		conn->rbuf = nopoll_new (char, NOPOLL_RECV_BUF_SIZE + 1);
+		if (conn->rbuf == NULL)
+			return NULL;
+	} /* end if */
+
+	header_size = __nopoll_conn_frame_in_place (conn, &payload_size);
+	if (header_size == 0) {
+		/* move the partial frame to the front and read more */
+		conn->rbuf_len -= conn->rbuf_start;
+		memmove (conn->rbuf, conn->rbuf + conn->rbuf_start, conn->rbuf_len);
+		conn->rbuf_start = 0;
+
+		*handled = nopoll_true;
+		if (__nopoll_conn_fill_rbuf (conn) <= 0)
+			return NULL;
+
+		header_size = __nopoll_conn_frame_in_place (conn, &payload_size);
+		if (header_size == 0)
+			return NULL;
+	} /* end if */
+
+	if (header_size < 0) {
+		/* too big: streamed, starting with what is buffered */
+		*handled = nopoll_false;
+		return NULL;
+	} /* end if */
+
+	*handled = nopoll_true;
+	frame = conn->rbuf + conn->rbuf_start;
+
+	if (conn->role == NOPOLL_ROLE_LISTENER && ! nopoll_get_bit (frame[1], 7)) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Received websocket frame with mask bit set to zero, closing session id: %d",
+			    conn->id);
+		nopoll_conn_shutdown (conn);
+		return NULL;
+	} /* end if */
+
+	msg = conn->rbuf_msg;
+	if (msg == NULL) {
+		msg = nopoll_msg_new ();
+		if (msg == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Failed to allocate memory for received message, closing session id: %d",
+				    conn->id);
+			nopoll_conn_shutdown (conn);
+			return NULL;
+		} /* end if */
+		msg->in_place  = nopoll_true;
+		conn->rbuf_msg = msg;
+	} /* end if */
+
+	msg->has_fin      = nopoll_get_bit (frame[0], 7);
+	msg->op_code      = frame[0] & 0x0F;
+	msg->is_masked    = nopoll_get_bit (frame[1], 7);
+	msg->payload      = frame + header_size;
+	msg->payload_size = payload_size;
+	msg->remain_bytes = 0;
+	msg->unmask_desp  = 0;
+
+	if (msg->is_masked) {
+		memcpy (msg->mask, frame + header_size - 4, 4);
+		nopoll_conn_mask_content (conn->ctx, (char *) msg->payload, payload_size, msg->mask, 0);
+		msg->unmask_desp = payload_size;
+	} /* end if */
+
+	/* nul terminate the payload like the allocated ones, holding
+	 * the first byte of the next frame until the next call */
+	conn->rbuf_start += header_size + payload_size;
+	conn->rbuf_hold   = conn->rbuf[conn->rbuf_start];
+	conn->rbuf_held   = nopoll_true;
+	conn->rbuf[conn->rbuf_start] = 0;
+
+	if (msg->op_code == NOPOLL_PONG_FRAME) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "PONG received over connection id=%d", conn->id);
+#if NOPOLL_DELIVER_PONG_FRAME
+		nopoll_msg_ref (msg);
+		return msg;
+#else
+		return NULL;
+#endif
+	} /* end if */
+
+	if (msg->op_code == NOPOLL_CLOSE_FRAME) {
+		if (payload_size >= 2) {
+			conn->peer_close_status = nopoll_get_16bit ((const char *) msg->payload);
+			conn->peer_close_reason = nopoll_strdup ((const char *) msg->payload + 2);
+		} /* end if */
+
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Proper connection close frame received id=%d, shutting down", conn->id);
+		nopoll_conn_shutdown (conn);
+		return NULL;
+	} /* end if */
+
+	msg->is_fragment            = conn->previous_was_fragment || msg->has_fin == 0;
+	conn->previous_was_fragment = msg->is_fragment && msg->has_fin == 0;
+
+	/* the caller's reference, the connection keeps its own */
+	nopoll_msg_ref (msg);
+	return msg;
+}
+
 /**
  * @brief Allows to get the next message available on the provided
  * connection. The function returns NULL in the case no message is
@@ -3223,6 +3539,7 @@ noPollMsg   * nopoll_conn_get_msg (noPollConn * conn)
 	noPollMsg * msg;
 	int         ssl_error;
 	int         header_size = 2;
+	nopoll_bool handled;
 #if defined(SHOW_DEBUG_LOG)
 	long        result;
 	(void)result;
@@ -3358,6 +3675,11 @@ noPollMsg   * nopoll_conn_get_msg (noPollConn * conn)
 			return NULL;
 	} /* end if */
 
+	/* frames that fit the receive buffer are parsed in place */
+	msg = __nopoll_conn_get_msg_in_place (conn, &handled);
+	if (handled)
+		return msg;
+
 	if (conn->previous_msg) {
 		nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Reading bytes (previously read %d) from a previous unfinished frame (pending: %d) over conn-id=%d",
 			    conn->previous_msg->payload_size, conn->previous_msg->remain_bytes, conn->id);
@@ -3776,6 +4098,8 @@ read_payload:
  */
 int           __nopoll_conn_send_common (noPollConn * conn, const char * content, long length, nopoll_bool has_fin, long sleep_in_header, noPollOpCode frame_type)
 {
+	noPollIov iov;
+
 //	if (conn == NULL || content == NULL || length == 0 || length < -1)
 	if (conn == NULL || content == NULL || length < -1)
 		return -1;
@@ -3795,6 +4119,13 @@ int           __nopoll_conn_send_common (noPollConn * conn, const char * content
 	}
 	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "nopoll_conn_send_text: Attempting to send %d bytes", (int) length);
 
+	/* frames without the testing pause go out without copies */
+	if (sleep_in_header == 0 && conn->__force_stop_after_header == 0) {
+		iov.base = content;
+		iov.len  = length;
+		return nopoll_conn_send_iov (conn, frame_type, has_fin, &iov, 1);
+	} /* end if */
+
 	/* sending content as client */
 	if (conn->role == NOPOLL_ROLE_CLIENT) {
 		return nopoll_conn_send_frame (conn, /* fin */ has_fin, /* masked */ nopoll_true,
@@ -4501,53 +4832,16 @@ int nopoll_conn_flush_writes (noPollConn * conn, long timeout, int previous_resu
 
 
 /**
- * @internal Function used to send a frame over the provided
- * connection.
- *
- * @param conn The connection where the send operation will hapen.
- *
- * @param fin If the frame to be sent must be flagged as a fin frame.
- *
- * @param masked The frame to be sent is masked or not.
- *
- * @param op_code The frame op code to be configured.
- *
- * @param length The frame payload length.
- *
- * @param content Pointer to the data to be sent in the frame.
- *
- * @return The function returns the number of bytes sent, being @length the
- * max amount of bytes that can be reported as sent by
- * this funciton. This means value reported by this function do not
- * includes headers.  The funciton also returns the following general indications:
- *
- *   N : number of bytes sent (user land bytes sent, without including web socket headers).
- *   0 : no bytes sent (see errno indication). See also \ref nopoll_conn_complete_pending_write
- *  -1 : failure found
- *  -2 : retry operation needed (NOPOLL_EWOULDBLOCK)
+ * @internal Writes the header of a frame carrying length bytes,
+ * picking a random mask (copied to mask) when masked.
  *
+ * @return The header size or -1 if the length can't be encoded.
  */
-int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool masked,
-			    noPollOpCode op_code, long length, noPollPtr content, long sleep_in_header)
-
+static int __nopoll_conn_frame_header (noPollConn * conn, char * header, nopoll_bool fin, nopoll_bool masked,
+				       noPollOpCode op_code, long length, char * mask)
 {
-	char               header[14];
-	int                header_size;
-	char             * send_buffer;
-	int                bytes_written = 0;
-	int                bytes_sent    = 0;
-	char               mask[4];
 	unsigned int       mask_value = 0;
-	int                desp = 0;
-	int                tries;
-#if defined(SHOW_DEBUG_LOG)
-	noPollDebugLevel   level;
-#endif
-
-	/* check for pending send operation */
-	bytes_written = nopoll_conn_complete_pending_write (conn);
-	if (bytes_written < 0)
-		return bytes_written;
+	int                header_size;
 
 	/* clear header */
 	memset (header, 0, 14);
@@ -4567,7 +4861,6 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 #else
 		mask_value = (unsigned int) random ();
 #endif
-		memset (mask, 0, 4);
 		nopoll_set_32bit (mask_value, mask);
 	} /* end if */
 
@@ -4615,6 +4908,64 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 		header_size += 4;
 	} /* end if */
 
+	return header_size;
+}
+
+/**
+ * @internal Function used to send a frame over the provided
+ * connection.
+ *
+ * @param conn The connection where the send operation will hapen.
+ *
+ * @param fin If the frame to be sent must be flagged as a fin frame.
+ *
+ * @param masked The frame to be sent is masked or not.
+ *
+ * @param op_code The frame op code to be configured.
+ *
+ * @param length The frame payload length.
+ *
+ * @param content Pointer to the data to be sent in the frame.
+ *
+ * @return The function returns the number of bytes sent, being @length the
+ * max amount of bytes that can be reported as sent by
+ * this funciton. This means value reported by this function do not
+ * includes headers.  The funciton also returns the following general indications:
+ *
+ *   N : number of bytes sent (user land bytes sent, without including web socket headers).
+ *   0 : no bytes sent (see errno indication). See also \ref nopoll_conn_complete_pending_write
+ *  -1 : failure found
+ *  -2 : retry operation needed (NOPOLL_EWOULDBLOCK)
+ *
+ */
+int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool masked,
+			    noPollOpCode op_code, long length, noPollPtr content, long sleep_in_header)
+
+{
+	char               header[14];
+	int                header_size;
+	char             * send_buffer;
+	int                bytes_written = 0;
+	int                bytes_sent    = 0;
+	char               mask[4];
+	unsigned int       mask_value = 0;
+	int                desp = 0;
+	int                tries;
+#if defined(SHOW_DEBUG_LOG)
+	noPollDebugLevel   level;
+#endif
+
+	/* check for pending send operation */
+	bytes_written = nopoll_conn_complete_pending_write (conn);
+	if (bytes_written < 0)
+		return bytes_written;
+
+	header_size = __nopoll_conn_frame_header (conn, header, fin, masked, op_code, length, mask);
+	if (header_size < 0)
+		return -1;
+	if (masked)
+		mask_value = nopoll_get_32bit (mask);
+
 	/* allocate enough memory to send content */
 	send_buffer = nopoll_new (char, length + header_size + 2);
 	if (send_buffer == NULL) {
@@ -4784,6 +5135,150 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 	return bytes_sent;
 }
 
+/**
+ * @brief Sends a frame whose payload is made of the segments provided,
+ * without building an intermediate message.
+ *
+ * Unmasked frames over plain connections are written as they are with
+ * writev(2) where the platform provides it. Otherwise (client side
+ * masking, TLS, lwIP) the segments are gathered into a buffer kept by
+ * the connection, so no memory is allocated per frame.
+ *
+ * @param conn The connection where the frame will be sent.
+ *
+ * @param op_code The frame op code (\ref NOPOLL_TEXT_FRAME, \ref NOPOLL_BINARY_FRAME...).
+ *
+ * @param has_fin nopoll_false to flag the frame as a fragment with
+ * more to come (FIN = 0).
+ *
+ * @param iov The payload segments.
+ *
+ * @param iovcnt Number of segments.
+ *
+ * @return The same values as \ref nopoll_conn_send_binary: the payload
+ * bytes sent, -1 on failure or -2 when the operation must be retried,
+ * which includes a previous write still pending (see \ref
+ * nopoll_conn_complete_pending_write).
+ */
+int nopoll_conn_send_iov (noPollConn * conn, noPollOpCode op_code, nopoll_bool has_fin,
+			  const noPollIov * iov, int iovcnt)
+{
+	char               header[14];
+	char               mask[4];
+	char             * buffer;
+	nopoll_bool        masked;
+	long               length = 0;
+	long               total;
+	long               desp   = 0;
+	int                header_size;
+	int                bytes_written = 0;
+	int                iterator;
+#if defined(NOPOLL_HAVE_WRITEV)
+	struct iovec       vec[NOPOLL_IOV_MAX];
+#endif
+
+	if (conn == NULL || iovcnt < 0 || (iovcnt > 0 && iov == NULL))
+		return -1;
+
+	if (conn->role == NOPOLL_ROLE_MAIN_LISTENER) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Trying to send content over a master listener connection");
+		return -1;
+	} /* end if */
+
+	for (iterator = 0; iterator < iovcnt; iterator++) {
+		if (iov[iterator].len < 0 || (iov[iterator].len > 0 && iov[iterator].base == NULL))
+			return -1;
+		length += iov[iterator].len;
+	} /* end for */
+
+	/* the rest of a previous frame goes first */
+	if (conn->pending_write) {
+		nopoll_conn_complete_pending_write (conn);
+		if (conn->pending_write)
+			return -2;
+	} /* end if */
+
+	masked      = (conn->role == NOPOLL_ROLE_CLIENT);
+	header_size = __nopoll_conn_frame_header (conn, header, has_fin, masked, op_code, length, mask);
+	if (header_size < 0)
+		return -1;
+	total = header_size + length;
+
+#if defined(NOPOLL_HAVE_WRITEV)
+	if (! masked && conn->send == nopoll_conn_default_send && iovcnt < NOPOLL_IOV_MAX) {
+		vec[0].iov_base = header;
+		vec[0].iov_len  = header_size;
+		for (iterator = 0; iterator < iovcnt; iterator++) {
+			vec[iterator + 1].iov_base = (void *) iov[iterator].base;
+			vec[iterator + 1].iov_len  = iov[iterator].len;
+		} /* end for */
+
+		do {
+			bytes_written = writev (conn->session, vec, iovcnt + 1);
+		} while (bytes_written < 0 && errno == NOPOLL_EINTR);
+
+		if (bytes_written == total)
+			return length;
+		if (bytes_written > 0)
+			desp = bytes_written;
+		else if (errno != NOPOLL_EWOULDBLOCK && errno != NOPOLL_EAGAIN)
+			return -1;
+	} /* end if */
+#endif
+
+	/* gather the frame (or what writev left) into the send buffer */
+	if (conn->send_buf_size < total) {
+		buffer = nopoll_realloc (conn->send_buf, total);
+		if (buffer == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to allocate memory to implement send operation");
+			if (desp > 0)
+				nopoll_conn_shutdown (conn);
+			return -1;
+		} /* end if */
+		conn->send_buf      = buffer;
+		conn->send_buf_size = total;
+	} /* end if */
+	buffer = conn->send_buf;
+
+	memcpy (buffer, header, header_size);
+	total = header_size;
+	for (iterator = 0; iterator < iovcnt; iterator++) {
+		memcpy (buffer + total, iov[iterator].base, iov[iterator].len);
+		total += iov[iterator].len;
+	} /* end for */
+
+	if (masked)
+		nopoll_conn_mask_content (conn->ctx, buffer + header_size, length, mask, 0);
+
+	while (desp < total) {
+		bytes_written = conn->send (conn, buffer + desp, total - desp);
+		if (bytes_written <= 0)
+			break;
+		desp += bytes_written;
+	} /* end while */
+
+	if (desp == total)
+		return length;
+
+	if (desp == 0 && errno != NOPOLL_EWOULDBLOCK && errno != NOPOLL_EAGAIN) {
+		nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Found errno=%d (%s) value while trying to send %d bytes to the WebSocket conn-id=%d",
+			    errno, strerror (errno), (int) total, conn->id);
+		return -1;
+	} /* end if */
+
+	/* hand the rest over to nopoll_conn_complete_pending_write */
+	conn->pending_write              = buffer;
+	conn->pending_write_bytes        = total - desp;
+	conn->pending_write_desp         = desp;
+	conn->pending_write_added_header = desp < header_size ? header_size - desp : 0;
+	conn->send_buf                   = NULL;
+	conn->send_buf_size              = 0;
+
+	if (desp <= header_size)
+		return -2;
+	return desp - header_size;
+}
+
 /**
  * @brief Allows to accept a new incoming WebSocket connection on the
  * provided listener.
@@ -261,6 +261,7 @@ nopoll_bool           nopoll_ctx_register_conn (noPollCtx  * ctx,
 
 			/* update connection list number */
 			ctx->conn_num++;
+			ctx->conn_changes++;
 
 			nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "registered connection id %d, role: %d", conn->id, conn->role);
 
@@ -336,6 +337,7 @@ void           nopoll_ctx_unregister_conn (noPollCtx  * ctx,
 
 			/* update connection list number */
 			ctx->conn_num--;
+			ctx->conn_changes++;
 
 			/* release */
 			nopoll_mutex_unlock (ctx->ref_mutex);
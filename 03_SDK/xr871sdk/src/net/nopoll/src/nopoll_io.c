@@ -40,7 +40,10 @@
 
 typedef struct _noPollSelect {
 	noPollCtx          * ctx;
+	/* sockets watched, kept across waits */
 	fd_set               set;
+	/* sockets reported by the last wait */
+	fd_set               ready;
 	int                  length;
 	int                  max_fds;
 } noPollSelect;
@@ -60,6 +63,7 @@ noPollPtr nopoll_io_wait_select_create (noPollCtx * ctx)
 	
 	/* clear the set */
 	FD_ZERO (&(select->set));
+	FD_ZERO (&(select->ready));
 
 	return select;
 }
@@ -92,7 +96,8 @@ void    nopoll_io_wait_select_clear (noPollCtx * ctx, noPollPtr __fd_group)
 	noPollSelect * select = (noPollSelect *) __fd_group;
 
 	/* clear the fd set */
-	select->length = 0;
+	select->length  = 0;
+	select->max_fds = 0;
 	FD_ZERO (&(select->set));
 
 	/* nothing more to do */
@@ -115,10 +120,11 @@ int nopoll_io_wait_select_wait (noPollCtx * ctx, noPollPtr __fd_group)
 	struct timeval      tv;
 	noPollSelect     * _select = (noPollSelect *) __fd_group;
 
-	/* init wait */
+	/* init wait, on a copy so the set can be reused */
 	tv.tv_sec    = 0;
 	tv.tv_usec   = 500000;
-	result       = select (_select->max_fds + 1, &(_select->set), NULL,   NULL, &tv);
+	_select->ready = _select->set;
+	result       = select (_select->max_fds + 1, &(_select->ready), NULL,   NULL, &tv);
 
 	/* check result */
 	if ((result == NOPOLL_SOCKET_ERROR) && (errno == NOPOLL_EINTR))
@@ -178,7 +184,7 @@ nopoll_bool      nopoll_io_wait_select_is_set (noPollCtx   * ctx,
 {
 	noPollSelect * select = (noPollSelect *) __fd_set;
 	
-	return FD_ISSET (fds, &(select->set));
+	return FD_ISSET (fds, &(select->ready));
 }
 
 
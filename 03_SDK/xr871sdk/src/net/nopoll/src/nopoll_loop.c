@@ -83,19 +83,24 @@ void nopoll_loop_process_data (noPollCtx * ctx, noPollConn * conn)
 {
 	noPollMsg * msg;
 
-	/* call to get messages from the connection */
-	msg = nopoll_conn_get_msg (conn);
-	if (msg == NULL)
-		return;
-
-	/* found message, notify it */
-	if (conn->on_msg)
-		conn->on_msg (ctx, conn, msg, conn->on_msg_data);
-	else if (ctx->on_msg)
-		ctx->on_msg (ctx, conn, msg, ctx->on_msg_data);
+	/* the frames read ahead along with the first one won't wake
+	 * up the wait again, deliver them all */
+	do {
+		/* call to get messages from the connection */
+		msg = nopoll_conn_get_msg (conn);
+		if (msg == NULL)
+			continue;
+
+		/* found message, notify it */
+		if (conn->on_msg)
+			conn->on_msg (ctx, conn, msg, conn->on_msg_data);
+		else if (ctx->on_msg)
+			ctx->on_msg (ctx, conn, msg, ctx->on_msg_data);
+
+		/* release message */
+		nopoll_msg_unref (msg);
+	} while (__nopoll_conn_has_frame_buffered (conn) && nopoll_conn_is_ok (conn));
 
-	/* release message */
-	nopoll_msg_unref (msg);
 	return;
 }
 
@@ -196,6 +201,7 @@ int nopoll_loop_wait (noPollCtx * ctx, long timeout)
 	struct timeval diff;
 	long           ellapsed;
 	int            wait_status;
+	int            conn_changes;
 
 	nopoll_return_val_if_fail (ctx, ctx, -2);
 	nopoll_return_val_if_fail (ctx, timeout >= 0, -2);
@@ -216,13 +222,21 @@ int nopoll_loop_wait (noPollCtx * ctx, long timeout)
 	/* set to keep looping everything this function is called */
 	ctx->keep_looping = nopoll_true;
 
+	/* force the first build of the watching set */
+	conn_changes = ctx->conn_changes - 1;
+
 	while (ctx->keep_looping) {
-		/* ok, now implement wait operation */
-		ctx->io_engine->clear (ctx, ctx->io_engine->io_object);
+		/* rebuild the set only when connections came or went */
+		if (conn_changes != ctx->conn_changes) {
+			conn_changes = ctx->conn_changes;
 
-		/* add all connections */
-		/* nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "Adding connections to watch: %d", ctx->conn_num);  */
-		nopoll_ctx_foreach_conn (ctx, nopoll_loop_register, NULL);
+			/* ok, now implement wait operation */
+			ctx->io_engine->clear (ctx, ctx->io_engine->io_object);
+
+			/* add all connections */
+			/* nopoll_log (ctx, NOPOLL_LEVEL_DEBUG, "Adding connections to watch: %d", ctx->conn_num);  */
+			nopoll_ctx_foreach_conn (ctx, nopoll_loop_register, NULL);
+		} /* end if */
 
 		/* if (errno == EBADF) { */
 			/* detected some descriptor not properly
@@ -308,7 +308,10 @@ void         nopoll_msg_unref (noPollMsg * msg)
 	nopoll_mutex_destroy (msg->ref_mutex);
 
 	/* free websocket message */
-	nopoll_free (msg->payload);
+	if (msg->in_place)
+		nopoll_free (msg->payload_buf);
+	else
+		nopoll_free (msg->payload);
 	nopoll_free (msg);
 
 	/* release mutex here */
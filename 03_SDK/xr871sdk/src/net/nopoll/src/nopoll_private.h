@@ -108,6 +108,13 @@ struct _noPollCtx {
 	 */
 	int               conn_num;
 
+	/**
+	 * @internal Bumped every time a connection is registered,
+	 * unregistered or shut down, so \ref nopoll_loop_wait only
+	 * rebuilds its watching set when it changed.
+	 */
+	int               conn_changes;
+
 	/**
 	 * @internal Reference to defined on accept handling.
 	 */
@@ -352,6 +359,30 @@ struct _noPollConn {
 	 */
 	nopoll_bool           read_pending_header;
 
+	/**
+	 * @internal Receive buffer where frames are parsed in place,
+	 * the bytes not consumed yet are rbuf_start..rbuf_len. The
+	 * byte at rbuf_start is rbuf_hold while rbuf_held is set,
+	 * hidden by the nul terminator of the last payload.
+	 */
+	char                * rbuf;
+	int                   rbuf_start;
+	int                   rbuf_len;
+	char                  rbuf_hold;
+	nopoll_bool           rbuf_held;
+
+	/**
+	 * @internal Message reused to report the frames parsed in
+	 * place while the application doesn't keep it.
+	 */
+	noPollMsg           * rbuf_msg;
+
+	/**
+	 * @internal Buffer reused to gather the frames sent.
+	 */
+	char                * send_buf;
+	int                   send_buf_size;
+
 
 	/**** debug values ****/
 	/* force stop after header: do not use this, it is just for
@@ -386,6 +417,11 @@ struct _noPollMsg {
 
 	nopoll_bool    is_fragment;
 	int            unmask_desp;
+
+	/* payload parsed in place: it points into payload_buf, which is
+	 * NULL while the connection still owns the buffer */
+	nopoll_bool    in_place;
+	noPollPtr      payload_buf;
 };
 
 struct _noPollHandshake {
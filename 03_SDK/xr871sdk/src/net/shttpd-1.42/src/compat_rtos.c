@@ -28,15 +28,28 @@
  */
 
 #include "defs.h"
+#if defined(SHTTPD_CONTENT_FATFS)
+#include "fs/fatfs/ff.h"
+#endif
 
 struct local {
 	struct llhead	link;
 	const char      *name;
-	char            *body;
+	const char      *body;
+	unsigned long	len;
+	const char      *gz_body;
+	unsigned long	gz_len;
+	unsigned long	etag;
 	unsigned long	mode;
 };
 
-struct llhead	registered_file;
+struct llhead	registered_file = {&registered_file, &registered_file};
+
+int _shttpd_add_file(struct local *file);
+
+#if defined(SHTTPD_CONTENT_FATFS)
+static char	*content_dir;
+#endif
 
 time_t TIME(time_t *timer)
 {
@@ -63,6 +76,46 @@ void *_shttpd_zalloc(size_t size)
 	return buf;
 }
 
+/* FNV-1a, the entity tag of content registered without one */
+static unsigned long content_hash(const void *data, unsigned long len)
+{
+	const unsigned char *p = data;
+	uint32_t h = 2166136261U;
+
+	while (len-- > 0)
+		h = (h ^ *p++) * 16777619U;
+	return h;
+}
+
+static int add_content(const struct usr_content *content)
+{
+	struct local *file;
+
+	if ((file = _shttpd_zalloc(sizeof(*file))) == NULL) {
+		_shttpd_elog(E_LOG, NULL, "add content _shttpd_zalloc failed.");
+		return -1;
+	}
+	file->name = content->name;
+	file->mode = (file->name[strlen(file->name)-1]
+	             == '/')? _S_IFDIR : _S_IFREG;
+	if (file->mode == _S_IFREG) {
+		file->body = content->body;
+		file->len = content->len;
+		if (content->gz_body != NULL) {
+			file->gz_body = content->gz_body;
+			file->gz_len = content->gz_len;
+		}
+		file->etag = content->etag ? content->etag :
+		             content_hash(file->body, file->len);
+	}
+	if (_shttpd_add_file(file) != 0) {
+		_shttpd_elog(E_LOG, NULL, "%s registered twice", file->name);
+		_shttpd_free(file);
+		return -1;
+	}
+	return 0;
+}
+
 void _shttpd_init_local_file(const struct usr_file *list, int count)
 {
 	if (list == NULL || count == 0) {
@@ -70,28 +123,71 @@ void _shttpd_init_local_file(const struct usr_file *list, int count)
 		return;
 	}
 	int i = 0;
-	struct local *file = NULL;
+	struct usr_content content;
 
-	LL_INIT(&registered_file);
-	for (i = 0; i < count; i++) {
-		if ((file = _shttpd_zalloc(sizeof(*file))) == NULL)
-		{
-			_shttpd_elog(E_LOG, NULL, "init local file _shttpd_zalloc failed.");
+	memset(&content, 0, sizeof(content));
+	for (i = 0; i < count && list[i].name != NULL; i++) {
+		content.name = list[i].name;
+		content.body = list[i].body;
+		content.len = list[i].body ? strlen(list[i].body) : 0;
+		if (add_content(&content) != 0)
 			return;
+	}
+}
+
+int _shttpd_add_local_content(const struct usr_content *list, int count)
+{
+	int i;
+
+	if (list == NULL) {
+		_shttpd_elog(E_LOG, NULL, "invalid param (%s)",__func__);
+		return -1;
+	}
+	for (i = 0; i < count && list[i].name != NULL; i++) {
+		if (add_content(&list[i]) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+int _shttpd_mount_content_image(const void *image, unsigned long size)
+{
+	const struct content_image_hdr *hdr = image;
+	const struct content_image_entry *ent;
+	const char *base = image;
+	struct usr_content content;
+	int i;
+
+	if (image == NULL || size < sizeof(*hdr) ||
+	    hdr->magic != CONTENT_IMAGE_MAGIC ||
+	    hdr->version != CONTENT_IMAGE_VERSION || hdr->size > size ||
+	    hdr->count > (hdr->size - sizeof(*hdr)) / sizeof(*ent)) {
+		_shttpd_elog(E_LOG, NULL, "invalid content image (%s)",__func__);
+		return -1;
+	}
+	size = hdr->size;
+	ent = (const struct content_image_entry *)(hdr + 1);
+	for (i = 0; i < hdr->count; i++, ent++) {
+		if (ent->name >= size ||
+		    memchr(base + ent->name, '\0', size - ent->name) == NULL ||
+		    ent->body > size || ent->len > size - ent->body ||
+		    ent->gz_body > size || ent->gz_len > size - ent->gz_body) {
+			_shttpd_elog(E_LOG, NULL, "bad content image entry %d", i);
+			return -1;
 		}
-		if (list[i].name != NULL) {
-			file->name = list[i].name;
-			file->mode = (file->name[strlen(file->name)-1]
-				             == '/')? _S_IFDIR : _S_IFREG;
-			if (file->mode == _S_IFREG)
-				file->body = list[i].body;
-		} else
-			break;
-		LL_ADD(&registered_file, &file->link);
+		content.name = base + ent->name;
+		content.body = base + ent->body;
+		content.len = ent->len;
+		content.gz_body = ent->gz_body ? base + ent->gz_body : NULL;
+		content.gz_len = ent->gz_len;
+		content.etag = ent->etag;
+		if (add_content(&content) != 0)
+			return -1;
 	}
+	return 0;
 }
 
-void _shttpd_deinit_local_file()
+void _shttpd_deinit_local_file(void)
 {
 	struct llhead *lp, *tmp;
 	struct local *local_file = NULL;
@@ -101,6 +197,10 @@ void _shttpd_deinit_local_file()
 		LL_DEL(&local_file->link);
 		_shttpd_free(local_file);
 	}
+#if defined(SHTTPD_CONTENT_FATFS)
+	_shttpd_free(content_dir);
+	content_dir = NULL;
+#endif
 }
 
 int _shttpd_add_file(struct local *file)
@@ -154,18 +254,177 @@ void _shttpd_set_close_on_exec(int fd)
 {
 }
 
+#if defined(SHTTPD_CONTENT_FATFS)
+int _shttpd_mount_content_dir(const char *dir)
+{
+	char *d = NULL;
+
+	if (dir != NULL && (d = _shttpd_strdup(dir)) == NULL)
+		return -1;
+	_shttpd_free(content_dir);
+	content_dir = d;
+	return 0;
+}
+
+/* The request path is looked up below the content directory */
+static int fatfs_path(char *buf, size_t size, const char *path,
+                      const char *suffix)
+{
+	int n;
+
+	while (path[0] == '.' && IS_DIRSEP_CHAR(path[1]))
+		path += 2;
+	while (IS_DIRSEP_CHAR(*path))
+		path++;
+	n = snprintf(buf, size, "%s/%s%s", content_dir, path, suffix);
+	if (n < 0 || (size_t)n >= size)
+		return -1;
+	if (n > 0 && IS_DIRSEP_CHAR(buf[n - 1]))
+		buf[n - 1] = '\0';
+	return 0;
+}
+
+static int fatfs_stat(const char *path, const char *suffix, struct stat *stp)
+{
+	FILINFO *info;
+	char *fpath;
+	int ret = -1;
+
+	info = _shttpd_zalloc(sizeof(*info));
+	fpath = _shttpd_zalloc(FILENAME_MAX);
+	if (info == NULL || fpath == NULL ||
+	    fatfs_path(fpath, FILENAME_MAX, path, suffix) != 0)
+		goto out;
+	if (strcmp(fpath, content_dir) == 0) {
+		/* f_stat() does not take the directory itself */
+		stp->st_mode = _S_IFDIR;
+		stp->st_size = 0;
+		ret = 0;
+	} else if (f_stat(fpath, info) == FR_OK) {
+		stp->st_mode = (info->fattrib & AM_DIR) ? _S_IFDIR : _S_IFREG;
+		stp->st_size = info->fsize;
+		stp->st_etag = ((unsigned long)info->fdate << 16 | info->ftime) ^
+		               content_hash(&info->fsize, sizeof(info->fsize));
+		ret = 0;
+	}
+out:
+	_shttpd_free(fpath);
+	_shttpd_free(info);
+	return ret;
+}
+
+/* Only the one copy of f_read() into the stream buffer, see io_file.c */
+static int fatfs_open(struct conn *c, const char *path, int gzip,
+                      struct stat *stp)
+{
+	struct stat gz;
+	char *fpath;
+	FIL *fp;
+	int ret = -1;
+
+	fp = _shttpd_zalloc(sizeof(*fp));
+	fpath = _shttpd_zalloc(FILENAME_MAX);
+	if (fp == NULL || fpath == NULL)
+		goto out;
+	memset(&gz, 0, sizeof(gz));
+	if (gzip && fatfs_stat(path, ".gz", &gz) == 0 &&
+	    fatfs_path(fpath, FILENAME_MAX, path, ".gz") == 0 &&
+	    f_open(fp, fpath, FA_READ) == FR_OK) {
+		stp->st_size = gz.st_size;
+		stp->st_etag = gz.st_etag;
+		stp->st_gzip = 1;
+		ret = 0;
+	} else if (fatfs_path(fpath, FILENAME_MAX, path, "") == 0 &&
+	           f_open(fp, fpath, FA_READ) == FR_OK) {
+		ret = 0;
+	}
+out:
+	_shttpd_free(fpath);
+	if (ret == 0) {
+		c->loc.chan.fil = fp;
+	} else {
+		_shttpd_free(fp);
+	}
+	return ret;
+}
+#endif /* SHTTPD_CONTENT_FATFS */
+
 int _shttpd_stat(const char *path, struct stat *stp)
 {
-        struct local *file;
-	 if (_shttpd_lookup_file(&file, path) != 0) {
-	 	_shttpd_elog(E_LOG, NULL, "file path mismatch (%s).", __func__);
+	struct local *file;
+
+	memset(stp, 0, sizeof(*stp));
+	if (_shttpd_lookup_file(&file, path) != 0) {
+#if defined(SHTTPD_CONTENT_FATFS)
+		if (content_dir != NULL && fatfs_stat(path, "", stp) == 0)
+			return 0;
+#endif
+		_shttpd_elog(E_LOG, NULL, "file path mismatch (%s).", __func__);
 		return -1;
-	 }
+	}
 	stp->st_mode = file->mode;
-	if (stp->st_mode == _S_IFREG)
-		stp->st_size = strlen(file->body);
-	else
-		stp->st_size = 0;
+	if (stp->st_mode == _S_IFREG) {
+		stp->st_size = file->len;
+		stp->st_etag = file->etag;
+	}
+	stp->st_local = file;
+	return 0;
+}
+
+/*
+ * "gzip" is acceptable if listed, or matched by "*", without "q=0".
+ */
+static int accepts_gzip(const struct vec *ae)
+{
+	const char *s = ae->ptr, *e = ae->ptr + ae->len, *p, *q;
+
+	while (s < e) {
+		while (s < e && (*s == ' ' || *s == ','))
+			s++;
+		for (p = s; p < e && *p != ','; p++)
+			;
+		for (q = s; q < p && *q != ';' && *q != ' '; q++)
+			;
+		if ((q - s == 4 && _shttpd_strncasecmp(s, "gzip", 4) == 0) ||
+		    (q - s == 1 && *s == '*')) {
+			while (q < p && *q != '=')
+				q++;
+			if (q == p)
+				return 1;
+			for (q++; q < p && (*q == '0' || *q == '.' || *q == ' '); q++)
+				;
+			return q < p;
+		}
+		s = p;
+	}
+	return 0;
+}
+
+/*
+ * Open the content found by _shttpd_stat(), picking its gzip variant if
+ * the client takes it. Registered content is pointed to by chan.fh.
+ */
+int _shttpd_open_content(struct conn *c, const char *path, struct stat *stp)
+{
+	struct local *file = stp->st_local;
+	int gzip = c->ch.ae.v_vec.len > 0 && accepts_gzip(&c->ch.ae.v_vec);
+
+	if (file == NULL) {
+#if defined(SHTTPD_CONTENT_FATFS)
+		return fatfs_open(c, path, gzip, stp);
+#else
+		return -1;
+#endif
+	}
+	if (file->mode != _S_IFREG)
+		return -1;
+	if (gzip && file->gz_body != NULL) {
+		c->loc.chan.fh = (char *)file->gz_body;
+		stp->st_size = file->gz_len;
+		stp->st_gzip = 1;
+	} else {
+		c->loc.chan.fh = (char *)file->body;
+	}
 	return 0;
 }
 
@@ -178,7 +437,7 @@ char* _shttpd_open(const char *path, int flags, int mode)
 		return NULL;
 	}
 	if (file->mode == _S_IFREG)
-			return file->body;
+			return (char *)file->body;
 		else
 			return NULL;
 }
@@ -9,6 +9,9 @@
  */
 
 #include "defs.h"
+#if defined(SHTTPD_CONTENT_FATFS)
+#include "fs/fatfs/ff.h"
+#endif
 
 static int
 write_file(struct stream *stream, const void *buf, size_t len)
@@ -95,8 +98,9 @@ read_file(struct stream *stream, void *buf, size_t len)
 #else
 	int sent_length = 0;
 	sent_length = len;
-	char *fp = (char *)stream->conn->loc.chan.fh;
+	char *fp = stream->conn->loc.chan.fh;
 	memcpy(buf, fp + stream->io.total, sent_length);
+	stream->conn->ctx->stats.bytes_copied += sent_length;
 	return sent_length;
 #endif
 }
@@ -108,15 +112,69 @@ close_file(struct stream *stream)
 	assert(stream->chan.fd != -1);
 	(void) close(stream->chan.fd);
 #else
-	stream->conn->loc.chan.fh = 0;
+	stream->conn->loc.chan.fh = NULL;
 	//stream->conn->loc.chan.fi.filelength = 0;
 #endif
 }
 
+#if defined(SHTTPD_CONTENT_FATFS)
+static int
+read_fatfs(struct stream *stream, void *buf, size_t len)
+{
+	UINT	n;
+
+	if (f_read(stream->chan.fil, buf, len, &n) != FR_OK)
+		return (0);
+	stream->conn->ctx->stats.bytes_copied += n;
+	return (n);
+}
+
+static void
+close_fatfs(struct stream *stream)
+{
+	(void) f_close(stream->chan.fil);
+	_shttpd_free(stream->chan.fil);
+	stream->chan.fil = NULL;
+}
+
+static const struct io_class	io_fatfs =  {
+	"fatfs",
+	read_fatfs,
+	NULL,
+	close_fatfs
+};
+#endif /* SHTTPD_CONTENT_FATFS */
+
+#if !defined(SHTTPD_FS)
+/*
+ * Return TRUE if the If-None-Match: list has the etag, or is "*".
+ */
+static int
+match_etag(const struct vec *inm, const char *etag)
+{
+	const char	*s = inm->ptr, *e = inm->ptr + inm->len;
+	size_t		len = strlen(etag);
+
+	for (; s < e; s++) {
+		if (*s == '*')
+			return (TRUE);
+		if (*s != '"')
+			continue;
+		if ((size_t) (e - s) > len + 1 && s[len + 1] == '"' &&
+		    memcmp(s + 1, etag, len) == 0)
+			return (TRUE);
+		for (s++; s < e && *s != '"'; s++)
+			;
+	}
+
+	return (FALSE);
+}
+#endif /* !SHTTPD_FS */
+
 void
 _shttpd_get_file(struct conn *c, struct stat *stp)
 {
-	char		date[64], lm[64], etag[64], range[64] = "";
+	char		date[64], lm[64], etag[64], range[64] = "", enc[64] = "";
 	size_t	 status = 200;
 	const char	*fmt = "%a, %d %b %Y %H:%M:%S GMT", *msg = "OK";
 	big_int_t	cl = 0; /* Content-Length */
@@ -157,8 +215,34 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 	(void) _shttpd_snprintf(etag, sizeof(etag), "%lx.%lx",
 	    (unsigned long) stp->st_mtime, (unsigned long) stp->st_size);
 #else
-	(void) _shttpd_snprintf(etag, sizeof(etag), "%lx.%lx",
-		(unsigned long)_shttpd_current_time, (unsigned long) stp->st_size);
+	/* Each variant has its own tag, both vary on Accept-Encoding */
+	(void) _shttpd_snprintf(etag, sizeof(etag), "%08lx%s",
+	    stp->st_etag, stp->st_gzip ? "-gz" : "");
+	(void) _shttpd_snprintf(enc, sizeof(enc), "%sVary: Accept-Encoding\r\n",
+	    stp->st_gzip ? "Content-Encoding: gzip\r\n" : "");
+#if defined(SHTTPD_CONTENT_FATFS)
+	c->loc.io_class = stp->st_local == NULL ? &io_fatfs : &_shttpd_io_file;
+#else
+	c->loc.io_class = &_shttpd_io_file;
+#endif
+	c->ctx->stats.responses++;
+
+	if (c->ch.inm.v_vec.len > 0 && match_etag(&c->ch.inm.v_vec, etag)) {
+		c->loc.io.head = c->loc.headers_len = _shttpd_snprintf(
+		    c->loc.io.buf, c->loc.io.size,
+		    "HTTP/1.1 304 Not Modified\r\n"
+		    "Date: %s\r\n"
+		    "Etag: \"%s\"\r\n"
+		    "%s\r\n",
+		    date, etag, enc);
+		c->status = 304;
+		c->loc.content_len = 0;
+		c->ctx->stats.not_modified++;
+		_shttpd_stop_stream(&c->loc);
+		return;
+	}
+	if (stp->st_gzip)
+		c->ctx->stats.gzip++;
 #endif
 
 	/*
@@ -175,13 +259,33 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 	    "Content-Type: %.*s\r\n"
 	    "Content-Length: %lu\r\n"
 	    "Accept-Ranges: bytes\r\n"
-	    "%s\r\n",
+	    "%s%s\r\n",
 	    status, msg, date, lm, etag,
-	    c->mime_type.len, c->mime_type.ptr, cl, range);
+	    c->mime_type.len, c->mime_type.ptr, cl, range, enc);
 
 	c->status = status;
 	c->loc.content_len = cl;
+#if defined(SHTTPD_FS)
 	c->loc.io_class = &_shttpd_io_file;
+#else
+	/*
+	 * Registered content stays put, so it goes to a plain socket right
+	 * from where it is stored (RAM or XIP flash) without the copy into
+	 * the stream buffer, see write_static() in shttpd.c. A small body
+	 * is cheaper to copy behind the headers and send in one segment.
+	 */
+	if (stp->st_local != NULL && c->method != METHOD_HEAD &&
+	    cl <= STATIC_INLINE_MAX && cl <= io_space_len(&c->loc.io)) {
+		(void) memcpy(io_space(&c->loc.io), c->loc.chan.fh, cl);
+		io_inc_head(&c->loc.io, cl);
+		c->ctx->stats.bytes_copied += cl;
+		_shttpd_stop_stream(&c->loc);
+		return;
+	} else if (stp->st_local != NULL &&
+	    c->rem.io_class == &_shttpd_io_socket) {
+		c->loc.flags |= FLAG_STATIC;
+	} else
+#endif
 	c->loc.flags |= FLAG_R | FLAG_ALWAYS_READY;
 
 	if (c->method == METHOD_HEAD)
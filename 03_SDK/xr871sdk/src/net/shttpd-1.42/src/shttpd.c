@@ -48,6 +48,8 @@ static const struct http_header http_headers[] = {
 	{7,  HDR_STRING, OFFSET(range),		"Range: "		},
 	{12, HDR_STRING, OFFSET(connection),	"Connection: "		},
 	{19, HDR_STRING, OFFSET(transenc),	"Transfer-Encoding: "	},
+	{17, HDR_STRING, OFFSET(ae),		"Accept-Encoding: "	},
+	{15, HDR_STRING, OFFSET(inm),		"If-None-Match: "	},
 	{0,  HDR_INT,	 0,			NULL			}
 };
 
@@ -167,7 +169,7 @@ _shttpd_stop_stream(struct stream *stream)
 
 	stream->io_class= NULL;
 	stream->flags |= FLAG_CLOSED;
-	stream->flags &= ~(FLAG_R | FLAG_W | FLAG_ALWAYS_READY);
+	stream->flags &= ~(FLAG_R | FLAG_W | FLAG_ALWAYS_READY | FLAG_STATIC);
 
 	DBG(("%d %s stopped. %lu of content data, %d now in a buffer",
 	    stream->conn->rem.chan.sock,
@@ -693,7 +695,7 @@ decide_what_to_do(struct conn *c)
 	} else if (_shttpd_match_extension(path,
 	    c->ctx->options[OPT_SSI_EXTENSIONS])) {
 #if !defined(SHTTPD_FS)
-	    	if ((c->loc.chan.fh =(unsigned int)_shttpd_open(path, 0, 0)) == 0) {
+	    	if ((c->loc.chan.fh = _shttpd_open(path, 0, 0)) == NULL) {
 #else
 		if ((c->loc.chan.fd = _shttpd_open(path,
 		    O_RDONLY | O_BINARY, 0644)) == -1) {
@@ -710,8 +712,7 @@ decide_what_to_do(struct conn *c)
 	    O_RDONLY | O_BINARY, 0644)) != -1) {
 		_shttpd_get_file(c, &st);
 #else
-	}
-	else if ((c->loc.chan.fh = (unsigned int)_shttpd_open(path, 0, 0)) != 0) {
+	} else if (_shttpd_open_content(c, path, &st) == 0) {
 		_shttpd_get_file(c, &st);
 #endif
 	} else {
@@ -830,6 +831,7 @@ add_socket(struct worker *worker, int sock, int is_ssl)
 	struct conn		*c;
 	struct usa		sa;
 	int			l = IS_TRUE(ctx, OPT_INETD) ? E_FATAL : E_LOG;
+	int			on = 1;
 	l = l;
 #if defined(SHTTPD_SSL)
 	SSL_CTX        *ssl_ctx = ctx->ssl_ctx;
@@ -848,6 +850,10 @@ add_socket(struct worker *worker, int sock, int is_ssl)
 
 	sa.len = sizeof(sa.u.sin);
 	(void) _shttpd_set_non_blocking_mode(sock);
+	/* Static bodies follow their headers in a second write, see
+	 * write_static(), which must not wait for the headers to be acked */
+	(void) setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+	    (char *) &on, sizeof(on));
 
 	if (getpeername(sock, &sa.u.sa, &sa.len)) {
 		_shttpd_elog(E_LOG, NULL, "add_socket: %s", strerror(ERRNO));
@@ -1036,6 +1042,37 @@ write_stream(struct stream *from, struct stream *to)
 		_shttpd_stop_stream(to);
 }
 
+#if !defined(SHTTPD_FS)
+/*
+ * Send the static content in place, once the headers are out. The socket
+ * queues it by reference (MSG_NOCOPY), so it is not copied to a buffer.
+ */
+static void
+write_static(struct conn *c)
+{
+	struct stream	*loc = &c->loc;
+	int		n;
+
+	n = send(c->rem.chan.sock, loc->chan.fh + loc->io.total,
+	    loc->content_len - loc->io.total, MSG_NOCOPY);
+	c->expire_time = _shttpd_current_time + EXPIRE_TIME;
+	DBG(("write_static (%d): written %d/%lu bytes (ERRNO %d)",
+	    c->rem.chan.sock, n,
+	    (unsigned long) (loc->content_len - loc->io.total), ERRNO));
+	if (n > 0) {
+		loc->io.total += n;
+		c->ctx->stats.bytes_nocopy += n;
+		if (loc->io.total == loc->content_len)
+			_shttpd_stop_stream(loc);
+	} else if (n == -1 && (ERRNO == EINTR || ERRNO == EWOULDBLOCK)) {
+		n = n;	/* Ignore EINTR and EAGAIN */
+	} else {
+		_shttpd_stop_stream(loc);
+		_shttpd_stop_stream(&c->rem);
+	}
+}
+#endif /* !SHTTPD_FS */
+
 static void
 connection_desctructor(struct llhead *lp)
 {
@@ -1080,7 +1117,7 @@ connection_desctructor(struct llhead *lp)
 
 	/* Keep the connection open only if we have Content-Length set */
 
-	if (!do_close && c->loc.content_len > 0) {
+	if (!do_close && (c->loc.content_len > 0 || c->status == 304)) {
 		DBG(("Keep connection.\n"));
 		c->loc.io_class = NULL;
 		c->loc.flags = 0;
@@ -1176,6 +1213,11 @@ process_connection(struct conn *c, int remote_ready, int local_ready)
 		write_stream(&c->loc, &c->rem);
 	}
 
+#if !defined(SHTTPD_FS)
+	if ((c->loc.flags & FLAG_STATIC) && io_data_len(&c->loc.io) == 0)
+		write_static(c);
+#endif
+
 	/* Check whether we should close this connection */
 	if ((_shttpd_current_time > c->expire_time) ||
 	    (c->rem.flags & FLAG_CLOSED) ||
@@ -1277,7 +1319,8 @@ multiplex_worker_sockets(const struct worker *worker, int *max_fd,
 		 * If there is some data read from local endpoint, check the
 		 * remote socket for write availability
 		 */
-		if (io_data_len(&c->loc.io) && !(c->loc.flags & FLAG_SUSPEND)) {
+		if ((io_data_len(&c->loc.io) || (c->loc.flags & FLAG_STATIC)) &&
+		    !(c->loc.flags & FLAG_SUSPEND)) {
 #if defined(SHTTPD_FS)
 			add_to_set(c->rem.chan.fd, write_set, max_fd);
 #else
@@ -1412,6 +1455,12 @@ shttpd_poll(struct shttpd_ctx *ctx, int milliseconds)
 		process_worker_sockets(first_worker(ctx), &read_set);
 }
 
+void
+shttpd_get_stats(struct shttpd_ctx *ctx, struct shttpd_stats *stats)
+{
+	*stats = ctx->stats;
+}
+
 /*
  * Deallocate shttpd object, free up the resources
  */
@@ -28,12 +28,27 @@
  */
 
 #include "net/sntp/sntp.h"
+#ifdef __CONFIG_OS_POSIX
+/* host build, over the host sockets and the monotonic clock */
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#define closesocket(s)              close(s)
+#else
 #include "lwip/sockets.h"
 #include "lwip/inet.h"
 #include "lwip/netdb.h"
+#include "driver/chip/hal_rtc.h"
+#endif
+#include "kernel/os/os.h"
+#include "sys/interrupt.h"
 #include "time.h"
 #include "string.h"
 #include "stdlib.h"
+#include "stdio.h"
 #include "errno.h"
 
 #define SNTP_DEBUG(msg, arg...)    //printf("[sntp debug] <%s : %d> " msg "\n", __func__, __LINE__, ##arg)
@@ -44,17 +59,38 @@
 /* SNTP protocol defines */
 #define SNTP_MSG_LEN                48
 #define SNTP_LI_NO_WARNING          0x00
+#define SNTP_LI_MASK                0xC0
+#define SNTP_LI_ALARM               0xC0 /* server clock not synchronized */
 #define SNTP_VERSION                3 /* NTP Version */
 #define SNTP_MODE_MASK              0x07
 #define SNTP_MODE_CLIENT            0x03
 #define SNTP_MODE_SERVER            0x04
 #define SNTP_MODE_BROADCAST         0x05
 #define SNTP_STRATUM_KOD            0x00
+#define SNTP_STRATUM_MAX            15
 /* number of seconds between 1900 and 1970 */
 #define DIFF_SEC_1900_1970         (2208988800UL)
 /* number of seconds between 1970 and Feb 7, 2036 (6:28:16 UTC) (MSB=0) */
 #define DIFF_SEC_1970_2036         (2085978496UL)
 
+/* clock filter, selection and discipline */
+#if SNTP_SUPPORT_MULTIPLE_SERVERS
+#define SNTP_MAX_PEERS              SNTP_MAX_SERVERS
+#else
+#define SNTP_MAX_PEERS              1
+#endif
+#define SNTP_MIN_DIST               10000   /* us, floor of a server's root distance */
+#define SNTP_STEP_THRESHOLD         128000  /* us, larger corrections step the clock */
+#define SNTP_SLEW_TIME              4000000 /* us, time to slew a correction in */
+#define SNTP_MAX_SLEW               500000  /* ppb */
+#define SNTP_MAX_FREQ               500000  /* ppb */
+#ifndef SNTP_FREQ_MIN_SPAN
+#define SNTP_FREQ_MIN_SPAN          60000000LL   /* us, shortest span to measure the frequency */
+#endif
+#define SNTP_FREQ_MAX_SPAN          14400000000LL /* us, restart the measurement after 4 hours */
+
+#define SNTP_PPB                    1000000000LL
+
 typedef struct
 {
   uint8_t li_vn_mode;	   // Eight bits. li, vn, and mode.
@@ -83,30 +119,55 @@ typedef struct
   uint32_t txTm_f;		   // 32 bits. Transmit time-stamp fraction of a second.
 } ntp_packet;			   // Total: 384 bits or 48 bytes.
 
-static sntp_time g_time;
+typedef struct {
+	int64_t offset;       /* us, server time minus the local clock */
+	int32_t delay;        /* us, round trip delay */
+	uint64_t t4;          /* local time the reply arrived */
+} sntp_sample;
 
-#if SNTP_SUPPORT_MULTIPLE_SERVERS
 typedef struct {
-  struct in_addr addr;
-} sntp_server_info;
+	struct sockaddr_in addr;
+	sntp_sample sample[SNTP_MAX_SAMPLES];
+	uint8_t nsample;
+	uint8_t pending;      /* a request is in flight */
+	uint8_t dead;         /* kiss-o'-death received */
+	uint8_t stratum;
+	int32_t root;         /* us, root delay / 2 + root dispersion */
+	uint32_t nonce[2];    /* transmit timestamp of the request in flight */
+	uint64_t t1;          /* local time the request was sent */
+	/* clock filter output */
+	int64_t offset;
+	uint64_t t4;
+	int32_t delay;
+	int32_t jitter;
+	int32_t dist;         /* us, root distance */
+} sntp_peer;
 
-static sntp_server_info sntp_servers[SNTP_MAX_SERVERS];
+/*
+ * The local clock is a hardware free running counter in microseconds. It's
+ * mapped to UTC piecewise linearly, from the start of the current segment:
+ *   UTC(t) = utc + (t - base) * (1 + freq + slew)
+ * where slew only applies up to slew_end, to slew a correction in.
+ */
+typedef struct {
+	uint8_t synced;
+	int32_t freq;         /* ppb */
+	int32_t slew;         /* ppb */
+	uint64_t base;
+	int64_t utc;
+	uint64_t slew_end;
+	/* frequency measurement, from this point on */
+	uint64_t anchor;
+	int64_t anchor_utc;
+} sntp_model;
+
+static sntp_model g_model;
+static sntp_status g_status;
 
-static const struct in_addr* sntp_get_server_addr(uint8_t idx)
-{
-	if (idx < SNTP_MAX_SERVERS) {
-		return &sntp_servers[idx].addr;
-	}
-	return INADDR_ANY;
-}
+static sntp_time g_time;
 
-static int sntp_set_server_addr(uint8_t idx, struct in_addr *server_addr)
-{
-	if (idx >= SNTP_MAX_SERVERS)
-		return -1;
-	sntp_servers[idx].addr.s_addr = server_addr->s_addr;
-	return 0;
-}
+#if SNTP_SUPPORT_MULTIPLE_SERVERS
+static struct in_addr sntp_servers[SNTP_MAX_SERVERS];
 
 /**
   * @brief Set the remote ntp server address by name.
@@ -128,193 +189,558 @@ int sntp_set_server(uint8_t idx, char *server)
 		return -1;
 	}
 
-	sntp_set_server_addr(idx, (struct in_addr *)host->h_addr);
+	sntp_servers[idx].s_addr = ((struct in_addr *)host->h_addr)->s_addr;
 	return 0;
 }
 #endif
 
-static void sntp_init_request_packet(ntp_packet *packet)
+static __inline uint64_t sntp_local_us(void)
+{
+#ifdef __CONFIG_OS_POSIX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	return HAL_RTC_GetFreeRunTime();
+#endif
+}
+
+/* dt * ppb / 10^9, without overflowing for long dt */
+static __inline int64_t sntp_scale(int64_t dt, int32_t ppb)
+{
+	return dt / 1000000 * ppb / 1000 + dt % 1000000 * ppb / SNTP_PPB;
+}
+
+static int64_t sntp_model_utc(const sntp_model *m, uint64_t t)
+{
+	int64_t dt, utc;
+
+	if (!m->synced)
+		return (int64_t)t;
+
+	dt = (int64_t)(t - m->base);
+	utc = m->utc + dt + sntp_scale(dt, m->freq);
+	if (t > m->slew_end)
+		utc += sntp_scale((int64_t)(m->slew_end - m->base), m->slew);
+	else
+		utc += sntp_scale(dt, m->slew);
+	return utc;
+}
+
+static int64_t sntp_ntp_to_us(uint32_t sec, uint32_t frac)
+{
+	int64_t s;
+
+	s = (sec & 0x80000000) ? (int64_t)sec - DIFF_SEC_1900_1970
+	                       : (int64_t)sec + DIFF_SEC_1970_2036;
+	return s * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+/* NTP short format, 16.16 seconds, to microseconds */
+static __inline int32_t sntp_short_to_us(uint32_t v)
 {
-	struct timeval local_time;
+	return (int32_t)(((uint64_t)v * 1000000) >> 16);
+}
+
+static uint32_t sntp_isqrt(uint64_t v)
+{
+	uint64_t r = 0, b = 1ULL << 62;
+
+	while (b > v)
+		b >>= 2;
+	while (b) {
+		if (v >= r + b) {
+			v -= r + b;
+			r = (r >> 1) + b;
+		} else {
+			r >>= 1;
+		}
+		b >>= 2;
+	}
+	return (uint32_t)r;
+}
 
+static void sntp_init_request_packet(ntp_packet *packet, sntp_peer *peer)
+{
 	memset(packet, 0, sizeof(ntp_packet));
-	gettimeofday(&local_time, NULL);
 	packet->li_vn_mode = SNTP_LI_NO_WARNING | SNTP_VERSION << 3 | SNTP_MODE_CLIENT;
-	packet->txTm_s = htonl(local_time.tv_sec);
-	packet->txTm_f = htonl(local_time.tv_usec);
+	/* the transmit timestamp is only echoed back by the server, a random
+	 * one matches the reply to the request and hides the local time */
+	peer->nonce[0] = OS_Rand32();
+	peer->nonce[1] = OS_Rand32() ^ rand();
+	packet->txTm_s = peer->nonce[0];
+	packet->txTm_f = peer->nonce[1];
 }
 
-static int sntp_process_time(ntp_packet *packet, struct timeval *time)
+/*
+ * Take a sample from a server's reply.
+ * Return 0 if a sample is taken, -1 if the reply is rejected and 1 if it isn't
+ * a reply to the request in flight.
+ */
+static int sntp_process_reply(sntp_peer *peer, const ntp_packet *packet, uint64_t t4)
 {
-	struct timeval local_time;
-	uint32_t t0_s, t1_s, t2_s, t3_s, real_time_s;
-	uint32_t t0_us, t1_us, t2_us, t3_us, real_time_us;
-	int deta1, deta2, transmit_time;
+	int64_t t1, t2, t3, utc4, delay;
+	sntp_sample *s;
 
-	if (((packet->li_vn_mode & SNTP_MODE_MASK) == SNTP_MODE_SERVER) ||
-		((packet->li_vn_mode & SNTP_MODE_MASK) == SNTP_MODE_BROADCAST)) {
-		gettimeofday(&local_time, NULL);
+	if ((packet->li_vn_mode & SNTP_MODE_MASK) != SNTP_MODE_SERVER ||
+	    packet->origTm_s != peer->nonce[0] || packet->origTm_f != peer->nonce[1]) {
+		SNTP_DEBUG("sntp_request: not response frame code");
+		return 1;
+	}
+	peer->pending = 0;
 
-		t0_s = ntohl(packet->origTm_s);
-		t0_us = ntohl(packet->origTm_f);
+	if (packet->stratum == SNTP_STRATUM_KOD) {
+		SNTP_WRANING("kiss-o'-death %.4s from %s",
+		             (const char *)&packet->refId, inet_ntoa(peer->addr.sin_addr));
+		peer->dead = 1;
+		return -1;
+	}
+	if ((packet->li_vn_mode & SNTP_LI_MASK) == SNTP_LI_ALARM ||
+	    packet->stratum > SNTP_STRATUM_MAX ||
+	    (packet->txTm_s == 0 && packet->txTm_f == 0)) {
+		SNTP_DEBUG("server %s not synchronized", inet_ntoa(peer->addr.sin_addr));
+		return -1;
+	}
 
-		t3_s = local_time.tv_sec;
-		t3_us = local_time.tv_usec;
+	/* the local timestamps are read through the current clock model, so the
+	 * offset is the correction the model needs */
+	t1 = sntp_model_utc(&g_model, peer->t1);
+	utc4 = sntp_model_utc(&g_model, t4);
+	t2 = sntp_ntp_to_us(ntohl(packet->rxTm_s), ntohl(packet->rxTm_f));
+	t3 = sntp_ntp_to_us(ntohl(packet->txTm_s), ntohl(packet->txTm_f));
+
+	delay = (utc4 - t1) - (t3 - t2);
+	if (delay < 0)
+		delay = 0;
+
+	s = &peer->sample[peer->nsample++];
+	s->offset = ((t2 - t1) + (t3 - utc4)) / 2;
+	s->delay = (int32_t)delay;
+	s->t4 = t4;
+	peer->stratum = packet->stratum;
+	peer->root = sntp_short_to_us(ntohl(packet->rootDelay)) / 2 +
+	             sntp_short_to_us(ntohl(packet->rootDispersion));
+	SNTP_DEBUG("%s offset %lld delay %d", inet_ntoa(peer->addr.sin_addr),
+	           (long long)s->offset, s->delay);
+	return 0;
+}
 
-		t1_s =  ntohl(packet->rxTm_s);
-		t1_us = ntohl(packet->rxTm_f) / 4295;
+/* send a request to each server short of samples and collect the replies */
+static void sntp_exchange(int sockfd, sntp_peer *peer, int npeer, int samples, int timeout)
+{
+	ntp_packet packet;
+	struct sockaddr_in from;
+	socklen_t fromlen;
+	fd_set rset;
+	struct timeval tv;
+	OS_Time_t end;
+	int32_t left;
+	int i, len, pending = 0;
+	uint64_t t4;
+
+	for (i = 0; i < npeer; i++) {
+		if (peer[i].dead || peer[i].nsample >= samples)
+			continue;
+		sntp_init_request_packet(&packet, &peer[i]);
+		peer[i].t1 = sntp_local_us();
+		len = sendto(sockfd, &packet, sizeof(packet), 0,
+		             (struct sockaddr *)&peer[i].addr, sizeof(peer[i].addr));
+		if (len != sizeof(packet)) {
+			SNTP_ERROR("send err,ret=%d,errno:%d", len, errno);
+			continue;
+		}
+		peer[i].pending = 1;
+		pending++;
+	}
 
-		t2_s =  ntohl(packet->txTm_s);
-		t2_us = ntohl(packet->txTm_f) / 4295;
+	end = OS_GetTicks() + OS_MSecsToTicks(timeout);
+	while (pending > 0) {
+		left = (int32_t)(end - OS_GetTicks());
+		if (left <= 0)
+			break;
+		left = OS_TicksToMSecs(left);
+		tv.tv_sec = left / 1000;
+		tv.tv_usec = (left % 1000) * 1000;
+		FD_ZERO(&rset);
+		FD_SET(sockfd, &rset);
+		if (select(sockfd + 1, &rset, NULL, NULL, &tv) <= 0)
+			break;
 
-		deta1 = (t3_s - t0_s) * 1000000 + (t3_us - t0_us); /* us */
-		deta2 = (t2_s - t1_s) * 1000000 + (t2_us - t1_us); /* us */
+		fromlen = sizeof(from);
+		len = recvfrom(sockfd, &packet, sizeof(packet), 0,
+		               (struct sockaddr *)&from, &fromlen);
+		t4 = sntp_local_us();
+		if (len != SNTP_MSG_LEN) {
+			SNTP_ERROR("recv err,ret=%d,errno:%d", len, errno);
+			continue;
+		}
+
+		for (i = 0; i < npeer; i++) {
+			if (peer[i].pending &&
+			    peer[i].addr.sin_addr.s_addr == from.sin_addr.s_addr &&
+			    peer[i].addr.sin_port == from.sin_port)
+				break;
+		}
+		if (i < npeer && sntp_process_reply(&peer[i], &packet, t4) <= 0)
+			pending--;
+	}
 
-		transmit_time = (deta1 - deta2) / 2; /* us */
+	for (i = 0; i < npeer; i++)
+		peer[i].pending = 0;
+}
 
-		real_time_s = t2_s + (t2_us + transmit_time) / 1000000;
-		real_time_us = (t2_us + transmit_time) % 1000000;
+/* clock filter, keep the sample with the lowest delay */
+static int sntp_filter(sntp_peer *peer)
+{
+	int i, best = 0;
+	int64_t d;
+	uint64_t sq = 0;
 
-		int is_1900_based = ((real_time_s & 0x80000000) != 0);
-		real_time_s = is_1900_based ? (real_time_s - DIFF_SEC_1900_1970) : (real_time_s + DIFF_SEC_1970_2036);
-		time->tv_sec = real_time_s;
-		time->tv_usec = real_time_us;
-	} else {
-		SNTP_ERROR("sntp_request: not response frame code");
+	if (peer->dead || peer->nsample == 0)
 		return -1;
+
+	for (i = 1; i < peer->nsample; i++) {
+		if (peer->sample[i].delay < peer->sample[best].delay)
+			best = i;
+	}
+	peer->offset = peer->sample[best].offset;
+	peer->delay = peer->sample[best].delay;
+	peer->t4 = peer->sample[best].t4;
+
+	for (i = 0; i < peer->nsample; i++) {
+		d = peer->sample[i].offset - peer->offset;
+		if (d > 1000000000 || d < -1000000000)
+			d = 1000000000;
+		sq += (uint64_t)(d * d);
 	}
+	peer->jitter = peer->nsample > 1 ? sntp_isqrt(sq / (peer->nsample - 1)) : 0;
+
+	peer->dist = peer->delay / 2 + peer->root + peer->jitter;
+	if (peer->dist < SNTP_MIN_DIST)
+		peer->dist = SNTP_MIN_DIST;
 	return 0;
 }
 
-static int sntp_query_server(sntp_arg *arg, struct timeval *ntp_time)
+typedef struct {
+	int64_t val;
+	int8_t type;          /* -1 lower end, 0 midpoint, 1 upper end */
+} sntp_edge;
+
+/*
+ * Selection, find the smallest interval containing points of the majority of
+ * the servers' correctness intervals [offset - dist, offset + dist]. Servers
+ * whose offset is out of it are falsetickers.
+ */
+static int sntp_select(sntp_peer *peer, int npeer, int64_t *low, int64_t *high)
 {
-	ntp_packet packet;
-	int sockfd = -1;
-	struct sockaddr_in server_addr;
-	struct hostent *host;
-	char *server_name = NULL;
-	int ret = 0;
-#if SNTP_SUPPORT_MULTIPLE_SERVERS
-	uint8_t idx = 0;
-#endif
+	sntp_edge edge[SNTP_MAX_PEERS * 3], e;
+	int i, j, n = 0, m = 0, allow, found, chime;
 
-	memset(&server_addr, 0, sizeof(server_addr));
+	for (i = 0; i < npeer; i++) {
+		if (sntp_filter(&peer[i]) != 0)
+			continue;
+		edge[n].val = peer[i].offset - peer[i].dist;
+		edge[n++].type = -1;
+		edge[n].val = peer[i].offset;
+		edge[n++].type = 0;
+		edge[n].val = peer[i].offset + peer[i].dist;
+		edge[n++].type = 1;
+		m++;
+	}
+	if (m == 0)
+		return -1;
 
-	/* choose the right server */
-	do {
-		if (arg && arg->server_name) {
-			server_name = arg->server_name;
-			break;
+	for (i = 1; i < n; i++) {
+		e = edge[i];
+		for (j = i; j > 0 && (edge[j - 1].val > e.val ||
+		     (edge[j - 1].val == e.val && edge[j - 1].type > e.type)); j--)
+			edge[j] = edge[j - 1];
+		edge[j] = e;
+	}
+
+	for (allow = 0; 2 * allow < m; allow++) {
+		*low = INT64_MAX;
+		*high = INT64_MIN;
+		found = 0;
+		chime = 0;
+		for (i = 0; i < n; i++) {
+			chime -= edge[i].type;
+			if (chime >= m - allow) {
+				*low = edge[i].val;
+				break;
+			}
+			if (edge[i].type == 0)
+				found++;
+		}
+		chime = 0;
+		for (i = n - 1; i >= 0; i--) {
+			chime += edge[i].type;
+			if (chime >= m - allow) {
+				*high = edge[i].val;
+				break;
+			}
+			if (edge[i].type == 0)
+				found++;
 		}
+		if (found <= allow && *low <= *high)
+			return 0;
+	}
+	return -1;
+}
+
+/* step or slew the clock model by offset, measured at local time t */
+static void sntp_discipline(int64_t offset, uint64_t t)
+{
+	sntp_model m = g_model;
+	uint64_t now = sntp_local_us();
+	int64_t utc = sntp_model_utc(&m, now);
+	int64_t truth = sntp_model_utc(&m, t) + offset;
+	int64_t span, err;
+	unsigned long flags;
+
+	m.base = now;
+	if (!m.synced || offset > SNTP_STEP_THRESHOLD || offset < -SNTP_STEP_THRESHOLD) {
+		m.utc = utc + offset;
+		m.slew = 0;
+		m.slew_end = now;
+		m.anchor = t;
+		m.anchor_utc = truth;
+		g_status.steps++;
+	} else {
+		/* frequency, from the drift since the anchor */
+		span = (int64_t)(t - m.anchor);
+		if (span >= SNTP_FREQ_MIN_SPAN) {
+			err = truth - m.anchor_utc - span;
+			if (err > 8000000000LL)
+				err = 8000000000LL;
+			else if (err < -8000000000LL)
+				err = -8000000000LL;
+			err = err * SNTP_PPB / span;
+			if (err > SNTP_MAX_FREQ)
+				err = SNTP_MAX_FREQ;
+			else if (err < -SNTP_MAX_FREQ)
+				err = -SNTP_MAX_FREQ;
+			m.freq = (int32_t)err;
+			if (span > SNTP_FREQ_MAX_SPAN) {
+				m.anchor = t;
+				m.anchor_utc = truth;
+			}
+		}
+		/* phase, slewed in so the time never jumps back */
+		m.utc = utc;
+		err = offset * SNTP_PPB / SNTP_SLEW_TIME;
+		if (err > SNTP_MAX_SLEW)
+			err = SNTP_MAX_SLEW;
+		else if (err < -SNTP_MAX_SLEW)
+			err = -SNTP_MAX_SLEW;
+		m.slew = (int32_t)err;
+		m.slew_end = now + (uint64_t)(m.slew ? offset * SNTP_PPB / m.slew : 0);
+	}
+	m.synced = 1;
+
+	flags = arch_irq_save();
+	g_model = m;
+	arch_irq_restore(flags);
+}
+
+static int sntp_add_host(sntp_peer *peer, int npeer, const char *name)
+{
+	struct hostent *host;
+	int i;
+
+	host = gethostbyname(name);
+	if (!host) {
+		SNTP_ERROR("invalid address parameter '%s'", name);
+		return npeer;
+	}
+	for (i = 0; host->h_addr_list[i] && npeer < SNTP_MAX_PEERS; i++)
+		peer[npeer++].addr.sin_addr.s_addr = ((struct in_addr *)host->h_addr_list[i])->s_addr;
+	return npeer;
+}
+
+static int sntp_get_peers(sntp_arg *arg, sntp_peer *peer)
+{
+	int i, npeer = 0;
+
+	memset(peer, 0, sizeof(sntp_peer) * SNTP_MAX_PEERS);
+
+	/* the server by name is preferred, then the servers set, a name may
+	 * resolve to several servers */
+	if (arg && arg->server_name) {
+		npeer = sntp_add_host(peer, npeer, arg->server_name);
+	} else {
 #if SNTP_SUPPORT_MULTIPLE_SERVERS
-		while(idx < SNTP_MAX_SERVERS && sntp_get_server_addr(idx)->s_addr == INADDR_ANY)
-			idx++;
-		if (idx < SNTP_MAX_SERVERS) {
-			server_name = NULL;
-			server_addr.sin_addr.s_addr = sntp_get_server_addr(idx)->s_addr;
-			break;
+		for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+			if (sntp_servers[i].s_addr != INADDR_ANY)
+				peer[npeer++].addr.sin_addr = sntp_servers[i];
 		}
 #endif
-		server_name = SNTP_SERVER_ADDRESS;
-	} while(0);
-
-	if (server_name) {
-		host = gethostbyname(server_name);
-		if (!host) {
-			SNTP_ERROR("invalid address parameter '%s'",server_name);
-			ret = -1;
-			goto exit;
-		}
-		server_addr.sin_addr.s_addr  = (*(struct in_addr *)host->h_addr).s_addr;
+		if (npeer == 0)
+			npeer = sntp_add_host(peer, npeer, SNTP_SERVER_ADDRESS);
+	}
+
+	for (i = 0; i < npeer; i++) {
+		peer[i].addr.sin_family = AF_INET;
+		peer[i].addr.sin_port = htons(SNTP_PORT);
+	}
+	return npeer;
+}
+
+/**
+  * @brief Synchronize the local clock with the remote servers.
+  * @note This a blocking interface. Every server is sampled several times,
+  *       the best sample of each server is kept, the falsetickers are
+  *       discarded and the rest are combined to step or slew the clock read
+  *       by sntp_get_time_us(). It's not reentrant.
+  * @param arg: The pointer of sntp module parameter, NULL for the defaults
+  * @retval 0:success -1:fail
+  */
+int sntp_sync(sntp_arg *arg)
+{
+	sntp_peer *peer;
+	int sockfd = -1;
+	int i, npeer, round, rounds, samples, retry, timeout, survivors = 0;
+	int64_t low, high, offset, sum, wsum, w;
+	sntp_peer *best = NULL;
+	uint32_t jitter = 0;
+	int ret = -1;
+
+	peer = malloc(sizeof(sntp_peer) * SNTP_MAX_PEERS);
+	if (peer == NULL) {
+		SNTP_ERROR("no memory");
+		return -1;
 	}
 
-	server_addr.sin_family = AF_INET;
-	server_addr.sin_port = htons(SNTP_PORT);
+	npeer = sntp_get_peers(arg, peer);
+	if (npeer == 0)
+		goto exit;
 
 	sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if (sockfd < 0) {
 		SNTP_ERROR("socket create err!");
-		ret = -1;
 		goto exit;
 	}
 
-	int val = 1;
-	if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(int)) != 0) {
-		SNTP_ERROR("setsockopt(SO_REUSEADDR) failed");
-		ret = -1;
-		goto exit;
+	samples = arg && arg->samples ? arg->samples : SNTP_SAMPLES;
+	if (samples > SNTP_MAX_SAMPLES)
+		samples = SNTP_MAX_SAMPLES;
+	timeout = arg && arg->recv_timeout > 0 ? arg->recv_timeout : SNTP_RECV_TIMEOUT;
+	/* the retries are extra rounds for the servers short of samples */
+	retry = arg ? arg->retry_times : SNTP_RETRY_TIMES;
+	rounds = samples + (retry > 0 ? retry - 1 : 0);
+
+	for (round = 0; round < rounds; round++) {
+		for (i = 0; i < npeer; i++) {
+			if (!peer[i].dead && peer[i].nsample < samples)
+				break;
+		}
+		if (i == npeer)
+			break;
+		if (round)
+			OS_MSleep(SNTP_SAMPLE_INTERVAL);
+		sntp_exchange(sockfd, peer, npeer, samples, timeout);
 	}
 
-	int timeout = arg && arg->recv_timeout > 0 ? arg->recv_timeout : SNTP_RECV_TIMEOUT;
-	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(int)) != 0) {
-		SNTP_ERROR("setsockopt(SO_RCVTIMEO) failed");
-		ret = -1;
+	if (sntp_select(peer, npeer, &low, &high) != 0) {
+		SNTP_ERROR("no majority of the servers agree");
 		goto exit;
 	}
 
-#if SNTP_SUPPORT_MULTIPLE_SERVERS
-send_request:
-#endif
-	SNTP_DEBUG("server name:%s", server_name ? server_name : "NULL");
-	SNTP_DEBUG("server ip:%s", inet_ntoa(server_addr.sin_addr));
-
-	int retry_times = arg ? arg->retry_times : SNTP_RETRY_TIMES;
-
-	do {
-		sntp_init_request_packet(&packet);
-
-		ret = sendto(sockfd, &packet, sizeof(packet), 0, (struct sockaddr *)&server_addr, sizeof(server_addr));
-		if (ret <= 0) {
-			SNTP_ERROR("send err,ret=%d,errno:%d", ret, errno);
-			ret = -1;
+	/* combine the truechimers, weighted by their root distance */
+	sum = wsum = 0;
+	for (i = 0; i < npeer; i++) {
+		if (peer[i].dead || peer[i].nsample == 0 ||
+		    peer[i].offset < low || peer[i].offset > high)
 			continue;
-		}
-
-		ret = recvfrom(sockfd, &packet, sizeof(packet), 0, NULL, NULL);
-		if (ret != SNTP_MSG_LEN) {
-			SNTP_ERROR("recv err,ret=%d,errno:%d", ret, errno);
-			ret = -1;
+		if (best == NULL || peer[i].dist < best->dist)
+			best = &peer[i];
+	}
+	for (i = 0; i < npeer; i++) {
+		if (peer[i].dead || peer[i].nsample == 0 ||
+		    peer[i].offset < low || peer[i].offset > high)
 			continue;
-		} else {
-			if ((ret = sntp_process_time(&packet, ntp_time)) != 0)
-				ret = -1;
-			else
-				goto exit;
-		}
-	} while (--retry_times && retry_times > 0);
-
-#if SNTP_SUPPORT_MULTIPLE_SERVERS
-	/* try and get the next ntp server */
-	if (server_name == NULL) {
-		for (idx++; idx < SNTP_MAX_SERVERS; idx++) {
-			if (sntp_get_server_addr(idx)->s_addr != INADDR_ANY) {
-				server_name = NULL;
-				server_addr.sin_addr.s_addr = sntp_get_server_addr(idx)->s_addr;
-				goto send_request;
-			}
-		}
+		w = SNTP_PPB / peer[i].dist;
+		sum += (peer[i].offset - best->offset) * w;
+		wsum += w;
+		if (peer[i].jitter > jitter)
+			jitter = peer[i].jitter;
+		survivors++;
 	}
-#endif
+	offset = best->offset + sum / wsum;
+
+	sntp_discipline(offset, best->t4);
+
+	g_status.synced = 1;
+	g_status.servers = survivors;
+	g_status.stratum = best->stratum;
+	g_status.offset = (int32_t)(offset > INT32_MAX ? INT32_MAX :
+	                            offset < INT32_MIN ? INT32_MIN : offset);
+	g_status.delay = best->delay;
+	g_status.jitter = jitter;
+	g_status.freq = g_model.freq;
+	SNTP_DEBUG("offset %lld us, %d servers, freq %d ppb", (long long)offset,
+	           survivors, g_model.freq);
+	ret = 0;
 
 exit:
 	if (sockfd >= 0)
 		closesocket(sockfd);
-	if (ret)
+	free(peer);
+	return ret;
+}
+
+/**
+  * @brief Get the time synchronized by sntp_sync().
+  * @note The time is kept by the hardware free running counter, corrected in
+  *       frequency between two synchronizations.
+  * @retval UTC in microseconds since 1970, -1 if never synchronized
+  */
+int64_t sntp_get_time_us(void)
+{
+	sntp_model m;
+	unsigned long flags;
+
+	flags = arch_irq_save();
+	m = g_model;
+	arch_irq_restore(flags);
+
+	if (!m.synced)
 		return -1;
+	return sntp_model_utc(&m, sntp_local_us());
+}
 
+/**
+  * @brief Get the state of the synchronization.
+  * @param status: Pointer to the struct to fill
+  * @retval 0:success -1:fail
+  */
+int sntp_get_status(sntp_status *status)
+{
+	if (status == NULL)
+		return -1;
+	*status = g_status;
 	return 0;
 }
 
 /**
   * @brief Get time from the remote server.
-  * @note This a blocking interface.
+  * @note This a blocking interface, it synchronizes the clock first.
   * @param ntp_time: Pointer to the struct timeval.
   *        arg: The pointer of sntp module parameter
   * @retval 0:success -1:fail
   */
 int sntp_get_time(sntp_arg *arg, struct timeval *ntp_time)
 {
-	return sntp_query_server(arg, ntp_time);
+	int64_t us;
+
+	if (sntp_sync(arg) != 0)
+		return -1;
+
+	us = sntp_get_time_us();
+	ntp_time->tv_sec = us / 1000000;
+	ntp_time->tv_usec = us % 1000000;
+	return 0;
 }
 
 /**
@@ -328,7 +754,7 @@ int sntp_request(void *arg)
 	struct tm *gt;
 	int ret;
 
-	ret = sntp_query_server(NULL, &ntp_time);
+	ret = sntp_get_time(NULL, &ntp_time);
 	if (ret != 0)
 		return -1;
 
@@ -356,5 +782,3 @@ sntp_time *sntp_obtain_time(void)
 {
 	return &g_time;
 }
-
-
@@ -114,8 +114,8 @@ int main(int argc, char *argv[])
 	}
 	else server_config.lease = LEASE_TIME;
 
-	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
-	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	if (leases_init() != 0)
+		exit_server(1);
 	read_leases(server_config.lease_file);
 
 	if (read_interface(server_config.interface, &server_config.ifindex,
@@ -250,7 +250,7 @@ int main(int argc, char *argv[])
 				if ((lease = find_lease_by_yiaddr(requested_align))) {
 					if (lease_expired(lease)) {
 						/* probably best if we drop this lease */
-						memset(lease->chaddr, 0, 16);
+						lease_clear_chaddr(lease);
 					/* make some contention for this address */
 					} else sendNAK(&packet);
 				} else if (requested_align < server_config.start ||
@@ -265,14 +265,14 @@ int main(int argc, char *argv[])
 		case DHCPDECLINE:
 			DEBUG(LOG_INFO,"received DECLINE");
 			if (lease) {
-				memset(lease->chaddr, 0, 16);
-				lease->expires = time(0) + server_config.decline_time;
+				lease_clear_chaddr(lease);
+				lease_set_expires(lease, time(0) + server_config.decline_time);
 				printf("%s,line:%d,lease->expires:%lu\n",__func__,__LINE__,lease->expires);
 			}
 			break;
 		case DHCPRELEASE:
 			DEBUG(LOG_INFO,"received RELEASE");
-			if (lease) lease->expires = time(0);
+			if (lease) lease_set_expires(lease, time(0));
 			printf("%s,line:%d,lease->expires:%lu\n",__func__,__LINE__,lease->expires);
 			break;
 		case DHCPINFORM:
@@ -17,7 +17,9 @@
 #include <netdb.h>
 #endif
 
-#ifndef DHCPD_TIMEALT
+#ifdef DHCPD_TIMEALT
+#include "dhcp_time.h"
+#else
 #include <time.h>
 #endif
 
@@ -324,3 +326,43 @@ void read_leases(char *file)
 }
 
 #endif
+
+/* the lease file records of write_leases(), in memory. The time is always
+ * the remaining one, so the leases survive a reboot without a clock. */
+unsigned int pack_leases(u_int8_t *buf, unsigned int size)
+{
+	unsigned int i, len = 0;
+	u_int32_t lease_time;
+
+	for (i = 0; i < server_config.max_leases && len + LEASE_RECORD_SIZE <= size; i++) {
+		/* skip empty, expired and conflict/declined leases */
+		if (leases[i].yiaddr == 0 || lease_expired(&(leases[i])) ||
+		    !memcmp(leases[i].chaddr, blank_chaddr, 16))
+			continue;
+		lease_time = htonl(leases[i].expires - time(0));
+		memcpy(buf + len, leases[i].chaddr, 16);
+		memcpy(buf + len + 16, &(leases[i].yiaddr), 4);
+		memcpy(buf + len + 20, &lease_time, 4);
+		len += LEASE_RECORD_SIZE;
+	}
+	return len;
+}
+
+void unpack_leases(const u_int8_t *buf, unsigned int len)
+{
+	struct dhcpOfferedAddr lease;
+	unsigned int i = 0;
+
+	for (; len >= LEASE_RECORD_SIZE; buf += LEASE_RECORD_SIZE, len -= LEASE_RECORD_SIZE) {
+		memcpy(lease.chaddr, buf, 16);
+		memcpy(&lease.yiaddr, buf + 16, 4);
+		memcpy(&lease.expires, buf + 20, 4);
+		if (ntohl(lease.yiaddr) < ntohl(server_config.start) ||
+		    ntohl(lease.yiaddr) > ntohl(server_config.end))
+			continue;
+		if (!(add_lease(lease.chaddr, lease.yiaddr, ntohl(lease.expires))))
+			break;
+		i++;
+	}
+	DEBUG(LOG_INFO, "Loaded %d leases", i);
+}
@@ -9,6 +9,12 @@ struct config_keyword {
 	char def[30];
 };
 
+/* chaddr, yiaddr and the remaining lease time */
+#define LEASE_RECORD_SIZE	24
+
+unsigned int pack_leases(u_int8_t *buf, unsigned int size);
+void unpack_leases(const u_int8_t *buf, unsigned int len);
+
 #ifdef DHCPD_FS
 int read_config(char *file);
 void write_leases(void);
@@ -3,6 +3,7 @@
  * Russ Dill <Russ.Dill@asu.edu> July 2001
  */
 #include <string.h>
+#include <stdlib.h>
 
 #ifdef DHCPD_LWIP
 #include <lwip/sockets.h>
@@ -26,19 +27,239 @@
 #include "arpping.h"
 
 unsigned char blank_chaddr[] = {[0 ... 15] = 0};
+int leases_dirty;
+
+/*
+ * The lease table is indexed so that a request costs about the same with
+ * a full pool as with an empty one:
+ * - chaddr hash chains for find_lease_by_chaddr()
+ * - the lease of each pool address, and a bitmap of the addresses having
+ *   one, for find_lease_by_yiaddr() and find_address()
+ * - a min-heap on expires for oldest_expired_lease()
+ * - when check_ip() last found an address free, so it isn't probed again
+ *   for CHECK_IP_CACHE_TIME seconds
+ * Everything that changes chaddr, yiaddr or expires of a lease has to go
+ * through the functions here.
+ */
+#define LEASE_NONE	0xFFFF
+
+static struct {
+	u_int16_t *hash;	/* heads of the chaddr hash chains */
+	u_int16_t *next;	/* next lease in the chain */
+	u_int16_t *heap;	/* leases, the oldest expiry first */
+	u_int16_t *heap_pos;	/* position of each lease in heap */
+	u_int16_t *by_ip;	/* lease of each pool address */
+	u_int32_t *used;	/* pool addresses having a lease */
+	u_int32_t *free_until;	/* check_ip() result is valid until then */
+	unsigned int hash_mask;
+	unsigned int pool_size;
+	u_int32_t pool_start;	/* host order */
+} idx;
+
+static int chaddr_blank(u_int8_t *chaddr)
+{
+	return !memcmp(chaddr, blank_chaddr, 16);
+}
+
+static unsigned int chaddr_hash(u_int8_t *chaddr)
+{
+	unsigned int h = 0;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		h = h * 31 + chaddr[i];
+	return (h ^ (h >> 16)) & idx.hash_mask;
+}
+
+static int pool_index(u_int32_t yiaddr)
+{
+	u_int32_t addr = ntohl(yiaddr);
+
+	if (addr < idx.pool_start || addr - idx.pool_start >= idx.pool_size)
+		return -1;
+	return addr - idx.pool_start;
+}
+
+static void heap_swap(unsigned int a, unsigned int b)
+{
+	u_int16_t t = idx.heap[a];
+
+	idx.heap[a] = idx.heap[b];
+	idx.heap[b] = t;
+	idx.heap_pos[idx.heap[a]] = a;
+	idx.heap_pos[idx.heap[b]] = b;
+}
+
+#define HEAP_EXPIRES(pos)	(leases[idx.heap[pos]].expires)
+
+/* restore the heap order after the expiry of lease i changed */
+static void heap_update(unsigned int i)
+{
+	unsigned int pos = idx.heap_pos[i];
+	unsigned int child;
+
+	while (pos > 0 && HEAP_EXPIRES((pos - 1) / 2) > HEAP_EXPIRES(pos)) {
+		heap_swap(pos, (pos - 1) / 2);
+		pos = (pos - 1) / 2;
+	}
+
+	while ((child = 2 * pos + 1) < server_config.max_leases) {
+		if (child + 1 < server_config.max_leases &&
+		    HEAP_EXPIRES(child + 1) < HEAP_EXPIRES(child))
+			child++;
+		if (HEAP_EXPIRES(pos) <= HEAP_EXPIRES(child))
+			break;
+		heap_swap(pos, child);
+		pos = child;
+	}
+}
+
+/* add lease i to the chaddr and address indexes */
+static void lease_link(unsigned int i)
+{
+	unsigned int h;
+	int p;
+
+	if (!chaddr_blank(leases[i].chaddr)) {
+		h = chaddr_hash(leases[i].chaddr);
+		idx.next[i] = idx.hash[h];
+		idx.hash[h] = i;
+	}
+
+	if (leases[i].yiaddr && (p = pool_index(leases[i].yiaddr)) >= 0) {
+		idx.by_ip[p] = i;
+		idx.used[p >> 5] |= 1UL << (p & 31);
+	}
+}
+
+/* remove lease i from the chaddr and address indexes */
+static void lease_unlink(unsigned int i)
+{
+	u_int16_t *pi;
+	int p;
+
+	if (!chaddr_blank(leases[i].chaddr)) {
+		for (pi = &idx.hash[chaddr_hash(leases[i].chaddr)]; *pi != LEASE_NONE; pi = &idx.next[*pi]) {
+			if (*pi == i) {
+				*pi = idx.next[i];
+				break;
+			}
+		}
+	}
+
+	if (leases[i].yiaddr && (p = pool_index(leases[i].yiaddr)) >= 0 &&
+	    idx.by_ip[p] == i) {
+		idx.by_ip[p] = LEASE_NONE;
+		idx.used[p >> 5] &= ~(1UL << (p & 31));
+	}
+}
+
+static void free_index(void)
+{
+	free(idx.hash);
+	free(idx.next);
+	free(idx.heap);
+	free(idx.heap_pos);
+	free(idx.by_ip);
+	free(idx.used);
+	free(idx.free_until);
+	memset(&idx, 0, sizeof(idx));
+}
+
+/* allocate the lease table for server_config.max_leases leases in the
+ * pool server_config.start - server_config.end, 0 on success */
+int leases_init(void)
+{
+	unsigned int i;
+	unsigned int hash_size;
+
+	if (server_config.max_leases == 0 || server_config.max_leases >= LEASE_NONE)
+		return -1;
+
+	leases = calloc(server_config.max_leases, sizeof(struct dhcpOfferedAddr));
+
+	for (hash_size = 8; hash_size < server_config.max_leases; hash_size <<= 1)
+		;
+	idx.hash_mask = hash_size - 1;
+	idx.pool_start = ntohl(server_config.start);
+	idx.pool_size = ntohl(server_config.end) - idx.pool_start + 1;
+
+	idx.hash = malloc(hash_size * sizeof(u_int16_t));
+	idx.next = malloc(server_config.max_leases * sizeof(u_int16_t));
+	idx.heap = malloc(server_config.max_leases * sizeof(u_int16_t));
+	idx.heap_pos = malloc(server_config.max_leases * sizeof(u_int16_t));
+	idx.by_ip = malloc(idx.pool_size * sizeof(u_int16_t));
+	idx.used = calloc((idx.pool_size + 31) / 32, sizeof(u_int32_t));
+	idx.free_until = calloc(idx.pool_size, sizeof(u_int32_t));
+
+	if (!leases || !idx.hash || !idx.next || !idx.heap || !idx.heap_pos ||
+	    !idx.by_ip || !idx.used || !idx.free_until) {
+		DHCPD_LOG(LOG_ERR, "no memory for %lu leases", server_config.max_leases);
+		leases_deinit();
+		return -1;
+	}
+
+	memset(idx.hash, 0xFF, hash_size * sizeof(u_int16_t));
+	memset(idx.by_ip, 0xFF, idx.pool_size * sizeof(u_int16_t));
+	/* all leases are empty, expires 0, so any order is a heap */
+	for (i = 0; i < server_config.max_leases; i++) {
+		idx.heap[i] = i;
+		idx.heap_pos[i] = i;
+	}
+
+	return 0;
+}
+
+void leases_deinit(void)
+{
+	free_index();
+	if (leases != NULL) {
+		free(leases);
+		leases = NULL;
+	}
+}
+
+/* change the expiry of a lease */
+void lease_set_expires(struct dhcpOfferedAddr *lease, u_int32_t expires)
+{
+	lease->expires = expires;
+	heap_update(lease - leases);
+	leases_dirty = 1;
+}
+
+/* keep the address of a lease reserved, but not for its client */
+void lease_clear_chaddr(struct dhcpOfferedAddr *lease)
+{
+	unsigned int i = lease - leases;
+
+	lease_unlink(i);
+	memset(lease->chaddr, 0, 16);
+	lease_link(i);
+	leases_dirty = 1;
+}
+
+static void lease_clear(struct dhcpOfferedAddr *lease)
+{
+	lease_unlink(lease - leases);
+	memset(lease, 0, sizeof(struct dhcpOfferedAddr));
+	heap_update(lease - leases);
+	leases_dirty = 1;
+}
 
 /* clear every lease out that chaddr OR yiaddr matches and is nonzero */
 void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr)
 {
-	unsigned int i, j;
+	struct dhcpOfferedAddr *lease;
 
-	for (j = 0; j < 16 && !chaddr[j]; j++);
+	if (!chaddr_blank(chaddr)) {
+		while ((lease = find_lease_by_chaddr(chaddr)))
+			lease_clear(lease);
+	}
 
-	for (i = 0; i < server_config.max_leases; i++)
-		if ((j != 16 && !memcmp(leases[i].chaddr, chaddr, 16)) ||
-		    (yiaddr && leases[i].yiaddr == yiaddr)) {
-			memset(&(leases[i]), 0, sizeof(struct dhcpOfferedAddr));
-		}
+	if (yiaddr) {
+		while ((lease = find_lease_by_yiaddr(yiaddr)))
+			lease_clear(lease);
+	}
 }
 
 
@@ -46,6 +267,7 @@ void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr)
 struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned long lease)
 {
 	struct dhcpOfferedAddr *oldest;
+	unsigned int i;
 
 	/* clean out any old ones */
 	clear_lease(chaddr, yiaddr);
@@ -53,9 +275,12 @@ struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned l
 	oldest = oldest_expired_lease();
 
 	if (oldest) {
+		i = oldest - leases;
+		lease_unlink(i);
 		memcpy(oldest->chaddr, chaddr, 16);
 		oldest->yiaddr = yiaddr;
-		oldest->expires = time(0) + lease;
+		lease_link(i);
+		lease_set_expires(oldest, time(0) + lease);
 	}
 
 	return oldest;
@@ -72,38 +297,39 @@ int lease_expired(struct dhcpOfferedAddr *lease)
 /* Find the oldest expired lease, NULL if there are no expired leases */
 struct dhcpOfferedAddr *oldest_expired_lease(void)
 {
-	struct dhcpOfferedAddr *oldest = NULL;
-	unsigned long oldest_lease = time(0);
-	unsigned int i;
-
-
-	for (i = 0; i < server_config.max_leases; i++)
-		if (oldest_lease > leases[i].expires) {
-			oldest_lease = leases[i].expires;
-			oldest = &(leases[i]);
-		}
-	return oldest;
+	struct dhcpOfferedAddr *oldest = &leases[idx.heap[0]];
 
+	if (oldest->expires < (unsigned long) time(0))
+		return oldest;
+	return NULL;
 }
 
 
-/* Find the first lease that matches chaddr, NULL if no match */
+/* Find the lease that matches chaddr, NULL if no match */
 struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr)
 {
 	unsigned int i;
 
-	for (i = 0; i < server_config.max_leases; i++)
+	if (chaddr_blank(chaddr))
+		return NULL;
+
+	for (i = idx.hash[chaddr_hash(chaddr)]; i != LEASE_NONE; i = idx.next[i])
 		if (!memcmp(leases[i].chaddr, chaddr, 16)) return &(leases[i]);
 
 	return NULL;
 }
 
 
-/* Find the first lease that matches yiaddr, NULL is no match */
+/* Find the lease that matches yiaddr, NULL is no match */
 struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 {
 	unsigned int i;
+	int p;
 
+	if ((p = pool_index(yiaddr)) >= 0)
+		return idx.by_ip[p] != LEASE_NONE ? &(leases[idx.by_ip[p]]) : NULL;
+
+	/* not in the pool, eg. read from an old lease file */
 	for (i = 0; i < server_config.max_leases; i++)
 		if (leases[i].yiaddr == yiaddr) return &(leases[i]);
 
@@ -116,10 +342,22 @@ struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 u_int32_t find_address(int check_expired)
 {
 	u_int32_t addr, ret;
-	struct dhcpOfferedAddr *lease = NULL;
+	unsigned int p;
+
+	for (p = 0; p < idx.pool_size; p++) {
+		if (!check_expired) {
+			/* skip 32 taken addresses at once */
+			if (!(p & 31) && idx.used[p >> 5] == 0xFFFFFFFFUL) {
+				p += 31;
+				continue;
+			}
+			if (idx.used[p >> 5] & (1UL << (p & 31)))
+				continue;
+		} else if (idx.by_ip[p] != LEASE_NONE && !lease_expired(&leases[idx.by_ip[p]])) {
+			continue;
+		}
 
-	addr = ntohl(server_config.start); /* addr is in host order here */
-	for (;addr <= ntohl(server_config.end); addr++) {
+		addr = idx.pool_start + p; /* addr is in host order here */
 
 		/* ie, 192.168.55.0 */
 		if (!(addr & 0xFF)) continue;
@@ -127,18 +365,10 @@ u_int32_t find_address(int check_expired)
 		/* ie, 192.168.55.255 */
 		if ((addr & 0xFF) == 0xFF) continue;
 
-		/* lease is not taken */
+		/* and it isn't on the network */
 		ret = htonl(addr);
-		if ((!(lease = find_lease_by_yiaddr(ret)) ||
-
-		     /* or it expired and we are checking for expired leases */
-		     (check_expired  && lease_expired(lease))) &&
-
-		     /* and it isn't on the network */
-	    	     !check_ip(ret)) {
+		if (!check_ip(ret))
 			return ret;
-			break;
-		}
 	}
 	return 0;
 }
@@ -148,6 +378,14 @@ u_int32_t find_address(int check_expired)
 int check_ip(u_int32_t addr)
 {
 	struct in_addr temp;
+	unsigned long now = time(0);
+	int p = pool_index(addr);
+
+	if (p >= 0 && now < idx.free_until[p]) {
+		/* nobody answered a moment ago */
+		return 0;
+	}
+
 	memset(&temp, 0, sizeof(temp));
 	DHCPD_LOG(LOG_INFO, "check ip");
 	if (arpping(addr, server_config.server, server_config.arp, server_config.interface) == 0) {
@@ -156,6 +394,9 @@ int check_ip(u_int32_t addr)
 	 		inet_ntoa(temp), server_config.conflict_time);
 		add_lease(blank_chaddr, addr, server_config.conflict_time);
 		return 1;
-	} else return 0;
+	} else {
+		if (p >= 0)
+			idx.free_until[p] = now + CHECK_IP_CACHE_TIME;
+		return 0;
+	}
 }
-
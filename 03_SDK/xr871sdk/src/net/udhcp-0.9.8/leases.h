@@ -12,8 +12,16 @@ struct dhcpOfferedAddr {
 	u_int32_t expires;	/* host order */
 };
 
+/* how long check_ip() trusts that nobody answered for an address */
+#define CHECK_IP_CACHE_TIME	30
+
 extern unsigned char blank_chaddr[];
+extern int leases_dirty;	/* the table changed since it was last saved */
 
+int leases_init(void);
+void leases_deinit(void);
+void lease_set_expires(struct dhcpOfferedAddr *lease, u_int32_t expires);
+void lease_clear_chaddr(struct dhcpOfferedAddr *lease);
 void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr);
 struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned long lease);
 int lease_expired(struct dhcpOfferedAddr *lease);
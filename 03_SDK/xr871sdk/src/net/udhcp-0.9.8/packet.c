@@ -23,6 +23,7 @@
 #include "lwip/sockets.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/ip_addr.h"
+#include "lwip/tcpip.h"
 #include "lwipopts.h"
 #include "stdlib.h"
 #endif
@@ -139,7 +140,7 @@ u_int16_t checksum(void *addr, int count)
 int _low_level_dhcp_send(struct dhcpMessage *payload, u_int32_t source_ip, int source_port,
 		   u_int32_t dest_ip, int dest_port, unsigned char *dest_arp, int ifindex)
 {
-	struct netif *netif = netif_find(server_config.interface);
+	struct netif *netif;
     struct pbuf *p;
     struct eth_hdr *ethhdr;
     struct ip_hdr *iphdr;
@@ -183,7 +184,12 @@ int _low_level_dhcp_send(struct dhcpMessage *payload, u_int32_t source_ip, int s
     memcpy((char *)udphdr + sizeof(struct udp_hdr),
            payload, sizeof(struct dhcpMessage));
 
-    netif->linkoutput(netif, p);
+    /* output directly to the driver, serialized with the tcpip thread */
+    LOCK_TCPIP_CORE();
+    netif = netif_find(server_config.interface);
+    if (netif != NULL)
+        netif->linkoutput(netif, p);
+    UNLOCK_TCPIP_CORE();
     pbuf_free(p);
 
     return 0;
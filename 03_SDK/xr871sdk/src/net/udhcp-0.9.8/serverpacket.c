@@ -20,6 +20,7 @@
  */
 #ifdef DHCPD_LWIP
 #include <lwip/sockets.h>
+#include <lwip/tcpip.h>
 #else
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -215,9 +216,11 @@ int sendOffer(struct dhcpMessage *oldpacket)
 		lease_time_align = server_config.lease;
 	/* ADDME: end of short circuit */
 #ifdef DHCPD_HEAP_REPLACE_STACK
-	struct netif *netif = netif_find(server_config.interface);
+	struct netif *netif;
 
 	add_simple_option(packet->options, DHCP_LEASE_TIME, htonl(lease_time_align));
+	LOCK_TCPIP_CORE();
+	netif = netif_find(server_config.interface);
 #ifdef __CONFIG_LWIP_V1
 	add_simple_option(packet->options, DHCP_SUBNET, ip4_addr_get_u32(&netif->netmask));
 	add_simple_option(packet->options, DHCP_ROUTER, ip4_addr_get_u32(&netif->gw));
@@ -229,6 +232,7 @@ int sendOffer(struct dhcpMessage *oldpacket)
 #else
 	#error "IPv4 not support!"
 #endif
+	UNLOCK_TCPIP_CORE();
 
 #else
 	add_simple_option(packet.options, DHCP_LEASE_TIME, htonl(lease_time_align));
@@ -326,9 +330,11 @@ int sendACK(struct dhcpMessage *oldpacket, u_int32_t yiaddr)
 			lease_time_align = server_config.lease;
 	}
 #ifdef DHCPD_HEAP_REPLACE_STACK
-	struct netif *netif = netif_find(server_config.interface);
+	struct netif *netif;
 
 	add_simple_option(packet->options, DHCP_LEASE_TIME, htonl(lease_time_align));
+	LOCK_TCPIP_CORE();
+	netif = netif_find(server_config.interface);
 #ifdef __CONFIG_LWIP_V1
 	add_simple_option(packet->options, DHCP_SUBNET, ip4_addr_get_u32(&netif->netmask));
 	add_simple_option(packet->options, DHCP_ROUTER, ip4_addr_get_u32(&netif->gw));
@@ -340,6 +346,7 @@ int sendACK(struct dhcpMessage *oldpacket, u_int32_t yiaddr)
 #else
 	#error "IPv4 not support!"
 #endif
+	UNLOCK_TCPIP_CORE();
 
 #else
 	add_simple_option(packet.options, DHCP_LEASE_TIME, htonl(lease_time_align));
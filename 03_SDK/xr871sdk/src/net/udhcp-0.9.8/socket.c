@@ -55,6 +55,7 @@
 #include "netif/etharp.h"
 #include "lwip/sockets.h"
 #include <lwip/netif.h>
+#include <lwip/tcpip.h>
 #include "dhcpd.h"
 #endif
 #include "debug.h"
@@ -108,14 +109,18 @@ int read_interface(char *interface, int *ifindex, u_int32_t *addr, unsigned char
 	}
 	close(fd);
 #else
-	struct netif *netif = netif_find(interface);
-	if (netif != NULL)
-		 *ifindex = netif->num;
-	else
-		return -1;
+	struct netif *netif;
 
-	 memcpy(addr, &(netif->ip_addr), 4);
-	 memcpy(arp, netif->hwaddr, 6);
+	LOCK_TCPIP_CORE();
+	netif = netif_find(interface);
+	if (netif == NULL) {
+		UNLOCK_TCPIP_CORE();
+		return -1;
+	}
+	*ifindex = netif->num;
+	memcpy(addr, &(netif->ip_addr), 4);
+	memcpy(arp, netif->hwaddr, 6);
+	UNLOCK_TCPIP_CORE();
 	 DHCPD_LOG(LOG_INFO, "Obtain addr :%s,hwaddr:[%02x:%02x:%02x:%02x:%02x:%02x]",inet_ntoa(*addr),arp[0],arp[1],arp[2],arp[3],arp[4],arp[5]);
 #endif
 	return 0;
@@ -31,6 +31,11 @@
 #include <lwip/inet.h>
 #include <sys/types.h>
 #include "lwip/sockets.h"
+#ifdef DHCPD_TIMEALT
+#include "dhcp_time.h"
+#else
+#include <time.h>
+#endif
 #include "debug.h"
 #include "dhcpd.h"
 #include "arpping.h"
@@ -50,6 +55,10 @@ struct server_config_t server_config;
 #define DHCPD_THREAD_STACK_SIZE	(1 * 1024)
 static OS_Thread_t g_dhcpd_thread;
 
+/* minimum seconds between two saves of a changed lease table */
+#define DHCPD_LEASE_SAVE_INTERVAL	60
+static unsigned long g_dhcpd_lease_saved;
+
 #ifdef DHCPD_USE_DEFAULT_INIT
 static void udhcpd_use_default_init_config(struct server_config_t *config)
 {
@@ -68,10 +77,67 @@ static void udhcpd_use_default_init_config(struct server_config_t *config)
 }
 #endif
 
+static void udhcpd_load_leases(const struct dhcp_server_info *param)
+{
+	unsigned int size = server_config.max_leases * LEASE_RECORD_SIZE;
+	u_int8_t *buf;
+	int len;
+
+	if (param == NULL || param->lease_load == NULL)
+		return;
+
+	buf = malloc(size);
+	if (buf == NULL)
+		return;
+	len = param->lease_load(buf, size);
+	if (len > 0)
+		unpack_leases(buf, len);
+	free(buf);
+	leases_dirty = 0;
+	g_dhcpd_lease_saved = time(0);
+}
+
+static void udhcpd_save_leases(const struct dhcp_server_info *param, int force)
+{
+	unsigned int size = server_config.max_leases * LEASE_RECORD_SIZE;
+	u_int8_t *buf;
+
+	if (param == NULL || param->lease_save == NULL || !leases_dirty)
+		return;
+	if (!force && time(0) - g_dhcpd_lease_saved < DHCPD_LEASE_SAVE_INTERVAL)
+		return;
+
+	buf = malloc(size);
+	if (buf == NULL)
+		return;
+	if (param->lease_save(buf, pack_leases(buf, size)) >= 0)
+		leases_dirty = 0;
+	free(buf);
+	g_dhcpd_lease_saved = time(0);
+}
+
+#ifdef DHCPD_DNS
+/* time left before a changed lease table is due for saving, NULL if none */
+static struct timeval *udhcpd_save_timeout(const struct dhcp_server_info *param,
+                                           struct timeval *tv)
+{
+	long left;
+
+	if (param == NULL || param->lease_save == NULL || !leases_dirty)
+		return NULL;
+
+	left = DHCPD_LEASE_SAVE_INTERVAL - (long)(time(0) - g_dhcpd_lease_saved);
+	tv->tv_sec = left > 0 ? left : 0;
+	tv->tv_usec = 0;
+	return tv;
+}
+#endif
+
 static void udhcpd_start(void *arg)
 {
 #ifdef DHCPD_DNS
 	fd_set fds;
+	struct timeval tv;
 	int maxfdp;
 	int ret;
 
@@ -137,8 +203,9 @@ static void udhcpd_start(void *arg)
 	if ((ntohl(server_param->addr_end) - ntohl(server_param->addr_start))  > (server_config.max_leases - 1))
 		server_config.end = htonl((ntohl(server_config.start) + server_config.max_leases - 1));
 
-	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
-	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	if (leases_init() != 0)
+		goto exit_server;
+	udhcpd_load_leases(server_param);
 	DEBUG(LOG_DEBUG, "start ip=%s", inet_ntoa(server_config.start));
 	DEBUG(LOG_DEBUG, "end   ip=%s", inet_ntoa(server_config.end));
 
@@ -160,11 +227,14 @@ static void udhcpd_start(void *arg)
 		FD_SET(server_socket, &fds);
 		FD_SET(dns_socket, &fds);
 		maxfdp = server_socket > dns_socket ? server_socket + 1 : dns_socket + 1;
-		ret = select(maxfdp, &fds, NULL, NULL, NULL);
+		ret = select(maxfdp, &fds, NULL, NULL, udhcpd_save_timeout(server_param, &tv));
 		if (ret < 0)
 			goto exit_server;
-		else if (ret == 0)
+		else if (ret == 0) {
+			/* no packet since the lease table changed, save it now */
+			udhcpd_save_leases(server_param, 0);
 			continue;
+		}
 		if (FD_ISSET(dns_socket, &fds))
 			dns_server(dns_socket, dns_buf, DNS_BUF_SIZE);
 
@@ -249,7 +319,7 @@ static void udhcpd_start(void *arg)
 						if ((lease = find_lease_by_yiaddr(requested_align))) {
 							if (lease_expired(lease)) {
 								/* probably best if we drop this lease */
-								memset(lease->chaddr, 0, 16);
+								lease_clear_chaddr(lease);
 								/* make some contention for this address */
 							} else sendNAK(packet);
 						} else {
@@ -262,13 +332,13 @@ static void udhcpd_start(void *arg)
 				case DHCPDECLINE:
 					DEBUG(LOG_INFO,"received DECLINE");
 					if (lease) {
-						memset(lease->chaddr, 0, 16);
-						lease->expires = time(0) + server_config.decline_time;
+						lease_clear_chaddr(lease);
+						lease_set_expires(lease, time(0) + server_config.decline_time);
 					}
 					break;
 				case DHCPRELEASE:
 					DEBUG(LOG_INFO,"received RELEASE");
-					if (lease) lease->expires = time(0);
+					if (lease) lease_set_expires(lease, time(0));
 					break;
 				case DHCPINFORM:
 					DEBUG(LOG_INFO,"received INFORM");
@@ -277,6 +347,7 @@ static void udhcpd_start(void *arg)
 				default:
 					DEBUG(LOG_WARNING, "unsupported DHCP message (%02x) -- ignoring", state[0]);
 			}
+			udhcpd_save_leases(server_param, 0);
 #ifdef DHCPD_DNS
 		}
 #endif
@@ -296,8 +367,8 @@ exit_server:
 		packet = NULL;
 	}
 	if (leases != NULL) {
-		free(leases);
-		leases = NULL;
+		udhcpd_save_leases(server_param, 1);
+		leases_deinit();
 	}
 	if (arg != NULL)
 		free(arg);
@@ -36,7 +36,7 @@
 #include "image/image.h"
 #include "net/wlan/wlan.h"
 #ifdef __CONFIG_BIN_COMPRESS
-#include "xz/xz.h"
+#include "image/decomp.h"
 #endif
 #include "sys/ducc/ducc_net.h"
 #include "sys/ducc/ducc_app.h"
@@ -327,6 +327,7 @@ static const struct soc_device_driver m_wlan_sys_drv = {
 static struct soc_device m_wlan_sys_dev = {
 	.name = "wlan_sys",
 	.driver = &m_wlan_sys_drv,
+	.async = 1,
 };
 
 #define WLAN_SYS_DEV (&m_wlan_sys_dev)
@@ -339,112 +340,6 @@ static struct soc_device m_wlan_sys_dev = {
 static OS_Semaphore_t m_ducc_sync_sem; /* use to sync with net system */
 static ducc_cb_func m_wlan_net_sys_cb = NULL;
 
-#ifdef __CONFIG_BIN_COMPRESS
-
-#define WLAN_DEC_BIN_INBUF_SIZE (4 * 1024)
-#define WLAN_DEC_BIN_DICT_MAX   (32 * 1024)
-
-static int wlan_decompress_bin(section_header_t *sh)
-{
-	uint8_t *in_buf;
-	uint32_t read_size, len, id, offset, left;
-	uint16_t chksum;
-	struct xz_dec *s;
-	struct xz_buf b;
-	enum xz_ret xzret;
-	int ret = -1;
-#if WLAN_DBG_ON
-	OS_Time_t tm;
-#endif
-
-#if WLAN_DBG_ON
-	WLAN_DBG("%s() start\n", __func__);
-	tm = OS_GetTicks();
-#endif
-
-	in_buf = wlan_malloc(WLAN_DEC_BIN_INBUF_SIZE);
-	if (in_buf == NULL) {
-		WLAN_ERR("no mem\n");
-		return ret;
-	}
-
-	/*
-	 * Support up to WLAN_DEC_BIN_DICT_MAX KiB dictionary. The actually
-	 * needed memory is allocated once the headers have been parsed.
-	 */
-	s = xz_dec_init(XZ_DYNALLOC, WLAN_DEC_BIN_DICT_MAX);
-	if (s == NULL) {
-		WLAN_ERR("no mem\n");
-		goto out;
-	}
-
-	b.in = in_buf;
-	b.in_pos = 0;
-	b.in_size = 0;
-	b.out = (uint8_t *)sh->load_addr;
-	b.out_pos = 0;
-	b.out_size = WLAN_SYS_RAM_SIZE;
-
-	id = sh->id;
-	offset = 0;
-	left = sh->body_len;
-	chksum = sh->data_chksum;
-
-	while (1) {
-		if (b.in_pos == b.in_size) {
-			if (left == 0) {
-				WLAN_ERR("no more input data\n");
-				break;
-			}
-			read_size = left > WLAN_DEC_BIN_INBUF_SIZE ?
-			            WLAN_DEC_BIN_INBUF_SIZE : left;
-			len = image_read(id, IMAGE_SEG_BODY, offset, in_buf, read_size);
-			if (len != read_size) {
-				WLAN_ERR("read img body fail, id %#x, off %u, len %u != %u\n",
-				         id, offset, len, read_size);
-				break;
-			}
-			chksum += image_get_checksum(in_buf, len);
-			offset += len;
-			left -= len;
-			b.in_size = len;
-			b.in_pos = 0;
-		}
-
-		xzret = xz_dec_run(s, &b);
-
-		if (b.out_pos == b.out_size) {
-			WLAN_ERR("decompress size >= %u\n", b.out_size);
-			break;
-		}
-
-		if (xzret == XZ_OK) {
-			continue;
-		} else if (xzret == XZ_STREAM_END) {
-#if WLAN_DBG_ON
-			tm = OS_GetTicks() - tm;
-			WLAN_DBG("%s() end, size %u --> %u, cost %u ms\n", __func__,
-			         sh->body_len, b.out_pos, tm);
-#endif
-			if (chksum != 0xFFFF) {
-				WLAN_ERR("invalid checksum %#x\n", chksum);
-			} else {
-				ret = 0;
-			}
-			break;
-		} else {
-			WLAN_ERR("xz_dec_run() fail %d\n", xzret);
-			break;
-		}
-	}
-
-out:
-	xz_dec_end(s);
-	wlan_free(in_buf);
-	return ret;
-}
-
-#endif /* __CONFIG_BIN_COMPRESS */
 
 static int wlan_load_net_bin(enum wlan_mode mode)
 {
@@ -467,7 +362,8 @@ static int wlan_load_net_bin(enum wlan_mode mode)
 
 #ifdef __CONFIG_BIN_COMPRESS
 	if (sh.attribute & IMAGE_ATTR_FLAG_COMPRESS) {
-		if (wlan_decompress_bin(&sh) != 0) {
+		if (image_decompress(&sh, (void *)sh.load_addr, WLAN_SYS_RAM_SIZE,
+		                     NULL) != 0) {
 			WLAN_ERR("decompress net bin failed\n");
 			return -1;
 		}
@@ -126,6 +126,7 @@ static ota_status_t ota_update_image_process(image_seq_t seq, void *url,
 	OTA_DBG("%s(), seq %d, flash %u, addr %#x\n", __func__, seq, flash, addr);
 	OTA_SYSLOG("OTA: erase flash...\n");
 
+	image_vcache_drop(seq);
 	if (flash_erase(flash, addr, img_max_size) != 0) {
 		return ret;
 	}
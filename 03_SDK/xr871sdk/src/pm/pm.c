@@ -372,6 +372,13 @@ static LIST_HEAD_DEF(dpm_noirq_list);
 static LIST_HEAD_DEF(dpm_list);
 static LIST_HEAD_DEF(dpm_suspended_list);
 
+/* time of each phase, and from suspend_ops.enter() returned until all devices
+ * are resumed. kept across cycles like the per device time for pm_stats_show */
+static struct pm_time_stats pm_phase_time[PM_OP_NUM][PM_TIME_NUM];
+static struct pm_time_stats pm_wake_time;
+static uint32_t pm_wake_start;
+static uint8_t pm_woken;
+
 #ifdef CONFIG_PM_DEBUG
 static struct suspend_stats suspend_stats;
 
@@ -458,6 +465,8 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 #ifdef CONFIG_PM_DEBUG
 	ktime_t starttime = ktime_get();
 #endif
+	uint32_t phase_start = pm_time_us();
+	uint32_t start;
 	int error = 0;
 
 	while (!list_empty(&dpm_late_early_list)) {
@@ -465,7 +474,10 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 
 		get_device(dev);
 
+		start = pm_time_us();
 		error = dev->driver->suspend_noirq(dev, state);
+		pm_time_add(&dev->time[PM_OP_NOIRQ][PM_TIME_SUSPEND],
+		            pm_time_us() - start);
 		if (initcall_debug_delay_us > 0) {
 			PM_LOGD("%s sleep %d us for debug.\n", dev->name,
 			        initcall_debug_delay_us);
@@ -502,6 +514,8 @@ static int dpm_suspend_noirq(enum suspend_state_t state)
 		dpm_show_time(starttime, state, "noirq");
 	}
 #endif
+	pm_time_add(&pm_phase_time[PM_OP_NOIRQ][PM_TIME_SUSPEND],
+	            pm_time_us() - phase_start);
 
 	return error;
 }
@@ -516,13 +530,18 @@ static int dpm_suspend(enum suspend_state_t state)
 #ifdef CONFIG_PM_DEBUG
 	ktime_t starttime = ktime_get();
 #endif
+	uint32_t phase_start = pm_time_us();
+	uint32_t start;
 	int error = 0;
 
 	while (!list_empty(&dpm_list)) {
 		dev = to_device(dpm_list.next, PM_OP_NORMAL);
 
 		get_device(dev);
+		start = pm_time_us();
 		error = dev->driver->suspend(dev, state);
+		pm_time_add(&dev->time[PM_OP_NORMAL][PM_TIME_SUSPEND],
+		            pm_time_us() - start);
 		if (initcall_debug_delay_us > 0) {
 			PM_LOGD("sleep %d ms for debug.\n", initcall_debug_delay_us);
 			pm_udelay(initcall_debug_delay_us);
@@ -548,6 +567,8 @@ static int dpm_suspend(enum suspend_state_t state)
 		dpm_show_time(starttime, state, "suspend");
 	}
 #endif
+	pm_time_add(&pm_phase_time[PM_OP_NORMAL][PM_TIME_SUSPEND],
+	            pm_time_us() - phase_start);
 
 	return error;
 }
@@ -563,6 +584,8 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 {
 	struct soc_device *dev;
 	ktime_t starttime = ktime_get();
+	uint32_t phase_start = pm_time_us();
+	uint32_t start;
 	int error;
 
 	while (!list_empty(&dpm_noirq_list)) {
@@ -573,7 +596,10 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 		dsb();
 		isb();
 
+		start = pm_time_us();
 		error = dev->driver->resume_noirq(dev, state);
+		pm_time_add(&dev->time[PM_OP_NOIRQ][PM_TIME_RESUME],
+		            pm_time_us() - start);
 #ifdef CONFIG_PM_DEBUG
 		if (error) {
 			suspend_stats.failed_resume_noirq++;
@@ -586,6 +612,8 @@ static void dpm_resume_noirq(enum suspend_state_t state)
 
 		put_device(dev);
 	}
+	pm_time_add(&pm_phase_time[PM_OP_NOIRQ][PM_TIME_RESUME],
+	            pm_time_us() - phase_start);
 	dpm_show_time(starttime, state, "noirq");
 }
 
@@ -594,35 +622,24 @@ static void dpm_resume_noirq(enum suspend_state_t state)
  * @state: PM transition of the system being carried out.
  *
  * Execute the appropriate "resume" callback for all devices whose status
- * indicates that they are suspended.
+ * indicates that they are suspended. Devices marked async are overlapped on
+ * the pm workers, see dpm_resume_async().
  */
 static void dpm_resume(enum suspend_state_t state)
 {
-	struct soc_device *dev;
 	ktime_t starttime = ktime_get();
-	int error;
-
-	while (!list_empty(&dpm_suspended_list)) {
-		dev = to_device(dpm_suspended_list.next, PM_OP_NORMAL);
-
-		get_device(dev);
-		list_move(&dev->node[PM_OP_NORMAL], &dpm_list);
-		dsb();
-		isb();
+	uint32_t phase_start = pm_time_us();
+	int failed;
 
-		error = dev->driver->resume(dev, state);
+	failed = dpm_resume_async(&dpm_suspended_list, &dpm_list, state);
 #ifdef CONFIG_PM_DEBUG
-		if (error) {
-			suspend_stats.failed_resume++;
-			PM_LOGE("%s resume failed!\n", dev->name);
-		}
+	suspend_stats.failed_resume += failed;
 #else
-		(void)error;
-		(void)starttime;
+	(void)failed;
+	(void)starttime;
 #endif
-
-		put_device(dev);
-	}
+	pm_time_add(&pm_phase_time[PM_OP_NORMAL][PM_TIME_RESUME],
+	            pm_time_us() - phase_start);
 	dpm_show_time(starttime, state, "resume");
 }
 
@@ -685,6 +702,8 @@ static int suspend_enter(enum suspend_state_t state)
 	if (!(suspend_test(TEST_CORE) || wakeup)) {
 		__record_dbg_status(PM_SUSPEND_ENTER | 3);
 		suspend_ops.enter(state);
+		pm_wake_start = pm_time_us();
+		pm_woken = 1;
 		__record_dbg_status(PM_SUSPEND_ENTER | 4);
 	}
 
@@ -752,6 +771,10 @@ Resume_devices:
 	suspend_test_start();
 	dpm_resume(state);
 	suspend_test_finish("resume devices");
+	if (pm_woken) {
+		pm_time_add(&pm_wake_time, pm_time_us() - pm_wake_start);
+		pm_woken = 0;
+	}
 
 Close:
 	__record_dbg_status(PM_RESUME_END);
@@ -898,11 +921,55 @@ void pm_select_mode(enum suspend_state_t state)
 	user_sel_power_mode = state;
 }
 
+static void pm_time_show(const char *name, const char *op,
+                         const struct pm_time_stats *st)
+{
+	if (!st->count)
+		return;
+
+	PM_LOGA("%-12s %-10s %5u %8u %8u %5u %5u %5u %5u %5u %5u\n", name, op,
+	        (unsigned int)st->count, (unsigned int)(st->sum_us / st->count),
+	        (unsigned int)st->max_us, st->hist[0], st->hist[1], st->hist[2],
+	        st->hist[3], st->hist[4], st->hist[5]);
+}
+
+static void pm_dev_time_show(struct list_head *head, enum pm_op_t op)
+{
+	static const char *const op_name[PM_OP_NUM][PM_TIME_NUM] = {
+		[PM_OP_NORMAL] = { "suspend", "resume" },
+		[PM_OP_NOIRQ] = { "suspend_ni", "resume_ni" },
+	};
+	struct list_head *pos;
+	struct soc_device *dev;
+	int i;
+
+	list_for_each(pos, head) {
+		dev = to_device(pos, op);
+		for (i = 0; i < PM_TIME_NUM; i++)
+			pm_time_show(dev->name ? dev->name : "-", op_name[op][i],
+			             &dev->time[op][i]);
+	}
+}
+
+static void pm_time_stats_show(void)
+{
+	PM_LOGA("%-12s %-10s %5s %8s %8s %5s %5s %5s %5s %5s %5s\n", "device",
+	        "op", "cnt", "avg_us", "max_us", "<128u", "<512u", "<2m",
+	        "<8m", "<32m", "more");
+	pm_time_show("all", "suspend", &pm_phase_time[PM_OP_NORMAL][PM_TIME_SUSPEND]);
+	pm_time_show("all", "suspend_ni", &pm_phase_time[PM_OP_NOIRQ][PM_TIME_SUSPEND]);
+	pm_time_show("all", "resume_ni", &pm_phase_time[PM_OP_NOIRQ][PM_TIME_RESUME]);
+	pm_time_show("all", "resume", &pm_phase_time[PM_OP_NORMAL][PM_TIME_RESUME]);
+	pm_time_show("all", "wake", &pm_wake_time);
+	pm_dev_time_show(&dpm_late_early_list, PM_OP_NOIRQ);
+	pm_dev_time_show(&dpm_list, PM_OP_NORMAL);
+}
+
 #ifdef CONFIG_PM_DEBUG
 /** @brief Show suspend statistic info. */
 void pm_stats_show(void)
 {
-	PM_LOGN("suspend state:\n"
+	PM_LOGA("suspend state:\n"
 	        "  success:%d\n"
 	        "  fail:%d\n"
 	        "  failed_suspend:%d\n"
@@ -914,10 +981,12 @@ void pm_stats_show(void)
 	        suspend_stats.failed_suspend, suspend_stats.failed_resume,
 	        suspend_stats.last_failed_step, suspend_stats.failed_devs,
 	        HAL_Wakeup_GetEvent());
+	pm_time_stats_show();
 }
 #else
 void pm_stats_show(void)
 {
+	pm_time_stats_show();
 }
 #endif
 
@@ -1108,10 +1177,13 @@ int pm_enter_mode(enum suspend_state_t state)
 
 void pm_start(void)
 {
+	if (pm_async_start())
+		PM_LOGW("pm async resume not started\n");
 }
 
 void pm_stop(void)
 {
+	pm_async_stop();
 }
 
 //#define CONFIG_PM_TEST 1
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Device resume timing and overlapped resume of the normal phase.
+ *
+ * dpm_resume_async() starts the suspended devices strictly in list order on
+ * the calling thread. A device runs inline unless it is marked async and the
+ * workers are started, then it is queued to one of PM_ASYNC_WORKERS threads.
+ * Before starting a device the caller collects completions until every
+ * device named in its deps has finished, and until a worker is free if the
+ * device goes to one. The device lists and the pm_flags of devices not in
+ * flight are only touched by the caller; a worker owns a device from the
+ * request queue until it hands it back through the done queue.
+ *
+ * Devices resumed together share the CCM bus clock and reset registers,
+ * HAL_CCM_Bus*Periph*() change them with the interrupts off for that.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sys/list.h"
+#include "kernel/os/os.h"
+
+#include "pm/pm.h"
+#include "pm_i.h"
+#include "port.h"
+
+#ifdef CONFIG_PM
+
+#define PM_ASYNC_THREAD_STACK_SIZE	(1 * 1024)
+
+struct pm_async {
+	OS_Thread_t thread[PM_ASYNC_WORKERS];
+	OS_Queue_t req;                 /* devices to resume */
+	OS_Queue_t done;                /* devices resumed, NULL on exit */
+	enum suspend_state_t state;
+	uint8_t running;
+};
+
+static struct pm_async pm_async;
+
+/**
+ * @brief Account one latency sample.
+ */
+void pm_time_add(struct pm_time_stats *st, uint32_t us)
+{
+	uint32_t limit = PM_TIME_BUCKET0_US;
+	int i = 0;
+
+	while (i < PM_TIME_BUCKETS - 1 && us >= limit) {
+		limit <<= 2;
+		i++;
+	}
+	if (st->hist[i] != UINT16_MAX)
+		st->hist[i]++;
+	st->count++;
+	st->sum_us += us;
+	if (us > st->max_us)
+		st->max_us = us;
+}
+
+static int pm_dev_resume(struct soc_device *dev, enum suspend_state_t state)
+{
+	uint32_t start = pm_time_us();
+	int error;
+
+	error = dev->driver->resume(dev, state);
+	pm_time_add(&dev->time[PM_OP_NORMAL][PM_TIME_RESUME], pm_time_us() - start);
+	if (error) {
+		PM_LOGE("%s resume failed!\n", dev->name);
+		dev->pm_flags |= PM_DEV_FAILED;
+	}
+
+	return error;
+}
+
+static void pm_async_task(void *arg)
+{
+	struct soc_device *dev;
+
+	while (1) {
+		if (OS_MsgQueueReceive(&pm_async.req, (void **)&dev,
+		                       OS_WAIT_FOREVER) != OS_OK)
+			continue;
+		if (dev == NULL)
+			break;
+		pm_dev_resume(dev, pm_async.state);
+		OS_MsgQueueSend(&pm_async.done, dev, OS_WAIT_FOREVER);
+	}
+
+	OS_MsgQueueSend(&pm_async.done, NULL, OS_WAIT_FOREVER);
+	OS_ThreadDelete(NULL);
+}
+
+static void pm_async_exit(int num)
+{
+	void *dev;
+	int i;
+
+	for (i = 0; i < num; i++)
+		OS_MsgQueueSend(&pm_async.req, NULL, OS_WAIT_FOREVER);
+	for (i = 0; i < num; i++) {
+		OS_MsgQueueReceive(&pm_async.done, &dev, OS_WAIT_FOREVER);
+		OS_ThreadSetInvalid(&pm_async.thread[i]);
+	}
+	OS_MsgQueueDelete(&pm_async.done);
+	OS_MsgQueueDelete(&pm_async.req);
+}
+
+/**
+ * @brief Create the resume workers, async devices run inline without them.
+ * @retval  0 if success or other if failed.
+ */
+int pm_async_start(void)
+{
+	int i;
+
+	if (pm_async.running)
+		return 0;
+
+	if (OS_MsgQueueCreate(&pm_async.req, PM_ASYNC_WORKERS) != OS_OK)
+		return -1;
+	if (OS_MsgQueueCreate(&pm_async.done, PM_ASYNC_WORKERS) != OS_OK) {
+		OS_MsgQueueDelete(&pm_async.req);
+		return -1;
+	}
+	for (i = 0; i < PM_ASYNC_WORKERS; i++) {
+		if (OS_ThreadCreate(&pm_async.thread[i], "pm_async",
+		                    pm_async_task, NULL, OS_PRIORITY_HIGH,
+		                    PM_ASYNC_THREAD_STACK_SIZE) != OS_OK) {
+			PM_LOGE("create pm_async %d failed\n", i);
+			pm_async_exit(i);
+			return -1;
+		}
+	}
+	pm_async.running = 1;
+
+	return 0;
+}
+
+/**
+ * @brief Stop the resume workers, not to be called during a resume.
+ */
+void pm_async_stop(void)
+{
+	if (!pm_async.running)
+		return;
+
+	pm_async.running = 0;
+	pm_async_exit(PM_ASYNC_WORKERS);
+}
+
+static struct soc_device *pm_dev_find(struct list_head *head, const char *name)
+{
+	struct list_head *pos;
+	struct soc_device *dev;
+
+	list_for_each(pos, head) {
+		dev = to_device(pos, PM_OP_NORMAL);
+		if (dev->name && !strcmp(dev->name, name))
+			return dev;
+	}
+
+	return NULL;
+}
+
+/* whether a device in deps is still resuming; deps not started yet are
+ * ordered after dev in the list, they can't be waited for. */
+static int pm_dev_blocked(struct soc_device *dev, struct list_head *from,
+                          struct list_head *to)
+{
+	const char *const *name;
+	struct soc_device *dep;
+
+	for (name = dev->deps; name && *name; name++) {
+		dep = pm_dev_find(to, *name);
+		if (dep && (dep->pm_flags & PM_DEV_PENDING))
+			return 1;
+		if (!dep && pm_dev_find(from, *name))
+			PM_LOGW("%s resumes before %s it depends on\n",
+			        dev->name, *name);
+	}
+
+	return 0;
+}
+
+static int pm_async_reap(void)
+{
+	struct soc_device *dev;
+
+	OS_MsgQueueReceive(&pm_async.done, (void **)&dev, OS_WAIT_FOREVER);
+	dev->pm_flags &= ~PM_DEV_PENDING;
+	put_device(dev);
+
+	return (dev->pm_flags & PM_DEV_FAILED) ? 1 : 0;
+}
+
+/**
+ * @brief Resume the devices on from and move them to to.
+ * @retval  number of devices failed to resume.
+ */
+int dpm_resume_async(struct list_head *from, struct list_head *to,
+                     enum suspend_state_t state)
+{
+	struct list_head *pos;
+	struct soc_device *dev;
+	int busy = 0;
+	int failed = 0;
+
+	list_for_each(pos, from) {
+		dev = to_device(pos, PM_OP_NORMAL);
+		dev->pm_flags = PM_DEV_PENDING;
+	}
+	pm_async.state = state;
+
+	while (!list_empty(from)) {
+		dev = to_device(from->next, PM_OP_NORMAL);
+
+		while (busy && (pm_dev_blocked(dev, from, to) ||
+		       (dev->async && busy == PM_ASYNC_WORKERS))) {
+			failed += pm_async_reap();
+			busy--;
+		}
+
+		get_device(dev);
+		list_move(&dev->node[PM_OP_NORMAL], to);
+		dev->pm_flags |= PM_DEV_STARTED;
+
+		if (dev->async && pm_async.running) {
+			OS_MsgQueueSend(&pm_async.req, dev, OS_WAIT_FOREVER);
+			busy++;
+			continue;
+		}
+
+		if (pm_dev_resume(dev, state))
+			failed++;
+		dev->pm_flags &= ~PM_DEV_PENDING;
+		put_device(dev);
+	}
+
+	while (busy) {
+		failed += pm_async_reap();
+		busy--;
+	}
+
+	return failed;
+}
+
+#endif /* CONFIG_PM */
@@ -167,6 +167,19 @@ struct platform_suspend_ops {
 
 extern void __cpu_sleep(enum suspend_state_t state);
 extern void __cpu_suspend(enum suspend_state_t state);
+
+/* soc_device pm_flags, owned by the thread walking the resume list */
+#define PM_DEV_PENDING             (1<<0) /* suspended, resume not finished */
+#define PM_DEV_STARTED             (1<<1) /* resume called or queued */
+#define PM_DEV_FAILED              (1<<2) /* resume returned error */
+
+#define PM_ASYNC_WORKERS           2
+
+extern void pm_time_add(struct pm_time_stats *st, uint32_t us);
+extern int pm_async_start(void);
+extern void pm_async_stop(void);
+extern int dpm_resume_async(struct list_head *from, struct list_head *to,
+                            enum suspend_state_t state);
 #endif
 
 #endif
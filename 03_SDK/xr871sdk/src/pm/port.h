@@ -45,10 +45,12 @@
 #define ktime_t uint64_t
 #define ktime_get() (HAL_RTC_GetFreeRunTime() / 1000)
 #define ktime_to_msecs(t) (t)
+#define pm_time_us() ((uint32_t)HAL_RTC_GetFreeRunTime())
 #else
 #define ktime_t uint32_t
 #define ktime_get() OS_GetTicks()
 #define ktime_to_msecs(t) OS_MSecsToJiffies(t)
+#define pm_time_us() (OS_GetTicks() * OS_TICK)
 #endif
 
 #define arch_suspend_disable_irqs __disable_irq
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions
+#  are met:
+#    1. Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#    2. Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the
+#       distribution.
+#    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+#  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+#  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+#  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+#  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+#  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+#  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+#  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+#  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+#  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""Pack a directory of web content into a shttpd content image.
+
+Usage:
+    mkwebimg.py <dir> -o <image> [-r <root>] [-c <name>]
+
+Every file gets a gzip encoded variant, kept when it is smaller, and an entity
+tag (FNV-1a of the file). The image is mounted with
+_shttpd_mount_content_image(), in place from XIP mapped flash or from RAM, and
+must be 4 bytes aligned there. The layout is struct content_image_hdr and
+struct content_image_entry in include/net/shttpd/compat_rtos.h.
+
+Names are the request paths below <root>, the shttpd "root" option ("." by
+default), eg. "./index.html". Directories are listed as "./", "./js/".
+
+With -c, a C source defining the image as the const array <name> and its size
+as <name>_size is written instead of the binary.
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+
+MAGIC = 0x49434853  # "SHCI"
+VERSION = 1
+HDR = struct.Struct('<IHHI')
+ENTRY = struct.Struct('<IIIIII')
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in bytearray(data):
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def collect(top, root):
+    """Return [(name, data)] for the directories and files under top."""
+    items = []
+    for path, dirs, files in os.walk(top):
+        dirs.sort()
+        rel = os.path.relpath(path, top).replace(os.sep, '/')
+        prefix = root + '/' if rel == '.' else '%s/%s/' % (root, rel)
+        items.append((prefix, None))
+        for name in sorted(files):
+            with open(os.path.join(path, name), 'rb') as f:
+                items.append((prefix + name, f.read()))
+    return items
+
+
+def build(items):
+    """Return the image and a list of (name, size, gzip size)."""
+    blobs = bytearray()
+    entries = []
+    report = []
+    base = HDR.size + ENTRY.size * len(items)
+
+    def put(data):
+        off = base + len(blobs)
+        blobs.extend(data)
+        blobs.extend(b'\0' * (4 - len(data) % 4))  # '\0' ended, aligned
+        return off
+
+    for name, data in items:
+        name_off = put(name.encode('utf-8'))
+        if data is None:
+            entries.append((name_off, 0, 0, 0, 0, 0))
+            continue
+        gz = gzip.compress(data, 9, mtime=0)
+        body = put(data)
+        if len(gz) < len(data):
+            entries.append((name_off, body, len(data), put(gz), len(gz),
+                            fnv1a(data)))
+            report.append((name, len(data), len(gz)))
+        else:
+            entries.append((name_off, body, len(data), 0, 0, fnv1a(data)))
+            report.append((name, len(data), 0))
+
+    image = bytearray(HDR.pack(MAGIC, VERSION, len(entries),
+                               base + len(blobs)))
+    for e in entries:
+        image.extend(ENTRY.pack(*e))
+    image.extend(blobs)
+    return bytes(image), report
+
+
+def write_c(path, name, image):
+    with open(path, 'w') as f:
+        f.write('/* Generated by tools/mkwebimg.py */\n\n')
+        f.write('const unsigned char %s[] __attribute__((aligned(4))) = {\n'
+                % name)
+        for i in range(0, len(image), 12):
+            f.write('\t' + ' '.join('0x%02x,' % b
+                                    for b in bytearray(image[i:i + 12]))
+                    + '\n')
+        f.write('};\n\nconst unsigned long %s_size = %u;\n'
+                % (name, len(image)))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description='Pack web content into a shttpd content image.')
+    parser.add_argument('dir', help='directory to pack')
+    parser.add_argument('-o', '--output', required=True, help='output file')
+    parser.add_argument('-r', '--root', default='.',
+                        help='shttpd root option the names are under')
+    parser.add_argument('-c', '--c-array', metavar='NAME',
+                        help='write a C source defining the array NAME')
+    args = parser.parse_args(argv)
+
+    if not os.path.isdir(args.dir):
+        sys.stderr.write('%s is not a directory\n' % args.dir)
+        return 1
+    image, report = build(collect(args.dir, args.root.rstrip('/')))
+    if len(report) == 0:
+        sys.stderr.write('no files in %s\n' % args.dir)
+        return 1
+    if len(image) > 0xffffffff or len(report) > 0xffff:
+        sys.stderr.write('too much content\n')
+        return 1
+
+    if args.c_array:
+        write_c(args.output, args.c_array, image)
+    else:
+        with open(args.output, 'wb') as f:
+            f.write(image)
+
+    total = sum(r[1] for r in report)
+    sent = sum(r[2] or r[1] for r in report)
+    for name, size, gz in report:
+        print('%8u %8s  %s' % (size, gz or '-', name))
+    print('%u files, %u bytes, %u bytes gzip encoded (%.1f%%), image %u bytes'
+          % (len(report), total, sent, 100.0 * sent / max(total, 1),
+             len(image)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
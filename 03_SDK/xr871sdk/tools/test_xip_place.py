@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions
+#  are met:
+#    1. Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#    2. Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the
+#       distribution.
+#    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+#  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+#  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+#  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+#  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+#  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+#  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+#  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+#  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+#  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""Tests of xip_place.py on a recorded "prof dump" and a map fixture.
+
+Run from anywhere:
+    python3 tools/test_xip_place.py
+"""
+
+import io
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+DATA = os.path.join(TOOLS, 'testdata', 'xip_place')
+sys.path.insert(0, TOOLS)
+
+import xip_place  # noqa: E402
+
+SAMPLES = os.path.join(DATA, 'prof_dump.txt')
+MAP = os.path.join(DATA, 'wlan_demo.map')
+
+
+class XipPlaceTest(unittest.TestCase):
+    def setUp(self):
+        self.samples = xip_place.read_samples(SAMPLES)
+        self.secs, self.assigns = xip_place.read_map(MAP)
+        self.missed = xip_place.attribute(self.secs, self.samples)
+        self.xip = (self.assigns['__xip_start'], self.assigns['__xip_end'])
+
+    def sec(self, name):
+        return [s for s in self.secs if s.name == name][0]
+
+    def test_samples(self):
+        self.assertEqual(len(self.samples), 9)
+        self.assertEqual(sum(self.samples.values()), 1090)
+
+    def test_map(self):
+        # .text input sections only, sorted, the split and the one line forms
+        self.assertEqual([s.name for s in self.secs], [
+            '.text.HAL_UART_IRQHandler', '.text.tcp_input',
+            '.text.inet_chksum_pseudo', '.text.mbedtls_sha256_process',
+            '.text.net_ctrl_msg_process', '.text.pbuf_ref'])
+        self.assertEqual(self.xip, (0x10000000, 0x10000de0))
+        s = self.sec('.text.pbuf_ref')
+        self.assertEqual((s.addr, s.size), (0x10000cd8, 0x100))
+        self.assertEqual(s.syms, ['pbuf_ref'])
+
+    def test_attribute(self):
+        # a pc at the end of a section belongs to the next one
+        self.assertEqual(self.sec('.text.inet_chksum_pseudo').samples, 96)
+        self.assertEqual(self.sec('.text.mbedtls_sha256_process').samples, 480)
+        self.assertEqual(self.sec('.text.tcp_input').samples, 300)
+        self.assertEqual(self.sec('.text.HAL_UART_IRQHandler').samples, 200)
+        self.assertEqual(self.missed, 5)
+
+    def test_place(self):
+        ranked, chosen = xip_place.place(self.secs, self.xip, 1088)
+        # by density, SRAM and unsampled code left out, tcp_input too large
+        self.assertEqual([s.syms[0] for s in ranked], [
+            'inet_chksum_pseudo', 'mbedtls_sha256_process',
+            'net_ctrl_msg_process', 'tcp_input'])
+        self.assertEqual([s.syms[0] for s in chosen], [
+            'inet_chksum_pseudo', 'mbedtls_sha256_process',
+            'net_ctrl_msg_process'])
+        ranked, chosen = xip_place.place(self.secs, self.xip, 1024)
+        self.assertEqual([s.syms[0] for s in chosen], [
+            'inet_chksum_pseudo', 'net_ctrl_msg_process'])
+
+    def test_ld_rule(self):
+        self.assertEqual(self.sec('.text.tcp_input').ld_rule(),
+                         '*liblwip.a:tcp_in.o(.text.tcp_input)')
+        self.assertEqual(self.sec('.text.net_ctrl_msg_process').ld_rule(),
+                         '*framework/net_ctrl.o(.text.net_ctrl_msg_process)')
+
+    def test_output(self):
+        tmp = tempfile.mkdtemp()
+        out = os.path.join(tmp, 'hot.ld')
+        stdout = sys.stdout
+        sys.stdout = io.StringIO()
+        try:
+            ret = xip_place.main([SAMPLES, MAP, '-b', '0x440', '-o', out])
+            report = sys.stdout.getvalue()
+        finally:
+            sys.stdout = stdout
+        try:
+            self.assertEqual(ret, 0)
+            self.assertIn('3 sections, 1076 bytes, 585 xip samples moved',
+                          report)
+            with open(out) as f, \
+                    open(os.path.join(DATA, 'hot_1088.ld')) as ref:
+                self.assertEqual(f.read(), ref.read())
+        finally:
+            shutil.rmtree(tmp)
+
+
+if __name__ == '__main__':
+    unittest.main()
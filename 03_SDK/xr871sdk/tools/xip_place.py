@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions
+#  are met:
+#    1. Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#    2. Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the
+#       distribution.
+#    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+#       its contributors may be used to endorse or promote products derived
+#       from this software without specific prior written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+#  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+#  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+#  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+#  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+#  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+#  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+#  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+#  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+#  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+#  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""Rank XIP code for moving to SRAM, from a PC sample dump.
+
+Usage:
+    xip_place.py <samples> <map> [-b <budget>] [-o <hot.ld>]
+
+<samples> is the console output of "prof dump", lines of "<pc> <count>" and
+other lines are ignored. <map> is the map file of the same build, eg.
+project/wlan_demo/gcc/wlan_demo.map.
+
+The unit of placement is the input section, which is a function for code
+built with -ffunction-sections. Sections in XIP are ranked by samples per
+byte and taken greedily until the SRAM budget is used up.
+
+With -o, a linker script fragment is written. Set XIP_HOT_LINKER_SCRIPT to it
+when building the project, the fragment is placed in front of the project's
+linker script so its rules take precedence over those of .xip, and the
+output section it defines is inserted after .text, in the SRAM region named
+RAM of the project's linker script.
+"""
+
+import argparse
+import bisect
+import os
+import re
+import sys
+
+RE_SAMPLE = re.compile(r'^\s*(?:0x)?([0-9a-fA-F]{8})\s+(\d+)\s*$')
+RE_SEC_ONE = re.compile(r'^ (\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+RE_SEC_NAME = re.compile(r'^ (\.\S+)$')
+RE_SEC_BODY = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+RE_SYM = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$')
+RE_ASSIGN = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*=')
+
+# XIP window used if the map has no __xip_start/__xip_end
+XIP_DEFAULT = (0x10000000, 0x11000000)
+
+# memory region of the output section, as named in project/linker_script
+SRAM_REGION = 'RAM'
+
+
+class Section(object):
+    def __init__(self, name, addr, size, obj):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.obj = obj
+        self.syms = []
+        self.samples = 0
+
+    def density(self):
+        return float(self.samples) / self.size
+
+    def ld_rule(self):
+        """Input section description matching this section only."""
+        m = re.match(r'^(.*?)([^/\\]+\.a)\((.+)\)$', self.obj)
+        if m:
+            pattern = '*%s:%s' % (m.group(2), m.group(3))
+        else:
+            parts = re.split(r'[/\\]', self.obj)
+            pattern = '*' + '/'.join(parts[-2:])
+        return '%s(%s)' % (pattern, self.name)
+
+
+def read_samples(path):
+    """Return {pc: count} from a "prof dump" capture."""
+    samples = {}
+    with open(path) as f:
+        for line in f:
+            m = RE_SAMPLE.match(line)
+            if m:
+                pc = int(m.group(1), 16)
+                samples[pc] = samples.get(pc, 0) + int(m.group(2))
+    return samples
+
+
+def read_map(path):
+    """Return (code sections sorted by address, {symbol assignment: addr})."""
+    secs = []
+    assigns = {}
+    started = False
+    pending = None
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\r\n')
+            if not started:
+                started = line.startswith('Linker script and memory map')
+                continue
+            if line.startswith('Cross Reference Table'):
+                break
+
+            if pending is not None:
+                m = RE_SEC_BODY.match(line)
+                if m:
+                    secs.append(Section(pending, int(m.group(1), 16),
+                                        int(m.group(2), 16), m.group(3)))
+                pending = None
+                continue
+
+            m = RE_SEC_ONE.match(line)
+            if m:
+                secs.append(Section(m.group(1), int(m.group(2), 16),
+                                    int(m.group(3), 16), m.group(4)))
+                continue
+            m = RE_SEC_NAME.match(line)
+            if m:
+                pending = m.group(1)
+                continue
+            m = RE_ASSIGN.match(line)
+            if m:
+                assigns[m.group(2)] = int(m.group(1), 16)
+                continue
+            m = RE_SYM.match(line)
+            if m and secs:
+                addr = int(m.group(1), 16)
+                last = secs[-1]
+                if last.addr <= addr < last.addr + last.size:
+                    last.syms.append(m.group(2))
+
+    code = [s for s in secs
+            if s.size > 0 and s.addr > 0 and s.name.startswith('.text')]
+    code.sort(key=lambda s: s.addr)
+    return code, assigns
+
+
+def attribute(secs, samples):
+    """Add samples to the sections, return the number of unmatched ones."""
+    starts = [s.addr for s in secs]
+    missed = 0
+    for pc, cnt in samples.items():
+        i = bisect.bisect_right(starts, pc) - 1
+        if i >= 0 and pc < secs[i].addr + secs[i].size:
+            secs[i].samples += cnt
+        else:
+            missed += cnt
+    return missed
+
+
+def place(secs, xip, budget):
+    """Rank the sampled sections in XIP, return (ranked, chosen)."""
+    ranked = [s for s in secs
+              if s.samples > 0 and xip[0] <= s.addr < xip[1]]
+    ranked.sort(key=lambda s: (-s.density(), -s.samples, s.addr))
+    chosen = []
+    used = 0
+    for s in ranked:
+        size = (s.size + 3) & ~3
+        if used + size <= budget:
+            chosen.append(s)
+            used += size
+    return ranked, chosen
+
+
+def write_ld(path, chosen, budget):
+    with open(path, 'w') as f:
+        f.write('/* Generated by tools/xip_place.py, SRAM budget %u bytes */\n'
+                % budget)
+        f.write('SECTIONS\n{\n')
+        f.write('\t.hot_text :\n\t{\n')
+        f.write('\t\t. = ALIGN(4);\n')
+        f.write('\t\t__hot_text_start__ = .;\n')
+        for s in chosen:
+            f.write('\t\t%s\t/* %u samples */\n' % (s.ld_rule(), s.samples))
+        f.write('\t\t. = ALIGN(4);\n')
+        f.write('\t\t__hot_text_end__ = .;\n')
+        f.write('\t} > %s\n' % SRAM_REGION)
+        f.write('}\nINSERT AFTER .text;\n')
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description='Rank XIP code for SRAM placement from PC samples.')
+    parser.add_argument('samples', help='"prof dump" output')
+    parser.add_argument('map', help='map file of the profiled build')
+    parser.add_argument('-b', '--budget', type=lambda x: int(x, 0),
+                        default=16 * 1024, help='SRAM budget in bytes')
+    parser.add_argument('-o', '--output', help='linker script fragment')
+    parser.add_argument('-n', '--top', type=int, default=0,
+                        help='number of ranked sections listed, 0 for all')
+    args = parser.parse_args(argv)
+
+    samples = read_samples(args.samples)
+    if not samples:
+        sys.stderr.write('no samples in %s\n' % args.samples)
+        return 1
+    secs, assigns = read_map(args.map)
+    if not secs:
+        sys.stderr.write('no code sections in %s\n' % args.map)
+        return 1
+
+    xip = (assigns.get('__xip_start', XIP_DEFAULT[0]),
+           assigns.get('__xip_end', XIP_DEFAULT[1]))
+    total = sum(samples.values())
+    missed = attribute(secs, samples)
+    ranked, chosen = place(secs, xip, args.budget)
+    in_xip = sum(s.samples for s in ranked)
+    moved = sum(s.samples for s in chosen)
+    chosen_set = set(id(s) for s in chosen)
+
+    print('samples %u, in xip %u (%.1f%%), unknown %u' %
+          (total, in_xip, 100.0 * in_xip / total, missed))
+    print('budget %u bytes, %u sections, %u bytes, %u xip samples moved '
+          '(%.1f%%)' % (args.budget, len(chosen),
+                        sum((s.size + 3) & ~3 for s in chosen), moved,
+                        100.0 * moved / total))
+    print('%4s %1s %8s %6s %6s %10s  %s' %
+          ('rank', '', 'samples', '%', 'size', 'addr', 'section'))
+    for i, s in enumerate(ranked):
+        if args.top and i >= args.top:
+            break
+        name = s.syms[0] if s.syms else s.name
+        print('%4u %1s %8u %6.2f %6u 0x%08x  %s  %s' %
+              (i + 1, '*' if id(s) in chosen_set else '', s.samples,
+               100.0 * s.samples / total, s.size, s.addr, name,
+               os.path.basename(s.obj)))
+
+    if args.output:
+        write_ld(args.output, chosen, args.budget)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))